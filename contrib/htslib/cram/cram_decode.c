@@ -1853,7 +1853,10 @@ static cram_slice *cram_next_slice(cram_fd *fd, cram_container **cp) {
     cram_container *c;
     cram_slice *s = NULL;
 
-    fd->eof = 0;
+    // keep the EOF status found by the last cram_read_container() once
+    // the multi-threaded decoder has run out of containers
+    if (!fd->ooc)
+	fd->eof = 0;
 
     if (!(c = fd->ctr)) {
 	// Load first container.
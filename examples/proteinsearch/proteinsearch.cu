@@ -0,0 +1,422 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+// proteinsearch.cu
+//
+
+#include <nvbio/basic/console.h>
+#include <nvbio/basic/timer.h>
+#include <nvbio/basic/vector.h>
+#include <nvbio/basic/vector_view.h>
+#include <nvbio/basic/shared_pointer.h>
+#include <nvbio/strings/alphabet.h>
+#include <nvbio/io/sequence/sequence.h>
+#include <nvbio/alignment/alignment.h>
+#include <nvbio/alignment/batched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+using namespace nvbio;
+
+// a database hit
+//
+struct Hit
+{
+    int32       score;
+    uint64      index;      // the global index of the database sequence
+    std::string name;       // the name of the database sequence
+};
+
+// hit ordering: the best hits come first, with ties broken by database order
+//
+struct better_hit
+{
+    bool operator() (const Hit& a, const Hit& b) const
+    {
+        return a.score > b.score || (a.score == b.score && a.index < b.index);
+    }
+};
+
+//
+// A host alignment stream aligning a single query against a batch of database sequences.
+// The database sequences are the patterns and the query is the text shared by all jobs, so that
+// the HostSimdScheduler can read the substitution scores of each query symbol from the score
+// profiles of the database sequences in place; local alignment scores are symmetric with
+// respect to this choice.
+//
+template <typename t_aligner_type>
+struct SearchStream
+{
+    typedef t_aligner_type                          aligner_type;
+
+    typedef vector_view<const uint8*>               pattern_string;
+    typedef vector_view<const uint8*>               text_string;
+
+    // an alignment context
+    struct context_type
+    {
+        int32                   min_score;
+        aln::BestSink<int32>    sink;
+    };
+    // a container for the strings to be aligned
+    struct strings_type
+    {
+        pattern_string                  pattern;
+        aln::trivial_quality_string     quals;
+        text_string                     text;
+    };
+
+    // constructor
+    SearchStream(
+        const aligner_type  _aligner,
+        const uint32        _count,
+        const uint32        _max_db_len,
+        const uint8*        _db,
+        const uint32*       _db_offsets,
+        const uint32        _query_len,
+        const uint8*        _query,
+              int32*        _scores) :
+        m_aligner( _aligner ), m_count( _count ), m_max_db_len( _max_db_len ), m_db( _db ), m_db_offsets( _db_offsets ),
+        m_query_len( _query_len ), m_query( _query ), m_scores( _scores ) {}
+
+    // get the aligner
+    const aligner_type& aligner() const { return m_aligner; };
+
+    // return the maximum pattern length
+    uint32 max_pattern_length() const { return m_max_db_len; }
+
+    // return the maximum text length
+    uint32 max_text_length() const { return m_query_len; }
+
+    // return the stream size
+    uint32 size() const { return m_count; }
+
+    // return the i-th pattern's length
+    uint32 pattern_length(const uint32 i, context_type* context) const { return m_db_offsets[i+1] - m_db_offsets[i]; }
+
+    // return the i-th text's length
+    uint32 text_length(const uint32 i, context_type* context) const { return m_query_len; }
+
+    // initialize the i-th context
+    bool init_context(
+        const uint32    i,
+        context_type*   context) const
+    {
+        context->min_score = Field_traits<int32>::min();
+        return true;
+    }
+
+    // load the strings of the i-th job
+    void load_strings(
+        const uint32        i,
+        const uint32        window_begin,
+        const uint32        window_end,
+        const context_type* context,
+              strings_type* strings) const
+    {
+        strings->pattern = pattern_string( m_db_offsets[i+1] - m_db_offsets[i], m_db + m_db_offsets[i] );
+        strings->text    = text_string( m_query_len, m_query );
+    }
+
+    // handle the output
+    void output(
+        const uint32        i,
+        const context_type* context) const
+    {
+        m_scores[i] = context->sink.score;
+    }
+
+    aligner_type    m_aligner;
+    uint32          m_count;
+    uint32          m_max_db_len;
+    const uint8*    m_db;
+    const uint32*   m_db_offsets;
+    uint32          m_query_len;
+    const uint8*    m_query;
+    int32*          m_scores;
+};
+
+// sort database sequences by decreasing length
+//
+struct longer_sequence
+{
+    longer_sequence(const uint32* _lengths) : lengths( _lengths ) {}
+
+    bool operator() (const uint32 a, const uint32 b) const { return lengths[a] > lengths[b] || (lengths[a] == lengths[b] && a < b); }
+
+    const uint32* lengths;
+};
+
+// main test entry point
+//
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        log_info(stderr, "proteinsearch [options] queries.fa database.fa\n");
+        log_info(stderr, "  options:\n");
+        log_info(stderr, "    -matrix     file      NCBI substitution matrix file (e.g. PAM250), default: BLOSUM62\n");
+        log_info(stderr, "    -gap-open   int       gap open penalty, default: 11\n");
+        log_info(stderr, "    -gap-ext    int       gap extension penalty, default: 1\n");
+        log_info(stderr, "    -top        int       number of hits to report per query, default: 10\n");
+        log_info(stderr, "    -batch      int       database sequences per batch, default: 256K\n");
+        return 0;
+    }
+
+    //
+    // perform some basic option parsing
+    //
+
+    const char* query_name = argv[argc-2];
+    const char* db_name    = argv[argc-1];
+    const char* matrix_name = NULL;
+
+    int32  gap_open      = 11;
+    int32  gap_ext       = 1;
+    uint32 top_n         = 10u;
+    uint32 batch_seqs    = 256*1024;
+    uint32 batch_symbols = 128*1024*1024;
+
+    for (int i = 1; i < argc-2; ++i)
+    {
+        if (strcmp( argv[i], "-matrix" ) == 0)
+            matrix_name = argv[++i];
+        else if (strcmp( argv[i], "-gap-open" ) == 0)
+            gap_open = atoi( argv[++i] );
+        else if (strcmp( argv[i], "-gap-ext" ) == 0)
+            gap_ext = atoi( argv[++i] );
+        else if (strcmp( argv[i], "-top" ) == 0)
+            top_n = uint32( atoi( argv[++i] ) );
+        else if (strcmp( argv[i], "-batch" ) == 0)
+            batch_seqs = uint32( atoi( argv[++i] ) );
+    }
+
+    if (int32( top_n ) <= 0)
+    {
+        log_error(stderr, "  -top must be a positive number of hits\n");
+        return 1;
+    }
+
+    // setup the scoring scheme
+    aln::SubstitutionMatrix matrix = aln::blosum62_matrix();
+    if (matrix_name && aln::load_substitution_matrix( matrix_name, &matrix ) == false)
+    {
+        log_error(stderr, "  failed loading substitution matrix \"%s\"\n", matrix_name);
+        return 1;
+    }
+
+    // NOTE: a gap of length k costs gap_open + (k-1) * gap_ext
+    const aln::MatrixGotohScheme scoring( matrix, -gap_open, -gap_ext );
+
+    typedef aln::GotohAligner<aln::LOCAL,aln::MatrixGotohScheme,aln::TextBlockingTag> aligner_type;
+    typedef SearchStream<aligner_type>                                                stream_type;
+    typedef aln::BatchedAlignmentScore<stream_type,aln::HostSimdScheduler>            batch_type;
+
+    const aligner_type aligner = aln::make_gotoh_aligner<aln::LOCAL,aln::TextBlockingTag>( scoring );
+
+    // load the queries
+    log_info(stderr, "  loading queries... started\n");
+
+    SharedPointer<io::SequenceDataStream> query_file( io::open_sequence_file( query_name ) );
+    if (query_file == NULL || query_file->is_ok() == false)
+    {
+        log_error(stderr, "  failed opening queries \"%s\"\n", query_name);
+        return 1;
+    }
+
+    std::vector< std::vector<uint8> > queries;
+    std::vector<std::string>          query_names;
+
+    io::SequenceDataHost h_queries;
+    while (io::next( PROTEIN, &h_queries, query_file.get(), 64*1024, 64*1024*1024 ))
+    {
+        const io::SequenceDataAccess<PROTEIN> query_access( h_queries );
+
+        // unpack the queries
+        for (uint32 q = 0; q < h_queries.size(); ++q)
+        {
+            const io::SequenceDataAccess<PROTEIN>::sequence_string query = query_access.get_read( q );
+            const io::SequenceDataAccess<PROTEIN>::name_string     name  = query_access.get_name( q );
+
+            queries.push_back( std::vector<uint8>( query.length() ) );
+            for (uint32 i = 0; i < query.length(); ++i)
+                queries.back()[i] = uint8( query[i] );
+
+            query_names.push_back( std::string( name.begin(), name.end() ) );
+        }
+    }
+
+    const uint32 n_queries = uint32( queries.size() );
+    if (n_queries == 0)
+    {
+        log_error(stderr, "  no queries found in \"%s\"\n", query_name);
+        return 1;
+    }
+    log_info(stderr, "  loading queries... done: %u queries\n", n_queries);
+
+    // open the database
+    SharedPointer<io::SequenceDataStream> db_file( io::open_sequence_file( db_name ) );
+    if (db_file == NULL || db_file->is_ok() == false)
+    {
+        log_error(stderr, "  failed opening database \"%s\"\n", db_name);
+        return 1;
+    }
+
+    std::vector< std::vector<Hit> > hits( n_queries );
+
+    std::vector<uint32> db_lengths;
+    std::vector<uint32> db_order;
+    std::vector<uint8>  db_symbols;
+    std::vector<uint32> db_offsets;
+    std::vector<int32>  scores;
+
+    nvbio::vector<host_tag,uint8> temp;
+
+    uint64 db_size  = 0u;
+    uint64 n_cells  = 0u;
+    float  aln_time = 0.0f;
+
+    Timer global_timer;
+    global_timer.start();
+
+    io::SequenceDataHost h_db;
+
+    // stream through the database in batches
+    while (io::next( PROTEIN, &h_db, db_file.get(), batch_seqs, batch_symbols ))
+    {
+        const io::SequenceDataAccess<PROTEIN> db_access( h_db );
+        const uint32 n_seqs = h_db.size();
+
+        // sort the sequences by length, so that the SIMD lanes of each group see similar lengths
+        db_lengths.resize( n_seqs );
+        db_order.resize( n_seqs );
+        for (uint32 i = 0; i < n_seqs; ++i)
+        {
+            db_lengths[i] = db_access.get_range( i ).y - db_access.get_range( i ).x;
+            db_order[i]   = i;
+        }
+        std::sort( db_order.begin(), db_order.end(), longer_sequence( &db_lengths[0] ) );
+
+        // unpack them in sorted order
+        db_offsets.resize( n_seqs + 1 );
+        db_offsets[0] = 0u;
+        for (uint32 i = 0; i < n_seqs; ++i)
+            db_offsets[i+1] = db_offsets[i] + db_lengths[ db_order[i] ];
+
+        db_symbols.resize( db_offsets[ n_seqs ] + 1u );
+        for (uint32 i = 0; i < n_seqs; ++i)
+        {
+            const io::SequenceDataAccess<PROTEIN>::sequence_string seq = db_access.get_read( db_order[i] );
+            for (uint32 j = 0; j < seq.length(); ++j)
+                db_symbols[ db_offsets[i] + j ] = uint8( seq[j] );
+        }
+
+        const uint32 max_db_len = db_lengths[ db_order[0] ];
+
+        scores.resize( n_seqs );
+
+        // search all queries against this batch
+        for (uint32 q = 0; q < n_queries; ++q)
+        {
+            const uint32 query_len = uint32( queries[q].size() );
+            if (query_len == 0)
+                continue;
+
+            const stream_type stream(
+                aligner,
+                n_seqs,
+                max_db_len,
+                &db_symbols[0],
+                &db_offsets[0],
+                query_len,
+                &queries[q][0],
+                &scores[0] );
+
+            // reuse the temporary storage across queries and batches
+            const uint64 temp_size = batch_type::max_temp_storage( max_db_len, query_len, n_seqs );
+            if (temp.size() < temp_size)
+                temp.resize( temp_size );
+
+            Timer timer;
+            timer.start();
+
+            batch_type batch;
+            batch.enact( stream, temp.size(), nvbio::raw_pointer( temp ) );
+
+            timer.stop();
+            aln_time += timer.seconds();
+            n_cells  += uint64( query_len ) * uint64( db_offsets[ n_seqs ] );
+
+            // collect the top-N hits, keeping them in a heap with the worst hit on top
+            std::vector<Hit>& top = hits[q];
+            for (uint32 i = 0; i < n_seqs; ++i)
+            {
+                Hit hit;
+                hit.score = scores[i];
+                hit.index = db_size + db_order[i];
+
+                if (top.size() == top_n && better_hit()( hit, top.front() ) == false)
+                    continue;
+
+                const io::SequenceDataAccess<PROTEIN>::name_string name = db_access.get_name( db_order[i] );
+                hit.name = std::string( name.begin(), name.end() );
+
+                if (top.size() == top_n)
+                {
+                    std::pop_heap( top.begin(), top.end(), better_hit() );
+                    top.pop_back();
+                }
+                top.push_back( hit );
+                std::push_heap( top.begin(), top.end(), better_hit() );
+            }
+        }
+
+        db_size += n_seqs;
+        log_verbose(stderr, "\r  searched %llu sequences: %.2f GCUPS    ", db_size, 1.0e-9f * float(n_cells) / aln_time);
+    }
+    global_timer.stop();
+    log_verbose_cont(stderr, "\n");
+
+    // output the hits
+    for (uint32 q = 0; q < n_queries; ++q)
+    {
+        std::vector<Hit>& top = hits[q];
+        std::sort_heap( top.begin(), top.end(), better_hit() );
+
+        for (uint32 i = 0; i < top.size(); ++i)
+            fprintf(stdout, "%s\t%s\t%d\n", query_names[q].c_str(), top[i].name.c_str(), top[i].score);
+    }
+
+    log_info(stderr, "  searched %u queries against %llu sequences in %.2fs\n", n_queries, db_size, global_timer.seconds());
+    log_info(stderr, "    alignment: %.2f GCUPS\n", 1.0e-9f * float(n_cells) / aln_time);
+    return 0;
+}
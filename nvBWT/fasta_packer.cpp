@@ -0,0 +1,645 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+// fasta_packer.cpp
+//
+
+#include "fasta_packer.h"
+#include <nvbio/basic/console.h>
+#include <nvbio/basic/numbers.h>
+#include <nvbio/basic/threads.h>
+#include <nvbio/fasta/fasta.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <deque>
+
+using namespace nvbio;
+
+namespace {
+
+unsigned char nst_nt4_table[256] = {
+	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4, 
+	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4, 
+	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 5 /*'-'*/, 4, 4,
+	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4, 
+	4, 0, 4, 1,  4, 4, 4, 2,  4, 4, 4, 4,  4, 4, 4, 4, 
+	4, 4, 4, 4,  3, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4, 
+	4, 0, 4, 1,  4, 4, 4, 2,  4, 4, 4, 4,  4, 4, 4, 4, 
+	4, 4, 4, 4,  3, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4, 
+	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4, 
+	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4, 
+	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4, 
+	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4, 
+	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4, 
+	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4, 
+	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4, 
+	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4
+};
+
+#define RAND    0
+#define RAND48  1
+
+#if (GENERATOR == RAND) || ((GENERATOR == RAND48) && defined(WIN32))
+
+// generate random base pairs using rand()
+inline void  srand_bp(const unsigned int s) { srand(s); }
+inline float frand() { return float(rand()) / float(RAND_MAX); }
+inline uint8 rand_bp() { return uint8( frand() * 4 ) & 3; }
+
+#elif (GENERATOR == RAND48)
+
+// generate random base pairs using rand48()
+inline void  srand_bp(const unsigned int s) { srand48(s); }
+inline uint8 rand_bp() { return uint8( drand48() * 4 ) & 3; }
+
+#endif
+
+// the maximum size of a parsed chunk, in bytes
+//
+const uint32 CHUNK_SIZE = 4u*1024u*1024u;
+
+//
+// A chunk of a parsed FASTA file: the raw bps, together with the list of read boundaries
+// falling within them
+//
+struct FASTAChunk
+{
+    enum MarkType { BEGIN_READ = 0, END_READ = 1 };
+
+    FASTAChunk() : mark_bytes( 0 ) {}
+
+    // the amount of memory held by this chunk, accounting for the read marks and names too,
+    // as a file made of many short reads may have more of those than bps
+    uint64 size() const { return bps.capacity() + mark_bytes; }
+
+    struct Mark
+    {
+        uint32      offset;     // the offset of the mark within the chunk's bps
+        uint32      type;       // the mark type
+        std::string name;       // the read name, for BEGIN_READ marks
+    };
+
+    std::vector<uint8> bps;
+    std::vector<Mark>  marks;
+    uint64             mark_bytes;  // the size of the marks, including their names
+};
+
+//
+// A per-file queue of parsed chunks
+//
+struct FASTAFileQueue
+{
+    FASTAFileQueue() : done( false ), error( false ) {}
+
+    std::deque<FASTAChunk*> chunks;
+    bool                    done;
+    bool                    error;
+};
+
+//
+// The state shared between the parsing threads and the packing (consumer) thread
+//
+struct FASTAPackingContext
+{
+    FASTAPackingContext(const std::vector<std::string>& _file_names, const uint64 _max_memory) :
+        file_names( _file_names ),
+        queues( _file_names.size() ),
+        next_file( 0 ),
+        head_file( 0 ),
+        buffered( 0 ),
+        max_memory( _max_memory ),
+        abort( false ) {}
+
+    // fetch the next file to parse, returning false when there's none left
+    //
+    bool next(uint32* file)
+    {
+        ScopedLock lock( &mutex );
+        if (abort || next_file >= file_names.size())
+            return false;
+
+        *file = next_file++;
+        return true;
+    }
+
+    // push a parsed chunk to the queue of the given file, blocking while the memory budget
+    // is exhausted: the only exception is a chunk of the file currently being consumed when
+    // its queue is empty, as the consumer is then waiting on it, so that at most one chunk
+    // in excess of the budget is ever buffered
+    //
+    bool push(const uint32 file, FASTAChunk* chunk)
+    {
+        const uint64 chunk_bytes = chunk->size();
+
+        ScopedLock lock( &mutex );
+        while (abort == false &&
+               (file != head_file || queues[file].chunks.empty() == false) &&
+               buffered + chunk_bytes > max_memory)
+            cond.wait( &mutex );
+
+        if (abort)
+        {
+            delete chunk;
+            return false;
+        }
+
+        queues[file].chunks.push_back( chunk );
+        buffered += chunk_bytes;
+        cond.broadcast();
+        return true;
+    }
+
+    // mark the given file as fully parsed
+    //
+    void finish(const uint32 file, const bool error)
+    {
+        ScopedLock lock( &mutex );
+        queues[file].done  = true;
+        queues[file].error = error;
+        cond.broadcast();
+    }
+
+    // pop the next chunk of the given file, blocking until one is available;
+    // returns NULL once the file has been fully consumed
+    //
+    FASTAChunk* pop(const uint32 file, bool* error)
+    {
+        ScopedLock lock( &mutex );
+        if (head_file != file)
+        {
+            // wake up the parser of the new head file, if it was waiting on the budget
+            head_file = file;
+            cond.broadcast();
+        }
+
+        FASTAFileQueue& queue = queues[file];
+        while (queue.chunks.empty() && queue.done == false)
+            cond.wait( &mutex );
+
+        *error = queue.error;
+        if (queue.chunks.empty())
+            return NULL;
+
+        FASTAChunk* chunk = queue.chunks.front();
+        queue.chunks.pop_front();
+
+        buffered -= chunk->size();
+        cond.broadcast();
+        return chunk;
+    }
+
+    // stop all parsers and release all pending chunks
+    //
+    void stop()
+    {
+        ScopedLock lock( &mutex );
+        abort = true;
+        for (uint32 i = 0; i < queues.size(); ++i)
+        {
+            while (queues[i].chunks.empty() == false)
+            {
+                delete queues[i].chunks.front();
+                queues[i].chunks.pop_front();
+            }
+        }
+        cond.broadcast();
+    }
+
+    const std::vector<std::string>& file_names;
+    std::vector<FASTAFileQueue>     queues;
+    uint32                          next_file;
+    uint32                          head_file;
+    uint64                          buffered;
+    uint64                          max_memory;
+    bool                            abort;
+    Mutex                           mutex;
+    Condition                       cond;
+};
+
+//
+// A FASTA_inc_reader output handler splitting a file into chunks
+//
+struct FASTAChunker
+{
+    FASTAChunker(FASTAPackingContext* context, const uint32 file) :
+        m_context( context ), m_file( file ), m_chunk( new FASTAChunk ), m_ok( true ) {}
+
+    ~FASTAChunker() { delete m_chunk; }
+
+    void begin_read()
+    {
+        FASTAChunk::Mark mark;
+        mark.offset = uint32( m_chunk->bps.size() );
+        mark.type   = FASTAChunk::BEGIN_READ;
+        m_chunk->marks.push_back( mark );
+        m_chunk->mark_bytes += sizeof(FASTAChunk::Mark);
+    }
+    void end_read()
+    {
+        FASTAChunk::Mark mark;
+        mark.offset = uint32( m_chunk->bps.size() );
+        mark.type   = FASTAChunk::END_READ;
+        m_chunk->marks.push_back( mark );
+        m_chunk->mark_bytes += sizeof(FASTAChunk::Mark);
+    }
+
+    // ids always follow a begin_read() mark within the same chunk, as chunks
+    // are only flushed upon reading bps
+    void id(const uint8 c)
+    {
+        m_chunk->marks.back().name.push_back( char(c) );
+        m_chunk->mark_bytes++;
+    }
+
+    void read(const uint8 c)
+    {
+        // flush as soon as the bps and the marks together fill up the chunk
+        if (m_chunk->bps.size() + m_chunk->mark_bytes >= CHUNK_SIZE)
+            flush();
+
+        m_chunk->bps.push_back( c );
+    }
+
+    void flush()
+    {
+        if (m_ok)
+            m_ok = m_context->push( m_file, m_chunk );
+        else
+            delete m_chunk;
+
+        m_chunk = new FASTAChunk;
+        m_chunk->bps.reserve( CHUNK_SIZE );
+    }
+
+    FASTAPackingContext* m_context;
+    uint32               m_file;
+    FASTAChunk*          m_chunk;
+    bool                 m_ok;
+};
+
+//
+// A FASTA parsing thread
+//
+struct FASTAParserThread : public Thread<FASTAParserThread>
+{
+    FASTAParserThread() : context( NULL ) {}
+
+    void run()
+    {
+        uint32 file;
+        while (context->next( &file ))
+        {
+            FASTA_inc_reader fasta( context->file_names[file].c_str() );
+            if (fasta.valid() == false)
+            {
+                context->finish( file, true );
+                continue;
+            }
+
+            FASTAChunker chunker( context, file );
+
+            // parse the whole file in one go: reads are streamed to the chunker one bp at a time
+            fasta.read( uint32(-1), chunker );
+
+            // push the last chunk
+            chunker.flush();
+
+            context->finish( file, false );
+        }
+    }
+
+    FASTAPackingContext* context;
+};
+
+//
+// An incremental writer of 2-bit packed .pac / .wpac files
+//
+struct PacWriter
+{
+    PacWriter() : m_file( NULL ), m_word( 0 ), m_size( 0 ) {}
+    ~PacWriter() { if (m_file) fclose( m_file ); }
+
+    bool open(const char* pac_name, const PacType pac_type)
+    {
+        m_type = pac_type;
+        m_file = fopen( pac_name, "wb" );
+        if (m_file == NULL)
+            return false;
+
+        m_buffer.reserve( 1024*1024 );
+
+        if (m_type == WPAC)
+        {
+            // reserve space for the sequence length, which will be filled-in upon closing
+            const uint64 len = 0;
+            fwrite( &len, sizeof(len), 1u, m_file );
+        }
+        return true;
+    }
+
+    void push(const uint8 c)
+    {
+        // pack the symbol in big-endian order
+        const uint32 symbols_per_word = m_type == WPAC ? 16u : 4u;
+        const uint32 bit = (symbols_per_word - 1u - uint32(m_size & (symbols_per_word-1u))) * 2u;
+
+        m_word |= uint32(c) << bit;
+
+        if (++m_size % symbols_per_word == 0)
+            emit();
+    }
+
+    bool close()
+    {
+        const uint32 symbols_per_word = m_type == WPAC ? 16u : 4u;
+        if (m_size % symbols_per_word)
+            emit();
+
+        bool ok = flush();
+
+        if (m_type == BPAC)
+        {
+            // the following code makes the pac file size always (l_pac/4+1+1)
+            if (m_size % 4 == 0)
+            {
+                const uint8 ct = 0;
+                ok &= fwrite( &ct, 1, 1, m_file ) == 1;
+            }
+            const uint8 ct = uint8( m_size % 4 );
+            ok &= fwrite( &ct, 1, 1, m_file ) == 1;
+        }
+        else
+        {
+            // write the sequence length as a uint64
+            ok &= fseek( m_file, 0, SEEK_SET ) == 0;
+            ok &= fwrite( &m_size, sizeof(m_size), 1u, m_file ) == 1u;
+        }
+
+        ok &= fclose( m_file ) == 0;
+        m_file = NULL;
+        return ok;
+    }
+
+    uint64 size() const { return m_size; }
+
+private:
+    void emit()
+    {
+        if (m_type == WPAC)
+        {
+            const uint8* bytes = reinterpret_cast<const uint8*>( &m_word );
+            m_buffer.insert( m_buffer.end(), bytes, bytes + sizeof(uint32) );
+        }
+        else
+            m_buffer.push_back( uint8( m_word ) );
+
+        m_word = 0;
+
+        if (m_buffer.size() >= 1024*1024)
+            flush();
+    }
+
+    bool flush()
+    {
+        const size_t n = m_buffer.size();
+        const bool  ok = n == 0 || fwrite( &m_buffer[0], 1u, n, m_file ) == n;
+        m_buffer.clear();
+        return ok;
+    }
+
+    PacType             m_type;
+    FILE*               m_file;
+    std::vector<uint8>  m_buffer;
+    uint32              m_word;
+    uint64              m_size;
+};
+
+} // anonymous namespace
+
+// constructor
+//
+FASTAPacker::FASTAPacker() : m_length( 0 )
+{
+    for (uint32 i = 0; i < 4; ++i)
+        m_freq[i] = 0;
+}
+
+// pack the given list of files
+//
+bool FASTAPacker::pack(
+    const std::vector<std::string>& file_names,
+    const char*                     pac_name,
+    const PacType                   pac_type,
+    const uint64                    max_length,
+    const uint32                    n_threads,
+    const uint64                    max_memory)
+{
+    PacWriter pac;
+    if (pac.open( pac_name, pac_type ) == false)
+    {
+        log_error(stderr, "  could not open output file \"%s\"!\n", pac_name );
+        return false;
+    }
+
+    const uint32 n_files = uint32( file_names.size() );
+
+    // start the parsers
+    FASTAPackingContext context( file_names, max_memory );
+
+    std::vector<FASTAParserThread> parsers( nvbio::max( nvbio::min( n_threads ? n_threads : num_logical_cores(), n_files ), 1u ) );
+    for (uint32 i = 0; i < parsers.size(); ++i)
+    {
+        parsers[i].context = &context;
+        parsers[i].set_id( i );
+        parsers[i].create();
+    }
+
+    m_bntseq      = BNTSeq();
+    m_bntseq.seed = 11;
+
+    srand_bp( m_bntseq.seed );
+
+    for (uint32 i = 0; i < 4; ++i)
+        m_freq[i] = 0;
+
+    uint64 size  = 0;
+    uint8  lasts = 0;
+    bool   ok    = true;
+
+    // consume the parsed chunks in file order
+    for (uint32 f = 0; f < n_files && ok; ++f)
+    {
+        log_info(stderr, "  packing \"%s\"\n", file_names[f].c_str());
+
+        bool error;
+        while (FASTAChunk* chunk = context.pop( f, &error ))
+        {
+            const uint32 n_bps = uint32( chunk->bps.size() );
+
+            uint32 i = 0;
+            for (uint32 m = 0; m <= chunk->marks.size(); ++m)
+            {
+                // process all bps up to the next mark
+                const uint32 end = m < chunk->marks.size() ? chunk->marks[m].offset : n_bps;
+
+                for (; i < end; ++i)
+                {
+                    const uint8 s = chunk->bps[i];
+
+                    if (size < max_length)
+                    {
+                        const uint8 c = nst_nt4_table[s];
+
+                        const uint8 sc = c < 4 ? c : rand_bp();
+
+                        pac.push( sc );
+
+                        // keep track of the symbol frequencies
+                        ++m_freq[sc];
+
+                        if (c >= 4) // we have an N
+                        {
+                            if (lasts == s) // contiguous N
+                            {
+                                // increment length of the last hole
+                                ++m_bntseq.ambs.back().len;
+                            }
+                            else
+                            {
+                                // beginning of a new hole
+                                BNTAmb amb;
+                                amb.len    = 1;
+                                amb.offset = size;
+                                amb.amb    = s;
+
+                                m_bntseq.ambs.push_back( amb );
+
+                                ++m_bntseq.anns_data[ m_bntseq.n_seqs ].n_ambs;
+                                ++m_bntseq.n_holes;
+                            }
+                        }
+                        // save last symbol
+                        lasts = s;
+
+                        // update sequence length
+                        m_bntseq.anns_data[ m_bntseq.n_seqs ].len++;
+                    }
+
+                    m_bntseq.l_pac++;
+
+                    size++;
+                }
+
+                if (m == chunk->marks.size())
+                    break;
+
+                const FASTAChunk::Mark& mark = chunk->marks[m];
+                if (mark.type == FASTAChunk::BEGIN_READ)
+                {
+                    BNTAnnData ann_data;
+                    ann_data.len    = 0;
+                    ann_data.gi     = 0;
+                    ann_data.offset = size;
+                    ann_data.n_ambs = 0;
+
+                    BNTAnnInfo ann_info;
+                    ann_info.name   = mark.name;
+                    ann_info.anno   = "null";
+
+                    m_bntseq.anns_data.push_back( ann_data );
+                    m_bntseq.anns_info.push_back( ann_info );
+
+                    lasts = 0;
+                }
+                else
+                    m_bntseq.n_seqs++;
+            }
+            delete chunk;
+        }
+
+        if (error)
+        {
+            log_error(stderr, "  unable to open file \"%s\"\n", file_names[f].c_str());
+            ok = false;
+        }
+    }
+
+    // stop and join the parsers
+    if (ok == false)
+        context.stop();
+
+    for (uint32 i = 0; i < parsers.size(); ++i)
+        parsers[i].join();
+
+    if (ok == false)
+        return false;
+
+    if (pac.close() == false)
+    {
+        log_error(stderr, "  writing \"%s\" failed!\n", pac_name);
+        return false;
+    }
+
+    m_length = pac.size();
+    return true;
+}
+
+// unpack a range of words of a packed file into a 2-bit big-endian uint32 packed stream
+//
+void unpack_pac_words(
+    const PacType   pac_type,
+    const void*     pac_data,
+    const uint64    seq_length,
+    const uint64    word_begin,
+    const uint32    n_words,
+    uint32*         words)
+{
+    if (pac_type == WPAC)
+    {
+        // the .wpac words follow a uint64 header, and share the in-memory layout
+        const uint32* pac_words = reinterpret_cast<const uint32*>( reinterpret_cast<const uint8*>( pac_data ) + sizeof(uint64) );
+        memcpy( words, pac_words + word_begin, sizeof(uint32) * n_words );
+        return;
+    }
+
+    // assemble each word from 4 consecutive big-endian packed bytes, skipping the .pac trailer
+    const uint8* pac_bytes = reinterpret_cast<const uint8*>( pac_data );
+    const uint64 n_bytes   = util::divide_ri( seq_length, 4u );
+
+    for (uint32 w = 0; w < n_words; ++w)
+    {
+        const uint64 b = (word_begin + w) * 4u;
+
+        uint32 word = 0u;
+        for (uint32 j = 0; j < 4; ++j)
+            word |= uint32( b + j < n_bytes ? pac_bytes[b + j] : 0u ) << ((3u - j)*8u);
+
+        words[w] = word;
+    }
+}
@@ -0,0 +1,96 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/bnt.h>
+#include <string>
+#include <vector>
+
+// PAC File Type
+enum PacType { BPAC = 0, WPAC = 1 };
+
+///
+/// A streaming reference packer: the input FASTA files are parsed in parallel by a pool
+/// of threads, while the calling thread consumes the parsed chunks in file order, packing
+/// the bps to a 2-bit .pac (or .wpac) file on the fly and collecting the annotations.
+///
+/// The full reference is never buffered in memory: the amount of parsed data waiting
+/// to be packed is bounded by a user-specified budget, and the resulting packed file
+/// can later be memory-mapped back for sorting.
+///
+struct FASTAPacker
+{
+    /// constructor
+    ///
+    FASTAPacker();
+
+    /// pack the given list of files
+    ///
+    /// \param file_names       the sorted list of input files
+    /// \param pac_name         the name of the output packed file
+    /// \param pac_type         the output packing, BPAC or WPAC
+    /// \param max_length       clamp the packed sequence to max_length bps
+    /// \param n_threads        the number of parsing threads (0 = number of logical cores)
+    /// \param max_memory       the maximum amount of parsed data buffered in memory; a single
+    ///                         parsed chunk (a few MB) is let through when the budget is
+    ///                         smaller, so that packing can always progress
+    ///
+    /// \return                 true upon success
+    ///
+    bool pack(
+        const std::vector<std::string>& file_names,
+        const char*                     pac_name,
+        const PacType                   pac_type,
+        const nvbio::uint64             max_length,
+        const nvbio::uint32             n_threads  = 0u,
+        const nvbio::uint64             max_memory = 256u*1024u*1024u);
+
+    nvbio::BNTSeq   m_bntseq;       ///< the reference annotations
+    nvbio::uint64   m_length;       ///< the packed sequence length
+    nvbio::uint32   m_freq[4];      ///< the symbol frequencies
+};
+
+/// unpack a range of words of a packed file into a 2-bit big-endian uint32 packed stream,
+/// the format used by the FM-index construction
+///
+/// \param pac_type         the packed file type
+/// \param pac_data         the memory-mapped packed file
+/// \param seq_length       the packed sequence length
+/// \param word_begin       the first word to unpack
+/// \param n_words          the number of words to unpack
+/// \param words            the output words
+///
+void unpack_pac_words(
+    const PacType           pac_type,
+    const void*             pac_data,
+    const nvbio::uint64     seq_length,
+    const nvbio::uint64     word_begin,
+    const nvbio::uint32     n_words,
+    nvbio::uint32*          words);
@@ -43,6 +43,7 @@
 #include <nvbio/basic/numbers.h>
 #include <nvbio/basic/timer.h>
 #include <nvbio/basic/packedstream.h>
+#include <nvbio/basic/mmap.h>
 #include <nvbio/basic/thrust_view.h>
 #include <nvbio/basic/dna.h>
 #include <nvbio/basic/exceptions.h>
@@ -52,159 +53,10 @@
 #include <nvbio/io/fmindex/fmindex.h>
 #include <nvbio/sufsort/sufsort.h>
 #include "filelist.h"
-
-// PAC File Type
-enum PacType { BPAC = 0, WPAC = 1 };
+#include "fasta_packer.h"
 
 using namespace nvbio;
 
-unsigned char nst_nt4_table[256] = {
-	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4, 
-	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4, 
-	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 5 /*'-'*/, 4, 4,
-	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4, 
-	4, 0, 4, 1,  4, 4, 4, 2,  4, 4, 4, 4,  4, 4, 4, 4, 
-	4, 4, 4, 4,  3, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4, 
-	4, 0, 4, 1,  4, 4, 4, 2,  4, 4, 4, 4,  4, 4, 4, 4, 
-	4, 4, 4, 4,  3, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4, 
-	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4, 
-	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4, 
-	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4, 
-	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4, 
-	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4, 
-	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4, 
-	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4, 
-	4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4,  4, 4, 4, 4
-};
-
-
-#define RAND    0
-#define RAND48  1
-
-#if (GENERATOR == RAND) || ((GENERATOR == RAND48) && defined(WIN32))
-
-// generate random base pairs using rand()
-inline void  srand_bp(const unsigned int s) { srand(s); }
-inline float frand() { return float(rand()) / float(RAND_MAX); }
-inline uint8 rand_bp() { return uint8( frand() * 4 ) & 3; }
-
-#elif (GENERATOR == RAND48)
-
-// generate random base pairs using rand48()
-inline void  srand_bp(const unsigned int s) { srand48(s); }
-inline uint8 rand_bp() { return uint8( drand48() * 4 ) & 3; }
-
-#endif
-
-struct Counter
-{
-    Counter() : m_size(0), m_reads(0) {}
-
-    void begin_read() { m_reads++; }
-    void end_read() {}
-
-    void id(const uint8 c) {}
-    void read(const uint8 c) { m_size++; }
-
-    uint64 m_size;
-    uint32 m_reads;
-};
-
-template <typename stream_type>
-struct Writer
-{
-    Writer(stream_type stream, const uint32 reads, const uint64 max_size) :
-        m_max_size(max_size), m_size(0), m_stream( stream )
-    {
-        m_bntseq.seed = 11;
-        m_bntseq.anns_data.resize( reads );
-        m_bntseq.anns_info.resize( reads );
-
-        srand_bp( m_bntseq.seed );
-
-        for (uint32 i = 0; i < 4; ++i)
-            m_freq[i] = 0;
-    }
-
-    void begin_read()
-    {
-        BNTAnnData& ann_data = m_bntseq.anns_data[ m_bntseq.n_seqs ];
-        ann_data.len    = 0;
-        ann_data.gi     = 0;
-        ann_data.offset = m_size;
-        ann_data.n_ambs = 0;
-
-        BNTAnnInfo& ann_info = m_bntseq.anns_info[ m_bntseq.n_seqs ];
-        ann_info.anno   = "null";
-
-        m_lasts = 0;
-    }
-    void end_read()
-    {
-        m_bntseq.n_seqs++;
-    }
-
-    void id(const uint8 c)
-    {
-        m_bntseq.anns_info[ m_bntseq.n_seqs ].name.push_back(char(c));
-    }
-    void read(const uint8 s)
-    {
-        if (m_size < m_max_size)
-        {
-            const uint8 c = nst_nt4_table[s];
-
-            const uint8 sc = c < 4 ? c : rand_bp();
-
-            m_stream[ m_size ] = sc;
-
-            // keep track of the symbol frequencies
-            ++m_freq[sc];
-
-            if (c >= 4) // we have an N
-            {
-                if (m_lasts == s) // contiguous N
-                {
-                    // increment length of the last hole
-                    ++m_bntseq.ambs.back().len;
-                }
-                else
-                {
-                    // beginning of a new hole
-                    BNTAmb amb;
-                    amb.len    = 1;
-                    amb.offset = m_size;
-                    amb.amb    = s;
-
-                    m_bntseq.ambs.push_back( amb );
-
-                    ++m_bntseq.anns_data[ m_bntseq.n_seqs ].n_ambs;
-                    ++m_bntseq.n_holes;
-                }
-            }
-            // save last symbol
-            m_lasts = s;
-
-            // update sequence length
-            BNTAnnData& ann_data = m_bntseq.anns_data[ m_bntseq.n_seqs ];
-            ann_data.len++;
-        }
-
-        m_bntseq.l_pac++;
-
-        m_size++;
-    }
-
-    uint64      m_max_size;
-    uint64      m_size;
-    stream_type m_stream;
-
-    BNTSeq      m_bntseq;
-    uint8       m_lasts;
-
-    uint32      m_freq[4];
-};
-
 template <typename StreamType>
 bool save_stream(FILE* output_file, const uint64 seq_words, const StreamType* stream)
 {
@@ -353,6 +205,66 @@ void save_ssa(const uint32 seq_length, const uint32 sa_intv, const uint32 ssa_le
     log_info(stderr, "writing \"%s\"... done\n", sa_name);
 }
 
+//
+// compute the crc of a memory-mapped .pac | .wpac file
+//
+uint32 pac_crc(const PacType pac_type, const void* pac_data, const uint64 seq_length)
+{
+    if (pac_type == BPAC)
+    {
+        const PackedStream<const uint8*,uint8,2,true,int64> string( (const uint8*)pac_data );
+        return crcCalc( string, uint32(seq_length) );
+    }
+    else
+    {
+        const PackedStream<const uint32*,uint8,2,true,int64> string( (const uint32*)( (const uint8*)pac_data + sizeof(uint64) ) );
+        return crcCalc( string, uint32(seq_length) );
+    }
+}
+
+//
+// reverse a memory-mapped .pac | .wpac file into a uint32 packed stream
+//
+template <typename stream_type>
+void reverse_pac(const PacType pac_type, const void* pac_data, const uint64 seq_length, stream_type rstring)
+{
+    if (pac_type == BPAC)
+    {
+        const PackedStream<const uint8*,uint8,2,true,int64> string( (const uint8*)pac_data );
+        for (uint64 i = 0; i < seq_length; ++i)
+            rstring[i] = string[ seq_length - i - 1u ];
+    }
+    else
+    {
+        const PackedStream<const uint32*,uint8,2,true,int64> string( (const uint32*)( (const uint8*)pac_data + sizeof(uint64) ) );
+        for (uint64 i = 0; i < seq_length; ++i)
+            rstring[i] = string[ seq_length - i - 1u ];
+    }
+}
+
+//
+// upload a memory-mapped .pac | .wpac file to a device packed stream, in blocks
+//
+void upload_pac(const PacType pac_type, const void* pac_data, const uint64 seq_length, thrust::device_vector<uint32>& d_string_storage)
+{
+    const uint64 seq_words  = util::divide_ri( seq_length, 16u );
+    const uint32 block_size = 4u*1024u*1024u;
+
+    thrust::host_vector<uint32> h_block( nvbio::min( seq_words, uint64(block_size) ) );
+
+    for (uint64 word_begin = 0; word_begin < seq_words; word_begin += block_size)
+    {
+        const uint32 n_words = (uint32)nvbio::min( uint64(block_size), seq_words - word_begin );
+
+        unpack_pac_words( pac_type, pac_data, seq_length, word_begin, n_words, nvbio::plain_view( h_block ) );
+
+        thrust::copy(
+            h_block.begin(),
+            h_block.begin() + n_words,
+            d_string_storage.begin() + word_begin );
+    }
+}
+
 int build(
     const char*  input_name,
     const char*  output_name,
@@ -364,97 +276,78 @@ int build(
     const char*  rsa_name,
     const uint64 max_length,
     const PacType pac_type,
-    const bool    compute_crc)
+    const bool    compute_crc,
+    const uint32  n_threads)
 {
     std::vector<std::string> sortednames;
     list_files(input_name, sortednames);
 
-    uint32 n_inputs = (uint32)sortednames.size();
-    log_info(stderr, "\ncounting bps... started\n");
-    // count entire sequence length
-    Counter counter;
-
-    for (uint32 i = 0; i < n_inputs; ++i)
-    {
-        log_info(stderr, "  counting \"%s\"\n", sortednames[i].c_str());
-
-        FASTA_inc_reader fasta( sortednames[i].c_str() );
-        if (fasta.valid() == false)
-        {
-            log_error(stderr, "  unable to open file\n");
-            exit(1);
-        }
+    log_info(stderr, "\npacking bps... started\n");
+    // parse all files in parallel, streaming the packed string straight to disk
+    FASTAPacker packer;
+    if (packer.pack( sortednames, pac_name, pac_type, max_length, n_threads ) == false)
+        exit(1);
 
-        while (fasta.read( 1024, counter ) == 1024);
-    }
-    log_info(stderr, "counting bps... done\n");
+    save_bns( packer.m_bntseq, output_name );
+    log_info(stderr, "packing bps... done\n");
 
-    const uint64 seq_length   = nvbio::min( (uint64)counter.m_size, (uint64)max_length );
+    const uint64 seq_length   = packer.m_length;
     const uint32 bps_per_word = sizeof(uint32)*4u;
     const uint64 seq_words    = (seq_length + bps_per_word - 1u) / bps_per_word;
 
     log_info(stderr, "\nstats:\n");
-    log_info(stderr, "  reads           : %u\n", counter.m_reads );
+    log_info(stderr, "  reads           : %u\n", packer.m_bntseq.n_seqs );
     log_info(stderr, "  sequence length : %llu bps (%.1f MB)\n",
         seq_length,
         float(seq_words*sizeof(uint32))/float(1024*1024));
     log_info(stderr, "  buffer size     : %.1f MB\n",
-        2*seq_words*sizeof(uint32)/1.0e6f );
+        seq_words*sizeof(uint32)/1.0e6f );
+
+    // compute the cumulative symbol frequencies
+    uint32 cumFreq[4] = { 0, 0, 0, 0 };
+    cumFreq[0] = packer.m_freq[0];
+    cumFreq[1] = packer.m_freq[1] + cumFreq[0];
+    cumFreq[2] = packer.m_freq[2] + cumFreq[1];
+    cumFreq[3] = packer.m_freq[3] + cumFreq[2];
+
+    if (cumFreq[3] != seq_length)
+    {
+        log_error(stderr, "  mismatching symbol frequencies!\n");
+        log_error(stderr, "    (%u, %u, %u, %u)\n", cumFreq[0], cumFreq[1], cumFreq[2], cumFreq[3]);
+        exit(1);
+    }
+
+    // map the packed string back from disk, rather than keeping a copy in memory
+    DiskMappedFile pac_file;
+    const void*    pac_data = NULL;
+    try
+    {
+        pac_data = pac_file.init( pac_name );
+    }
+    catch (DiskMappedFile::mapping_error e)
+    {
+        log_error(stderr, "  could not open file \"%s\" (error %d)\n", e.m_file_name, e.m_code);
+        exit(1);
+    }
+    catch (DiskMappedFile::view_error e)
+    {
+        log_error(stderr, "  could not map file \"%s\" (error %d)\n", e.m_file_name, e.m_code);
+        exit(1);
+    }
 
     const uint32 sa_intv = nvbio::io::FMIndexData::SA_INT;
     const uint32 ssa_len = (seq_length + sa_intv) / sa_intv;
 
     // allocate the actual storage
-    thrust::host_vector<uint32> h_string_storage( seq_words+1 );
     thrust::host_vector<uint32> h_bwt_storage( seq_words+1 );
     thrust::host_vector<uint32> h_ssa( ssa_len );
 
     typedef PackedStream<const uint32*,uint8,io::FMIndexData::BWT_BITS,io::FMIndexData::BWT_BIG_ENDIAN> const_stream_type;
     typedef PackedStream<      uint32*,uint8,io::FMIndexData::BWT_BITS,io::FMIndexData::BWT_BIG_ENDIAN>       stream_type;
 
-    stream_type h_string( nvbio::plain_view( h_string_storage ) );
-
-    uint32 cumFreq[4] = { 0, 0, 0, 0 };
-
-    log_info(stderr, "\nbuffering bps... started\n");
-    // read all files
-    {
-        Writer<stream_type> writer( h_string, counter.m_reads, seq_length );
-
-        for (uint32 i = 0; i < n_inputs; ++i)
-        {
-            log_info(stderr, "  buffering \"%s\"\n", sortednames[i].c_str());
-
-            FASTA_inc_reader fasta( sortednames[i].c_str() );
-            if (fasta.valid() == false)
-            {
-                log_error(stderr, "  unable to open file!\n");
-                exit(1);
-            }
-
-            while (fasta.read( 1024, writer ) == 1024);
-        }
-
-        save_bns( writer.m_bntseq, output_name );
-
-        // compute the cumulative symbol frequencies
-        cumFreq[0] = writer.m_freq[0];
-        cumFreq[1] = writer.m_freq[1] + cumFreq[0];
-        cumFreq[2] = writer.m_freq[2] + cumFreq[1];
-        cumFreq[3] = writer.m_freq[3] + cumFreq[2];
-
-        if (cumFreq[3] != seq_length)
-        {
-            log_error(stderr, "  mismatching symbol frequencies!\n");
-            log_error(stderr, "    (%u, %u, %u, %u)\n", cumFreq[0], cumFreq[1], cumFreq[2], cumFreq[3]);
-            exit(1);
-        }
-    }
-    log_info(stderr, "buffering bps... done\n");
-
     if (compute_crc)
     {
-        const uint32 crc = crcCalc( h_string, uint32(seq_length) );
+        const uint32 crc = pac_crc( pac_type, pac_data, seq_length );
         log_info(stderr, "  crc: %u\n", crc);
     }
 
@@ -463,9 +356,11 @@ int build(
         BWTParams params;
         uint32    primary;
 
-        thrust::device_vector<uint32> d_string_storage( h_string_storage );
+        thrust::device_vector<uint32> d_string_storage( seq_words+1 );
         thrust::device_vector<uint32> d_bwt_storage( seq_words+1 );
 
+        upload_pac( pac_type, pac_data, seq_length, d_string_storage );
+
         const_stream_type d_string( nvbio::plain_view( d_string_storage ) );
               stream_type d_bwt(    nvbio::plain_view( d_bwt_storage ) );
 
@@ -510,27 +405,28 @@ int build(
                 log_info(stderr, "  crc: %u\n", crc);
             }
 
-            save_pac( seq_length, nvbio::plain_view( h_string_storage ),                           pac_name, pac_type );
             save_bwt( seq_length, seq_words, primary, cumFreq, nvbio::plain_view( h_bwt_storage ), bwt_name );
             save_ssa( seq_length, sa_intv, ssa_len, primary, cumFreq, nvbio::plain_view( h_ssa ),  sa_name );
         }
 
-        // reverse the string in h_string_storage
+        // reverse the string
         {
-            // reuse the bwt storage to build the reverse
+            // reuse the bwt storage to build the reverse, streaming the forward string from the mapped file
             uint32* h_rbase_stream = nvbio::plain_view( h_bwt_storage );
             stream_type h_rstring( h_rbase_stream );
 
-            // reverse the string
-            for (uint32 i = 0; i < seq_length; ++i)
-                h_rstring[i] = h_string[ seq_length - i - 1u ];
+            reverse_pac( pac_type, pac_data, seq_length, h_rstring );
 
-            // and now swap the vectors
-            h_bwt_storage.swap( h_string_storage );
-            h_string = stream_type( nvbio::plain_view( h_string_storage ) );
+            // clear the padding
+            for (uint64 i = seq_length; i < seq_words * bps_per_word; ++i)
+                h_rstring[i] = 0u;
+            h_bwt_storage[ seq_words ] = 0u;
 
-            // and copy back the new string to the device
-            d_string_storage = h_string_storage;
+            // save the reverse string before its storage gets reused for the reverse BWT
+            save_pac( seq_length, nvbio::plain_view( h_bwt_storage ), rpac_name, pac_type );
+
+            // and copy the new string to the device
+            d_string_storage = h_bwt_storage;
         }
 
         log_info(stderr, "\nbuilding reverse BWT... started\n");
@@ -572,7 +468,6 @@ int build(
                 log_info(stderr, "  crc: %u\n", crc);
             }
 
-            save_pac( seq_length, nvbio::plain_view( h_string_storage ),                           rpac_name, pac_type );
             save_bwt( seq_length, seq_words, primary, cumFreq, nvbio::plain_view( h_bwt_storage ), rbwt_name );
             save_ssa( seq_length, sa_intv, ssa_len, primary, cumFreq, nvbio::plain_view( h_ssa ),  rsa_name );
         }
@@ -635,6 +530,7 @@ int main(int argc, char* argv[])
         log_info(stderr, "    -w | --word-packing   output word packed .wpac\n");
         log_info(stderr, "    -c | --crc            compute crcs\n");
         log_info(stderr, "    -d | --device         cuda device\n");
+        log_info(stderr, "    -t | --threads        number of FASTA parsing threads\n");
         exit(0);
     }
 
@@ -643,6 +539,7 @@ int main(int argc, char* argv[])
     PacType pac_type    = BPAC;
     bool    crc         = false;
     int     cuda_device = -1;
+    uint32  n_threads   = 0;
 
     uint32 n_files = 0;
     for (int32 i = 1; i < argc; ++i)
@@ -680,6 +577,11 @@ int main(int argc, char* argv[])
         {
             cuda_device = atoi( argv[++i] );
         }
+        else if ((strcmp( arg, "-t" )               == 0) ||
+                 (strcmp( arg, "--threads" )        == 0))
+        {
+            n_threads = atoi( argv[++i] );
+        }
         else
             file_names[ n_files++ ] = argv[i];
     }
@@ -754,7 +656,7 @@ int main(int argc, char* argv[])
 
         cuda::check_error("cuda-memory-check");
 
-        return build( input_name, output_name, pac_name, rpac_name, bwt_name, rbwt_name, sa_name, rsa_name, max_length, pac_type, crc );
+        return build( input_name, output_name, pac_name, rpac_name, bwt_name, rbwt_name, sa_name, rsa_name, max_length, pac_type, crc, n_threads );
     }
     catch (nvbio::cuda_error e)
     {
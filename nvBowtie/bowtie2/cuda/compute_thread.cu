@@ -217,7 +217,9 @@ void ComputeThreadSE::do_run()
         Timer io_timer;
         io_timer.start();
 
-        io::SequenceDataHost* read_data_host = input_thread->next( &read_begin );
+        InputThreadSE::batch_type* read_batch = input_thread->next( &read_begin );
+
+        io::SequenceDataHost* read_data_host = read_batch ? &read_batch->data[0] : NULL;
 
         io_timer.stop();
         stats.read_io.add( read_data_host ? read_data_host->size() : 0u, io_timer.seconds() );
@@ -239,8 +241,11 @@ void ComputeThreadSE::do_run()
         // make a local copy of the host batch
         local_read_data_host = *read_data_host;
 
+        // the aligners read plain qualities: expand the bins the input thread stored
+        io::expand_qualities( &local_read_data_host );
+
         // mark this set as ready to be reused
-        input_thread->release( read_data_host );
+        input_thread->release( read_batch );
 
         Timer timer;
         timer.start();
@@ -554,10 +559,10 @@ void ComputeThreadPE::do_run()
         Timer io_timer;
         io_timer.start();
 
-        std::pair<io::SequenceDataHost*,io::SequenceDataHost*> read_data_host_pair = input_thread->next( &read_begin );
+        InputThreadPE::batch_type* read_batch = input_thread->next( &read_begin );
 
-        io::SequenceDataHost* read_data_host1 = read_data_host_pair.first;
-        io::SequenceDataHost* read_data_host2 = read_data_host_pair.second;
+        io::SequenceDataHost* read_data_host1 = read_batch ? &read_batch->data[0] : NULL;
+        io::SequenceDataHost* read_data_host2 = read_batch ? &read_batch->data[1] : NULL;
 
         io_timer.stop();
         stats.read_io.add( read_data_host1 ? read_data_host1->size() : 0u, io_timer.seconds() );
@@ -583,8 +588,12 @@ void ComputeThreadPE::do_run()
         local_read_data_host1 = *read_data_host1;
         local_read_data_host2 = *read_data_host2;
 
+        // the aligners read plain qualities: expand the bins the input thread stored
+        io::expand_qualities( &local_read_data_host1 );
+        io::expand_qualities( &local_read_data_host2 );
+
         // mark this set as ready to be reused
-        input_thread->release( read_data_host_pair );
+        input_thread->release( read_batch );
 
         Timer timer;
         timer.start();
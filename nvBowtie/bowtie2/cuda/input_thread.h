@@ -30,10 +30,8 @@
 #include <nvBowtie/bowtie2/cuda/defs.h>
 #include <nvBowtie/bowtie2/cuda/stats.h>
 #include <nvbio/basic/threads.h>
-#include <nvbio/basic/timer.h>
 #include <nvbio/io/sequence/sequence.h>
-#include <stack>
-#include <deque>
+#include <nvbio/io/sequence/sequence_async.h>
 
 namespace nvbio {
 namespace bowtie2 {
@@ -43,100 +41,84 @@ namespace cuda {
 // A class implementing a background input thread, providing
 // a set of input read-streams which are read in parallel to the
 // operations performed by the main thread.
+// The batches are read ahead by an io::AsyncSequenceDataStream, within
+// the given host memory budget.
 //
 
-struct InputThreadSE : public Thread<InputThreadSE>
+struct InputThreadSE
 {
-    static const uint32 BUFFERS = 4;
+    typedef io::AsyncSequenceDataStream::Batch batch_type;
 
-    InputThreadSE(io::SequenceDataStream* read_data_stream, Stats& _stats, const uint32 batch_size, const uint32 read_length) :
-        m_read_data_stream( read_data_stream ), m_stats( _stats ), m_batch_size( batch_size ), m_read_length( read_length ), m_set(0), m_reads(0), m_done(false)
-    {}
-
-    void run();
+    InputThreadSE(
+        io::SequenceDataStream* read_data_stream,
+        Stats&                  _stats,
+        const uint32            batch_size,
+        const uint32            read_length,
+        const io::QualityBins&  quality_bins  = io::QualityBins(),
+        const uint64            memory_budget = io::AsyncSequenceDataStream::DEFAULT_MEMORY_BUDGET);
 
     // get a batch
     //
-    io::SequenceDataHost* next(uint32* offset = NULL);
+    batch_type* next(uint32* offset = NULL);
 
     // release a batch
     //
-    void release(io::SequenceDataHost* read_data);
+    void release(batch_type* read_data) { m_stream.release( read_data ); }
 
     // return the batch size
     //
-    uint32 batch_size() const { return m_batch_size; }
-
-private:
-    io::SequenceDataStream* m_read_data_stream;
-    Stats&                  m_stats;
-    uint32                  m_batch_size;
-    uint32                  m_read_length;
-    uint32                  m_set;
-    uint32                  m_reads;
-
-    io::SequenceDataHost                 m_read_data_storage[BUFFERS];
+    uint32 batch_size() const { return m_stream.batch_size(); }
 
-    Mutex                                m_free_pool_lock;
-    std::stack<io::SequenceDataHost*>    m_free_pool;
-
-    Mutex                                m_ready_pool_lock;
-    std::deque<io::SequenceDataHost*>    m_ready_pool;
-    std::deque<uint32>                   m_ready_poolN;
+    // return the read-ahead statistics
+    //
+    io::AsyncSequenceDataStats stream_stats() const { return m_stream.stats(); }
 
-    volatile bool m_done;
+private:
+    Stats&                      m_stats;
+    Mutex                       m_stats_lock;
+    io::AsyncSequenceDataStream m_stream;
 };
 
 //
 // A class implementing a background input thread, providing
-// a set of input read-streams which are read in parallel to the
-// operations performed by the main thread.
+// a set of mate-aligned input read-streams which are read in parallel
+// to the operations performed by the main thread.
+// The batches are read ahead by an io::AsyncSequenceDataStream, within
+// the given host memory budget.
 //
 
-struct InputThreadPE : public Thread<InputThreadPE>
+struct InputThreadPE
 {
-    static const uint32 BUFFERS = 4;
-
-    InputThreadPE(io::SequenceDataStream* read_data_stream1, io::SequenceDataStream* read_data_stream2, Stats& _stats, const uint32 batch_size, const uint32 read_length) :
-        m_read_data_stream1( read_data_stream1 ), m_read_data_stream2( read_data_stream2 ), m_stats( _stats ), m_batch_size( batch_size ), m_read_length( read_length ), m_set(0), m_reads(0), m_done(false)
-    {}
+    typedef io::AsyncSequenceDataStream::Batch batch_type;
 
-    void run();
+    InputThreadPE(
+        io::PairedSequenceDataInputStream*  read_data_stream,
+        Stats&                              _stats,
+        const uint32                        batch_size,
+        const uint32                        read_length,
+        const io::QualityBins&              quality_bins  = io::QualityBins(),
+        const uint64                        memory_budget = io::AsyncSequenceDataStream::DEFAULT_MEMORY_BUDGET);
 
-    // get a batch
+    // get a batch, holding the first mates in data[0] and the second mates in data[1]
     //
-    std::pair<io::SequenceDataHost*,io::SequenceDataHost*> next(uint32* offset = NULL);
+    batch_type* next(uint32* offset = NULL);
 
     // release a batch
     //
-    void release(std::pair<io::SequenceDataHost*,io::SequenceDataHost*> read_data);
+    void release(batch_type* read_data) { m_stream.release( read_data ); }
 
     // return the batch size
     //
-    uint32 batch_size() const { return m_batch_size; }
+    uint32 batch_size() const { return m_stream.batch_size(); }
+
+    // return the read-ahead statistics
+    //
+    io::AsyncSequenceDataStats stream_stats() const { return m_stream.stats(); }
 
 private:
-    io::SequenceDataStream* m_read_data_stream1;
-    io::SequenceDataStream* m_read_data_stream2;
-    Stats&                  m_stats;
-    uint32                  m_batch_size;
-    uint32                  m_read_length;
-    uint32                  m_set;
-    uint32                  m_reads;
-
-    io::SequenceDataHost    m_read_data_storage1[BUFFERS];
-    io::SequenceDataHost    m_read_data_storage2[BUFFERS];
-
-    Mutex                                m_free_pool_lock;
-    std::stack<io::SequenceDataHost*>    m_free_pool1;
-    std::stack<io::SequenceDataHost*>    m_free_pool2;
-
-    Mutex                                m_ready_pool_lock;
-    std::deque<io::SequenceDataHost*>    m_ready_pool1;
-    std::deque<io::SequenceDataHost*>    m_ready_pool2;
-    std::deque<uint32>                   m_ready_poolN;
-
-    volatile bool m_done;
+    Stats&                      m_stats;
+    Mutex                       m_stats_lock;
+    io::AsyncSequenceDataStream m_stream;
 };
 
 } // namespace cuda
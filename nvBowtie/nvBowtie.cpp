@@ -129,8 +129,10 @@ int main(int argc, char* argv[])
         log_info(stderr,"    -U                  file-name      unpaired reads\n");
         log_info(stderr,"    -1                  file-name      first mate reads\n");
         log_info(stderr,"    -2                  file-name      second mate reads\n");
+        log_info(stderr,"    --interleaved       file-name      interleaved paired-end reads\n");
         log_info(stderr,"    -S                  file-name      output file (.sam|.bam)\n");
         log_info(stderr,"    -x                  file-name      reference index\n");
+        log_info(stderr,"    --cram-ref          file-name      FASTA reference CRAM inputs were compressed against\n");
         log_info(stderr,"    --verbosity         int [5]        verbosity level\n");
         log_info(stderr,"    --upto       | -u   int [-1]       maximum number of reads to process\n");
         log_info(stderr,"    --trim3      | -3   int [0]        trim the first N bases of 3'\n");
@@ -143,6 +145,7 @@ int main(int argc, char* argv[])
         log_info(stderr,"    --phred33                          qualities are ASCII characters equal to Phred quality + 33\n");
         log_info(stderr,"    --phred64                          qualities are ASCII characters equal to Phred quality + 64\n");
         log_info(stderr,"    --solexa-quals                     qualities are in the Solexa format\n");
+        log_info(stderr,"    --qual-bins         string         bin qualities on input (\"illumina\" or lower:value,...)\n");
         log_info(stderr,"    --rg-id             string         add the RG-ID field of the SAM output header\n");
         log_info(stderr,"    --rg                string,val     add an RG-TAG field of the SAM output header\n");
         log_info(stderr,"  Paired-End:\n");
@@ -217,6 +220,7 @@ int main(int argc, char* argv[])
     bool   paired_end   = false;
     io::PairedEndPolicy pe_policy = io::PE_POLICY_FR;
     io::QualityEncoding qencoding = io::Phred33;
+    io::QualityBins     qbins;
     std::vector<int> cuda_devices;
 
     std::map<std::string,std::string> string_options;
@@ -232,11 +236,13 @@ int main(int argc, char* argv[])
     std::string rg_string;
 
     bool legacy_cmdline = true;
+    bool interleaved    = false;
 
     const char* read_name1      = "";
     const char* read_name2      = "";
     const char* reference_name  = "";
     const char* output_name     = "";
+    const char* cram_ref_name   = NULL;
 
     for (int32 i = 1; i < argc; ++i)
     {
@@ -293,6 +299,12 @@ int main(int argc, char* argv[])
         else if (strcmp( argv[i], "-solexa-quals" ) == 0 ||
                  strcmp( argv[i], "--solexa-quals" ) == 0)
             qencoding = io::Solexa;
+        else if (strcmp( argv[i], "-qual-bins" ) == 0 ||
+                 strcmp( argv[i], "--qual-bins" ) == 0)
+        {
+            if (io::QualityBins::parse( argv[++i], &qbins ) == false)
+                return 1;
+        }
         else if (strcmp( argv[i], "-device" ) == 0 ||
                  strcmp( argv[i], "--device" ) == 0)
             cuda_devices.push_back( atoi( argv[++i] ) );
@@ -320,6 +332,13 @@ int main(int argc, char* argv[])
             paired_end     = true;
             read_name2     = argv[++i];
         }
+        else if (strcmp( argv[i], "--interleaved") == 0)
+        {
+            legacy_cmdline = false;
+            paired_end     = true;
+            interleaved    = true;
+            read_name1     = argv[++i];
+        }
         else if (strcmp( argv[i], "-U") == 0)
         {
             legacy_cmdline = false;
@@ -336,6 +355,9 @@ int main(int argc, char* argv[])
             legacy_cmdline = false;
             reference_name = argv[++i];
         }
+        else if (strcmp( argv[i], "-cram-ref" ) == 0 ||
+                 strcmp( argv[i], "--cram-ref" ) == 0)
+            cram_ref_name = argv[++i];
         else if (argv[i][0] == '-')
         {
             // add unknown option to the string options
@@ -365,6 +387,7 @@ int main(int argc, char* argv[])
     log_debug(stderr, "  %-16s : %s\n", "quals", qencoding == io::Phred33 ? "phred33" :
                                                  qencoding == io::Phred64 ? "phred64" :
                                                                             "solexa");
+    log_debug(stderr, "  %-16s : %u\n", "qual-bins", qbins.size());
     if (paired_end)
     {
         log_debug(stderr, "  %-16s : %s\n", "pe-policy",
@@ -569,39 +592,35 @@ int main(int argc, char* argv[])
             // Open the input read files
             //
 
-            log_visible(stderr, "opening read file [1] \"%s\"\n", read_name1);
-            SharedPointer<nvbio::io::SequenceDataStream> read_data_file1(
-                nvbio::io::open_sequence_file(
-                    strcmp( read_name1, "-" ) == 0 ? "" : read_name1,
-                    qencoding,
-                    max_reads,
-                    max_read_len,
-                    io::REVERSE,
-                    trim3,
-                    trim5 )
-            );
-
-            if (read_data_file1 == NULL || read_data_file1->is_ok() == false)
+            if (interleaved)
+                log_visible(stderr, "opening interleaved read file \"%s\"\n", read_name1);
+            else
             {
-                log_error(stderr, "unable to open read file \"%s\"\n", read_name1);
-                return 1;
+                log_visible(stderr, "opening read file [1] \"%s\"\n", read_name1);
+                log_visible(stderr, "opening read file [2] \"%s\"\n", read_name2);
             }
 
-            log_visible(stderr, "opening read file [2] \"%s\"\n", read_name2);
-            SharedPointer<nvbio::io::SequenceDataStream> read_data_file2(
-                nvbio::io::open_sequence_file(
-                    strcmp( read_name2, "-" ) == 0 ? "" : read_name2,
+            SharedPointer<nvbio::io::PairedSequenceDataInputStream> read_data_file(
+                nvbio::io::open_paired_sequence_files(
+                    strcmp( read_name1, "-" ) == 0 ? "" : read_name1,
+                    interleaved ? NULL : (strcmp( read_name2, "-" ) == 0 ? "" : read_name2),
                     qencoding,
                     max_reads,
                     max_read_len,
                     io::REVERSE,
                     trim3,
-                    trim5 )
+                    trim5,
+                    0u,         // parse FASTA/FASTQ inputs with all available threads
+                    0x100u,     // skip secondary alignments
+                    cram_ref_name ? cram_ref_name : reference_name )    // decode CRAM inputs against --cram-ref, or else the reference index
             );
 
-            if (read_data_file2 == NULL || read_data_file2->is_ok() == false)
+            if (read_data_file == NULL || read_data_file->is_ok() == false)
             {
-                log_error(stderr, "unable to open read file \"%s\"\n", read_name2);
+                if (interleaved)
+                    log_error(stderr, "unable to open read file \"%s\"\n", read_name1);
+                else
+                    log_error(stderr, "unable to open read files \"%s\" and \"%s\"\n", read_name1, read_name2);
                 return 1;
             }
 
@@ -669,8 +688,7 @@ int main(int argc, char* argv[])
 
             bowtie2::cuda::Stats input_stats( params );
 
-            bowtie2::cuda::InputThreadPE input_thread( read_data_file1.get(),  read_data_file2.get(), input_stats, batch_size, params.avg_read_length );
-            input_thread.create();
+            bowtie2::cuda::InputThreadPE input_thread( read_data_file.get(), input_stats, batch_size, params.avg_read_length, qbins );
 
             for (uint32 i = 0; i < cuda_devices.size(); ++i)
             {
@@ -696,8 +714,6 @@ int main(int argc, char* argv[])
                 mate2.merge( device_stats[i].mate2 );
             }
 
-            input_thread.join();
-
             timer.stop();
 
             log_verbose( stderr, "  compute threads joined\n" );
@@ -715,6 +731,10 @@ int main(int argc, char* argv[])
 
             log_stats(stderr, "  total         : %.2f sec (avg: %.3fK reads/s).\n", timer.seconds(), 1.0e-3f * float(n_reads) / timer.seconds());
             log_stats(stderr, "  reads   I/O   : %.2f sec (avg: %.3fM reads/s, max: %.3fM reads/s).\n", input_stats.read_io.time, 1.0e-6f * input_stats.read_io.avg_speed(), 1.0e-6f * input_stats.read_io.max_speed);
+            {
+                const io::AsyncSequenceDataStats read_ahead = input_thread.stream_stats();
+                log_stats(stderr, "  reads   wait  : %.2f sec (%u stalls, %u buffers, %.1f MB peak).\n", read_ahead.consumer_stall_time, read_ahead.consumer_stalls, read_ahead.buffers, float(read_ahead.peak_bytes) / float(1024*1024));
+            }
             log_stats(stderr, "  results I/O   : %.2f sec (avg: %.3fM reads/s, max: %.3fM reads/s).\n", io.time, 1.0e-6f * io.avg_speed(), 1.0e-6f * io.max_speed);
 
             uint32&              n_mapped       = concordant.n_mapped;
@@ -773,7 +793,10 @@ int main(int argc, char* argv[])
                     max_read_len,
                     io::REVERSE,
                     trim3,
-                    trim5 )
+                    trim5,
+                    0u,         // parse FASTA/FASTQ inputs with all available threads
+                    0x100u,     // skip secondary alignments
+                    cram_ref_name ? cram_ref_name : reference_name )    // decode CRAM inputs against --cram-ref, or else the reference index
             );
 
             if (read_data_file == NULL || read_data_file->is_ok() == false)
@@ -840,8 +863,7 @@ int main(int argc, char* argv[])
 
             bowtie2::cuda::Stats input_stats( params );
 
-            bowtie2::cuda::InputThreadSE input_thread( read_data_file.get(), input_stats, batch_size, params.avg_read_length );
-            input_thread.create();
+            bowtie2::cuda::InputThreadSE input_thread( read_data_file.get(), input_stats, batch_size, params.avg_read_length, qbins );
 
             for (uint32 i = 0; i < cuda_devices.size(); ++i)
             {
@@ -861,8 +883,6 @@ int main(int argc, char* argv[])
                 mate1.merge( device_stats[i].mate1 );
             }
 
-            input_thread.join();
-
             timer.stop();
 
             log_verbose( stderr, "  compute threads joined\n" );
@@ -880,6 +900,10 @@ int main(int argc, char* argv[])
 
             log_stats(stderr, "  total         : %.2f sec (avg: %.3fK reads/s).\n", timer.seconds(), 1.0e-3f * float(n_reads) / timer.seconds());
             log_stats(stderr, "  reads   I/O   : %.2f sec (avg: %.3fM reads/s, max: %.3fM reads/s).\n", input_stats.read_io.time, 1.0e-6f * input_stats.read_io.avg_speed(), 1.0e-6f * input_stats.read_io.max_speed);
+            {
+                const io::AsyncSequenceDataStats read_ahead = input_thread.stream_stats();
+                log_stats(stderr, "  reads   wait  : %.2f sec (%u stalls, %u buffers, %.1f MB peak).\n", read_ahead.consumer_stall_time, read_ahead.consumer_stalls, read_ahead.buffers, float(read_ahead.peak_bytes) / float(1024*1024));
+            }
             log_stats(stderr, "  results I/O   : %.2f sec (avg: %.3fM reads/s, max: %.3fM reads/s).\n", io.time, 1.0e-6f * io.avg_speed(), 1.0e-6f * io.max_speed);
 
             uint32&              n_mapped       = mate1.n_mapped;
@@ -204,11 +204,60 @@ bool to_packed(const char* reads_name, void* output_file, void* output_index, co
     return true;
 }
 
+bool to_cache(const char* reads_name, const char* out_name, const io::QualityEncoding qencoding, const char* options)
+{
+    // only the forward strands are stored, as the other ones can be selected when reading the cache back
+    log_visible(stderr, "opening read file \"%s\"\n", reads_name);
+    SharedPointer<nvbio::io::SequenceDataStream> read_data_file(
+        nvbio::io::open_sequence_file(reads_name,
+        qencoding,
+        uint32(-1),
+        uint32(-1),
+        io::FORWARD )
+    );
+
+    if (read_data_file == NULL || read_data_file->is_ok() == false)
+    {
+        log_error(stderr, "    failed opening file \"%s\"\n", reads_name);
+        return false;
+    }
+
+    SharedPointer<nvbio::io::SequenceDataOutputStream> output_file(
+        nvbio::io::open_output_sequence_file( out_name, options ) );
+
+    if (output_file == NULL || output_file->is_ok() == false)
+    {
+        log_error(stderr, "    failed opening file \"%s\"\n", out_name);
+        return false;
+    }
+
+    const uint32 batch_size = 512*1024;
+
+    uint32 n_reads = 0;
+    uint64 n_bps   = 0;
+
+    io::SequenceDataHost h_read_data;
+
+    // loop through all read batches, keeping the reads in ASCII so as to retain any IUPAC symbol
+    while (io::next( ASCII, &h_read_data, read_data_file.get(), batch_size ) > 0)
+    {
+        output_file->next( h_read_data );
+
+        n_reads += h_read_data.size();
+        n_bps   += h_read_data.bps();
+
+        log_verbose(stderr,"\r    %u reads (%.2fG bps)    ", n_reads, float( n_bps ) / float(1024*1024*1024));
+    }
+    log_verbose_cont(stderr,"\n");
+    return true;
+}
+
 enum Format
 {
     ASCII_FORMAT   = 0u,
     PACKED2_FORMAT = 1u,
     PACKED4_FORMAT = 2u,
+    CACHE_FORMAT   = 3u,
 };
 
 int main(int argc, char* argv[])
@@ -216,7 +265,8 @@ int main(int argc, char* argv[])
     if (argc < 2)
     {
         log_info(stderr, "nvExtractReads [options] input output\n");
-        log_info(stderr, "  extract a set of reads to a plain ASCII_FORMAT or packed file with one read per line (.txt)\n\n");
+        log_info(stderr, "  extract a set of reads to a plain ASCII_FORMAT or packed file with one read per line (.txt),\n");
+        log_info(stderr, "  or to a binary read cache (.nvr)\n\n");
         log_info(stderr, "options:\n");
         log_info(stderr, "  --verbosity\n");
         log_info(stderr, "  -F | --skip-forward          skip forward strand\n");
@@ -224,6 +274,8 @@ int main(int argc, char* argv[])
         log_info(stderr, "  -a | --ascii                 ASCII_FORMAT output\n");
         log_info(stderr, "  -p2 | --packed-2             2-bits packed output\n");
         log_info(stderr, "  -p4 | --packed-4             4-bits packed output\n");
+        log_info(stderr, "  -c  | --cache                binary read cache output (.nvr), which can be used as input\n");
+        log_info(stderr, "  -b  | --bin-quals            bin the qualities of the read cache in 8 levels\n");
         log_info(stderr, "  -i  | --idx string           save an index file\n");
         exit(0);
     }
@@ -234,6 +286,7 @@ int main(int argc, char* argv[])
     bool  forward           = true;
     bool  reverse           = true;
     Format format           = ASCII_FORMAT;
+    bool  bin_quals         = false;
     io::QualityEncoding qencoding = io::Phred33;
 
     for (int i = 0; i < argc - 2; ++i)
@@ -268,6 +321,16 @@ int main(int argc, char* argv[])
         {
             format = PACKED4_FORMAT;
         }
+        else if (strcmp( argv[i], "-c" ) == 0 ||
+                 strcmp( argv[i], "--cache" ) == 0)     // read cache
+        {
+            format = CACHE_FORMAT;
+        }
+        else if (strcmp( argv[i], "-b" ) == 0 ||
+                 strcmp( argv[i], "--bin-quals" ) == 0) // quality binning
+        {
+            bin_quals = true;
+        }
         else if (strcmp( argv[i], "-i" ) == 0 ||
                  strcmp( argv[i], "--idx" ) == 0)       // index file
         {
@@ -275,6 +338,28 @@ int main(int argc, char* argv[])
         }
     }
 
+    // read caches are recognized by their suffix, both when writing and reading them
+    const uint32 out_len = uint32( strlen(out_name) );
+    const bool   is_nvr  = out_len >= strlen(".nvr") && strcmp(&out_name[out_len - strlen(".nvr")], ".nvr") == 0;
+
+    if (is_nvr)
+        format = CACHE_FORMAT;
+    else if (format == CACHE_FORMAT)
+    {
+        log_error(stderr, "    read cache \"%s\" must have a .nvr suffix\n", out_name);
+        return 1;
+    }
+
+    if (format == CACHE_FORMAT)
+    {
+        log_visible(stderr,"nvExtractReads... started\n");
+
+        const bool success = to_cache( reads_name, out_name, qencoding, bin_quals ? "b" : "" );
+
+        log_visible(stderr,"nvExtractReads... done\n");
+        return success ? 0u : 1u;
+    }
+
     std::string out_string = out_name;
     // parse out file extension; look for .fastq.gz, .fastq suffixes
     uint32 len = uint32( strlen(out_name) );
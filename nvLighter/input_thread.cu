@@ -43,20 +43,13 @@ using namespace nvbio;
 //
 bool InputStage::process(nvbio::PipelineContext& context)
 {
-    m_data->m_mutex.lock();
-
-    nvbio::Timer timer;
-    timer.start();
-
     // fetch the output
     nvbio::io::SequenceDataHost* h_read_data = context.output<nvbio::io::SequenceDataHost>();
 
-    const int ret = nvbio::io::next( DNA_N, h_read_data, m_data->m_file, m_data->m_max_strings, m_data->m_max_bps );
-
-    timer.stop();
-    m_data->m_time  += timer.seconds();
-    m_data->m_reads += h_read_data->size();
-    m_data->m_bps   += h_read_data->bps();
+    // swap in the next batch read ahead by the background thread
+    uint64 offset;
+    if (m_data->m_stream.next( h_read_data, &offset ) == 0)
+        return false;
 
     if (h_read_data->max_sequence_len() > MAX_READ_LENGTH)
     {
@@ -64,16 +57,19 @@ bool InputStage::process(nvbio::PipelineContext& context)
         return false;
     }
 
+    const nvbio::io::AsyncSequenceDataStats stats = m_data->m_stream.stats();
+
+    nvbio::ScopedLock lock( &m_data->m_mutex );
+
     log_verbose(stderr, "\r  loaded reads [%llu, %llu] (%.1fM / %.2fG bps, %.1fK reads/s, %.1fM bps/s)                ",
-        m_data->m_reads,
-        m_data->m_reads + h_read_data->size(),
+        offset,
+        offset + h_read_data->size(),
         1.0e-6f * (h_read_data->bps()),
         1.0e-9f * (m_data->m_bps + h_read_data->bps()),
-        m_data->m_time ? (1.0e-3f * (m_data->m_reads + h_read_data->size())) / m_data->m_time : 0.0f,
-        m_data->m_time ? (1.0e-6f * (m_data->m_bps   + h_read_data->bps() )) / m_data->m_time : 0.0f );
+        stats.read_time ? (1.0e-3f * stats.reads) / stats.read_time : 0.0f,
+        stats.read_time ? (1.0e-6f * stats.bps)   / stats.read_time : 0.0f );
     log_debug_cont(stderr, "\n");
 
-    m_data->m_mutex.unlock();
-
-    return ret;
+    m_data->m_bps += h_read_data->bps();
+    return true;
 }
@@ -36,6 +36,7 @@
 #include <nvbio/basic/timer.h>
 #include <nvbio/basic/threads.h>
 #include <nvbio/io/sequence/sequence.h>
+#include <nvbio/io/sequence/sequence_async.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -43,32 +44,24 @@
 ///@{
 
 /// A small class encapsulating the core data needed by all input threads,
-/// i.e. the actual input file, a lock, and the relative statistics
+/// i.e. the read-ahead input stream, a lock, and the relative statistics
 ///
 struct InputStageData
 {
     /// constructor
     ///
-    ///\param file          input sequence file
+    ///\param file          input sequence file, which must not be rewound while this object is alive
     ///\param max_strings   maximum number of strings per batch
     ///\param max_bps       maximum number of base pairs per batch
     ///
     InputStageData(nvbio::io::SequenceDataStream* file, const uint32 max_strings, const uint32 max_bps) :
-        m_file          ( file ),
-        m_max_strings   ( max_strings ),
-        m_max_bps       ( max_bps ),
-        m_reads         ( 0 ),
-        m_bps           ( 0 ),
-        m_time          ( 0.0f )
+        m_stream        ( file, nvbio::DNA_N, max_strings, max_bps ),
+        m_bps           ( 0 )
     {}
 
-    nvbio::Mutex                    m_mutex;
-    nvbio::io::SequenceDataStream*  m_file;
-    uint32                          m_max_strings;
-    uint32                          m_max_bps;
-    uint64                          m_reads;
-    uint64                          m_bps;
-    float                           m_time;
+    nvbio::Mutex                        m_mutex;
+    nvbio::io::AsyncSequenceDataStream  m_stream;
+    uint64                              m_bps;
 };
 
 ///
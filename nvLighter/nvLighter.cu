@@ -460,7 +460,7 @@ int main(int argc, char* argv[])
             nvbio::Pipeline pipeline;
             for (uint32 i = 0; i < device_count + (cpu ? 1 : 0); ++i)
             {
-                const uint32 in0 = pipeline.append_stage( &input_stage[i], 4u );
+                const uint32 in0 = pipeline.append_stage( &input_stage[i], 2u );
                 const uint32 out = pipeline.append_sink( &sample_stage[i] );
                 pipeline.add_dependency( in0, out );
             }
@@ -607,7 +607,7 @@ int main(int argc, char* argv[])
             nvbio::Pipeline pipeline;
             for (uint32 i = 0; i < device_count + (cpu ? 1 : 0); ++i)
             {
-                const uint32 in0 = pipeline.append_stage( &input_stage[i], 4u );
+                const uint32 in0 = pipeline.append_stage( &input_stage[i], 2u );
                 const uint32 out = pipeline.append_sink( &marking_stage[i] );
                 pipeline.add_dependency( in0, out );
             }
@@ -738,7 +738,7 @@ int main(int argc, char* argv[])
             nvbio::Pipeline pipeline;
             for (uint32 i = 0; i < device_count + (cpu ? 1 : 0); ++i)
             {
-                const uint32 in  = pipeline.append_stage( &input_stage[i], 4u );
+                const uint32 in  = pipeline.append_stage( &input_stage[i], 2u );
                 const uint32 ec  = pipeline.append_stage( &ec_stage[i] );
                 const uint32 out = pipeline.append_sink( &output_stage[i] );
                 pipeline.add_dependency( in, ec );
@@ -35,13 +35,15 @@
 #include <nvbio/basic/timer.h>
 #include <nvbio/basic/threads.h>
 #include <nvbio/io/sequence/sequence.h>
+#include <nvbio/io/sequence/sequence_async.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 using namespace nvbio;
 
 ///
-/// A small class implementing a Pipeline stage reading sequence batches from a file
+/// A small class implementing a Pipeline stage reading sequence batches from a file;
+/// the batches are read ahead by a background thread
 ///
 struct InputStage
 {
@@ -55,9 +57,10 @@ struct InputStage
     ///\param max_bps       maximum number of base pairs per batch
     ///
     InputStage(io::SequenceDataStream* file, const uint32 max_strings, const uint32 max_bps) :
-        m_file          ( file ),
+        m_stream        ( file, DNA, max_strings, max_bps ),
         m_max_strings   ( max_strings ),
-        m_max_bps       ( max_bps )
+        m_max_bps       ( max_bps ),
+        m_time          ( 0.0f )
     {}
 
     /// fill the next batch
@@ -71,15 +74,15 @@ struct InputStage
         io::SequenceDataHost* output = context.output<io::SequenceDataHost>();
 
         log_debug(stderr, "    loading.. started (%u, %u)\n", m_max_strings, m_max_bps);
-        const int ret = io::next( DNA, output, m_file, m_max_strings, m_max_bps );
+        const uint32 ret = m_stream.next( output );
         log_debug(stderr, "    loading.. done\n");
 
         timer.stop();
         m_time += timer.seconds();
-        return ret;
+        return ret > 0;
     }
 
-    io::SequenceDataStream*         m_file;
+    io::AsyncSequenceDataStream     m_stream;
     uint32                          m_max_strings;
     uint32                          m_max_bps;
     float                           m_time;
@@ -190,6 +190,8 @@ int main(int argc, char* argv[])
         log_info(stderr, "   -v       | --verbosity     int (0-6) [5]\n");
         log_info(stderr, "   -c       | --compression   string    [1R]   (e.g. \"1\", ..., \"9\", \"1R\")\n");
         log_info(stderr, "   -t       | --threads       int       [auto]\n");
+        log_info(stderr, "   -ct      | --compression-threads int [auto] (# of output compression threads)\n");
+        log_info(stderr, "   -cm      | --compression-memory  int [256]  (output compression buffers, in MB)\n");
         log_info(stderr, "   -b       | --bucketing     int       [16]   (# of bits used for bucketing)\n");
         log_info(stderr, "   -F       | --skip-forward\n");
         log_info(stderr, "   -R       | --skip-reverse\n");
@@ -203,6 +205,10 @@ int main(int argc, char* argv[])
         log_info(stderr, "    .bwt4     4-bit packed binary\n");
         log_info(stderr, "    .bwt4.gz  4-bit packed binary, gzip compressed\n");
         log_info(stderr, "    .bwt4.bgz 4-bit packed binary, block-gzip compressed\n");
+        log_info(stderr, "    .bwt.lz4  2-bit packed binary, LZ4 compressed\n");
+        log_info(stderr, "    .bwt4.lz4 4-bit packed binary, LZ4 compressed\n");
+        log_info(stderr, "    .rlbwt    run-length encoded binary\n");
+        log_info(stderr, "    .rlbwt.gz run-length encoded binary, gzip compressed\n");
         return 0;
     }
 
@@ -213,6 +219,8 @@ int main(int argc, char* argv[])
     const char* comp_level        = "1R";
     io::QualityEncoding qencoding = io::Phred33;
     int   threads                 = 0;
+    int   comp_threads            = 0;
+    int   comp_memory             = 256;
 
     for (int i = 0; i < argc - 2; ++i)
     {
@@ -242,6 +250,16 @@ int main(int argc, char* argv[])
         {
             threads = atoi( argv[++i] );
         }
+        else if ((strcmp( argv[i], "-ct" )                    == 0) ||
+                 (strcmp( argv[i], "--compression-threads" )  == 0))  // setup number of compression threads
+        {
+            comp_threads = atoi( argv[++i] );
+        }
+        else if ((strcmp( argv[i], "-cm" )                    == 0) ||
+                 (strcmp( argv[i], "--compression-memory" )   == 0))  // setup compression memory budget
+        {
+            comp_memory = atoi( argv[++i] );
+        }
     }
 
     try
@@ -249,7 +267,7 @@ int main(int argc, char* argv[])
         log_visible(stderr,"nvSetBWT... started\n");
 
         // build an output file
-        SharedPointer<SetBWTHandler> output_handler = SharedPointer<SetBWTHandler>( open_bwt_file( output_name, comp_level ) );
+        SharedPointer<SetBWTHandler> output_handler = SharedPointer<SetBWTHandler>( open_bwt_file( output_name, comp_level, uint32( comp_threads ), uint64( comp_memory )*1024u*1024u ) );
         if (output_handler == NULL)
         {
             log_error(stderr, "  failed to create an output handler\n");
@@ -331,7 +349,7 @@ int main(int argc, char* argv[])
 
         // build the pipeline
         Pipeline pipeline;
-        const uint32 in0 = pipeline.append_stage( &input_stage, 4u );
+        const uint32 in0 = pipeline.append_stage( &input_stage, 2u );
         const uint32 in1 = pipeline.append_stage( &sort_stage, 4u );
         const uint32 out = pipeline.append_sink( &sink_stage );
         pipeline.add_dependency( in0, out );
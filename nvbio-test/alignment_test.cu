@@ -37,8 +37,11 @@
 #include <nvbio/basic/packedstream_loader.h>
 #include <nvbio/basic/vector_view.h>
 #include <nvbio/basic/vector.h>
+#include <nvbio/basic/packed_vector.h>
 #include <nvbio/basic/shared_pointer.h>
 #include <nvbio/basic/dna.h>
+#include <nvbio/strings/string_set.h>
+#include <nvbio/strings/infix.h>
 #include <nvbio/alignment/alignment.h>
 #include <nvbio/alignment/batched.h>
 #include <nvbio/alignment/sink.h>
@@ -46,6 +49,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <vector>
+#include <string>
 #include <algorithm>
 
 using namespace nvbio;
@@ -172,6 +176,212 @@ struct AlignmentStream
     int16*                      m_scores;
 };
 
+//
+// A host alignment stream class with variable length strings, to be used in conjunction
+// with the host BatchAlignmentScore schedulers
+//
+template <typename t_aligner_type>
+struct HostAlignmentStream
+{
+    typedef t_aligner_type                                                          aligner_type;
+
+    typedef nvbio::vector_view<const uint8*>                                        pattern_string;
+    typedef nvbio::vector_view<const uint8*>                                        text_string;
+
+    // an alignment context
+    struct context_type
+    {
+        int32                   min_score;
+        aln::BestSink<int32>    sink;
+    };
+    // a container for the strings to be aligned
+    struct strings_type
+    {
+        pattern_string          pattern;
+        trivial_quality_string  quals;
+        text_string             text;
+    };
+
+    // constructor
+    HostAlignmentStream(
+        aligner_type        _aligner,
+        const uint32        _count,
+        const uint32        _max_pattern_len,
+        const uint32        _max_text_len,
+        const uint32*       _pattern_lengths,
+        const uint32*       _text_lengths,
+        const uint8*        _patterns,
+        const uint8*        _text,
+               int32*       _scores) :
+        m_aligner( _aligner ), m_count(_count), m_max_pattern_len(_max_pattern_len), m_max_text_len(_max_text_len),
+        m_pattern_lengths(_pattern_lengths), m_text_lengths(_text_lengths), m_patterns(_patterns), m_text(_text), m_scores(_scores) {}
+
+    // get the aligner
+    const aligner_type& aligner() const { return m_aligner; };
+
+    // return the maximum pattern length
+    uint32 max_pattern_length() const { return m_max_pattern_len; }
+
+    // return the maximum text length
+    uint32 max_text_length() const { return m_max_text_len; }
+
+    // return the stream size
+    uint32 size() const { return m_count; }
+
+    // return the i-th pattern's length
+    uint32 pattern_length(const uint32 i, context_type* context) const { return m_pattern_lengths[i]; }
+
+    // return the i-th text's length
+    uint32 text_length(const uint32 i, context_type* context) const { return m_text_lengths[i]; }
+
+    // initialize the i-th context
+    bool init_context(
+        const uint32    i,
+        context_type*   context) const
+    {
+        context->min_score = Field_traits<int32>::min();
+        return true;
+    }
+
+    // initialize the i-th context
+    void load_strings(
+        const uint32        i,
+        const uint32        window_begin,
+        const uint32        window_end,
+        const context_type* context,
+              strings_type* strings) const
+    {
+        strings->pattern = pattern_string( m_pattern_lengths[i], m_patterns + i * m_max_pattern_len );
+        strings->text    = text_string( m_text_lengths[i], m_text + i * m_max_text_len );
+    }
+
+    // handle the output
+    void output(
+        const uint32        i,
+        const context_type* context) const
+    {
+        // copy the output score
+        m_scores[i] = context->sink.score;
+    }
+
+    aligner_type    m_aligner;
+    uint32          m_count;
+    uint32          m_max_pattern_len;
+    uint32          m_max_text_len;
+    const uint32*   m_pattern_lengths;
+    const uint32*   m_text_lengths;
+    const uint8*    m_patterns;
+    const uint8*    m_text;
+    int32*          m_scores;
+};
+
+//
+// A host traceback stream class with variable length strings, to be used in conjunction
+// with the host BatchAlignmentTraceback scheduler
+//
+template <typename t_aligner_type>
+struct HostTracebackStream
+{
+    typedef t_aligner_type                                                          aligner_type;
+
+    typedef nvbio::vector_view<const uint8*>                                        pattern_string;
+    typedef nvbio::vector_view<const uint8*>                                        text_string;
+
+    // a backtracer accumulating the (reversed) alignment operations in a string
+    struct backtracer_type
+    {
+        void clip(const uint32 len) { ops.append( len, 'S' ); }
+        void push(const uint8 op)   { ops.push_back( "MID"[op] ); }
+
+        std::string ops;
+    };
+
+    // an alignment context
+    struct context_type
+    {
+        int32                   min_score;
+        backtracer_type         backtracer;
+        Alignment<int32>        alignment;
+    };
+    // a container for the strings to be aligned
+    struct strings_type
+    {
+        pattern_string          pattern;
+        trivial_quality_string  quals;
+        text_string             text;
+    };
+
+    // constructor
+    HostTracebackStream(
+        aligner_type        _aligner,
+        const uint32        _count,
+        const uint32        _max_pattern_len,
+        const uint32        _max_text_len,
+        const uint32*       _pattern_lengths,
+        const uint32*       _text_lengths,
+        const uint8*        _patterns,
+        const uint8*        _text,
+        Alignment<int32>*   _alignments,
+        std::string*        _cigars) :
+        m_aligner( _aligner ), m_count(_count), m_max_pattern_len(_max_pattern_len), m_max_text_len(_max_text_len),
+        m_pattern_lengths(_pattern_lengths), m_text_lengths(_text_lengths), m_patterns(_patterns), m_text(_text),
+        m_alignments(_alignments), m_cigars(_cigars) {}
+
+    // get the aligner
+    const aligner_type& aligner() const { return m_aligner; };
+
+    // return the stream size
+    uint32 size() const { return m_count; }
+
+    // return the i-th pattern's length
+    uint32 pattern_length(const uint32 i, context_type* context) const { return m_pattern_lengths[i]; }
+
+    // return the i-th text's length
+    uint32 text_length(const uint32 i, context_type* context) const { return m_text_lengths[i]; }
+
+    // initialize the i-th context
+    bool init_context(
+        const uint32    i,
+        context_type*   context) const
+    {
+        context->min_score = Field_traits<int32>::min();
+        context->backtracer.ops.clear();
+        return true;
+    }
+
+    // initialize the i-th context
+    void load_strings(
+        const uint32        i,
+        const uint32        window_begin,
+        const uint32        window_end,
+        const context_type* context,
+              strings_type* strings) const
+    {
+        strings->pattern = pattern_string( m_pattern_lengths[i], m_patterns + i * m_max_pattern_len );
+        strings->text    = text_string( m_text_lengths[i], m_text + i * m_max_text_len );
+    }
+
+    // handle the output
+    void output(
+        const uint32        i,
+        const context_type* context) const
+    {
+        m_alignments[i] = context->alignment;
+        m_cigars[i]     = context->backtracer.ops;
+    }
+
+    aligner_type        m_aligner;
+    uint32              m_count;
+    uint32              m_max_pattern_len;
+    uint32              m_max_text_len;
+    const uint32*       m_pattern_lengths;
+    const uint32*       m_text_lengths;
+    const uint8*        m_patterns;
+    const uint8*        m_text;
+    Alignment<int32>*   m_alignments;
+    std::string*        m_cigars;
+};
+
 // A simple kernel to test the speed of alignment without the possible overheads of the BatchAlignmentScore interface
 //
 template <uint32 BLOCKDIM, uint32 MAX_REF_LEN, typename aligner_type, typename score_type>
@@ -379,152 +589,1626 @@ float enact_batch(
     Timer timer;
     timer.start();
 
-    for (uint32 i = 0; i < n_tests; ++i)
-    {
-        // enact the batch
-        batch.enact( stream, temp_size, nvbio::raw_pointer( temp_dvec ) );
+    for (uint32 i = 0; i < n_tests; ++i)
+    {
+        // enact the batch
+        batch.enact( stream, temp_size, nvbio::raw_pointer( temp_dvec ) );
+
+        cudaDeviceSynchronize();
+    }
+
+    timer.stop();
+
+    return timer.seconds() / float(n_tests);
+}
+
+// execute and time a batch of full DP alignments using BatchAlignmentScore
+//
+template <bool supported, typename scheduler_type, uint32 N, uint32 M, typename stream_type>
+struct batch_score_profile_dispatch
+{
+    static void run(
+        const stream_type               stream,
+        const uint32                    n_tests,
+        const uint32                    n_tasks)
+    {}
+};
+
+// execute and time a batch of full DP alignments using BatchAlignmentScore
+//
+template <typename scheduler_type, uint32 N, uint32 M, typename stream_type>
+struct batch_score_profile_dispatch<true,scheduler_type,N,M,stream_type>
+{
+    static void run(
+        const stream_type               stream,
+        const uint32                    n_tests,
+        const uint32                    n_tasks)
+    {
+        typedef aln::BatchedAlignmentScore<stream_type, scheduler_type> batch_type;  // our batch type
+
+        // setup a batch
+        batch_type batch;
+
+        const float time = enact_batch(
+            batch,
+            stream,
+            n_tests,
+            n_tasks );
+
+        fprintf(stderr,"  %5.1f", 1.0e-9f * float(n_tasks*uint64(N*M))/time );
+    }
+};
+
+// execute and time a batch of full DP alignments using BatchAlignmentScore
+//
+template <typename scheduler_type, uint32 N, uint32 M, typename stream_type>
+void batch_score_profile(
+    const stream_type               stream,
+    const uint32                    n_tests,
+    const uint32                    n_tasks)
+{
+    NVBIO_VAR_UNUSED const bool is_supported = aln::supports_scheduler<typename stream_type::aligner_type,scheduler_type>::pred;
+
+    batch_score_profile_dispatch<is_supported,scheduler_type,N,M,stream_type>::run(
+        stream,
+        n_tests,
+        n_tasks );
+}
+
+// execute and time the batch_score<scheduler> algorithm for all possible schedulers
+//
+template <uint32 N, uint32 M, typename aligner_type>
+void batch_score_profile_all(
+    const aligner_type              aligner,
+    const uint32                    n_tests,
+    const uint32                    n_tasks,
+    thrust::device_vector<uint32>&  pattern_dvec,
+    thrust::device_vector<uint32>&  text_dvec,
+    thrust::device_vector<int16>&   score_dvec)
+{
+    {
+        typedef AlignmentStream<aligner_type,M,N> stream_type;
+
+        // create a stream
+        stream_type stream(
+            aligner,
+            n_tasks,
+            nvbio::raw_pointer( pattern_dvec ),
+            nvbio::raw_pointer( text_dvec ),
+            nvbio::raw_pointer( score_dvec ) );
+
+        // test the DeviceThreadScheduler
+        batch_score_profile<DeviceThreadScheduler,N,M>(
+            stream,
+            n_tests,
+            n_tasks );
+
+        // test the DeviceStagedThreadScheduler
+        batch_score_profile<DeviceStagedThreadScheduler,N,M>(
+            stream,
+            n_tests,
+            n_tasks );
+    }
+    {
+        typedef AlignmentStream<aligner_type,M,N,uncached_tag_type> stream_type;
+
+        // create a stream
+        stream_type stream(
+            aligner,
+            n_tasks,
+            nvbio::raw_pointer( pattern_dvec ),
+            nvbio::raw_pointer( text_dvec ),
+            nvbio::raw_pointer( score_dvec ) );
+
+        // test the DeviceWarpScheduler
+        batch_score_profile<DeviceWarpScheduler,N,M>(
+            stream,
+            n_tests,
+            n_tasks );
+    }
+    {
+        const uint32 BLOCKDIM = 128;
+        const uint32 N_BLOCKS = (n_tasks + BLOCKDIM-1) / BLOCKDIM;
+
+        Timer timer;
+        timer.start();
+
+        for (uint32 i = 0; i < n_tests; ++i)
+        {
+            // enact the batch
+            alignment_test_kernel<BLOCKDIM,N> <<<N_BLOCKS,BLOCKDIM>>>(
+                aligner,
+                n_tasks,
+                M,
+                N,
+                nvbio::raw_pointer( pattern_dvec ),
+                nvbio::raw_pointer( text_dvec ),
+                nvbio::raw_pointer( score_dvec ) );
+
+            cudaDeviceSynchronize();
+        }
+
+        timer.stop();
+
+        const float time = timer.seconds();
+
+        fprintf(stderr,"  %5.1f", 1.0e-9f * float(n_tasks*uint64(N*M))*(float(n_tests)/time) );
+    }
+    fprintf(stderr, " GCUPS\n");
+}
+
+// a batch of variable length host alignment problems, storing the i-th pattern and text
+// at offsets i*M and i*N respectively
+//
+struct HostAlignmentBatch
+{
+    typedef nvbio::vector_view<const uint8*> string_type;
+
+    // constructor
+    HostAlignmentBatch(
+        const uint32                _n_tasks,
+        const uint32                _M,
+        const uint32                _N,
+        const std::vector<uint32>&  _pattern_lengths,
+        const std::vector<uint32>&  _text_lengths,
+        const std::vector<uint8>&   _patterns,
+        const std::vector<uint8>&   _text) :
+        n_tasks(_n_tasks), M(_M), N(_N),
+        pattern_lengths( &_pattern_lengths[0] ), text_lengths( &_text_lengths[0] ),
+        patterns( &_patterns[0] ), text( &_text[0] ) {}
+
+    // return the i-th pattern
+    string_type pattern(const uint32 i) const { return string_type( pattern_lengths[i], patterns + i*M ); }
+
+    // return the i-th text
+    string_type text_string(const uint32 i) const { return string_type( text_lengths[i], text + i*N ); }
+
+    // return the number of cells of all the full DP matrices
+    uint64 n_cells() const
+    {
+        uint64 n = 0u;
+        for (uint32 i = 0; i < n_tasks; ++i)
+            n += uint64( pattern_lengths[i] ) * uint64( text_lengths[i] );
+        return n;
+    }
+
+    // return a score stream over this batch
+    template <typename aligner_type>
+    HostAlignmentStream<aligner_type> score_stream(const aligner_type aligner, int32* scores) const
+    {
+        return HostAlignmentStream<aligner_type>( aligner, n_tasks, M, N, pattern_lengths, text_lengths, patterns, text, scores );
+    }
+
+    // return a traceback stream over this batch
+    template <typename aligner_type>
+    HostTracebackStream<aligner_type> traceback_stream(const aligner_type aligner, Alignment<int32>* alignments, std::string* cigars) const
+    {
+        return HostTracebackStream<aligner_type>( aligner, n_tasks, M, N, pattern_lengths, text_lengths, patterns, text, alignments, cigars );
+    }
+
+    uint32          n_tasks;
+    uint32          M;
+    uint32          N;
+    const uint32*   pattern_lengths;
+    const uint32*   text_lengths;
+    const uint8*    patterns;
+    const uint8*    text;
+};
+
+// score a batch with a given aligner and host scheduler
+//
+template <typename scheduler_type, typename aligner_type>
+void host_batch_score(const aligner_type aligner, const HostAlignmentBatch& batch, int32* scores)
+{
+    typedef HostAlignmentStream<aligner_type> stream_type;
+
+    BatchedAlignmentScore<stream_type,scheduler_type> batch_score;
+    batch_score.enact( batch.score_stream( aligner, scores ) );
+}
+
+// check a score against the reference one, logging any mismatch
+//
+bool check_score(const uint32 i, const int32 ref_score, const int32 score)
+{
+    if (ref_score != score)
+    {
+        log_error(stderr, "\n    mismatching score for problem %u: expected %d, got %d\n", i, ref_score, score);
+        return false;
+    }
+    return true;
+}
+
+// check the HostSimdScheduler against the HostThreadScheduler on a batch of variable length problems
+//
+template <typename aligner_type>
+void host_simd_test(
+    const char*                     name,
+    const aligner_type              aligner,
+    const HostAlignmentBatch&       batch)
+{
+    std::vector<int32> ref_scores( batch.n_tasks );
+    std::vector<int32> simd_scores( batch.n_tasks );
+
+    fprintf(stderr,"    %15s : ", name);
+
+    float times[2];
+    for (uint32 s = 0; s < 2; ++s)
+    {
+        Timer timer;
+        timer.start();
+
+        if (s == 0)
+            host_batch_score<HostThreadScheduler>( aligner, batch, &ref_scores[0] );
+        else
+            host_batch_score<HostSimdScheduler>( aligner, batch, &simd_scores[0] );
+
+        timer.stop();
+        times[s] = timer.seconds();
+    }
+
+    for (uint32 i = 0; i < batch.n_tasks; ++i)
+    {
+        if (check_score( i, ref_scores[i], simd_scores[i] ) == false)
+            exit(1);
+    }
+
+    const uint64 n_cells = batch.n_cells();
+    fprintf(stderr,"  %5.2f (thread)  %5.2f (simd) GCUPS\n", 1.0e-9f * float(n_cells)/times[0], 1.0e-9f * float(n_cells)/times[1] );
+}
+
+// check the lane width escalation of the HostSimdScheduler: a batch whose size isn't a multiple of the
+// number of 8-bit lanes mixes short jobs, whose scores fit 8-bit lanes, with long identical and long
+// unrelated strings, whose scores overflow them (and with large enough scores the 16-bit ones as well),
+// so that each group holds jobs re-run at different widths
+//
+template <typename aligner_type>
+void host_simd_overflow_test(
+    const char*                     name,
+    const aligner_type              aligner)
+{
+    const uint32 W       = host_simd<int8>::WIDTH;
+    const uint32 N_TASKS = 3u*W + 5u;
+    const uint32 M       = 600;
+    const uint32 N       = 600;
+
+    std::vector<uint32> pattern_lengths( N_TASKS );
+    std::vector<uint32> text_lengths( N_TASKS );
+    std::vector<uint8>  patterns( M * N_TASKS );
+    std::vector<uint8>  text( N * N_TASKS );
+
+    LCG_random rand;
+    for (uint32 i = 0; i < N_TASKS; ++i)
+    {
+        const uint32 kind = i % 4u;
+
+        // short, long identical, long unrelated, and medium length derived strings
+        pattern_lengths[i] = kind == 0 ? 1u + (rand.next() >> 8) % 16u : kind == 3 ? 100u : M;
+        text_lengths[i]    = kind == 0 ? 1u + (rand.next() >> 8) % 16u : kind == 3 ? 120u : N;
+
+        for (uint32 j = 0; j < M; ++j)
+            patterns[ i*M + j ] = (rand.next() >> 16) & 3u;
+        for (uint32 j = 0; j < N; ++j)
+        {
+            const bool copy = kind == 1 || (kind == 3 && (rand.next() >> 12) % 16u);
+            text[ i*N + j ] = (copy && j < M) ? patterns[ i*M + j ] : uint8( (rand.next() >> 16) & 3u );
+        }
+    }
+
+    const HostAlignmentBatch batch( N_TASKS, M, N, pattern_lengths, text_lengths, patterns, text );
+
+    std::vector<int32> ref_scores( N_TASKS );
+    std::vector<int32> simd_scores( N_TASKS );
+
+    fprintf(stderr,"    %15s : ", name);
+
+    host_batch_score<HostThreadScheduler>( aligner, batch, &ref_scores[0] );
+    host_batch_score<HostSimdScheduler>( aligner, batch, &simd_scores[0] );
+
+    int32 min_score = ref_scores[0];
+    int32 max_score = ref_scores[0];
+    for (uint32 i = 0; i < N_TASKS; ++i)
+    {
+        if (check_score( i, ref_scores[i], simd_scores[i] ) == false)
+            exit(1);
+
+        min_score = nvbio::min( min_score, ref_scores[i] );
+        max_score = nvbio::max( max_score, ref_scores[i] );
+    }
+    fprintf(stderr,"ok (%u jobs, scores in [%d,%d])\n", N_TASKS, min_score, max_score);
+}
+
+// a host alignment stream declaring smaller maximum lengths than its longest strings, so as to
+// send the longer jobs through the fallback paths of the schedulers
+//
+template <typename aligner_type>
+struct HostUnderestimatedStream : public HostAlignmentStream<aligner_type>
+{
+    // constructor
+    HostUnderestimatedStream(
+        const HostAlignmentStream<aligner_type> _stream,
+        const uint32                            _max_pattern_len,
+        const uint32                            _max_text_len) :
+        HostAlignmentStream<aligner_type>( _stream ), m_declared_pattern_len( _max_pattern_len ), m_declared_text_len( _max_text_len ) {}
+
+    // return the declared maximum pattern length
+    uint32 max_pattern_length() const { return m_declared_pattern_len; }
+
+    // return the declared maximum text length
+    uint32 max_text_length() const { return m_declared_text_len; }
+
+    uint32 m_declared_pattern_len;
+    uint32 m_declared_text_len;
+};
+
+// check the HostSimdScheduler on a stream whose longest jobs exceed its declared maximum lengths
+// against the HostThreadScheduler on the plain stream
+//
+template <typename aligner_type>
+void host_simd_long_job_test(
+    const char*                     name,
+    const aligner_type              aligner,
+    const HostAlignmentBatch&       batch)
+{
+    fprintf(stderr,"    %15s : ", name);
+
+    std::vector<int32> ref_scores( batch.n_tasks );
+    std::vector<int32> scores( batch.n_tasks );
+
+    host_batch_score<HostThreadScheduler>( aligner, batch, &ref_scores[0] );
+
+    typedef HostUnderestimatedStream<aligner_type> stream_type;
+
+    const stream_type stream( batch.score_stream( aligner, &scores[0] ), batch.M/2, batch.N/2 );
+
+    BatchedAlignmentScore<stream_type,HostSimdScheduler> batch_score;
+    batch_score.enact( stream );
+
+    uint32 n_long = 0;
+    for (uint32 i = 0; i < batch.n_tasks; ++i)
+    {
+        if (batch.pattern_lengths[i] > batch.M/2 || batch.text_lengths[i] > batch.N/2)
+            ++n_long;
+
+        if (check_score( i, ref_scores[i], scores[i] ) == false)
+            exit(1);
+    }
+    fprintf(stderr,"ok (%u long jobs)\n", n_long);
+}
+
+// check the HostTiledAlignmentStream on packed reads and reference windows against the plain
+// HostAlignmentStream on the unpacked strings, running each scheduler twice on the same arena:
+// the second round must not allocate any more tiles
+//
+template <typename aligner_type>
+void host_tiled_test(
+    const char*                     name,
+    const aligner_type              aligner,
+    const HostAlignmentBatch&       batch)
+{
+    typedef PackedVector<host_tag,2u>                                   packed_vector_type;
+    typedef packed_vector_type::const_plain_view_type                   packed_stream_type;
+    typedef ConcatenatedStringSet<packed_stream_type,const uint32*>     pattern_set_type;
+    typedef InfixSet<packed_stream_type,const uint2*>                   text_set_type;
+    typedef aln::BestSink<int32>                                        sink_type;
+
+    const uint32 n_tasks = batch.n_tasks;
+
+    // pack the patterns as a concatenated read set, and the texts as windows of a single reference
+    std::vector<uint32> pattern_offsets( n_tasks+1 );
+    std::vector<uint2>  text_infixes( n_tasks );
+
+    pattern_offsets[0] = 0u;
+    uint32 text_offset = 0u;
+    for (uint32 i = 0; i < n_tasks; ++i)
+    {
+        pattern_offsets[i+1] = pattern_offsets[i] + batch.pattern_lengths[i];
+        text_infixes[i]      = make_uint2( text_offset, text_offset + batch.text_lengths[i] );
+        text_offset         += batch.text_lengths[i];
+    }
+
+    packed_vector_type packed_patterns( pattern_offsets[ n_tasks ] );
+    packed_vector_type packed_text( text_offset );
+    for (uint32 i = 0; i < n_tasks; ++i)
+    {
+        for (uint32 j = 0; j < batch.pattern_lengths[i]; ++j)
+            packed_patterns[ pattern_offsets[i] + j ] = batch.patterns[ i*batch.M + j ];
+        for (uint32 j = 0; j < batch.text_lengths[i]; ++j)
+            packed_text[ text_infixes[i].x + j ] = batch.text[ i*batch.N + j ];
+    }
+
+    const pattern_set_type pattern_set( n_tasks, plain_view( (const packed_vector_type&)packed_patterns ), &pattern_offsets[0] );
+    const text_set_type    text_set( n_tasks, plain_view( (const packed_vector_type&)packed_text ), &text_infixes[0] );
+
+    std::vector<int32>      ref_scores( n_tasks );
+    std::vector<sink_type>  sinks( n_tasks );
+
+    fprintf(stderr,"    %15s : ", name);
+
+    Timer timer;
+    timer.start();
+
+    host_batch_score<HostThreadScheduler>( aligner, batch, &ref_scores[0] );
+
+    timer.stop();
+    const float ref_time = timer.seconds();
+
+    // run each scheduler twice, reusing the same arena
+    HostTileArena arena;
+
+    float  times[2];
+    uint64 first_round_bytes = 0u;
+    for (uint32 s = 0; s < 4; ++s)
+    {
+        timer.start();
+
+        if (s & 1)
+            batch_alignment_score( aligner, pattern_set, trivial_quality_string_set(), text_set, &sinks[0], HostSimdScheduler(), arena, batch.M, batch.N );
+        else
+            batch_alignment_score( aligner, pattern_set, trivial_quality_string_set(), text_set, &sinks[0], HostThreadScheduler(), arena, batch.M, batch.N );
+
+        timer.stop();
+        times[s & 1] = timer.seconds();
+
+        for (uint32 i = 0; i < n_tasks; ++i)
+        {
+            if (check_score( i, ref_scores[i], sinks[i].score ) == false)
+                exit(1);
+        }
+
+        if (s == 1)
+            first_round_bytes = arena.allocated_bytes();
+    }
+
+    if (arena.allocated_bytes() != first_round_bytes)
+    {
+        log_error(stderr, "\n    the arena grew from %llu to %llu bytes when reused\n",
+            (unsigned long long)first_round_bytes, (unsigned long long)arena.allocated_bytes() );
+        exit(1);
+    }
+
+    const uint64 n_cells = batch.n_cells();
+    fprintf(stderr,"  %5.2f (unpacked)  %5.2f (thread)  %5.2f (simd) GCUPS, %.1f KB of tiles\n",
+        1.0e-9f * float(n_cells)/ref_time,
+        1.0e-9f * float(n_cells)/times[0],
+        1.0e-9f * float(n_cells)/times[1],
+        float(arena.allocated_bytes()) / 1024.0f );
+}
+
+// check the word-at-a-time unpacking of packed strings used by the HostTiledAlignmentStream against
+// plain symbol access, on reference windows starting at every offset within a few storage words and
+// spanning from zero to a few words, making sure nothing is written past their end
+//
+void host_tiled_unpack_test()
+{
+    typedef PackedVector<host_tag,2u>                   packed_vector_type;
+    typedef packed_vector_type::const_plain_view_type   packed_stream_type;
+    typedef InfixSet<packed_stream_type,const uint2*>   text_set_type;
+
+    const uint32 REF_LEN     = 256;
+    const uint32 MAX_OFFSET  = 48;
+    const uint32 MAX_LEN     = 100;
+    const uint8  GUARD       = 0xAA;
+
+    LCG_random rand;
+
+    packed_vector_type packed_text( REF_LEN );
+    for (uint32 j = 0; j < REF_LEN; ++j)
+        packed_text[j] = (rand.next() >> 16) & 3u;
+
+    std::vector<uint2> infixes;
+    for (uint32 offset = 0; offset < MAX_OFFSET; ++offset)
+    {
+        for (uint32 len = 0; len <= MAX_LEN; ++len)
+            infixes.push_back( make_uint2( offset, offset + len ) );
+    }
+
+    const text_set_type text_set( uint32( infixes.size() ), plain_view( (const packed_vector_type&)packed_text ), &infixes[0] );
+
+    fprintf(stderr,"    %15s : ", "unpacking");
+
+    std::vector<uint8> out( MAX_LEN + 1u );
+    for (uint32 i = 0; i < text_set.size(); ++i)
+    {
+        const uint32 len = infixes[i].y - infixes[i].x;
+
+        std::fill( out.begin(), out.end(), GUARD );
+        aln::priv::unpack_string( text_set[i], &out[0] );
+
+        for (uint32 j = 0; j <= len; ++j)
+        {
+            const uint8 expected = j < len ? uint8( text_set[i][j] ) : GUARD;
+            if (out[j] != expected)
+            {
+                log_error(stderr, "\n    window [%u,%u): expected %u at %u, got %u\n", infixes[i].x, infixes[i].y, expected, j, out[j] );
+                exit(1);
+            }
+        }
+    }
+    fprintf(stderr,"  %u windows ok\n", text_set.size());
+}
+
+// check the StripedTag Gotoh implementation against the TextBlockingTag one on a batch of variable length problems
+//
+template <AlignmentType TYPE>
+void host_striped_test(
+    const char*                     name,
+    const SimpleGotohScheme         scoring,
+    const HostAlignmentBatch&       batch)
+{
+    typedef GotohAligner<TYPE,SimpleGotohScheme,TextBlockingTag>    ref_aligner_type;
+    typedef GotohAligner<TYPE,SimpleGotohScheme,StripedTag>         striped_aligner_type;
+
+    std::vector<int32> ref_scores( batch.n_tasks );
+    std::vector<int32> striped_scores( batch.n_tasks );
+
+    fprintf(stderr,"    %15s : ", name);
+
+    float times[2];
+    {
+        Timer timer;
+        timer.start();
+
+        host_batch_score<HostThreadScheduler>( ref_aligner_type( scoring ), batch, &ref_scores[0] );
+
+        timer.stop();
+        times[0] = timer.seconds();
+    }
+    {
+        Timer timer;
+        timer.start();
+
+        host_batch_score<HostThreadScheduler>( striped_aligner_type( scoring ), batch, &striped_scores[0] );
+
+        timer.stop();
+        times[1] = timer.seconds();
+    }
+
+    for (uint32 i = 0; i < batch.n_tasks; ++i)
+    {
+        if (check_score( i, ref_scores[i], striped_scores[i] ) == false)
+            exit(1);
+    }
+
+    const uint64 n_cells = batch.n_cells();
+    fprintf(stderr,"  %5.2f (text-blocking)  %5.2f (striped) GCUPS\n", 1.0e-9f * float(n_cells)/times[0], 1.0e-9f * float(n_cells)/times[1] );
+}
+
+// check the StripedTag Gotoh implementation against the TextBlockingTag one on the cases its
+// layout makes special: pattern lengths around multiples of the vector width, which leave the
+// last lanes padded, texts missing a long run of the pattern, which make the lazy-F loop wrap
+// around the segments, and scores too large for the 16-bit lanes, which must fall back to the
+// scalar code
+//
+template <AlignmentType TYPE>
+void host_striped_edge_test(
+    const char*                     name,
+    const SimpleGotohScheme         scoring)
+{
+    typedef GotohAligner<TYPE,SimpleGotohScheme,TextBlockingTag>    ref_aligner_type;
+    typedef GotohAligner<TYPE,SimpleGotohScheme,StripedTag>         striped_aligner_type;
+    typedef nvbio::vector_view<const uint8*>                        string_type;
+
+    const uint32 W = host_simd<int16>::WIDTH;
+
+    fprintf(stderr,"    %15s : ", name);
+
+    LCG_random rand;
+
+    std::vector<uint8>  pattern;
+    std::vector<uint8>  text;
+    std::vector<short2> column;
+
+    uint32 n_tests = 0;
+
+    // 0: a text matching the pattern, 1: a text missing half of the pattern, 2: identical strings
+    // long and well-matching enough to overflow 16 bits
+    for (uint32 kind = 0; kind < 3; ++kind)
+    {
+        const uint32 max_M = kind < 2 ? 4*W + 1 : 600u;
+        const uint32 min_M = kind < 2 ? 1u      : 600u;
+
+        for (uint32 M = min_M; M <= max_M; ++M)
+        {
+            pattern.resize( M );
+            for (uint32 j = 0; j < M; ++j)
+                pattern[j] = uint8( (rand.next() >> 16) & 3u );
+
+            // surround the (possibly gapped) pattern with random flanks, except for the overflow test
+            const uint32 flank = kind < 2 ? 1u + (rand.next() >> 8) % W : 0u;
+
+            text.clear();
+            for (uint32 i = 0; i < flank; ++i)
+                text.push_back( uint8( (rand.next() >> 16) & 3u ) );
+            for (uint32 j = 0; j < M; ++j)
+            {
+                if (kind != 1 || j < M/4 || j >= M/4 + M/2)
+                    text.push_back( pattern[j] );
+            }
+            for (uint32 i = 0; i < flank; ++i)
+                text.push_back( uint8( (rand.next() >> 16) & 3u ) );
+
+            column.resize( M + 1u );
+
+            const string_type p( M, &pattern[0] );
+            const string_type t( uint32( text.size() ), &text[0] );
+
+            aln::BestSink<int32> ref_sink;
+            aln::BestSink<int32> striped_sink;
+
+            alignment_score( ref_aligner_type( scoring ),     p, trivial_quality_string(), t, Field_traits<int32>::min(), ref_sink,     &column[0] );
+            alignment_score( striped_aligner_type( scoring ), p, trivial_quality_string(), t, Field_traits<int32>::min(), striped_sink, &column[0] );
+
+            if (ref_sink.score != striped_sink.score)
+            {
+                log_error(stderr, "\n    mismatching score for M=%u, text length %u (case %u): expected %d, got %d\n",
+                    M, uint32( text.size() ), kind, ref_sink.score, striped_sink.score);
+                exit(1);
+            }
+            ++n_tests;
+        }
+    }
+    fprintf(stderr,"ok (%u problems, %u lanes)\n", n_tests, W);
+}
+
+// check the host-side Myers bit-vector algorithm against the scalar edit distance code
+//
+template <AlignmentType TYPE>
+void host_myers_test(
+    const char*                     name,
+    const HostAlignmentBatch&       batch)
+{
+    typedef EditDistanceAligner<TYPE,TextBlockingTag>   ref_aligner_type;
+    typedef EditDistanceAligner<TYPE,MyersTag<4> >      myers_aligner_type;
+
+    std::vector<int32> ref_scores( batch.n_tasks );
+    std::vector<int32> myers_scores( batch.n_tasks );
+
+    fprintf(stderr,"    %15s : ", name);
+
+    float times[2];
+    {
+        Timer timer;
+        timer.start();
+
+        host_batch_score<HostThreadScheduler>( ref_aligner_type(), batch, &ref_scores[0] );
+
+        timer.stop();
+        times[0] = timer.seconds();
+    }
+    {
+        Timer timer;
+        timer.start();
+
+        host_batch_score<HostThreadScheduler>( myers_aligner_type(), batch, &myers_scores[0] );
+
+        timer.stop();
+        times[1] = timer.seconds();
+    }
+
+    for (uint32 i = 0; i < batch.n_tasks; ++i)
+    {
+        if (check_score( i, ref_scores[i], myers_scores[i] ) == false)
+            exit(1);
+    }
+
+    const uint64 n_cells = batch.n_cells();
+    fprintf(stderr,"  %5.2f (text-blocking)  %5.2f (myers) GCUPS\n", 1.0e-9f * float(n_cells)/times[0], 1.0e-9f * float(n_cells)/times[1] );
+}
+
+// check the edit distance threshold of the host-side Myers bit-vector algorithm: each problem is
+// scored with min_score set one below, at and one above the full DP score, so that the Ukkonen
+// cut-off and the early exits run right at their limits; the first two must report the full
+// DP score and succeed, while the last must report nothing
+//
+template <AlignmentType TYPE>
+void host_myers_threshold_test(
+    const char*                     name,
+    const HostAlignmentBatch&       batch)
+{
+    typedef EditDistanceAligner<TYPE,TextBlockingTag>   ref_aligner_type;
+    typedef EditDistanceAligner<TYPE,MyersTag<4> >      myers_aligner_type;
+
+    std::vector<int32> ref_scores( batch.n_tasks );
+
+    fprintf(stderr,"    %15s : ", name);
+
+    host_batch_score<HostThreadScheduler>( ref_aligner_type(), batch, &ref_scores[0] );
+
+    std::vector<int16> column( batch.M + 1u );
+
+    Timer timer;
+    timer.start();
+
+    uint32 n_accepted = 0;
+    uint32 n_rejected = 0;
+    for (uint32 i = 0; i < batch.n_tasks; ++i)
+    {
+        for (int32 delta = -1; delta <= 1; ++delta)
+        {
+            const int32 min_score = ref_scores[i] + delta;
+
+            aln::BestSink<int32> sink;
+            const bool ok = alignment_score(
+                myers_aligner_type(),
+                batch.pattern(i),
+                trivial_quality_string(),
+                batch.text_string(i),
+                min_score,
+                sink,
+                &column[0] );
+
+            const bool  accept   = ref_scores[i] >= min_score;
+            const int32 expected = accept ? ref_scores[i] : Field_traits<int32>::min();
+
+            if (sink.score != expected || (accept && ok == false))
+            {
+                log_error(stderr, "\n    problem %u, min score %d: expected %d, got %d (%s)\n",
+                    i, min_score, expected, sink.score, ok ? "succeeded" : "failed");
+                exit(1);
+            }
+
+            if (accept) ++n_accepted;
+            else        ++n_rejected;
+        }
+    }
+
+    timer.stop();
+
+    fprintf(stderr,"  %u accepted, %u rejected, %.1f ms\n", n_accepted, n_rejected, timer.seconds() * 1000.0f);
+}
+
+// check the host adaptive banded extension, run through BatchedBandedAlignmentScore, against the scalar code
+//
+template <uint32 BAND_LEN, typename aligner_type>
+void host_extension_test(
+    const char*                     name,
+    const aligner_type              aligner,
+    const HostAlignmentBatch&       batch)
+{
+    typedef HostAlignmentStream<aligner_type> stream_type;
+
+    std::vector<int32> scores( batch.n_tasks );
+
+    fprintf(stderr,"    %15s : ", name);
+
+    Timer timer;
+    timer.start();
+
+    BatchedBandedAlignmentScore<BAND_LEN,stream_type,HostThreadScheduler> batch_score;
+    batch_score.enact( batch.score_stream( aligner, &scores[0] ) );
+
+    timer.stop();
+
+    uint64 n_cells = 0u;
+    for (uint32 i = 0; i < batch.n_tasks; ++i)
+    {
+        priv::ExtensionState state;
+        priv::extension_score<BAND_LEN>(
+            aligner,
+            batch.pattern(i),
+            trivial_quality_string(),
+            batch.text_string(i),
+            state );
+
+        n_cells += uint64( batch.pattern_lengths[i] + batch.text_lengths[i] ) * BAND_LEN;
+
+        if (check_score( i, state.score, scores[i] ) == false)
+            exit(1);
+    }
+    fprintf(stderr,"  %5.2f GCUPS (upper bound)\n", 1.0e-9f * float(n_cells)/timer.seconds() );
+}
+
+// compute the best score of the alignments between any prefixes of a pattern and a text, and the best
+// one consuming the whole pattern, with the full (N+1)x(M+1) DP matrix of extension_score()
+//
+template <typename string_type>
+void extension_full_dp(
+    const SimpleGotohScheme         scoring,
+    const string_type               pattern,
+    const string_type               text,
+    int32&                          best_score,
+    int32&                          end_to_end_score)
+{
+    const int32 M = int32( pattern.length() );
+    const int32 N = int32( text.length() );
+    const int32 INF = -(1 << 29);
+
+    std::vector<int32> H( (N+1) * (M+1) );
+    std::vector<int32> E( (N+1) * (M+1), INF );
+    std::vector<int32> F( (N+1) * (M+1), INF );
+
+    best_score       = 0;
+    end_to_end_score = INF;
+    for (int32 i = 0; i <= N; ++i)
+    {
+        for (int32 j = 0; j <= M; ++j)
+        {
+            const int32 c = i*(M+1) + j;
+            if (i == 0 || j == 0)
+            {
+                H[c] = (i == 0 && j == 0) ? 0 :
+                       (i == 0) ? scoring.pattern_gap_open() + scoring.pattern_gap_extension() * (j-1) :
+                                  scoring.text_gap_open()    + scoring.text_gap_extension()    * (i-1);
+            }
+            else
+            {
+                E[c] = nvbio::max( H[c - (M+1)] + scoring.text_gap_open(),    E[c - (M+1)] + scoring.text_gap_extension() );
+                F[c] = nvbio::max( H[c - 1]     + scoring.pattern_gap_open(), F[c - 1]     + scoring.pattern_gap_extension() );
+
+                const int32 s = text[i-1] == pattern[j-1] ? scoring.match() : scoring.mismatch();
+                H[c] = nvbio::max( nvbio::max( H[c - (M+1) - 1] + s, E[c] ), F[c] );
+            }
+            best_score = nvbio::max( best_score, H[c] );
+        }
+        end_to_end_score = nvbio::max( end_to_end_score, H[i*(M+1) + M] );
+    }
+}
+
+// check the adaptive band at its edges: texts reproduce their pattern but for a single gap of
+// increasing length at its middle, so that the best path leaves the main diagonal by as much.
+// Within half the band the window must find the full DP scores, while beyond that it can never
+// do better than them; the batched scores must match the scalar ones throughout
+//
+template <uint32 BAND_LEN>
+void host_extension_band_test(
+    const char*                     name,
+    const SimpleGotohScheme         scoring)
+{
+    typedef ExtensionAligner<SimpleGotohScheme>     aligner_type;
+    typedef HostAlignmentStream<aligner_type>       stream_type;
+
+    const uint32 M       = 200u;
+    const uint32 N       = M + 2u * BAND_LEN;
+    const uint32 n_tasks = 4u * BAND_LEN;
+
+    // task 2g inserts g symbols in the text, task 2g+1 deletes them
+    std::vector<uint32> pattern_lengths( n_tasks, M );
+    std::vector<uint32> text_lengths( n_tasks );
+    std::vector<uint8>  patterns( M * n_tasks );
+    std::vector<uint8>  text( N * n_tasks );
+
+    LCG_random rand;
+    for (uint32 t = 0; t < n_tasks; ++t)
+    {
+        const uint32 g = t / 2u;
+
+        for (uint32 j = 0; j < M; ++j)
+            patterns[ t*M + j ] = uint8( (rand.next() >> 16) & 3u );
+
+        uint32 n = 0;
+        for (uint32 j = 0; j < M; ++j)
+        {
+            if (j == M/2 && (t & 1u) == 0u)
+            {
+                for (uint32 k = 0; k < g; ++k)
+                    text[ t*N + n++ ] = uint8( (rand.next() >> 16) & 3u );
+            }
+            if ((t & 1u) == 0u || j < M/2 || j >= M/2 + g)
+                text[ t*N + n++ ] = patterns[ t*M + j ];
+        }
+        text_lengths[t] = n;
+    }
+
+    const HostAlignmentBatch batch( n_tasks, M, N, pattern_lengths, text_lengths, patterns, text );
+
+    const aligner_type aligner( scoring );
+
+    std::vector<int32> scores( n_tasks );
+
+    BatchedBandedAlignmentScore<BAND_LEN,stream_type,HostThreadScheduler> batch_score;
+    batch_score.enact( batch.score_stream( aligner, &scores[0] ) );
+
+    fprintf(stderr,"    %15s : ", name);
+
+    uint32 n_exact = 0;
+    for (uint32 t = 0; t < n_tasks; ++t)
+    {
+        const uint32 g = t / 2u;
+
+        priv::ExtensionState state;
+        priv::extension_score<BAND_LEN>( aligner, batch.pattern(t), trivial_quality_string(), batch.text_string(t), state );
+
+        int32 full_score, full_end_to_end_score;
+        extension_full_dp( scoring, batch.pattern(t), batch.text_string(t), full_score, full_end_to_end_score );
+
+        const bool within = g <= (BAND_LEN-1)/2;
+
+        if (check_score( t, state.score, scores[t] ) == false ||
+            state.score            > full_score            ||
+            state.end_to_end_score > full_end_to_end_score ||
+            (within && (state.score != full_score || state.end_to_end_score != full_end_to_end_score)))
+        {
+            log_error(stderr, "\n    %s of %u symbols: banded score %d (end-to-end %d), full DP score %d (end-to-end %d)\n",
+                t & 1u ? "deletion" : "insertion", g,
+                state.score, state.end_to_end_score, full_score, full_end_to_end_score);
+            exit(1);
+        }
+
+        if (state.score == full_score)
+            ++n_exact;
+    }
+    fprintf(stderr,"ok (%u/%u exact, gaps up to %u)\n", n_exact, n_tasks, 2u*BAND_LEN - 1u);
+}
+
+// check the host two-level checkpoint traceback against the fully checkpointed one, and both
+// against the scores of the plain scoring pass; the alignment operations must also span exactly
+// the pattern and text ranges between the reported source and sink
+//
+template <uint32 CHECKPOINTS, typename aligner_type>
+void host_traceback_test(
+    const char*                     name,
+    const aligner_type              aligner,
+    const HostAlignmentBatch&       batch)
+{
+    typedef HostTracebackStream<aligner_type> stream_type;
+
+    std::vector<int32>             scores( batch.n_tasks );
+    std::vector<Alignment<int32> > alignments[2];
+    std::vector<std::string>       cigars[2];
+
+    fprintf(stderr,"    %15s : ", name);
+
+    host_batch_score<HostThreadScheduler>( aligner, batch, &scores[0] );
+
+    float times[2];
+    for (uint32 mode = 0; mode < 2; ++mode)
+    {
+        alignments[mode].resize( batch.n_tasks );
+        cigars[mode].resize( batch.n_tasks );
+
+        Timer timer;
+        timer.start();
+
+        BatchedAlignmentTraceback<CHECKPOINTS,stream_type,HostThreadScheduler> batch_traceback( mode ? TWO_LEVEL_CHECKPOINTS : FULL_CHECKPOINTS );
+        batch_traceback.enact( batch.traceback_stream( aligner, &alignments[mode][0], &cigars[mode][0] ) );
+
+        timer.stop();
+        times[mode] = timer.seconds();
+    }
+
+    for (uint32 i = 0; i < batch.n_tasks; ++i)
+    {
+        if (alignments[0][i].score    != alignments[1][i].score    ||
+            alignments[0][i].source.x != alignments[1][i].source.x ||
+            alignments[0][i].sink.x   != alignments[1][i].sink.x   ||
+            cigars[0][i]              != cigars[1][i])
+        {
+            log_error(stderr, "\n    mismatching traceback for problem %u: expected score %d, got %d\n", i, alignments[0][i].score, alignments[1][i].score);
+            exit(1);
+        }
+
+        // count the text and pattern symbols consumed by the alignment operations
+        uint32 n_text    = 0u;
+        uint32 n_pattern = 0u;
+        for (uint32 j = 0; j < cigars[0][i].size(); ++j)
+        {
+            const char op = cigars[0][i][j];
+            n_text    += (op == 'M' || op == 'D') ? 1u : 0u;
+            n_pattern += (op == 'M' || op == 'I') ? 1u : 0u;
+        }
+
+        const Alignment<int32>& alignment = alignments[0][i];
+        if (alignment.score != scores[i] ||
+            n_text          != alignment.sink.x - alignment.source.x ||
+            n_pattern       != alignment.sink.y - alignment.source.y)
+        {
+            log_error(stderr, "\n    inconsistent traceback for problem %u: score %d (expected %d), text [%u,%u) with %u symbols, pattern [%u,%u) with %u symbols\n",
+                i, alignment.score, scores[i],
+                alignment.source.x, alignment.sink.x, n_text,
+                alignment.source.y, alignment.sink.y, n_pattern );
+            exit(1);
+        }
+    }
+
+    const uint64 n_cells = batch.n_cells();
+    fprintf(stderr,"  %5.2f (full)  %5.2f (two-level) GCUPS\n", 1.0e-9f * float(n_cells)/times[0], 1.0e-9f * float(n_cells)/times[1] );
+}
+
+// check the host wavefront aligner against the Gotoh one on a batch of variable length problems,
+// both scoring and tracing back alignments in either memory mode; the tracebacks are re-scored
+// operation by operation
+//
+template <AlignmentType TYPE>
+void host_wavefront_test(
+    const char*                     name,
+    const SimpleGotohScheme         scoring,
+    const HostAlignmentBatch&       batch)
+{
+    typedef GotohAligner<TYPE,SimpleGotohScheme>        ref_aligner_type;
+    typedef WavefrontAligner<TYPE,SimpleGotohScheme>    wfa_aligner_type;
+    typedef HostTracebackStream<wfa_aligner_type>       stream_type;
+
+    std::vector<int32>              ref_scores( batch.n_tasks );
+    std::vector<int32>              wfa_scores( batch.n_tasks );
+    std::vector<Alignment<int32> >  alignments[2];
+    std::vector<std::string>        cigars[2];
+
+    fprintf(stderr,"    %15s : ", name);
+
+    float ref_time, wfa_time, traceback_times[2];
+    {
+        Timer timer;
+        timer.start();
+
+        host_batch_score<HostThreadScheduler>( ref_aligner_type( scoring ), batch, &ref_scores[0] );
+
+        timer.stop();
+        ref_time = timer.seconds();
+    }
+    {
+        Timer timer;
+        timer.start();
+
+        host_batch_score<HostThreadScheduler>( wfa_aligner_type( scoring ), batch, &wfa_scores[0] );
+
+        timer.stop();
+        wfa_time = timer.seconds();
+    }
+    for (uint32 mode = 0; mode < 2; ++mode)
+    {
+        alignments[mode].resize( batch.n_tasks );
+        cigars[mode].resize( batch.n_tasks );
+
+        Timer timer;
+        timer.start();
+
+        BatchedAlignmentTraceback<16,stream_type,HostThreadScheduler> batch_traceback;
+        batch_traceback.enact( batch.traceback_stream(
+            wfa_aligner_type( scoring, mode ? BIDIRECTIONAL_WAVEFRONTS : FULL_WAVEFRONTS ),
+            &alignments[mode][0],
+            &cigars[mode][0] ) );
+
+        timer.stop();
+        traceback_times[mode] = timer.seconds();
+    }
+
+    for (uint32 i = 0; i < batch.n_tasks; ++i)
+    {
+        if (check_score( i, ref_scores[i], wfa_scores[i] ) == false)
+            exit(1);
+
+        const uint8* pattern = batch.patterns + i*batch.M;
+        const uint8* text    = batch.text     + i*batch.N;
+
+        for (uint32 mode = 0; mode < 2; ++mode)
+        {
+            // re-score the (reversed) alignment operations
+            const Alignment<int32>& alignment = alignments[mode][i];
+            const std::string&      ops       = cigars[mode][i];
+
+            uint32 h = alignment.source.x;
+            uint32 v = alignment.source.y;
+            int32  score = 0;
+            char   prev  = 'M';
+            for (int32 j = int32( ops.size() ) - 1; j >= 0; --j)
+            {
+                const char op = ops[j];
+                if (op == 'M')
+                {
+                    score += pattern[v] == text[h] ? scoring.match() : scoring.mismatch();
+                    ++h; ++v;
+                }
+                else if (op == 'I')
+                {
+                    score += prev == 'I' ? scoring.pattern_gap_extension() : scoring.pattern_gap_open();
+                    ++v;
+                }
+                else if (op == 'D')
+                {
+                    score += prev == 'D' ? scoring.pattern_gap_extension() : scoring.pattern_gap_open();
+                    ++h;
+                }
+                if (op != 'S')
+                    prev = op;
+            }
+
+            if (alignment.score != ref_scores[i] ||
+                score           != ref_scores[i] ||
+                h               != alignment.sink.x ||
+                v               != alignment.sink.y ||
+                v               != batch.pattern_lengths[i])
+            {
+                log_error(stderr, "\n    mismatching %s traceback for problem %u: expected score %d, got %d (re-scored %d)\n", mode ? "bidirectional" : "full", i, ref_scores[i], alignment.score, score);
+                exit(1);
+            }
+        }
+    }
+
+    const uint64 n_cells = batch.n_cells();
+    fprintf(stderr,"  %5.2f (gotoh)  %5.2f (wfa)  %5.2f (wfa-traceback)  %5.2f (biwfa-traceback) GCUPS\n",
+        1.0e-9f * float(n_cells)/ref_time,
+        1.0e-9f * float(n_cells)/wfa_time,
+        1.0e-9f * float(n_cells)/traceback_times[0],
+        1.0e-9f * float(n_cells)/traceback_times[1] );
+}
+
+// check the score threshold of the host wavefront aligner: each problem is scored with min_score
+// set one below, at and one above the Gotoh score, so that the maximum penalty the wavefronts
+// are extended to sits right at its limit; the first two must report the Gotoh score and succeed,
+// while the last must report nothing
+//
+template <AlignmentType TYPE>
+void host_wavefront_threshold_test(
+    const char*                     name,
+    const SimpleGotohScheme         scoring,
+    const HostAlignmentBatch&       batch)
+{
+    typedef GotohAligner<TYPE,SimpleGotohScheme>        ref_aligner_type;
+    typedef WavefrontAligner<TYPE,SimpleGotohScheme>    wfa_aligner_type;
+
+    std::vector<int32> ref_scores( batch.n_tasks );
+
+    fprintf(stderr,"    %15s : ", name);
+
+    host_batch_score<HostThreadScheduler>( ref_aligner_type( scoring ), batch, &ref_scores[0] );
+
+    // the column storage used by the Gotoh fallback
+    std::vector<short2> column( batch.M + 1u );
+
+    uint32 n_accepted = 0;
+    uint32 n_rejected = 0;
+    for (uint32 i = 0; i < batch.n_tasks; ++i)
+    {
+        for (int32 delta = -1; delta <= 1; ++delta)
+        {
+            const int32 min_score = ref_scores[i] + delta;
+
+            aln::BestSink<int32> sink;
+            const bool ok = alignment_score(
+                wfa_aligner_type( scoring ),
+                batch.pattern(i),
+                trivial_quality_string(),
+                batch.text_string(i),
+                min_score,
+                sink,
+                &column[0] );
+
+            const bool  accept   = ref_scores[i] >= min_score;
+            const int32 expected = accept ? ref_scores[i] : Field_traits<int32>::min();
+
+            if (sink.score != expected || (accept && ok == false))
+            {
+                log_error(stderr, "\n    problem %u, min score %d: expected %d, got %d (%s)\n",
+                    i, min_score, expected, sink.score, ok ? "succeeded" : "failed");
+                exit(1);
+            }
+
+            if (accept) ++n_accepted;
+            else        ++n_rejected;
+        }
+    }
+    fprintf(stderr,"  %u accepted, %u rejected\n", n_accepted, n_rejected);
+}
+
+// a Gotoh scoring scheme scoring any alignment of an N (i.e. symbol 4) as a mismatch,
+// including that of two N's, which the wavefront aligner can't represent
+//
+struct NMismatchGotohScheme : public SimpleGotohScheme
+{
+    NMismatchGotohScheme(const int32 match, const int32 mm, const int32 gap_open, const int32 gap_ext) :
+        SimpleGotohScheme( match, mm, gap_open, gap_ext ) {}
+
+    int32 substitution(const uint32 r_i, const uint32 q_j, const uint8 r, const uint8 q, const uint8 qq = 0) const { return (q == r && q < 4) ? m_match : m_mismatch; }
+};
+
+// check the host wavefront aligner against the Gotoh one on strings holding N's, scoring and
+// tracing back alignments: with SimpleGotohScheme an N matches an N and nothing else, and the
+// wavefronts handle them as any other symbol, while with NMismatchGotohScheme the alignments
+// must fall back to the Gotoh aligner
+//
+template <AlignmentType TYPE, typename scoring_type>
+void host_wavefront_alphabet_test(
+    const char*                     name,
+    const scoring_type              scoring,
+    const HostAlignmentBatch&       batch)
+{
+    typedef GotohAligner<TYPE,scoring_type>         ref_aligner_type;
+    typedef WavefrontAligner<TYPE,scoring_type>     wfa_aligner_type;
+    typedef HostTracebackStream<wfa_aligner_type>   stream_type;
+
+    std::vector<int32>              ref_scores( batch.n_tasks );
+    std::vector<int32>              wfa_scores( batch.n_tasks );
+    std::vector<Alignment<int32> >  alignments( batch.n_tasks );
+    std::vector<std::string>        cigars( batch.n_tasks );
+
+    fprintf(stderr,"    %15s : ", name);
+
+    host_batch_score<HostThreadScheduler>( ref_aligner_type( scoring ), batch, &ref_scores[0] );
+    host_batch_score<HostThreadScheduler>( wfa_aligner_type( scoring ), batch, &wfa_scores[0] );
+
+    BatchedAlignmentTraceback<16,stream_type,HostThreadScheduler> batch_traceback;
+    batch_traceback.enact( batch.traceback_stream( wfa_aligner_type( scoring ), &alignments[0], &cigars[0] ) );
+
+    for (uint32 i = 0; i < batch.n_tasks; ++i)
+    {
+        if (check_score( i, ref_scores[i], wfa_scores[i] )        == false ||
+            check_score( i, ref_scores[i], alignments[i].score ) == false)
+            exit(1);
+    }
+    fprintf(stderr,"  %u problems ok\n", batch.n_tasks);
+}
+
+// generate a batch of patterns and of texts derived from them with the given error profile,
+// optionally surrounded by random flanks
+//
+void generate_error_profile_batch(
+    const uint32            n_tasks,
+    const uint32            M,
+    const uint32            flank,
+    const float             substitution_rate,
+    const float             indel_rate,
+    std::vector<uint32>&    pattern_lengths,
+    std::vector<uint32>&    text_lengths,
+    std::vector<uint8>&     patterns,
+    std::vector<uint8>&     text)
+{
+    // leave enough room for all the insertions in the text
+    const uint32 N = 2u * (M + flank);
+
+    pattern_lengths.resize( n_tasks );
+    text_lengths.resize( n_tasks );
+    patterns.resize( M * n_tasks );
+    text.resize( N * n_tasks );
+
+    const uint32 substitution_threshold = uint32( substitution_rate * 65536.0f );
+    const uint32 indel_threshold        = uint32( (substitution_rate + indel_rate) * 65536.0f );
+
+    LCG_random rand;
+    for (uint32 i = 0; i < n_tasks; ++i)
+    {
+        pattern_lengths[i] = M;
+
+        for (uint32 j = 0; j < M; ++j)
+            patterns[ i*M + j ] = (rand.next() >> 16) & 3u;
+
+        uint32 n = 0;
+        for (uint32 j = 0; j < flank; ++j)
+            text[ i*N + n++ ] = (rand.next() >> 16) & 3u;
+
+        for (uint32 j = 0; j < M; ++j)
+        {
+            const uint32 r = (rand.next() >> 8) & 0xFFFFu;
+            if (r < substitution_threshold)
+                text[ i*N + n++ ] = uint8( (patterns[ i*M + j ] + 1u + (rand.next() >> 16) % 3u) & 3u );
+            else if (r < indel_threshold)
+            {
+                // an insertion or a deletion of one or two bases
+                const uint32 len = 1u + ((rand.next() >> 16) & 1u);
+                if ((rand.next() >> 16) & 1u)
+                {
+                    for (uint32 l = 0; l < len; ++l)
+                        text[ i*N + n++ ] = (rand.next() >> 16) & 3u;
+
+                    text[ i*N + n++ ] = patterns[ i*M + j ];
+                }
+                else
+                    j += len - 1u;
+            }
+            else
+                text[ i*N + n++ ] = patterns[ i*M + j ];
+        }
+
+        for (uint32 j = 0; j < flank; ++j)
+            text[ i*N + n++ ] = (rand.next() >> 16) & 3u;
+
+        text_lengths[i] = nvbio::max( n, 1u );
+    }
+}
+
+// a Gotoh scoring scheme whose substitution scores depend on the pattern qualities,
+// with different pattern and text gap penalties
+//
+struct QualityGotohScheme
+{
+    int32 match(const uint8 q = 0)      const { return 1 + q/20; }
+    int32 mismatch(const uint8 q = 0)   const { return -1 - q/15; }
+    int32 mismatch(const uint8 a, const uint8 b, const uint8 q = 0) const { return mismatch( q ); }
+    int32 substitution(const uint32 r_i, const uint32 q_j, const uint8 r, const uint8 q, const uint8 qq = 0) const { return q == r ? match( qq ) : mismatch( qq ); }
+    int32 pattern_gap_open()            const { return -7; }
+    int32 pattern_gap_extension()       const { return -2; }
+    int32 text_gap_open()               const { return -9; }
+    int32 text_gap_extension()          const { return -3; }
+};
+
+// check the DifferenceRecurrenceTag banded Gotoh implementation against the PatternBlockingTag one,
+// aligning each pattern to its text clipped to the band, and optionally using qualities stored
+// at the same offsets as the patterns
+//
+template <uint32 BAND_LEN, AlignmentType TYPE, typename scoring_type>
+void host_banded_diff_test(
+    const char*                     name,
+    const scoring_type              scoring,
+    const HostAlignmentBatch&       batch,
+    const uint8*                    quals = NULL)
+{
+    typedef HostAlignmentBatch::string_type                         string_type;
+    typedef GotohAligner<TYPE,scoring_type>                         ref_aligner_type;
+    typedef GotohAligner<TYPE,scoring_type,DifferenceRecurrenceTag> diff_aligner_type;
+
+    std::vector< BestSink<int32> > sinks[2];
+    sinks[0].resize( batch.n_tasks );
+    sinks[1].resize( batch.n_tasks );
+
+    fprintf(stderr,"    %15s : ", name);
+
+    float times[2];
+    for (uint32 mode = 0; mode < 2; ++mode)
+    {
+        Timer timer;
+        timer.start();
+
+        for (uint32 i = 0; i < batch.n_tasks; ++i)
+        {
+            const string_type pattern = batch.pattern(i);
+            const string_type ref( nvbio::min( pattern.length() + BAND_LEN - 1u, batch.text_lengths[i] ), batch.text + i*batch.N );
+
+            if (quals)
+            {
+                const string_type qual( pattern.length(), quals + i*batch.M );
 
-        cudaDeviceSynchronize();
+                if (mode == 0)
+                    banded_alignment_score<BAND_LEN>( ref_aligner_type( scoring ),  pattern, qual, ref, Field_traits<int32>::min(), sinks[0][i] );
+                else
+                    banded_alignment_score<BAND_LEN>( diff_aligner_type( scoring ), pattern, qual, ref, Field_traits<int32>::min(), sinks[1][i] );
+            }
+            else
+            {
+                if (mode == 0)
+                    banded_alignment_score<BAND_LEN>( ref_aligner_type( scoring ),  pattern, ref, Field_traits<int32>::min(), sinks[0][i] );
+                else
+                    banded_alignment_score<BAND_LEN>( diff_aligner_type( scoring ), pattern, ref, Field_traits<int32>::min(), sinks[1][i] );
+            }
+        }
+
+        timer.stop();
+        times[mode] = timer.seconds();
     }
 
-    timer.stop();
+    uint64 n_cells = 0u;
+    for (uint32 i = 0; i < batch.n_tasks; ++i)
+    {
+        n_cells += uint64( batch.pattern_lengths[i] ) * BAND_LEN;
 
-    return timer.seconds() / float(n_tests);
+        if (sinks[0][i].score  != sinks[1][i].score ||
+            sinks[0][i].sink.x != sinks[1][i].sink.x ||
+            sinks[0][i].sink.y != sinks[1][i].sink.y)
+        {
+            log_error(stderr, "\n    mismatching score for problem %u (%u x %u): expected %d at (%u,%u), got %d at (%u,%u)\n", i,
+                batch.pattern_lengths[i], batch.text_lengths[i],
+                sinks[0][i].score, sinks[0][i].sink.x, sinks[0][i].sink.y,
+                sinks[1][i].score, sinks[1][i].sink.x, sinks[1][i].sink.y );
+            exit(1);
+        }
+    }
+    fprintf(stderr,"  %5.2f (pattern-blocking)  %5.2f (difference) GCUPS\n", 1.0e-9f * float(n_cells)/times[0], 1.0e-9f * float(n_cells)/times[1] );
 }
 
-// execute and time a batch of full DP alignments using BatchAlignmentScore
+// a brute-force banded DP with affine gaps, computing the score the banded kernels report:
+// H[r][j] is the cell at pattern row r and text column r + j, the cells outside the band are -inf,
+// and the columns past the end of the text hold a symbol that matches nothing.
+// Linear gaps are obtained passing the same open and extension penalties.
 //
-template <bool supported, typename scheduler_type, uint32 N, uint32 M, typename stream_type>
-struct batch_score_profile_dispatch
+template <uint32 BAND_LEN, AlignmentType TYPE, typename string_type>
+int32 banded_reference_score(
+    const string_type   pattern,
+    const string_type   text,
+    const int32         match,
+    const int32         mismatch,
+    const int32         top_open,
+    const int32         top_ext,
+    const int32         left_open,
+    const int32         left_ext,
+    const int32         row_zero_open,
+    const int32         row_zero_ext)
 {
-    static void run(
-        const stream_type               stream,
-        const uint32                    n_tests,
-        const uint32                    n_tasks)
-    {}
-};
+    const int32  inf = -(1 << 20);
+    const uint32 m   = pattern.length();
+    const uint32 n   = text.length();
 
-// execute and time a batch of full DP alignments using BatchAlignmentScore
-//
-template <typename scheduler_type, uint32 N, uint32 M, typename stream_type>
-struct batch_score_profile_dispatch<true,scheduler_type,N,M,stream_type>
-{
-    static void run(
-        const stream_type               stream,
-        const uint32                    n_tests,
-        const uint32                    n_tasks)
+    std::vector<int32> H( (m+1) * BAND_LEN, inf );
+    std::vector<int32> F( (m+1) * BAND_LEN, inf );
+
+    H[0] = 0;
+    for (uint32 j = 1; j < BAND_LEN; ++j)
+        H[j] = TYPE == GLOBAL ? row_zero_open + int32(j-1)*row_zero_ext : 0;
+
+    int32 best = 0;
+    for (uint32 r = 1; r <= m; ++r)
     {
-        typedef aln::BatchedAlignmentScore<stream_type, scheduler_type> batch_type;  // our batch type
+        int32 E = inf;
+        for (uint32 j = 0; j < BAND_LEN; ++j)
+        {
+            const uint32 c = r-1 + j;
+            const int32  S = (c < n && text[c] == pattern[r-1]) ? match : mismatch;
 
-        // setup a batch
-        batch_type batch;
+            if (j+1 < BAND_LEN)
+                F[ r*BAND_LEN + j ] = nvbio::max( F[ (r-1)*BAND_LEN + j+1 ] + top_ext, H[ (r-1)*BAND_LEN + j+1 ] + top_open );
 
-        const float time = enact_batch(
-            batch,
-            stream,
-            n_tests,
-            n_tasks );
+            if (j > 0)
+                E = nvbio::max( E + left_ext, H[ r*BAND_LEN + j-1 ] + left_open );
 
-        fprintf(stderr,"  %5.1f", 1.0e-9f * float(n_tasks*uint64(N*M))/time );
+            int32 h = nvbio::max3( H[ (r-1)*BAND_LEN + j ] + S, F[ r*BAND_LEN + j ], E );
+            if (TYPE == LOCAL)
+            {
+                h    = nvbio::max( h, 0 );
+                best = nvbio::max( best, h );
+            }
+            H[ r*BAND_LEN + j ] = h;
+        }
     }
-};
 
-// execute and time a batch of full DP alignments using BatchAlignmentScore
-//
-template <typename scheduler_type, uint32 N, uint32 M, typename stream_type>
-void batch_score_profile(
-    const stream_type               stream,
-    const uint32                    n_tests,
-    const uint32                    n_tasks)
-{
-    NVBIO_VAR_UNUSED const bool is_supported = aln::supports_scheduler<typename stream_type::aligner_type,scheduler_type>::pred;
+    if (TYPE == GLOBAL)
+        return H[ m*BAND_LEN + BAND_LEN-1 ];
+    else if (TYPE == SEMI_GLOBAL)
+    {
+        // only the columns within the text can end a semi-global alignment
+        const uint32 n_end = nvbio::min( m + BAND_LEN - 1u, n ) - (m-1u);
 
-    batch_score_profile_dispatch<is_supported,scheduler_type,N,M,stream_type>::run(
-        stream,
-        n_tests,
-        n_tasks );
+        best = H[ m*BAND_LEN ];
+        for (uint32 j = 1; j < n_end; ++j)
+            best = nvbio::max( best, H[ m*BAND_LEN + j ] );
+    }
+    return best;
 }
 
-// execute and time the batch_score<scheduler> algorithm for all possible schedulers
+// check the banded Gotoh and Smith-Waterman kernels against a brute-force banded DP on texts ending
+// anywhere within the band, so that the band runs past the end of the text by up to BAND_LEN-1 columns:
+// the patterns are rich in T's, which the 2-bit text cache would confuse with the padding past the end
 //
-template <uint32 N, uint32 M, typename aligner_type>
-void batch_score_profile_all(
-    const aligner_type              aligner,
-    const uint32                    n_tests,
-    const uint32                    n_tasks,
-    thrust::device_vector<uint32>&  pattern_dvec,
-    thrust::device_vector<uint32>&  text_dvec,
-    thrust::device_vector<int16>&   score_dvec)
+template <uint32 BAND_LEN, AlignmentType TYPE>
+void host_banded_edge_test(const char* name, LCG_random& rand)
 {
-    {
-        typedef AlignmentStream<aligner_type,M,N> stream_type;
+    typedef nvbio::vector_view<const uint8*>                                string_type;
+    typedef GotohAligner<TYPE,SimpleGotohScheme>                            gotoh_aligner_type;
+    typedef GotohAligner<TYPE,SimpleGotohScheme,DifferenceRecurrenceTag>    diff_aligner_type;
+    typedef SmithWatermanAligner<TYPE,SimpleSmithWatermanScheme>            sw_aligner_type;
 
-        // create a stream
-        stream_type stream(
-            aligner,
-            n_tasks,
-            nvbio::raw_pointer( pattern_dvec ),
-            nvbio::raw_pointer( text_dvec ),
-            nvbio::raw_pointer( score_dvec ) );
+    const SimpleGotohScheme         gotoh( 2, -3, -5, -2 );
+    const SimpleSmithWatermanScheme sw( 2, -1, -2, -3 );
 
-        // test the DeviceThreadScheduler
-        batch_score_profile<DeviceThreadScheduler,N,M>(
-            stream,
-            n_tests,
-            n_tasks );
+    const uint32 pattern_lengths[] = { 1u, 2u, BAND_LEN-1u, BAND_LEN, BAND_LEN+1u, 3u*BAND_LEN };
 
-        // test the DeviceStagedThreadScheduler
-        batch_score_profile<DeviceStagedThreadScheduler,N,M>(
-            stream,
-            n_tests,
-            n_tasks );
-    }
+    fprintf(stderr,"    %15s : ", name);
+
+    uint32 n_problems = 0;
+    for (uint32 l = 0; l < sizeof(pattern_lengths)/sizeof(uint32); ++l)
     {
-        typedef AlignmentStream<aligner_type,M,N,uncached_tag_type> stream_type;
+        const uint32 m = pattern_lengths[l];
 
-        // create a stream
-        stream_type stream(
-            aligner,
-            n_tasks,
-            nvbio::raw_pointer( pattern_dvec ),
-            nvbio::raw_pointer( text_dvec ),
-            nvbio::raw_pointer( score_dvec ) );
+        std::vector<uint8> pattern( m );
+        std::vector<uint8> text( m + BAND_LEN - 1u );
 
-        // test the DeviceWarpScheduler
-        batch_score_profile<DeviceWarpScheduler,N,M>(
-            stream,
-            n_tests,
-            n_tasks );
+        for (uint32 trial = 0; trial < 8; ++trial)
+        {
+            // the first trial aligns a string of T's to itself
+            for (uint32 j = 0; j < m; ++j)
+                pattern[j] = (trial == 0 || ((rand.next() >> 16) & 1u)) ? 3u : uint8( (rand.next() >> 16) % 3u );
+            for (uint32 j = 0; j < text.size(); ++j)
+                text[j] = trial == 0 ? 3u : ((rand.next() >> 16) % 8u == 0) ? uint8( (rand.next() >> 16) & 3u ) : pattern[ j % m ];
+
+            for (uint32 n = m; n <= m + BAND_LEN - 1u; ++n, ++n_problems)
+            {
+                const string_type pattern_string( m, &pattern[0] );
+                const string_type text_string( n, &text[0] );
+
+                const int32 ref_scores[2] = {
+                    banded_reference_score<BAND_LEN,TYPE>( pattern_string, text_string,
+                        gotoh.match(), gotoh.mismatch(),
+                        gotoh.pattern_gap_open(), gotoh.pattern_gap_extension(),
+                        gotoh.pattern_gap_open(), gotoh.pattern_gap_extension(),
+                        gotoh.text_gap_open(),    gotoh.text_gap_extension() ),
+                    banded_reference_score<BAND_LEN,TYPE>( pattern_string, text_string,
+                        sw.match(), sw.mismatch(),
+                        sw.deletion(),  sw.deletion(),
+                        sw.insertion(), sw.insertion(),
+                        sw.deletion(),  sw.deletion() ) };
+
+                BestSink<int32> sinks[3];
+                banded_alignment_score<BAND_LEN>( gotoh_aligner_type( gotoh ), pattern_string, text_string, Field_traits<int32>::min(), sinks[0] );
+                banded_alignment_score<BAND_LEN>( diff_aligner_type( gotoh ),  pattern_string, text_string, Field_traits<int32>::min(), sinks[1] );
+                banded_alignment_score<BAND_LEN>( sw_aligner_type( sw ),       pattern_string, text_string, Field_traits<int32>::min(), sinks[2] );
+
+                const char* impl_names[3] = { "gotoh", "gotoh difference", "sw" };
+                for (uint32 impl = 0; impl < 3; ++impl)
+                {
+                    const int32 ref_score = ref_scores[ impl == 2 ? 1 : 0 ];
+                    if (sinks[impl].score != ref_score)
+                    {
+                        log_error(stderr, "\n    %s: mismatching score for a %u x %u problem: expected %d, got %d\n",
+                            impl_names[impl], m, n, ref_score, sinks[impl].score );
+                        exit(1);
+                    }
+                }
+            }
+        }
     }
+    fprintf(stderr,"  %u problems ok\n", n_problems);
+}
+
+// check the DifferenceRecurrenceTag banded Gotoh implementation against the PatternBlockingTag one
+// on random problems: random pattern lengths and qualities, and texts derived from the patterns
+// spanning either the whole band, only part of it, or less than the pattern itself
+//
+template <uint32 BAND_LEN, AlignmentType TYPE, typename scoring_type>
+void host_banded_diff_random_test(
+    const char*                     name,
+    const scoring_type              scoring,
+    const uint32                    n_tasks,
+    const uint32                    M,
+    LCG_random&                     rand)
+{
+    const uint32 N = M + BAND_LEN - 1u;
+
+    std::vector<uint32> pattern_lengths( n_tasks );
+    std::vector<uint32> text_lengths( n_tasks );
+    std::vector<uint8>  patterns( M * n_tasks );
+    std::vector<uint8>  quals( M * n_tasks );
+    std::vector<uint8>  text( N * n_tasks );
+
+    for (uint32 i = 0; i < n_tasks; ++i)
     {
-        const uint32 BLOCKDIM = 128;
-        const uint32 N_BLOCKS = (n_tasks + BLOCKDIM-1) / BLOCKDIM;
+        const uint32 m = 1u + (rand.next() >> 8) % M;
+        const uint32 n = m + BAND_LEN - 1u;
 
-        Timer timer;
-        timer.start();
+        pattern_lengths[i] = m;
 
-        for (uint32 i = 0; i < n_tests; ++i)
+        for (uint32 j = 0; j < m; ++j)
         {
-            // enact the batch
-            alignment_test_kernel<BLOCKDIM,N> <<<N_BLOCKS,BLOCKDIM>>>(
-                aligner,
-                n_tasks,
-                M,
-                N,
-                nvbio::raw_pointer( pattern_dvec ),
-                nvbio::raw_pointer( text_dvec ),
-                nvbio::raw_pointer( score_dvec ) );
+            patterns[ i*M + j ] = (rand.next() >> 16) & 3u;
+            quals[ i*M + j ]    = (rand.next() >> 16) % 41u;
+        }
 
-            cudaDeviceSynchronize();
+        // derive the text from the pattern with ~10% substitutions and ~5% indels,
+        // and fill the rest of the band randomly
+        uint32 k = 0;
+        for (uint32 j = 0; j < m && k < n; ++j)
+        {
+            const uint32 r = (rand.next() >> 16) % 100u;
+            if (r < 3)
+                continue;
+            if (r < 5)
+                text[ i*N + k++ ] = (rand.next() >> 16) & 3u;
+            if (k < n)
+                text[ i*N + k++ ] = r < 15 ? uint8( (rand.next() >> 16) & 3u ) : patterns[ i*M + j ];
         }
+        for (; k < n; ++k)
+            text[ i*N + k ] = (rand.next() >> 16) & 3u;
+
+        // span the whole band, part of it, or less than the pattern
+        const uint32 r = (rand.next() >> 16) % 4u;
+        text_lengths[i] =
+            r == 0 ? 1u + (rand.next() >> 8) % m :
+            r == 1 ? m  + (rand.next() >> 8) % BAND_LEN :
+                     n;
+    }
 
-        timer.stop();
+    const HostAlignmentBatch batch( n_tasks, M, N, pattern_lengths, text_lengths, patterns, text );
 
-        const float time = timer.seconds();
+    host_banded_diff_test<BAND_LEN,TYPE>( name, scoring, batch, &quals[0] );
+}
 
-        fprintf(stderr,"  %5.1f", 1.0e-9f * float(n_tasks*uint64(N*M))*(float(n_tests)/time) );
-    }
-    fprintf(stderr, " GCUPS\n");
+// check the DifferenceRecurrenceTag banded Gotoh implementation on random problems with a given band,
+// covering both alignment types, scores right at and just past the int8 lane limits, and quality
+// dependent scores
+//
+template <uint32 BAND_LEN>
+void host_banded_diff_random_tests(const uint32 n_tasks, const uint32 M, LCG_random& rand)
+{
+    // 4 * max gap penalty + max score - min score must stay below 127: the limit schemes sit right
+    // below it, while the last one is far enough past it to overflow the lanes if it were not rejected
+    const SimpleGotohScheme plain(2,-3,-5,-2);
+    const SimpleGotohScheme gap_limit(5,-6,-28,-1);
+    const SimpleGotohScheme mismatch_limit(2,-104,-5,-2);
+    const SimpleGotohScheme past_limit(120,-10,-30,-10);
+
+    fprintf(stderr,"    band %u\n", BAND_LEN);
+    host_banded_diff_random_test<BAND_LEN,aln::GLOBAL>(      "global",         plain,                n_tasks, M, rand );
+    host_banded_diff_random_test<BAND_LEN,aln::SEMI_GLOBAL>( "semi-global",    plain,                n_tasks, M, rand );
+    host_banded_diff_random_test<BAND_LEN,aln::GLOBAL>(      "gap limit",      gap_limit,            n_tasks, M, rand );
+    host_banded_diff_random_test<BAND_LEN,aln::SEMI_GLOBAL>( "mismatch limit", mismatch_limit,       n_tasks, M, rand );
+    host_banded_diff_random_test<BAND_LEN,aln::SEMI_GLOBAL>( "past limit",     past_limit,           n_tasks, M, rand );
+    host_banded_diff_random_test<BAND_LEN,aln::GLOBAL>(      "quality",        QualityGotohScheme(), n_tasks, M, rand );
+    host_banded_diff_random_test<BAND_LEN,aln::SEMI_GLOBAL>( "quality",        QualityGotohScheme(), n_tasks, M, rand );
 }
 
 // execute and time a batch of banded alignments using BatchBandedAlignmentScore
@@ -663,6 +2347,10 @@ void test(int argc, char* argv[])
                     TEST_MASK |= GOTOH;
                 else if (strcmp( temp, "gotoh-banded" ) == 0)
                     TEST_MASK |= GOTOH_BANDED;
+                else if (strcmp( temp, "host-simd" ) == 0)
+                    TEST_MASK |= HOST_SIMD;
+                else if (strcmp( temp, "wfa" ) == 0)
+                    TEST_MASK |= WFA;
 
                 if (*end == '\0')
                     break;
@@ -903,6 +2591,342 @@ void test(int argc, char* argv[])
         test.full<BLOCKDIM,N,M>( "semi-global", aligner, "1I1M2I1M3I136M" );
     }
 
+    // check the host inter-sequence SIMD scheduler and the striped algorithm against the scalar code
+    if (TEST_MASK & HOST_SIMD)
+    {
+        const uint32 N_TASKS = 16*1024;
+        const uint32 M = 150;
+        const uint32 N = 200;
+
+        std::vector<uint32> pattern_lengths( N_TASKS );
+        std::vector<uint32> text_lengths( N_TASKS );
+        std::vector<uint8>  patterns( M * N_TASKS );
+        std::vector<uint8>  text( N * N_TASKS );
+
+        LCG_random rand;
+        for (uint32 i = 0; i < N_TASKS; ++i)
+        {
+            // use a mixture of lengths
+            pattern_lengths[i] = 1u + (rand.next() >> 8) % M;
+            text_lengths[i]    = 1u + (rand.next() >> 8) % N;
+        }
+        for (uint32 i = 0; i < M * N_TASKS; ++i)
+            patterns[i] = (rand.next() >> 16) & 3u;
+
+        // derive the texts from the patterns, to get meaningful alignments
+        for (uint32 i = 0; i < N_TASKS; ++i)
+        {
+            for (uint32 j = 0; j < N; ++j)
+            {
+                const uint32 r = (rand.next() >> 12) % 16u;
+                text[ i*N + j ] = (r && j < M) ? patterns[ i*M + j ] : uint8( (rand.next() >> 16) & 3u );
+            }
+        }
+
+        const HostAlignmentBatch batch( N_TASKS, M, N, pattern_lengths, text_lengths, patterns, text );
+
+        fprintf(stderr,"  testing host SIMD Edit Distance scoring...\n");
+        host_simd_test( "global",      make_edit_distance_aligner<aln::GLOBAL>(),      batch );
+        host_simd_test( "semi-global", make_edit_distance_aligner<aln::SEMI_GLOBAL>(), batch );
+        host_simd_test( "local",       make_edit_distance_aligner<aln::LOCAL>(),       batch );
+
+        fprintf(stderr,"  testing host SIMD Smith-Waterman scoring...\n");
+        host_simd_test( "global",      make_smith_waterman_aligner<aln::GLOBAL>( aln::SimpleSmithWatermanScheme(2,-1,-1,-1) ),      batch );
+        host_simd_test( "semi-global", make_smith_waterman_aligner<aln::SEMI_GLOBAL>( aln::SimpleSmithWatermanScheme(2,-1,-1,-1) ), batch );
+        host_simd_test( "local",       make_smith_waterman_aligner<aln::LOCAL>( aln::SimpleSmithWatermanScheme(2,-1,-1,-1) ),       batch );
+
+        fprintf(stderr,"  testing host SIMD Gotoh scoring...\n");
+        host_simd_test( "global",      make_gotoh_aligner<aln::GLOBAL>( aln::SimpleGotohScheme(2,-1,-5,-3) ),      batch );
+        host_simd_test( "semi-global", make_gotoh_aligner<aln::SEMI_GLOBAL>( aln::SimpleGotohScheme(2,-1,-5,-3) ), batch );
+        host_simd_test( "local",       make_gotoh_aligner<aln::LOCAL>( aln::SimpleGotohScheme(2,-1,-5,-3) ),       batch );
+
+        fprintf(stderr,"  testing host SIMD scoring of jobs longer than the declared maxima...\n");
+        host_simd_long_job_test( "ed global",      make_edit_distance_aligner<aln::GLOBAL>(),                               batch );
+        host_simd_long_job_test( "gotoh semi-glob", make_gotoh_aligner<aln::SEMI_GLOBAL>( aln::SimpleGotohScheme(2,-1,-5,-3) ), batch );
+        host_simd_long_job_test( "gotoh local",    make_gotoh_aligner<aln::LOCAL>( aln::SimpleGotohScheme(2,-1,-5,-3) ),       batch );
+
+        fprintf(stderr,"  testing host SIMD lane width escalation...\n");
+        host_simd_overflow_test( "ed global",      make_edit_distance_aligner<aln::GLOBAL>() );
+        host_simd_overflow_test( "sw semi-global", make_smith_waterman_aligner<aln::SEMI_GLOBAL>( aln::SimpleSmithWatermanScheme(2,-1,-1,-1) ) );
+        host_simd_overflow_test( "gotoh global",   make_gotoh_aligner<aln::GLOBAL>( aln::SimpleGotohScheme(60,-1,-5,-3) ) );
+        host_simd_overflow_test( "gotoh local",    make_gotoh_aligner<aln::LOCAL>( aln::SimpleGotohScheme(60,-1,-5,-3) ) );
+
+        fprintf(stderr,"  testing host striped Gotoh scoring...\n");
+        host_striped_test<aln::GLOBAL>(      "global",      aln::SimpleGotohScheme(2,-1,-5,-3), batch );
+        host_striped_test<aln::SEMI_GLOBAL>( "semi-global", aln::SimpleGotohScheme(2,-1,-5,-3), batch );
+        host_striped_test<aln::LOCAL>(       "local",       aln::SimpleGotohScheme(2,-1,-5,-3), batch );
+        host_striped_edge_test<aln::GLOBAL>(      "global",      aln::SimpleGotohScheme(60,-1,-5,-3) );
+        host_striped_edge_test<aln::SEMI_GLOBAL>( "semi-global", aln::SimpleGotohScheme(60,-1,-5,-3) );
+        host_striped_edge_test<aln::LOCAL>(       "local",       aln::SimpleGotohScheme(60,-1,-5,-3) );
+
+        fprintf(stderr,"  testing host Myers Edit Distance scoring...\n");
+        host_myers_test<aln::GLOBAL>(      "global",      batch );
+        host_myers_test<aln::SEMI_GLOBAL>( "semi-global", batch );
+        host_myers_threshold_test<aln::GLOBAL>(      "global k",      batch );
+        host_myers_threshold_test<aln::SEMI_GLOBAL>( "semi-global k", batch );
+
+        fprintf(stderr,"  testing host adaptive banded extension...\n");
+        host_extension_test<16>( "no drop", make_extension_aligner( aln::SimpleGotohScheme(2,-4,-6,-1) ),         batch );
+        host_extension_test<16>( "x-drop",  make_extension_aligner( aln::SimpleGotohScheme(2,-4,-6,-1), 20, -1 ), batch );
+        host_extension_test<32>( "z-drop",  make_extension_aligner( aln::SimpleGotohScheme(2,-4,-6,-1), -1, 40 ), batch );
+        host_extension_band_test<16>( "band 16", aln::SimpleGotohScheme(2,-4,-6,-1) );
+        host_extension_band_test<32>( "band 32", aln::SimpleGotohScheme(2,-4,-6,-1) );
+
+        fprintf(stderr,"  testing host tiled alignment of packed strings...\n");
+        host_tiled_test( "ed semi-global", make_edit_distance_aligner<aln::SEMI_GLOBAL>(),                             batch );
+        host_tiled_test( "sw local",       make_smith_waterman_aligner<aln::LOCAL>( aln::SimpleSmithWatermanScheme(2,-1,-1,-1) ), batch );
+        host_tiled_test( "gotoh global",   make_gotoh_aligner<aln::GLOBAL>( aln::SimpleGotohScheme(2,-1,-5,-3) ),                   batch );
+        host_tiled_unpack_test();
+    }
+
+    // check the score profiles of the SIMD scheduler with a substitution matrix on protein strings
+    if (TEST_MASK & HOST_SIMD)
+    {
+        const uint32 N_TASKS = 4*1024;
+        const uint32 M = 300;
+        const uint32 N = 400;
+        const uint32 SYMBOLS = AlphabetTraits<PROTEIN>::SYMBOL_COUNT;
+
+        std::vector<uint32> pattern_lengths( N_TASKS );
+        std::vector<uint32> text_lengths( N_TASKS );
+        std::vector<uint8>  patterns( M * N_TASKS );
+        std::vector<uint8>  text( N * N_TASKS );
+
+        LCG_random rand;
+        for (uint32 i = 0; i < N_TASKS; ++i)
+        {
+            pattern_lengths[i] = 1u + (rand.next() >> 8) % M;
+            text_lengths[i]    = 1u + (rand.next() >> 8) % N;
+        }
+        for (uint32 i = 0; i < M * N_TASKS; ++i)
+            patterns[i] = uint8( (rand.next() >> 16) % SYMBOLS );
+
+        // derive the texts from the patterns, with ~25% substitutions
+        for (uint32 i = 0; i < N_TASKS; ++i)
+        {
+            for (uint32 j = 0; j < N; ++j)
+            {
+                const uint32 r = (rand.next() >> 12) % 4u;
+                text[ i*N + j ] = (r && j < M) ? patterns[ i*M + j ] : uint8( (rand.next() >> 16) % SYMBOLS );
+            }
+        }
+
+        const aln::MatrixGotohScheme blosum62( aln::blosum62_matrix(), -11, -1 );
+        const HostAlignmentBatch     batch( N_TASKS, M, N, pattern_lengths, text_lengths, patterns, text );
+
+        fprintf(stderr,"  testing host SIMD protein scoring...\n");
+        host_simd_test( "global",      make_gotoh_aligner<aln::GLOBAL>( blosum62 ),      batch );
+        host_simd_test( "semi-global", make_gotoh_aligner<aln::SEMI_GLOBAL>( blosum62 ), batch );
+        host_simd_test( "local",       make_gotoh_aligner<aln::LOCAL>( blosum62 ),       batch );
+
+        // search a single query against all the patterns, so that all lanes share the text symbols
+        for (uint32 i = 0; i < N_TASKS; ++i)
+        {
+            text_lengths[i] = N;
+            for (uint32 j = 0; j < N; ++j)
+                text[ i*N + j ] = text[j];
+        }
+
+        host_simd_test( "local search", make_gotoh_aligner<aln::LOCAL>( blosum62 ),      batch );
+    }
+
+    // check the multi-word Myers algorithm on long patterns
+    if (TEST_MASK & HOST_SIMD)
+    {
+        const uint32 N_TASKS = 128;
+        const uint32 M = 4000;
+        const uint32 N = 4500;
+
+        std::vector<uint32> pattern_lengths( N_TASKS );
+        std::vector<uint32> text_lengths( N_TASKS );
+        std::vector<uint8>  patterns( M * N_TASKS );
+        std::vector<uint8>  text( N * N_TASKS );
+
+        LCG_random rand;
+        for (uint32 i = 0; i < N_TASKS; ++i)
+        {
+            pattern_lengths[i] = 1u + (rand.next() >> 8) % M;
+            text_lengths[i]    = pattern_lengths[i] + (rand.next() >> 8) % (N - M);
+        }
+        for (uint32 i = 0; i < M * N_TASKS; ++i)
+            patterns[i] = (rand.next() >> 16) & 3u;
+
+        for (uint32 i = 0; i < N_TASKS; ++i)
+        {
+            for (uint32 j = 0; j < N; ++j)
+            {
+                const uint32 r = (rand.next() >> 12) % 16u;
+                text[ i*N + j ] = (r && j < M) ? patterns[ i*M + j ] : uint8( (rand.next() >> 16) & 3u );
+            }
+        }
+
+        const HostAlignmentBatch batch( N_TASKS, M, N, pattern_lengths, text_lengths, patterns, text );
+
+        fprintf(stderr,"  testing host Myers Edit Distance scoring on long patterns...\n");
+        host_myers_test<aln::GLOBAL>(      "global",      batch );
+        host_myers_test<aln::SEMI_GLOBAL>( "semi-global", batch );
+        host_myers_threshold_test<aln::GLOBAL>(      "global k",      batch );
+        host_myers_threshold_test<aln::SEMI_GLOBAL>( "semi-global k", batch );
+
+        const uint32 N_TRACEBACK_TASKS = 16;
+
+        const HostAlignmentBatch traceback_batch( N_TRACEBACK_TASKS, M, N, pattern_lengths, text_lengths, patterns, text );
+
+        fprintf(stderr,"  testing host two-level checkpoint traceback on long patterns...\n");
+        host_traceback_test<32>( "ed semi-global",    make_edit_distance_aligner<aln::SEMI_GLOBAL>(),                                traceback_batch );
+        host_traceback_test<32>( "sw local",          make_smith_waterman_aligner<aln::LOCAL>( SimpleSmithWatermanScheme(2,-1,-1,-1) ), traceback_batch );
+        host_traceback_test<16>( "gotoh global",      make_gotoh_aligner<aln::GLOBAL>( SimpleGotohScheme(2,-3,-5,-2) ),                 traceback_batch );
+
+        // use lengths one below, at and one above 16 * k^2, i.e. at the boundaries of both the
+        // checkpoints and of the groups of the two-level scheme, for all k in [1,8]
+        const uint32 N_BOUNDARY_TASKS = 48;
+
+        std::vector<uint32> boundary_pattern_lengths( N_BOUNDARY_TASKS );
+        std::vector<uint32> boundary_text_lengths( N_BOUNDARY_TASKS );
+        for (uint32 i = 0; i < N_BOUNDARY_TASKS; ++i)
+        {
+            const uint32 k = 1u + i / 6u;
+            const uint32 d = i % 3u;
+
+            boundary_pattern_lengths[i] = 16u * k * k + d - 1u;
+            boundary_text_lengths[i]    = boundary_pattern_lengths[i] + (i % 6u < 3u ? 0u : 32u);
+        }
+
+        const HostAlignmentBatch boundary_batch( N_BOUNDARY_TASKS, M, N, boundary_pattern_lengths, boundary_text_lengths, patterns, text );
+
+        fprintf(stderr,"  testing host two-level checkpoint traceback at the checkpoint boundaries...\n");
+        host_traceback_test<32>( "ed semi-global",    make_edit_distance_aligner<aln::SEMI_GLOBAL>(),                                boundary_batch );
+        host_traceback_test<32>( "sw local",          make_smith_waterman_aligner<aln::LOCAL>( SimpleSmithWatermanScheme(2,-1,-1,-1) ), boundary_batch );
+        host_traceback_test<16>( "gotoh global",      make_gotoh_aligner<aln::GLOBAL>( SimpleGotohScheme(2,-3,-5,-2) ),                 boundary_batch );
+
+        fprintf(stderr,"  testing host banded Gotoh difference recurrences on long patterns...\n");
+        host_banded_diff_test<64,aln::GLOBAL>(       "global",      SimpleGotohScheme(2,-3,-5,-2),  batch );
+        host_banded_diff_test<64,aln::SEMI_GLOBAL>(  "semi-global", SimpleGotohScheme(2,-3,-5,-2),  batch );
+        host_banded_diff_test<256,aln::SEMI_GLOBAL>( "wide band",   SimpleGotohScheme(5,-4,-12,-3), batch );
+    }
+
+    // check the banded Gotoh difference recurrences on random problems, from bands too narrow for the
+    // int8 lanes to bands much wider than the patterns
+    if (TEST_MASK & HOST_SIMD)
+    {
+        LCG_random rand;
+
+        fprintf(stderr,"  testing host banded Gotoh difference recurrences on random problems...\n");
+        host_banded_diff_random_tests<2>(    2048, 100,  rand );
+        host_banded_diff_random_tests<15>(   2048, 200,  rand );
+        host_banded_diff_random_tests<16>(   2048, 200,  rand );
+        host_banded_diff_random_tests<17>(   2048, 200,  rand );
+        host_banded_diff_random_tests<64>(   1024, 500,  rand );
+        host_banded_diff_random_tests<100>(  1024, 500,  rand );
+        host_banded_diff_random_tests<256>(  256,  1000, rand );
+        host_banded_diff_random_tests<1024>( 64,   1000, rand );
+        host_banded_diff_random_tests<2048>( 32,   2000, rand );
+
+        fprintf(stderr,"  testing host banded kernels on texts ending within the band...\n");
+        host_banded_edge_test<16,aln::GLOBAL>(      "band 16 global",      rand );
+        host_banded_edge_test<16,aln::SEMI_GLOBAL>( "band 16 semi-global", rand );
+        host_banded_edge_test<16,aln::LOCAL>(       "band 16 local",       rand );
+        host_banded_edge_test<31,aln::GLOBAL>(      "band 31 global",      rand );
+        host_banded_edge_test<31,aln::SEMI_GLOBAL>( "band 31 semi-global", rand );
+        host_banded_edge_test<31,aln::LOCAL>(       "band 31 local",       rand );
+    }
+
+    // check the wavefront aligner against the Gotoh one on realistic error profiles
+    if (TEST_MASK & WFA)
+    {
+        std::vector<uint32> pattern_lengths;
+        std::vector<uint32> text_lengths;
+        std::vector<uint8>  patterns;
+        std::vector<uint8>  text;
+
+        // short reads, with ~1% substitutions and ~0.1% indels
+        {
+            const uint32 N_TASKS = 16*1024;
+            const uint32 M       = 150;
+            const uint32 FLANK   = 20;
+
+            generate_error_profile_batch( N_TASKS, M, 0u, 0.01f, 0.001f, pattern_lengths, text_lengths, patterns, text );
+
+            fprintf(stderr,"  testing host wavefront alignment on short reads...\n");
+            host_wavefront_test<aln::GLOBAL>( "global", SimpleGotohScheme(2,-4,-6,-2), HostAlignmentBatch( N_TASKS, M, 2u * M, pattern_lengths, text_lengths, patterns, text ) );
+
+            generate_error_profile_batch( N_TASKS, M, FLANK, 0.01f, 0.001f, pattern_lengths, text_lengths, patterns, text );
+
+            host_wavefront_test<aln::SEMI_GLOBAL>( "semi-global", SimpleGotohScheme(0,-6,-8,-3), HostAlignmentBatch( N_TASKS, M, 2u * (M + FLANK), pattern_lengths, text_lengths, patterns, text ) );
+        }
+        // the score threshold, on short reads with ~5% substitutions and ~1% indels
+        {
+            const uint32 N_TASKS = 1024;
+            const uint32 M       = 150;
+            const uint32 FLANK   = 20;
+
+            generate_error_profile_batch( N_TASKS, M, 0u, 0.05f, 0.01f, pattern_lengths, text_lengths, patterns, text );
+
+            fprintf(stderr,"  testing host wavefront alignment score thresholds...\n");
+            host_wavefront_threshold_test<aln::GLOBAL>( "global", SimpleGotohScheme(2,-4,-6,-2), HostAlignmentBatch( N_TASKS, M, 2u * M, pattern_lengths, text_lengths, patterns, text ) );
+
+            generate_error_profile_batch( N_TASKS, M, FLANK, 0.05f, 0.01f, pattern_lengths, text_lengths, patterns, text );
+
+            host_wavefront_threshold_test<aln::SEMI_GLOBAL>( "semi-global", SimpleGotohScheme(0,-6,-8,-3), HostAlignmentBatch( N_TASKS, M, 2u * (M + FLANK), pattern_lengths, text_lengths, patterns, text ) );
+        }
+        // short reads holding N's, replacing ~2% of the pattern and text symbols
+        {
+            const uint32 N_TASKS = 1024;
+            const uint32 M       = 150;
+            const uint32 FLANK   = 20;
+
+            LCG_random rand;
+
+            fprintf(stderr,"  testing host wavefront alignment on strings holding N's...\n");
+            for (uint32 type = 0; type < 2; ++type)
+            {
+                const uint32 flank = type ? FLANK : 0u;
+                const uint32 N     = 2u * (M + flank);
+
+                generate_error_profile_batch( N_TASKS, M, flank, 0.01f, 0.001f, pattern_lengths, text_lengths, patterns, text );
+
+                for (uint32 i = 0; i < N_TASKS * M; ++i)
+                {
+                    if ((rand.next() >> 16) % 50u == 0)
+                        patterns[i] = 4u;
+                }
+                for (uint32 i = 0; i < N_TASKS * N; ++i)
+                {
+                    if ((rand.next() >> 16) % 50u == 0)
+                        text[i] = 4u;
+                }
+
+                const HostAlignmentBatch batch( N_TASKS, M, N, pattern_lengths, text_lengths, patterns, text );
+
+                if (type == 0)
+                {
+                    host_wavefront_alphabet_test<aln::GLOBAL>( "global",          SimpleGotohScheme(2,-4,-6,-2),    batch );
+                    host_wavefront_alphabet_test<aln::GLOBAL>( "global N mm",     NMismatchGotohScheme(2,-4,-6,-2), batch );
+                }
+                else
+                {
+                    host_wavefront_alphabet_test<aln::SEMI_GLOBAL>( "semi-global",      SimpleGotohScheme(0,-6,-8,-3),    batch );
+                    host_wavefront_alphabet_test<aln::SEMI_GLOBAL>( "semi-global N mm", NMismatchGotohScheme(0,-6,-8,-3), batch );
+                }
+            }
+        }
+        // long reads, with ~3% substitutions and ~2% indels
+        {
+            const uint32 N_TASKS = 64;
+            const uint32 M       = 2000;
+            const uint32 FLANK   = 50;
+
+            generate_error_profile_batch( N_TASKS, M, 0u, 0.03f, 0.02f, pattern_lengths, text_lengths, patterns, text );
+
+            fprintf(stderr,"  testing host wavefront alignment on long reads...\n");
+            host_wavefront_test<aln::GLOBAL>( "global", SimpleGotohScheme(2,-4,-6,-2), HostAlignmentBatch( N_TASKS, M, 2u * M, pattern_lengths, text_lengths, patterns, text ) );
+
+            generate_error_profile_batch( N_TASKS, M, FLANK, 0.03f, 0.02f, pattern_lengths, text_lengths, patterns, text );
+
+            host_wavefront_test<aln::SEMI_GLOBAL>( "semi-global", SimpleGotohScheme(0,-6,-8,-3), HostAlignmentBatch( N_TASKS, M, 2u * (M + FLANK), pattern_lengths, text_lengths, patterns, text ) );
+        }
+    }
+
     // do a larger speed test of the Gotoh alignment
     if (TEST_MASK & (ED | SW | GOTOH))
     {
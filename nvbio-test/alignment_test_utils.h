@@ -64,6 +64,8 @@ enum AlignmentTest
     SW_WARP             = 64u,
     SW_STRIPED          = 128u,
     FUNCTIONAL          = 256u,
+    HOST_SIMD           = 512u,
+    WFA                 = 1024u,
 };
 
 // make a light-weight string from an ASCII char string
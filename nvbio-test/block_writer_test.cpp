@@ -0,0 +1,252 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// block_writer_test.cpp
+//
+
+#include <nvbio/sufsort/file_bwt_block_writer.h>
+#include <nvbio/basic/console.h>
+#include <nvbio/basic/exceptions.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+namespace nvbio {
+
+namespace {
+
+// a compressor which halves even-sized blocks by dropping every other byte, and leaves
+// odd-sized ones uncompressed
+//
+struct HalvingCompressor : public BlockCompressor
+{
+    uint32 compress(const uint8* src, uint8* dst, const uint32 n_bytes) const
+    {
+        if (n_bytes & 1u)
+            return 0u;
+
+        for (uint32 i = 0; i < n_bytes/2; ++i)
+            dst[i] = src[2*i];
+
+        return n_bytes/2;
+    }
+};
+
+// read back a file written by a ParallelBlockWriter and check it against the original blocks
+//
+bool check_blocks(const char* file_name, const std::vector<uint8>& data, const std::vector<uint32>& sizes)
+{
+    FILE* file = fopen( file_name, "rb" );
+    if (file == NULL)
+    {
+        log_error(stderr,"  failed reopening %s\n", file_name);
+        return false;
+    }
+
+    std::vector<uint8> out;
+    {
+        uint8  buffer[4096];
+        size_t n;
+        while ((n = fread( buffer, 1u, sizeof(buffer), file )) > 0)
+            out.insert( out.end(), buffer, buffer + n );
+    }
+    fclose( file );
+
+    uint64 offset      = 0;
+    uint64 data_offset = 0;
+    for (uint32 i = 0; i < sizes.size(); ++i)
+    {
+        const uint32 n_bytes = sizes[i];
+
+        uint32 header;
+        if (offset + sizeof(uint32) > out.size())
+        {
+            log_error(stderr,"  block writer: file ends before block %u\n", i);
+            return false;
+        }
+        memcpy( &header, &out[offset], sizeof(uint32) ); // the tests only run on little-endian hosts
+        offset += sizeof(uint32);
+
+        // odd blocks must have been left uncompressed, even ones halved
+        const bool   raw       = (n_bytes & 1u) != 0;
+        const uint32 out_bytes = raw ? n_bytes : n_bytes/2;
+        if (header != (raw ? (n_bytes | ParallelBlockWriter::UNCOMPRESSED_FLAG) : out_bytes) ||
+            offset + out_bytes > out.size())
+        {
+            log_error(stderr,"  block writer: bad header %08x for block %u (%u bytes)\n", header, i, n_bytes);
+            return false;
+        }
+        for (uint32 j = 0; j < out_bytes; ++j)
+        {
+            if (out[offset + j] != data[data_offset + (raw ? j : 2*j)])
+            {
+                log_error(stderr,"  block writer: block %u differs at byte %u\n", i, j);
+                return false;
+            }
+        }
+        offset      += out_bytes;
+        data_offset += n_bytes;
+    }
+    if (offset != out.size())
+    {
+        log_error(stderr,"  block writer: %llu trailing bytes\n", uint64( out.size() ) - offset);
+        return false;
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+int block_writer_test()
+{
+    log_info(stderr,"testing block writer... started\n");
+
+    // in NOTHREADS builds this exercises the synchronous path, where write() compresses
+    // and writes each block out itself
+    log_info(stderr,"  %s mode\n", threads_enabled() ? "threaded" : "synchronous");
+
+    const char*  file_name  = "block_writer_test.bin";
+    const uint32 BLOCK_SIZE = 1000;
+
+    HalvingCompressor compressor;
+
+    // random blocks of random sizes, with a budget of only a few slots so that write()
+    // has to wait for the output
+    {
+        FILE* file = fopen( file_name, "wb" );
+        if (file == NULL)
+        {
+            log_error(stderr,"  failed opening %s\n", file_name);
+            return 0;
+        }
+
+        std::vector<uint8>  data;
+        std::vector<uint32> sizes;
+
+        ParallelBlockWriter writer;
+        writer.open( file, &compressor, BLOCK_SIZE, 3u, 8u * BLOCK_SIZE );
+
+        srand(0);
+        std::vector<uint8> block( BLOCK_SIZE );
+        for (uint32 i = 0; i < 2000; ++i)
+        {
+            const uint32 n_bytes = 1u + (rand() % BLOCK_SIZE);
+            for (uint32 j = 0; j < n_bytes; ++j)
+                block[j] = uint8( rand() );
+
+            if (writer.write( n_bytes, &block[0] ) == false)
+            {
+                log_error(stderr,"  block writer: write of block %u failed\n", i);
+                return 0;
+            }
+            data.insert( data.end(), block.begin(), block.begin() + n_bytes );
+            sizes.push_back( n_bytes );
+        }
+
+        // empty blocks are skipped altogether
+        if (writer.write( 0u, &block[0] ) == false)
+        {
+            log_error(stderr,"  block writer: write of an empty block failed\n");
+            return 0;
+        }
+
+        // blocks larger than the session's block size must be rejected
+        bool rejected = false;
+        try
+        {
+            std::vector<uint8> oversized( BLOCK_SIZE + 1u );
+            writer.write( BLOCK_SIZE + 1u, &oversized[0] );
+        }
+        catch (nvbio::runtime_error&)
+        {
+            rejected = true;
+        }
+        if (rejected == false)
+        {
+            log_error(stderr,"  block writer: accepted a block larger than %u bytes\n", BLOCK_SIZE);
+            return 0;
+        }
+
+        if (writer.close() == false)
+        {
+            log_error(stderr,"  block writer: close failed\n");
+            return 0;
+        }
+        fclose( file );
+
+        if (check_blocks( file_name, data, sizes ) == false)
+            return 0;
+    }
+
+    // write errors must be reported by write() or at the latest by close(): use a stream
+    // opened for reading only, on which every fwrite() fails
+    {
+        FILE* file = fopen( file_name, "rb" );
+        if (file == NULL)
+        {
+            log_error(stderr,"  failed reopening %s\n", file_name);
+            return 0;
+        }
+
+        ParallelBlockWriter writer;
+        writer.open( file, &compressor, BLOCK_SIZE, 2u, 8u * BLOCK_SIZE );
+
+        std::vector<uint8> block( BLOCK_SIZE, 1u );
+
+        // once a failure has been seen, it must stick
+        bool failed = false;
+        for (uint32 i = 0; i < 100; ++i)
+        {
+            const bool written = writer.write( BLOCK_SIZE, &block[0] );
+            if (failed && written)
+            {
+                log_error(stderr,"  block writer: write %u succeeded after a failure\n", i);
+                return 0;
+            }
+            failed = failed || (written == false);
+        }
+        // the synchronous path must report the error right away
+        if (threads_enabled() == false && failed == false)
+        {
+            log_error(stderr,"  block writer: synchronous write errors not reported by write()\n");
+            return 0;
+        }
+        if (writer.close())
+        {
+            log_error(stderr,"  block writer: close did not report the write errors\n");
+            return 0;
+        }
+        fclose( file );
+    }
+    remove( file_name );
+
+    log_info(stderr,"testing block writer... done\n");
+    return 1;
+}
+
+} // namespace nvbio
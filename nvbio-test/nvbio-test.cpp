@@ -58,6 +58,7 @@ int qgram_test(int argc, char* argv[]);
 int sequence_test(int argc, char* argv[]);
 int wavelet_test(int argc, char* argv[]);
 int bloom_filter_test(int argc, char* argv[]);
+int block_writer_test();
 
 namespace cuda { void scan_test(); }
 namespace aln { void test(int argc, char* argv[]); }
@@ -86,6 +87,7 @@ enum Tests {
     kSequence       = 131072u,
     kWaveletTree    = 262144u,
     kBloomFilter    = 524288u,
+    kBlockWriter    = 1048576u,
     kALL            = 0xFFFFFFFFu
 };
 
@@ -151,6 +153,8 @@ int main(int argc, char* argv[])
                     tests = kWaveletTree;
                 else if (strcmp( argv[arg], "-bloom-filter" ) == 0)
                     tests = kBloomFilter;
+                else if (strcmp( argv[arg], "-block-writer" ) == 0)
+                    tests = kBlockWriter;
 
                 ++arg;
             }
@@ -216,6 +220,7 @@ int main(int argc, char* argv[])
         if (tests & kSequence)      sequence_test( argc, argv+arg );
         if (tests & kWaveletTree)   wavelet_test( argc, argv+arg );
         if (tests & kBloomFilter)   bloom_filter_test( argc, argv+arg );
+        if (tests & kBlockWriter)   block_writer_test();
 
         cudaDeviceReset();
     	return 0;
@@ -48,6 +48,9 @@
 #include <nvbio/basic/deinterleaved_iterator.h>
 #include <nvbio/fmindex/bwt.h>
 #include <nvbio/fmindex/rank_dictionary.h>
+#include <nvbio/fmindex/rl_rank_dictionary.h>
+#include <nvbio/fmindex/fmindex.h>
+#include <nvbio/fmindex/backtrack.h>
 
 namespace nvbio {
 namespace { // anonymous namespace
@@ -234,6 +237,179 @@ void synthetic_test(const uint32 LEN)
     }
 }
 
+void rl_test(const uint32 LEN)
+{
+    fprintf(stderr, "  run-length test\n");
+
+    // build a highly repetitive text, made of long runs
+    thrust::host_vector<uint8> text( LEN );
+    for (uint32 i = 0; i < LEN;)
+    {
+        const uint8  c = uint8( rand() % 4 );
+        const uint32 l = nvbio::min( uint32( 1 + rand() % 64 ), LEN - i );
+
+        for (uint32 j = 0; j < l; ++j)
+            text[i+j] = c;
+
+        i += l;
+    }
+
+    RLRankDictionaryStorage<host_tag,2u,uint32> dict_storage;
+    setup_rl_rank_dictionary( LEN, text.begin(), dict_storage );
+
+    fprintf(stderr, "    runs    : %u\n", dict_storage.n_runs());
+    fprintf(stderr, "    memory  : %.1f MB\n", float(dict_storage.bytes())/float(1024*1024));
+
+    const RLRankDictionaryStorage<host_tag,2u,uint32>::const_plain_view_type dict = plain_view( (const RLRankDictionaryStorage<host_tag,2u,uint32>&)dict_storage );
+
+    do_test( LEN, dict );
+
+    // the empty prefix [0,-1] must contain no symbols
+    const uint4 r4 = rank4( dict, uint32(-1) );
+    if (r4.x || r4.y || r4.z || r4.w ||
+        rank( dict, uint32(-1), 0u ) || rank( dict, uint32(-1), 3u ))
+    {
+        log_error(stderr, "  rank mismatch at [-1]: expected no occurrences\n");
+        exit(1);
+    }
+}
+
+struct ssa_nop {};
+
+// A backtracking delegate counting the total number of occurrences
+//
+struct CountDelegate
+{
+    CountDelegate(uint32* count) : m_count( count ) {}
+
+    void operator() (const uint2 range) const { *m_count += range.y + 1u - range.x; }
+
+    uint32* m_count;
+};
+
+// count the occurrences of a pattern in a text by brute force, allowing up to
+// the given number of mismatches outside of its last seed characters
+//
+uint32 count_occurrences(
+    const uint32    text_len,
+    const uint8*    text,
+    const uint8*    pattern,
+    const uint32    len,
+    const uint32    seed,
+    const uint32    mismatches)
+{
+    uint32 count = 0;
+    for (uint32 p = 0; p + len <= text_len; ++p)
+    {
+        uint32 m = 0;
+        for (uint32 j = 0; j < len && m <= mismatches; ++j)
+        {
+            if (text[p+j] != pattern[j])
+                m += (j < len - seed) ? 1u : mismatches+1u;
+        }
+        if (m <= mismatches)
+            ++count;
+    }
+    return count;
+}
+
+void rl_fmindex_test(const uint32 LEN)
+{
+    fprintf(stderr, "  run-length FM-index test\n");
+
+    // build a repetitive text, made of many copies of a few short motifs
+    // with sparse mutations, so as to produce a BWT with long runs
+    thrust::host_vector<uint8> motifs( 4*64 );
+    for (uint32 i = 0; i < motifs.size(); ++i)
+        motifs[i] = uint8( rand() % 4 );
+
+    thrust::host_vector<uint8> text( LEN );
+    for (uint32 i = 0; i < LEN;)
+    {
+        const uint8* motif = &motifs[ (rand() % 4) * 64 ];
+        for (uint32 j = 0; j < 64 && i < LEN; ++j, ++i)
+            text[i] = (rand() % 100) ? motif[j] : uint8( rand() % 4 );
+    }
+
+    // build its BWT, dropping the $ symbol
+    std::vector<int32> sa( LEN+1, 0u );
+    gen_sa( LEN, &text[0], &sa[0] );
+
+    thrust::host_vector<uint8> bwt( LEN+1 );
+    const uint32 primary = gen_bwt_from_sa( LEN, &text[0], &sa[0], &bwt[0] );
+
+    RLRankDictionaryStorage<host_tag,2u,uint32> dict_storage;
+    setup_rl_rank_dictionary( LEN, bwt.begin(), dict_storage );
+
+    fprintf(stderr, "    runs    : %u\n", dict_storage.n_runs());
+
+    typedef RLRankDictionaryStorage<host_tag,2u,uint32>::const_plain_view_type rank_dict_type;
+    const rank_dict_type dict = plain_view( (const RLRankDictionaryStorage<host_tag,2u,uint32>&)dict_storage );
+
+    // build the L2 table
+    uint32 L2[5];
+    L2[0] = 0;
+    for (uint32 c = 0; c < 4; ++c)
+        L2[c+1] = L2[c] + dict.count(c);
+
+    typedef fm_index<rank_dict_type, ssa_nop> fm_index_type;
+    const fm_index_type fmi(
+        LEN,
+        primary,
+        L2,
+        dict,
+        ssa_nop() );
+
+    const uint32 n_queries  = 1000;
+    const uint32 len        = 24;
+    const uint32 seed       = 8;
+
+    uint4 stack[32*4];
+
+    for (uint32 q = 0; q < n_queries; ++q)
+    {
+        // pick a pattern from the text and mutate it
+        uint8 pattern[len];
+        const uint32 p = rand() % (LEN - len);
+        for (uint32 j = 0; j < len; ++j)
+            pattern[j] = (rand() % 16) ? text[p+j] : uint8( rand() % 4 );
+
+        // exact matching
+        {
+            const uint2 range = match( fmi, pattern, len );
+
+            const uint32 n_occ = range.x <= range.y ? range.y + 1u - range.x : 0u;
+            const uint32 r_occ = count_occurrences( LEN, &text[0], pattern, len, 0u, 0u );
+            if (n_occ != r_occ)
+            {
+                log_error(stderr, "  match mismatch at query %u: expected %u occurrences, got %u\n", q, r_occ, n_occ);
+                exit(1);
+            }
+        }
+        // backtracking
+        {
+            uint32 n_occ = 0;
+            CountDelegate counter( &n_occ );
+
+            hamming_backtrack(
+                fmi,
+                pattern,
+                len,
+                seed,
+                2u,
+                stack,
+                counter );
+
+            const uint32 r_occ = count_occurrences( LEN, &text[0], pattern, len, seed, 2u );
+            if (n_occ != r_occ)
+            {
+                log_error(stderr, "  backtrack mismatch at query %u: expected %u occurrences, got %u\n", q, r_occ, n_occ);
+                exit(1);
+            }
+        }
+    }
+}
+
 } // anonymous namespace
 
 int rank_test(int argc, char* argv[])
@@ -249,6 +425,8 @@ int rank_test(int argc, char* argv[])
     fprintf(stderr, "rank test... started\n");
 
     synthetic_test( len );
+    rl_test( len );
+    rl_fmindex_test( nvbio::min( len, 100000u ) );
 
     fprintf(stderr, "rank test... done\n");
     return 0;
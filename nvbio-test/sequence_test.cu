@@ -36,14 +36,511 @@
 #include <nvbio/basic/console.h>
 #include <nvbio/basic/dna.h>
 #include <nvbio/io/sequence/sequence.h>
+#include <nvbio/io/sequence/sequence_access.h>
+#include <nvbio/io/sequence/sequence_encoder.h>
 #include <nvbio/io/sequence/sequence_mmap.h>
+#include <nvbio/io/sequence/sequence_async.h>
+#include <nvbio/io/sequence/sequence_parallel.h>
+#include <nvbio/io/parallel_gzip_reader.h>
+#include <zlib/zlib.h>
+#if defined(NVBIO_CRAM)
+#include <htslib/sam.h>
+#include <htslib/faidx.h>
+#endif
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <string>
 
 using namespace nvbio;
 
 namespace nvbio {
 
+namespace { // anonymous namespace
+
+// check whether a stream has been opened successfully, logging an error otherwise
+//
+template <typename stream_type>
+bool is_open(const SharedPointer<stream_type>& file, const char* file_name)
+{
+    if (file == NULL || file->is_ok() == false)
+    {
+        log_error(stderr,"  failed opening reads file %s\n", file_name);
+        return false;
+    }
+    return true;
+}
+
+// check whether two sets of reads match base by base, logging the first mismatch
+//
+// \param data1        the first set of reads
+// \param data2        the second set of reads
+// \param what         the name of the tested component
+// \param file_name    the name of the file the reads come from
+// \param offset       the index of the first read in the file
+// \param names        whether to compare the read names as well
+//
+bool match_reads(
+    const io::SequenceDataHost& data1,
+    const io::SequenceDataHost& data2,
+    const char*                 what,
+    const char*                 file_name,
+    const uint64                offset = 0,
+    const bool                  names  = false)
+{
+    if (static_cast<const io::SequenceDataInfo&>( data1 ) !=
+        static_cast<const io::SequenceDataInfo&>( data2 ))
+    {
+        log_error(stderr,"  %s mismatch at read %llu of file %s: (%u reads, %u bps) vs (%u reads, %u bps)\n",
+            what, offset, file_name,
+            data1.size(), data1.bps(),
+            data2.size(), data2.bps());
+        return false;
+    }
+
+    const io::SequenceDataAccess<DNA_N> access1( data1 );
+    const io::SequenceDataAccess<DNA_N> access2( data2 );
+
+    for (uint32 i = 0; i < data1.size(); ++i)
+    {
+        const io::SequenceDataAccess<DNA_N>::sequence_string read1 = access1.get_read(i);
+        const io::SequenceDataAccess<DNA_N>::sequence_string read2 = access2.get_read(i);
+        const io::SequenceDataAccess<DNA_N>::qual_string     qual1 = access1.get_quals(i);
+        const io::SequenceDataAccess<DNA_N>::qual_string     qual2 = access2.get_quals(i);
+
+        bool match = read1.length() == read2.length();
+
+        for (uint32 j = 0; j < read1.length() && match; ++j)
+            match = read1[j] == read2[j] && qual1[j] == qual2[j];
+
+        if (match && names)
+        {
+            const io::SequenceDataAccess<DNA_N>::name_string name1 = access1.get_name(i);
+            const io::SequenceDataAccess<DNA_N>::name_string name2 = access2.get_name(i);
+
+            match = name1.length() == name2.length() &&
+                    strncmp( name1.begin(), name2.begin(), name1.length() ) == 0;
+        }
+
+        if (match == false)
+        {
+            log_error(stderr,"  %s mismatch at read %llu of file %s\n", what, offset + i, file_name);
+            return false;
+        }
+    }
+    return true;
+}
+
+// read two streams in lockstep, batching the reference stream like the tested one,
+// and check they match
+//
+bool match_streams(
+    io::SequenceDataStream*     ref_file,
+    io::SequenceDataStream*     file,
+    const uint32                batch_size,
+    const char*                 what,
+    const char*                 file_name)
+{
+    io::SequenceDataHost ref_data;
+    io::SequenceDataHost data;
+
+    uint64 n_reads = 0;
+    while (io::next( DNA_N, &data, file, batch_size ))
+    {
+        io::next( DNA_N, &ref_data, ref_file, data.size() );
+
+        if (match_reads( ref_data, data, what, file_name, n_reads, true ) == false)
+            return false;
+
+        n_reads += data.size();
+    }
+
+    if (file->is_ok() == false || io::next( DNA_N, &ref_data, ref_file, 1u ))
+    {
+        log_error(stderr,"  %s stopped early at read %llu of file %s\n", what, n_reads, file_name);
+        return false;
+    }
+    return true;
+}
+
+// read a paired stream in lockstep with two single-end streams of its first and second mates,
+// and check they match, names included
+//
+// \param ref_file1    the reference stream of first mates
+// \param ref_file2    the reference stream of second mates
+// \param file         the tested paired stream
+// \param batch_size   the number of pairs per batch
+// \param batch_bps    the number of base pairs per batch
+// \param what         the name of the tested component
+// \param file_name    the name of the tested file
+// \param n_pairs      the number of pairs read
+//
+bool match_paired_streams(
+    io::SequenceDataStream*             ref_file1,
+    io::SequenceDataStream*             ref_file2,
+    io::PairedSequenceDataInputStream*  file,
+    const uint32                        batch_size,
+    const uint32                        batch_bps,
+    const char*                         what,
+    const char*                         file_name,
+    uint64*                             n_pairs)
+{
+    io::SequenceDataHost ref_data1;
+    io::SequenceDataHost ref_data2;
+    io::SequenceDataHost data1;
+    io::SequenceDataHost data2;
+
+    *n_pairs = 0;
+    while (io::next( DNA_N, &data1, &data2, file, batch_size, batch_bps ))
+    {
+        io::next( DNA_N, &ref_data1, ref_file1, data1.size() );
+        io::next( DNA_N, &ref_data2, ref_file2, data2.size() );
+
+        if (match_reads( ref_data1, data1, what, file_name, *n_pairs, true ) == false ||
+            match_reads( ref_data2, data2, what, file_name, *n_pairs, true ) == false)
+            return false;
+
+        *n_pairs += data1.size();
+    }
+    return file->is_ok();
+}
+
+// write a FASTQ record with random bases and qualities
+//
+void write_random_record(FILE* file, const char* name, const uint32 pair, const uint32 mate)
+{
+    const uint32 len = 30u + (rand() % 121u);
+
+    char bps[256];
+    char quals[256];
+    for (uint32 i = 0; i < len; ++i)
+    {
+        bps[i]   = "ACGTN"[ rand() % 5 ];
+        quals[i] = char( 33 + (rand() % 41) );
+    }
+    bps[len]   = '\0';
+    quals[len] = '\0';
+
+    fprintf( file, "@%s%u/%u\n%s\n+\n%s\n", name, pair, mate, bps, quals );
+}
+
+// a scalar reference of the encoding of ASCII bases in the { A, C, G, T, N } alphabet, as in nst_nt4_table
+//
+uint8 nt4_reference(const char c)
+{
+    switch (c)
+    {
+    case 'A': case 'a': return 0u;
+    case 'C': case 'c': return 1u;
+    case 'G': case 'g': return 2u;
+    case 'T': case 't': return 3u;
+    case '-':           return 5u;
+    default:            return 4u;
+    }
+}
+
+// a scalar reference of the conversion of ASCII qualities to Phred scores
+//
+uint8 phred_reference(const io::QualityEncoding encoding, const char q)
+{
+    if (encoding == io::Phred33) return uint8( q - 33 );
+    if (encoding == io::Phred64) return uint8( q - 64 );
+
+    // Solexa scores are -10 log10( p / (1 - p) ), offset by 64
+    return uint8( 10.0 * log10( pow( 10.0, double( q - 64 ) / 10.0 ) + 1.0 ) + 0.5 );
+}
+
+// check the four strands encoded for each of a set of reads, emitted in the order forward, reverse,
+// forward-complemented and reverse-complemented, against a scalar encoding of their ASCII bases and qualities
+//
+template <Alphabet ALPHABET>
+bool check_strands(
+    const io::SequenceDataHost&         data,
+    const std::vector<std::string>&     reads,
+    const std::vector<std::string>&     quals,
+    const io::QualityEncoding           quality_encoding)
+{
+    const io::SequenceDataAccess<ALPHABET> access( data );
+
+    const uint8 symbol_mask = ALPHABET == DNA ? 3u : 15u;
+
+    for (uint32 i = 0; i < data.size(); ++i)
+    {
+        const std::string& read = reads[ i/4 ];
+        const std::string& qual = quals[ i/4 ];
+
+        const bool   reverse    = (i & 1u) != 0u;
+        const bool   complement = (i & 2u) != 0u;
+        const uint32 len        = uint32( read.size() );
+
+        const typename io::SequenceDataAccess<ALPHABET>::sequence_string strand   = access.get_read(i);
+        const typename io::SequenceDataAccess<ALPHABET>::qual_string     strand_q = access.get_quals(i);
+
+        bool match = strand.length() == len;
+        for (uint32 j = 0; j < len && match; ++j)
+        {
+            const uint32 k = reverse ? len - j - 1u : j;
+
+            uint8 bp = nt4_reference( read[k] );
+            if (complement)
+                bp = bp < 4u ? 3u - bp : 4u;
+
+            match = strand[j] == (bp & symbol_mask) &&
+                    uint8( strand_q[j] ) == phred_reference( quality_encoding, qual[k] );
+        }
+
+        if (match == false)
+        {
+            log_error(stderr,"  %s encoding mismatch at strand %u of read %u (length %u)\n",
+                ALPHABET == DNA ? "DNA" : "DNA_N", i & 3u, i/4, len);
+            return false;
+        }
+    }
+    return true;
+}
+
+// the expected contents of a set of reads, given as text: names, bases and Phred33 qualities
+//
+struct ExpectedReads
+{
+    void push_back(const char* name, const char* bps, const char* quals)
+    {
+        names.push_back( name );
+        reads.push_back( bps );
+        qualities.push_back( quals );
+    }
+
+    uint32 size() const { return uint32( names.size() ); }
+
+    std::vector<std::string> names;
+    std::vector<std::string> reads;
+    std::vector<std::string> qualities;
+};
+
+// check a set of reads against their expected names, bases and qualities, logging the first mismatch
+//
+// \param data         the reads
+// \param expected     the expected reads
+// \param what         the name of the tested component
+// \param file_name    the name of the file the reads come from
+// \param offset       the index of the first read in the file
+//
+bool check_reads(
+    const io::SequenceDataHost& data,
+    const ExpectedReads&        expected,
+    const char*                 what,
+    const char*                 file_name,
+    const uint32                offset = 0)
+{
+    const io::SequenceDataAccess<DNA_N> access( data );
+
+    for (uint32 i = 0; i < data.size(); ++i)
+    {
+        const io::SequenceDataAccess<DNA_N>::sequence_string read = access.get_read(i);
+        const io::SequenceDataAccess<DNA_N>::qual_string     qual = access.get_quals(i);
+        const io::SequenceDataAccess<DNA_N>::name_string     name = access.get_name(i);
+
+        bool match = offset + i < expected.size();
+        if (match)
+        {
+            const std::string& exp_name = expected.names[ offset + i ];
+            const std::string& exp_read = expected.reads[ offset + i ];
+            const std::string& exp_qual = expected.qualities[ offset + i ];
+
+            match = read.length() == exp_read.length() &&
+                    name.length() == exp_name.length() &&
+                    strncmp( name.begin(), exp_name.c_str(), name.length() ) == 0;
+
+            for (uint32 j = 0; j < read.length() && match; ++j)
+                match = "ACGTN"[ read[j] ] == exp_read[j] && qual[j] == exp_qual[j] - 33;
+        }
+
+        if (match == false)
+        {
+            log_error(stderr,"  %s mismatch at read %u of file %s\n", what, offset + i, file_name);
+            return false;
+        }
+    }
+    return true;
+}
+
+// read a whole file, and check it against its expected reads
+//
+// \param file_name    the name of the file
+// \param expected     the expected reads
+// \param batch_size   the number of reads per batch
+// \param what         the name of the tested component
+// \param n_threads    the number of parsing threads, as in io::open_sequence_file()
+// \param skip_flags   the SAM flags of the records to skip, as in io::open_sequence_file()
+// \param ref_name     the reference of CRAM files, as in io::open_sequence_file()
+//
+bool check_file(
+    const char*             file_name,
+    const ExpectedReads&    expected,
+    const uint32            batch_size,
+    const char*             what,
+    const uint32            n_threads  = 1u,
+    const uint32            skip_flags = 0x100,
+    const char*             ref_name   = NULL)
+{
+    SharedPointer<io::SequenceDataStream> file( io::open_sequence_file(
+        file_name,
+        io::Phred33,
+        uint32(-1),
+        uint32(-1),
+        io::FORWARD,
+        0u, 0u,
+        n_threads,
+        skip_flags,
+        ref_name ) );
+    if (is_open( file, file_name ) == false)
+        return false;
+
+    io::SequenceDataHost data;
+
+    uint32 n_reads = 0;
+    while (io::next( DNA_N, &data, file.get(), batch_size ))
+    {
+        if (check_reads( data, expected, what, file_name, n_reads ) == false)
+            return false;
+
+        n_reads += data.size();
+    }
+
+    if (file->is_ok() == false || n_reads != expected.size())
+    {
+        log_error(stderr,"  %s stopped early at read %u of file %s\n", what, n_reads, file_name);
+        return false;
+    }
+    return true;
+}
+
+// write a text file
+//
+bool write_file(const char* file_name, const char* text)
+{
+    FILE* file = fopen( file_name, "wb" );
+    if (file == NULL)
+    {
+        log_error(stderr,"  failed writing file %s\n", file_name);
+        return false;
+    }
+    fputs( text, file );
+    fclose( file );
+    return true;
+}
+
+// append a little-endian 32-bit field to a BAM file
+//
+void append_bam_field(std::string& out, const uint32 value)
+{
+    for (uint32 i = 0; i < 4; ++i)
+        out.push_back( char( (value >> (i*8)) & 0xFF ) );
+}
+
+// append a BAM alignment record, storing its bases as they are given, i.e. already
+// reverse-complemented if the record is flagged as such
+//
+// \param out          the output BAM file
+// \param name         the read name
+// \param bps          the read bases, in ACGTN
+// \param quals        the read qualities, as Phred scores
+// \param flag         the SAM flag
+//
+void append_bam_record(std::string& out, const char* name, const std::string& bps, const std::string& quals, const uint32 flag)
+{
+    const uint32 name_len = uint32( strlen( name ) ) + 1u;
+    const uint32 len      = uint32( bps.size() );
+
+    append_bam_field( out, 32u + name_len + (len + 1u)/2u + len );         // block_size
+    append_bam_field( out, uint32(-1) );                                    // refID
+    append_bam_field( out, uint32(-1) );                                    // pos
+    append_bam_field( out, (4680u << 16) | name_len );                      // bin_mq_nl
+    append_bam_field( out, flag << 16 );                                    // flag_nc
+    append_bam_field( out, len );                                           // l_seq
+    append_bam_field( out, uint32(-1) );                                    // next_refID
+    append_bam_field( out, uint32(-1) );                                    // next_pos
+    append_bam_field( out, 0u );                                            // tlen
+    out.append( name, name_len );
+
+    // pack the bases two per byte, high nibble first, as { A = 1, C = 2, G = 4, T = 8, N = 15 }
+    for (uint32 i = 0; i < len; i += 2)
+    {
+        const uint8 c0 = uint8( strchr( "=AC.G...T......N", bps[i] ) - "=AC.G...T......N" );
+        const uint8 c1 = i+1 < len ? uint8( strchr( "=AC.G...T......N", bps[i+1] ) - "=AC.G...T......N" ) : 0u;
+        out.push_back( char( (c0 << 4) | c1 ) );
+    }
+    out.append( quals );
+}
+
+// reverse-complement a string of ACGTN bases
+//
+std::string reverse_complement(const std::string& bps)
+{
+    std::string rc( bps.rbegin(), bps.rend() );
+    for (uint32 i = 0; i < rc.size(); ++i)
+        rc[i] = rc[i] == 'A' ? 'T' : rc[i] == 'C' ? 'G' : rc[i] == 'G' ? 'C' : rc[i] == 'T' ? 'A' : rc[i];
+    return rc;
+}
+
+#if defined(NVBIO_CRAM)
+// convert a SAM file to a CRAM file compressed against a given FASTA reference
+//
+bool write_cram(const char* sam_name, const char* cram_name, const char* ref_name)
+{
+    samFile* in  = sam_open( sam_name, "r" );
+    samFile* out = sam_open( cram_name, "wc" );
+    if (in == NULL || out == NULL || fai_build( ref_name ) != 0 || hts_set_fai_filename( out, ref_name ) != 0)
+    {
+        log_error(stderr,"  failed writing file %s\n", cram_name);
+        if (in)  sam_close( in );
+        if (out) sam_close( out );
+        return false;
+    }
+
+    bam_hdr_t* header = sam_hdr_read( in );
+    bam1_t*    record = bam_init1();
+
+    bool ok = header != NULL && sam_hdr_write( out, header ) == 0;
+    while (ok && sam_read1( in, header, record ) >= 0)
+        ok = sam_write1( out, header, record ) >= 0;
+
+    bam_destroy1( record );
+    if (header) bam_hdr_destroy( header );
+    sam_close( in );
+    ok = sam_close( out ) == 0 && ok;
+
+    if (ok == false)
+        log_error(stderr,"  failed writing file %s\n", cram_name);
+    return ok;
+}
+#endif
+
+// open a FASTQ (or FASTA) file with the parallel parser, using a given block size
+//
+io::SequenceDataFile_Parallel* open_parallel_file(
+    const char*                                 file_name,
+    const uint32                                n_threads,
+    const uint32                                block_size,
+    const io::SequenceDataFile_Parallel::Format format = io::SequenceDataFile_Parallel::FASTQ)
+{
+    io::SequenceDataFile::Options options;
+    options.qualities = io::Phred33;
+
+    io::SequenceDataFile_Parallel* file = new io::SequenceDataFile_Parallel(
+        file_name,
+        format,
+        options,
+        n_threads,
+        block_size );
+
+    file->init();
+    return file;
+}
+
+} // anonymous namespace
 
 int sequence_test(int argc, char* argv[])
 {
@@ -62,6 +559,169 @@ int sequence_test(int argc, char* argv[])
 
     try
     {
+        // benchmark the encoding of synthetic reads, emitting all four strands of each
+        {
+            const uint32 n_reads  = 256*1024;
+            const uint32 read_len = 150;
+
+            std::vector<uint8>       bps( n_reads * read_len );
+            std::vector<uint8>       quals( n_reads * read_len );
+            std::vector<uint32>      lens( n_reads, read_len );
+            std::vector<const char*> names( n_reads, "read" );
+            std::vector<const uint8*> bp_ptrs( n_reads );
+            std::vector<const uint8*> qual_ptrs( n_reads );
+
+            for (uint32 i = 0; i < n_reads * read_len; ++i)
+            {
+                bps[i]   = "ACGTACGTACGTACGN"[ rand() & 15 ];
+                quals[i] = uint8( 33 + (rand() % 41) );
+            }
+            for (uint32 i = 0; i < n_reads; ++i)
+            {
+                bp_ptrs[i]   = &bps[ i * read_len ];
+                qual_ptrs[i] = &quals[ i * read_len ];
+            }
+
+            for (uint32 a = 0; a < 2; ++a)
+            {
+                const Alphabet alphabet = a == 0 ? DNA : DNA_N;
+
+                io::SequenceDataHost encoded_data;
+                SharedPointer<io::SequenceDataEncoder> encoder( io::create_encoder( alphabet, &encoded_data ) );
+
+                Timer timer;
+                timer.start();
+
+                encoder->begin_batch();
+                encoder->reserve( n_reads * 4, n_reads * read_len * 4 );
+                encoder->push_back(
+                    n_reads,
+                    &lens[0],
+                    &names[0],
+                    &bp_ptrs[0],
+                    &qual_ptrs[0],
+                    io::Phred33,
+                    uint32(-1),
+                    0u, 0u,
+                    io::SequenceEncoding( io::FORWARD | io::REVERSE | io::FORWARD_COMPLEMENT | io::REVERSE_COMPLEMENT ) );
+                encoder->end_batch();
+
+                timer.stop();
+
+                // check the reverse-complemented strands against the forward ones
+                if (alphabet == DNA_N)
+                {
+                    const io::SequenceDataAccess<DNA_N> access( encoded_data );
+
+                    for (uint32 i = 0; i < encoded_data.size(); i += 4)
+                    {
+                        const io::SequenceDataAccess<DNA_N>::sequence_string f_read  = access.get_read(i);
+                        const io::SequenceDataAccess<DNA_N>::sequence_string rc_read = access.get_read(i+3);
+                        const io::SequenceDataAccess<DNA_N>::qual_string     f_qual  = access.get_quals(i);
+                        const io::SequenceDataAccess<DNA_N>::qual_string     rc_qual = access.get_quals(i+3);
+
+                        for (uint32 j = 0; j < read_len; ++j)
+                        {
+                            const uint8 c = f_read[ read_len - j - 1u ];
+
+                            if (rc_read[j] != (c < 4u ? 3u - c : c) ||
+                                rc_qual[j] != f_qual[ read_len - j - 1u ])
+                            {
+                                log_error(stderr,"  reverse-complemented read %u does not match its forward strand!\n", i/4);
+                                return 0;
+                            }
+                        }
+                    }
+                }
+
+                log_verbose(stderr, "  %s encoding: %.2f G bps/s\n", alphabet == DNA ? "DNA" : "DNA_N", 1.0e-9f * float(encoded_data.bps()) / timer.seconds() );
+            }
+        }
+
+        // check the strands of reads of all lengths from 1 to 100, encoded both one at a time and in bulk,
+        // against a scalar encoding of their ASCII bases and qualities, for 2-bit and 4-bit alphabets and
+        // all the ASCII quality encodings
+        {
+            const uint32 n_reads = 4000;
+
+            for (uint32 a = 0; a < 2; ++a)
+            {
+                for (uint32 e = 0; e < 3; ++e)
+                {
+                    const Alphabet            alphabet = a == 0 ? DNA : DNA_N;
+                    const io::QualityEncoding encoding = e == 0 ? io::Phred33 :
+                                                         e == 1 ? io::Phred64 :
+                                                                  io::Solexa;
+
+                    // the lowest valid ASCII quality: Solexa scores start from -5
+                    const uint32 min_q = encoding == io::Phred33 ? 33u :
+                                         encoding == io::Phred64 ? 64u : 59u;
+
+                    std::vector<std::string>  reads( n_reads );
+                    std::vector<std::string>  quals( n_reads );
+                    std::vector<uint32>       lens( n_reads );
+                    std::vector<const char*>  names( n_reads, "read" );
+                    std::vector<const uint8*> bp_ptrs( n_reads );
+                    std::vector<const uint8*> qual_ptrs( n_reads );
+
+                    for (uint32 i = 0; i < n_reads; ++i)
+                    {
+                        lens[i] = 1u + (i % 100u);
+
+                        reads[i].resize( lens[i] );
+                        quals[i].resize( lens[i] );
+                        for (uint32 j = 0; j < lens[i]; ++j)
+                        {
+                            reads[i][j] = "ACGTACGTNacgtnRY-."[ rand() % 18 ];
+                            quals[i][j] = char( min_q + (rand() % 41) );
+                        }
+
+                        bp_ptrs[i]   = (const uint8*)reads[i].c_str();
+                        qual_ptrs[i] = (const uint8*)quals[i].c_str();
+                    }
+
+                    io::SequenceDataHost encoded_data;
+                    SharedPointer<io::SequenceDataEncoder> encoder( io::create_encoder( alphabet, &encoded_data ) );
+
+                    encoder->begin_batch();
+
+                    // encode the first half of the reads one strand at a time
+                    const io::SequenceDataEncoder::StrandOp ops[4] = {
+                        io::SequenceDataEncoder::NO_OP,
+                        io::SequenceDataEncoder::REVERSE_OP,
+                        io::SequenceDataEncoder::COMPLEMENT_OP,
+                        io::SequenceDataEncoder::REVERSE_COMPLEMENT_OP };
+
+                    for (uint32 i = 0; i < n_reads/2; ++i)
+                    {
+                        for (uint32 op = 0; op < 4; ++op)
+                            encoder->push_back( lens[i], names[i], bp_ptrs[i], qual_ptrs[i], encoding, uint32(-1), 0u, 0u, ops[op] );
+                    }
+
+                    // and the second half in bulk
+                    encoder->push_back(
+                        n_reads/2,
+                        &lens[ n_reads/2 ],
+                        &names[ n_reads/2 ],
+                        &bp_ptrs[ n_reads/2 ],
+                        &qual_ptrs[ n_reads/2 ],
+                        encoding,
+                        uint32(-1),
+                        0u, 0u,
+                        io::SequenceEncoding( io::FORWARD | io::REVERSE | io::FORWARD_COMPLEMENT | io::REVERSE_COMPLEMENT ) );
+
+                    encoder->end_batch();
+
+                    const bool match = alphabet == DNA ?
+                        check_strands<DNA>(   encoded_data, reads, quals, encoding ) :
+                        check_strands<DNA_N>( encoded_data, reads, quals, encoding );
+
+                    if (match == false)
+                        return 0;
+                }
+            }
+        }
+
         if (index_name != NULL)
         {
             log_verbose(stderr, "  loading sequence file %s\n", index_name );
@@ -121,11 +781,8 @@ int sequence_test(int argc, char* argv[])
         if (reads_name != NULL)
         {
             SharedPointer<io::SequenceDataStream> read_file( io::open_sequence_file( reads_name ) );
-            if (read_file == NULL || read_file->is_ok() == false)
-            {
-                log_error(stderr,"  failed opening reads file %s\n", reads_name);
+            if (is_open( read_file, reads_name ) == false)
                 return 0;
-            }
 
             io::SequenceDataHost read_data;
 
@@ -137,6 +794,841 @@ int sequence_test(int argc, char* argv[])
                 read_data.avg_sequence_len(),
                 read_data.min_sequence_len(),
                 read_data.max_sequence_len() );
+
+            // parse the whole file with the parallel parser, using blocks small enough to cross
+            // many block and range boundaries, and check it matches the serial parser
+            {
+                SharedPointer<io::SequenceDataStream> ser_file( io::open_sequence_file( reads_name ) );
+                SharedPointer<io::SequenceDataStream> par_file( open_parallel_file( reads_name, 4u, 64*1024 ) );
+                if (is_open( ser_file, reads_name ) == false ||
+                    is_open( par_file, reads_name ) == false)
+                    return 0;
+
+                if (match_streams( ser_file.get(), par_file.get(), 10000, "parallel parser", reads_name ) == false)
+                    return 0;
+            }
+
+            // write the reads to a read cache, and check they are read back unchanged
+            {
+                const char* cache_name = "sequence_test.nvr";
+                {
+                    SharedPointer<io::SequenceDataOutputStream> cache_file( io::open_output_sequence_file( cache_name, "" ) );
+                    if (is_open( cache_file, cache_name ) == false)
+                        return 0;
+
+                    cache_file->next( read_data );
+                }
+
+                io::SequenceDataHost cache_data;
+                {
+                    SharedPointer<io::SequenceDataStream> cache_file( io::open_sequence_file( cache_name ) );
+                    if (is_open( cache_file, cache_name ) == false)
+                        return 0;
+
+                    io::next( DNA_N, &cache_data, cache_file.get(), 10000 );
+                }
+                remove( cache_name );
+
+                if (match_reads( read_data, cache_data, "read cache", reads_name, 0u, true ) == false)
+                    return 0;
+            }
+
+            // load the reads with binned qualities, and check they decode to the scores of their bins
+            {
+                SharedPointer<io::SequenceDataStream> bin_file( io::open_sequence_file( reads_name ) );
+                if (is_open( bin_file, reads_name ) == false)
+                    return 0;
+
+                const io::QualityBins bins = io::QualityBins::illumina();
+
+                uint8 bin_table[256];
+                bins.bin_table( bin_table );
+
+                io::SequenceDataHost bin_data;
+                bin_data.set_quality_bins( bins );
+
+                io::next( DNA_N, &bin_data, bin_file.get(), 10000 );
+
+                if (bin_data.quality_bins() != bins ||
+                    bin_data.qs() != (read_data.bps() + 1u) / 2u)
+                {
+                    log_error(stderr,"  binned qualities of file %s were not packed!\n", reads_name);
+                    return 0;
+                }
+
+                typedef io::SequenceDataAccess<DNA_N>                                   plain_access_type;
+                typedef io::SequenceDataAccess<DNA_N,io::ConstSequenceDataView,true>    binned_access_type;
+
+                // expand a copy of the binned qualities back to plain scores
+                io::SequenceDataHost expanded_data( bin_data );
+                io::expand_qualities( &expanded_data );
+
+                if (expanded_data.quality_bins().is_plain() == false ||
+                    expanded_data.qs() != read_data.bps())
+                {
+                    log_error(stderr,"  binned qualities of file %s were not expanded!\n", reads_name);
+                    return 0;
+                }
+
+                const plain_access_type  read_access( read_data );
+                const binned_access_type bin_access( bin_data );
+                const plain_access_type  expanded_access( expanded_data );
+
+                for (uint32 i = 0; i < read_data.size(); ++i)
+                {
+                    const plain_access_type::qual_string  qual1 = read_access.get_quals(i);
+                    const binned_access_type::qual_string qual2 = bin_access.get_quals(i);
+                    const plain_access_type::qual_string  qual3 = expanded_access.get_quals(i);
+
+                    for (uint32 j = 0; j < qual1.length(); ++j)
+                    {
+                        if (qual2[j] != char( bins.value( bin_table[ uint8( qual1[j] ) ] ) ) ||
+                            qual3[j] != qual2[j])
+                        {
+                            log_error(stderr,"  binned qualities of file %s do not match at read %u!\n", reads_name, i);
+                            return 0;
+                        }
+                    }
+                }
+
+                // time decoding the plain and the binned qualities
+                {
+                    uint64 plain_sum  = 0;
+                    uint64 binned_sum = 0;
+
+                    Timer plain_timer;
+                    plain_timer.start();
+
+                    for (uint32 i = 0; i < read_data.size(); ++i)
+                    {
+                        const plain_access_type::qual_string qual = read_access.get_quals(i);
+                        for (uint32 j = 0; j < qual.length(); ++j)
+                            plain_sum += uint8( qual[j] );
+                    }
+
+                    plain_timer.stop();
+
+                    Timer binned_timer;
+                    binned_timer.start();
+
+                    for (uint32 i = 0; i < bin_data.size(); ++i)
+                    {
+                        const binned_access_type::qual_string qual = bin_access.get_quals(i);
+                        for (uint32 j = 0; j < qual.length(); ++j)
+                            binned_sum += uint8( qual[j] );
+                    }
+
+                    binned_timer.stop();
+
+                    log_verbose(stderr, "  plain  quality decoding: %.2f G quals/s (checksum %llu)\n", 1.0e-9f * float(read_data.bps()) / plain_timer.seconds(),  plain_sum );
+                    log_verbose(stderr, "  binned quality decoding: %.2f G quals/s (checksum %llu)\n", 1.0e-9f * float(bin_data.bps())  / binned_timer.seconds(), binned_sum );
+                }
+            }
+
+            // check the parallel gzip reader against zlib
+            {
+                io::ParallelGzipReader gz_reader;
+                if (gz_reader.open( reads_name ) == false)
+                {
+                    log_error(stderr,"  failed opening reads file %s\n", reads_name);
+                    return 0;
+                }
+
+                gzFile gz_file = gzopen( reads_name, "rb" );
+
+                std::vector<char> buffer1( 1024*1024 );
+                std::vector<char> buffer2( 1024*1024 );
+
+                uint64 n_bytes = 0;
+                while (1)
+                {
+                    // use an odd read size, so as to straddle the decompressed blocks
+                    const int32 n1 = gz_reader.read( &buffer1[0], 1000003u );
+                    const int32 n2 = gzread( gz_file, &buffer2[0], 1000003u );
+
+                    if (n1 != n2 || memcmp( &buffer1[0], &buffer2[0], nvbio::max( n1, 0 ) ) != 0)
+                    {
+                        log_error(stderr,"  parallel gzip reader mismatch at byte %llu of file %s\n", n_bytes, reads_name);
+                        gzclose( gz_file );
+                        return 0;
+                    }
+                    if (n1 <= 0)
+                        break;
+
+                    n_bytes += uint64( n1 );
+                }
+                gzclose( gz_file );
+
+                log_verbose(stderr, "  gzip reader: %s, %llu bytes\n", gz_reader.format() == io::ParallelGzipReader::BGZF ? "BGZF" : "gzip", n_bytes );
+            }
+
+            // benchmark the serial and parallel parsers on the whole file
+            for (uint32 n_threads = 1; n_threads != uint32(-1); --n_threads)
+            {
+                const char* parser_name = n_threads == 1 ? "serial" : "parallel";
+
+                log_verbose(stderr, "  %s parsing benchmark... started\n", parser_name);
+
+                SharedPointer<io::SequenceDataStream> bench_file(
+                    io::open_sequence_file( reads_name, io::Phred33, uint32(-1), uint32(-1), io::FORWARD, 0u, 0u, n_threads ) );
+                if (is_open( bench_file, reads_name ) == false)
+                    return 0;
+
+                uint64 n_reads = 0;
+                uint64 n_bps   = 0;
+
+                Timer timer;
+                timer.start();
+
+                while (io::next( DNA_N, &read_data, bench_file.get(), 512*1024, 128*1024*1024 ))
+                {
+                    n_reads += read_data.size();
+                    n_bps   += read_data.bps();
+                }
+
+                timer.stop();
+
+                // measure the (possibly compressed) file size
+                uint64 file_size = 0;
+                if (FILE* file = fopen( reads_name, "rb" ))
+                {
+                    fseek( file, 0, SEEK_END );
+                    file_size = uint64( ftell( file ) );
+                    fclose( file );
+                }
+
+                log_verbose(stderr, "  %s parsing benchmark... done\n", parser_name);
+                log_verbose(stderr, "    reads : %llu (%.2f M reads/s)\n", n_reads, 1.0e-6f * float(n_reads) / timer.seconds() );
+                log_verbose(stderr, "    bps   : %llu (%.2f G bps/s)\n", n_bps, 1.0e-9f * float(n_bps) / timer.seconds() );
+                log_verbose(stderr, "    file  : %.2f MB/s\n", 1.0e-6f * float(file_size) / timer.seconds() );
+            }
+
+            // read the file as both mates of a pair: both batches must match the file read on its own
+            {
+                SharedPointer<io::PairedSequenceDataInputStream> paired_file(
+                    io::open_paired_sequence_files( reads_name, reads_name, io::Phred33, uint32(-1), uint32(-1), io::FORWARD, 0u, 0u, 0u ) );
+                SharedPointer<io::SequenceDataStream> ref_file1( io::open_sequence_file( reads_name ) );
+                SharedPointer<io::SequenceDataStream> ref_file2( io::open_sequence_file( reads_name ) );
+                if (is_open( paired_file, reads_name ) == false ||
+                    is_open( ref_file1,   reads_name ) == false ||
+                    is_open( ref_file2,   reads_name ) == false)
+                    return 0;
+
+                uint64 n_pairs;
+                if (match_paired_streams( ref_file1.get(), ref_file2.get(), paired_file.get(), 512*1024, 128*1024*1024, "paired reader", reads_name, &n_pairs ) == false)
+                    return 0;
+
+                log_verbose(stderr, "  paired reader: %llu pairs\n", n_pairs);
+            }
+
+            // read the file ahead on a background thread, within a budget small enough to force
+            // recycling the buffers: the batches must match those read synchronously
+            {
+                SharedPointer<io::SequenceDataStream> sync_file( io::open_sequence_file( reads_name ) );
+                SharedPointer<io::SequenceDataStream> async_file( io::open_sequence_file( reads_name ) );
+                if (is_open( sync_file, reads_name ) == false ||
+                    is_open( async_file, reads_name ) == false)
+                    return 0;
+
+                io::AsyncSequenceDataStream async_stream( async_file.get(), DNA_N, 64*1024, 16*1024*1024, 1u );
+
+                uint64 n_reads = 0;
+                while (io::next( DNA_N, &read_data, sync_file.get(), 64*1024, 16*1024*1024 ))
+                {
+                    io::AsyncSequenceDataStream::Batch* batch = async_stream.next();
+                    if (batch == NULL || batch->offset != n_reads)
+                    {
+                        log_error(stderr,"  read-ahead stream mismatch at read %llu of file %s\n", n_reads, reads_name);
+                        return 0;
+                    }
+                    if (match_reads( read_data, batch->data[0], "read-ahead stream", reads_name, n_reads, true ) == false)
+                        return 0;
+
+                    n_reads += read_data.size();
+
+                    async_stream.release( batch );
+                }
+                if (async_stream.next() != NULL || async_stream.error())
+                {
+                    log_error(stderr,"  read-ahead stream did not end with file %s\n", reads_name);
+                    return 0;
+                }
+
+                const io::AsyncSequenceDataStats stats = async_stream.stats();
+                log_verbose(stderr, "  read-ahead stream: %llu reads, %u buffers, %u producer stalls, %u consumer stalls\n",
+                    stats.reads, stats.buffers, stats.producer_stalls, stats.consumer_stalls);
+            }
+        }
+
+        // read a set of synthetic pairs both from two mate files and interleaved, with a bps budget
+        // forcing batches to stop between two mates; then check that mates with different names are rejected
+        {
+            const char* mate_names[2] = { "sequence_test_1.fastq", "sequence_test_2.fastq" };
+            const char* il_name       = "sequence_test_il.fastq";
+            const char* bad_names[2]  = { "sequence_test_bad_2.fastq", "sequence_test_bad_il.fastq" };
+
+            const uint32 n_pairs = 5000;
+            {
+                FILE* mate_files[2] = { fopen( mate_names[0], "w" ), fopen( mate_names[1], "w" ) };
+                FILE* il_file       = fopen( il_name, "w" );
+                FILE* bad_files[2]  = { fopen( bad_names[0], "w" ), fopen( bad_names[1], "w" ) };
+                if (mate_files[0] && mate_files[1] && il_file && bad_files[0] && bad_files[1])
+                {
+                    for (uint32 i = 0; i < n_pairs; ++i)
+                    {
+                        for (uint32 mate = 0; mate < 2; ++mate)
+                        {
+                            // write the same record to all files, using the same seed; the bad files
+                            // rename the second mate of one pair
+                            const char*  bad  = (i == n_pairs/2 && mate == 1) ? "other" : "pair";
+                            const uint32 seed = rand();
+                            srand( seed ); write_random_record( mate_files[mate], "pair", i, mate+1 );
+                            srand( seed ); write_random_record( il_file,          "pair", i, mate+1 );
+                            srand( seed ); write_random_record( bad_files[1],     bad,    i, mate+1 );
+                            if (mate == 1)
+                            {
+                                srand( seed );
+                                write_random_record( bad_files[0], bad, i, mate+1 );
+                            }
+                        }
+                    }
+                }
+                for (uint32 mate = 0; mate < 2; ++mate)
+                    if (mate_files[mate]) fclose( mate_files[mate] );
+                if (il_file)  fclose( il_file );
+                for (uint32 mate = 0; mate < 2; ++mate)
+                    if (bad_files[mate]) fclose( bad_files[mate] );
+            }
+
+            bool success = true;
+
+            for (uint32 interleaved = 0; interleaved < 2 && success; ++interleaved)
+            {
+                const char* name = interleaved ? il_name : mate_names[0];
+
+                SharedPointer<io::PairedSequenceDataInputStream> paired_file(
+                    io::open_paired_sequence_files( name, interleaved ? NULL : mate_names[1] ) );
+                SharedPointer<io::SequenceDataStream> ref_file1( io::open_sequence_file( mate_names[0] ) );
+                SharedPointer<io::SequenceDataStream> ref_file2( io::open_sequence_file( mate_names[1] ) );
+
+                uint64 n_read = 0;
+                success =
+                    is_open( paired_file, name )           &&
+                    is_open( ref_file1,   mate_names[0] )  &&
+                    is_open( ref_file2,   mate_names[1] )  &&
+                    match_paired_streams( ref_file1.get(), ref_file2.get(), paired_file.get(), 777, 100*1024, "paired reader", name, &n_read );
+
+                if (success && n_read != n_pairs)
+                {
+                    log_error(stderr,"  paired reader returned %llu pairs out of %u from file %s\n", n_read, n_pairs, name);
+                    success = false;
+                }
+            }
+
+            // the mismatching names must be detected both interleaved and in separate files
+            for (uint32 interleaved = 0; interleaved < 2 && success; ++interleaved)
+            {
+                SharedPointer<io::PairedSequenceDataInputStream> paired_file(
+                    io::open_paired_sequence_files(
+                        interleaved ? bad_names[1] : mate_names[0],
+                        interleaved ? NULL         : bad_names[0] ) );
+                if (is_open( paired_file, bad_names[interleaved] ) == false)
+                {
+                    success = false;
+                    break;
+                }
+
+                io::SequenceDataHost data1;
+                io::SequenceDataHost data2;
+
+                uint64 n_read = 0;
+                while (io::next( DNA_N, &data1, &data2, paired_file.get(), 777, 100*1024 ))
+                    n_read += data1.size();
+
+                if (paired_file->is_ok() || n_read >= n_pairs)
+                {
+                    log_error(stderr,"  paired reader did not reject mismatching mate names (%llu pairs)\n", n_read);
+                    success = false;
+                }
+            }
+
+            for (uint32 mate = 0; mate < 2; ++mate)
+            {
+                remove( mate_names[mate] );
+                remove( bad_names[mate] );
+            }
+            remove( il_name );
+
+            if (success == false)
+                return 0;
+        }
+
+        // the serial FASTQ parser must read DOS line endings (as must the parallel one), last records with
+        // no trailing newline and multi-line records mixed with single-line ones, and give the same reads
+        // across the refills of its 1MB buffer
+        {
+            const char* fq_name = "sequence_test_direct.fastq";
+
+            // DOS line endings, with the last record ending without a newline
+            {
+                ExpectedReads expected;
+                expected.push_back( "r0 some description", "ACGTN", "II#I5" );
+                expected.push_back( "r1",                  "GA",    "!~" );
+                expected.push_back( "r2",                  "TTCA",  "ABCD" );
+
+                const bool ok =
+                    write_file( fq_name, "@r0 some description\r\nACGTN\r\n+\r\nII#I5\r\n@r1\r\nGA\r\n+r1\r\n!~\r\n@r2\r\nTTCA\r\n+\r\nABCD" ) &&
+                    check_file( fq_name, expected, 2u, "FASTQ parser (DOS line endings)" ) &&
+                    check_file( fq_name, expected, 2u, "parallel FASTQ parser (DOS line endings)", 4u );
+
+                remove( fq_name );
+                if (ok == false)
+                    return 0;
+            }
+
+            // multi-line records mixed with single-line ones, with and without DOS line endings,
+            // and a multi-line last record ending without a newline
+            {
+                ExpectedReads expected;
+                expected.push_back( "m0", "ACGT",    "IIII" );
+                expected.push_back( "m1", "ACGTTA",  "IIIJJJ" );
+                expected.push_back( "m2", "GATTACA", "#######" );
+                expected.push_back( "m3", "ACGTN",   "ABCDE" );
+                expected.push_back( "m4", "CCCC",    "5555" );
+                expected.push_back( "m5", "TGCA",    "!!@@" );
+
+                const bool ok =
+                    write_file( fq_name,
+                        "@m0\nACGT\n+\nIIII\n"
+                        "@m1\nACG\nTTA\n+\nIII\nJJJ\n"
+                        "@m2\nGATTACA\n+m2\n#######\n"
+                        "@m3\r\nAC\r\nGT\r\nN\r\n+\r\nAB\r\nCD\r\nE\r\n"
+                        "@m4\nCCCC\n+\n5555\n"
+                        "@m5\nTG\nCA\n+\n!!\n@@" ) &&
+                    check_file( fq_name, expected, 4u, "FASTQ parser (multi-line records)" );
+
+                remove( fq_name );
+                if (ok == false)
+                    return 0;
+            }
+
+            // a few MBs of records of all of the above kinds, one of which straddles the end of the
+            // first buffer, and one of which is longer than the buffer itself
+            {
+                ExpectedReads expected;
+                std::string   text;
+
+                bool straddled = false;
+
+                for (uint32 i = 0; text.size() < 4u*1024u*1024u; ++i)
+                {
+                    const uint32 len = i == 1000u ? 1536u*1024u : 50u + (i * 37u) % 200u;
+
+                    std::string bps( len, 'A' );
+                    std::string quals( len, 'I' );
+                    for (uint32 j = 0; j < len; ++j)
+                    {
+                        bps[j]   = "ACGTN"[ rand() % 5 ];
+                        quals[j] = char( 33 + (rand() % 41) );
+                    }
+
+                    char name[32];
+                    sprintf( name, "read%u", i );
+                    expected.push_back( name, bps.c_str(), quals.c_str() );
+
+                    const char*  eol   = (i % 3u) ? "\n" : "\r\n";
+                    const size_t begin = text.size();
+
+                    text += std::string( "@" ) + name + eol;
+                    if (i % 11u)
+                        text += bps + eol + "+" + eol + quals + eol;
+                    else
+                    {
+                        // split the record across multiple lines
+                        text += bps.substr( 0, len/2 ) + eol + bps.substr( len/2 ) + eol + "+" + eol;
+                        text += quals.substr( 0, len/2 ) + eol + quals.substr( len/2 ) + eol;
+                    }
+
+                    if (begin < 1024u*1024u && text.size() > 1024u*1024u)
+                        straddled = true;
+                }
+
+                if (straddled == false)
+                {
+                    log_error(stderr,"  no FASTQ record straddles the parser's buffer\n");
+                    return 0;
+                }
+
+                const bool ok =
+                    write_file( fq_name, text.c_str() ) &&
+                    check_file( fq_name, expected, 1000u, "FASTQ parser (buffer refills)" );
+
+                remove( fq_name );
+                if (ok == false)
+                    return 0;
+            }
+        }
+
+        // a BAM file must be decoded to its original reads, with reverse-complemented records restored to their
+        // original orientation and filtered by their SAM flags; read lengths span all the residues of the decoder's
+        // 16-base unpacking, odd ones included, and a truncated record must be reported as an error
+        {
+            const char* bam_name = "sequence_test.bam";
+
+            std::string header( "BAM\1", 4u );
+            append_bam_field( header, 11u );
+            header += "@HD\tVN:1.6\n";
+            append_bam_field( header, 1u );
+            append_bam_field( header, 5u );
+            header.append( "chr1", 5u );
+            append_bam_field( header, 1000000u );
+
+            std::string   records;
+            ExpectedReads expected_all;         // all records
+            ExpectedReads expected_primary;     // the records which are not secondary (the default filter)
+            ExpectedReads expected_mapped;      // the mapped records which are not secondary
+
+            const uint32 n_records = 3001;
+            for (uint32 i = 0; i < n_records; ++i)
+            {
+                const uint32 len = 1u + (i % 67u);
+
+                std::string bps( len, 'A' );
+                std::string quals( len, 'I' );
+                std::string phred( len, 0 );
+                for (uint32 j = 0; j < len; ++j)
+                {
+                    bps[j]   = "ACGTN"[ rand() % 5 ];
+                    phred[j] = char( rand() % 41 );
+                    quals[j] = char( 33 + phred[j] );
+                }
+
+                const uint32 flag =
+                    ((i % 3u) == 1u ? 0x10u  : 0u) |  // reverse-complemented
+                    ((i % 5u) == 2u ? 0x4u   : 0u) |  // unmapped
+                    ((i % 7u) == 3u ? 0x100u : 0u);   // secondary
+
+                char name[32];
+                sprintf( name, "bam%u", i );
+
+                if (flag & 0x10u)
+                    append_bam_record( records, name, reverse_complement( bps ), std::string( phred.rbegin(), phred.rend() ), flag );
+                else
+                    append_bam_record( records, name, bps, phred, flag );
+
+                expected_all.push_back( name, bps.c_str(), quals.c_str() );
+                if ((flag & 0x100u) == 0u)
+                    expected_primary.push_back( name, bps.c_str(), quals.c_str() );
+                if ((flag & 0x104u) == 0u)
+                    expected_mapped.push_back( name, bps.c_str(), quals.c_str() );
+            }
+
+            gzFile bam_file = gzopen( bam_name, "wb" );
+            if (bam_file == NULL)
+            {
+                log_error(stderr,"  failed writing file %s\n", bam_name);
+                return 0;
+            }
+            gzwrite( bam_file, header.c_str(),  unsigned( header.size() ) );
+            gzwrite( bam_file, records.c_str(), unsigned( records.size() ) );
+            gzclose( bam_file );
+
+            // read the file in small batches, and in batches large enough to be decoded in parallel
+            const bool ok =
+                check_file( bam_name, expected_primary, 100u,  "BAM reader" ) &&
+                check_file( bam_name, expected_primary, 4000u, "BAM reader (parallel decoding)", 4u ) &&
+                check_file( bam_name, expected_all,     100u,  "BAM reader (no filtering)", 1u, 0u ) &&
+                check_file( bam_name, expected_mapped,  100u,  "BAM reader (skipping unmapped reads)", 1u, 0x104u );
+
+            if (ok == false)
+            {
+                remove( bam_name );
+                return 0;
+            }
+
+            // truncate the last record, which is primary
+            bam_file = gzopen( bam_name, "wb" );
+            gzwrite( bam_file, header.c_str(),  unsigned( header.size() ) );
+            gzwrite( bam_file, records.c_str(), unsigned( records.size() - 10u ) );
+            gzclose( bam_file );
+
+            SharedPointer<io::SequenceDataStream> file( io::open_sequence_file( bam_name ) );
+            if (is_open( file, bam_name ) == false)
+            {
+                remove( bam_name );
+                return 0;
+            }
+
+            io::SequenceDataHost data;
+
+            uint32 n_reads = 0;
+            while (io::next( DNA_N, &data, file.get(), 100u ))
+            {
+                if (check_reads( data, expected_primary, "BAM reader (truncated file)", bam_name, n_reads ) == false)
+                {
+                    remove( bam_name );
+                    return 0;
+                }
+                n_reads += data.size();
+            }
+            remove( bam_name );
+
+            if (file->is_ok() || n_reads + 1u != expected_primary.size())
+            {
+                log_error(stderr,"  truncated BAM record not reported as an error after %u reads\n", n_reads);
+                return 0;
+            }
+        }
+
+      #if defined(NVBIO_CRAM)
+        // a CRAM file must be decoded against the FASTA reference it was compressed against, N runs included,
+        // restoring the original reads as the BAM reader does; a reference lacking the N runs, as exported from
+        // a .pac archive, must fail the MD5 checks rather than silently decode different reads
+        {
+            const char* ref_name    = "sequence_test_cram.fa";
+            const char* nref_name   = "sequence_test_cram_noN.fa";
+            const char* sam_name    = "sequence_test_cram.sam";
+            const char* cram_name   = "sequence_test.cram";
+
+            const uint32 ref_len = 20000;
+
+            std::string ref( ref_len, 'A' );
+            for (uint32 i = 0; i < ref_len; ++i)
+                ref[i] = "ACGT"[ rand() % 4 ];
+
+            // add a few N runs, and the same reference with the runs replaced by A's
+            std::string nref( ref );
+            for (uint32 i = 1000; i < ref_len; i += 4000)
+            {
+                ref.replace( i, 200, 200, 'N' );
+                nref.replace( i, 200, 200, 'A' );
+            }
+
+            std::string ref_file  = ">chr1\n";
+            std::string nref_file = ">chr1\n";
+            for (uint32 i = 0; i < ref_len; i += 60)
+            {
+                ref_file  += ref.substr( i, 60 )  + "\n";
+                nref_file += nref.substr( i, 60 ) + "\n";
+            }
+
+            std::string   sam_file = "@HD\tVN:1.4\tSO:coordinate\n@SQ\tSN:chr1\tLN:20000\n";
+            ExpectedReads expected;
+
+            const uint32 n_records = 5000;
+            for (uint32 i = 0; i < n_records; ++i)
+            {
+                // sorted mapped reads covering the whole reference, followed by a few unmapped ones
+                const bool   mapped = i < n_records - 100u;
+                const uint32 len    = 20u + (i % 131u);
+                const uint32 pos    = mapped ? (i * (ref_len - 200u)) / n_records : 0u;
+
+                std::string bps   = mapped ? ref.substr( pos, len ) : std::string( len, 'A' );
+                std::string quals( len, 'I' );
+                for (uint32 j = 0; j < len; ++j)
+                {
+                    if (mapped == false || rand() % 50 == 0)
+                        bps[j] = "ACGTN"[ rand() % 5 ];
+
+                    quals[j] = char( 33 + rand() % 41 );
+                }
+
+                const uint32 flag =
+                    (mapped == false           ? 0x4u   : 0u) |  // unmapped
+                    (mapped && (i % 3u) == 1u  ? 0x10u  : 0u) |  // reverse-complemented
+                    (mapped && (i % 7u) == 3u  ? 0x100u : 0u);   // secondary
+
+                char name[32];
+                sprintf( name, "cram%u", i );
+
+                char fields[256];
+                if (mapped)
+                    sprintf( fields, "%s\t%u\tchr1\t%u\t60\t%uM\t*\t0\t0\t", name, flag, pos + 1u, len );
+                else
+                    sprintf( fields, "%s\t%u\t*\t0\t0\t*\t*\t0\t0\t", name, flag );
+
+                // the SAM record stores the bases as aligned to the forward strand, so that the original
+                // reads of reverse-complemented records are the reverse-complement of the stored ones
+                sam_file += fields + bps + "\t" + quals + "\n";
+
+                if ((flag & 0x100u) == 0u)
+                {
+                    if (flag & 0x10u)
+                        expected.push_back( name, reverse_complement( bps ).c_str(), std::string( quals.rbegin(), quals.rend() ).c_str() );
+                    else
+                        expected.push_back( name, bps.c_str(), quals.c_str() );
+                }
+            }
+
+            bool ok =
+                write_file( ref_name,  ref_file.c_str() ) &&
+                write_file( nref_name, nref_file.c_str() ) &&
+                write_file( sam_name,  sam_file.c_str() ) &&
+                write_cram( sam_name, cram_name, ref_name );
+
+            // read the file in small batches, and in batches large enough to be decoded in parallel
+            ok = ok &&
+                check_file( cram_name, expected, 100u,  "CRAM reader", 1u, 0x100u, ref_name ) &&
+                check_file( cram_name, expected, 4000u, "CRAM reader (parallel decoding)", 4u, 0x100u, ref_name );
+
+            if (ok)
+            {
+                SharedPointer<io::SequenceDataStream> file( io::open_sequence_file(
+                    cram_name,
+                    io::Phred33,
+                    uint32(-1),
+                    uint32(-1),
+                    io::FORWARD,
+                    0u, 0u,
+                    1u,
+                    0x100u,
+                    nref_name ) );
+
+                io::SequenceDataHost data;
+                if (file != NULL)
+                {
+                    while (io::next( DNA_N, &data, file.get(), 100u )) {}
+
+                    if (file->is_ok())
+                    {
+                        log_error(stderr,"  CRAM reader decoded %s against a mismatching reference\n", cram_name);
+                        ok = false;
+                    }
+                }
+            }
+
+            remove( ref_name );
+            remove( nref_name );
+            remove( (std::string( ref_name )  + ".fai").c_str() );
+            remove( (std::string( nref_name ) + ".fai").c_str() );
+            remove( sam_name );
+            remove( cram_name );
+
+            if (ok == false)
+                return 0;
+        }
+      #endif
+
+        // a file switching to multi-line FASTQ records past the first block must be handed over
+        // to the serial parser, and read exactly as the serial parser reads it
+        {
+            const char* ml_name = "sequence_test_multiline.fastq";
+            if (FILE* ml_file = fopen( ml_name, "w" ))
+            {
+                for (uint32 i = 0; i < 4000; ++i)
+                    fprintf( ml_file, "@read%u\nACGTACGTACGTACGTACGT\n+\nIIIIIIIIIIIIIIIIIIII\n", i );
+                for (uint32 i = 4000; i < 5000; ++i)
+                    fprintf( ml_file, "@read%u\nACGTACGTAC\nTTTTTGGGGG\n+\nIIIIIIIIII\n##########\n", i );
+                fclose( ml_file );
+            }
+
+            SharedPointer<io::SequenceDataStream> ser_file( io::open_sequence_file( ml_name ) );
+            SharedPointer<io::SequenceDataStream> par_file( open_parallel_file( ml_name, 4u, 16*1024 ) );
+            if (is_open( ser_file, ml_name ) == false ||
+                is_open( par_file, ml_name ) == false)
+            {
+                remove( ml_name );
+                return 0;
+            }
+
+            const bool match = match_streams( ser_file.get(), par_file.get(), 1000, "parallel parser fallback", ml_name );
+            remove( ml_name );
+
+            if (match == false)
+                return 0;
+        }
+
+        // the parallel FASTA parser must tokenize records exactly as the serial one: names end at the
+        // first space only, and only spaces and newlines are dropped from the sequences, so that tabs and
+        // the carriage returns of DOS line endings are kept; the second file also has a '>' in the middle
+        // of a sequence line past the first block, which the serial parser takes as the start of a new record
+        for (uint32 variant = 0; variant < 2; ++variant)
+        {
+            const char* fa_name = "sequence_test_parity.fa";
+            if (FILE* fa_file = fopen( fa_name, "wb" ))
+            {
+                fprintf( fa_file, "\n \n" );
+                for (uint32 i = 0; i < 3000; ++i)
+                {
+                    const char* eol = (i & 1) ? "\r\n" : "\n";
+                    switch (i % 4)
+                    {
+                    case 0:  fprintf( fa_file, ">seq%u description%s", i, eol ); break;
+                    case 1:  fprintf( fa_file, ">seq%u\tdescription%s", i, eol ); break;
+                    case 2:  fprintf( fa_file, ">seq%u%s", i, eol ); break;
+                    default: fprintf( fa_file, ">%s", eol ); break;
+                    }
+                    const uint32 n_lines = 1u + (i % 3u);
+                    for (uint32 l = 0; l < n_lines; ++l)
+                    {
+                        fprintf( fa_file, "ACGT%sNNac gt\tTG", (i % 5u == 0) ? " " : "" );
+                        if (variant == 1 && i == 2500 && l == 0)
+                            fprintf( fa_file, ">inner%u", i );
+                        fprintf( fa_file, "%s", eol );
+                    }
+                    if (i % 7u == 0)
+                        fprintf( fa_file, "%s", eol );
+                }
+                fclose( fa_file );
+            }
+
+            SharedPointer<io::SequenceDataStream> ser_file( io::open_sequence_file( fa_name, io::Phred33, uint32(-1), uint32(-1), io::FORWARD, 0u, 0u, 1u ) );
+            SharedPointer<io::SequenceDataStream> par_file( open_parallel_file( fa_name, 4u, 16*1024, io::SequenceDataFile_Parallel::FASTA ) );
+            if (is_open( ser_file, fa_name ) == false ||
+                is_open( par_file, fa_name ) == false)
+            {
+                remove( fa_name );
+                return 0;
+            }
+
+            const bool match = match_streams( ser_file.get(), par_file.get(), 777, "parallel FASTA parser", fa_name );
+            remove( fa_name );
+
+            if (match == false)
+                return 0;
+        }
+
+        // a malformed file must be reported as an error by the read-ahead stream, rather than as a clean end,
+        // both when read serially and when read in parallel past the first block
+        for (uint32 parallel = 0; parallel < 2; ++parallel)
+        {
+            const char* bad_name = "sequence_test_bad.fastq";
+            if (FILE* bad_file = fopen( bad_name, "w" ))
+            {
+                for (uint32 i = 0; i < 1000; ++i)
+                    fprintf( bad_file, "@read%u\nACGTACGTAC\n+\nIIIIIIIIII\n", i );
+                fprintf( bad_file, "this is not a FASTQ record\n" );
+                fclose( bad_file );
+            }
+
+            SharedPointer<io::SequenceDataStream> bad_file( parallel ?
+                open_parallel_file( bad_name, 2u, 16*1024 ) :
+                io::open_sequence_file( bad_name ) );
+            if (is_open( bad_file, bad_name ) == false)
+            {
+                remove( bad_name );
+                return 0;
+            }
+
+            uint64 n_reads = 0;
+            bool   error;
+            {
+                io::AsyncSequenceDataStream async_stream( bad_file.get(), DNA_N, 100 );
+
+                while (io::AsyncSequenceDataStream::Batch* batch = async_stream.next())
+                {
+                    n_reads += batch->data[0].size();
+                    async_stream.release( batch );
+                }
+                error = async_stream.error();
+            }
+            remove( bad_name );
+
+            if (error == false || n_reads > 1000)
+            {
+                log_error(stderr,"  read-ahead stream did not report the malformed file with the %s parser (%llu reads)\n", parallel ? "parallel" : "serial", n_reads);
+                return 0;
+            }
         }
     }
     catch (...)
@@ -109,14 +109,27 @@
 /// - \ref SmithWatermanAligner
 /// - \ref GotohAligner
 ///\par
+/// Additionally, the \ref ExtensionAligner performs banded seed extension with an adaptive band
+/// and X-drop/Z-drop termination, reporting its clipping information to an ExtensionSink,
+/// while the \ref WavefrontAligner computes Gotoh alignments on the host with the wavefront algorithm (WFA),
+/// whose cost grows with the alignment penalty rather than with the DP matrix size, and can trace them back
+/// in O(s) memory with its bidirectional variant (BiWFA).
+///\par
+/// Protein strings can be aligned with a GotohAligner using a MatrixGotohScheme, which scores substitutions
+/// with a SubstitutionMatrix such as the built-in BLOSUM62 (see blosum62_matrix()) or any matrix loaded
+/// from an NCBI matrix file (see load_substitution_matrix()); the HostSimdScheduler precomputes score
+/// profiles for such schemes.
+///\par
 /// These objects are parameterized by an \ref AlignmentTypeModule "AlignmentType", which can be any of GLOBAL,
 /// SEMI_GLOBAL or LOCAL, and an \ref AlgorithmTag "Algorithm Tag", which specifies the
 /// actual algorithm to employ.
-/// At the moment, there are three such algorithms:
+/// At the moment, there are five such algorithms:
 ///\par
 /// - \ref PatternBlockingTag : a DP algorithm which blocks the matrix in stripes along the pattern
 /// - \ref TextBlockingTag : a DP algorithm which blocks the matrix in stripes along the text
 /// - \ref MyersTag : the Myers bit-vector algorithm, a very fast algorithm to perform edit distance computations
+/// - \ref StripedTag : Farrar's striped SIMD algorithm, a host-only algorithm for Gotoh scoring of long alignments
+/// - \ref DifferenceRecurrenceTag : an 8-bit SIMD algorithm for banded Gotoh scoring on the host, suited to wide bands
 ///
 /// \section TracebackSection Traceback
 ///\par
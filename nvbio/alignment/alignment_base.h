@@ -64,7 +64,9 @@ enum AlignmentType { GLOBAL, LOCAL, SEMI_GLOBAL };
 /// the amount of temporary storage needed (for long texts, text-blocking is preferred).
 ///\par
 /// Additionally, for \ref EditDistanceAligner "edit distance", the Myers bit-vector algorithm
-/// is available.
+/// is available, while for \ref GotohAligner "Gotoh" scoring on the host long alignments can
+/// be computed with Farrar's striped SIMD algorithm, and wide bands with 8-bit difference
+/// recurrences.
 ///@{
 
 /// an algorithm that blocks the DP matrix along the pattern, in stripes parallel to the text
@@ -78,7 +80,10 @@ struct PatternBlockingTag {};  ///< block along the pattern
 ///\anchor TextBlockingTag
 struct TextBlockingTag {};     ///< block along the text (at the moment, this is only supported for scoring)
 
-/// Myers bit-vector algorithm, only supported for the EditDistanceAligner
+/// Myers bit-vector algorithm, only supported for the EditDistanceAligner.
+/// Banded alignment supports patterns up to the band length; full DP scoring is host-only,
+/// and supports global and semi-global alignment of patterns of any length using Hyyrö's
+/// multi-word blocks (see myers_inl.h).
 ///
 ///\tparam ALPHABET_SIZE_T      the size of the alphabet, in symbols; currently there are fast
 ///                             specializations for alphabets of 2, 4 and 5 symbols.
@@ -86,6 +91,21 @@ struct TextBlockingTag {};     ///< block along the text (at the moment, this is
 ///\anchor MyersTag
 template <uint32 ALPHABET_SIZE_T> struct MyersTag { static const uint32 ALPHABET_SIZE = ALPHABET_SIZE_T; }; ///< Myers bit-vector algorithm
 
+/// Farrar's striped intra-sequence SIMD algorithm, laying out the pattern across the lanes of
+/// host vectors with a precomputed query profile; only supported for host-side scoring with
+/// the GotohAligner (see gotoh_striped_inl.h)
+///
+///\anchor StripedTag
+struct StripedTag {};          ///< host-side striped SIMD scoring
+
+/// Suzuki and Kasahara's difference recurrences, storing the differences between adjacent cells
+/// rather than the scores themselves so that they fit in 8-bit lanes however long the alignment;
+/// only supported for host-side banded global and semi-global scoring with the GotohAligner
+/// (see gotoh_banded_diff_inl.h), while other uses fall back to the PatternBlockingTag algorithm
+///
+///\anchor DifferenceRecurrenceTag
+struct DifferenceRecurrenceTag {};  ///< host-side banded int8 difference recurrence scoring
+
 template <typename T> struct transpose_tag {};
 template <>           struct transpose_tag<PatternBlockingTag> { typedef TextBlockingTag type; };
 template <>           struct transpose_tag<TextBlockingTag>    { typedef PatternBlockingTag type; };
@@ -106,6 +126,8 @@ struct SmithWatermanTag {}; ///< the Smith-Waterman aligner tag
 struct GotohTag {};         ///< the Gotoh aligner tag
 struct EditDistanceTag {};  ///< the Edit Distance aligner tag
 struct HammingDistanceTag {};  ///< the Hamming Distance aligner tag
+struct ExtensionTag {};     ///< the seed extension aligner tag
+struct WavefrontTag {};     ///< the wavefront aligner tag
 
 /// A meta-function specifying the aligner tag of an \ref Aligner "Aligner"
 ///
@@ -167,6 +189,7 @@ enum State
 ///     - EditDistanceAligner
 ///     - SmithWatermanAligner
 ///     - GotohAligner
+///     - ExtensionAligner
 ///@{
 ///
 
@@ -411,6 +434,101 @@ HammingDistanceAligner<TYPE,scoring_scheme_type,PatternBlockingTag> transpose(co
     return HammingDistanceAligner<TYPE,scoring_scheme_type,PatternBlockingTag>( aligner.scheme );
 }
 
+/// A seed extension algorithm with affine gap penalties, see \ref Aligner
+/// \anchor ExtensionAligner
+///
+/// The alignment is anchored at the beginning of both the pattern and the text (i.e. at the end
+/// of a seed), and can terminate anywhere, as in local alignment.
+/// Only banded scoring is supported: the DP matrix is swept along its anti-diagonals, computing
+/// a window of BAND_LEN cells of each which moves down or right following the best scoring
+/// diagonal (an adaptive band), until either the end of the matrix is reached or one of the
+/// following heuristics kicks in:
+///
+/// - X-drop: the best score in the window falls more than xdrop below the best score so far;
+/// - Z-drop: as above, but allowing for the cost of the gap separating the two cells, as in BWA-MEM.
+///
+/// Negative thresholds disable the corresponding test. The end-to-end score needed to decide
+/// whether to clip the pattern can be obtained using an ExtensionSink.
+///
+/// \tparam scoring_scheme_type     specifies the scoring scheme, a model of \ref GotohScoringScheme
+///
+template <typename scoring_scheme_type>
+struct ExtensionAligner
+{
+    static const AlignmentType TYPE =   LOCAL;          ///< the AlignmentType (extensions have a free end)
+
+    typedef ExtensionTag                aligner_tag;    ///< the \ref AlignerTag "Aligner Tag"
+    typedef PatternBlockingTag          algorithm_tag;  ///< the \ref AlgorithmTag "Algorithm Tag"
+
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    ExtensionAligner(const scoring_scheme_type _scheme, const int32 _xdrop = -1, const int32 _zdrop = -1) :
+        scheme(_scheme), xdrop(_xdrop), zdrop(_zdrop) {}
+
+    scoring_scheme_type scheme;
+    int32               xdrop;  ///< X-drop threshold, disabled if negative
+    int32               zdrop;  ///< Z-drop threshold, disabled if negative
+};
+
+template <typename scoring_scheme_type>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+ExtensionAligner<scoring_scheme_type> make_extension_aligner(const scoring_scheme_type& scheme, const int32 xdrop = -1, const int32 zdrop = -1)
+{
+    return ExtensionAligner<scoring_scheme_type>( scheme, xdrop, zdrop );
+}
+
+/// The traceback memory mode of a \ref WavefrontAligner "WavefrontAligner"
+///
+enum WavefrontMemoryMode
+{
+    FULL_WAVEFRONTS,            ///< keep all the wavefronts, using O(s^2) memory for an alignment of penalty s
+    BIDIRECTIONAL_WAVEFRONTS    ///< BiWFA: find a breakpoint meeting forward and reverse wavefronts and recurse, using O(s) memory
+};
+
+/// A gap-affine wavefront alignment (WFA) algorithm, see \ref Aligner
+/// \anchor WavefrontAligner
+///
+/// Rather than filling the DP matrix, WFA computes the furthest reaching cell of each diagonal
+/// for increasing values of the alignment penalty, extending each along exact matches for free:
+/// its cost is O((M+N) s) for an alignment of penalty s, instead of O(M N), which makes it the
+/// algorithm of choice for verifying high identity pairs.
+/// The scores of the given Gotoh scheme are mapped to equivalent penalties, following Eizenga
+/// and Paten: a match bonus is supported for global alignment, while semi-global alignment requires
+/// a match score of zero, as in end-to-end read mapping; as the latter starts a diagonal at each
+/// text position, its cost grows to O(N s), and it only pays off on texts not much longer than
+/// the pattern.
+/// All other configurations, i.e. local alignment, match bonuses with semi-global alignment, scores
+/// depending on the base qualities or on the symbols of the strings (as with substitution matrices,
+/// or schemes scoring N's differently), or different gap penalties for the pattern and the text,
+/// fall back to the GotohAligner.
+/// Only host-side whole-pattern scoring and traceback are supported; the score sinks are passed
+/// the optimal alignment ends only.
+///
+/// \tparam TYPE                    specifies whether the alignment is LOCAL, GLOBAL or SEMI_GLOBAL
+/// \tparam scoring_scheme_type     specifies the scoring scheme, a model of \ref GotohScoringScheme
+///
+template <AlignmentType T_TYPE, typename scoring_scheme_type>
+struct WavefrontAligner
+{
+    static const AlignmentType TYPE =   T_TYPE;         ///< the AlignmentType
+
+    typedef WavefrontTag                aligner_tag;    ///< the \ref AlignerTag "Aligner Tag"
+    typedef PatternBlockingTag          algorithm_tag;  ///< the \ref AlgorithmTag "Algorithm Tag" (used by the Gotoh fallback)
+
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    WavefrontAligner(const scoring_scheme_type _scheme, const WavefrontMemoryMode _memory_mode = FULL_WAVEFRONTS) :
+        scheme(_scheme), memory_mode(_memory_mode) {}
+
+    scoring_scheme_type scheme;
+    WavefrontMemoryMode memory_mode;    ///< the traceback memory mode
+};
+
+template <AlignmentType TYPE, typename scoring_scheme_type>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+WavefrontAligner<TYPE,scoring_scheme_type> make_wavefront_aligner(const scoring_scheme_type& scheme, const WavefrontMemoryMode memory_mode = FULL_WAVEFRONTS)
+{
+    return WavefrontAligner<TYPE,scoring_scheme_type>( scheme, memory_mode );
+}
+
 ///@} // end of the Aligner group
 
 ///@} // end of the Alignment group
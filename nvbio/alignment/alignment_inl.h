@@ -33,7 +33,10 @@
 #include <nvbio/alignment/sw/sw_inl.h>
 #include <nvbio/alignment/ed/ed_inl.h>
 #include <nvbio/alignment/gotoh/gotoh_inl.h>
+#include <nvbio/alignment/gotoh/gotoh_striped_inl.h>
+#include <nvbio/alignment/myers/myers_inl.h>
 #include <nvbio/alignment/hamming/hamming_inl.h>
+#include <nvbio/alignment/wfa/wfa_inl.h>
 
 #if defined(__CUDACC__)
 #include <nvbio/alignment/sw/sw_warp_inl.h>
@@ -464,6 +467,247 @@ Alignment<int32> alignment_traceback(
     return Alignment<int32>( best.score, sink, best.sink );
 }
 
+namespace priv {
+
+///@addtogroup private
+///@{
+
+//
+// A checkpoint storage adaptor used by the coarse pass of two-level traceback:
+// only one every STRIDE checkpoints is kept, while all others are written to a
+// scratch area.
+//
+template <typename checkpoints_type>
+struct coarse_checkpoints
+{
+    typedef typename std::iterator_traits<checkpoints_type>::value_type value_type;
+    typedef typename std::iterator_traits<checkpoints_type>::reference  reference;
+
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    coarse_checkpoints(checkpoints_type checkpoints, checkpoints_type scratch, const uint32 N, const uint32 stride) :
+        m_checkpoints( checkpoints ), m_scratch( scratch ), m_N( N ), m_stride( stride ) {}
+
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    reference operator[] (const uint32 i) const
+    {
+        const uint32 checkpoint_id = i / m_N;
+        const uint32 row           = i - checkpoint_id * m_N;
+
+        return (checkpoint_id % m_stride) == 0u ?
+            m_checkpoints[ (checkpoint_id / m_stride) * m_N + row ] :
+            m_scratch[ row ];
+    }
+
+    checkpoints_type m_checkpoints;
+    checkpoints_type m_scratch;
+    uint32           m_N;
+    uint32           m_stride;
+};
+
+//
+// A checkpoint storage adaptor shifting all indices by a constant offset, used to
+// address the fine checkpoints of two-level traceback with their global ids
+//
+template <typename checkpoints_type>
+struct shifted_checkpoints
+{
+    typedef typename std::iterator_traits<checkpoints_type>::value_type value_type;
+    typedef typename std::iterator_traits<checkpoints_type>::reference  reference;
+
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    shifted_checkpoints(checkpoints_type checkpoints, const int32 shift) :
+        m_checkpoints( checkpoints ), m_shift( shift ) {}
+
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    reference operator[] (const uint32 i) const { return m_checkpoints[ uint32( int32(i) + m_shift ) ]; }
+
+    checkpoints_type m_checkpoints;
+    int32            m_shift;
+};
+
+///@} // end of private group
+
+} // namespace priv
+
+//
+// Return the stride between the coarse checkpoints of two-level traceback,
+// i.e. the square root of the number of checkpoints, rounded up.
+//
+// \param n_checkpoints        the total number of checkpoints
+//
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+uint32 two_level_checkpoint_stride(const uint32 n_checkpoints)
+{
+    uint32 stride = 1u;
+    while (stride * stride < n_checkpoints)
+        ++stride;
+
+    return stride;
+}
+
+//
+// Backtrace an optimal alignment using a full DP algorithm and two levels of checkpoints.
+//
+// \tparam CHECKPOINTS         number of DP rows between each checkpoint
+// \tparam aligner_type        an \ref Aligner "Aligner" algorithm
+// \tparam pattern_string      a string representing the pattern.
+// \tparam qual_string         an array representing the pattern qualities.
+// \tparam text_string         a string representing the text.
+// \tparam backtracer_type     a model of \ref Backtracer.
+//
+// \param aligner              alignment algorithm
+// \param pattern              pattern to be aligned
+// \param quals                pattern quality scores
+// \param text                 text to align the pattern to
+// \param min_score            minimum accepted score
+// \param backtracer           backtracking delegate
+// \param stride               the number of checkpoints between each coarse checkpoint
+// \param coarse_checkpoints   temporary coarse checkpoints storage
+// \param fine_checkpoints     temporary fine checkpoints storage
+// \param submatrix            temporary submatrix storage
+// \param column               temporary column storage
+//
+// \return                     reported alignment
+//
+template <
+    uint32          CHECKPOINTS,
+    typename        aligner_type,
+    typename        pattern_string,
+    typename        qual_string,
+    typename        text_string,
+    typename        backtracer_type,
+    typename        checkpoints_type,
+    typename        submatrix_type,
+    typename        column_type>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+Alignment<int32> alignment_traceback(
+    const aligner_type      aligner,
+    const pattern_string    pattern,
+    const qual_string       quals,
+    const text_string       text,
+    const int32             min_score,
+    backtracer_type&        backtracer,
+    const uint32            stride,
+    checkpoints_type        coarse_checkpoints,
+    checkpoints_type        fine_checkpoints,
+    submatrix_type          submatrix,
+    column_type             column)
+{
+    //
+    // This function follows exactly the same steps as the single-level version above,
+    // except that the first scoring pass only retains one every 'stride' checkpoints:
+    // the fine checkpoints of each group are then recomputed from the coarse one when
+    // backtracking enters the group, using windowed checkpointed scoring.
+    // As the recomputed checkpoints are identical, so is the resulting alignment.
+    //
+
+    const uint32 N = text.length();
+
+    // the submatrix height is equal to the text length (remember the DP matrix has the pattern as rows and the text as columns)
+    const uint32 submatrix_height = N;
+
+    // compute a set of coarse checkpoints along the pattern, using the fine storage as scratch
+    BestSink<int32> best;
+    alignment_score_checkpoints<CHECKPOINTS>(
+        aligner, pattern, quals, text, min_score, best,
+        priv::coarse_checkpoints<checkpoints_type>( coarse_checkpoints, fine_checkpoints, N, stride ),
+        column );
+
+    const uint32 n_checkpoints = (pattern.length() + CHECKPOINTS-1)/CHECKPOINTS;
+
+    // check whether we found a valid alignment
+    uint2 sink = best.sink;
+    if (sink.x == uint32(-1) ||
+        sink.y == uint32(-1))
+        return Alignment<int32>( best.score, make_uint2( uint32(-1), uint32(-1) ), make_uint2( uint32(-1), uint32(-1) ) );
+
+    // clip the end of the pattern, in case the alignment terminated early
+    backtracer.clip( pattern.length() - sink.y );
+
+    // find the checkpoint containing the sink
+    int32 checkpoint_id = n_checkpoints-1;
+
+    if (aligner_type::TYPE == LOCAL)
+    {
+        for (; checkpoint_id >= 0; --checkpoint_id)
+        {
+            if (checkpoint_id * CHECKPOINTS < sink.y)
+                break;
+        }
+    }
+
+    //store state (H, E, or F) between checkpoints
+    uint8 state = HSTATE;
+
+    // the group whose fine checkpoints are currently available
+    int32 group = -1;
+
+    // backtrack until needed
+    for (; checkpoint_id >= 0; --checkpoint_id)
+    {
+        const uint32 group_begin = (checkpoint_id / stride) * stride;
+
+        typedef priv::shifted_checkpoints<checkpoints_type> group_checkpoints_type;
+        const group_checkpoints_type group_checkpoints( fine_checkpoints, -int32( group_begin * N ) );
+
+        if (int32( checkpoint_id / stride ) != group)
+        {
+            group = checkpoint_id / stride;
+
+            // restore the coarse checkpoint
+            for (uint32 i = 0; i < N; ++i)
+                fine_checkpoints[i] = coarse_checkpoints[ group * N + i ];
+
+            // and recompute the following ones, up to the current one
+            for (uint32 c = group_begin + 1; c <= uint32( checkpoint_id ); ++c)
+            {
+                for (uint32 i = 0; i < N; ++i)
+                    group_checkpoints[ c * N + i ] = group_checkpoints[ (c-1) * N + i ];
+
+                NullSink null_sink;
+                alignment_score(
+                    aligner, pattern, quals, text, Field_traits<int32>::min(),
+                    (c-1) * CHECKPOINTS,
+                    c * CHECKPOINTS,
+                    null_sink,
+                    priv::shifted_checkpoints<checkpoints_type>( fine_checkpoints, int32( (c - group_begin) * N ) ),
+                    column );
+            }
+        }
+
+        const uint32 submatrix_width = alignment_score_submatrix<CHECKPOINTS>(
+            aligner, pattern, quals, text, min_score, group_checkpoints, checkpoint_id, submatrix, column );
+
+        if (priv::alignment_traceback<CHECKPOINTS>(
+            aligner, group_checkpoints, checkpoint_id, submatrix, submatrix_width, submatrix_height, state, sink, backtracer ))
+            break;
+    }
+
+    // finish backtracking along the first row and first column (not explicitly stored)
+    // until we get to a cell containing the value zero.
+    if (aligner_type::TYPE == SEMI_GLOBAL || aligner_type::TYPE == GLOBAL)
+    {
+        if (sink.x == 0)
+        {
+            for (; sink.y > 0; --sink.y)
+                backtracer.push( INSERTION );
+        }
+    }
+    if (aligner_type::TYPE == GLOBAL)
+    {
+        if (sink.y == 0)
+        {
+            for (; sink.x > 0; --sink.x)
+                backtracer.push( DELETION );
+        }
+    }
+
+    // clip the beginning of the alignment
+    backtracer.clip( sink.y );
+
+    return Alignment<int32>( best.score, sink, best.sink );
+}
+
 //
 // Backtrace an optimal alignment using a full DP algorithm.
 //
@@ -33,7 +33,9 @@
 #include <nvbio/alignment/ed/ed_banded_inl.h>
 #include <nvbio/alignment/sw/sw_banded_inl.h>
 #include <nvbio/alignment/gotoh/gotoh_banded_inl.h>
+#include <nvbio/alignment/gotoh/gotoh_banded_diff_inl.h>
 #include <nvbio/alignment/myers/myers_banded_inl.h>
+#include <nvbio/alignment/extension/extension_inl.h>
 namespace nvbio {
 namespace aln {
 
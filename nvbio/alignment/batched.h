@@ -28,6 +28,7 @@
 #pragma once
 
 #include <nvbio/alignment/alignment.h>
+#include <vector>
 
 namespace nvbio {
 namespace aln {
@@ -38,9 +39,10 @@ namespace aln {
 ///
 ///@defgroup BatchScheduler Batch Schedulers
 /// A Batch Scheduler is a tag specifying the algorithm used to execute a batch of jobs in parallel.
-/// Four such algorithms are currently available:
+/// Five such algorithms are currently available:
 ///
 ///     - HostThreadScheduler
+///     - HostSimdScheduler
 ///     - DeviceThreadScheduler (inheriting from DeviceThreadBlockScheduler)
 ///     - DeviceStagedThreadScheduler
 ///     - DeviceWarpScheduler
@@ -50,6 +52,12 @@ namespace aln {
 ///
 struct HostThreadScheduler {};
 
+/// Identify a host inter-sequence SIMD \ref BatchScheduler "batch scheduling" algorithm,
+/// scoring groups of jobs in the lanes of the widest vector instruction set available
+/// (see \ref HostSIMD), with 8-bit and 16-bit saturating arithmetic
+///
+struct HostSimdScheduler {};
+
 /// Identify a device thread-parallel \ref BatchScheduler "batch scheduling" algorithm, specifying
 /// the CUDA kernel grid configuration
 ///
@@ -79,24 +87,40 @@ template <typename T,typename Scheduler>
 struct supports_scheduler { static const bool pred = false; };
 
 template <AlignmentType TYPE, typename AlgorithmTag> struct supports_scheduler<EditDistanceAligner<TYPE,AlgorithmTag>, HostThreadScheduler>         { static const bool pred = true; };
+template <AlignmentType TYPE, typename AlgorithmTag> struct supports_scheduler<EditDistanceAligner<TYPE,AlgorithmTag>, HostSimdScheduler>           { static const bool pred = true; };
 template <AlignmentType TYPE, typename AlgorithmTag> struct supports_scheduler<EditDistanceAligner<TYPE,AlgorithmTag>, DeviceThreadScheduler>       { static const bool pred = true; };
 template <AlignmentType TYPE, typename AlgorithmTag> struct supports_scheduler<EditDistanceAligner<TYPE,AlgorithmTag>, DeviceStagedThreadScheduler> { static const bool pred = true; };
 template <AlignmentType TYPE, typename AlgorithmTag> struct supports_scheduler<EditDistanceAligner<TYPE,AlgorithmTag>, DeviceWarpScheduler>         { static const bool pred = true; };
 
 template <AlignmentType TYPE, typename ScoringScheme, typename AlgorithmTag> struct supports_scheduler<SmithWatermanAligner<TYPE,ScoringScheme,AlgorithmTag>, HostThreadScheduler>          { static const bool pred = true; };
+template <AlignmentType TYPE, typename ScoringScheme, typename AlgorithmTag> struct supports_scheduler<SmithWatermanAligner<TYPE,ScoringScheme,AlgorithmTag>, HostSimdScheduler>            { static const bool pred = true; };
 template <AlignmentType TYPE, typename ScoringScheme, typename AlgorithmTag> struct supports_scheduler<SmithWatermanAligner<TYPE,ScoringScheme,AlgorithmTag>, DeviceThreadScheduler>        { static const bool pred = true; };
 template <AlignmentType TYPE, typename ScoringScheme, typename AlgorithmTag> struct supports_scheduler<SmithWatermanAligner<TYPE,ScoringScheme,AlgorithmTag>, DeviceStagedThreadScheduler>  { static const bool pred = true; };
 template <AlignmentType TYPE, typename ScoringScheme, typename AlgorithmTag> struct supports_scheduler<SmithWatermanAligner<TYPE,ScoringScheme,AlgorithmTag>, DeviceWarpScheduler>          { static const bool pred = true; };
 
 template <AlignmentType TYPE, typename ScoringScheme, typename AlgorithmTag> struct supports_scheduler<GotohAligner<TYPE,ScoringScheme,AlgorithmTag>, HostThreadScheduler>                  { static const bool pred = true; };
+template <AlignmentType TYPE, typename ScoringScheme, typename AlgorithmTag> struct supports_scheduler<GotohAligner<TYPE,ScoringScheme,AlgorithmTag>, HostSimdScheduler>                    { static const bool pred = true; };
 template <AlignmentType TYPE, typename ScoringScheme, typename AlgorithmTag> struct supports_scheduler<GotohAligner<TYPE,ScoringScheme,AlgorithmTag>, DeviceThreadScheduler>                { static const bool pred = true; };
 template <AlignmentType TYPE, typename ScoringScheme, typename AlgorithmTag> struct supports_scheduler<GotohAligner<TYPE,ScoringScheme,AlgorithmTag>, DeviceStagedThreadScheduler>          { static const bool pred = true; };
 template <AlignmentType TYPE, typename ScoringScheme, typename AlgorithmTag> struct supports_scheduler<GotohAligner<TYPE,ScoringScheme,AlgorithmTag>, DeviceWarpScheduler>                  { static const bool pred = true; };
 
+// the unbanded Myers algorithm is host-only
+template <AlignmentType TYPE, uint32 ALPHABET_SIZE> struct supports_scheduler<EditDistanceAligner<TYPE,MyersTag<ALPHABET_SIZE> >, DeviceThreadScheduler>       { static const bool pred = false; };
+template <AlignmentType TYPE, uint32 ALPHABET_SIZE> struct supports_scheduler<EditDistanceAligner<TYPE,MyersTag<ALPHABET_SIZE> >, DeviceStagedThreadScheduler> { static const bool pred = false; };
+template <AlignmentType TYPE, uint32 ALPHABET_SIZE> struct supports_scheduler<EditDistanceAligner<TYPE,MyersTag<ALPHABET_SIZE> >, DeviceWarpScheduler>         { static const bool pred = false; };
+
+// the striped algorithm is host-only
+template <AlignmentType TYPE, typename ScoringScheme> struct supports_scheduler<GotohAligner<TYPE,ScoringScheme,StripedTag>, DeviceThreadScheduler>                { static const bool pred = false; };
+template <AlignmentType TYPE, typename ScoringScheme> struct supports_scheduler<GotohAligner<TYPE,ScoringScheme,StripedTag>, DeviceStagedThreadScheduler>          { static const bool pred = false; };
+template <AlignmentType TYPE, typename ScoringScheme> struct supports_scheduler<GotohAligner<TYPE,ScoringScheme,StripedTag>, DeviceWarpScheduler>                  { static const bool pred = false; };
+
 template <AlignmentType TYPE, typename ScoringScheme, typename AlgorithmTag> struct supports_scheduler<HammingDistanceAligner<TYPE,ScoringScheme,AlgorithmTag>, HostThreadScheduler>            { static const bool pred = true; };
 template <AlignmentType TYPE, typename ScoringScheme, typename AlgorithmTag> struct supports_scheduler<HammingDistanceAligner<TYPE,ScoringScheme,AlgorithmTag>, DeviceThreadScheduler>          { static const bool pred = true; };
 template <AlignmentType TYPE, typename ScoringScheme, typename AlgorithmTag> struct supports_scheduler<HammingDistanceAligner<TYPE,ScoringScheme,AlgorithmTag>, DeviceStagedThreadScheduler>    { static const bool pred = true; };
 
+// the wavefront aligner is host-only
+template <AlignmentType TYPE, typename ScoringScheme> struct supports_scheduler<WavefrontAligner<TYPE,ScoringScheme>, HostThreadScheduler> { static const bool pred = true; };
+
 ///@} // end of BatchScheduler group
 
 ///
@@ -230,6 +254,223 @@ void batch_banded_alignment_score(
     const uint32            max_pattern_length,
     const uint32            max_text_length);
 
+///
+/// A persistent set of per-thread host tiles, into which a HostTiledAlignmentStream unpacks
+/// the strings of each alignment job.
+/// Each thread owns a ring of SLOTS tiles, which are sized on demand to the jobs it processes
+/// and kept across batches: in steady state no allocations are performed, and the tiles of
+/// short-read jobs stay resident in the cache.
+/// A tile stays valid until the same thread has requested SLOTS more, which covers all the
+/// host schedulers (the HostSimdScheduler keeps at most one group of SIMD lanes loaded at a time).
+///
+struct HostTileArena
+{
+    static const uint32 SLOTS = 64;     ///< the number of tiles per thread, at least the number of SIMD lanes
+
+    /// make room for the tiles of the given number of threads; must not be called while
+    /// any thread is requesting tiles
+    ///
+    void reserve(const uint32 n_threads);
+
+    /// return the number of threads the arena has room for
+    ///
+    uint32 size() const { return uint32( m_threads.size() ); }
+
+    /// return the next tile of a given thread, sized to hold at least the given number of bytes
+    ///
+    uint8* tile(const uint32 thread_id, const uint32 size);
+
+    /// return the total number of bytes allocated by the arena
+    ///
+    uint64 allocated_bytes() const;
+
+    struct thread_tiles
+    {
+        thread_tiles() : next( 0u ) {}
+
+        std::vector<uint8>  slots[ SLOTS ];
+        uint32              next;
+        uint8               pad[64];    // keep the ring heads of different threads on separate cache lines
+    };
+
+    std::vector<thread_tiles> m_threads;
+};
+
+///
+/// A host alignment stream which aligns each pattern of a string set to the corresponding text
+/// of another without materializing any copy of the sets: the strings of each job are unpacked
+/// on the fly into a thread-local tile of a HostTileArena, so that the aligners run on plain byte
+/// strings whatever the packing of the inputs.
+/// Any string set can be used, while packed ones are unpacked a word at a time: these include
+/// ConcatenatedStringSet's of packed reads, and InfixSet's of packed reference windows.
+///\par
+/// The stream can be used with the HostThreadScheduler and HostSimdScheduler, and with both
+/// BatchedAlignmentScore and BatchedBandedAlignmentScore; the sinks are reset for each job.
+///
+/// \tparam aligner_type        an \ref Aligner "Aligner" algorithm
+/// \tparam pattern_set_type    a string set storing the patterns
+/// \tparam qualities_set_type  a string set storing the qualities
+/// \tparam text_set_type       a string set storing the texts
+/// \tparam sink_iterator       a random access iterator to the output alignment sinks
+///
+template <
+    typename t_aligner_type,
+    typename pattern_set_type,
+    typename qualities_set_type,
+    typename text_set_type,
+    typename sink_iterator>
+struct HostTiledAlignmentStream
+{
+    typedef t_aligner_type                                              aligner_type;
+
+    typedef vector_view<const uint8*>                                   pattern_string;
+    typedef vector_view<const uint8*>                                   text_string;
+    typedef typename qualities_set_type::string_type                    quals_string;
+    typedef typename std::iterator_traits<sink_iterator>::value_type    sink_type;
+
+    /// an alignment context
+    ///
+    struct context_type
+    {
+        int32                   min_score;
+        sink_type               sink;
+    };
+    /// a container for the strings to be aligned, pointing to the tile they were unpacked into
+    ///
+    struct strings_type
+    {
+        pattern_string          pattern;
+        quals_string            quals;
+        text_string             text;
+    };
+
+    /// constructor
+    ///
+    /// \param aligner              the aligner
+    /// \param patterns             the patterns string set
+    /// \param quals                the pattern qualities string set
+    /// \param texts                the texts string set
+    /// \param sinks                the output alignment sinks
+    /// \param arena                the persistent tile arena, sized here to the number of threads
+    /// \param max_pattern_length   the maximum pattern length
+    /// \param max_text_length      the maximum text length
+    ///
+    HostTiledAlignmentStream(
+        const aligner_type          aligner,
+        const pattern_set_type      patterns,
+        const qualities_set_type    quals,
+        const text_set_type         texts,
+              sink_iterator         sinks,
+              HostTileArena&        arena,
+        const uint32                max_pattern_length,
+        const uint32                max_text_length);
+
+    /// get the aligner
+    ///
+    const aligner_type& aligner() const { return m_aligner; };
+
+    /// return the maximum pattern length
+    ///
+    uint32 max_pattern_length() const { return m_max_pattern_length; }
+
+    /// return the maximum text length
+    ///
+    uint32 max_text_length() const { return m_max_text_length; }
+
+    /// return the stream size
+    ///
+    uint32 size() const { return m_patterns.size(); }
+
+    /// return the i-th pattern's length
+    ///
+    uint32 pattern_length(const uint32 i, context_type* context) const { return m_patterns[i].length(); }
+
+    /// return the i-th text's length
+    ///
+    uint32 text_length(const uint32 i, context_type* context) const { return m_texts[i].length(); }
+
+    /// initialize the i-th context
+    ///
+    bool init_context(
+        const uint32    i,
+        context_type*   context) const
+    {
+        // initialize the sink
+        context->sink = sink_type();
+
+        context->min_score = Field_traits<int32>::min();
+        return true;
+    }
+
+    /// unpack the i-th pattern and text into the calling thread's next tile
+    ///
+    void load_strings(
+        const uint32        i,
+        const uint32        window_begin,
+        const uint32        window_end,
+        const context_type* context,
+              strings_type* strings) const;
+
+    /// handle the output
+    ///
+    void output(
+        const uint32        i,
+        const context_type* context) const
+    {
+        // copy the sink
+        m_sinks[i] = context->sink;
+    }
+
+    aligner_type        m_aligner;
+    pattern_set_type    m_patterns;
+    qualities_set_type  m_quals;
+    text_set_type       m_texts;
+    sink_iterator       m_sinks;
+    HostTileArena*      m_arena;
+    uint32              m_max_pattern_length;
+    uint32              m_max_text_length;
+};
+
+///
+/// A convenience function for aligning a batch of patterns to a corresponding batch of texts on
+/// the host, through a HostTiledAlignmentStream: unlike the other variants, it doesn't allocate any
+/// temporary storage for the input strings, which are unpacked into the tiles of a persistent arena.
+///\par
+/// All the involved string sets and iterators must reside in <em>host memory</em>.
+///
+/// \tparam aligner_type        an \ref Aligner "Aligner" algorithm
+/// \tparam pattern_set_type    a string set storing the patterns
+/// \tparam qualities_set_type  a string set storing the qualities
+/// \tparam text_set_type       a string set storing the texts
+/// \tparam sink_iterator       a random access iterator to the output alignment sinks
+/// \tparam scheduler_type      a host \ref BatchScheduler "Batch Scheduler"
+///
+/// \param aligner              the \ref Aligner "Aligner" algorithm
+/// \param patterns             the patterns string set
+/// \param quals                the pattern qualities string set
+/// \param texts                the texts string set
+/// \param sinks                the output alignment sinks
+/// \param scheduler            the \ref BatchScheduler "Batch Scheduler"
+/// \param arena                the persistent tile arena, to be reused across calls
+///
+template <
+    typename aligner_type,
+    typename pattern_set_type,
+    typename qualities_set_type,
+    typename text_set_type,
+    typename sink_iterator,
+    typename scheduler_type>
+void batch_alignment_score(
+    const aligner_type          aligner,
+    const pattern_set_type      patterns,
+    const qualities_set_type    quals,
+    const text_set_type         texts,
+          sink_iterator         sinks,
+    const scheduler_type        scheduler,
+          HostTileArena&        arena,
+    const uint32                max_pattern_length = 1000,
+    const uint32                max_text_length = 1000);
+
 ///
 /// Execution context for a batch of alignment jobs.
 ///
@@ -352,6 +593,16 @@ struct BatchedBandedAlignmentScore
     void enact(stream_type stream, uint64 temp_size = 0u, uint8* temp = NULL);
 };
 
+///
+/// The checkpointing strategies available to the host-side BatchedAlignmentTraceback
+///
+enum TracebackCheckpointing
+{
+    FULL_CHECKPOINTS        = 0u,   ///< store a DP column every CHECKPOINTS pattern symbols: O(N*M/CHECKPOINTS) storage
+    TWO_LEVEL_CHECKPOINTS   = 1u,   ///< store a DP column every ~sqrt(M/CHECKPOINTS) checkpoints, and recompute the
+                                    ///< others during traceback: O(N*sqrt(M/CHECKPOINTS)) storage, identical alignments
+};
+
 ///
 /// Consume a stream of alignment traceback jobs
 ///
@@ -484,4 +735,5 @@ struct BatchedBandedAlignmentTraceback
 } // namespace nvbio
 
 #include <nvbio/alignment/batched_inl.h>
+#include <nvbio/alignment/batched_simd_inl.h>
 #include <nvbio/alignment/batched_banded_inl.h>
@@ -38,6 +38,7 @@
 #if defined(_OPENMP)
 #include <omp.h>
 #endif
+#include <vector>
 
 namespace nvbio {
 namespace aln {
@@ -45,23 +46,13 @@ namespace aln {
 ///@addtogroup private
 ///@{
 
-template <typename stream_type, typename column_type>
+template <typename stream_type, typename context_type, typename column_type>
 NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
-void batched_alignment_score(stream_type& stream, column_type column, const uint32 work_id, const uint32 thread_id)
+void batched_alignment_score_job(stream_type& stream, context_type& context, column_type column, const uint32 work_id)
 {
     typedef typename stream_type::aligner_type  aligner_type;
-    typedef typename stream_type::context_type  context_type;
     typedef typename stream_type::strings_type  strings_type;
 
-    // load the alignment context
-    context_type context;
-    if (stream.init_context( work_id, &context ) == false)
-    {
-        // handle the output
-        stream.output( work_id, &context );
-        return;
-    }
-
     // compute the end of the current DP matrix window
     const uint32 len = equal<typename aligner_type::algorithm_tag,PatternBlockingTag>() ?
         stream.pattern_length( work_id, &context ) :
@@ -85,6 +76,37 @@ void batched_alignment_score(stream_type& stream, column_type column, const uint
     stream.output( work_id, &context );
 }
 
+template <typename stream_type, typename column_type>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void batched_alignment_score(stream_type& stream, column_type column, const uint32 work_id, const uint32 thread_id)
+{
+    typedef typename stream_type::context_type  context_type;
+
+    // load the alignment context
+    context_type context;
+    if (stream.init_context( work_id, &context ) == false)
+    {
+        // handle the output
+        stream.output( work_id, &context );
+        return;
+    }
+
+    batched_alignment_score_job( stream, context, column, work_id );
+}
+
+// return the cost bin of a DP problem, i.e. the base-2 logarithm of its number of cells
+//
+inline uint32 batched_alignment_cost_bin(const uint32 pattern_len, const uint32 text_len)
+{
+    uint64 cells = uint64( pattern_len ) * uint64( text_len );
+
+    uint32 bin = 0;
+    while (cells >>= 1)
+        ++bin;
+
+    return bin;
+}
+
 template <uint32 BLOCKDIM, uint32 MINBLOCKS, uint32 COLUMN_SIZE, typename stream_type, typename cell_type>
 __global__ void
 __launch_bounds__(BLOCKDIM,MINBLOCKS)
@@ -230,13 +252,25 @@ __global__ void warp_persistent_batched_alignment_score_kernel(stream_type strea
 
 ///
 /// HostThreadScheduler specialization of BatchedAlignmentScore.
+///\par
+/// Jobs are binned by the base-2 logarithm of their DP matrix size and dispatched
+/// largest-first to the OpenMP threads, in dynamically fetched chunks sized so as to
+/// contain a roughly constant number of cells; this keeps all cores busy until the end
+/// of batches whose job lengths vary widely.
+/// Each thread sizes its column storage to the jobs it actually processes, rather than
+/// to the maximum pattern or text length of the whole batch, so that the temporary
+/// storage passed to enact() is not needed.
 ///
 /// \tparam stream_type     the stream of alignment jobs
 ///
 template <typename stream_type>
 struct BatchedAlignmentScore<stream_type,HostThreadScheduler>
 {
-    static const uint32 MAX_THREADS = 128; // whatever CPU we have, we assume we are never going to have more than this number of threads
+    static const uint32 MAX_THREADS     = 128;  // whatever CPU we have, we assume we are never going to have more than this number of threads
+    static const uint32 N_BINS          = 64;   // the number of cost bins
+    static const uint32 NO_BIN          = 255;  // the bin of jobs which needn't be scored
+    static const uint32 LOG_CHUNK_CELLS = 20;   // the (log of the) target number of cells per chunk
+    static const uint32 MAX_CHUNK_SIZE  = 256;  // the maximum number of jobs per chunk
 
     typedef typename stream_type::aligner_type                  aligner_type;
     typedef typename column_storage_type<aligner_type>::type    cell_type;
@@ -270,7 +304,8 @@ struct BatchedAlignmentScore<stream_type,HostThreadScheduler>
 template <typename stream_type>
 uint64 BatchedAlignmentScore<stream_type,HostThreadScheduler>::min_temp_storage(const uint32 max_pattern_len, const uint32 max_text_len, const uint32 stream_size)
 {
-    return column_storage( max_pattern_len, max_text_len ) * MAX_THREADS;
+    // the column storage is allocated by each thread on demand
+    return 0u;
 }
 
 // return the maximum number of bytes required by the algorithm
@@ -278,7 +313,8 @@ uint64 BatchedAlignmentScore<stream_type,HostThreadScheduler>::min_temp_storage(
 template <typename stream_type>
 uint64 BatchedAlignmentScore<stream_type,HostThreadScheduler>::max_temp_storage(const uint32 max_pattern_len, const uint32 max_text_len, const uint32 stream_size)
 {
-    return column_storage( max_pattern_len, max_text_len ) * MAX_THREADS;
+    // the column storage is allocated by each thread on demand
+    return 0u;
 }
 
 // enact the batch execution
@@ -286,38 +322,107 @@ uint64 BatchedAlignmentScore<stream_type,HostThreadScheduler>::max_temp_storage(
 template <typename stream_type>
 void BatchedAlignmentScore<stream_type,HostThreadScheduler>::enact(stream_type stream, uint64 temp_size, uint8* temp)
 {
-    const uint32 column_size = equal<typename aligner_type::algorithm_tag,PatternBlockingTag>() ?
-        uint32( stream.max_pattern_length() ) :
-        uint32( stream.max_text_length() );
+    typedef typename stream_type::context_type context_type;
 
-    const uint64 min_temp_size = min_temp_storage(
-        stream.max_pattern_length(),
-        stream.max_text_length(),
-        stream.size() );
+    const uint32 n_jobs = stream.size();
 
-    nvbio::vector<host_tag,uint8> temp_vec( min_temp_size );
-    cell_type* columns = (cell_type*)nvbio::raw_pointer( temp_vec );
+    // initialize all contexts, and bin the jobs by their cost
+    nvbio::vector<host_tag,context_type> contexts( n_jobs );
+    nvbio::vector<host_tag,uint8>        bins( n_jobs );
 
     #if defined(_OPENMP)
     #pragma omp parallel for
     #endif
-    for (int work_id = 0; work_id < int( stream.size() ); ++work_id)
+    for (int work_id = 0; work_id < int( n_jobs ); ++work_id)
+    {
+        context_type* context = &contexts[ work_id ];
+
+        if (stream.init_context( work_id, context ) == false)
+        {
+            // handle the output
+            stream.output( work_id, context );
+
+            bins[ work_id ] = uint8( NO_BIN );
+            continue;
+        }
+
+        bins[ work_id ] = uint8( batched_alignment_cost_bin(
+            stream.pattern_length( work_id, context ),
+            stream.text_length( work_id, context ) ) );
+    }
+
+    // sort the jobs by decreasing cost bin, so as to start the most expensive ones first
+    // and leave the cheapest to fill the tail
+    uint32 bin_offsets[ N_BINS+1 ] = { 0u };
+    for (uint32 work_id = 0; work_id < n_jobs; ++work_id)
+    {
+        if (bins[ work_id ] != NO_BIN)
+            ++bin_offsets[ N_BINS-1 - bins[ work_id ] ];
+    }
+    for (uint32 i = 0, offset = 0; i <= N_BINS; ++i)
     {
-      #if defined(_OPENMP)
-        const uint32 thread_id = omp_get_thread_num();
-      #else
-        const uint32 thread_id = 0;
-      #endif
+        const uint32 count = bin_offsets[i];
+        bin_offsets[i] = offset;
+        offset += count;
+    }
 
-        // fetch the proper column storage
-        //typedef strided_iterator<cell_type*> column_type;
-        //column_type column = column_type( columns + thread_id, queue_capacity );
+    const uint32 n_active = bin_offsets[ N_BINS ];
 
-        // for the CPU it might be better to keep column storage contiguous
-        cell_type* column = columns + thread_id * column_size;
+    nvbio::vector<host_tag,uint32> order( n_active );
+    {
+        uint32 bin_heads[ N_BINS ];
+        for (uint32 i = 0; i < N_BINS; ++i)
+            bin_heads[i] = bin_offsets[i];
 
-        // and solve the actual alignment problem
-        batched_alignment_score( stream, column, work_id, thread_id );
+        for (uint32 work_id = 0; work_id < n_jobs; ++work_id)
+        {
+            if (bins[ work_id ] != NO_BIN)
+                order[ bin_heads[ N_BINS-1 - bins[ work_id ] ]++ ] = work_id;
+        }
+    }
+
+    // split each bin in chunks of roughly CHUNK_CELLS cells, which threads fetch dynamically
+    std::vector<uint2> chunks;
+    chunks.reserve( util::divide_ri( n_active, 4u ) + N_BINS );
+    for (uint32 i = 0; i < N_BINS; ++i)
+    {
+        const uint32 bin        = N_BINS-1 - i;
+        const uint32 chunk_size = bin >= LOG_CHUNK_CELLS ? 1u : nvbio::min( 1u << (LOG_CHUNK_CELLS - bin), MAX_CHUNK_SIZE );
+
+        for (uint32 begin = bin_offsets[i]; begin < bin_offsets[i+1]; begin += chunk_size)
+            chunks.push_back( make_uint2( begin, nvbio::min( begin + chunk_size, bin_offsets[i+1] ) ) );
+    }
+
+    #if defined(_OPENMP)
+    #pragma omp parallel
+    #endif
+    {
+        // each thread sizes its own column to the largest job it actually sees: as jobs are
+        // processed largest-first, this is typically the very first one
+        nvbio::vector<host_tag,cell_type> column;
+
+        #if defined(_OPENMP)
+        #pragma omp for schedule(dynamic,1)
+        #endif
+        for (int chunk = 0; chunk < int( chunks.size() ); ++chunk)
+        {
+            for (uint32 i = chunks[ chunk ].x; i < chunks[ chunk ].y; ++i)
+            {
+                const uint32 work_id = order[i];
+
+                context_type& context = contexts[ work_id ];
+
+                const uint32 column_size = equal<typename aligner_type::algorithm_tag,PatternBlockingTag>() ?
+                    stream.text_length( work_id, &context ) :
+                    stream.pattern_length( work_id, &context );
+
+                if (column.size() < column_size + 1u)
+                    column.resize( column_size + 1u );
+
+                // and solve the actual alignment problem
+                batched_alignment_score_job( stream, context, nvbio::raw_pointer( column ), work_id );
+            }
+        }
     }
 }
 
@@ -849,6 +954,165 @@ void BatchedAlignmentTraceback<CHECKPOINTS,stream_type,DeviceThreadBlockSchedule
     }
 }
 
+///
+/// HostThreadScheduler specialization of BatchedAlignmentTraceback.
+///\par
+/// Each OpenMP thread sizes its own checkpoint, submatrix and column storage to the jobs
+/// it processes. The checkpointing strategy can be selected per batch: with
+/// TWO_LEVEL_CHECKPOINTS the checkpoint storage of a job grows as N*sqrt(M/CHECKPOINTS)
+/// rather than N*M/CHECKPOINTS, at the cost of scoring each group of checkpoints
+/// twice, while the output alignments are exactly the same.
+///
+/// \tparam CHECKPOINTS     number of DP rows between each checkpoint
+/// \tparam stream_type     the stream of alignment jobs
+///
+template <uint32 CHECKPOINTS, typename stream_type>
+struct BatchedAlignmentTraceback<CHECKPOINTS, stream_type, HostThreadScheduler>
+{
+    typedef typename stream_type::aligner_type                      aligner_type;
+    typedef typename column_storage_type<aligner_type>::type        cell_type;
+    typedef typename checkpoint_storage_type<aligner_type>::type    checkpoint_type;
+
+    /// constructor
+    ///
+    /// \param checkpointing    the checkpointing strategy
+    ///
+    BatchedAlignmentTraceback(const TracebackCheckpointing checkpointing = FULL_CHECKPOINTS) : m_checkpointing( checkpointing ) {}
+
+    /// return the minimum number of bytes required by the algorithm
+    ///
+    static uint64 min_temp_storage(const uint32 max_pattern_len, const uint32 max_text_len, const uint32 stream_size);
+
+    /// return the maximum number of bytes required by the algorithm
+    ///
+    static uint64 max_temp_storage(const uint32 max_pattern_len, const uint32 max_text_len, const uint32 stream_size);
+
+    /// enact the batch execution
+    ///
+    void enact(stream_type stream, uint64 temp_size = 0u, uint8* temp = NULL);
+
+    TracebackCheckpointing m_checkpointing;
+};
+
+// return the minimum number of bytes required by the algorithm
+//
+template <uint32 CHECKPOINTS, typename stream_type>
+uint64 BatchedAlignmentTraceback<CHECKPOINTS,stream_type,HostThreadScheduler>::min_temp_storage(const uint32 max_pattern_len, const uint32 max_text_len, const uint32 stream_size)
+{
+    // all storage is allocated by each thread on demand
+    return 0u;
+}
+
+// return the maximum number of bytes required by the algorithm
+//
+template <uint32 CHECKPOINTS, typename stream_type>
+uint64 BatchedAlignmentTraceback<CHECKPOINTS,stream_type,HostThreadScheduler>::max_temp_storage(const uint32 max_pattern_len, const uint32 max_text_len, const uint32 stream_size)
+{
+    // all storage is allocated by each thread on demand
+    return 0u;
+}
+
+// enact the batch execution
+//
+template <uint32 CHECKPOINTS, typename stream_type>
+void BatchedAlignmentTraceback<CHECKPOINTS,stream_type,HostThreadScheduler>::enact(stream_type stream, uint64 temp_size, uint8* temp)
+{
+    typedef typename stream_type::context_type  context_type;
+    typedef typename stream_type::strings_type  strings_type;
+
+    const uint32 BITS = direction_vector_traits<aligner_type>::BITS;
+    const uint32 ELEMENTS_PER_WORD = 32 / BITS;
+
+    #if defined(_OPENMP)
+    #pragma omp parallel
+    #endif
+    {
+        nvbio::vector<host_tag,checkpoint_type> checkpoints;
+        nvbio::vector<host_tag,uint32>          submatrix_storage;
+        nvbio::vector<host_tag,cell_type>       column;
+
+        #if defined(_OPENMP)
+        #pragma omp for schedule(dynamic)
+        #endif
+        for (int work_id = 0; work_id < int( stream.size() ); ++work_id)
+        {
+            // load the alignment context
+            context_type context;
+            if (stream.init_context( work_id, &context ) == false)
+            {
+                // handle the output
+                stream.output( work_id, &context );
+                continue;
+            }
+
+            const uint32 pattern_len = stream.pattern_length( work_id, &context );
+            const uint32 text_len    = stream.text_length( work_id, &context );
+
+            // load the strings to be aligned
+            strings_type strings;
+            stream.load_strings( work_id, 0, pattern_len, &context, &strings );
+
+            const uint32 n_checkpoints = util::divide_ri( pattern_len, CHECKPOINTS );
+
+            // size the storage for this job
+            const uint32 stride = m_checkpointing == TWO_LEVEL_CHECKPOINTS ?
+                two_level_checkpoint_stride( n_checkpoints ) :
+                n_checkpoints;
+
+            const uint32 n_coarse = m_checkpointing == TWO_LEVEL_CHECKPOINTS ?
+                util::divide_ri( n_checkpoints, stride ) :
+                0u;
+
+            // (aligners which don't rely on checkpointing manage their own storage)
+            if (needs_checkpoint_storage<aligner_type>::pred)
+            {
+                if (checkpoints.size() < (n_coarse + stride) * text_len + 1u)
+                    checkpoints.resize( (n_coarse + stride) * text_len + 1u );
+
+                if (submatrix_storage.size() < (text_len * CHECKPOINTS + ELEMENTS_PER_WORD-1) / ELEMENTS_PER_WORD + 1u)
+                    submatrix_storage.resize( (text_len * CHECKPOINTS + ELEMENTS_PER_WORD-1) / ELEMENTS_PER_WORD + 1u );
+
+                if (column.size() < text_len + 1u)
+                    column.resize( text_len + 1u );
+            }
+
+            PackedStream<uint32*,uint8,BITS,false> submatrix( nvbio::raw_pointer( submatrix_storage ) );
+
+            if (m_checkpointing == TWO_LEVEL_CHECKPOINTS)
+            {
+                context.alignment = alignment_traceback<CHECKPOINTS>(
+                    stream.aligner(),
+                    strings.pattern,
+                    strings.quals,
+                    strings.text,
+                    context.min_score,
+                    context.backtracer,
+                    stride,
+                    nvbio::raw_pointer( checkpoints ),
+                    nvbio::raw_pointer( checkpoints ) + n_coarse * text_len,
+                    submatrix,
+                    nvbio::raw_pointer( column ) );
+            }
+            else
+            {
+                context.alignment = alignment_traceback<CHECKPOINTS>(
+                    stream.aligner(),
+                    strings.pattern,
+                    strings.quals,
+                    strings.text,
+                    context.min_score,
+                    context.backtracer,
+                    nvbio::raw_pointer( checkpoints ),
+                    submatrix,
+                    nvbio::raw_pointer( column ) );
+            }
+
+            // handle the output
+            stream.output( work_id, &context );
+        }
+    }
+}
+
 namespace priv {
 
 //
@@ -1100,6 +1364,201 @@ void batch_banded_alignment_score(
     batch.enact( stream );
 }
 
+// make room for the tiles of the given number of threads
+//
+inline void HostTileArena::reserve(const uint32 n_threads)
+{
+    if (m_threads.size() < n_threads)
+        m_threads.resize( n_threads );
+}
+
+// return the next tile of a given thread, sized to hold at least the given number of bytes
+//
+inline uint8* HostTileArena::tile(const uint32 thread_id, const uint32 size)
+{
+    thread_tiles& tiles = m_threads[ thread_id ];
+
+    std::vector<uint8>& slot = tiles.slots[ tiles.next ];
+    tiles.next = (tiles.next + 1u) % SLOTS;
+
+    // grow geometrically, so that a thread seeing increasingly long jobs reallocates rarely
+    if (slot.size() < size)
+        slot.resize( nvbio::max( size, uint32( 2u * slot.size() ) ) );
+
+    return slot.size() ? &slot[0] : NULL;
+}
+
+// return the total number of bytes allocated by the arena
+//
+inline uint64 HostTileArena::allocated_bytes() const
+{
+    uint64 bytes = 0u;
+    for (uint32 t = 0; t < m_threads.size(); ++t)
+    {
+        for (uint32 i = 0; i < SLOTS; ++i)
+            bytes += m_threads[t].slots[i].capacity();
+    }
+    return bytes;
+}
+
+namespace priv {
+
+//
+// Unpack a generic string into a byte array
+//
+template <typename string_type>
+void unpack_string(const string_type& string, uint8* out)
+{
+    const uint32 len = string.length();
+    for (uint32 i = 0; i < len; ++i)
+        out[i] = uint8( string[i] );
+}
+
+//
+// Unpack the first len symbols of a packed stream into a byte array, streaming through
+// its storage words rather than addressing each symbol separately
+//
+template <typename StorageIterator, typename Symbol, uint32 SYMBOL_SIZE_T, bool BIG_ENDIAN_T, typename IndexType>
+void unpack_packed_stream(const PackedStream<StorageIterator,Symbol,SYMBOL_SIZE_T,BIG_ENDIAN_T,IndexType> stream, const uint32 len, uint8* out)
+{
+    ForwardPackedStream<StorageIterator,Symbol,SYMBOL_SIZE_T,BIG_ENDIAN_T,IndexType> it( stream );
+    for (uint32 i = 0; i < len; ++i, ++it)
+        out[i] = uint8( *it );
+}
+
+//
+// Unpack a packed string, e.g. a string of a ConcatenatedStringSet of PackedStream's
+//
+template <typename StorageIterator, typename Symbol, uint32 SYMBOL_SIZE_T, bool BIG_ENDIAN_T, typename IndexType, typename ViewIndexType>
+void unpack_string(const vector_view< PackedStream<StorageIterator,Symbol,SYMBOL_SIZE_T,BIG_ENDIAN_T,IndexType>, ViewIndexType >& string, uint8* out)
+{
+    unpack_packed_stream( string.base(), string.length(), out );
+}
+
+//
+// Unpack an infix of a PackedStream, e.g. a string of an InfixSet of reference windows
+//
+template <typename StorageIterator, typename Symbol, uint32 SYMBOL_SIZE_T, bool BIG_ENDIAN_T, typename IndexType, typename CoordType>
+void unpack_string(const Infix< PackedStream<StorageIterator,Symbol,SYMBOL_SIZE_T,BIG_ENDIAN_T,IndexType>, CoordType >& string, uint8* out)
+{
+    unpack_packed_stream( string.m_string + string.range().x, string.length(), out );
+}
+
+//
+// Unpack an infix of a packed string, e.g. a string of an InfixSet built on top of a
+// ConcatenatedStringSet of PackedStream's
+//
+template <typename StorageIterator, typename Symbol, uint32 SYMBOL_SIZE_T, bool BIG_ENDIAN_T, typename IndexType, typename ViewIndexType, typename CoordType>
+void unpack_string(const Infix< vector_view< PackedStream<StorageIterator,Symbol,SYMBOL_SIZE_T,BIG_ENDIAN_T,IndexType>, ViewIndexType >, CoordType >& string, uint8* out)
+{
+    unpack_packed_stream( string.m_string.base() + string.range().x, string.length(), out );
+}
+
+} // namespace priv
+
+// constructor
+//
+template <typename aligner_type, typename pattern_set_type, typename qualities_set_type, typename text_set_type, typename sink_iterator>
+HostTiledAlignmentStream<aligner_type,pattern_set_type,qualities_set_type,text_set_type,sink_iterator>::HostTiledAlignmentStream(
+    const aligner_type          aligner,
+    const pattern_set_type      patterns,
+    const qualities_set_type    quals,
+    const text_set_type         texts,
+          sink_iterator         sinks,
+          HostTileArena&        arena,
+    const uint32                max_pattern_length,
+    const uint32                max_text_length) :
+    m_aligner               ( aligner ),
+    m_patterns              ( patterns ),
+    m_quals                 ( quals ),
+    m_texts                 ( texts ),
+    m_sinks                 ( sinks ),
+    m_arena                 ( &arena ),
+    m_max_pattern_length    ( max_pattern_length ),
+    m_max_text_length       ( max_text_length )
+{
+  #if defined(_OPENMP)
+    arena.reserve( omp_get_max_threads() );
+  #else
+    arena.reserve( 1u );
+  #endif
+}
+
+// unpack the i-th pattern and text into the calling thread's next tile
+//
+template <typename aligner_type, typename pattern_set_type, typename qualities_set_type, typename text_set_type, typename sink_iterator>
+void HostTiledAlignmentStream<aligner_type,pattern_set_type,qualities_set_type,text_set_type,sink_iterator>::load_strings(
+    const uint32        i,
+    const uint32        window_begin,
+    const uint32        window_end,
+    const context_type* context,
+          strings_type* strings) const
+{
+  #if defined(_OPENMP)
+    const uint32 thread_id = omp_get_thread_num();
+  #else
+    const uint32 thread_id = 0;
+  #endif
+
+    const typename pattern_set_type::string_type pattern = m_patterns[i];
+    const typename text_set_type::string_type    text    = m_texts[i];
+
+    const uint32 M = pattern.length();
+    const uint32 N = text.length();
+
+    // keep the text 16-byte aligned within the tile
+    uint8* tile = m_arena->tile( thread_id, align<16>( M ) + N );
+
+    priv::unpack_string( pattern, tile );
+    priv::unpack_string( text,    tile + align<16>( M ) );
+
+    strings->pattern = pattern_string( M, tile );
+    strings->quals   = m_quals[i];
+    strings->text    = text_string( N, tile + align<16>( M ) );
+}
+
+//
+// A convenience function for aligning a batch of patterns to a corresponding batch of texts
+// on the host, through a HostTiledAlignmentStream.
+//
+template <
+    typename aligner_type,
+    typename pattern_set_type,
+    typename qualities_set_type,
+    typename text_set_type,
+    typename sink_iterator,
+    typename scheduler_type>
+void batch_alignment_score(
+    const aligner_type          aligner,
+    const pattern_set_type      patterns,
+    const qualities_set_type    quals,
+    const text_set_type         texts,
+          sink_iterator         sinks,
+    const scheduler_type        scheduler,
+          HostTileArena&        arena,
+    const uint32                max_pattern_length,
+    const uint32                max_text_length)
+{
+    typedef HostTiledAlignmentStream<aligner_type,pattern_set_type,qualities_set_type,text_set_type,sink_iterator> stream_type;
+
+    typedef aln::BatchedAlignmentScore<stream_type, scheduler_type> batch_type;  // our batch type
+
+    // create the stream
+    stream_type stream(
+        aligner,
+        patterns,
+        quals,
+        texts,
+        sinks,
+        arena,
+        max_pattern_length,
+        max_text_length );
+
+    // enact the batch
+    batch_type batch;
+    batch.enact( stream );
+}
+
 ///@} // end of BatchAlignment group
 
 ///@} // end of the Alignment group
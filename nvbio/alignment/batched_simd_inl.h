@@ -0,0 +1,811 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <nvbio/alignment/utils.h>
+#include <nvbio/alignment/ed/ed_utils.h>
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/numbers.h>
+#include <nvbio/basic/host_simd.h>
+#include <nvbio/basic/vector.h>
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+namespace nvbio {
+namespace aln {
+
+namespace priv {
+
+///@addtogroup private
+///@{
+
+///
+/// A meta-function telling whether a scoring scheme's substitution scores
+/// only depend on whether the text and pattern symbols match, in which case
+/// they can be computed with vector comparisons rather than with one scoring
+/// scheme invocation per cell.
+///
+template <typename scheme_type> struct simd_constant_substitution                       { static const bool VALUE = false; };
+template <>                     struct simd_constant_substitution<EditDistanceSWScheme>      { static const bool VALUE = true; };
+template <>                     struct simd_constant_substitution<SimpleSmithWatermanScheme> { static const bool VALUE = true; };
+template <>                     struct simd_constant_substitution<SimpleGotohScheme>         { static const bool VALUE = true; };
+
+///
+/// A meta-function returning the alphabet size of a scoring scheme whose substitution scores
+/// only depend on the text and pattern symbols, or zero if they may depend on anything else:
+/// with such schemes the kernel precomputes a score profile of the patterns of each group,
+/// and fetches the substitution scores of each row with plain vector loads.
+///
+template <typename scheme_type> struct simd_profile_substitution                   { static const uint32 SYMBOLS = 0u; };
+template <>                     struct simd_profile_substitution<MatrixGotohScheme> { static const uint32 SYMBOLS = SubstitutionMatrix::SYMBOLS; };
+
+///
+/// Adapt an \ref Aligner "Aligner" to the inter-sequence SIMD kernel, exposing
+/// the DP boundary conditions and the substitution scores in the same form
+/// they assume in the scalar implementations (sw_inl.h and gotoh_inl.h).
+/// The DP matrix is always laid out with the text along the rows and the pattern
+/// along the columns, irrespectively of the aligner's \ref AlgorithmTag "Algorithm Tag",
+/// as both blocking strategies compute the very same matrix.
+///
+template <typename aligner_type> struct simd_scoring {};
+
+///
+/// EditDistanceAligner specialization of simd_scoring
+///
+template <AlignmentType T_TYPE, typename algorithm_tag>
+struct simd_scoring< EditDistanceAligner<T_TYPE,algorithm_tag> >
+{
+    static const AlignmentType TYPE     = T_TYPE;
+    static const bool          AFFINE   = false;
+    static const bool          CONSTANT = true;
+    static const uint32        PROFILE  = 0u;
+
+    simd_scoring(const EditDistanceAligner<T_TYPE,algorithm_tag>& aligner) {}
+
+    int32 substitution(const uint32 i, const uint32 j, const uint8 t, const uint8 p, const uint8 q) const { return t == p ? scheme.match(q) : scheme.mismatch( t, p, q ); }
+    int32 match()       const { return scheme.match(); }        ///< match bonus (constant substitutions)
+    int32 mismatch()    const { return scheme.mismatch(); }     ///< mismatch penalty (constant substitutions)
+
+    int32 text_gap()    const { return scheme.deletion(); }     ///< vertical gap (linear)
+    int32 pattern_gap() const { return scheme.insertion(); }    ///< horizontal gap (linear)
+    int32 gap_open()    const { return 0; }                     ///< gap open (affine)
+    int32 gap_ext()     const { return 0; }                     ///< gap extension (affine)
+
+    int32 row0(const uint32 j) const { return TYPE != LOCAL  ? pattern_gap() * int32(j) : 0; }     ///< H[0][j]
+    int32 col0(const uint32 i) const { return TYPE == GLOBAL ? text_gap() * int32(i+1)  : 0; }     ///< H[i+1][0]
+
+    EditDistanceSWScheme scheme;
+};
+
+///
+/// SmithWatermanAligner specialization of simd_scoring
+///
+template <AlignmentType T_TYPE, typename scoring_type, typename algorithm_tag>
+struct simd_scoring< SmithWatermanAligner<T_TYPE,scoring_type,algorithm_tag> >
+{
+    static const AlignmentType TYPE     = T_TYPE;
+    static const bool          AFFINE   = false;
+    static const bool          CONSTANT = simd_constant_substitution<scoring_type>::VALUE;
+    static const uint32        PROFILE  = 0u;
+
+    simd_scoring(const SmithWatermanAligner<T_TYPE,scoring_type,algorithm_tag>& aligner) : scheme( aligner.scheme ) {}
+
+    int32 substitution(const uint32 i, const uint32 j, const uint8 t, const uint8 p, const uint8 q) const { return t == p ? scheme.match(q) : scheme.mismatch( t, p, q ); }
+    int32 match()       const { return scheme.match(); }        ///< match bonus (constant substitutions)
+    int32 mismatch()    const { return scheme.mismatch(); }     ///< mismatch penalty (constant substitutions)
+
+    int32 text_gap()    const { return scheme.deletion(); }     ///< vertical gap (linear)
+    int32 pattern_gap() const { return scheme.insertion(); }    ///< horizontal gap (linear)
+    int32 gap_open()    const { return 0; }                     ///< gap open (affine)
+    int32 gap_ext()     const { return 0; }                     ///< gap extension (affine)
+
+    int32 row0(const uint32 j) const { return TYPE != LOCAL  ? pattern_gap() * int32(j) : 0; }     ///< H[0][j]
+    int32 col0(const uint32 i) const { return TYPE == GLOBAL ? text_gap() * int32(i+1)  : 0; }     ///< H[i+1][0]
+
+    scoring_type scheme;
+};
+
+///
+/// GotohAligner specialization of simd_scoring
+///
+template <AlignmentType T_TYPE, typename scoring_type, typename algorithm_tag>
+struct simd_scoring< GotohAligner<T_TYPE,scoring_type,algorithm_tag> >
+{
+    static const AlignmentType TYPE     = T_TYPE;
+    static const bool          AFFINE   = true;
+    static const bool          CONSTANT = simd_constant_substitution<scoring_type>::VALUE;
+    static const uint32        PROFILE  = simd_profile_substitution<scoring_type>::SYMBOLS;  ///< the score profile alphabet size, if any
+
+    simd_scoring(const GotohAligner<T_TYPE,scoring_type,algorithm_tag>& aligner) : scheme( aligner.scheme ) {}
+
+    // NOTE: the scalar kernels pass the 1-based pattern column to the scoring scheme
+    int32 substitution(const uint32 i, const uint32 j, const uint8 t, const uint8 p, const uint8 q) const { return scheme.substitution( i, j+1, t, p, q ); }
+    int32 match()       const { return scheme.match(); }                    ///< match bonus (constant substitutions)
+    int32 mismatch()    const { return scheme.mismatch(); }                 ///< mismatch penalty (constant substitutions)
+
+    int32 text_gap()    const { return 0; }                                 ///< vertical gap (linear)
+    int32 pattern_gap() const { return 0; }                                 ///< horizontal gap (linear)
+    int32 gap_open()    const { return scheme.pattern_gap_open(); }         ///< gap open (affine)
+    int32 gap_ext()     const { return scheme.pattern_gap_extension(); }    ///< gap extension (affine)
+
+    int32 row0(const uint32 j) const { return TYPE != LOCAL  ? (j ? gap_open() + gap_ext() * int32(j-1) : 0) : 0; }                         ///< H[0][j]
+    int32 col0(const uint32 i) const { return TYPE == GLOBAL ? scheme.text_gap_open() + scheme.text_gap_extension() * int32(i) : 0; }   ///< H[i+1][0]
+
+    scoring_type scheme;
+};
+
+///
+/// A single job assigned to a SIMD lane
+///
+struct simd_lane
+{
+    uint32          slot;       ///< the job's slot in the group's context array
+    uint32          M;          ///< pattern length
+    uint32          N;          ///< text length
+    const uint8*    pattern;    ///< pattern symbols
+    const uint8*    quals;      ///< pattern qualities
+    const uint8*    text;       ///< text symbols
+    bool            overflow;   ///< whether the scores didn't fit the lane width
+};
+
+/// return the amount of workspace needed by simd_alignment_score()
+///
+/// \param max_pattern_len     the maximum pattern length
+/// \param max_text_len        the maximum text length
+/// \param profile_symbols     the score profile alphabet size (simd_scoring::PROFILE)
+///
+inline uint64 simd_alignment_workspace(const uint32 max_pattern_len, const uint32 max_text_len, const uint32 profile_symbols = 0u)
+{
+    // six full rows (H, F, the substitutions, the best local row and the two clamping rows),
+    // plus the semi-global boundary, a few vectors of scratch and the score profile
+    return uint64( (6u + profile_symbols) * (max_pattern_len + 1u) + max_text_len + 8u ) * HOST_SIMD_BYTES;
+}
+
+/// clamp a 32-bit score to the given lane type, flagging any overflow
+///
+template <typename score_type>
+NVBIO_FORCEINLINE
+score_type simd_clamp(const int32 x, bool& overflow)
+{
+    const int32 lo = int32( Field_traits<score_type>::min() );
+    const int32 hi = int32( Field_traits<score_type>::max() );
+    if (x <= lo || x >= hi)
+        overflow = true;
+
+    return score_type( nvbio::min( nvbio::max( x, lo ), hi ) );
+}
+
+/// return the text symbol shared by all the lanes which are still active at row i, or uint32(-1)
+/// if they see different symbols or a symbol outside of the score profile alphabet
+///
+NVBIO_FORCEINLINE
+uint32 simd_shared_symbol(simd_lane* const* lanes, const uint32 n_lanes, const uint32 i, const uint32 n_symbols)
+{
+    uint32 symbol = uint32(-1);
+    for (uint32 l = 0; l < n_lanes; ++l)
+    {
+        if (i < lanes[l]->N)
+        {
+            const uint32 t_i = lanes[l]->text[i];
+            if (t_i >= n_symbols || (symbol != uint32(-1) && t_i != symbol))
+                return uint32(-1);
+
+            symbol = t_i;
+        }
+    }
+    return symbol;
+}
+
+///
+/// Score up to host_simd<score_type>::WIDTH jobs at once with the inter-sequence
+/// SIMD layout, where each lane of a vector holds a cell of a different DP matrix.
+/// The matrices are swept row by row (i.e. along the text), and all cell updates
+/// use saturating arithmetic: any job whose scores reach the range of score_type
+/// is marked as overflown and left untouched, so that it can be re-run with wider
+/// lanes; all other jobs have their alignments reported to their sinks.
+///\par
+/// Cells lying past the end of a job's pattern or text are computed as well, but are
+/// masked out of any test by means of a pair of clamping rows.
+/// If the scoring scheme supports a score profile (simd_scoring::PROFILE != 0) and enough rows
+/// see the same text symbol in all lanes (e.g. when a single query is searched against a group
+/// of database sequences), the substitution scores of all the lanes' patterns against each symbol
+/// are computed once upfront, and such rows read them in place.
+/// Gap penalties are assumed to be non-positive, as everywhere else in the module,
+/// which guarantees that saturated values can never be "healed" by later updates.
+///
+/// \param scoring      the simd_scoring adaptor
+/// \param lanes        the jobs to score
+/// \param n_lanes      the number of jobs (at most host_simd<score_type>::WIDTH)
+/// \param workspace    a workspace of at least simd_alignment_workspace() bytes
+/// \param contexts     the job contexts, indexed by simd_lane::slot
+///
+template <typename score_type, typename scoring_type, typename context_type>
+void simd_alignment_score(
+    const scoring_type&     scoring,
+          simd_lane**       lanes,
+    const uint32            n_lanes,
+          uint8*            workspace,
+          context_type*     contexts)
+{
+    typedef host_simd<score_type>   simd;
+    typedef typename simd::type     vec;
+
+    const AlignmentType TYPE     = scoring_type::TYPE;
+    const bool          AFFINE   = scoring_type::AFFINE;
+    const bool          CONSTANT = scoring_type::CONSTANT;
+    const uint32        PROFILE  = scoring_type::PROFILE;
+    const uint32        W        = simd::WIDTH;
+
+    const score_type T_MIN = Field_traits<score_type>::min();
+    const score_type T_MAX = Field_traits<score_type>::max();
+
+    uint32 M = 0u;
+    uint32 N = 0u;
+    for (uint32 l = 0; l < n_lanes; ++l)
+    {
+        M = nvbio::max( M, lanes[l]->M );
+        N = nvbio::max( N, lanes[l]->N );
+    }
+
+    // carve the workspace
+    score_type* H        = (score_type*)workspace;
+    score_type* F        = H        + (M+1) * W;
+    score_type* S        = F        + (M+1) * W;       // substitution scores, or pattern symbols if CONSTANT
+    score_type* B        = S        + (M+1) * W;       // the row containing the best local cell
+    score_type* cap_hi   = B        + (M+1) * W;
+    score_type* cap_lo   = cap_hi   + (M+1) * W;
+    score_type* boundary = cap_lo   + (M+1) * W;
+    score_type* row      = boundary + N * W;           // left boundary of the current row (H and E)
+    score_type* text     = row      + 2 * W;           // text symbols of the current row (CONSTANT)
+    score_type* active   = text     + W;               // row activity mask
+    score_type* best     = active   + W;               // best local scores
+    score_type* tmp      = best     + W;
+    score_type* profile  = tmp      + 2 * W;           // the score profile (PROFILE)
+
+    bool   overflow[ W ];
+    uint32 best_row[ W ];
+
+    const vec G   = simd::set1( simd_clamp<score_type>( scoring.text_gap(),    overflow[0] = false ) );
+    const vec I   = simd::set1( simd_clamp<score_type>( scoring.pattern_gap(), overflow[0] ) );
+    const vec G_o = simd::set1( simd_clamp<score_type>( scoring.gap_open(),    overflow[0] ) );
+    const vec G_e = simd::set1( simd_clamp<score_type>( scoring.gap_ext(),     overflow[0] ) );
+    const vec S_m = simd::set1( simd_clamp<score_type>( CONSTANT ? scoring.match()    : 0, overflow[0] ) );
+    const vec S_x = simd::set1( simd_clamp<score_type>( CONSTANT ? scoring.mismatch() : 0, overflow[0] ) );
+
+    // the scoring parameters are shared by all lanes
+    if (overflow[0])
+    {
+        for (uint32 l = 0; l < n_lanes; ++l)
+            lanes[l]->overflow = true;
+        return;
+    }
+
+    // the score profile only pays off if enough rows can read it in place
+    uint32 shared_rows = 0u;
+    for (uint32 i = 0; PROFILE && i < N && shared_rows <= PROFILE; ++i)
+        shared_rows += simd_shared_symbol( lanes, n_lanes, i, PROFILE ) != uint32(-1) ? 1u : 0u;
+
+    const bool   use_profile = shared_rows > PROFILE;
+    const uint32 n_profile   = use_profile ? PROFILE : 0u;
+
+    // initialize row 0, and the clamping rows used to restrict all tests to the cells
+    // which actually belong to each job
+    for (uint32 l = 0; l < W; ++l)
+    {
+        const uint32 M_l = l < n_lanes ? lanes[l]->M : 0u;
+
+        overflow[l] = false;
+        best_row[l] = 0u;
+
+        row[l]      = 0;
+        row[W + l]  = T_MIN;
+        text[l]     = 0;
+        active[l]   = l < n_lanes ? score_type(-1) : score_type(0);
+        best[l]     = T_MIN;
+
+        for (uint32 j = 0; j <= M; ++j)
+        {
+            bool o = false;
+            H[ j*W + l ]      = simd_clamp<score_type>( scoring.row0(j), o );
+            F[ j*W + l ]      = T_MIN;
+            S[ j*W + l ]      = CONSTANT && j < M_l ? score_type( lanes[l]->pattern[j] ) : T_MIN;
+            B[ j*W + l ]      = T_MIN;
+            cap_hi[ j*W + l ] = j <= M_l ? T_MAX : T_MIN;
+            cap_lo[ j*W + l ] = j <= M_l ? T_MIN : T_MAX;
+
+            if (j <= M_l)
+                overflow[l] |= o;
+        }
+
+        // build the score profile of the lane's pattern
+        for (uint32 a = 0; a < n_profile; ++a)
+        {
+            for (uint32 j = 0; j < M; ++j)
+            {
+                bool o = false;
+                profile[ (a*M + j)*W + l ] = j < M_l ?
+                    simd_clamp<score_type>( scoring.substitution( 0u, j, uint8(a), lanes[l]->pattern[j], lanes[l]->quals[j] ), o ) :
+                    T_MIN;
+
+                overflow[l] |= o;
+            }
+        }
+    }
+
+    const vec zero = simd::zero();
+
+    vec best_score = simd::set1( T_MIN );
+
+    // loop across the long edge of the DP matrix (i.e. the rows)
+    for (uint32 i = 0; i < N; ++i)
+    {
+        // the substitution scores of this row
+        const score_type* S_row = S;
+
+        // if all the active lanes see the same text symbol, use the row of the score profile in place
+        const uint32 symbol = use_profile ? simd_shared_symbol( lanes, n_lanes, i, PROFILE ) : uint32(-1);
+        if (symbol != uint32(-1))
+            S_row = profile + symbol*M*W;
+
+        // setup the left boundary, and the substitution scores or the text symbols of this row
+        for (uint32 l = 0; l < n_lanes; ++l)
+        {
+            const simd_lane& lane = *lanes[l];
+
+            if (i < lane.N)
+            {
+                const uint8 t_i = lane.text[i];
+
+                bool o = false;
+                if (CONSTANT)
+                    text[l] = score_type( t_i );
+                else if (use_profile && t_i < PROFILE)
+                {
+                    // gather the lane's scores from the profile
+                    if (S_row == S)
+                    {
+                        for (uint32 j = 0; j < lane.M; ++j)
+                            S[ j*W + l ] = profile[ (t_i*M + j)*W + l ];
+                    }
+                }
+                else
+                {
+                    for (uint32 j = 0; j < lane.M; ++j)
+                        S[ j*W + l ] = simd_clamp<score_type>( scoring.substitution( i, j, t_i, lane.pattern[j], lane.quals[j] ), o );
+                }
+
+                row[l]     = simd_clamp<score_type>( scoring.col0(i), o );
+                row[W + l] = TYPE == LOCAL ? score_type(0) : T_MIN;
+
+                overflow[l] |= o;
+            }
+            else if (i == lane.N)
+                active[l] = 0;
+        }
+
+        const vec t_i = simd::load( text );
+
+        vec diag = simd::load( H );
+        vec left = simd::load( row );
+        vec E    = simd::load( row + W );
+        simd::store( H, left );
+
+        vec row_max = simd::set1( T_MIN );
+        vec row_min = simd::set1( T_MAX );
+
+        // loop across the short edge of the DP matrix (i.e. the columns)
+        for (uint32 j = 1; j <= M; ++j)
+        {
+            const vec top = simd::load( H + j*W );
+            const vec s   = CONSTANT ?
+                simd::blend( S_x, S_m, simd::cmpeq( simd::load( S + (j-1)*W ), t_i ) ) :
+                simd::load( S_row + (j-1)*W );
+
+            vec h;
+            if (AFFINE)
+            {
+                const vec f = simd::max( simd::adds( simd::load( F + j*W ), G_e ), simd::adds( top, G_o ) );
+                simd::store( F + j*W, f );
+
+                E = simd::max( simd::adds( E, G_e ), simd::adds( left, G_o ) );
+                h = simd::max( simd::max( E, f ), simd::adds( diag, s ) );
+            }
+            else
+                h = simd::max( simd::max( simd::adds( top, G ), simd::adds( left, I ) ), simd::adds( diag, s ) );
+
+            if (TYPE == LOCAL)
+                h = simd::max( h, zero ); // clamp to zero
+            else
+                row_min = simd::min( row_min, simd::max( h, simd::load( cap_lo + j*W ) ) );
+
+            row_max = simd::max( row_max, simd::min( h, simd::load( cap_hi + j*W ) ) );
+
+            simd::store( H + j*W, h );
+            diag = top;
+            left = h;
+        }
+
+        const vec row_active = simd::load( active );
+
+        if (TYPE == LOCAL)
+        {
+            // keep track of the last row containing the best cell of each job
+            const vec improved = simd::and_op( simd::or_op( simd::cmpgt( row_max, best_score ), simd::cmpeq( row_max, best_score ) ), row_active );
+            if (simd::any( improved ))
+            {
+                best_score = simd::blend( best_score, row_max, improved );
+
+                for (uint32 j = 1; j <= M; ++j)
+                    simd::store( B + j*W, simd::blend( simd::load( B + j*W ), simd::load( H + j*W ), improved ) );
+
+                simd::store( tmp, improved );
+                for (uint32 l = 0; l < n_lanes; ++l)
+                {
+                    if (tmp[l])
+                        best_row[l] = i;
+                }
+            }
+        }
+        else
+        {
+            // check for overflows, and save the last column
+            simd::store( tmp,     row_max );
+            simd::store( tmp + W, row_min );
+
+            for (uint32 l = 0; l < n_lanes; ++l)
+            {
+                const simd_lane& lane = *lanes[l];
+                if (i >= lane.N)
+                    continue;
+
+                if (tmp[l] == T_MAX || tmp[W + l] == T_MIN)
+                    overflow[l] = true;
+
+                if (TYPE == SEMI_GLOBAL || i+1 == lane.N)
+                    boundary[ i*W + l ] = H[ lane.M*W + l ];
+            }
+        }
+    }
+
+    simd::store( best, best_score );
+
+    // report the alignments of all the jobs that didn't overflow
+    for (uint32 l = 0; l < n_lanes; ++l)
+    {
+        simd_lane& lane = *lanes[l];
+
+        if (TYPE == LOCAL && best[l] == T_MAX)
+            overflow[l] = true;
+
+        if (overflow[l])
+        {
+            lane.overflow = true;
+            continue;
+        }
+
+        context_type& context = contexts[ lane.slot ];
+
+        if (TYPE == LOCAL)
+        {
+            // find the right-most best cell in the best row
+            uint32 best_col = 0u;
+            for (uint32 j = 1; j <= lane.M; ++j)
+            {
+                if (B[ j*W + l ] == best[l])
+                    best_col = j;
+            }
+            context.sink.report( int32( best[l] ), make_uint2( best_row[l]+1, best_col ) );
+        }
+        else if (TYPE == GLOBAL)
+            context.sink.report( int32( boundary[ (lane.N-1)*W + l ] ), make_uint2( lane.N, lane.M ) );
+        else
+        {
+            for (uint32 i = 0; i < lane.N; ++i)
+                context.sink.report( int32( boundary[ i*W + l ] ), make_uint2( i+1, lane.M ) );
+        }
+    }
+}
+
+///@} // end of the private group
+
+} // namespace priv
+
+///@addtogroup BatchAlignment
+///@{
+
+///
+/// HostSimdScheduler specialization of BatchedAlignmentScore.
+///\par
+/// Jobs are processed in groups of host_simd<int8>::WIDTH consecutive stream elements,
+/// each distributed across OpenMP threads.
+/// Each group is first scored with 8-bit saturating lanes; the jobs whose scores
+/// overflow are re-scored with 16-bit lanes, and any job that still doesn't fit
+/// (or is empty) falls back to the scalar 32-bit implementation.
+///\par
+/// For local alignment, each sink receives a single report for the best scoring
+/// cell (the right-most in the bottom-most row among ties), rather than one per cell;
+/// for global and semi-global alignment the reports match those of the scalar kernels.
+/// The min_score early-exit is not applied.
+///
+/// \tparam stream_type     the stream of alignment jobs
+///
+template <typename stream_type>
+struct BatchedAlignmentScore<stream_type,HostSimdScheduler>
+{
+    static const uint32 MAX_THREADS = 128; // whatever CPU we have, we assume we are never going to have more than this number of threads
+    static const uint32 MAX_LANES   = host_simd<int8>::WIDTH;
+
+    typedef typename stream_type::aligner_type                  aligner_type;
+    typedef typename stream_type::context_type                  context_type;
+    typedef typename stream_type::strings_type                  strings_type;
+    typedef typename column_storage_type<aligner_type>::type    cell_type;
+
+    static const uint32 PROFILE = priv::simd_scoring<aligner_type>::PROFILE;   // the score profile alphabet size
+
+    /// return the per-thread storage size
+    ///
+    static uint64 thread_storage(const uint32 max_pattern_len, const uint32 max_text_len)
+    {
+        const uint32 column_size = equal<typename aligner_type::algorithm_tag,PatternBlockingTag>() ?
+            uint32( (max_text_len    + 1u) * sizeof(cell_type) ) :
+            uint32( (max_pattern_len + 1u) * sizeof(cell_type) );
+
+        return
+            align<64>( priv::simd_alignment_workspace( max_pattern_len, max_text_len, PROFILE ) ) +  // DP workspace
+            align<64>( uint64( MAX_LANES ) * (2u * max_pattern_len + max_text_len) ) +               // lane strings
+            align<64>( column_size );                                                                // scalar fallback column
+    }
+
+    /// return the minimum number of bytes required by the algorithm
+    ///
+    static uint64 min_temp_storage(const uint32 max_pattern_len, const uint32 max_text_len, const uint32 stream_size);
+
+    /// return the maximum number of bytes required by the algorithm
+    ///
+    static uint64 max_temp_storage(const uint32 max_pattern_len, const uint32 max_text_len, const uint32 stream_size);
+
+    /// enact the batch execution
+    ///
+    void enact(stream_type stream, uint64 temp_size = 0u, uint8* temp = NULL);
+
+private:
+    /// score a group of consecutive jobs
+    ///
+    static void score_group(
+        const stream_type&  stream,
+        const uint32        group_begin,
+        const uint32        group_end,
+              uint8*        thread_temp);
+};
+
+// return the minimum number of bytes required by the algorithm
+//
+template <typename stream_type>
+uint64 BatchedAlignmentScore<stream_type,HostSimdScheduler>::min_temp_storage(const uint32 max_pattern_len, const uint32 max_text_len, const uint32 stream_size)
+{
+    return thread_storage( max_pattern_len, max_text_len ) * MAX_THREADS;
+}
+
+// return the maximum number of bytes required by the algorithm
+//
+template <typename stream_type>
+uint64 BatchedAlignmentScore<stream_type,HostSimdScheduler>::max_temp_storage(const uint32 max_pattern_len, const uint32 max_text_len, const uint32 stream_size)
+{
+    return thread_storage( max_pattern_len, max_text_len ) * MAX_THREADS;
+}
+
+// enact the batch execution
+//
+template <typename stream_type>
+void BatchedAlignmentScore<stream_type,HostSimdScheduler>::enact(stream_type stream, uint64 temp_size, uint8* temp)
+{
+  #if defined(_OPENMP)
+    const uint32 n_threads = nvbio::min( uint32( omp_get_max_threads() ), MAX_THREADS );
+  #else
+    const uint32 n_threads = 1u;
+  #endif
+
+    const uint64 thread_size = thread_storage(
+        stream.max_pattern_length(),
+        stream.max_text_length() );
+
+    // use the caller's temporary storage if it's large enough
+    nvbio::vector<host_tag,uint8> temp_vec;
+    if (temp == NULL || temp_size < thread_size * n_threads)
+    {
+        temp_vec.resize( thread_size * n_threads );
+        temp = nvbio::raw_pointer( temp_vec );
+    }
+
+    const uint32 n_groups = util::divide_ri( stream.size(), MAX_LANES );
+
+    #if defined(_OPENMP)
+    #pragma omp parallel for schedule(dynamic) num_threads(n_threads)
+    #endif
+    for (int group = 0; group < int( n_groups ); ++group)
+    {
+      #if defined(_OPENMP)
+        const uint32 thread_id = omp_get_thread_num();
+      #else
+        const uint32 thread_id = 0;
+      #endif
+
+        const uint32 group_begin = uint32( group ) * MAX_LANES;
+        const uint32 group_end   = nvbio::min( group_begin + MAX_LANES, stream.size() );
+
+        score_group( stream, group_begin, group_end, temp + thread_id * thread_size );
+    }
+}
+
+// score a group of consecutive jobs
+//
+template <typename stream_type>
+void BatchedAlignmentScore<stream_type,HostSimdScheduler>::score_group(
+    const stream_type&  stream,
+    const uint32        group_begin,
+    const uint32        group_end,
+          uint8*        thread_temp)
+{
+    const uint32 max_pattern_len = stream.max_pattern_length();
+    const uint32 max_text_len    = stream.max_text_length();
+
+    // carve the thread's storage
+    uint8* workspace = thread_temp;
+    uint8* symbols   = workspace + align<64>( priv::simd_alignment_workspace( max_pattern_len, max_text_len, PROFILE ) );
+    cell_type* column = (cell_type*)( symbols + align<64>( uint64( MAX_LANES ) * (2u * max_pattern_len + max_text_len) ) );
+
+    context_type     contexts[ MAX_LANES ];
+    strings_type     strings[ MAX_LANES ];
+    priv::simd_lane  lanes[ MAX_LANES ];
+    priv::simd_lane* active[ MAX_LANES ];
+
+    uint32 n_active = 0;
+
+    // load all the jobs in the group
+    for (uint32 work_id = group_begin; work_id < group_end; ++work_id)
+    {
+        const uint32 slot = work_id - group_begin;
+
+        // load the alignment context
+        if (stream.init_context( work_id, &contexts[slot] ) == false)
+        {
+            // handle the output
+            stream.output( work_id, &contexts[slot] );
+            continue;
+        }
+
+        const uint32 M = stream.pattern_length( work_id, &contexts[slot] );
+        const uint32 N = stream.text_length( work_id, &contexts[slot] );
+
+        // load the strings to be aligned
+        const uint32 len = equal<typename aligner_type::algorithm_tag,PatternBlockingTag>() ? M : N;
+        stream.load_strings( work_id, 0, len, &contexts[slot], &strings[slot] );
+
+        priv::simd_lane& lane = lanes[ n_active ];
+        lane.slot     = slot;
+        lane.M        = M;
+        lane.N        = N;
+        lane.overflow = (M == 0u || N == 0u || M > max_pattern_len || N > max_text_len);
+
+        if (lane.overflow == false)
+        {
+            // copy the strings to the lane's local storage
+            uint8* pattern = symbols + slot * (2u * max_pattern_len + max_text_len);
+            uint8* quals   = pattern + max_pattern_len;
+            uint8* text    = quals   + max_pattern_len;
+
+            for (uint32 j = 0; j < M; ++j)
+            {
+                pattern[j] = uint8( strings[slot].pattern[j] );
+                quals[j]   = uint8( strings[slot].quals[j] );
+            }
+            for (uint32 i = 0; i < N; ++i)
+                text[i] = uint8( strings[slot].text[i] );
+
+            lane.pattern = pattern;
+            lane.quals   = quals;
+            lane.text    = text;
+        }
+        ++n_active;
+    }
+
+    const priv::simd_scoring<aligner_type> scoring( stream.aligner() );
+
+    // first pass: 8-bit lanes
+    {
+        uint32 n_lanes = 0;
+        for (uint32 l = 0; l < n_active; ++l)
+        {
+            if (lanes[l].overflow == false)
+                active[ n_lanes++ ] = &lanes[l];
+        }
+        if (n_lanes)
+            priv::simd_alignment_score<int8>( scoring, active, n_lanes, workspace, contexts );
+    }
+
+    // second pass: re-run all overflown jobs with 16-bit lanes
+    {
+        const uint32 W16 = host_simd<int16>::WIDTH;
+
+        uint32 n_lanes = 0;
+        for (uint32 l = 0; l < n_active; ++l)
+        {
+            priv::simd_lane& lane = lanes[l];
+            if (lane.overflow && lane.M && lane.N && lane.M <= max_pattern_len && lane.N <= max_text_len)
+            {
+                lane.overflow = false;
+                active[ n_lanes++ ] = &lane;
+            }
+        }
+        for (uint32 begin = 0; begin < n_lanes; begin += W16)
+            priv::simd_alignment_score<int16>( scoring, active + begin, nvbio::min( n_lanes - begin, W16 ), workspace, contexts );
+    }
+
+    // last pass: fall back to the scalar code for whatever is left - jobs longer than the
+    // stream's declared maximum lengths don't fit the thread's column, and get their own
+    nvbio::vector<host_tag,cell_type> long_column;
+
+    for (uint32 l = 0; l < n_active; ++l)
+    {
+        const priv::simd_lane& lane = lanes[l];
+        if (lane.overflow)
+        {
+            context_type& context = contexts[ lane.slot ];
+
+            const bool fits = equal<typename aligner_type::algorithm_tag,PatternBlockingTag>() ?
+                lane.N <= max_text_len :
+                lane.M <= max_pattern_len;
+
+            if (fits == false)
+            {
+                const uint32 column_size = equal<typename aligner_type::algorithm_tag,PatternBlockingTag>() ? lane.N : lane.M;
+                if (long_column.size() < column_size + 1u)
+                    long_column.resize( column_size + 1u );
+            }
+
+            alignment_score(
+                stream.aligner(),
+                strings[ lane.slot ].pattern,
+                strings[ lane.slot ].quals,
+                strings[ lane.slot ].text,
+                context.min_score,
+                context.sink,
+                fits ? column : nvbio::raw_pointer( long_column ) );
+        }
+    }
+
+    // handle the output
+    for (uint32 l = 0; l < n_active; ++l)
+        stream.output( group_begin + lanes[l].slot, &contexts[ lanes[l].slot ] );
+}
+
+///@} // end of the BatchAlignment group
+
+} // namespace aln
+} // namespace nvbio
@@ -0,0 +1,586 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <nvbio/alignment/sink.h>
+#include <nvbio/alignment/utils.h>
+#include <nvbio/alignment/alignment_base_inl.h>
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/numbers.h>
+#include <nvbio/basic/popcount.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#include <vector>
+#endif
+
+namespace nvbio {
+namespace aln {
+
+// ----------------------------- Extension functions ---------------------------- //
+
+namespace priv
+{
+
+///@addtogroup private
+///@{
+
+///
+/// The outcome of a seed extension
+///
+struct ExtensionState
+{
+    int32   score;                  ///< best score
+    uint2   sink;                   ///< best cell, as the end of the text and pattern prefixes
+    int32   end_to_end_score;       ///< best score at the end of the pattern
+    uint32  end_to_end_sink;        ///< end of the text prefix of the best end-to-end cell
+    bool    dropped;                ///< whether the X-drop/Z-drop heuristics kicked in
+};
+
+///
+/// The adaptive band used by the extension aligner: a window of BAND_LEN cells,
+/// indexed by their text coordinate, sliding along the anti-diagonals of the
+/// (N+1)x(M+1) DP matrix.
+/// Both the scalar and the SIMD implementations rely on this class to initialize
+/// and move the window, so as to produce the very same results.
+///
+template <uint32 BAND_LEN>
+struct ExtensionWindow
+{
+    static const int32 INFIMUM = -(1 << 30);    ///< the score of the cells outside of the matrix or the band
+
+    /// constructor: center the window on the anchor cell
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    ExtensionWindow(const int32 _M, const int32 _N) :
+        M( _M ), N( _N ), lo( -int32(BAND_LEN-1)/2 ), shift( 0 ), prev_shift( 0 ) {}
+
+    /// move the window from anti-diagonal d to d+1, either down (along the text) or right
+    /// (along the pattern), towards the better scoring of its two ends
+    ///
+    /// \param d            the current anti-diagonal
+    /// \param H_first      the score of the first cell of the window (the closest to the pattern's end)
+    /// \param H_last       the score of the last cell of the window (the closest to the text's end)
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    void advance(const int32 d, const int32 H_first, const int32 H_last)
+    {
+        // the range of valid text coordinates along the next anti-diagonal
+        const int32 a = nvbio::max( 0, d + 1 - M );
+        const int32 b = nvbio::min( N, d + 1 );
+
+        int32 next_shift;
+        if (lo + 1 > b)                             // moving down would leave the matrix
+            next_shift = 0;
+        else if (lo + int32(BAND_LEN) - 1 < a)      // moving right would leave the matrix
+            next_shift = 1;
+        else if (H_first != H_last)                 // follow the best scoring end
+            next_shift = H_last > H_first ? 1 : 0;
+        else                                        // keep the window centered on the valid cells
+            next_shift = 2*lo + int32(BAND_LEN) - 1 < a + b ? 1 : 0;
+
+        prev_shift = shift;
+        shift      = next_shift;
+        lo        += next_shift;
+    }
+
+    int32 M;                ///< pattern length
+    int32 N;                ///< text length
+    int32 lo;               ///< text coordinate of the first cell of the window
+    int32 shift;            ///< window displacement between the previous and the current anti-diagonal
+    int32 prev_shift;       ///< window displacement between the previous two anti-diagonals
+};
+
+///
+/// Update the outcome of a seed extension after an anti-diagonal has been computed,
+/// returning true if the extension should be terminated.
+///
+/// \param state        the extension state
+/// \param max_H        the best score along the anti-diagonal
+/// \param max_i        the text coordinate of the best cell along the anti-diagonal
+/// \param max_j        the pattern coordinate of the best cell along the anti-diagonal
+/// \param xdrop        X-drop threshold
+/// \param zdrop        Z-drop threshold
+/// \param G_te         text gap extension penalty
+/// \param G_pe         pattern gap extension penalty
+///
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+bool extension_update(
+    ExtensionState& state,
+    const int32     max_H,
+    const int32     max_i,
+    const int32     max_j,
+    const int32     xdrop,
+    const int32     zdrop,
+    const int32     G_te,
+    const int32     G_pe)
+{
+    if (max_H > state.score)
+    {
+        state.score = max_H;
+        state.sink  = make_uint2( uint32( max_i ), uint32( max_j ) );
+        return false;
+    }
+
+    // X-drop: the whole window scores too far below the best cell
+    if (xdrop >= 0 && max_H < state.score - xdrop)
+    {
+        state.dropped = true;
+        return true;
+    }
+
+    // Z-drop: as above, but accounting for the gap needed to go from the best cell to the current one
+    if (zdrop >= 0 && max_i >= int32( state.sink.x ) && max_j >= int32( state.sink.y ))
+    {
+        const int32 di = max_i - int32( state.sink.x );
+        const int32 dj = max_j - int32( state.sink.y );
+        const int32 gap_penalty = di > dj ? -G_te * (di - dj) : -G_pe * (dj - di);
+
+        if (state.score - max_H > zdrop + gap_penalty)
+        {
+            state.dropped = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+///
+/// Compute an adaptive banded seed extension, one cell at a time.
+///
+/// The DP matrix has (N+1) x (M+1) cells, where cell (i,j) holds the best score of the alignments
+/// between the first i text characters and the first j pattern characters; it is swept along
+/// anti-diagonals, restricting the computation to a window of BAND_LEN cells that is moved by
+/// ExtensionWindow::advance().
+///
+/// \param aligner      the extension aligner
+/// \param pattern      pattern string
+/// \param quals        pattern qualities
+/// \param text         text string
+/// \param state        output extension state
+///
+template <
+    uint32          BAND_LEN,
+    typename        scoring_type,
+    typename        pattern_string,
+    typename        qual_string,
+    typename        text_string>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void extension_score(
+    const ExtensionAligner<scoring_type>&   aligner,
+    const pattern_string                    pattern,
+    const qual_string                       quals,
+    const text_string                       text,
+          ExtensionState&                   state)
+{
+    const int32 M = int32( pattern.length() );
+    const int32 N = int32( text.length() );
+
+    const scoring_type& scoring = aligner.scheme;
+    const int32 G_po = scoring.pattern_gap_open();
+    const int32 G_pe = scoring.pattern_gap_extension();
+    const int32 G_to = scoring.text_gap_open();
+    const int32 G_te = scoring.text_gap_extension();
+
+    const int32 INF = ExtensionWindow<BAND_LEN>::INFIMUM;
+
+    // the last three anti-diagonals of H and the last two of E and F,
+    // padded by an empty cell on each side
+    int32 H_band[3][BAND_LEN+2];
+    int32 E_band[2][BAND_LEN+2];
+    int32 F_band[2][BAND_LEN+2];
+    for (uint32 k = 0; k < BAND_LEN+2; ++k)
+    {
+        H_band[0][k] = H_band[1][k] = H_band[2][k] = INF;
+        E_band[0][k] = E_band[1][k] = INF;
+        F_band[0][k] = F_band[1][k] = INF;
+    }
+
+    state.score            = INF;
+    state.sink             = make_uint2( 0u, 0u );
+    state.end_to_end_score = INF;
+    state.end_to_end_sink  = uint32(-1);
+    state.dropped          = false;
+
+    ExtensionWindow<BAND_LEN> window( M, N );
+
+    for (int32 d = 0; d <= N + M; ++d)
+    {
+              int32* H  = H_band[ d % 3 ];
+        const int32* H1 = H_band[ (d+2) % 3 ];  // anti-diagonal d-1
+        const int32* H2 = H_band[ (d+1) % 3 ];  // anti-diagonal d-2
+              int32* E  = E_band[ d & 1 ];
+        const int32* E1 = E_band[ (d+1) & 1 ];
+              int32* F  = F_band[ d & 1 ];
+        const int32* F1 = F_band[ (d+1) & 1 ];
+
+        // the offsets of the up, left and diagonal neighbours of each cell in the padded bands
+        const int32 up   = window.shift;
+        const int32 left = window.shift + 1;
+        const int32 diag = window.shift + window.prev_shift;
+
+        int32 max_H = INF;
+        int32 max_k = 0;
+
+        for (int32 k = 0; k < int32( BAND_LEN ); ++k)
+        {
+            const int32 i = window.lo + k;
+            const int32 j = d - i;
+
+            int32 h, e, f;
+            if (i < 0 || i > N || j < 0 || j > M)
+            {
+                h = e = f = INF;
+            }
+            else if (i == 0 || j == 0)
+            {
+                h = (i == 0 && j == 0) ? 0 :
+                    (i == 0) ? G_po + G_pe * (j-1) :
+                               G_to + G_te * (i-1);
+                e = f = INF;
+            }
+            else
+            {
+                e = nvbio::max( H1[k + up]   + G_to, E1[k + up]   + G_te );
+                f = nvbio::max( H1[k + left] + G_po, F1[k + left] + G_pe );
+
+                const int32 S_ij = scoring.substitution( i-1, j, text[i-1], pattern[j-1], quals[j-1] );
+                h = nvbio::max3( H2[k + diag] + S_ij, e, f );
+
+                h = nvbio::max( h, INF );
+                e = nvbio::max( e, INF );
+                f = nvbio::max( f, INF );
+            }
+            H[k+1] = h;
+            E[k+1] = e;
+            F[k+1] = f;
+
+            if (max_H < h)
+            {
+                max_H = h;
+                max_k = k;
+            }
+        }
+
+        // check whether the window contains the last cell of the pattern
+        const int32 k_end = d - M - window.lo;
+        if (d >= M && d - M <= N && k_end >= 0 && k_end < int32( BAND_LEN ) && H[k_end+1] > state.end_to_end_score)
+        {
+            state.end_to_end_score = H[k_end+1];
+            state.end_to_end_sink  = uint32( d - M );
+        }
+
+        if (max_H == INF ||
+            extension_update( state, max_H, window.lo + max_k, d - window.lo - max_k, aligner.xdrop, aligner.zdrop, G_te, G_pe ))
+            break;
+
+        window.advance( d, H[1], H[BAND_LEN] );
+    }
+}
+
+#if defined(__AVX2__)
+
+///
+/// Compute an adaptive banded seed extension, 8 cells at a time using AVX2.
+/// The results are identical to those of extension_score(), provided the substitution scores
+/// do not depend on the text position: these are looked up in a query profile.
+///
+/// \param aligner      the extension aligner
+/// \param pattern      pattern string
+/// \param quals        pattern qualities
+/// \param text         text string
+/// \param state        output extension state
+///
+template <
+    uint32          BAND_LEN,
+    typename        scoring_type,
+    typename        pattern_string,
+    typename        qual_string,
+    typename        text_string>
+void extension_score_avx2(
+    const ExtensionAligner<scoring_type>&   aligner,
+    const pattern_string                    pattern,
+    const qual_string                       quals,
+    const text_string                       text,
+          ExtensionState&                   state)
+{
+    const int32 M = int32( pattern.length() );
+    const int32 N = int32( text.length() );
+    const int32 W = int32( BAND_LEN );
+
+    const scoring_type& scoring = aligner.scheme;
+    const int32 G_po = scoring.pattern_gap_open();
+    const int32 G_pe = scoring.pattern_gap_extension();
+    const int32 G_to = scoring.text_gap_open();
+    const int32 G_te = scoring.text_gap_extension();
+
+    const int32 INF = ExtensionWindow<BAND_LEN>::INFIMUM;
+
+    // the window can reach at most BAND_LEN cells outside the matrix: pad both strings accordingly
+    const int32 PAD = W + 1;
+
+    // copy the text, remapping text coordinate i to PAD + i - 1
+    std::vector<uint8> text_buffer( N + 2*PAD, 0u );
+    uint32 max_symbol = 0u;
+    for (int32 i = 0; i < N; ++i)
+    {
+        text_buffer[ PAD + i ] = uint8( text[i] );
+        max_symbol = nvbio::max( max_symbol, uint32( text_buffer[ PAD + i ] ) );
+    }
+
+    // build a query profile for all the text symbols, storing the substitution score
+    // of pattern coordinate j at offset PAD + M - j, so that it increases along anti-diagonals
+    const int32 stride = M + 2*PAD;
+    std::vector<int32> profile( (max_symbol+1) * stride, 0 );
+    for (uint32 c = 0; c <= max_symbol; ++c)
+    {
+        for (int32 j = 1; j <= M; ++j)
+            profile[ c * stride + PAD + M - j ] = scoring.substitution( 0u, j, uint8(c), pattern[j-1], quals[j-1] );
+    }
+
+    // the last three anti-diagonals of H and the last two of E and F,
+    // padded by an empty cell on each side
+    int32 H_band[3][BAND_LEN+2];
+    int32 E_band[2][BAND_LEN+2];
+    int32 F_band[2][BAND_LEN+2];
+    for (uint32 k = 0; k < BAND_LEN+2; ++k)
+    {
+        H_band[0][k] = H_band[1][k] = H_band[2][k] = INF;
+        E_band[0][k] = E_band[1][k] = INF;
+        F_band[0][k] = F_band[1][k] = INF;
+    }
+
+    state.score            = INF;
+    state.sink             = make_uint2( 0u, 0u );
+    state.end_to_end_score = INF;
+    state.end_to_end_sink  = uint32(-1);
+    state.dropped          = false;
+
+    const __m256i lane    = _mm256_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7 );
+    const __m256i INF_v   = _mm256_set1_epi32( INF );
+    const __m256i G_po_v  = _mm256_set1_epi32( G_po );
+    const __m256i G_pe_v  = _mm256_set1_epi32( G_pe );
+    const __m256i G_to_v  = _mm256_set1_epi32( G_to );
+    const __m256i G_te_v  = _mm256_set1_epi32( G_te );
+    const __m256i stride_v = _mm256_set1_epi32( stride );
+    const __m256i neg1_v  = _mm256_set1_epi32( -1 );
+    const __m256i N1_v    = _mm256_set1_epi32( N+1 );
+    const __m256i M1_v    = _mm256_set1_epi32( M+1 );
+
+    ExtensionWindow<BAND_LEN> window( M, N );
+
+    for (int32 d = 0; d <= N + M; ++d)
+    {
+              int32* H  = H_band[ d % 3 ];
+        const int32* H1 = H_band[ (d+2) % 3 ];  // anti-diagonal d-1
+        const int32* H2 = H_band[ (d+1) % 3 ];  // anti-diagonal d-2
+              int32* E  = E_band[ d & 1 ];
+        const int32* E1 = E_band[ (d+1) & 1 ];
+              int32* F  = F_band[ d & 1 ];
+        const int32* F1 = F_band[ (d+1) & 1 ];
+
+        const int32 up   = window.shift;
+        const int32 left = window.shift + 1;
+        const int32 diag = window.shift + window.prev_shift;
+        const int32 lo   = window.lo;
+
+        const __m256i d_v       = _mm256_set1_epi32( d );
+        const __m256i profile_v = _mm256_set1_epi32( PAD + M - d + lo );
+
+        for (int32 k = 0; k < W; k += 8)
+        {
+            // compute the coordinates of the cells and their validity
+            const __m256i i_v = _mm256_add_epi32( _mm256_set1_epi32( lo + k ), lane );
+            const __m256i j_v = _mm256_sub_epi32( d_v, i_v );
+            const __m256i valid = _mm256_and_si256(
+                _mm256_and_si256( _mm256_cmpgt_epi32( i_v, neg1_v ), _mm256_cmpgt_epi32( N1_v, i_v ) ),
+                _mm256_and_si256( _mm256_cmpgt_epi32( j_v, neg1_v ), _mm256_cmpgt_epi32( M1_v, j_v ) ) );
+
+            const __m256i e = _mm256_max_epi32(
+                _mm256_add_epi32( _mm256_loadu_si256( (const __m256i*)( H1 + k + up ) ), G_to_v ),
+                _mm256_add_epi32( _mm256_loadu_si256( (const __m256i*)( E1 + k + up ) ), G_te_v ) );
+            const __m256i f = _mm256_max_epi32(
+                _mm256_add_epi32( _mm256_loadu_si256( (const __m256i*)( H1 + k + left ) ), G_po_v ),
+                _mm256_add_epi32( _mm256_loadu_si256( (const __m256i*)( F1 + k + left ) ), G_pe_v ) );
+
+            // look up the substitution scores in the query profile
+            const __m256i t_v = _mm256_cvtepu8_epi32( _mm_loadl_epi64( (const __m128i*)( &text_buffer[ PAD + lo + k - 1 ] ) ) );
+            const __m256i s_v = _mm256_i32gather_epi32(
+                &profile[0],
+                _mm256_add_epi32( _mm256_add_epi32( _mm256_mullo_epi32( t_v, stride_v ), profile_v ), _mm256_add_epi32( _mm256_set1_epi32( k ), lane ) ),
+                4 );
+
+            __m256i h = _mm256_add_epi32( _mm256_loadu_si256( (const __m256i*)( H2 + k + diag ) ), s_v );
+            h = _mm256_max_epi32( _mm256_max_epi32( h, e ), f );
+
+            _mm256_storeu_si256( (__m256i*)( H + k + 1 ), _mm256_blendv_epi8( INF_v, _mm256_max_epi32( h, INF_v ), valid ) );
+            _mm256_storeu_si256( (__m256i*)( E + k + 1 ), _mm256_blendv_epi8( INF_v, _mm256_max_epi32( e, INF_v ), valid ) );
+            _mm256_storeu_si256( (__m256i*)( F + k + 1 ), _mm256_blendv_epi8( INF_v, _mm256_max_epi32( f, INF_v ), valid ) );
+        }
+
+        // patch the (at most two) cells lying on the first row and column of the matrix
+        const int32 k_row = -lo;        // cell (0,d)
+        if (k_row >= 0 && k_row < W && d <= M)
+        {
+            H[k_row+1] = d == 0 ? 0 : G_po + G_pe * (d-1);
+            E[k_row+1] = F[k_row+1] = INF;
+        }
+        const int32 k_col = d - lo;     // cell (d,0)
+        if (d > 0 && k_col >= 0 && k_col < W && d <= N)
+        {
+            H[k_col+1] = G_to + G_te * (d-1);
+            E[k_col+1] = F[k_col+1] = INF;
+        }
+
+        // find the best cell of the window, breaking ties towards its beginning
+        __m256i max_v = INF_v;
+        for (int32 k = 0; k < W; k += 8)
+            max_v = _mm256_max_epi32( max_v, _mm256_loadu_si256( (const __m256i*)( H + k + 1 ) ) );
+
+        max_v = _mm256_max_epi32( max_v, _mm256_permute2x128_si256( max_v, max_v, 0x01 ) );
+        max_v = _mm256_max_epi32( max_v, _mm256_shuffle_epi32( max_v, 0x4E ) );
+        max_v = _mm256_max_epi32( max_v, _mm256_shuffle_epi32( max_v, 0xB1 ) );
+        const int32 max_H = _mm256_cvtsi256_si32( max_v );
+
+        int32 max_k = 0;
+        for (int32 k = 0; k < W; k += 8)
+        {
+            const uint32 mask = _mm256_movemask_ps( _mm256_castsi256_ps(
+                _mm256_cmpeq_epi32( max_v, _mm256_loadu_si256( (const __m256i*)( H + k + 1 ) ) ) ) );
+            if (mask)
+            {
+                max_k = k + popc( (mask & (~mask + 1u)) - 1u );
+                break;
+            }
+        }
+
+        // check whether the window contains the last cell of the pattern
+        const int32 k_end = d - M - lo;
+        if (d >= M && d - M <= N && k_end >= 0 && k_end < W && H[k_end+1] > state.end_to_end_score)
+        {
+            state.end_to_end_score = H[k_end+1];
+            state.end_to_end_sink  = uint32( d - M );
+        }
+
+        if (max_H == INF ||
+            extension_update( state, max_H, lo + max_k, d - lo - max_k, aligner.xdrop, aligner.zdrop, G_te, G_pe ))
+            break;
+
+        window.advance( d, H[1], H[BAND_LEN] );
+    }
+}
+
+#endif
+
+///
+/// Report the outcome of a seed extension to a generic alignment sink,
+/// returning true if the minimum score was reached
+///
+template <typename sink_type>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+bool extension_report(const ExtensionState& state, const uint32 M, const int32 min_score, sink_type& sink)
+{
+    if (state.score < min_score)
+        return false;
+
+    sink.report( state.score, state.sink );
+    return true;
+}
+
+///
+/// Report the outcome of a seed extension to an ExtensionSink,
+/// returning true if the minimum score was reached
+///
+template <typename ScoreType>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+bool extension_report(const ExtensionState& state, const uint32 M, const int32 min_score, ExtensionSink<ScoreType>& sink)
+{
+    sink.dropped = state.dropped;
+
+    if (state.end_to_end_sink != uint32(-1))
+        sink.report_end_to_end( ScoreType( state.end_to_end_score ), make_uint2( state.end_to_end_sink, M ) );
+
+    if (state.score < min_score)
+        return false;
+
+    sink.report( ScoreType( state.score ), state.sink );
+    return true;
+}
+
+///
+/// Calculate the adaptive banded seed extension of a pattern against a text,
+/// starting from their first characters.
+/// On the host, the band is processed with AVX2 when available and BAND_LEN is a multiple of 8.
+///
+/// \tparam BAND_LEN    the number of cells of each anti-diagonal in the adaptive band
+///
+/// \param aligner      the extension aligner
+/// \param pattern      pattern string
+/// \param quals        pattern qualities
+/// \param text         text string
+/// \param min_score    minimum output score
+/// \param sink         output alignment sink, reported the best extension's end;
+///                     an ExtensionSink will also get the best end-to-end extension
+///
+/// \return             false if the minimum score was not reached, true otherwise
+///
+template <
+    uint32 BAND_LEN,
+    typename scoring_type,
+    typename pattern_type,
+    typename qual_type,
+    typename text_type,
+    typename sink_type>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+bool banded_alignment_score(
+    const ExtensionAligner<scoring_type>&   aligner,
+    pattern_type                            pattern,
+    qual_type                               quals,
+    text_type                               text,
+    const int32                             min_score,
+    sink_type&                              sink)
+{
+    ExtensionState state;
+
+  #if defined(__AVX2__) && !defined(__CUDA_ARCH__)
+    if (BAND_LEN % 8u == 0u)
+        extension_score_avx2<BAND_LEN>( aligner, pattern, quals, text, state );
+    else
+  #endif
+        extension_score<BAND_LEN>( aligner, pattern, quals, text, state );
+
+    return extension_report( state, pattern.length(), min_score, sink );
+}
+
+///@} // end of private group
+
+} // namespace priv
+
+} // namespace aln
+} // namespace nvbio
@@ -0,0 +1,412 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <nvbio/alignment/sink.h>
+#include <nvbio/alignment/utils.h>
+#include <nvbio/alignment/alignment_base_inl.h>
+#include <nvbio/alignment/gotoh/gotoh_banded_inl.h>
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/numbers.h>
+#include <nvbio/basic/host_simd.h>
+#include <vector>
+
+namespace nvbio {
+namespace aln {
+
+// ----------------------------- Banded difference recurrence Gotoh functions ---------------------------- //
+
+namespace priv
+{
+
+///@addtogroup private
+///@{
+
+///
+/// Banded Gotoh scoring with Suzuki and Kasahara's difference recurrences.
+/// Rather than the scores themselves, each cell keeps the differences
+///\par
+///   u(i,j) = H(i,j) - H(i-1,j)        v(i,j) = H(i,j) - H(i,j-1)
+///   x(i,j) = F(i+1,j) - H(i,j)        y(i,j) = E(i,j+1) - H(i,j)
+///\par
+/// which are bounded by the scoring scheme alone, and can hence be stored in int8 lanes
+/// however long the alignment; the recurrences read
+///\par
+///   z(i,j) = max( S(i,j), x(i-1,j) + v(i-1,j), y(i,j-1) + u(i,j-1) )
+///   u(i,j) = z(i,j) - v(i-1,j)        v(i,j) = z(i,j) - u(i,j-1)
+///   x(i,j) = max( x(i-1,j) + v(i-1,j) - z(i,j) + G_e, G_o )
+///   y(i,j) = max( y(i,j-1) + u(i,j-1) - z(i,j) + G_e, G_o )
+///\par
+/// where z(i,j) = H(i,j) - H(i-1,j-1). As a cell only depends on its top and left neighbours,
+/// the anti-diagonals of the band are computed with host_simd<int8> vectors, laying out the
+/// cells of each anti-diagonal by pattern row so that the top neighbours are just one lane away.
+/// The absolute scores are recovered by accumulating the differences along a staircase path
+/// from the origin to the main diagonal of the band, and then along the last row.
+///\par
+/// The band, its boundary conditions and the sink reports are those of the PatternBlockingTag
+/// implementation in gotoh_banded_inl.h, i.e. the i-th pattern row spans the text columns
+/// [i, i + BAND_LEN), and text columns past the end of the text are scored as mismatches against
+/// the symbol 255. As in the striped code, the substitution scores are assumed not to depend on
+/// the text position, and the min_score early-exit is not applied.
+///
+/// \return     false if the alignment type, the band, the alphabet or the scoring scheme are not
+///             supported by the int8 lanes, in which case nothing is reported to the sink
+///
+template <
+    uint32          BAND_LEN,
+    AlignmentType   TYPE,
+    typename        scoring_type,
+    typename        pattern_string,
+    typename        qual_string,
+    typename        text_string,
+    typename        sink_type>
+bool gotoh_banded_diff_score(
+    const scoring_type&     scoring,
+    const pattern_string    pattern,
+    const qual_string       quals,
+    const text_string       text,
+          sink_type&        sink)
+{
+    typedef host_simd<int8>         simd;
+    typedef typename simd::type     vec;
+
+    // the largest text alphabet for which the substitution scores are looked up by blending
+    const uint32 MAX_SYMBOLS = 32u;
+
+    // the value of the differences outside the band, acting as minus infinity
+    const int8 INFIMUM = Field_traits<int8>::min();
+
+    const int32 W = int32( simd::WIDTH );
+    const int32 M = int32( pattern.length() );
+    const int32 N = int32( text.length() );
+
+    // local alignment needs absolute scores to clamp to zero, while narrow bands fill too few lanes
+    if (TYPE == LOCAL || BAND_LEN < 16u || M == 0 || N < M)
+        return false;
+
+    const int32 G_o = scoring.pattern_gap_open();
+    const int32 G_e = scoring.pattern_gap_extension();
+    const int32 T_o = TYPE == GLOBAL ? scoring.text_gap_open()      : 0;
+    const int32 T_e = TYPE == GLOBAL ? scoring.text_gap_extension() : 0;
+
+    if (nvbio::max( nvbio::max( G_o, G_e ), nvbio::max( T_o, T_e ) ) > 0)
+        return false;
+
+    // find the text alphabet size: the extra symbol stands for the columns past the end of the text
+    uint32 alphabet_size = 0u;
+    for (int32 i = 0; i < N; ++i)
+        alphabet_size = nvbio::max( alphabet_size, uint32( uint8( text[i] ) ) + 1u );
+
+    if (alphabet_size + 1u > MAX_SYMBOLS)
+        return false;
+
+    const uint8 PAD = uint8( alphabet_size );
+
+    // the text columns the band can reach, and the padding needed by the partial vectors
+    const int32 L = M + int32(BAND_LEN) - 1;
+    const int32 P = M + 3*W;
+
+    std::vector<int8> storage( (alphabet_size + 1u) * P + (L + 3*W) + 4 * (M + 3*W) );
+
+    int8* profile = &storage[0];
+    int8* text_r  = profile + (alphabet_size + 1u) * P;
+    int8* U       = text_r + (L + 3*W) + 2*W;
+    int8* V       = U + (M + 3*W);
+    int8* X       = V + (M + 3*W);
+    int8* Y       = X + (M + 3*W);
+
+    // build the query profile, indexed by text symbol and pattern row
+    int32 s_min = 0;
+    int32 s_max = 0;
+    for (uint32 c = 0; c <= alphabet_size; ++c)
+    {
+        int8* prof = profile + c * P + 2*W;
+
+        for (int32 i = 0; i < M; ++i)
+        {
+            const int32 s = scoring.substitution( 0u, uint32(i), c == PAD ? uint8(255u) : uint8(c), uint8( pattern[i] ), uint8( quals[i] ) );
+            s_min = nvbio::min( s_min, s );
+            s_max = nvbio::max( s_max, s );
+
+            prof[i+1] = int8( nvbio::max( nvbio::min( s, 127 ), -127 ) );
+        }
+    }
+
+    // make sure all the differences and their intermediate sums fit in the int8 lanes
+    const int32 G_max = nvbio::max( nvbio::max( -G_o, -G_e ), nvbio::max( -T_o, -T_e ) );
+    if (4*G_max + s_max - s_min >= 127)
+        return false;
+
+    // store the text reversed, so that the text symbols of an anti-diagonal follow its pattern rows
+    for (int32 k = 0; k < L + 3*W; ++k)
+    {
+        const int32 b = L - 1 - (k - 2*W);      // the text column, 0-based
+        text_r[k] = int8( b >= 0 && b < N ? uint8( text[b] ) : PAD );
+    }
+
+    // the rows which haven't started yet have no left neighbours
+    for (int32 i = -2*W; i < M + W; ++i)
+    {
+        U[i] = Y[i] = INFIMUM;
+        V[i] = X[i] = INFIMUM;
+    }
+
+    const vec v_G_o = simd::set1( int8( G_o ) );
+    const vec v_G_e = simd::set1( int8( G_e ) );
+    const vec v_inf = simd::set1( INFIMUM );
+
+    // the score at the cell (0,1) of the staircase path
+    int32 score = T_o;
+
+    // the last row can reach no further than the end of the text
+    const int32 last_col = nvbio::min( L, N );
+
+    // loop across the anti-diagonals, r = i + j
+    for (int32 r = 2; r <= 2*M + int32(BAND_LEN) - 1; ++r)
+    {
+        const int32 i_lo = nvbio::max( (r - int32(BAND_LEN) + 2) / 2, 1 );
+        const int32 i_hi = nvbio::min( r / 2, M );
+
+        // the 0-th row of the DP matrix
+        if (i_lo == 1 && r-1 < int32(BAND_LEN))
+        {
+            X[0] = int8( G_o );
+            V[0] = int8( TYPE == GLOBAL ? (r == 2 ? T_o : T_e) : 0 );
+        }
+
+        const int8* text_d = text_r + 2*W + L - r;
+
+        // process the anti-diagonal from the bottom up, so that each vector only overwrites
+        // the top neighbours of the vectors already processed
+        for (int32 i0 = i_hi - W + 1; i0 + W > i_lo; i0 -= W)
+        {
+            // look up the substitution scores
+            const vec t = simd::load( text_d + i0 );
+
+            vec s = simd::load( profile + 2*W + i0 );
+            for (uint32 c = 1; c <= alphabet_size; ++c)
+                s = simd::blend( s, simd::load( profile + c * P + 2*W + i0 ), simd::cmpeq( t, simd::set1( int8(c) ) ) );
+
+            const vec v_top  = simd::load( V + i0 - 1 );
+            const vec u_left = simd::load( U + i0 );
+
+            const vec f = simd::adds( simd::load( X + i0 - 1 ), v_top );   // F(i,j) - H(i-1,j-1)
+            const vec e = simd::adds( simd::load( Y + i0 ), u_left );      // E(i,j) - H(i-1,j-1)
+            const vec z = simd::max( s, simd::max( f, e ) );
+
+            simd::store( U + i0, simd::subs( z, v_top ) );
+            simd::store( V + i0, simd::subs( z, u_left ) );
+            simd::store( X + i0, simd::max( simd::adds( simd::subs( f, z ), v_G_e ), v_G_o ) );
+            simd::store( Y + i0, simd::max( simd::adds( simd::subs( e, z ), v_G_e ), v_G_o ) );
+        }
+
+        // the rows before i_lo leave the band, or have been overwritten by the partial vectors:
+        // from the next anti-diagonal on their top contributions are out of the band
+        simd::store( X + i_lo - W, v_inf );
+        simd::store( V + i_lo - W, v_inf );
+
+        // follow the staircase path (i-1,i) -> (i,i) up to the main diagonal of the last row,
+        // and then move along the last row
+        if (r <= 2*M)
+            score += (r & 1) ? V[i_hi] : U[i_hi];
+        else
+            score += V[M];
+
+        if (r >= 2*M)
+        {
+            const int32 j = r - M;
+
+            if (TYPE == SEMI_GLOBAL && j <= last_col)
+                sink.report( score, make_uint2( j, M ) );
+            else if (TYPE == GLOBAL && j == L)
+                sink.report( score, make_uint2( j, M ) );
+        }
+    }
+    return true;
+}
+
+///@} // end of the private group
+
+///@addtogroup private
+///@{
+
+///
+/// Calculate the banded alignment score between a pattern and a text string
+/// using Gotoh's algorithm with difference recurrences on the host.
+/// Local alignment, device code and the problems whose scores don't fit the int8 lanes
+/// fall back to the scalar PatternBlockingTag implementation.
+///
+/// \param pattern      shorter string (horizontal)
+/// \param quals        qualities string
+/// \param text         longer string (vertical)
+/// \param min_score    minimum score
+/// \param sink         output alignment sink
+///
+/// \return             false if the minimum score was not reached, true otherwise
+///
+template <
+    uint32 BAND_LEN,
+    AlignmentType TYPE,
+    typename scoring_type,
+    typename pattern_type,
+    typename qual_type,
+    typename text_type,
+    typename sink_type>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+bool banded_alignment_score(
+    const GotohAligner<TYPE,scoring_type,DifferenceRecurrenceTag>&  aligner,
+    pattern_type                                                    pattern,
+    qual_type                                                       quals,
+    text_type                                                       text,
+    const int32                                                     min_score,
+    sink_type&                                                      sink)
+{
+  #if !defined(NVBIO_DEVICE_COMPILATION)
+    if (gotoh_banded_diff_score<BAND_LEN,TYPE>( aligner.scheme, pattern, quals, text, sink ))
+        return true;
+  #endif
+
+    return priv::banded_alignment_score<BAND_LEN>( GotohAligner<TYPE,scoring_type>( aligner.scheme ), pattern, quals, text, min_score, sink );
+}
+
+///
+/// Calculate a window of the banded alignment matrix between a pattern and a text strings,
+/// forwarding to the PatternBlockingTag implementation.
+///
+template <
+    uint32 BAND_LEN,
+    AlignmentType TYPE,
+    typename scoring_type,
+    typename pattern_type,
+    typename qual_type,
+    typename text_type,
+    typename sink_type,
+    typename checkpoint_type>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+bool banded_alignment_score(
+    const GotohAligner<TYPE,scoring_type,DifferenceRecurrenceTag>&  aligner,
+    pattern_type                                                    pattern,
+    qual_type                                                       quals,
+    text_type                                                       text,
+    const int32                                                     min_score,
+    const uint32                                                    window_begin,
+    const uint32                                                    window_end,
+    sink_type&                                                      sink,
+    checkpoint_type                                                 checkpoint)
+{
+    return priv::banded_alignment_score<BAND_LEN>( GotohAligner<TYPE,scoring_type>( aligner.scheme ), pattern, quals, text, min_score, window_begin, window_end, sink, checkpoint );
+}
+
+///
+/// Calculate the banded checkpoints needed by traceback, forwarding to the PatternBlockingTag
+/// implementation.
+///
+template <
+    uint32          BAND_LEN,
+    uint32          CHECKPOINTS,
+    AlignmentType   TYPE,
+    typename        scoring_type,
+    typename        pattern_type,
+    typename        qual_type,
+    typename        text_type,
+    typename        sink_type,
+    typename        checkpoint_type>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+bool banded_alignment_checkpoints(
+    const GotohAligner<TYPE,scoring_type,DifferenceRecurrenceTag>&  aligner,
+    pattern_type                                                    pattern,
+    qual_type                                                       quals,
+    text_type                                                       text,
+    const int32                                                     min_score,
+    sink_type&                                                      sink,
+    checkpoint_type                                                 checkpoints)
+{
+    return priv::banded_alignment_checkpoints<BAND_LEN,CHECKPOINTS>( GotohAligner<TYPE,scoring_type>( aligner.scheme ), pattern, quals, text, min_score, sink, checkpoints );
+}
+
+///
+/// Compute the banded flow submatrix between two checkpoints, forwarding to the
+/// PatternBlockingTag implementation.
+///
+template <
+    uint32          BAND_LEN,
+    uint32          CHECKPOINTS,
+    AlignmentType   TYPE,
+    typename        scoring_type,
+    typename        pattern_string,
+    typename        qual_string,
+    typename        text_string,
+    typename        checkpoint_type,
+    typename        submatrix_type>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+uint32 banded_alignment_submatrix(
+    const GotohAligner<TYPE,scoring_type,DifferenceRecurrenceTag>&  aligner,
+    pattern_string                                                  pattern,
+    qual_string                                                     quals,
+    text_string                                                     text,
+    const int32                                                     min_score,
+    checkpoint_type                                                 checkpoints,
+    const uint32                                                    checkpoint_id,
+    submatrix_type                                                  submatrix)
+{
+    return priv::banded_alignment_submatrix<BAND_LEN,CHECKPOINTS>( GotohAligner<TYPE,scoring_type>( aligner.scheme ), pattern, quals, text, min_score, checkpoints, checkpoint_id, submatrix );
+}
+
+///
+/// Backtrack through a banded flow submatrix, forwarding to the PatternBlockingTag
+/// implementation.
+///
+template <
+    uint32          BAND_LEN,
+    uint32          CHECKPOINTS,
+    AlignmentType   TYPE,
+    typename        scoring_type,
+    typename        checkpoint_type,
+    typename        submatrix_type,
+    typename        backtracer_type>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+bool banded_alignment_traceback(
+    const GotohAligner<TYPE,scoring_type,DifferenceRecurrenceTag>&  aligner,
+    checkpoint_type                                                 checkpoints,
+    const uint32                                                    checkpoint_id,
+    submatrix_type                                                  submatrix,
+    const uint32                                                    submatrix_height,
+          uint8&                                                    state,
+          uint2&                                                    sink,
+    backtracer_type&                                                backtracer)
+{
+    return priv::banded_alignment_traceback<BAND_LEN,CHECKPOINTS>( GotohAligner<TYPE,scoring_type>( aligner.scheme ), checkpoints, checkpoint_id, submatrix, submatrix_height, state, sink, backtracer );
+}
+
+///@} // end of the private group
+
+} // namespace priv
+
+} // namespace aln
+} // namespace nvbio
@@ -423,6 +423,38 @@ struct gotoh_alignment_score_dispatch
         const int32         min_score,
         context_type&       context,
         sink_type&          sink)
+    {
+        // the text cache can't hold the padding symbol 255, so the cells past the end of the text
+        // need checking: as it's rare for the band to reach that far, only pay for it when it does
+        if (pos + window_end + BAND_LEN - 1u > text.length())
+            return run_rows<true>( scoring, pattern, quals, text, window_begin, window_end, pos, min_score, context, sink );
+        else
+            return run_rows<false>( scoring, pattern, quals, text, window_begin, window_end, pos, min_score, context, sink );
+    }
+
+    // the implementation of run(), where PADDED tells whether the band reaches past the end of the text
+    //
+    template <
+        bool PADDED,
+        typename pattern_type,
+        typename qual_type,
+        typename text_type,
+        typename scoring_type,
+        typename context_type,
+        typename sink_type>
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    static
+    bool run_rows(
+        const scoring_type& scoring,
+        pattern_type        pattern,
+        qual_type           quals,
+        text_type           text,
+        const uint32        window_begin,
+        const uint32        window_end,
+        const uint32        pos,
+        const int32         min_score,
+        context_type&       context,
+        sink_type&          sink)
     {
         const uint32 pattern_len = pattern.length();
         const uint32 text_len = text.length();
@@ -437,9 +469,9 @@ struct gotoh_alignment_score_dispatch
         uint32 text_cache_storage[Reference_cache<BAND_LEN>::BAND_WORDS];
         text_cache_type text_cache( text_cache_storage );
 
-        // load first band of text
+        // load first band of text, padding it past the end of the text
         for (uint32 j = 0; j < BAND_LEN-1; ++j)
-            text_cache[j] = text[start+window_begin+j];
+            text_cache[j] = start+window_begin+j < text_len ? text[start+window_begin+j] : 255u;
 
         const score_type G_o = scoring.pattern_gap_open();
         const score_type G_e = scoring.pattern_gap_extension();
@@ -487,7 +519,7 @@ struct gotoh_alignment_score_dispatch
                 F_band[0] = nvbio::max( ftop, htop );
                 const DirectionVector fdir = ftop > htop ? DELETION_EXT : SUBSTITUTION;
 
-                const uint8      g        = text_cache[0];
+                const uint8      g        = (PADDED && start+i >= text_len) ? uint8(255u) : uint8( text_cache[0] );
                 //const score_type S_ij     = (g == q) ?  V : scoring.mismatch( g, q, qq );
                 const score_type S_ij     = scoring.substitution( i+0, i, g, q, qq );
                 const score_type diagonal = H_band[0] + S_ij;
@@ -541,7 +573,7 @@ struct gotoh_alignment_score_dispatch
 
                 const uint32 g = text_cache[j]; text_cache[j-1] = g;
                 //const score_type S_ij     = (g == q) ? V : scoring.mismatch( g, q, qq );
-                const score_type S_ij     = scoring.substitution( i+j, i, g, q, qq );
+                const score_type S_ij     = scoring.substitution( i+j, i, (PADDED && start+i+j >= text_len) ? uint8(255u) : uint8(g), q, qq );
                 const score_type diagonal = H_band[j] + S_ij;
                 const score_type top      = F_band[j];
                 const score_type left     = E_j;
@@ -0,0 +1,364 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <nvbio/alignment/sink.h>
+#include <nvbio/alignment/utils.h>
+#include <nvbio/alignment/alignment_base_inl.h>
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/numbers.h>
+#include <nvbio/basic/host_simd.h>
+#include <vector>
+
+namespace nvbio {
+namespace aln {
+
+// ----------------------------- Striped Gotoh functions ---------------------------- //
+
+namespace priv
+{
+
+///@addtogroup private
+///@{
+
+///
+/// Farrar's striped Gotoh scoring, computing the full DP matrix with the pattern laid out
+/// across the lanes of host_simd<int16> vectors: given W lanes and a pattern of length M,
+/// the pattern is split into W segments of S = ceil(M/W) symbols, and the k-th vector of a
+/// row holds the columns { k, S + k, 2S + k, ... }.
+/// This way the substitution scores of each row can be looked up in a query profile built
+/// once per pattern, and the only data dependency along the row, i.e. the horizontal gaps,
+/// can be resolved by a "lazy" correction loop which in practice runs only a few iterations.
+/// The text is processed one row at a time, so that long texts stream through the kernel
+/// with a per-row working set proportional to the pattern only.
+///\par
+/// Unlike the scalar implementations, the kernel doesn't use the caller's column storage:
+/// each call allocates a scratch buffer of (A + 7) * W * S + N 16-bit words, with A the
+/// alphabet size, holding the query profile, a few rows of vectors and the last column,
+/// whose scores are only reported once they are known not to have overflowed.
+/// Large batches of short problems are better served by the HostSimdScheduler.
+///\par
+/// The rows and columns of the DP matrix, and hence its boundary conditions and the sink
+/// reports, follow the conventions of the PatternBlockingTag implementation, with one
+/// exception: local alignment reports a single best-scoring cell rather than all cells.
+/// The substitution scores are assumed not to depend on the text position, and the min_score
+/// early-exit is not applied.
+///
+/// \return     false if the scores could not be represented with 16-bit lanes, in which
+///             case nothing is reported to the sink
+///
+template <
+    AlignmentType   TYPE,
+    typename        scoring_type,
+    typename        pattern_string,
+    typename        qual_string,
+    typename        text_string,
+    typename        sink_type>
+bool gotoh_striped_score(
+    const scoring_type&     scoring,
+    const pattern_string    pattern,
+    const qual_string       quals,
+    const text_string       text,
+          sink_type&        sink)
+{
+    typedef int16                   score_type;
+    typedef host_simd<score_type>   simd;
+    typedef typename simd::type     vec;
+
+    const uint32 W = simd::WIDTH;
+    const uint32 M = pattern.length();
+    const uint32 N = text.length();
+    const uint32 S = (M + W-1) / W;
+
+    const int32 T_MIN = Field_traits<score_type>::min();
+    const int32 T_MAX = Field_traits<score_type>::max();
+
+    const int32 G_o = scoring.pattern_gap_open();
+    const int32 G_e = scoring.pattern_gap_extension();
+
+    // DP boundary conditions
+    const int32 last_row0 = TYPE != LOCAL  ? (M ? G_o + G_e * int32(M-1) : 0) : 0;
+    const int32 last_col0 = TYPE == GLOBAL ? scoring.text_gap_open() + scoring.text_gap_extension() * int32(N-1) : 0;
+
+    // make sure the boundaries and the gap penalties fit in the lanes (the boundaries are monotonic)
+    if (nvbio::min( nvbio::min( last_row0, last_col0 ), nvbio::min( G_o, G_e ) ) <= T_MIN ||
+        nvbio::max( nvbio::max( last_row0, last_col0 ), nvbio::max( G_o, G_e ) ) >= T_MAX)
+        return false;
+
+    // find the alphabet size
+    uint32 alphabet_size = 0u;
+    for (uint32 j = 0; j < M; ++j)
+        alphabet_size = nvbio::max( alphabet_size, uint32( uint8( pattern[j] ) ) + 1u );
+    for (uint32 i = 0; i < N; ++i)
+        alphabet_size = nvbio::max( alphabet_size, uint32( uint8( text[i] ) ) + 1u );
+
+    std::vector<score_type> storage( (alphabet_size + 7u) * S * W + N );
+
+    score_type* profile = &storage[0];
+    score_type* H_prev  = profile + alphabet_size * S * W;
+    score_type* H_curr  = H_prev  + S * W;
+    score_type* F       = H_curr  + S * W;
+    score_type* E_curr  = F       + S * W;          // the horizontal gaps entering each cell
+    score_type* B       = E_curr  + S * W;          // the row containing the best local cell
+    score_type* cap_hi  = B       + S * W;
+    score_type* cap_lo  = cap_hi  + S * W;
+    score_type* last    = cap_lo  + S * W;          // the last column
+
+    // build the query profile, and the clamping vectors used to exclude the padding
+    // columns past the end of the pattern from all tests
+    for (uint32 k = 0; k < S; ++k)
+    {
+        for (uint32 l = 0; l < W; ++l)
+        {
+            const uint32 j = l * S + k;
+
+            for (uint32 a = 0; a < alphabet_size; ++a)
+            {
+                const int32 s = j < M ? scoring.substitution( 0u, j+1, uint8(a), uint8( pattern[j] ), uint8( quals[j] ) ) : T_MIN;
+                if (j < M && (s <= T_MIN || s >= T_MAX))
+                    return false;
+
+                profile[ (a * S + k) * W + l ] = score_type( s );
+            }
+
+            H_prev[ k*W + l ] = score_type( TYPE != LOCAL ? G_o + G_e * int32(j) : 0 );
+            F[ k*W + l ]      = score_type( T_MIN );
+            cap_hi[ k*W + l ] = score_type( j < M ? T_MAX : T_MIN );
+            cap_lo[ k*W + l ] = score_type( j < M ? T_MIN : T_MAX );
+        }
+    }
+
+    const vec v_G_o  = simd::set1( score_type( G_o ) );
+    const vec v_G_e  = simd::set1( score_type( G_e ) );
+    const vec v_zero = simd::zero();
+    const vec v_inf  = simd::set1( score_type( T_MIN ) );
+
+    vec v_max = v_inf;
+    vec v_min = simd::set1( score_type( T_MAX ) );
+
+    int32  best_score = T_MIN;
+    uint32 best_row   = 0u;
+
+    // loop across the long edge of the DP matrix (i.e. the rows)
+    for (uint32 i = 0; i < N; ++i)
+    {
+        const score_type* P = profile + uint8( text[i] ) * S * W;
+
+        // H[i][0] and H[i+1][0]
+        const int32 h_diag = (TYPE == GLOBAL && i) ? scoring.text_gap_open() + scoring.text_gap_extension() * int32(i-1) : 0;
+        const int32 h_left = (TYPE == GLOBAL)      ? scoring.text_gap_open() + scoring.text_gap_extension() * int32(i)   : 0;
+
+        // the horizontal gap entering the first column, exact in lane 0 only
+        const int32 e_left = nvbio::max( (TYPE == LOCAL ? 0 : T_MIN) + G_e, h_left + G_o );
+
+        vec E    = simd::shift_in( v_inf, score_type( nvbio::max( e_left, T_MIN ) ) );
+        vec diag = simd::shift_in( simd::load( H_prev + (S-1)*W ), score_type( h_diag ) );
+
+        vec row_max = v_inf;
+
+        for (uint32 k = 0; k < S; ++k)
+        {
+            const vec top = simd::load( H_prev + k*W );
+
+            // update the vertical gaps
+            const vec f = simd::max( simd::adds( simd::load( F + k*W ), v_G_e ), simd::adds( top, v_G_o ) );
+            simd::store( F + k*W, f );
+
+            simd::store( E_curr + k*W, E );
+
+            vec h = simd::max( simd::max( simd::adds( diag, simd::load( P + k*W ) ), f ), E );
+            if (TYPE == LOCAL)
+                h = simd::max( h, v_zero ); // clamp to zero
+
+            simd::store( H_curr + k*W, h );
+
+            row_max = simd::max( row_max, simd::min( h, simd::load( cap_hi + k*W ) ) );
+            if (TYPE != LOCAL)
+                v_min = simd::min( v_min, simd::max( h, simd::load( cap_lo + k*W ) ) );
+
+            // propagate the horizontal gaps within each lane
+            E    = simd::max( simd::adds( E, v_G_e ), simd::adds( h, v_G_o ) );
+            diag = top;
+        }
+
+        // lazy-F loop: propagate the horizontal gaps across the lanes until they no longer
+        // improve the ones each cell has already seen, as from then on nothing could change
+        E = simd::shift_in( E, score_type( T_MIN ) );
+        for (uint32 k = 0; true;)
+        {
+            const vec e_old = simd::load( E_curr + k*W );
+            if (simd::any( simd::cmpgt( E, e_old ) ) == false)
+                break;
+
+            E = simd::max( E, e_old );
+            simd::store( E_curr + k*W, E );
+
+            const vec h_new = simd::max( simd::load( H_curr + k*W ), E );
+            simd::store( H_curr + k*W, h_new );
+
+            row_max = simd::max( row_max, simd::min( h_new, simd::load( cap_hi + k*W ) ) );
+
+            E = simd::max( simd::adds( E, v_G_e ), simd::adds( h_new, v_G_o ) );
+
+            if (++k == S)
+            {
+                E = simd::shift_in( E, score_type( T_MIN ) );
+                k = 0;
+            }
+        }
+
+        v_max = simd::max( v_max, row_max );
+
+        if (TYPE == LOCAL)
+        {
+            // keep track of the first row containing the best cell
+            if (simd::any( simd::cmpgt( row_max, simd::set1( score_type( nvbio::max( best_score, T_MIN ) ) ) ) ))
+            {
+                score_type lanes[ W ];
+                simd::store( lanes, row_max );
+
+                for (uint32 l = 0; l < W; ++l)
+                    best_score = nvbio::max( best_score, int32( lanes[l] ) );
+
+                best_row = i;
+                for (uint32 k = 0; k < S; ++k)
+                    simd::store( B + k*W, simd::load( H_curr + k*W ) );
+            }
+        }
+        else if (TYPE == SEMI_GLOBAL || i+1 == N)
+        {
+            // save the last column
+            last[i] = H_curr[ ((M-1) % S) * W + (M-1) / S ];
+        }
+
+        std::swap( H_prev, H_curr );
+    }
+
+    // check for overflows
+    {
+        score_type lanes[ 2*W ];
+        simd::store( lanes,     v_max );
+        simd::store( lanes + W, v_min );
+
+        for (uint32 l = 0; l < W; ++l)
+        {
+            if (lanes[l] >= T_MAX || lanes[W + l] <= T_MIN)
+                return false;
+        }
+    }
+
+    if (TYPE == LOCAL)
+    {
+        // find the right-most best cell in the best row
+        uint32 best_col = 0u;
+        for (uint32 j = 0; j < M; ++j)
+        {
+            if (B[ (j % S) * W + j / S ] == best_score)
+                best_col = j+1;
+        }
+        sink.report( best_score, make_uint2( best_row+1, best_col ) );
+    }
+    else if (TYPE == GLOBAL)
+        sink.report( int32( last[N-1] ), make_uint2( N, M ) );
+    else
+    {
+        for (uint32 i = 0; i < N; ++i)
+            sink.report( int32( last[i] ), make_uint2( i+1, M ) );
+    }
+    return true;
+}
+
+///@} // end of the private group
+
+//
+// Calculate the alignment score between a pattern and a text, using Farrar's striped
+// formulation of the Gotoh algorithm.
+// The striped kernel allocates its own scratch storage (see gotoh_striped_score()), while
+// problems whose scores don't fit in 16 bits fall back to the scalar TextBlockingTag
+// implementation, which requires the same column storage.
+//
+template <
+    AlignmentType   TYPE,
+    typename        scoring_type,
+    typename        pattern_string,
+    typename        qual_string,
+    typename        text_string,
+    typename        column_type>
+struct alignment_score_dispatch<
+    GotohAligner<TYPE,scoring_type,StripedTag>,
+    pattern_string,
+    qual_string,
+    text_string,
+    column_type>
+{
+    typedef GotohAligner<TYPE,scoring_type,StripedTag> aligner_type;
+
+    /// dispatch scoring across the whole pattern
+    ///
+    /// \param aligner      scoring scheme
+    /// \param pattern      pattern string (horizontal)
+    /// \param quals        pattern qualities
+    /// \param text         text string (vertical)
+    /// \param min_score    minimum score
+    /// \param sink         output alignment sink
+    /// \param column       temporary column storage, only used by the scalar fallback
+    ///
+    /// \return             true iff the minimum score was reached
+    ///
+    template <typename sink_type>
+    static bool dispatch(
+        const aligner_type      aligner,
+        const pattern_string    pattern,
+        const qual_string       quals,
+        const text_string       text,
+        const  int32            min_score,
+              sink_type&        sink,
+              column_type       column)
+    {
+        if (pattern.length() && text.length() &&
+            gotoh_striped_score<TYPE>( aligner.scheme, pattern, quals, text, sink ))
+            return true;
+
+        typedef GotohAligner<TYPE,scoring_type,TextBlockingTag> fallback_aligner_type;
+        typedef alignment_score_dispatch<fallback_aligner_type,pattern_string,qual_string,text_string,column_type> fallback_dispatcher;
+
+        return fallback_dispatcher::dispatch(
+            fallback_aligner_type( aligner.scheme ),
+            pattern,
+            quals,
+            text,
+            min_score,
+            sink,
+            column );
+    }
+};
+
+} // namespace priv
+
+} // namespace aln
+} // namespace nvbio
@@ -0,0 +1,487 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <nvbio/alignment/sink.h>
+#include <nvbio/alignment/utils.h>
+#include <nvbio/alignment/alignment_base_inl.h>
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/numbers.h>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace nvbio {
+namespace aln {
+
+// ----------------------------- Myers functions ---------------------------- //
+
+namespace priv
+{
+
+///@addtogroup private
+///@{
+
+///
+/// Advance a 64-row block of Myers' bit-vector edit distance matrix by one text column,
+/// following Hyyrö's formulation for multi-word patterns.
+///
+/// \param Eq           the match vector of the current text symbol in this block
+/// \param VP           in/out positive vertical deltas
+/// \param VN           in/out negative vertical deltas
+/// \param h_in         the horizontal delta entering the top of the block, in {-1,0,+1}
+/// \param hi_bit       the mask of the last row of the block
+///
+/// \return             the horizontal delta leaving the bottom of the block
+///
+NVBIO_FORCEINLINE
+int32 myers_block_column(uint64 Eq, uint64& VP, uint64& VN, const int32 h_in, const uint64 hi_bit)
+{
+    const uint64 Xv = Eq | VN;
+    if (h_in < 0)
+        Eq |= 1u;
+
+    const uint64 Xh = (((Eq & VP) + VP) ^ VP) | Eq;
+
+    uint64 HP = VN | ~(Xh | VP);
+    uint64 HN = VP & Xh;
+
+    const int32 h_out = (HP & hi_bit) ? 1 : (HN & hi_bit) ? -1 : 0;
+
+    HP <<= 1;
+    HN <<= 1;
+    if (h_in < 0)
+        HN |= 1u;
+    else if (h_in > 0)
+        HP |= 1u;
+
+    VP = HN | ~(Xv | HP);
+    VN = HP & Xv;
+    return h_out;
+}
+
+///
+/// A set of Myers' match vectors for a pattern of arbitrary length, split in 64-bit blocks:
+/// the vector of symbol c in block b is stored at index (b / G) * G * (ALPHABET_SIZE+1) + c * G + (b % G),
+/// i.e. in groups of G consecutive blocks, so that G-wide SIMD code can fetch the vectors of
+/// a block group with a single load; the extra symbol ALPHABET_SIZE matches nothing, and is
+/// used for text symbols outside of the alphabet.
+///
+template <uint32 ALPHABET_SIZE, uint32 G>
+struct MyersBlockVectors
+{
+    static const uint32 SYMBOLS = ALPHABET_SIZE + 1u;
+
+    /// build the match vectors of a given pattern
+    ///
+    template <typename pattern_string>
+    MyersBlockVectors(const pattern_string pattern) :
+        n_blocks( (pattern.length() + 63u) / 64u ),
+        B( util::divide_ri( n_blocks, G ) * G * SYMBOLS, uint64(0u) )
+    {
+        const uint32 M = pattern.length();
+        for (uint32 j = 0; j < M; ++j)
+        {
+            const uint32 c = uint8( pattern[j] );
+            if (c < ALPHABET_SIZE)
+                B[ index( c, j / 64u ) ] |= uint64(1u) << (j & 63u);
+        }
+    }
+
+    /// return the index of the vector of symbol c in a given block
+    ///
+    static uint32 index(const uint32 c, const uint32 block) { return (block / G) * G * SYMBOLS + c * G + (block % G); }
+
+    /// return the vector of symbol c in a given block
+    ///
+    uint64 get(const uint32 c, const uint32 block) const { return B[ index( nvbio::min( c, ALPHABET_SIZE ), block ) ]; }
+
+    uint32              n_blocks;
+    std::vector<uint64> B;
+};
+
+///
+/// Block-based Myers edit distance scoring (Hyyrö, 2003) for patterns of arbitrary length,
+/// with Ukkonen's cut-off: only the blocks whose cells may still be within the edit distance
+/// threshold implied by min_score are updated, so that the work per text column is proportional
+/// to the threshold rather than to the pattern length.
+///\par
+/// Only GLOBAL and SEMI_GLOBAL alignment are supported, with the sink reports of the
+/// TextBlockingTag implementation, except that cells scoring below min_score are not reported.
+///
+/// \return     false if min_score cannot be reached
+///
+template <
+    AlignmentType   TYPE,
+    uint32          ALPHABET_SIZE,
+    typename        pattern_string,
+    typename        text_string,
+    typename        sink_type>
+bool myers_block_score(
+    const MyersBlockVectors<ALPHABET_SIZE,4u>&  Peq,
+    const pattern_string                        pattern,
+    const text_string                           text,
+    const int32                                 max_dist,
+          sink_type&                            sink)
+{
+    const uint32 M = pattern.length();
+    const uint32 N = text.length();
+    const uint32 n_blocks = Peq.n_blocks;
+    const uint32 last     = n_blocks - 1u;
+
+    const uint64 HI_BIT   = uint64(1u) << 63;
+    const uint64 LAST_BIT = uint64(1u) << ((M - 1u) & 63u);
+
+    std::vector<uint64> storage( n_blocks * 2u );
+    std::vector<int32>  scores( n_blocks );
+
+    uint64* VP = &storage[0];
+    uint64* VN = VP + n_blocks;
+
+    // the number of rows of each block
+    #define NVBIO_MYERS_BLOCK_ROWS(b) int32( (b) == last ? M - (b) * 64u : 64u )
+
+    // start with the blocks which may contain cells within the threshold
+    int32 y = int32( nvbio::min( n_blocks, util::divide_ri( uint32( max_dist ) + 1u, 64u ) ) ) - 1;
+    for (int32 b = 0; b <= y; ++b)
+    {
+        VP[b] = ~uint64(0u);
+        VN[b] = 0u;
+        scores[b] = (b ? scores[b-1] : 0) + NVBIO_MYERS_BLOCK_ROWS(b);
+    }
+
+    for (uint32 i = 0; i < N; ++i)
+    {
+        const uint32 c = uint8( text[i] );
+
+        // global alignment starts each column from the top row D[0][i] = i
+        int32 h = TYPE == GLOBAL ? 1 : 0;
+
+        for (int32 b = 0; b <= y; ++b)
+        {
+            h = myers_block_column( Peq.get( c, b ), VP[b], VN[b], h, uint32(b) == last ? LAST_BIT : HI_BIT );
+            scores[b] += h;
+        }
+
+        // Ukkonen's cut-off: add the next block if its first cell may be within the threshold...
+        if (y < int32( last ) &&
+            scores[y] - h <= max_dist &&
+            ((Peq.get( c, y+1 ) & 1u) || h < 0))
+        {
+            ++y;
+            VP[y] = ~uint64(0u);
+            VN[y] = 0u;
+            scores[y] = scores[y-1] - h + NVBIO_MYERS_BLOCK_ROWS(y) +
+                myers_block_column( Peq.get( c, y ), VP[y], VN[y], h, uint32(y) == last ? LAST_BIT : HI_BIT );
+        }
+        else
+        {
+            // ...or drop the bottom blocks whose cells are all beyond it
+            while (y >= 0 && scores[y] >= max_dist + 64)
+                --y;
+        }
+
+        if (y < 0)
+        {
+            // under semi-global alignment the top row is free, and the first block is always kept
+            if (TYPE == GLOBAL)
+                return false;
+
+            y = 0;
+        }
+
+        if (TYPE == SEMI_GLOBAL && y == int32( last ) && scores[y] <= max_dist)
+            sink.report( -scores[y], make_uint2( i+1, M ) );
+    }
+    #undef NVBIO_MYERS_BLOCK_ROWS
+
+    if (TYPE == GLOBAL)
+    {
+        if (y < int32( last ) || scores[last] > max_dist)
+            return false;
+
+        sink.report( -scores[last], make_uint2( N, M ) );
+    }
+    return true;
+}
+
+#if defined(__AVX2__)
+
+///
+/// AVX2 block-based Myers edit distance scoring, processing groups of 4 consecutive
+/// blocks at once: within a group the blocks advance along an anti-diagonal wavefront,
+/// so that at each step lane l processes block 4g+l on text column s-l, taking its
+/// horizontal input from lane l-1 at the previous step, while the horizontal deltas
+/// leaving the bottom of each group are saved for the whole text and fed to the next one.
+/// The whole matrix is computed, and the threshold is only checked once per group:
+/// any path to the last row has to cross the bottom row of each group, and edit
+/// distances never decrease along a path.
+///\par
+/// Only GLOBAL and SEMI_GLOBAL alignment are supported, with the same semantics as
+/// myers_block_score().
+///
+/// \return     false if min_score cannot be reached
+///
+template <
+    AlignmentType   TYPE,
+    uint32          ALPHABET_SIZE,
+    typename        pattern_string,
+    typename        text_string,
+    typename        sink_type>
+bool myers_block_score_avx2(
+    const MyersBlockVectors<ALPHABET_SIZE,4u>&  Peq,
+    const pattern_string                        pattern,
+    const text_string                           text,
+    const int32                                 max_dist,
+          sink_type&                            sink)
+{
+    typedef MyersBlockVectors<ALPHABET_SIZE,4u> vectors_type;
+
+    const uint32 M = pattern.length();
+    const uint32 N = text.length();
+    const uint32 n_blocks = Peq.n_blocks;
+    const uint32 n_groups = util::divide_ri( n_blocks, 4u );
+
+    // the horizontal deltas along the bottom row of the last processed group,
+    // initialized with those of the top row of the matrix
+    std::vector<int8>  h_row( N, int8( TYPE == GLOBAL ? 1 : 0 ) );
+    std::vector<uint8> symbols( N );
+    for (uint32 i = 0; i < N; ++i)
+        symbols[i] = uint8( nvbio::min( uint32( uint8( text[i] ) ), ALPHABET_SIZE ) );
+
+    const __m256i ones = _mm256_set1_epi64x( -1 );
+    const __m256i one  = _mm256_set1_epi64x( 1 );
+
+    for (uint32 g = 0; g < n_groups; ++g)
+    {
+        const uint64* B = &Peq.B[ vectors_type::index( 0u, g * 4u ) ];
+
+        // the lane holding the last row of this group
+        const uint32 out_lane = nvbio::min( 3u, n_blocks - 1u - g * 4u );
+
+        // the shifts bringing the last row of each block to bit 0
+        const uint32 last_shift = (M - 1u) & 63u;
+        const __m256i hi_shift = _mm256_set_epi64x(
+            g*4u + 3u == n_blocks - 1u ? last_shift : 63u,
+            g*4u + 2u == n_blocks - 1u ? last_shift : 63u,
+            g*4u + 1u == n_blocks - 1u ? last_shift : 63u,
+            g*4u + 0u == n_blocks - 1u ? last_shift : 63u );
+
+        __m256i VP = ones;
+        __m256i VN = _mm256_setzero_si256();
+        __m256i HP_out = _mm256_setzero_si256();
+        __m256i HN_out = _mm256_setzero_si256();
+
+        for (uint32 s = 0; s < N + 3u; ++s)
+        {
+            // fetch the match vectors of the column processed by each lane
+            const uint32 c0 = s      < N            ? symbols[s]    : ALPHABET_SIZE;
+            const uint32 c1 = s - 1u < N && s >= 1u ? symbols[s-1u] : ALPHABET_SIZE;
+            const uint32 c2 = s - 2u < N && s >= 2u ? symbols[s-2u] : ALPHABET_SIZE;
+            const uint32 c3 = s - 3u < N && s >= 3u ? symbols[s-3u] : ALPHABET_SIZE;
+
+            __m256i Eq = _mm256_set_epi64x(
+                B[ c3 * 4u + 3u ],
+                B[ c2 * 4u + 2u ],
+                B[ c1 * 4u + 1u ],
+                B[ c0 * 4u + 0u ] );
+
+            // the horizontal inputs: lane 0 reads the bottom row of the previous group,
+            // lane l the output of lane l-1 at the previous step
+            const int32 h0 = s < N ? h_row[s] : 0;
+            const __m256i HP_in = _mm256_blend_epi32( _mm256_permute4x64_epi64( HP_out, 0x93 ), _mm256_set_epi64x( 0, 0, 0, h0 > 0 ? 1 : 0 ), 0x03 );
+            const __m256i HN_in = _mm256_blend_epi32( _mm256_permute4x64_epi64( HN_out, 0x93 ), _mm256_set_epi64x( 0, 0, 0, h0 < 0 ? 1 : 0 ), 0x03 );
+
+            const __m256i Xv = _mm256_or_si256( Eq, VN );
+            Eq = _mm256_or_si256( Eq, HN_in );
+
+            const __m256i Xh = _mm256_or_si256( _mm256_xor_si256( _mm256_add_epi64( _mm256_and_si256( Eq, VP ), VP ), VP ), Eq );
+
+            __m256i HP = _mm256_or_si256( VN, _mm256_andnot_si256( _mm256_or_si256( Xh, VP ), ones ) );
+            __m256i HN = _mm256_and_si256( VP, Xh );
+
+            HP_out = _mm256_and_si256( _mm256_srlv_epi64( HP, hi_shift ), one );
+            HN_out = _mm256_and_si256( _mm256_srlv_epi64( HN, hi_shift ), one );
+
+            HP = _mm256_or_si256( _mm256_slli_epi64( HP, 1 ), HP_in );
+            HN = _mm256_or_si256( _mm256_slli_epi64( HN, 1 ), HN_in );
+
+            __m256i VP_new = _mm256_or_si256( HN, _mm256_andnot_si256( _mm256_or_si256( Xv, HP ), ones ) );
+            __m256i VN_new = _mm256_and_si256( HP, Xv );
+
+            if (s < 3u || s >= N)
+            {
+                // only lanes whose column lies within the text are active
+                const __m256i active = _mm256_set_epi64x(
+                    s - 3u < N && s >= 3u ? -1 : 0,
+                    s - 2u < N && s >= 2u ? -1 : 0,
+                    s - 1u < N && s >= 1u ? -1 : 0,
+                    s      < N            ? -1 : 0 );
+
+                VP_new = _mm256_blendv_epi8( VP, VP_new, active );
+                VN_new = _mm256_blendv_epi8( VN, VN_new, active );
+            }
+            VP = VP_new;
+            VN = VN_new;
+
+            // save the output of the lane holding the last row
+            if (s >= out_lane && s - out_lane < N)
+            {
+                const uint32 hp = _mm256_movemask_pd( _mm256_castsi256_pd( _mm256_slli_epi64( HP_out, 63 ) ) );
+                const uint32 hn = _mm256_movemask_pd( _mm256_castsi256_pd( _mm256_slli_epi64( HN_out, 63 ) ) );
+                h_row[ s - out_lane ] = int8( int32( (hp >> out_lane) & 1u ) - int32( (hn >> out_lane) & 1u ) );
+            }
+        }
+
+        // scan the bottom row of this group
+        const int32 rows = int32( nvbio::min( (g+1u) * 256u, M ) );
+
+        int32 score    = rows;
+        int32 min_dist = rows;
+        for (uint32 i = 0; i < N; ++i)
+        {
+            score += h_row[i];
+
+            if (g + 1u < n_groups)
+                min_dist = nvbio::min( min_dist, score );
+            else if (TYPE == SEMI_GLOBAL && score <= max_dist)
+                sink.report( -score, make_uint2( i+1, M ) );
+        }
+
+        if (g + 1u < n_groups)
+        {
+            // check whether the threshold can still be met
+            if (min_dist > max_dist)
+                return false;
+        }
+        else if (TYPE == GLOBAL)
+        {
+            if (score > max_dist)
+                return false;
+
+            sink.report( -score, make_uint2( N, M ) );
+        }
+    }
+    return true;
+}
+
+#endif
+
+///
+/// Calculate the alignment score between a pattern and a text, using the Myers bit-vector algorithm.
+/// Local alignment, and empty strings, are handled by the TextBlockingTag implementation.
+///
+/// \tparam TYPE                the alignment type
+/// \tparam pattern_string      pattern string 
+/// \tparam quals_string        pattern qualities
+/// \tparam text_string         text string
+/// \tparam column_type         temporary column storage
+///
+template <
+    AlignmentType   TYPE,
+    uint32          ALPHABET_SIZE,
+    typename        pattern_string,
+    typename        qual_string,
+    typename        text_string,
+    typename        column_type>
+struct alignment_score_dispatch<
+    EditDistanceAligner<TYPE,MyersTag<ALPHABET_SIZE> >,
+    pattern_string,
+    qual_string,
+    text_string,
+    column_type>
+{
+    typedef EditDistanceAligner<TYPE,MyersTag<ALPHABET_SIZE> > aligner_type;
+
+    /// dispatch scoring across the whole pattern
+    ///
+    /// \param aligner      scoring scheme
+    /// \param pattern      pattern string (horizontal)
+    /// \param quals        pattern qualities
+    /// \param text         text string (vertical)
+    /// \param min_score    minimum score
+    /// \param sink         output alignment sink
+    /// \param column       temporary column storage
+    ///
+    /// \return             true iff the minimum score was reached
+    ///
+    template <typename sink_type>
+    static bool dispatch(
+        const aligner_type      aligner,
+        const pattern_string    pattern,
+        const qual_string       quals,
+        const text_string       text,
+        const  int32            min_score,
+              sink_type&        sink,
+              column_type       column)
+    {
+        const uint32 M = pattern.length();
+        const uint32 N = text.length();
+
+        if (TYPE == LOCAL || M == 0u || N == 0u)
+        {
+            typedef EditDistanceAligner<TYPE,TextBlockingTag> fallback_aligner_type;
+            typedef alignment_score_dispatch<fallback_aligner_type,pattern_string,qual_string,text_string,column_type> fallback_dispatcher;
+
+            return fallback_dispatcher::dispatch(
+                fallback_aligner_type(),
+                pattern,
+                quals,
+                text,
+                min_score,
+                sink,
+                column );
+        }
+
+        // translate the minimum score into an edit distance threshold
+        if (min_score > 0)
+            return false;
+
+        const int32 max_dist = int32( nvbio::min( uint32( -int64( min_score ) ), M + N ) );
+
+        const MyersBlockVectors<ALPHABET_SIZE,4u> Peq( pattern );
+
+      #if defined(__AVX2__)
+        // process 4 blocks at a time unless the threshold leaves only a few blocks active
+        const uint32 n_band_blocks = util::divide_ri( uint32( max_dist ) + 1u, 64u ) + 1u;
+        if (Peq.n_blocks >= 4u && n_band_blocks * 4u >= Peq.n_blocks)
+            return myers_block_score_avx2<TYPE>( Peq, pattern, text, max_dist, sink );
+      #endif
+
+        return myers_block_score<TYPE>( Peq, pattern, text, max_dist, sink );
+    }
+};
+
+/// @} // end of private group
+
+} // namespace priv
+
+} // namespace aln
+} // namespace nvbio
@@ -190,6 +190,55 @@ private:
     ScoreType m_min_score;
 };
 
+///
+/// A sink for the result of a seed extension (see \ref ExtensionAligner), keeping the
+/// best extension, the best end-to-end extension (i.e. the best one covering the whole pattern)
+/// and whether the extension was terminated by the X-drop/Z-drop heuristics: all that is
+/// needed to decide whether to soft-clip the pattern.
+/// When passed to other aligners, it behaves as a BestSink.
+///
+template <typename ScoreType>
+struct ExtensionSink
+{
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    ExtensionSink();
+
+    /// invalidate
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    void invalidate();
+
+    /// store a valid alignment
+    ///
+    /// \param _score    alignment's score
+    /// \param _sink     alignment's end
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    void report(const ScoreType _score, const uint2 _sink);
+
+    /// store a valid end-to-end alignment
+    ///
+    /// \param _score    alignment's score
+    /// \param _sink     alignment's end
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    void report_end_to_end(const ScoreType _score, const uint2 _sink);
+
+    /// return true if the pattern should be clipped at the end of the best extension
+    /// rather than extended end-to-end, given the penalty for clipping it
+    ///
+    /// \param clip_penalty     the clipping penalty
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    bool clipped(const ScoreType clip_penalty) const;
+
+    ScoreType score;                ///< best extension score
+    uint2     sink;                 ///< best extension end
+    ScoreType end_to_end_score;     ///< best end-to-end extension score
+    uint2     end_to_end_sink;      ///< best end-to-end extension end
+    bool      dropped;              ///< true if the extension was terminated by X-drop/Z-drop
+};
+
 ///@} // end of the AlignmentSink group
 
 ///@} // end Alignment group
@@ -196,5 +196,68 @@ void BestColumnSink<ScoreType,N>::best2(uint32& i1, uint32& i2, const uint32 min
     }
 }
 
+// A sink for the result of a seed extension
+//
+template <typename ScoreType>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+ExtensionSink<ScoreType>::ExtensionSink() { invalidate(); }
+
+// invalidate
+//
+template <typename ScoreType>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void ExtensionSink<ScoreType>::invalidate()
+{
+    score            = Field_traits<ScoreType>::min();
+    sink             = make_uint2( uint32(-1), uint32(-1) );
+    end_to_end_score = Field_traits<ScoreType>::min();
+    end_to_end_sink  = make_uint2( uint32(-1), uint32(-1) );
+    dropped          = false;
+}
+
+// store a valid alignment
+//
+// \param score    alignment's score
+// \param sink     alignment's end
+//
+template <typename ScoreType>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void ExtensionSink<ScoreType>::report(const ScoreType _score, const uint2 _sink)
+{
+    if (score <= _score)
+    {
+        score = _score;
+        sink  = _sink;
+    }
+}
+
+// store a valid end-to-end alignment
+//
+// \param score    alignment's score
+// \param sink     alignment's end
+//
+template <typename ScoreType>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void ExtensionSink<ScoreType>::report_end_to_end(const ScoreType _score, const uint2 _sink)
+{
+    if (end_to_end_score <= _score)
+    {
+        end_to_end_score = _score;
+        end_to_end_sink  = _sink;
+    }
+}
+
+// return true if the pattern should be clipped at the end of the best extension
+//
+template <typename ScoreType>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+bool ExtensionSink<ScoreType>::clipped(const ScoreType clip_penalty) const
+{
+    // NOTE: as in BWA-MEM, we prefer the end-to-end alignment unless clipping gives
+    // a better score even after paying the clipping penalty
+    return end_to_end_score == Field_traits<ScoreType>::min() ||
+           end_to_end_score <= score - clip_penalty;
+}
+
 } // namespace aln
 } // namespace nvbio
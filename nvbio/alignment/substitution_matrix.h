@@ -0,0 +1,132 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/numbers.h>
+#include <nvbio/strings/alphabet.h>
+
+namespace nvbio {
+namespace aln {
+
+///@addtogroup Alignment
+///@{
+
+///@addtogroup Utilities
+///@{
+
+///
+/// A substitution matrix over the 24-letter PROTEIN alphabet, as used by BLOSUM
+/// and PAM protein scoring.
+/// The stop codon '*' of the NCBI matrices is mapped to the O (pyrrolysine) symbol.
+///
+struct SubstitutionMatrix
+{
+    static const uint32 SYMBOLS = AlphabetTraits<PROTEIN>::SYMBOL_COUNT;
+
+    /// return the score of substituting symbol a with symbol b
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    int32 operator() (const uint8 a, const uint8 b) const { return m_scores[ a * SYMBOLS + b ]; }
+
+    /// return the lowest score in the matrix
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    int32 min_score() const;
+
+    /// return the highest score in the matrix
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    int32 max_score() const;
+
+    int8 m_scores[ SYMBOLS * SYMBOLS ];
+};
+
+/// return the BLOSUM62 substitution matrix
+///
+SubstitutionMatrix blosum62_matrix();
+
+/// load a substitution matrix from a file in the NCBI format (e.g. BLOSUM45, BLOSUM80 or PAM250
+/// as distributed with BLAST): the first non-comment line lists the column symbols, and each
+/// following line a row symbol followed by its scores.
+/// Any symbol missing from the file takes the scores of X, or the lowest score if X is missing as well.
+///
+/// \param filename     the matrix file
+/// \param matrix       the output matrix
+/// \return             true on success, false if the file could not be opened or parsed
+///
+bool load_substitution_matrix(const char* filename, SubstitutionMatrix* matrix);
+
+///
+/// An implementation of the \ref GotohScoringScheme model looking up substitution scores
+/// in a SubstitutionMatrix, e.g. for aligning PROTEIN strings.
+/// The matrix is indexed by text (row) and pattern (column) symbols; symbols outside
+/// of the PROTEIN alphabet (e.g. padding) are scored as X.
+///\par
+/// match() and mismatch() return the highest and lowest scores in the matrix, which the
+/// scoring kernels use as bounds for early termination; as the warp-parallel kernels only
+/// distinguish matches from mismatches, this scheme should not be used with the
+/// DeviceWarpScheduler.
+///
+struct MatrixGotohScheme
+{
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE MatrixGotohScheme() {}
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE MatrixGotohScheme(
+        const SubstitutionMatrix& matrix, const int32 gap_open, const int32 gap_ext) :
+        m_matrix(matrix), m_max(matrix.max_score()), m_min(matrix.min_score()), m_gap_open(gap_open), m_gap_ext(gap_ext) {}
+
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE int32 match(const uint8 q = 0)      const { return m_max; };
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE int32 mismatch(const uint8 q = 0)   const { return m_min; };
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE int32 mismatch(const uint8 a, const uint8 b, const uint8 q = 0)   const { return score( a, b ); };
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE int32 substitution(const uint32 r_i, const uint32 q_j, const uint8 r, const uint8 q, const uint8 qq = 0) const { return score( r, q ); };
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE int32 pattern_gap_open()            const { return m_gap_open; };
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE int32 pattern_gap_extension()       const { return m_gap_ext; };
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE int32 text_gap_open()               const { return m_gap_open; };
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE int32 text_gap_extension()          const { return m_gap_ext; };
+
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE int32 score(const uint8 r, const uint8 q) const
+    {
+        const uint32 X = SubstitutionMatrix::SYMBOLS - 1u;
+        return m_matrix( uint8( nvbio::min( uint32(r), X ) ), uint8( nvbio::min( uint32(q), X ) ) );
+    }
+
+    SubstitutionMatrix m_matrix;
+    int32              m_max;
+    int32              m_min;
+    int32              m_gap_open;
+    int32              m_gap_ext;
+};
+
+///@} // end of Utilities group
+///@} // end of Alignment group
+
+} // namespace aln
+} // namespace nvbio
+
+#include <nvbio/alignment/substitution_matrix_inl.h>
@@ -0,0 +1,218 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+namespace nvbio {
+namespace aln {
+
+// return the lowest score in the matrix
+//
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+int32 SubstitutionMatrix::min_score() const
+{
+    int32 r = m_scores[0];
+    for (uint32 i = 1; i < SYMBOLS * SYMBOLS; ++i)
+        r = nvbio::min( r, int32( m_scores[i] ) );
+    return r;
+}
+
+// return the highest score in the matrix
+//
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+int32 SubstitutionMatrix::max_score() const
+{
+    int32 r = m_scores[0];
+    for (uint32 i = 1; i < SYMBOLS * SYMBOLS; ++i)
+        r = nvbio::max( r, int32( m_scores[i] ) );
+    return r;
+}
+
+// return the BLOSUM62 substitution matrix
+//
+inline SubstitutionMatrix blosum62_matrix()
+{
+    // rows and columns in PROTEIN alphabet order: A,C,D,E,F,G,H,I,K,L,M,N,O,P,Q,R,S,T,V,W,Y,B,Z,X
+    static const int8 s_blosum62[] =
+    {
+     4,  0, -2, -1, -2,  0, -2, -1, -1, -1, -1, -2, -4, -1, -1, -1,  1,  0,  0, -3, -2, -2, -1,  0,
+     0,  9, -3, -4, -2, -3, -3, -1, -3, -1, -1, -3, -4, -3, -3, -3, -1, -1, -1, -2, -2, -3, -3, -2,
+    -2, -3,  6,  2, -3, -1, -1, -3, -1, -4, -3,  1, -4, -1,  0, -2,  0, -1, -3, -4, -3,  4,  1, -1,
+    -1, -4,  2,  5, -3, -2,  0, -3,  1, -3, -2,  0, -4, -1,  2,  0,  0, -1, -2, -3, -2,  1,  4, -1,
+    -2, -2, -3, -3,  6, -3, -1,  0, -3,  0,  0, -3, -4, -4, -3, -3, -2, -2, -1,  1,  3, -3, -3, -1,
+     0, -3, -1, -2, -3,  6, -2, -4, -2, -4, -3,  0, -4, -2, -2, -2,  0, -2, -3, -2, -3, -1, -2, -1,
+    -2, -3, -1,  0, -1, -2,  8, -3, -1, -3, -2,  1, -4, -2,  0,  0, -1, -2, -3, -2,  2,  0,  0, -1,
+    -1, -1, -3, -3,  0, -4, -3,  4, -3,  2,  1, -3, -4, -3, -3, -3, -2, -1,  3, -3, -1, -3, -3, -1,
+    -1, -3, -1,  1, -3, -2, -1, -3,  5, -2, -1,  0, -4, -1,  1,  2,  0, -1, -2, -3, -2,  0,  1, -1,
+    -1, -1, -4, -3,  0, -4, -3,  2, -2,  4,  2, -3, -4, -3, -2, -2, -2, -1,  1, -2, -1, -4, -3, -1,
+    -1, -1, -3, -2,  0, -3, -2,  1, -1,  2,  5, -2, -4, -2,  0, -1, -1, -1,  1, -1, -1, -3, -1, -1,
+    -2, -3,  1,  0, -3,  0,  1, -3,  0, -3, -2,  6, -4, -2,  0,  0,  1,  0, -3, -4, -2,  3,  0, -1,
+    -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4,  1, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4,
+    -1, -3, -1, -1, -4, -2, -2, -3, -1, -3, -2, -2, -4,  7, -1, -2, -1, -1, -2, -4, -3, -2, -1, -2,
+    -1, -3,  0,  2, -3, -2,  0, -3,  1, -2,  0,  0, -4, -1,  5,  1,  0, -1, -2, -2, -1,  0,  3, -1,
+    -1, -3, -2,  0, -3, -2,  0, -3,  2, -2, -1,  0, -4, -2,  1,  5, -1, -1, -3, -3, -2, -1,  0, -1,
+     1, -1,  0,  0, -2,  0, -1, -2,  0, -2, -1,  1, -4, -1,  0, -1,  4,  1, -2, -3, -2,  0,  0,  0,
+     0, -1, -1, -1, -2, -2, -2, -1, -1, -1, -1,  0, -4, -1, -1, -1,  1,  5,  0, -2, -2, -1, -1,  0,
+     0, -1, -3, -2, -1, -3, -3,  3, -2,  1,  1, -3, -4, -2, -2, -3, -2,  0,  4, -3, -1, -3, -2, -1,
+    -3, -2, -4, -3,  1, -2, -2, -3, -3, -2, -1, -4, -4, -4, -2, -3, -3, -2, -3, 11,  2, -4, -3, -2,
+    -2, -2, -3, -2,  3, -3,  2, -1, -2, -1, -1, -2, -4, -3, -1, -2, -2, -2, -1,  2,  7, -3, -2, -1,
+    -2, -3,  4,  1, -3, -1,  0, -3,  0, -4, -3,  3, -4, -2,  0, -1,  0, -1, -3, -4, -3,  4,  1, -1,
+    -1, -3,  1,  4, -3, -2,  0, -3,  1, -3, -1,  0, -4, -1,  3,  0,  0, -1, -2, -3, -2,  1,  4, -1,
+     0, -2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -4, -2, -1, -1,  0,  0, -1, -2, -1, -1, -1, -1,
+    };
+
+    SubstitutionMatrix matrix;
+    memcpy( matrix.m_scores, s_blosum62, sizeof(s_blosum62) );
+    return matrix;
+}
+
+namespace priv {
+
+// map a character of an NCBI matrix file to a PROTEIN symbol, or return -1 if it's not part of the alphabet
+//
+inline int32 substitution_matrix_symbol(const char c)
+{
+    static const char s_symbols[] = "ACDEFGHIKLMNOPQRSTVWYBZX";
+
+    if (c == '*')
+        return AlphabetTraits<PROTEIN>::O;
+
+    const char* p = strchr( s_symbols, c );
+    return (p && c) ? int32( p - s_symbols ) : -1;
+}
+
+} // namespace priv
+
+// load a substitution matrix from a file in the NCBI format
+//
+inline bool load_substitution_matrix(const char* filename, SubstitutionMatrix* matrix)
+{
+    const uint32 SYMBOLS = SubstitutionMatrix::SYMBOLS;
+
+    FILE* file = fopen( filename, "r" );
+    if (file == NULL)
+        return false;
+
+    int32 columns[256];
+    uint32 n_columns = 0;
+
+    int32 scores[ SYMBOLS * SYMBOLS ];
+    bool  found[ SYMBOLS * SYMBOLS ];
+    for (uint32 i = 0; i < SYMBOLS * SYMBOLS; ++i)
+        found[i] = false;
+
+    bool header = false;
+    bool ok     = true;
+
+    char line[4096];
+    while (ok && fgets( line, sizeof(line), file ))
+    {
+        // skip comments and blank lines
+        const char* p = line;
+        while (*p == ' ' || *p == '\t') ++p;
+        if (*p == '#' || *p == '\n' || *p == '\r' || *p == '\0')
+            continue;
+
+        if (header == false)
+        {
+            // parse the column symbols
+            for (; *p && n_columns < 256; ++p)
+            {
+                if (*p != ' ' && *p != '\t' && *p != '\n' && *p != '\r')
+                    columns[ n_columns++ ] = priv::substitution_matrix_symbol( *p );
+            }
+            header = true;
+            continue;
+        }
+
+        // parse a row
+        const int32 row = priv::substitution_matrix_symbol( *p++ );
+
+        for (uint32 c = 0; c < n_columns; ++c)
+        {
+            char* end;
+            const long score = strtol( p, &end, 10 );
+            if (end == p || score < -128 || score > 127)
+            {
+                ok = false;
+                break;
+            }
+            p = end;
+
+            if (row >= 0 && columns[c] >= 0)
+            {
+                scores[ row * SYMBOLS + columns[c] ] = int32( score );
+                found[  row * SYMBOLS + columns[c] ] = true;
+            }
+        }
+    }
+    fclose( file );
+
+    if (ok == false || header == false)
+        return false;
+
+    // fill in the missing entries with the scores of X, or with the lowest score
+    const uint32 X = AlphabetTraits<PROTEIN>::X;
+
+    int32 lowest = 127;
+    bool  any    = false;
+    for (uint32 i = 0; i < SYMBOLS * SYMBOLS; ++i)
+    {
+        if (found[i])
+        {
+            lowest = nvbio::min( lowest, scores[i] );
+            any    = true;
+        }
+    }
+    if (any == false)
+        return false;
+
+    for (uint32 a = 0; a < SYMBOLS; ++a)
+    {
+        for (uint32 b = 0; b < SYMBOLS; ++b)
+        {
+            const uint32 ab = a * SYMBOLS + b;
+            if (found[ab])
+                matrix->m_scores[ab] = int8( scores[ab] );
+            else if (found[ X * SYMBOLS + b ] && a != X)
+                matrix->m_scores[ab] = int8( scores[ X * SYMBOLS + b ] );
+            else if (found[ a * SYMBOLS + X ] && b != X)
+                matrix->m_scores[ab] = int8( scores[ a * SYMBOLS + X ] );
+            else
+                matrix->m_scores[ab] = int8( lowest );
+        }
+    }
+    return true;
+}
+
+} // namespace aln
+} // namespace nvbio
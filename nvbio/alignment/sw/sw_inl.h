@@ -194,10 +194,7 @@ struct SWCheckpointedScoringContext
         const column_type   column)
     {
         for (uint32 i = 0; i < N; ++i)
-        {
-            m_checkpoint[i].x = column[i].x;
-            m_checkpoint[i].y = column[i].y;
-        }
+            m_checkpoint[i] = column[i];
     }
 
     /// do something with the newly computed cell
@@ -29,6 +29,7 @@
 
 #include <nvbio/basic/packedstream.h>
 #include <nvbio/alignment/sink.h>
+#include <nvbio/alignment/substitution_matrix.h>
 
 namespace nvbio {
 namespace aln {
@@ -62,6 +63,7 @@ template <AlignmentType TYPE, typename algorithm_tag>                        str
 template <AlignmentType TYPE, typename scoring_type, typename algorithm_tag> struct column_storage_type< HammingDistanceAligner<TYPE,scoring_type,algorithm_tag> >  { typedef  int16 type; };
 template <AlignmentType TYPE, typename scoring_type, typename algorithm_tag> struct column_storage_type< SmithWatermanAligner<TYPE,scoring_type,algorithm_tag> >    { typedef  int16 type; };
 template <AlignmentType TYPE, typename scoring_type, typename algorithm_tag> struct column_storage_type< GotohAligner<TYPE,scoring_type,algorithm_tag> >            { typedef short2 type; };
+template <AlignmentType TYPE, typename scoring_type>                         struct column_storage_type< WavefrontAligner<TYPE,scoring_type> >                      { typedef short2 type; };  // used by the Gotoh fallback
 
 /// A meta-function returning the number of bits required to represent the direction vectors
 /// for a given \ref Aligner "Aligner"
@@ -81,6 +83,19 @@ template <AlignmentType TYPE, typename scoring_type, typename algorithm_tag> str
     static const uint32 BITS = 4;   ///< the number of bits needed to encode direction vectors
 };
 
+/// A meta-function returning whether the traceback of a given \ref Aligner "Aligner" needs
+/// the caller to provide the checkpoint, submatrix and column storage described above;
+/// the WavefrontAligner manages its own temporary storage.
+///
+/// \tparam aligner_type        the queries \ref Aligner "Aligner" type
+///
+template <typename aligner_type> struct needs_checkpoint_storage {
+    static const bool pred = true;  ///< whether the traceback needs checkpoint storage
+};
+template <AlignmentType TYPE, typename scoring_type> struct needs_checkpoint_storage< WavefrontAligner<TYPE,scoring_type> > {
+    static const bool pred = false; ///< whether the traceback needs checkpoint storage
+};
+
 ///@}
 
 ///@defgroup Utilities
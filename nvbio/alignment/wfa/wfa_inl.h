@@ -0,0 +1,1217 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <nvbio/alignment/sink.h>
+#include <nvbio/alignment/utils.h>
+#include <nvbio/alignment/alignment_base_inl.h>
+#include <nvbio/alignment/gotoh/gotoh_inl.h>
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/numbers.h>
+#include <nvbio/basic/popcount.h>
+#include <vector>
+#include <list>
+#include <string.h>
+
+namespace nvbio {
+namespace aln {
+
+// ----------------------------- Wavefront functions ---------------------------- //
+
+namespace priv
+{
+
+///@addtogroup private
+///@{
+
+//
+// The wavefront algorithm (Marco-Sola et al., 2021) works on the diagonals k = h - v of the
+// DP matrix, where h and v are the number of text and pattern symbols consumed so far,
+// tracking for each penalty s and diagonal k the furthest reaching cell of the three Gotoh
+// matrices M (any edit), I (ending with an insertion, i.e. a pattern symbol aligned to a gap)
+// and D (ending with a deletion, i.e. a text symbol aligned to a gap), identified by its
+// text offset h:
+//
+//   I[s][k] = max( M[s-o-e][k+1], I[s-e][k+1] )
+//   D[s][k] = max( M[s-o-e][k-1], D[s-e][k-1] ) + 1
+//   M[s][k] = extend( max( M[s-x][k] + 1, I[s][k], D[s][k] ) )
+//
+// where extend() follows the exact matches along the diagonal for free.
+//
+
+enum WavefrontComponent
+{
+    WAVEFRONT_M = 0u,
+    WAVEFRONT_I = 1u,
+    WAVEFRONT_D = 2u
+};
+
+static const int32 WAVEFRONT_NULL        = -(1 << 30);  // the offset of the cells not reached by a wavefront
+static const int32 WAVEFRONT_MAX_PENALTY =  (1 << 29);  // a penalty larger than any alignment's
+
+// BiWFA subproblems whose penalty is at most this are solved keeping all their wavefronts
+static const int32 BIWFA_FULL_PENALTY    = 250;
+
+///
+/// The gap-affine penalties equivalent to a Gotoh scoring scheme (Eizenga and Paten, 2022):
+/// given a match score m, a mismatch score mm, and gaps of length L scoring G_o + (L-1) G_e,
+/// a global alignment of a pattern of length M and a text of length N scoring S has penalty
+///
+///   P = m (M + N) - 2 S
+///
+/// where mismatches cost x = 2 (m - mm), and gaps cost o + L e, with o = 2 (G_e - G_o)
+/// and e = m - 2 G_e.
+/// The penalties are further divided by their greatest common divisor, which reduces the
+/// number of wavefronts to compute.
+///
+struct WavefrontPenalties
+{
+    int32 x;        ///< mismatch penalty
+    int32 o;        ///< gap open penalty
+    int32 e;        ///< gap extension penalty
+    int32 factor;   ///< the common factor divided out of the penalties
+    int32 match;    ///< the match score
+
+    /// the number of wavefronts needed to compute the next one
+    ///
+    int32 window() const { return nvbio::max( x, o + e ) + 1; }
+
+    /// convert a penalty to the score of a global alignment of the given lengths
+    ///
+    int32 score(const int32 penalty, const uint32 M, const uint32 N) const
+    {
+        return (match * int32(M + N) - factor * penalty) / 2;
+    }
+
+    /// convert a minimum score to the maximum penalty of a global alignment of the given lengths,
+    /// returning -1 if no alignment could reach it
+    ///
+    int32 max_penalty(const int32 min_score, const uint32 M, const uint32 N) const
+    {
+        const int64 p = int64( match ) * int64( M + N ) - 2 * int64( min_score );
+        return p < 0 ? -1 : int32( nvbio::min( p / factor, int64( WAVEFRONT_MAX_PENALTY ) ) );
+    }
+};
+
+// greatest common divisor
+//
+inline int32 wavefront_gcd(int32 a, int32 b)
+{
+    while (b)
+    {
+        const int32 r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+//
+// Derive the wavefront penalties corresponding to a Gotoh scoring scheme, returning false
+// if the alignment can't be computed with the wavefront algorithm.
+//
+// \param scoring       the scoring scheme
+// \param quals         the pattern qualities
+// \param M             the pattern length
+// \param symbol_bits   the bitwise OR of all the pattern and text symbols
+// \param penalties     the output penalties
+//
+template <AlignmentType TYPE, typename scoring_type, typename qual_string>
+bool wavefront_penalties(
+    const scoring_type&     scoring,
+    const qual_string       quals,
+    const uint32            M,
+    const uint32            symbol_bits,
+    WavefrontPenalties&     penalties)
+{
+    if (TYPE == LOCAL)
+        return false;
+
+    const int32 m   = scoring.match();
+    const int32 mm  = scoring.mismatch();
+    const int32 G_o = scoring.pattern_gap_open();
+    const int32 G_e = scoring.pattern_gap_extension();
+
+    // the DP aligners use the text gap penalties along the first column only: make sure
+    // there's no difference
+    if (scoring.text_gap_open() != G_o || scoring.text_gap_extension() != G_e)
+        return false;
+
+    // with a match bonus, the penalty of a semi-global alignment would depend on its length
+    if (TYPE == SEMI_GLOBAL && m != 0)
+        return false;
+
+    // the substitution scores must not depend on the base qualities
+    for (uint32 j = 0; j < M; ++j)
+    {
+        if (scoring.match( quals[j] ) != m || scoring.mismatch( quals[j] ) != mm)
+            return false;
+    }
+
+    // nor on the symbols themselves, as with substitution matrices: as the wavefronts only compare
+    // symbols for equality, check all the pairs of symbols the strings may hold, including N's and
+    // any other code past the 2-bit alphabet; their OR bounds them by a power of 2, which with
+    // 2-bit symbols is just the 4 x 4 DNA table, and with N's the 8 x 8 one
+    uint32 n_symbols = 4u;
+    while (n_symbols <= symbol_bits)
+        n_symbols *= 2u;
+
+    for (uint32 a = 0; a < n_symbols; ++a)
+    {
+        for (uint32 b = 0; b < n_symbols; ++b)
+        {
+            if (scoring.substitution( 0u, 1u, uint8(a), uint8(b) ) != (a == b ? m : mm))
+                return false;
+        }
+    }
+
+    const int32 x = 2 * (m - mm);
+    const int32 o = 2 * (G_e - G_o);
+    const int32 e = m - 2 * G_e;
+
+    // the algorithm needs all edits to cost something, and gap openings not to be rewarded
+    if (x <= 0 || e <= 0 || o < 0)
+        return false;
+
+    const int32 factor = wavefront_gcd( wavefront_gcd( x, e ), o );
+
+    penalties.x      = x / factor;
+    penalties.o      = o / factor;
+    penalties.e      = e / factor;
+    penalties.factor = factor;
+    penalties.match  = m;
+    return true;
+}
+
+//
+// Return the length of the longest common prefix of two strings, up to a maximum of n symbols,
+// comparing 4 symbols at a time (on a little-endian host)
+//
+inline int32 wavefront_lcp(const uint8* a, const uint8* b, const int32 n)
+{
+    int32 i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        uint32 a4, b4;
+        memcpy( &a4, a + i, 4u );
+        memcpy( &b4, b + i, 4u );
+
+        if (a4 != b4)
+            return i + int32( nvbio::ffs( int32( a4 ^ b4 ) ) - 1u ) / 8;
+    }
+    while (i < n && a[i] == b[i])
+        ++i;
+
+    return i;
+}
+
+///
+/// A pool of wavefront offsets, allocated in geometrically growing blocks so that the arrays
+/// handed out never move; clearing the pool recycles all the blocks
+///
+struct WavefrontPool
+{
+    static const uint32 BLOCK_SIZE = 4u * 1024u;
+
+    WavefrontPool() : m_block( m_blocks.end() ), m_used( 0u ) {}
+
+    /// recycle all the blocks
+    ///
+    void clear()
+    {
+        m_block = m_blocks.begin();
+        m_used  = 0u;
+    }
+
+    /// allocate an array of offsets
+    ///
+    int32* allocate(const uint32 size)
+    {
+        while (m_block != m_blocks.end() && m_used + size > m_block->size())
+        {
+            ++m_block;
+            m_used = 0u;
+        }
+        if (m_block == m_blocks.end())
+        {
+            const uint32 block_size = m_blocks.empty() ? BLOCK_SIZE : 2u * uint32( m_blocks.back().size() );
+            m_blocks.push_back( std::vector<int32>( nvbio::max( size, block_size ) ) );
+            m_block = --m_blocks.end();
+            m_used  = 0u;
+        }
+        int32* r = &(*m_block)[ m_used ];
+        m_used += size;
+        return r;
+    }
+
+    std::list< std::vector<int32> >             m_blocks;
+    std::list< std::vector<int32> >::iterator   m_block;
+    uint32                                      m_used;
+
+private:
+    WavefrontPool(const WavefrontPool&);
+    WavefrontPool& operator=(const WavefrontPool&);
+};
+
+///
+/// A wavefront, i.e. the furthest reaching offsets along a range of diagonals for a given
+/// penalty and Gotoh matrix
+///
+struct Wavefront
+{
+    Wavefront() : lo( 0 ), hi( -1 ), offsets( NULL ), capacity( 0u ) {}
+
+    /// return whether the wavefront is empty
+    ///
+    bool is_null() const { return lo > hi; }
+
+    /// return the offset along the k-th diagonal
+    ///
+    int32 operator[] (const int32 k) const { return (k >= lo && k <= hi) ? offsets[ k - lo ] : WAVEFRONT_NULL; }
+
+    int32   lo;         ///< first diagonal
+    int32   hi;         ///< last diagonal
+    int32*  offsets;    ///< the offsets of the diagonals [lo,hi]
+    uint32  capacity;   ///< the size of the offsets array
+};
+
+///
+/// The M, I and D wavefronts computed along one direction, keeping either all of them or
+/// only the sliding window needed to compute the next ones
+///
+struct WavefrontSet
+{
+    WavefrontSet() : m_window( 0u ) {}
+
+    /// reset the set
+    ///
+    /// \param window       the number of wavefronts to keep, or 0 to keep them all
+    ///
+    void init(const uint32 window)
+    {
+        m_window = window;
+        m_pool.clear();
+        for (uint32 c = 0; c < 3; ++c)
+        {
+            m_wavefronts[c].clear();
+            m_wavefronts[c].resize( window );
+        }
+    }
+
+    /// make room for the wavefronts of a given penalty, invalidating all references
+    ///
+    void reserve(const int32 s)
+    {
+        if (m_window == 0u && m_wavefronts[0].size() <= uint32( s ))
+        {
+            for (uint32 c = 0; c < 3; ++c)
+                m_wavefronts[c].resize( s + 1u );
+        }
+    }
+
+    /// return the wavefront of a given penalty (empty if the penalty is negative)
+    ///
+    const Wavefront& get(const uint32 c, const int32 s) const { return s >= 0 ? m_wavefronts[c][ slot( s ) ] : m_null; }
+
+    /// return the wavefront of a given penalty
+    ///
+    Wavefront& get(const uint32 c, const int32 s) { return m_wavefronts[c][ slot( s ) ]; }
+
+    /// allocate the wavefront of a given penalty over the diagonals [lo,hi]
+    ///
+    Wavefront& allocate(const uint32 c, const int32 s, const int32 lo, const int32 hi)
+    {
+        Wavefront& wf = m_wavefronts[c][ slot( s ) ];
+
+        const uint32 size = uint32( hi - lo + 1 );
+        if (wf.capacity < size)
+        {
+            // sliding windows recycle their arrays, growing them geometrically
+            wf.capacity = m_window ? nvbio::max( size, 2u * wf.capacity ) : size;
+            wf.offsets  = m_pool.allocate( wf.capacity );
+        }
+        wf.lo = lo;
+        wf.hi = hi;
+        return wf;
+    }
+
+    /// mark the wavefront of a given penalty as empty
+    ///
+    void set_null(const uint32 c, const int32 s)
+    {
+        Wavefront& wf = m_wavefronts[c][ slot( s ) ];
+        wf.lo = 0;
+        wf.hi = -1;
+    }
+
+    uint32 slot(const int32 s) const { return m_window ? uint32( s ) % m_window : uint32( s ); }
+
+    uint32                  m_window;
+    std::vector<Wavefront>  m_wavefronts[3];
+    Wavefront               m_null;
+    WavefrontPool           m_pool;
+};
+
+///
+/// The wavefronts of an alignment between two strings, computed for increasing penalties
+///
+struct WavefrontRun
+{
+    /// start a new alignment, computing the wavefronts of penalty 0
+    ///
+    /// \param _text            text string
+    /// \param _N               text length
+    /// \param _pattern         pattern string
+    /// \param _M               pattern length
+    /// \param _penalties       alignment penalties
+    /// \param begin_component  the Gotoh matrix the alignment starts from: starting from I or D
+    ///                         continues a gap opened by a preceding alignment, which
+    ///                         must then go on with at least one more gap symbol
+    /// \param text_begin_free  whether the alignment can start anywhere along the text
+    /// \param window           the number of wavefronts to keep, or 0 to keep them all
+    ///
+    void init(
+        const uint8*                _text,
+        const int32                 _N,
+        const uint8*                _pattern,
+        const int32                 _M,
+        const WavefrontPenalties&   _penalties,
+        const uint32                begin_component,
+        const bool                  text_begin_free,
+        const uint32                window)
+    {
+        text      = _text;
+        N         = _N;
+        pattern   = _pattern;
+        M         = _M;
+        penalties = _penalties;
+        score     = 0;
+
+        wavefronts.init( window );
+        wavefronts.reserve( 0 );
+
+        for (uint32 c = WAVEFRONT_M; c <= WAVEFRONT_D; ++c)
+            wavefronts.set_null( c, 0 );
+
+        if (begin_component == WAVEFRONT_M)
+        {
+            Wavefront& m = wavefronts.allocate( WAVEFRONT_M, 0, 0, text_begin_free ? N : 0 );
+            for (int32 k = m.lo; k <= m.hi; ++k)
+                m.offsets[ k - m.lo ] = k;
+        }
+        else
+            wavefronts.allocate( begin_component, 0, 0, 0 ).offsets[0] = 0;
+
+        extend();
+    }
+
+    /// compute the wavefronts of the next penalty
+    ///
+    void next()
+    {
+        ++score;
+        compute();
+        extend();
+    }
+
+    /// return whether the current M, I or D wavefront reached the end of both strings
+    ///
+    bool reached_end(const uint32 end_component) const
+    {
+        return wavefronts.get( end_component, score )[ N - M ] == N;
+    }
+
+    /// return the offset of the first (or last) diagonal of the current M wavefront
+    /// reaching the end of the pattern, or -1 if none
+    ///
+    int32 pattern_end(const bool last) const
+    {
+        const Wavefront& m = wavefronts.get( WAVEFRONT_M, score );
+
+        const int32 lo = nvbio::max( m.lo, -M );
+        const int32 hi = nvbio::min( m.hi, N - M );
+
+        for (int32 i = 0; i <= hi - lo; ++i)
+        {
+            const int32 k = last ? hi - i : lo + i;
+            const int32 h = m.offsets[ k - m.lo ];
+            if (h >= 0 && h - k == M)
+                return h;
+        }
+        return -1;
+    }
+
+    /// compute the current M, I and D wavefronts from the previous ones
+    ///
+    void compute()
+    {
+        const int32 s = score;
+
+        wavefronts.reserve( s );
+
+        const WavefrontSet& previous = wavefronts;
+        const Wavefront& m_x  = previous.get( WAVEFRONT_M, s - penalties.x );
+        const Wavefront& m_oe = previous.get( WAVEFRONT_M, s - penalties.o - penalties.e );
+        const Wavefront& i_e  = previous.get( WAVEFRONT_I, s - penalties.e );
+        const Wavefront& d_e  = previous.get( WAVEFRONT_D, s - penalties.e );
+
+        // compute the range of diagonals reached by the new wavefronts
+        int32 lo = N + 1;
+        int32 hi = -M - 1;
+        if (m_x.is_null() == false)  { lo = nvbio::min( lo, m_x.lo );      hi = nvbio::max( hi, m_x.hi ); }
+        if (m_oe.is_null() == false) { lo = nvbio::min( lo, m_oe.lo - 1 ); hi = nvbio::max( hi, m_oe.hi + 1 ); }
+        if (i_e.is_null() == false)  { lo = nvbio::min( lo, i_e.lo - 1 );  hi = nvbio::max( hi, i_e.hi - 1 ); }
+        if (d_e.is_null() == false)  { lo = nvbio::min( lo, d_e.lo + 1 );  hi = nvbio::max( hi, d_e.hi + 1 ); }
+
+        lo = nvbio::max( lo, -M );
+        hi = nvbio::min( hi, N );
+
+        if (lo > hi)
+        {
+            for (uint32 c = 0; c < 3; ++c)
+                wavefronts.set_null( c, s );
+            return;
+        }
+
+        int32* m_s = wavefronts.allocate( WAVEFRONT_M, s, lo, hi ).offsets;
+        int32* i_s = wavefronts.allocate( WAVEFRONT_I, s, lo, hi ).offsets;
+        int32* d_s = wavefronts.allocate( WAVEFRONT_D, s, lo, hi ).offsets;
+
+        for (int32 k = lo; k <= hi; ++k)
+        {
+            // an insertion consumes a pattern symbol, coming from the diagonal k+1
+            int32 ins = nvbio::max( m_oe[k+1], i_e[k+1] );
+            if (ins - k > M)
+                ins = WAVEFRONT_NULL;
+
+            // a deletion consumes a text symbol, coming from the diagonal k-1
+            int32 del = nvbio::max( m_oe[k-1], d_e[k-1] ) + 1;
+            if (del > N)
+                del = WAVEFRONT_NULL;
+
+            // a mismatch consumes both
+            int32 mis = m_x[k] + 1;
+            if (mis > N || mis - k > M)
+                mis = WAVEFRONT_NULL;
+
+            i_s[ k - lo ] = ins;
+            d_s[ k - lo ] = del;
+            m_s[ k - lo ] = nvbio::max3( mis, ins, del );
+        }
+    }
+
+    /// extend the current M wavefront along the exact matches
+    ///
+    void extend()
+    {
+        Wavefront& m = wavefronts.get( WAVEFRONT_M, score );
+
+        for (int32 k = m.lo; k <= m.hi; ++k)
+        {
+            int32& h = m.offsets[ k - m.lo ];
+            if (h < 0)
+                continue;
+
+            const int32 v = h - k;
+            h += wavefront_lcp( text + h, pattern + v, nvbio::min( N - h, M - v ) );
+        }
+    }
+
+    const uint8*        text;
+    const uint8*        pattern;
+    int32               N;
+    int32               M;
+    WavefrontPenalties  penalties;
+    int32               score;          ///< the penalty of the current wavefronts
+    WavefrontSet        wavefronts;
+};
+
+//
+// Compute wavefronts until the alignment reaches its end, returning false if its penalty
+// would exceed a given maximum.
+//
+// \param run               an initialized wavefront run
+// \param text_end_free     whether the alignment can end anywhere along the text
+// \param end_component     the Gotoh matrix in which an anchored alignment must end
+// \param max_penalty       the maximum penalty
+//
+inline bool wavefront_run_to_end(
+    WavefrontRun&   run,
+    const bool      text_end_free,
+    const uint32    end_component,
+    const int32     max_penalty)
+{
+    while (text_end_free ? run.pattern_end( false ) < 0 : run.reached_end( end_component ) == false)
+    {
+        if (run.score >= max_penalty)
+            return false;
+
+        run.next();
+    }
+    return true;
+}
+
+//
+// Backtrack the alignment computed by a wavefront run keeping all its wavefronts, from the
+// end of the strings to their beginning.
+//
+// \param run               a wavefront run which reached the end of the strings
+// \param end_component     the Gotoh matrix in which the alignment ends
+// \param backtracer        backtracking delegate
+//
+template <typename backtracer_type>
+void wavefront_backtrace(
+    const WavefrontRun& run,
+    const uint32        end_component,
+    backtracer_type&    backtracer)
+{
+    const WavefrontSet&       wavefronts = run.wavefronts;
+    const WavefrontPenalties& p          = run.penalties;
+
+    int32  s = run.score;
+    int32  k = run.N - run.M;
+    int32  h = run.N;
+    uint32 c = end_component;
+
+    while (1)
+    {
+        if (c == WAVEFRONT_M)
+        {
+            // reconstruct the offset before the extension, following the same rules as compute()
+            int32 mis = s > 0 ? wavefronts.get( WAVEFRONT_M, s - p.x )[k] + 1 : WAVEFRONT_NULL;
+            if (mis > run.N || mis - k > run.M)
+                mis = WAVEFRONT_NULL;
+
+            const int32 ins = s > 0 ? wavefronts.get( WAVEFRONT_I, s )[k] : WAVEFRONT_NULL;
+            const int32 del = s > 0 ? wavefronts.get( WAVEFRONT_D, s )[k] : WAVEFRONT_NULL;
+
+            const int32 start = s > 0 ? nvbio::max3( mis, ins, del ) : 0;
+
+            // output the matches
+            for (; h > start; --h)
+                backtracer.push( SUBSTITUTION );
+
+            if (s == 0)
+                break;
+
+            if (start == mis)
+            {
+                backtracer.push( SUBSTITUTION );
+                --h;
+                s -= p.x;
+            }
+            else
+                c = (start == ins) ? WAVEFRONT_I : WAVEFRONT_D;
+        }
+        else if (c == WAVEFRONT_I)
+        {
+            // the gap continued from the beginning of the alignment
+            if (s == 0)
+                break;
+
+            backtracer.push( INSERTION );
+            ++k;
+
+            if (wavefronts.get( WAVEFRONT_I, s - p.e )[k] == h)
+                s -= p.e;
+            else
+            {
+                s -= p.o + p.e;
+                c  = WAVEFRONT_M;
+            }
+        }
+        else
+        {
+            // the gap continued from the beginning of the alignment
+            if (s == 0)
+                break;
+
+            backtracer.push( DELETION );
+            --k;
+            --h;
+
+            if (wavefronts.get( WAVEFRONT_D, s - p.e )[k] == h)
+                s -= p.e;
+            else
+            {
+                s -= p.o + p.e;
+                c  = WAVEFRONT_M;
+            }
+        }
+    }
+}
+
+///
+/// A BiWFA breakpoint, i.e. a cell where a forward and a reverse wavefront overlap
+///
+struct WavefrontBreakpoint
+{
+    int32  penalty;         ///< the penalty of the whole alignment
+    int32  forward_score;   ///< the penalty of the forward wavefront
+    int32  reverse_score;   ///< the penalty of the reverse wavefront
+    int32  k;               ///< the diagonal
+    int32  offset;          ///< the text offset
+    uint32 component;       ///< the Gotoh matrix
+};
+
+//
+// Check whether the forward wavefronts of penalty sf overlap the reverse wavefronts of
+// penalty sr, updating the best breakpoint found so far.
+// The reverse wavefronts align the reversed strings, so that their k-th diagonal corresponds
+// to the forward diagonal N - M - k, and their offset h to the forward offset N - h; when the
+// two meet in the middle of a gap, the gap is opened only once.
+//
+inline void wavefront_overlap(
+    const WavefrontRun&     fwd,
+    const int32             sf,
+    const WavefrontRun&     rev,
+    const int32             sr,
+    WavefrontBreakpoint&    bp)
+{
+    const int32 N     = fwd.N;
+    const int32 k_end = fwd.N - fwd.M;
+
+    for (uint32 c = 0; c < 3; ++c)
+    {
+        const int32 penalty = sf + sr - (c == WAVEFRONT_M ? 0 : fwd.penalties.o);
+        if (penalty >= bp.penalty)
+            continue;
+
+        const Wavefront& f = fwd.wavefronts.get( c, sf );
+        const Wavefront& r = rev.wavefronts.get( c, sr );
+        if (f.is_null() || r.is_null())
+            continue;
+
+        const int32 lo = nvbio::max( f.lo, k_end - r.hi );
+        const int32 hi = nvbio::min( f.hi, k_end - r.lo );
+
+        for (int32 k = lo; k <= hi; ++k)
+        {
+            const int32 h_f = f.offsets[ k - f.lo ];
+            const int32 h_r = r.offsets[ k_end - k - r.lo ];
+
+            if (h_f >= 0 && h_r >= 0 && h_f + h_r >= N)
+            {
+                bp.penalty       = penalty;
+                bp.forward_score = sf;
+                bp.reverse_score = sr;
+                bp.k             = k;
+                bp.offset        = h_f;
+                bp.component     = c;
+                break;
+            }
+        }
+    }
+}
+
+//
+// Find the optimal BiWFA breakpoint, computing the forward and reverse wavefronts in turn
+// and checking each new wavefront against the window of opposite ones which could overlap it.
+// The search stops when no later overlap could improve on the best one, or when the
+// alignment is known to cost more than a given maximum, in which case false is returned.
+//
+// \param fwd           the forward run, initialized
+// \param rev           the reverse run, initialized
+// \param max_penalty   the maximum penalty
+// \param bp            the output breakpoint
+//
+inline bool wavefront_breakpoint(
+    WavefrontRun&           fwd,
+    WavefrontRun&           rev,
+    const int32             max_penalty,
+    WavefrontBreakpoint&    bp)
+{
+    const int32 o      = fwd.penalties.o;
+    const int32 window = fwd.penalties.window();
+
+    bp.penalty = WAVEFRONT_MAX_PENALTY;
+
+    wavefront_overlap( fwd, 0, rev, 0, bp );
+
+    for (uint32 dir = 0; true; dir ^= 1u)
+    {
+        // the smallest penalty any later overlap could have
+        if (fwd.score + rev.score + 2 - window - o >= bp.penalty)
+            break;
+
+        // all overlaps within the maximum penalty would have been found by now
+        if (nvbio::min( fwd.score, rev.score ) > max_penalty + o)
+            break;
+
+        if (dir == 0u)
+        {
+            fwd.next();
+            for (int32 sr = nvbio::max( rev.score - window + 1, 0 ); sr <= rev.score; ++sr)
+                wavefront_overlap( fwd, fwd.score, rev, sr, bp );
+        }
+        else
+        {
+            rev.next();
+            for (int32 sf = nvbio::max( fwd.score - window + 1, 0 ); sf <= fwd.score; ++sf)
+                wavefront_overlap( fwd, sf, rev, rev.score, bp );
+        }
+    }
+    return bp.penalty <= max_penalty;
+}
+
+///
+/// The temporary storage of a wavefront alignment: a copy of the strings and their reverse,
+/// and the wavefront runs
+///
+struct WavefrontWorkspace
+{
+    /// copy the strings to be aligned
+    ///
+    template <typename pattern_string, typename text_string>
+    void load(const pattern_string pattern, const text_string text)
+    {
+        M = pattern.length();
+        N = text.length();
+
+        symbols.resize( 2u * (M + N) );
+        text_symbols     = &symbols[0];
+        pattern_symbols  = text_symbols    + N;
+        rtext_symbols    = pattern_symbols + M;
+        rpattern_symbols = rtext_symbols   + N;
+
+        uint32 bits = 0u;
+        for (int32 i = 0; i < N; ++i)
+        {
+            const uint8 c = uint8( text[i] );
+            text_symbols[i] = rtext_symbols[ N-1 - i ] = c;
+            bits |= c;
+        }
+        for (int32 j = 0; j < M; ++j)
+        {
+            const uint8 c = uint8( pattern[j] );
+            pattern_symbols[j] = rpattern_symbols[ M-1 - j ] = c;
+            bits |= c;
+        }
+        symbol_bits = bits;
+    }
+
+    std::vector<uint8>  symbols;
+    uint8*              text_symbols;
+    uint8*              pattern_symbols;
+    uint8*              rtext_symbols;
+    uint8*              rpattern_symbols;
+    uint32              symbol_bits;
+    int32               N;
+    int32               M;
+
+    WavefrontRun        forward;
+    WavefrontRun        reverse;
+    WavefrontRun        full;
+};
+
+//
+// Align the text window [h0,h1) to the pattern window [v0,v1), keeping all the wavefronts,
+// and backtrack the alignment, returning its penalty
+//
+template <typename backtracer_type>
+int32 wavefront_full_align(
+    WavefrontWorkspace&         ws,
+    const WavefrontPenalties&   penalties,
+    const int32 h0, const int32 h1,
+    const int32 v0, const int32 v1,
+    const uint32                begin_component,
+    const uint32                end_component,
+    const int32                 max_penalty,
+    backtracer_type&            backtracer)
+{
+    ws.full.init( ws.text_symbols + h0, h1 - h0, ws.pattern_symbols + v0, v1 - v0, penalties, begin_component, false, 0u );
+
+    if (wavefront_run_to_end( ws.full, false, end_component, max_penalty ) == false)
+        return -1;
+
+    wavefront_backtrace( ws.full, end_component, backtracer );
+    return ws.full.score;
+}
+
+//
+// Align the text window [h0,h1) to the pattern window [v0,v1) with BiWFA and backtrack the
+// alignment, returning its penalty (or -1 if it exceeds max_penalty): the forward and reverse
+// wavefronts are computed, keeping only a sliding window of each, until they meet at an optimal
+// breakpoint, and the two halves of the alignment are then aligned recursively.
+// The halves starting or ending at a breakpoint in the middle of a gap start or end in the
+// corresponding Gotoh matrix, so that the gap is opened only once.
+// The penalty of each half is only estimated by the breakpoint (with gap-affine penalties the
+// furthest reaching offsets don't bound the cost of the cells they pass over), so the estimate
+// just selects the subproblems to solve directly, while max_penalty is kept as a hard limit.
+//
+template <typename backtracer_type>
+int32 wavefront_bidirectional_align(
+    WavefrontWorkspace&         ws,
+    const WavefrontPenalties&   penalties,
+    const int32 h0, const int32 h1,
+    const int32 v0, const int32 v1,
+    const uint32                begin_component,
+    const uint32                end_component,
+    const int32                 estimated_penalty,
+    const int32                 max_penalty,
+    backtracer_type&            backtracer)
+{
+    // cheap subproblems are solved directly
+    if (estimated_penalty <= BIWFA_FULL_PENALTY)
+        return wavefront_full_align( ws, penalties, h0, h1, v0, v1, begin_component, end_component, max_penalty, backtracer );
+
+    const int32 N = h1 - h0;
+    const int32 M = v1 - v0;
+    const uint32 window = uint32( penalties.window() );
+
+    ws.forward.init( ws.text_symbols  + h0,         N, ws.pattern_symbols  + v0,         M, penalties, begin_component, false, window );
+    ws.reverse.init( ws.rtext_symbols + ws.N - h1,  N, ws.rpattern_symbols + ws.M - v1,  M, penalties, end_component,   false, window );
+
+    WavefrontBreakpoint bp;
+    if (wavefront_breakpoint( ws.forward, ws.reverse, max_penalty, bp ) == false)
+        return -1;
+
+    const int32 h = bp.offset;
+    const int32 v = bp.offset - bp.k;
+
+    // solve cheap subproblems, and those the breakpoint doesn't split, directly
+    if (bp.penalty <= BIWFA_FULL_PENALTY ||
+        (h == 0 && v == 0) ||
+        (h == N && v == M))
+        return wavefront_full_align( ws, penalties, h0, h1, v0, v1, begin_component, end_component, max_penalty, backtracer );
+
+    const int32 gap_open = bp.component == WAVEFRONT_M ? 0 : penalties.o;
+
+    // the backtracer expects the alignment from its end: align the second half first
+    const int32 right = wavefront_bidirectional_align( ws, penalties, h0 + h, h1, v0 + v, v1, bp.component, end_component, bp.reverse_score - gap_open, max_penalty, backtracer );
+    if (right < 0)
+        return -1;
+
+    const int32 left = wavefront_bidirectional_align( ws, penalties, h0, h0 + h, v0, v0 + v, begin_component, bp.component, bp.forward_score, max_penalty - right, backtracer );
+    if (left < 0)
+        return -1;
+
+    return left + right;
+}
+
+//
+// Compute the score of the optimal wavefront alignment of a pattern and a text, reporting
+// its end(s) to a sink; semi-global alignments report all the optimal ends.
+//
+// \return  true iff an alignment reaching min_score was found
+//
+template <AlignmentType TYPE, typename sink_type>
+bool wavefront_alignment_score(
+    WavefrontWorkspace&         ws,
+    const WavefrontPenalties&   penalties,
+    const int32                 min_score,
+    sink_type&                  sink)
+{
+    const int32 M = ws.M;
+    const int32 N = ws.N;
+
+    const int32 max_penalty = penalties.max_penalty( min_score, M, TYPE == GLOBAL ? N : 0 );
+    if (max_penalty < 0)
+        return false;
+
+    ws.forward.init( ws.text_symbols, N, ws.pattern_symbols, M, penalties, WAVEFRONT_M, TYPE == SEMI_GLOBAL, uint32( penalties.window() ) );
+
+    if (wavefront_run_to_end( ws.forward, TYPE == SEMI_GLOBAL, WAVEFRONT_M, max_penalty ) == false)
+        return false;
+
+    const WavefrontRun& run = ws.forward;
+
+    if (TYPE == GLOBAL)
+        sink.report( penalties.score( run.score, M, N ), make_uint2( N, M ) );
+    else
+    {
+        // report all the optimal ends along the text, in order
+        const int32 score = penalties.score( run.score, M, 0 );
+
+        const Wavefront& m = run.wavefronts.get( WAVEFRONT_M, run.score );
+        for (int32 k = nvbio::max( m.lo, -M ); k <= nvbio::min( m.hi, N - M ); ++k)
+        {
+            const int32 h = m.offsets[ k - m.lo ];
+            if (h >= 0 && h - k == M)
+                sink.report( score, make_uint2( h, M ) );
+        }
+    }
+    return true;
+}
+
+//
+// Compute and backtrack the optimal wavefront alignment of a pattern and a text.
+// Semi-global alignments are reduced to global ones: a first pass finds the last optimal end
+// along the text, as the DP aligners would, and a second pass on the reversed strings finds
+// a matching beginning.
+//
+template <AlignmentType TYPE, typename backtracer_type>
+Alignment<int32> wavefront_alignment_traceback(
+    WavefrontWorkspace&         ws,
+    const WavefrontPenalties&   penalties,
+    const WavefrontMemoryMode   memory_mode,
+    const int32                 min_score,
+    backtracer_type&            backtracer)
+{
+    const int32 M = ws.M;
+    const int32 N = ws.N;
+
+    const Alignment<int32> no_alignment( Field_traits<int32>::min(), make_uint2( uint32(-1), uint32(-1) ), make_uint2( uint32(-1), uint32(-1) ) );
+
+    int32 max_penalty = penalties.max_penalty( min_score, M, TYPE == GLOBAL ? N : 0 );
+    if (max_penalty < 0)
+        return no_alignment;
+
+    int32 text_begin = 0;
+    int32 text_end   = N;
+
+    if (TYPE == SEMI_GLOBAL)
+    {
+        const uint32 window = uint32( penalties.window() );
+
+        ws.forward.init( ws.text_symbols, N, ws.pattern_symbols, M, penalties, WAVEFRONT_M, true, window );
+        if (wavefront_run_to_end( ws.forward, true, WAVEFRONT_M, max_penalty ) == false)
+            return no_alignment;
+
+        max_penalty = ws.forward.score;
+        text_end    = ws.forward.pattern_end( true );
+
+        ws.reverse.init( ws.rtext_symbols + N - text_end, text_end, ws.rpattern_symbols, M, penalties, WAVEFRONT_M, false, window );
+        wavefront_run_to_end( ws.reverse, true, WAVEFRONT_M, max_penalty );
+
+        text_begin = text_end - ws.reverse.pattern_end( false );
+    }
+
+    // clip the end of the pattern (a no-op, as the whole pattern is aligned)
+    backtracer.clip( 0u );
+
+    const int32 penalty = memory_mode == BIDIRECTIONAL_WAVEFRONTS ?
+        wavefront_bidirectional_align( ws, penalties, text_begin, text_end, 0, M, WAVEFRONT_M, WAVEFRONT_M, max_penalty, max_penalty, backtracer ) :
+        wavefront_full_align(          ws, penalties, text_begin, text_end, 0, M, WAVEFRONT_M, WAVEFRONT_M, max_penalty, backtracer );
+
+    if (penalty < 0)
+        return no_alignment;
+
+    // clip the beginning of the pattern (again a no-op)
+    backtracer.clip( 0u );
+
+    return Alignment<int32>(
+        penalties.score( penalty, M, TYPE == GLOBAL ? N : 0 ),
+        make_uint2( text_begin, 0u ),
+        make_uint2( text_end,   M ) );
+}
+
+//
+// Backtrack an alignment with the Gotoh fallback of the WavefrontAligner, allocating
+// the checkpoint storage it needs
+//
+template <
+    uint32          CHECKPOINTS,
+    AlignmentType   TYPE,
+    typename        scoring_type,
+    typename        pattern_string,
+    typename        qual_string,
+    typename        text_string,
+    typename        backtracer_type>
+Alignment<int32> wavefront_fallback_traceback(
+    const WavefrontAligner<TYPE,scoring_type>&  aligner,
+    const pattern_string                        pattern,
+    const qual_string                           quals,
+    const text_string                           text,
+    const int32                                 min_score,
+    backtracer_type&                            backtracer)
+{
+    typedef GotohAligner<TYPE,scoring_type>                         fallback_aligner_type;
+    typedef typename checkpoint_storage_type<fallback_aligner_type>::type checkpoint_type;
+    typedef typename column_storage_type<fallback_aligner_type>::type     cell_type;
+
+    const uint32 BITS              = direction_vector_traits<fallback_aligner_type>::BITS;
+    const uint32 ELEMENTS_PER_WORD = 32 / BITS;
+
+    const uint32 N             = text.length();
+    const uint32 n_checkpoints = (pattern.length() + CHECKPOINTS-1) / CHECKPOINTS;
+
+    std::vector<checkpoint_type> checkpoints( n_checkpoints * N + 1u );
+    std::vector<uint32>          submatrix_storage( (N * CHECKPOINTS + ELEMENTS_PER_WORD-1) / ELEMENTS_PER_WORD + 1u );
+    std::vector<cell_type>       column( N + 1u );
+
+    PackedStream<uint32*,uint8,BITS,false> submatrix( &submatrix_storage[0] );
+
+    return alignment_traceback<CHECKPOINTS>(
+        fallback_aligner_type( aligner.scheme ),
+        pattern,
+        quals,
+        text,
+        min_score,
+        backtracer,
+        &checkpoints[0],
+        submatrix,
+        &column[0] );
+}
+
+///@} // end of private group
+
+//
+// Calculate the alignment score between a pattern and a text with the wavefront algorithm,
+// falling back to the Gotoh aligner for unsupported configurations and empty strings
+//
+template <
+    AlignmentType   TYPE,
+    typename        scoring_type,
+    typename        pattern_string,
+    typename        qual_string,
+    typename        text_string,
+    typename        column_type>
+struct alignment_score_dispatch<
+    WavefrontAligner<TYPE,scoring_type>,
+    pattern_string,
+    qual_string,
+    text_string,
+    column_type>
+{
+    typedef WavefrontAligner<TYPE,scoring_type> aligner_type;
+
+    /// dispatch scoring across the whole pattern
+    ///
+    /// \param aligner      scoring scheme
+    /// \param pattern      pattern string (horizontal)
+    /// \param quals        pattern qualities
+    /// \param text         text string (vertical)
+    /// \param min_score    minimum score
+    /// \param sink         output alignment sink
+    /// \param column       temporary column storage, used by the Gotoh fallback only
+    ///
+    /// \return             true iff the minimum score was reached
+    ///
+    template <typename sink_type>
+    static bool dispatch(
+        const aligner_type      aligner,
+        const pattern_string    pattern,
+        const qual_string       quals,
+        const text_string       text,
+        const  int32            min_score,
+              sink_type&        sink,
+              column_type       column)
+    {
+        if (pattern.length() && text.length())
+        {
+            WavefrontWorkspace workspace;
+            workspace.load( pattern, text );
+
+            WavefrontPenalties penalties;
+            if (wavefront_penalties<TYPE>( aligner.scheme, quals, pattern.length(), workspace.symbol_bits, penalties ))
+                return wavefront_alignment_score<TYPE>( workspace, penalties, min_score, sink );
+        }
+
+        typedef GotohAligner<TYPE,scoring_type> fallback_aligner_type;
+        typedef alignment_score_dispatch<fallback_aligner_type,pattern_string,qual_string,text_string,column_type> fallback_dispatcher;
+
+        return fallback_dispatcher::dispatch(
+            fallback_aligner_type( aligner.scheme ),
+            pattern,
+            quals,
+            text,
+            min_score,
+            sink,
+            column );
+    }
+};
+
+} // namespace priv
+
+//
+// Backtrace an optimal alignment with the wavefront algorithm, in either of the memory modes
+// of the aligner: the checkpoint, submatrix and column storage are not used, as all temporary
+// storage is allocated internally (see needs_checkpoint_storage).
+// Unsupported configurations fall back to the Gotoh aligner.
+//
+// \tparam CHECKPOINTS         number of DP rows between each checkpoint, used by the fallback
+//
+template <
+    uint32          CHECKPOINTS,
+    AlignmentType   TYPE,
+    typename        scoring_type,
+    typename        pattern_string,
+    typename        qual_string,
+    typename        text_string,
+    typename        backtracer_type,
+    typename        checkpoints_type,
+    typename        submatrix_type,
+    typename        column_type>
+Alignment<int32> alignment_traceback(
+    const WavefrontAligner<TYPE,scoring_type>   aligner,
+    const pattern_string                        pattern,
+    const qual_string                           quals,
+    const text_string                           text,
+    const int32                                 min_score,
+    backtracer_type&                            backtracer,
+    checkpoints_type                            checkpoints,
+    submatrix_type                              submatrix,
+    column_type                                 column)
+{
+    if (pattern.length() && text.length())
+    {
+        priv::WavefrontWorkspace workspace;
+        workspace.load( pattern, text );
+
+        priv::WavefrontPenalties penalties;
+        if (priv::wavefront_penalties<TYPE>( aligner.scheme, quals, pattern.length(), workspace.symbol_bits, penalties ))
+            return priv::wavefront_alignment_traceback<TYPE>( workspace, penalties, aligner.memory_mode, min_score, backtracer );
+    }
+    return priv::wavefront_fallback_traceback<CHECKPOINTS>( aligner, pattern, quals, text, min_score, backtracer );
+}
+
+//
+// Backtrace an optimal alignment with the wavefront algorithm: the two-level checkpointing
+// variant of the above, which behaves exactly the same way.
+//
+template <
+    uint32          CHECKPOINTS,
+    AlignmentType   TYPE,
+    typename        scoring_type,
+    typename        pattern_string,
+    typename        qual_string,
+    typename        text_string,
+    typename        backtracer_type,
+    typename        checkpoints_type,
+    typename        submatrix_type,
+    typename        column_type>
+Alignment<int32> alignment_traceback(
+    const WavefrontAligner<TYPE,scoring_type>   aligner,
+    const pattern_string                        pattern,
+    const qual_string                           quals,
+    const text_string                           text,
+    const int32                                 min_score,
+    backtracer_type&                            backtracer,
+    const uint32                                stride,
+    checkpoints_type                            coarse_checkpoints,
+    checkpoints_type                            fine_checkpoints,
+    submatrix_type                              submatrix,
+    column_type                                 column)
+{
+    return alignment_traceback<CHECKPOINTS>( aligner, pattern, quals, text, min_score, backtracer, coarse_checkpoints, submatrix, column );
+}
+
+} // namespace aln
+} // namespace nvbio
@@ -0,0 +1,307 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/numbers.h>
+
+#if defined(PLATFORM_X86) && !defined(NVBIO_DEVICE_COMPILATION)
+  #if defined(__AVX512BW__)
+    #define NVBIO_HOST_SIMD_AVX512
+    #include <immintrin.h>
+  #elif defined(__AVX2__)
+    #define NVBIO_HOST_SIMD_AVX2
+    #include <immintrin.h>
+  #elif defined(__SSE4_1__)
+    #define NVBIO_HOST_SIMD_SSE41
+    #include <smmintrin.h>
+  #endif
+#endif
+
+namespace nvbio {
+
+///
+///@addtogroup Basic
+///@{
+///
+
+///
+///@defgroup HostSIMD Host SIMD Vectors
+/// Thin wrappers around the widest vector instruction set the host compiler
+/// has been asked to target (AVX-512BW, AVX2 or SSE4.1), exposing the few
+/// saturating signed integer operations needed by the host DP kernels.
+/// If none of these instruction sets is enabled, a portable 16-byte emulation
+/// is used instead, so that client code never needs to be specialized.
+///@{
+///
+
+#if defined(NVBIO_HOST_SIMD_AVX512)
+static const uint32 HOST_SIMD_BYTES = 64u;  ///< the host vector width, in bytes
+#elif defined(NVBIO_HOST_SIMD_AVX2)
+static const uint32 HOST_SIMD_BYTES = 32u;  ///< the host vector width, in bytes
+#else
+static const uint32 HOST_SIMD_BYTES = 16u;  ///< the host vector width, in bytes
+#endif
+
+/// return the name of the instruction set used by host_simd
+///
+inline const char* host_simd_isa()
+{
+#if defined(NVBIO_HOST_SIMD_AVX512)
+    return "avx512bw";
+#elif defined(NVBIO_HOST_SIMD_AVX2)
+    return "avx2";
+#elif defined(NVBIO_HOST_SIMD_SSE41)
+    return "sse4.1";
+#else
+    return "none";
+#endif
+}
+
+///
+/// A host vector of signed integers of type T, with HOST_SIMD_BYTES / sizeof(T) lanes.
+/// Masks are represented as vectors whose lanes are either all zeros or all ones.
+/// All loads and stores are unaligned.
+///
+/// Specializations are provided for int8 and int16, and expose the following interface:
+///
+/// \code
+/// template <typename T>
+/// struct host_simd
+/// {
+///     static const uint32 WIDTH;                          // number of lanes
+///     typedef ... type;                                   // vector type
+///
+///     static type zero();
+///     static type set1(const T v);
+///     static type load(const T* p);
+///     static void store(T* p, const type v);
+///     static type adds(const type a, const type b);       // saturating addition
+///     static type subs(const type a, const type b);       // saturating subtraction
+///     static type max(const type a, const type b);
+///     static type min(const type a, const type b);
+///     static type cmpgt(const type a, const type b);      // a > b mask
+///     static type cmpeq(const type a, const type b);      // a == b mask
+///     static type and_op(const type a, const type b);
+///     static type or_op(const type a, const type b);
+///     static type blend(const type a, const type b, const type mask);  // mask ? b : a
+///     static bool any(const type mask);
+///     static type shift_in(const type a, const T x);      // move each lane up by one, inserting x in lane 0
+/// };
+/// \endcode
+///
+template <typename T> struct host_simd {};
+
+#if defined(NVBIO_HOST_SIMD_AVX512)
+
+template <>
+struct host_simd<int8>
+{
+    static const uint32 WIDTH = HOST_SIMD_BYTES;
+    typedef __m512i type;
+
+    static NVBIO_FORCEINLINE type zero()                                            { return _mm512_setzero_si512(); }
+    static NVBIO_FORCEINLINE type set1(const int8 v)                                { return _mm512_set1_epi8( v ); }
+    static NVBIO_FORCEINLINE type load(const int8* p)                               { return _mm512_loadu_si512( (const void*)p ); }
+    static NVBIO_FORCEINLINE void store(int8* p, const type v)                      { _mm512_storeu_si512( (void*)p, v ); }
+    static NVBIO_FORCEINLINE type adds(const type a, const type b)                  { return _mm512_adds_epi8( a, b ); }
+    static NVBIO_FORCEINLINE type subs(const type a, const type b)                  { return _mm512_subs_epi8( a, b ); }
+    static NVBIO_FORCEINLINE type max(const type a, const type b)                   { return _mm512_max_epi8( a, b ); }
+    static NVBIO_FORCEINLINE type min(const type a, const type b)                   { return _mm512_min_epi8( a, b ); }
+    static NVBIO_FORCEINLINE type cmpgt(const type a, const type b)                 { return _mm512_movm_epi8( _mm512_cmpgt_epi8_mask( a, b ) ); }
+    static NVBIO_FORCEINLINE type cmpeq(const type a, const type b)                 { return _mm512_movm_epi8( _mm512_cmpeq_epi8_mask( a, b ) ); }
+    static NVBIO_FORCEINLINE type and_op(const type a, const type b)                { return _mm512_and_si512( a, b ); }
+    static NVBIO_FORCEINLINE type or_op(const type a, const type b)                 { return _mm512_or_si512( a, b ); }
+    static NVBIO_FORCEINLINE type blend(const type a, const type b, const type m)   { return _mm512_mask_blend_epi8( _mm512_movepi8_mask( m ), a, b ); }
+    static NVBIO_FORCEINLINE bool any(const type m)                                 { return _mm512_movepi8_mask( m ) != 0; }
+    static NVBIO_FORCEINLINE type shift_in(const type a, const int8 x)              { return _mm512_mask_set1_epi8( _mm512_alignr_epi8( a, _mm512_alignr_epi64( a, _mm512_setzero_si512(), 6 ), 15 ), 1u, x ); }
+};
+
+template <>
+struct host_simd<int16>
+{
+    static const uint32 WIDTH = HOST_SIMD_BYTES / 2u;
+    typedef __m512i type;
+
+    static NVBIO_FORCEINLINE type zero()                                            { return _mm512_setzero_si512(); }
+    static NVBIO_FORCEINLINE type set1(const int16 v)                               { return _mm512_set1_epi16( v ); }
+    static NVBIO_FORCEINLINE type load(const int16* p)                              { return _mm512_loadu_si512( (const void*)p ); }
+    static NVBIO_FORCEINLINE void store(int16* p, const type v)                     { _mm512_storeu_si512( (void*)p, v ); }
+    static NVBIO_FORCEINLINE type adds(const type a, const type b)                  { return _mm512_adds_epi16( a, b ); }
+    static NVBIO_FORCEINLINE type subs(const type a, const type b)                  { return _mm512_subs_epi16( a, b ); }
+    static NVBIO_FORCEINLINE type max(const type a, const type b)                   { return _mm512_max_epi16( a, b ); }
+    static NVBIO_FORCEINLINE type min(const type a, const type b)                   { return _mm512_min_epi16( a, b ); }
+    static NVBIO_FORCEINLINE type cmpgt(const type a, const type b)                 { return _mm512_movm_epi16( _mm512_cmpgt_epi16_mask( a, b ) ); }
+    static NVBIO_FORCEINLINE type cmpeq(const type a, const type b)                 { return _mm512_movm_epi16( _mm512_cmpeq_epi16_mask( a, b ) ); }
+    static NVBIO_FORCEINLINE type and_op(const type a, const type b)                { return _mm512_and_si512( a, b ); }
+    static NVBIO_FORCEINLINE type or_op(const type a, const type b)                 { return _mm512_or_si512( a, b ); }
+    static NVBIO_FORCEINLINE type blend(const type a, const type b, const type m)   { return _mm512_mask_blend_epi16( _mm512_movepi16_mask( m ), a, b ); }
+    static NVBIO_FORCEINLINE bool any(const type m)                                 { return _mm512_movepi16_mask( m ) != 0; }
+    static NVBIO_FORCEINLINE type shift_in(const type a, const int16 x)             { return _mm512_mask_set1_epi16( _mm512_alignr_epi8( a, _mm512_alignr_epi64( a, _mm512_setzero_si512(), 6 ), 14 ), 1u, x ); }
+};
+
+#elif defined(NVBIO_HOST_SIMD_AVX2)
+
+template <>
+struct host_simd<int8>
+{
+    static const uint32 WIDTH = HOST_SIMD_BYTES;
+    typedef __m256i type;
+
+    static NVBIO_FORCEINLINE type zero()                                            { return _mm256_setzero_si256(); }
+    static NVBIO_FORCEINLINE type set1(const int8 v)                                { return _mm256_set1_epi8( v ); }
+    static NVBIO_FORCEINLINE type load(const int8* p)                               { return _mm256_loadu_si256( (const __m256i*)p ); }
+    static NVBIO_FORCEINLINE void store(int8* p, const type v)                      { _mm256_storeu_si256( (__m256i*)p, v ); }
+    static NVBIO_FORCEINLINE type adds(const type a, const type b)                  { return _mm256_adds_epi8( a, b ); }
+    static NVBIO_FORCEINLINE type subs(const type a, const type b)                  { return _mm256_subs_epi8( a, b ); }
+    static NVBIO_FORCEINLINE type max(const type a, const type b)                   { return _mm256_max_epi8( a, b ); }
+    static NVBIO_FORCEINLINE type min(const type a, const type b)                   { return _mm256_min_epi8( a, b ); }
+    static NVBIO_FORCEINLINE type cmpgt(const type a, const type b)                 { return _mm256_cmpgt_epi8( a, b ); }
+    static NVBIO_FORCEINLINE type cmpeq(const type a, const type b)                 { return _mm256_cmpeq_epi8( a, b ); }
+    static NVBIO_FORCEINLINE type and_op(const type a, const type b)                { return _mm256_and_si256( a, b ); }
+    static NVBIO_FORCEINLINE type or_op(const type a, const type b)                 { return _mm256_or_si256( a, b ); }
+    static NVBIO_FORCEINLINE type blend(const type a, const type b, const type m)   { return _mm256_blendv_epi8( a, b, m ); }
+    static NVBIO_FORCEINLINE bool any(const type m)                                 { return _mm256_movemask_epi8( m ) != 0; }
+    static NVBIO_FORCEINLINE type shift_in(const type a, const int8 x)              { return _mm256_insert_epi8( _mm256_alignr_epi8( a, _mm256_permute2x128_si256( a, a, 0x08 ), 15 ), x, 0 ); }
+};
+
+template <>
+struct host_simd<int16>
+{
+    static const uint32 WIDTH = HOST_SIMD_BYTES / 2u;
+    typedef __m256i type;
+
+    static NVBIO_FORCEINLINE type zero()                                            { return _mm256_setzero_si256(); }
+    static NVBIO_FORCEINLINE type set1(const int16 v)                               { return _mm256_set1_epi16( v ); }
+    static NVBIO_FORCEINLINE type load(const int16* p)                              { return _mm256_loadu_si256( (const __m256i*)p ); }
+    static NVBIO_FORCEINLINE void store(int16* p, const type v)                     { _mm256_storeu_si256( (__m256i*)p, v ); }
+    static NVBIO_FORCEINLINE type adds(const type a, const type b)                  { return _mm256_adds_epi16( a, b ); }
+    static NVBIO_FORCEINLINE type subs(const type a, const type b)                  { return _mm256_subs_epi16( a, b ); }
+    static NVBIO_FORCEINLINE type max(const type a, const type b)                   { return _mm256_max_epi16( a, b ); }
+    static NVBIO_FORCEINLINE type min(const type a, const type b)                   { return _mm256_min_epi16( a, b ); }
+    static NVBIO_FORCEINLINE type cmpgt(const type a, const type b)                 { return _mm256_cmpgt_epi16( a, b ); }
+    static NVBIO_FORCEINLINE type cmpeq(const type a, const type b)                 { return _mm256_cmpeq_epi16( a, b ); }
+    static NVBIO_FORCEINLINE type and_op(const type a, const type b)                { return _mm256_and_si256( a, b ); }
+    static NVBIO_FORCEINLINE type or_op(const type a, const type b)                 { return _mm256_or_si256( a, b ); }
+    static NVBIO_FORCEINLINE type blend(const type a, const type b, const type m)   { return _mm256_blendv_epi8( a, b, m ); }
+    static NVBIO_FORCEINLINE bool any(const type m)                                 { return _mm256_movemask_epi8( m ) != 0; }
+    static NVBIO_FORCEINLINE type shift_in(const type a, const int16 x)             { return _mm256_insert_epi16( _mm256_alignr_epi8( a, _mm256_permute2x128_si256( a, a, 0x08 ), 14 ), x, 0 ); }
+};
+
+#elif defined(NVBIO_HOST_SIMD_SSE41)
+
+template <>
+struct host_simd<int8>
+{
+    static const uint32 WIDTH = HOST_SIMD_BYTES;
+    typedef __m128i type;
+
+    static NVBIO_FORCEINLINE type zero()                                            { return _mm_setzero_si128(); }
+    static NVBIO_FORCEINLINE type set1(const int8 v)                                { return _mm_set1_epi8( v ); }
+    static NVBIO_FORCEINLINE type load(const int8* p)                               { return _mm_loadu_si128( (const __m128i*)p ); }
+    static NVBIO_FORCEINLINE void store(int8* p, const type v)                      { _mm_storeu_si128( (__m128i*)p, v ); }
+    static NVBIO_FORCEINLINE type adds(const type a, const type b)                  { return _mm_adds_epi8( a, b ); }
+    static NVBIO_FORCEINLINE type subs(const type a, const type b)                  { return _mm_subs_epi8( a, b ); }
+    static NVBIO_FORCEINLINE type max(const type a, const type b)                   { return _mm_max_epi8( a, b ); }
+    static NVBIO_FORCEINLINE type min(const type a, const type b)                   { return _mm_min_epi8( a, b ); }
+    static NVBIO_FORCEINLINE type cmpgt(const type a, const type b)                 { return _mm_cmpgt_epi8( a, b ); }
+    static NVBIO_FORCEINLINE type cmpeq(const type a, const type b)                 { return _mm_cmpeq_epi8( a, b ); }
+    static NVBIO_FORCEINLINE type and_op(const type a, const type b)                { return _mm_and_si128( a, b ); }
+    static NVBIO_FORCEINLINE type or_op(const type a, const type b)                 { return _mm_or_si128( a, b ); }
+    static NVBIO_FORCEINLINE type blend(const type a, const type b, const type m)   { return _mm_blendv_epi8( a, b, m ); }
+    static NVBIO_FORCEINLINE bool any(const type m)                                 { return _mm_movemask_epi8( m ) != 0; }
+    static NVBIO_FORCEINLINE type shift_in(const type a, const int8 x)              { return _mm_insert_epi8( _mm_slli_si128( a, 1 ), x, 0 ); }
+};
+
+template <>
+struct host_simd<int16>
+{
+    static const uint32 WIDTH = HOST_SIMD_BYTES / 2u;
+    typedef __m128i type;
+
+    static NVBIO_FORCEINLINE type zero()                                            { return _mm_setzero_si128(); }
+    static NVBIO_FORCEINLINE type set1(const int16 v)                               { return _mm_set1_epi16( v ); }
+    static NVBIO_FORCEINLINE type load(const int16* p)                              { return _mm_loadu_si128( (const __m128i*)p ); }
+    static NVBIO_FORCEINLINE void store(int16* p, const type v)                     { _mm_storeu_si128( (__m128i*)p, v ); }
+    static NVBIO_FORCEINLINE type adds(const type a, const type b)                  { return _mm_adds_epi16( a, b ); }
+    static NVBIO_FORCEINLINE type subs(const type a, const type b)                  { return _mm_subs_epi16( a, b ); }
+    static NVBIO_FORCEINLINE type max(const type a, const type b)                   { return _mm_max_epi16( a, b ); }
+    static NVBIO_FORCEINLINE type min(const type a, const type b)                   { return _mm_min_epi16( a, b ); }
+    static NVBIO_FORCEINLINE type cmpgt(const type a, const type b)                 { return _mm_cmpgt_epi16( a, b ); }
+    static NVBIO_FORCEINLINE type cmpeq(const type a, const type b)                 { return _mm_cmpeq_epi16( a, b ); }
+    static NVBIO_FORCEINLINE type and_op(const type a, const type b)                { return _mm_and_si128( a, b ); }
+    static NVBIO_FORCEINLINE type or_op(const type a, const type b)                 { return _mm_or_si128( a, b ); }
+    static NVBIO_FORCEINLINE type blend(const type a, const type b, const type m)   { return _mm_blendv_epi8( a, b, m ); }
+    static NVBIO_FORCEINLINE bool any(const type m)                                 { return _mm_movemask_epi8( m ) != 0; }
+    static NVBIO_FORCEINLINE type shift_in(const type a, const int16 x)             { return _mm_insert_epi16( _mm_slli_si128( a, 2 ), x, 0 ); }
+};
+
+#else
+
+///
+/// A portable emulation of a HOST_SIMD_BYTES-wide vector, used when no
+/// vector instruction set is available to the host compiler.
+///
+template <typename T>
+struct host_simd_emulation
+{
+    static const uint32 WIDTH = HOST_SIMD_BYTES / sizeof(T);
+
+    struct type { T v[WIDTH]; };
+
+    static NVBIO_FORCEINLINE T saturate(const int32 x)
+    {
+        return T( nvbio::min( nvbio::max( x, int32( Field_traits<T>::min() ) ), int32( Field_traits<T>::max() ) ) );
+    }
+
+    static NVBIO_FORCEINLINE type zero()                                            { return set1( T(0) ); }
+    static NVBIO_FORCEINLINE type set1(const T x)                                   { type r; for (uint32 i = 0; i < WIDTH; ++i) r.v[i] = x; return r; }
+    static NVBIO_FORCEINLINE type load(const T* p)                                  { type r; for (uint32 i = 0; i < WIDTH; ++i) r.v[i] = p[i]; return r; }
+    static NVBIO_FORCEINLINE void store(T* p, const type a)                         { for (uint32 i = 0; i < WIDTH; ++i) p[i] = a.v[i]; }
+    static NVBIO_FORCEINLINE type adds(const type a, const type b)                  { type r; for (uint32 i = 0; i < WIDTH; ++i) r.v[i] = saturate( int32(a.v[i]) + int32(b.v[i]) ); return r; }
+    static NVBIO_FORCEINLINE type subs(const type a, const type b)                  { type r; for (uint32 i = 0; i < WIDTH; ++i) r.v[i] = saturate( int32(a.v[i]) - int32(b.v[i]) ); return r; }
+    static NVBIO_FORCEINLINE type max(const type a, const type b)                   { type r; for (uint32 i = 0; i < WIDTH; ++i) r.v[i] = nvbio::max( a.v[i], b.v[i] ); return r; }
+    static NVBIO_FORCEINLINE type min(const type a, const type b)                   { type r; for (uint32 i = 0; i < WIDTH; ++i) r.v[i] = nvbio::min( a.v[i], b.v[i] ); return r; }
+    static NVBIO_FORCEINLINE type cmpgt(const type a, const type b)                 { type r; for (uint32 i = 0; i < WIDTH; ++i) r.v[i] = a.v[i] >  b.v[i] ? T(-1) : T(0); return r; }
+    static NVBIO_FORCEINLINE type cmpeq(const type a, const type b)                 { type r; for (uint32 i = 0; i < WIDTH; ++i) r.v[i] = a.v[i] == b.v[i] ? T(-1) : T(0); return r; }
+    static NVBIO_FORCEINLINE type and_op(const type a, const type b)                { type r; for (uint32 i = 0; i < WIDTH; ++i) r.v[i] = a.v[i] & b.v[i]; return r; }
+    static NVBIO_FORCEINLINE type or_op(const type a, const type b)                 { type r; for (uint32 i = 0; i < WIDTH; ++i) r.v[i] = a.v[i] | b.v[i]; return r; }
+    static NVBIO_FORCEINLINE type blend(const type a, const type b, const type m)   { type r; for (uint32 i = 0; i < WIDTH; ++i) r.v[i] = m.v[i] ? b.v[i] : a.v[i]; return r; }
+    static NVBIO_FORCEINLINE bool any(const type m)                                 { for (uint32 i = 0; i < WIDTH; ++i) if (m.v[i]) return true; return false; }
+    static NVBIO_FORCEINLINE type shift_in(const type a, const T x)                 { type r; r.v[0] = x; for (uint32 i = 1; i < WIDTH; ++i) r.v[i] = a.v[i-1]; return r; }
+};
+
+template <> struct host_simd<int8>  : host_simd_emulation<int8>  {};
+template <> struct host_simd<int16> : host_simd_emulation<int16> {};
+
+#endif
+
+///@} // end of the HostSIMD group
+///@} // end of the Basic group
+
+} // namespace nvbio
@@ -53,6 +53,15 @@ struct ServerMappedFile::Impl
     HANDLE h_file;
     void*  buffer;
 };
+struct DiskMappedFile::Impl
+{
+    Impl() : h_file( INVALID_HANDLE_VALUE ), h_mapping( NULL ), buffer( NULL ), file_size( 0 ) {} 
+
+    HANDLE h_file;
+    HANDLE h_mapping;
+    void*  buffer;
+    uint64 file_size;
+};
 
 MappedFile::MappedFile() : impl( new Impl() ) {}
 
@@ -142,6 +151,65 @@ ServerMappedFile::~ServerMappedFile()
     delete impl;
 }
 
+DiskMappedFile::DiskMappedFile() : impl( new Impl() ) {}
+
+const void* DiskMappedFile::init(const char* name)
+{
+    impl->h_file = CreateFileA(
+        name,
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        NULL,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+        NULL );
+
+    if (impl->h_file == INVALID_HANDLE_VALUE)
+        throw mapping_error( name, GetLastError() );
+
+    LARGE_INTEGER file_size;
+    if (GetFileSizeEx( impl->h_file, &file_size ) == FALSE)
+        throw mapping_error( name, GetLastError() );
+
+    impl->file_size = uint64( file_size.QuadPart );
+    if (impl->file_size == 0)
+        return NULL;
+
+    impl->h_mapping = CreateFileMapping(
+        impl->h_file,
+        NULL,
+        PAGE_READONLY,
+        0,
+        0,
+        NULL );
+
+    if (impl->h_mapping == NULL)
+        throw mapping_error( name, GetLastError() );
+
+    impl->buffer = MapViewOfFile(
+        impl->h_mapping,
+        FILE_MAP_READ,
+        0,
+        0,
+        0 );
+
+    if (impl->buffer == NULL)
+        throw view_error( name, GetLastError() );
+
+    log_verbose(stderr, "mapped file \"%s\" (%.2f %s)\n", name, (impl->file_size > 1024*1024 ? float(impl->file_size)/float(1024*1024) : float(impl->file_size)), (impl->file_size > 1024*1024 ? "MB" : "B"));
+    return impl->buffer;
+}
+uint64 DiskMappedFile::size() const { return impl->file_size; }
+
+DiskMappedFile::~DiskMappedFile()
+{
+    if (impl->buffer != NULL) UnmapViewOfFile( impl->buffer );
+    if (impl->h_mapping != NULL) CloseHandle( impl->h_mapping );
+    if (impl->h_file != INVALID_HANDLE_VALUE) CloseHandle( impl->h_file );
+
+    delete impl;
+}
+
 } // namespace nvbio
 
 #else
@@ -177,6 +245,14 @@ struct ServerMappedFile::Impl
     std::string file_name;
     uint64      file_size;
 };
+struct DiskMappedFile::Impl
+{
+    Impl() : h_file( -1 ), buffer( NULL ), file_size( 0 ) {} 
+
+    int    h_file;
+    void*  buffer;
+    uint64 file_size;
+};
 
 MappedFile::MappedFile() : impl( new Impl() ) {}
 
@@ -257,6 +333,49 @@ ServerMappedFile::~ServerMappedFile()
     delete impl;
 }
 
+DiskMappedFile::DiskMappedFile() : impl( new Impl() ) {}
+
+const void* DiskMappedFile::init(const char* name)
+{
+    impl->h_file = open( name, O_RDONLY );
+
+    if (impl->h_file == -1)
+        throw mapping_error( name, errno );
+
+    struct stat file_stat;
+    if (fstat( impl->h_file, &file_stat ) == -1)
+        throw mapping_error( name, errno );
+
+    impl->file_size = uint64( file_stat.st_size );
+    if (impl->file_size == 0)
+        return NULL;
+
+    void* buffer = mmap(
+        NULL,
+        impl->file_size,
+        PROT_READ,
+        MAP_SHARED,
+        impl->h_file,
+        0 );
+
+    if (buffer == MAP_FAILED)
+        throw view_error( name, errno );
+
+    impl->buffer = buffer;
+
+    log_verbose(stderr, "mapped file \"%s\" (%.2f %s)\n", name, (impl->file_size > 1024*1024 ? float(impl->file_size)/float(1024*1024) : float(impl->file_size)), (impl->file_size > 1024*1024 ? "MB" : "B"));
+    return impl->buffer;
+}
+uint64 DiskMappedFile::size() const { return impl->file_size; }
+
+DiskMappedFile::~DiskMappedFile()
+{
+    if (impl->buffer != NULL) munmap( impl->buffer, impl->file_size );
+    if (impl->h_file != -1)   close( impl->h_file );
+
+    delete impl;
+}
+
 } // namespace nvbio
 
 #endif
@@ -39,6 +39,7 @@ namespace nvbio {
 ///
 /// - MappedFile
 /// - ServerMappedFile
+/// - DiskMappedFile
 ///
 /// \section MMAPExampleSection Example
 ///
@@ -162,6 +163,49 @@ private:
     Impl* impl;
 };
 
+///
+/// A class to map a regular file on disk, read-only, into the process address space,
+/// so that its contents can be paged in on demand rather than being buffered in memory.
+/// The mapping is released when the destructor is called.
+///
+struct DiskMappedFile
+{
+    struct mapping_error
+    {
+        mapping_error(const char* name, int32 code) : m_file_name( name ), m_code( code ) {}
+
+        const char* m_file_name;
+        int32       m_code;
+    };
+    struct view_error
+    {
+        view_error(const char* name, uint32 code) : m_file_name( name ), m_code( code ) {}
+
+        const char* m_file_name;
+        int32       m_code;
+    };
+
+    /// constructor
+    ///
+    DiskMappedFile();
+
+    /// destructor
+    ///
+    ~DiskMappedFile();
+
+    /// map the given file, returning a pointer to its contents (or NULL if the file is empty)
+    ///
+    const void* init(const char* name);
+
+    /// return the size of the mapped file
+    ///
+    uint64 size() const;
+
+private:
+    struct Impl;
+    Impl* impl;
+};
+
 ///@} MemoryMappingModule
 ///@} Basic
 
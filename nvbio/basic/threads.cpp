@@ -126,6 +126,14 @@ uint32 num_logical_cores()
   #endif
 }
 
+bool threads_enabled()
+{
+  #if NOTHREADS
+    return false;
+  #else
+    return true;
+  #endif
+}
 
 #if NOTHREADS
 
@@ -168,6 +176,22 @@ Mutex::~Mutex()
 void Mutex::lock()   {}
 void Mutex::unlock() {}
 
+/// Condition class
+struct Condition::Impl
+{
+};
+
+Condition::Condition() : m_impl( new Impl )
+{
+}
+Condition::~Condition()
+{
+}
+
+void Condition::wait(Mutex* mutex) {}
+void Condition::signal()           {}
+void Condition::broadcast()        {}
+
 void yield() {}
 
 #elif defined(WIN32)
@@ -258,6 +282,25 @@ Mutex::~Mutex()
 void Mutex::lock()   { EnterCriticalSection( &m_impl->m_mutex ); }
 void Mutex::unlock() { LeaveCriticalSection( &m_impl->m_mutex ); }
 
+/// Condition class
+struct Condition::Impl
+{
+    Impl() { InitializeConditionVariable( &m_cond ); }
+
+    CONDITION_VARIABLE m_cond;
+};
+
+Condition::Condition() : m_impl( new Impl )
+{
+}
+Condition::~Condition()
+{
+}
+
+void Condition::wait(Mutex* mutex) { SleepConditionVariableCS( &m_impl->m_cond, &mutex->m_impl->m_mutex, INFINITE ); }
+void Condition::signal()           { WakeConditionVariable( &m_impl->m_cond ); }
+void Condition::broadcast()        { WakeAllConditionVariable( &m_impl->m_cond ); }
+
 void yield() {}
 
 #else
@@ -307,6 +350,26 @@ Mutex::~Mutex()
 void Mutex::lock()   { pthread_mutex_lock( &m_impl->m_mutex ); }
 void Mutex::unlock() { pthread_mutex_unlock( &m_impl->m_mutex ); }
 
+/// Condition class
+struct Condition::Impl
+{
+     Impl() { pthread_cond_init( &m_cond, NULL ); }
+    ~Impl() { pthread_cond_destroy( &m_cond ); }
+
+    pthread_cond_t m_cond;
+};
+
+Condition::Condition() : m_impl( new Impl )
+{
+}
+Condition::~Condition()
+{
+}
+
+void Condition::wait(Mutex* mutex) { pthread_cond_wait( &m_impl->m_cond, &mutex->m_impl->m_mutex ); }
+void Condition::signal()           { pthread_cond_signal( &m_impl->m_cond ); }
+void Condition::broadcast()        { pthread_cond_broadcast( &m_impl->m_cond ); }
+
 void yield() { pthread_yield(); }
 
 #endif
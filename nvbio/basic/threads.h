@@ -42,6 +42,7 @@ namespace nvbio {
 /// - Thread
 /// - Mutex
 /// - ScopedLock
+/// - Condition
 /// - WorkQueue
 /// - Pipeline
 ///
@@ -56,6 +57,11 @@ namespace nvbio {
 uint32 num_physical_cores();
 uint32 num_logical_cores();
 
+/// return whether Thread::create() actually spawns a thread: in NOTHREADS builds it runs
+/// the thread body synchronously, while Mutex and Condition are no-ops
+///
+bool threads_enabled();
+
 class ThreadBase
 {
 public:
@@ -148,6 +154,8 @@ public:
     void unlock();
 
 private:
+    friend class Condition;
+
     struct Impl;
 
     SharedPointer<Impl, AtomicInt32>  m_impl;
@@ -186,6 +194,57 @@ private:
     Mutex* m_mutex;
 };
 
+/// A condition variable class, to be used together with a Mutex to wait for a predicate
+/// to become true.
+/// e.g.
+///
+/// \code
+/// struct MyQueue
+/// {
+///     void push(const int x)
+///     {
+///         ScopedLock lock( &m_mutex );
+///         m_queue.push( x );
+///         m_cond.signal();
+///     }
+///     int pop()
+///     {
+///         ScopedLock lock( &m_mutex );
+///         while (m_queue.empty())
+///             m_cond.wait( &m_mutex );
+///
+///         const int x = m_queue.front(); m_queue.pop();
+///         return x;
+///     }
+/// private:
+///     Mutex           m_mutex;
+///     Condition       m_cond;
+///     std::queue<int> m_queue;
+/// };
+/// \endcode
+///
+class Condition
+{
+public:
+     Condition();
+    ~Condition();
+
+    /// atomically release the given (locked) mutex and wait for the condition to be signaled,
+    /// re-acquiring the mutex before returning
+    void wait(Mutex* mutex);
+
+    /// wake up one of the waiting threads
+    void signal();
+
+    /// wake up all the waiting threads
+    void broadcast();
+
+private:
+    struct Impl;
+
+    SharedPointer<Impl, AtomicInt32>  m_impl;
+};
+
 /// Work queue class
 template <typename WorkItemT, typename ProgressCallbackT>
 class WorkQueue
@@ -199,7 +199,11 @@ uint32 FASTA_reader::read(const uint32 n_reads, Writer& writer)
                     &m_read[0] );
 
                 if (n == n_reads)
+                {
+                    // put back the '>' so that the next call starts from this sequence
+                    --m_buffer_pos;
                     return n;
+                }
             }
 
             n++;
@@ -126,8 +126,7 @@ void hamming_backtrack(
                 if (range.x <= range.y)
                     delegate( range );
             }
-
-            if (cost < mismatches)
+            else if (cost < mismatches)
             {
                 // compute the four children
                 uint4 cnt_k, cnt_l;
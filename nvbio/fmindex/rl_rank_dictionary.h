@@ -0,0 +1,428 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/numbers.h>
+#include <nvbio/basic/algorithms.h>
+#include <nvbio/basic/static_vector.h>
+#include <nvbio/basic/vector.h>
+#include <nvbio/basic/exceptions.h>
+#include <vector_types.h>
+#include <vector_functions.h>
+#include <vector>
+
+namespace nvbio {
+
+///@addtogroup FMIndex
+///@{
+
+///@addtogroup RankDictionaryModule
+///@{
+
+///
+/// A run-length rank dictionary, i.e. a rank dictionary built on top of the run-length encoding
+/// of a text T, which can answer queries of the kind "how many times does character c occurr in
+/// the substring text[0:i] ?" in O(log(r)) time, where r is the number of runs of T.
+///\par
+/// The data structure stores, for each run, its head symbol, its starting position in T and
+/// the number of occurrences of each symbol preceding it (i.e. the occurrence table is sampled
+/// once per run, in the style of the r-index), for a total of O(r s) space: this makes it
+/// particularly suitable for the highly repetitive BWTs of deep-coverage read collections,
+/// where r is much smaller than n.
+///\par
+/// Like \ref rank_dictionary, this class is <i>storage-free</i>, and it can hence be used both
+/// on the host and on the device, with the storage provided by \ref RLRankDictionaryStorage.
+/// The text of the dictionary is the dictionary itself, which provides an operator[] to
+/// extract individual symbols in O(log(r)) time.
+///
+/// \tparam SYMBOL_SIZE_T       the size of the alphabet, in bits
+/// \tparam HeadIterator        the run heads iterator type
+/// \tparam IndexIterator       the run starts and occurrence table iterator type
+///
+template <uint32 SYMBOL_SIZE_T, typename HeadIterator, typename IndexIterator>
+struct rl_rank_dictionary
+{
+    static const uint32     SYMBOL_SIZE     = SYMBOL_SIZE_T;
+    static const uint32     SYMBOL_COUNT    = 1u << SYMBOL_SIZE;
+
+    typedef HeadIterator    head_iterator;
+    typedef IndexIterator   index_iterator;
+
+    typedef typename std::iterator_traits<IndexIterator>::value_type    index_type;
+    typedef uint8                                                       value_type;
+    typedef uint8                                                       symbol_type;
+
+    typedef typename vector_type<index_type,2>::type                range_type;
+    typedef typename vector_type<index_type,2>::type                vec2_type;
+    typedef typename vector_type<index_type,4>::type                vec4_type;
+    typedef StaticVector<index_type,SYMBOL_COUNT>                   vector_type;
+
+    typedef rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator> text_type;   // the text is the dictionary itself
+
+    /// default constructor
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    rl_rank_dictionary() : m_n_runs(0), m_size(0) {}
+
+    /// constructor
+    ///
+    /// \param _n_runs      number of runs
+    /// \param _size        length of the text
+    /// \param _heads       run heads, n_runs entries
+    /// \param _starts      run starts, n_runs+1 entries (the last being the text length)
+    /// \param _occ         per-run occurrence table, (n_runs+1) * SYMBOL_COUNT entries
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    rl_rank_dictionary(
+        const index_type    _n_runs,
+        const index_type    _size,
+        const HeadIterator  _heads,
+        const IndexIterator _starts,
+        const IndexIterator _occ) :
+        m_n_runs( _n_runs ),
+        m_size( _size ),
+        m_heads( _heads ),
+        m_starts( _starts ),
+        m_occ( _occ ) {}
+
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint32 symbol_count() const { return SYMBOL_COUNT; }
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE uint32 symbol_size()  const { return SYMBOL_SIZE; }
+
+    /// return the number of runs
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE index_type n_runs() const { return m_n_runs; }
+
+    /// return the text length
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE index_type size() const { return m_size; }
+
+    /// return the index of the run containing the i-th symbol
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    index_type run(const index_type i) const
+    {
+        // find the last run starting at or before i
+        return upper_bound_index( i, m_starts, m_n_runs ) - 1u;
+    }
+
+    /// return the i-th symbol
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    uint8 operator[] (const index_type i) const { return m_heads[ run(i) ]; }
+
+    /// return the total number of occurrences of a given symbol
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    index_type count(const uint32 c) const { return m_occ[ m_n_runs * SYMBOL_COUNT + c ]; }
+
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE       text_type& text()       { return *this; }
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE const text_type& text() const { return *this; }
+
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE HeadIterator  heads()  const { return m_heads; }
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE IndexIterator starts() const { return m_starts; }
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE IndexIterator occ()    const { return m_occ; }
+
+    index_type      m_n_runs;
+    index_type      m_size;
+    HeadIterator    m_heads;
+    IndexIterator   m_starts;
+    IndexIterator   m_occ;
+};
+
+///
+/// A run-length rank dictionary storage class, holding the run heads, the run starts and the
+/// per-run occurrence table needed by \ref rl_rank_dictionary.
+///
+/// \tparam SystemTag           the system memory space where this object's data is allocated
+/// \tparam SYMBOL_SIZE_T       the size of the alphabet, in bits
+/// \tparam IndexType           the type of integers used to index the text
+///
+template <typename SystemTag, uint32 SYMBOL_SIZE_T = 2, typename IndexType = uint64>
+struct RLRankDictionaryStorage
+{
+    static const uint32 SYMBOL_SIZE  = SYMBOL_SIZE_T;
+    static const uint32 SYMBOL_COUNT = 1u << SYMBOL_SIZE;
+
+    typedef SystemTag                                       system_tag;
+    typedef IndexType                                       index_type;
+
+    typedef nvbio::vector<system_tag,uint8>                 head_vector_type;
+    typedef nvbio::vector<system_tag,index_type>            index_vector_type;
+
+    typedef rl_rank_dictionary<SYMBOL_SIZE,      uint8*,      index_type*>       plain_view_type;
+    typedef rl_rank_dictionary<SYMBOL_SIZE,const uint8*,const index_type*> const_plain_view_type;
+
+    /// constructor
+    ///
+    RLRankDictionaryStorage() : m_n_runs( 0u ), m_size( 0u ) {}
+
+    /// copy constructor
+    ///
+    template <typename OtherSystemTag>
+    RLRankDictionaryStorage(const RLRankDictionaryStorage<OtherSystemTag,SYMBOL_SIZE_T,IndexType>& other) :
+        m_n_runs( other.m_n_runs ),
+        m_size( other.m_size ),
+        m_heads( other.m_heads ),
+        m_starts( other.m_starts ),
+        m_occ( other.m_occ ) {}
+
+    /// copy operator
+    ///
+    template <typename OtherSystemTag>
+    RLRankDictionaryStorage& operator=(const RLRankDictionaryStorage<OtherSystemTag,SYMBOL_SIZE_T,IndexType>& other)
+    {
+        m_n_runs = other.m_n_runs;
+        m_size   = other.m_size;
+        m_heads  = other.m_heads;
+        m_starts = other.m_starts;
+        m_occ    = other.m_occ;
+        return *this;
+    }
+
+    /// resize the dictionary
+    ///
+    void resize(const index_type _n_runs, const index_type _size)
+    {
+        m_n_runs = _n_runs;
+        m_size   = _size;
+
+        m_heads.resize( m_n_runs );
+        m_starts.resize( m_n_runs + 1u );
+        m_occ.resize( (m_n_runs + 1u) * SYMBOL_COUNT );
+    }
+
+    /// return the number of runs
+    ///
+    index_type n_runs() const { return m_n_runs; }
+
+    /// return the text length
+    ///
+    index_type size() const { return m_size; }
+
+    /// return the amount of memory used by this object, in bytes
+    ///
+    uint64 bytes() const
+    {
+        return m_heads.size()  * sizeof(uint8) +
+               m_starts.size() * sizeof(index_type) +
+               m_occ.size()    * sizeof(index_type);
+    }
+
+    operator plain_view_type()
+    {
+        return plain_view_type(
+            m_n_runs,
+            m_size,
+            nvbio::raw_pointer( m_heads ),
+            nvbio::raw_pointer( m_starts ),
+            nvbio::raw_pointer( m_occ ) );
+    }
+    operator const_plain_view_type() const
+    {
+        return const_plain_view_type(
+            m_n_runs,
+            m_size,
+            nvbio::raw_pointer( m_heads ),
+            nvbio::raw_pointer( m_starts ),
+            nvbio::raw_pointer( m_occ ) );
+    }
+
+    index_type          m_n_runs;
+    index_type          m_size;
+    head_vector_type    m_heads;
+    index_vector_type   m_starts;
+    index_vector_type   m_occ;
+};
+
+/// \relates RLRankDictionaryStorage
+///
+/// build a run-length rank dictionary out of a list of runs, specified as (symbol,length) pairs;
+/// consecutive runs of the same symbol are merged.
+///
+/// \param n_runs           the number of input runs
+/// \param heads            the run heads
+/// \param lengths          the run lengths
+/// \param out_dict         the output dictionary
+///
+template <uint32 SYMBOL_SIZE, typename index_type, typename head_iterator, typename length_iterator>
+void setup_rl_rank_dictionary(
+    const uint64                                                n_runs,
+    const head_iterator                                         heads,
+    const length_iterator                                       lengths,
+    RLRankDictionaryStorage<host_tag,SYMBOL_SIZE,index_type>&   out_dict);
+
+/// \relates RLRankDictionaryStorage
+///
+/// build a run-length rank dictionary out of a string
+///
+/// \param string_len       the string length
+/// \param string           the string iterator
+/// \param out_dict         the output dictionary
+///
+template <uint32 SYMBOL_SIZE, typename index_type, typename string_iterator>
+void setup_rl_rank_dictionary(
+    const index_type                                            string_len,
+    const string_iterator                                       string,
+    RLRankDictionaryStorage<host_tag,SYMBOL_SIZE,index_type>&   out_dict);
+
+/// \relates rl_rank_dictionary
+/// fetch the text character at position i in the rank dictionary
+///
+template <uint32 SYMBOL_SIZE_T, typename HeadIterator, typename IndexIterator, typename IndexType>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+uint8 text(const rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>& dict, const IndexType i);
+
+/// \relates rl_rank_dictionary
+/// fetch the number of occurrences of character c in the substring [0,i]
+///
+/// \param dict         the rank dictionary
+/// \param i            the end of the query range [0,i]
+/// \param c            the query character
+///
+template <uint32 SYMBOL_SIZE_T, typename HeadIterator, typename IndexIterator>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+typename rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>::index_type
+rank(
+    const          rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>&             dict,
+    const typename rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>::index_type  i,
+    const uint32                                                                            c);
+
+/// \relates rl_rank_dictionary
+/// fetch the number of occurrences of character c in the substrings [0,l] and [0,r]
+///
+/// \param dict         the rank dictionary
+/// \param range        the ends of the query ranges [0,range.x] and [0,range.y]
+/// \param c            the query character
+///
+template <uint32 SYMBOL_SIZE_T, typename HeadIterator, typename IndexIterator>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+typename rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>::range_type
+rank(
+    const          rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>&             dict,
+    const typename rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>::range_type  range,
+    const uint32                                                                            c);
+
+/// \relates rl_rank_dictionary
+/// fetch the number of occurrences of all characters c in the substring [0,i]
+///
+/// \param dict         the rank dictionary
+/// \param i            the end of the query range [0,i]
+///
+template <typename HeadIterator, typename IndexIterator>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+typename rl_rank_dictionary<2,HeadIterator,IndexIterator>::vec4_type
+rank4(
+    const          rl_rank_dictionary<2,HeadIterator,IndexIterator>&             dict,
+    const typename rl_rank_dictionary<2,HeadIterator,IndexIterator>::index_type  i);
+
+/// \relates rl_rank_dictionary
+/// fetch the number of occurrences of all characters in the substrings [0,l] and [0,r]
+///
+/// \param dict         the rank dictionary
+/// \param range        the ends of the query ranges [0,range.x] and [0,range.y]
+/// \param outl         the output count of all characters in the first range
+/// \param outh         the output count of all characters in the second range
+///
+template <typename HeadIterator, typename IndexIterator>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void rank4(
+    const          rl_rank_dictionary<2,HeadIterator,IndexIterator>&             dict,
+    const typename rl_rank_dictionary<2,HeadIterator,IndexIterator>::range_type  range,
+          typename rl_rank_dictionary<2,HeadIterator,IndexIterator>::vec4_type*  outl,
+          typename rl_rank_dictionary<2,HeadIterator,IndexIterator>::vec4_type*  outh);
+
+/// \relates rl_rank_dictionary
+/// fetch the number of occurrences of all characters c in the substring [0,i]
+///
+/// \param dict         the rank dictionary
+/// \param i            the end of the query range [0,i]
+///
+template <uint32 SYMBOL_SIZE_T, typename HeadIterator, typename IndexIterator>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+typename rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>::vector_type
+rank_all(
+    const          rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>&             dict,
+    const typename rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>::index_type  i);
+
+/// \relates rl_rank_dictionary
+/// fetch the number of occurrences of all characters c in the substring [0,i]
+///
+/// \param dict         the rank dictionary
+/// \param i            the end of the query range [0,i]
+/// \param out          the output count of all characters
+///
+template <uint32 SYMBOL_SIZE_T, typename HeadIterator, typename IndexIterator>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void rank_all(
+    const          rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>&                dict,
+    const typename rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>::index_type     i,
+          typename rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>::vector_type*  out);
+
+/// \relates rl_rank_dictionary
+/// fetch the number of occurrences of all characters in the substrings [0,l] and [0,r]
+///
+/// \param dict         the rank dictionary
+/// \param range        the ends of the query ranges [0,range.x] and [0,range.y]
+/// \param outl         the output count of all characters in the first range
+/// \param outh         the output count of all characters in the second range
+///
+template <uint32 SYMBOL_SIZE_T, typename HeadIterator, typename IndexIterator>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void rank_all(
+    const          rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>&                dict,
+    const typename rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>::range_type     range,
+          typename rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>::vector_type*  outl,
+          typename rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>::vector_type*  outh);
+
+/// \relates RLRankDictionaryStorage
+///
+/// plain_view specialization
+///
+template <typename SystemTag, uint32 SYMBOL_SIZE, typename IndexType>
+typename RLRankDictionaryStorage<SystemTag,SYMBOL_SIZE,IndexType>::plain_view_type plain_view(RLRankDictionaryStorage<SystemTag,SYMBOL_SIZE,IndexType>& dict)
+{
+    return dict;
+}
+/// \relates RLRankDictionaryStorage
+///
+/// plain_view specialization
+///
+template <typename SystemTag, uint32 SYMBOL_SIZE, typename IndexType>
+typename RLRankDictionaryStorage<SystemTag,SYMBOL_SIZE,IndexType>::const_plain_view_type plain_view(const RLRankDictionaryStorage<SystemTag,SYMBOL_SIZE,IndexType>& dict)
+{
+    return dict;
+}
+
+///@} RankDictionaryModule
+///@} FMIndex
+
+} // namespace nvbio
+
+#include <nvbio/fmindex/rl_rank_dictionary_inl.h>
@@ -0,0 +1,288 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+namespace nvbio {
+
+// build a run-length rank dictionary out of a list of runs
+//
+template <uint32 SYMBOL_SIZE, typename index_type, typename head_iterator, typename length_iterator>
+void setup_rl_rank_dictionary(
+    const uint64                                                n_runs,
+    const head_iterator                                         heads,
+    const length_iterator                                       lengths,
+    RLRankDictionaryStorage<host_tag,SYMBOL_SIZE,index_type>&   out_dict)
+{
+    const uint32 SYMBOL_COUNT = 1u << SYMBOL_SIZE;
+
+    // count the number of maximal runs, merging adjacent runs of the same symbol
+    // and skipping empty ones
+    index_type n_out_runs = 0;
+    index_type size       = 0;
+    {
+        uint32 prev = uint32(-1);
+        for (uint64 r = 0; r < n_runs; ++r)
+        {
+            if (lengths[r] == 0)
+                continue;
+
+            const uint32 c = heads[r];
+            if (c != prev)
+            {
+                ++n_out_runs;
+                prev = c;
+            }
+            size += index_type( lengths[r] );
+        }
+    }
+
+    out_dict.resize( n_out_runs, size );
+
+    uint8*      out_heads  = nvbio::raw_pointer( out_dict.m_heads );
+    index_type* out_starts = nvbio::raw_pointer( out_dict.m_starts );
+    index_type* out_occ    = nvbio::raw_pointer( out_dict.m_occ );
+
+    StaticVector<index_type,SYMBOL_COUNT> counts( index_type(0) );
+
+    index_type k   = 0;
+    index_type pos = 0;
+    uint32 prev    = uint32(-1);
+    for (uint64 r = 0; r < n_runs; ++r)
+    {
+        if (lengths[r] == 0)
+            continue;
+
+        const uint32 c = heads[r];
+        if (c >= SYMBOL_COUNT)
+            throw nvbio::runtime_error("setup_rl_rank_dictionary(): symbol %u out of range", c);
+
+        if (c != prev)
+        {
+            // open a new run, saving the counters preceding it
+            out_heads[k]  = uint8( c );
+            out_starts[k] = pos;
+            for (uint32 s = 0; s < SYMBOL_COUNT; ++s)
+                out_occ[ k * SYMBOL_COUNT + s ] = counts[s];
+
+            ++k;
+            prev = c;
+        }
+        counts[c] += index_type( lengths[r] );
+        pos       += index_type( lengths[r] );
+    }
+
+    // write the sentinel entries
+    out_starts[ n_out_runs ] = size;
+    for (uint32 s = 0; s < SYMBOL_COUNT; ++s)
+        out_occ[ n_out_runs * SYMBOL_COUNT + s ] = counts[s];
+}
+
+// build a run-length rank dictionary out of a string
+//
+template <uint32 SYMBOL_SIZE, typename index_type, typename string_iterator>
+void setup_rl_rank_dictionary(
+    const index_type                                            string_len,
+    const string_iterator                                       string,
+    RLRankDictionaryStorage<host_tag,SYMBOL_SIZE,index_type>&   out_dict)
+{
+    // run-length encode the string
+    std::vector<uint8>      heads;
+    std::vector<index_type> lengths;
+
+    for (index_type i = 0; i < string_len;)
+    {
+        const uint8 c = string[i];
+
+        index_type j = i+1;
+        while (j < string_len && string[j] == c)
+            ++j;
+
+        heads.push_back( c );
+        lengths.push_back( j - i );
+        i = j;
+    }
+
+    setup_rl_rank_dictionary(
+        uint64( heads.size() ),
+        heads.begin(),
+        lengths.begin(),
+        out_dict );
+}
+
+// fetch the text character at position i in the rank dictionary
+//
+template <uint32 SYMBOL_SIZE_T, typename HeadIterator, typename IndexIterator, typename IndexType>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+uint8 text(const rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>& dict, const IndexType i)
+{
+    return dict[i];
+}
+
+// fetch the number of occurrences of character c in the substring [0,i]
+//
+template <uint32 SYMBOL_SIZE_T, typename HeadIterator, typename IndexIterator>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+typename rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>::index_type
+rank(
+    const          rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>&             dict,
+    const typename rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>::index_type  i,
+    const uint32                                                                            c)
+{
+    typedef typename rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>::index_type index_type;
+
+    const uint32 SYMBOL_COUNT = 1u << SYMBOL_SIZE_T;
+
+    // the empty prefix [0,-1] contains no symbols
+    if (i == index_type(-1))
+        return 0u;
+
+    const index_type k = dict.run( i );
+
+    // add the occurrences preceding the run and, if the run is made of c's,
+    // the ones within the run itself
+    const index_type r = dict.m_occ[ k * SYMBOL_COUNT + c ];
+    return dict.m_heads[k] == c ?
+        r + (i - dict.m_starts[k]) + 1u :
+        r;
+}
+
+// fetch the number of occurrences of character c in the substrings [0,l] and [0,r]
+//
+template <uint32 SYMBOL_SIZE_T, typename HeadIterator, typename IndexIterator>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+typename rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>::range_type
+rank(
+    const          rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>&             dict,
+    const typename rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>::range_type  range,
+    const uint32                                                                            c)
+{
+    return make_vector(
+        rank( dict, range.x, c ),
+        rank( dict, range.y, c ) );
+}
+
+// fetch the number of occurrences of all characters c in the substring [0,i]
+//
+template <typename HeadIterator, typename IndexIterator>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+typename rl_rank_dictionary<2,HeadIterator,IndexIterator>::vec4_type
+rank4(
+    const          rl_rank_dictionary<2,HeadIterator,IndexIterator>&             dict,
+    const typename rl_rank_dictionary<2,HeadIterator,IndexIterator>::index_type  i)
+{
+    typedef typename rl_rank_dictionary<2,HeadIterator,IndexIterator>::index_type index_type;
+
+    const index_type zero = index_type(0);
+
+    if (i == index_type(-1))
+        return make_vector( zero, zero, zero, zero );
+
+    const index_type k = dict.run( i );
+    const uint8      c = dict.m_heads[k];
+    const index_type n = (i - dict.m_starts[k]) + 1u;
+
+    return make_vector(
+        dict.m_occ[ k*4 + 0 ] + (c == 0 ? n : index_type(0)),
+        dict.m_occ[ k*4 + 1 ] + (c == 1 ? n : index_type(0)),
+        dict.m_occ[ k*4 + 2 ] + (c == 2 ? n : index_type(0)),
+        dict.m_occ[ k*4 + 3 ] + (c == 3 ? n : index_type(0)) );
+}
+
+// fetch the number of occurrences of all characters in the substrings [0,l] and [0,r]
+//
+template <typename HeadIterator, typename IndexIterator>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void rank4(
+    const          rl_rank_dictionary<2,HeadIterator,IndexIterator>&             dict,
+    const typename rl_rank_dictionary<2,HeadIterator,IndexIterator>::range_type  range,
+          typename rl_rank_dictionary<2,HeadIterator,IndexIterator>::vec4_type*  outl,
+          typename rl_rank_dictionary<2,HeadIterator,IndexIterator>::vec4_type*  outh)
+{
+    *outl = rank4( dict, range.x );
+    *outh = range.x == range.y ? *outl : rank4( dict, range.y );
+}
+
+// fetch the number of occurrences of all characters c in the substring [0,i]
+//
+template <uint32 SYMBOL_SIZE_T, typename HeadIterator, typename IndexIterator>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void rank_all(
+    const          rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>&                dict,
+    const typename rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>::index_type     i,
+          typename rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>::vector_type*  out)
+{
+    typedef typename rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>::index_type index_type;
+
+    const uint32 SYMBOL_COUNT = 1u << SYMBOL_SIZE_T;
+
+    if (i == index_type(-1))
+    {
+        for (uint32 c = 0; c < SYMBOL_COUNT; ++c)
+            (*out)[c] = index_type(0);
+        return;
+    }
+
+    const index_type k = dict.run( i );
+
+    for (uint32 c = 0; c < SYMBOL_COUNT; ++c)
+        (*out)[c] = dict.m_occ[ k * SYMBOL_COUNT + c ];
+
+    (*out)[ dict.m_heads[k] ] += (i - dict.m_starts[k]) + 1u;
+}
+
+// fetch the number of occurrences of all characters c in the substring [0,i]
+//
+template <uint32 SYMBOL_SIZE_T, typename HeadIterator, typename IndexIterator>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+typename rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>::vector_type
+rank_all(
+    const          rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>&             dict,
+    const typename rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>::index_type  i)
+{
+    typename rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>::vector_type out;
+
+    rank_all( dict, i, &out );
+    return out;
+}
+
+// fetch the number of occurrences of all characters in the substrings [0,l] and [0,r]
+//
+template <uint32 SYMBOL_SIZE_T, typename HeadIterator, typename IndexIterator>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void rank_all(
+    const          rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>&                dict,
+    const typename rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>::range_type     range,
+          typename rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>::vector_type*  outl,
+          typename rl_rank_dictionary<SYMBOL_SIZE_T,HeadIterator,IndexIterator>::vector_type*  outh)
+{
+    rank_all( dict, range.x, outl );
+    rank_all( dict, range.y, outh );
+}
+
+} // namespace nvbio
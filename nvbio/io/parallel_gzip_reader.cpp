@@ -0,0 +1,635 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <nvbio/io/parallel_gzip_reader.h>
+#include <nvbio/basic/console.h>
+#include <nvbio/basic/numbers.h>
+#include <string.h>
+
+#if defined(NVBIO_LIBDEFLATE)
+#include <libdeflate.h>
+#endif
+
+namespace nvbio {
+namespace io {
+
+namespace {
+
+// the number of BGZF blocks batched in a single slot
+static const uint32 BGZF_BLOCKS_PER_SLOT = 16u;
+
+// the maximum size of a BGZF block, compressed or not
+static const uint32 BGZF_MAX_BLOCK_SIZE = 64u*1024u;
+
+// the size of the fixed part of the gzip header, and of the gzip footer
+static const uint32 GZIP_HEADER_SIZE = 12u;
+static const uint32 GZIP_FOOTER_SIZE = 8u;
+
+// the size of the slots used for plain gzip files
+static const uint32 GZIP_SLOT_SIZE = 1024u*1024u;
+
+// read a little-endian 16-bit integer
+inline uint32 load_le16(const uint8* ptr) { return uint32( ptr[0] ) | (uint32( ptr[1] ) << 8); }
+
+// read a little-endian 32-bit integer
+inline uint32 load_le32(const uint8* ptr) { return load_le16( ptr ) | (load_le16( ptr + 2 ) << 16); }
+
+// check whether a fixed gzip header belongs to a BGZF block
+inline bool is_bgzf_header(const uint8* header)
+{
+    return header[0] == 31u  &&
+           header[1] == 139u &&
+           header[2] == 8u   &&     // deflate
+          (header[3] & 4u);         // FEXTRA
+}
+
+// look for the BC subfield in the extra field of a BGZF block, returning the total block size
+// or 0 if not found
+inline uint32 find_bgzf_block_size(const uint8* extra, const uint32 extra_len)
+{
+    for (uint32 i = 0; i + 4u <= extra_len;)
+    {
+        const uint32 subfield_len = load_le16( extra + i + 2u );
+        if (extra[i] == 'B' && extra[i+1] == 'C' && subfield_len == 2u && i + 6u <= extra_len)
+            return load_le16( extra + i + 4u ) + 1u;
+
+        i += 4u + subfield_len;
+    }
+    return 0u;
+}
+
+// a raw deflate block decompressor
+//
+struct BlockInflater
+{
+  #if defined(NVBIO_LIBDEFLATE)
+    BlockInflater()  { m_decompressor = libdeflate_alloc_decompressor(); }
+    ~BlockInflater() { libdeflate_free_decompressor( m_decompressor ); }
+
+    // inflate a block, returning the CRC32 of the output, or false on errors
+    bool inflate(const uint8* src, const uint32 src_size, uint8* dst, const uint32 dst_size, uint32* crc)
+    {
+        size_t out_size;
+        if (libdeflate_deflate_decompress( m_decompressor, src, src_size, dst, dst_size, &out_size ) != LIBDEFLATE_SUCCESS ||
+            out_size != dst_size)
+            return false;
+
+        *crc = libdeflate_crc32( 0u, dst, dst_size );
+        return true;
+    }
+
+    struct libdeflate_decompressor* m_decompressor;
+  #else
+    BlockInflater()
+    {
+        memset( &m_stream, 0, sizeof(z_stream) );
+        inflateInit2( &m_stream, -15 ); // raw deflate
+    }
+    ~BlockInflater() { inflateEnd( &m_stream ); }
+
+    // inflate a block, returning the CRC32 of the output, or false on errors
+    bool inflate(const uint8* src, const uint32 src_size, uint8* dst, const uint32 dst_size, uint32* crc)
+    {
+        inflateReset( &m_stream );
+
+        m_stream.next_in   = const_cast<Bytef*>( src );
+        m_stream.avail_in  = src_size;
+        m_stream.next_out  = dst;
+        m_stream.avail_out = dst_size;
+
+        if (::inflate( &m_stream, Z_FINISH ) != Z_STREAM_END ||
+            m_stream.total_out != dst_size)
+            return false;
+
+        *crc = uint32( crc32( 0u, dst, dst_size ) );
+        return true;
+    }
+
+    z_stream m_stream;
+  #endif
+};
+
+// inflate the BGZF blocks starting at the given input offsets to the given output offsets,
+// returning an error message, or NULL on success
+//
+const char* inflate_bgzf_blocks(
+    BlockInflater&              inflater,
+    const uint8*                in,
+    const std::vector<uint32>&  blocks,
+    const std::vector<uint32>&  outputs,
+    uint8*                      out)
+{
+    for (uint32 b = 0; b + 1u < uint32( blocks.size() ); ++b)
+    {
+        const uint8* block      = in + blocks[b];
+        const uint32 block_size = blocks[b+1] - blocks[b];
+        const uint32 extra_len  = load_le16( block + 10u );
+        const uint32 out_size   = outputs[b+1] - outputs[b];
+
+        if (out_size == 0u)
+            continue; // e.g. the EOF marker block
+
+        uint32 crc;
+        if (inflater.inflate(
+                block + GZIP_HEADER_SIZE + extra_len,
+                block_size - GZIP_HEADER_SIZE - extra_len - GZIP_FOOTER_SIZE,
+                out + outputs[b],
+                out_size,
+                &crc ) == false)
+            return "corrupted BGZF block";
+
+        if (crc != load_le32( block + block_size - 8u ))
+            return "BGZF block CRC mismatch";
+    }
+    return NULL;
+}
+
+} // anonymous namespace
+
+// constructor
+//
+ParallelGzipReader::ParallelGzipReader() :
+    m_format( NONE ),
+    m_file( NULL ),
+    m_gz_file( NULL ),
+    m_n_threads( 0 ),
+    m_synchronous( false ),
+    m_head( 0 ),
+    m_tail( 0 ),
+    m_tail_pos( 0 ),
+    m_stop( false ),
+    m_input_done( false ),
+    m_eof( false ),
+    m_offset( 0 )
+{}
+
+// destructor
+//
+ParallelGzipReader::~ParallelGzipReader() { close(); }
+
+// open a file, spawning the input and decompression threads
+//
+bool ParallelGzipReader::open(const char* file_name, const uint32 n_threads, const uint64 max_memory)
+{
+    close();
+
+    m_file_name   = file_name;
+    m_synchronous = threads_enabled() == false;
+
+    // check whether this is a BGZF file
+    m_file = fopen( file_name, "rb" );
+    if (m_file == NULL)
+        return false;
+
+    uint8 header[ GZIP_HEADER_SIZE + 6u ];
+    const bool bgzf =
+        fread( header, 1u, sizeof(header), m_file ) == sizeof(header) &&
+        is_bgzf_header( header ) &&
+        find_bgzf_block_size( header + GZIP_HEADER_SIZE, nvbio::min( load_le16( header + 10u ), 6u ) ) != 0u;
+
+    uint32 slot_size;
+    if (bgzf)
+    {
+        fseek( m_file, 0, SEEK_SET );
+
+        m_format    = BGZF;
+        m_n_threads = m_synchronous ? 0u :
+                      n_threads ? n_threads : nvbio::max( num_logical_cores(), 1u );
+        slot_size   = 2u * BGZF_BLOCKS_PER_SLOT * BGZF_MAX_BLOCK_SIZE;
+    }
+    else
+    {
+        // let zlib handle plain gzip and uncompressed files alike
+        fclose( m_file );
+        m_file = NULL;
+
+        m_gz_file = gzopen( file_name, "rb" );
+        if (m_gz_file == NULL)
+            return false;
+
+        gzbuffer( m_gz_file, GZIP_SLOT_SIZE );
+
+        m_format    = GZIP;
+        m_n_threads = 0;
+        slot_size   = GZIP_SLOT_SIZE;
+    }
+
+    // keep at least one slot per decompression thread plus one being filled and one being
+    // consumed, regardless of the memory budget - without threads, a single slot is filled
+    // on demand by the consumer
+    const uint32 n_slots = m_synchronous ? 1u : nvbio::max(
+        uint32( nvbio::min( max_memory / slot_size, uint64( 4096u ) ) ),
+        m_n_threads + 2u );
+
+    m_slots.resize( n_slots );
+    for (uint32 i = 0; i < n_slots; ++i)
+    {
+        if (m_format == BGZF)
+        {
+            m_slots[i].in.resize( BGZF_BLOCKS_PER_SLOT * BGZF_MAX_BLOCK_SIZE );
+            m_slots[i].out.resize( BGZF_BLOCKS_PER_SLOT * BGZF_MAX_BLOCK_SIZE );
+        }
+        else
+            m_slots[i].out.resize( GZIP_SLOT_SIZE );
+    }
+
+    log_debug(stderr,"  gzip reader: %s, %u threads, %u slots (%.1f MB)\n",
+        m_format == BGZF ? "BGZF" : "gzip", m_n_threads, n_slots, float( uint64( slot_size ) * n_slots ) / float(1024*1024));
+
+    start();
+    return true;
+}
+
+// close the file, stopping all threads
+//
+void ParallelGzipReader::close()
+{
+    if (m_format == NONE)
+        return;
+
+    stop();
+
+    if (m_file)
+        fclose( m_file );
+    if (m_gz_file)
+        gzclose( m_gz_file );
+
+    m_file    = NULL;
+    m_gz_file = NULL;
+    m_format  = NONE;
+    m_slots.clear();
+}
+
+// rewind the file
+//
+bool ParallelGzipReader::rewind()
+{
+    if (m_format == NONE)
+        return false;
+
+    stop();
+
+    if (m_file)
+        fseek( m_file, 0, SEEK_SET );
+    if (m_gz_file)
+        gzrewind( m_gz_file );
+
+    start();
+    return true;
+}
+
+// spawn the threads
+//
+void ParallelGzipReader::start()
+{
+    m_head       = 0;
+    m_tail       = 0;
+    m_tail_pos   = 0;
+    m_stop       = false;
+    m_input_done = false;
+    m_eof        = false;
+    m_offset     = 0;
+    m_error.clear();
+
+    while (!m_work.empty())
+        m_work.pop();
+
+    for (uint32 i = 0; i < m_slots.size(); ++i)
+        m_slots[i].state = FREE;
+
+    if (m_synchronous)
+        return;
+
+    // spawn the threads - note that the threads vector must not be resized after this point
+    m_threads.resize( m_n_threads );
+    for (uint32 i = 0; i < m_n_threads; ++i)
+    {
+        m_threads[i].reader = this;
+        m_threads[i].set_id( i );
+        m_threads[i].create();
+    }
+
+    m_input_thread.reader = this;
+    m_input_thread.create();
+}
+
+// stop all threads
+//
+void ParallelGzipReader::stop()
+{
+    if (m_synchronous)
+        return;
+
+    // signal termination
+    {
+        ScopedLock lock( &m_mutex );
+        m_stop = true;
+        m_cond.broadcast();
+    }
+
+    m_input_thread.join();
+
+    for (uint32 i = 0; i < m_threads.size(); ++i)
+        m_threads[i].join();
+
+    m_threads.clear();
+}
+
+// read up to n_bytes of decompressed data
+//
+int32 ParallelGzipReader::read(void* dst, const uint32 n_bytes)
+{
+    return int32( consume( (uint8*)dst, n_bytes ) );
+}
+
+// skip n_bytes of decompressed data
+//
+int64 ParallelGzipReader::skip(const uint64 n_bytes)
+{
+    return consume( NULL, n_bytes );
+}
+
+// consume up to n_bytes of decompressed data, copying them to dst if not NULL
+//
+int64 ParallelGzipReader::consume(uint8* dst, const uint64 n_bytes)
+{
+    if (m_format == NONE || m_error.empty() == false)
+        return -1;
+
+    uint64 n_consumed = 0;
+    while (n_consumed < n_bytes)
+    {
+        Slot& slot = m_slots[ m_tail % m_slots.size() ];
+
+        if (m_synchronous && slot.state == FREE && m_input_done == false)
+            fill_next_synchronous();
+
+        // wait for the oldest slot to be decompressed
+        {
+            ScopedLock lock( &m_mutex );
+            while (slot.state != DONE && (m_input_done == false || m_tail < m_head))
+                m_cond.wait( &m_mutex );
+
+            if (slot.state != DONE)
+            {
+                // no more data
+                m_eof = true;
+                break;
+            }
+        }
+
+        if (slot.error.empty() == false)
+        {
+            m_error = slot.error;
+            return -1;
+        }
+
+        // DONE slots are only ever touched by the consumer, so we can read it outside the lock
+        const uint32 n_copied = uint32( nvbio::min( uint64( slot.out_size - m_tail_pos ), n_bytes - n_consumed ) );
+        if (dst)
+            memcpy( dst + n_consumed, &slot.out[ m_tail_pos ], n_copied );
+
+        m_tail_pos += n_copied;
+        n_consumed += n_copied;
+
+        // release the slot as soon as it has been fully consumed
+        if (m_tail_pos == slot.out_size)
+        {
+            ScopedLock lock( &m_mutex );
+            slot.state = FREE;
+            m_tail_pos = 0;
+            ++m_tail;
+            m_cond.broadcast();
+        }
+    }
+    m_offset += n_consumed;
+    return int64( n_consumed );
+}
+
+// read the next few BGZF blocks into a slot, returning false at the end of the file or on errors
+//
+bool ParallelGzipReader::fill_bgzf(Slot& slot)
+{
+    uint32 in_size  = 0;
+    uint32 out_size = 0;
+
+    for (uint32 b = 0; b < BGZF_BLOCKS_PER_SLOT; ++b)
+    {
+        uint8* block = &slot.in[ in_size ];
+
+        // read the fixed part of the header
+        const size_t n_read = fread( block, 1u, GZIP_HEADER_SIZE, m_file );
+        if (n_read == 0u && feof( m_file ))
+            break;
+
+        if (n_read != GZIP_HEADER_SIZE || is_bgzf_header( block ) == false)
+        {
+            slot.error = "invalid BGZF block header";
+            break;
+        }
+
+        // read the extra field, and look for the block size in it
+        const uint32 extra_len = load_le16( block + 10u );
+        if (GZIP_HEADER_SIZE + extra_len + GZIP_FOOTER_SIZE > BGZF_MAX_BLOCK_SIZE ||
+            fread( block + GZIP_HEADER_SIZE, 1u, extra_len, m_file ) != extra_len)
+        {
+            slot.error = "truncated BGZF block header";
+            break;
+        }
+
+        const uint32 block_size = find_bgzf_block_size( block + GZIP_HEADER_SIZE, extra_len );
+        if (block_size < GZIP_HEADER_SIZE + extra_len + GZIP_FOOTER_SIZE)
+        {
+            slot.error = "invalid BGZF block size";
+            break;
+        }
+
+        // and read the rest of the block
+        const uint32 rem = block_size - GZIP_HEADER_SIZE - extra_len;
+        if (fread( block + GZIP_HEADER_SIZE + extra_len, 1u, rem, m_file ) != rem)
+        {
+            slot.error = "truncated BGZF block";
+            break;
+        }
+
+        const uint32 block_out_size = load_le32( block + block_size - 4u );
+        if (block_out_size > BGZF_MAX_BLOCK_SIZE)
+        {
+            slot.error = "invalid BGZF block uncompressed size";
+            break;
+        }
+
+        slot.blocks.push_back( in_size );
+        slot.outputs.push_back( out_size );
+
+        in_size  += block_size;
+        out_size += block_out_size;
+    }
+    slot.blocks.push_back( in_size );
+    slot.outputs.push_back( out_size );
+    slot.out_size = out_size;
+
+    return slot.error.empty() && in_size;
+}
+
+// read the next chunk of a gzip file into a slot, returning false at the end of the file or on errors
+//
+bool ParallelGzipReader::fill_gzip(Slot& slot)
+{
+    uint32 out_size = 0;
+    while (out_size < GZIP_SLOT_SIZE)
+    {
+        const int n_bytes = gzread( m_gz_file, &slot.out[ out_size ], GZIP_SLOT_SIZE - out_size );
+        if (n_bytes < 0)
+        {
+            int err;
+            slot.error = gzerror( m_gz_file, &err );
+            break;
+        }
+        if (n_bytes == 0)
+            break;
+
+        out_size += uint32( n_bytes );
+    }
+    slot.out_size = out_size;
+
+    return slot.error.empty() && out_size == GZIP_SLOT_SIZE;
+}
+
+// read the next slot and hand it over to the decompression threads, or directly to the consumer,
+// returning false at the end of the file or on errors
+//
+bool ParallelGzipReader::fill_next()
+{
+    const uint32 slot_idx = uint32( m_head % m_slots.size() );
+    Slot& slot = m_slots[ slot_idx ];
+
+    // FREE slots are only ever touched by the input thread, so we can fill it outside the lock
+    slot.blocks.clear();
+    slot.outputs.clear();
+    slot.error.clear();
+
+    const bool more = (m_format == BGZF) ? fill_bgzf( slot ) : fill_gzip( slot );
+
+    ScopedLock lock( &m_mutex );
+    if (m_format == BGZF && slot.error.empty() && slot.out_size)
+    {
+        slot.state = READY;
+        m_work.push( slot_idx );
+    }
+    else
+        slot.state = DONE;
+
+    ++m_head;
+    m_cond.broadcast();
+    return more;
+}
+
+// read and inflate the next slot on the consumer's side, in builds without threads
+//
+void ParallelGzipReader::fill_next_synchronous()
+{
+    Slot& slot = m_slots[ m_head % m_slots.size() ];
+
+    if (fill_next() == false)
+        m_input_done = true;
+
+    if (slot.state == READY)
+    {
+        m_work.pop();
+
+        BlockInflater inflater;
+        if (const char* error = inflate_bgzf_blocks( inflater, &slot.in[0], slot.blocks, slot.outputs, &slot.out[0] ))
+            slot.error = error;
+
+        slot.state = DONE;
+    }
+}
+
+// the loop run by the input thread
+//
+void ParallelGzipReader::input_loop()
+{
+    while (1)
+    {
+        const Slot& slot = m_slots[ m_head % m_slots.size() ];
+
+        // wait for the slot to be released by the consumer
+        {
+            ScopedLock lock( &m_mutex );
+            while (slot.state != FREE && m_stop == false)
+                m_cond.wait( &m_mutex );
+
+            if (m_stop)
+                break;
+        }
+
+        if (fill_next() == false)
+            break;
+    }
+
+    ScopedLock lock( &m_mutex );
+    m_input_done = true;
+    m_cond.broadcast();
+}
+
+// the loop run by the decompression threads
+//
+void ParallelGzipReader::decompression_loop()
+{
+    BlockInflater inflater;
+
+    m_mutex.lock();
+    while (1)
+    {
+        while (m_work.empty() && m_stop == false)
+            m_cond.wait( &m_mutex );
+
+        if (m_work.empty())
+            break; // stopped and drained
+
+        const uint32 slot_idx = m_work.front();
+        m_work.pop();
+
+        Slot& slot = m_slots[ slot_idx ];
+        slot.state = BUSY;
+        m_mutex.unlock();
+
+        // inflate all blocks in the slot
+        if (const char* error = inflate_bgzf_blocks( inflater, &slot.in[0], slot.blocks, slot.outputs, &slot.out[0] ))
+            slot.error = error;
+
+        m_mutex.lock();
+        slot.state = DONE;
+        m_cond.broadcast();
+    }
+    m_mutex.unlock();
+}
+
+} // namespace io
+} // namespace nvbio
@@ -0,0 +1,226 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/threads.h>
+#include <zlib/zlib.h>
+#include <vector>
+#include <queue>
+#include <string>
+#include <stdio.h>
+
+namespace nvbio {
+namespace io {
+
+///@addtogroup IO
+///@{
+
+///
+/// A gzip file reader decompressing the input ahead of the consumer on a pool of threads.
+///\par
+/// BGZF files (i.e. the blocked gzip format used by BAM and by most .fastq.gz files written
+/// with bgzip) are detected on open: their compressed blocks are read sequentially by an input
+/// thread, batched into slots and inflated concurrently by the worker threads, while the consumer
+/// receives the decompressed data in the original order.
+/// Any other file - be it plain gzip, which can't be inflated in parallel, or uncompressed -
+/// is read through zlib on the input thread alone, which still pipelines inflation with
+/// parsing.
+///\par
+/// Slots are staged in a ring whose total size is bounded by a configurable read-ahead budget.
+/// In builds without threads (see threads_enabled()) each slot is read and inflated on demand
+/// by the consumer itself.
+/// When compiled with NVBIO_LIBDEFLATE, BGZF blocks are inflated with libdeflate rather than zlib.
+///
+struct ParallelGzipReader
+{
+    /// the input format
+    ///
+    enum Format { NONE = 0, GZIP = 1, BGZF = 2 };
+
+    /// constructor
+    ///
+    ParallelGzipReader();
+
+    /// destructor
+    ///
+    ~ParallelGzipReader();
+
+    /// open a file, spawning the input and decompression threads
+    ///
+    /// \param file_name        the input file
+    /// \param n_threads        the number of decompression threads used for BGZF inputs (0 = all available cores)
+    /// \param max_memory       the maximum amount of memory used for staging decompressed data, in bytes
+    ///
+    /// \return                 true on success
+    ///
+    bool open(const char* file_name, const uint32 n_threads = 0, const uint64 max_memory = 64u*1024u*1024u);
+
+    /// close the file, stopping all threads
+    ///
+    void close();
+
+    /// read up to n_bytes of decompressed data, blocking until they are available
+    ///
+    /// \return                 the number of bytes read, which is less than n_bytes only
+    ///                         at the end of the file, or -1 on errors
+    ///
+    int32 read(void* dst, const uint32 n_bytes);
+
+    /// skip n_bytes of decompressed data
+    ///
+    /// \return                 the number of bytes skipped, or -1 on errors
+    ///
+    int64 skip(const uint64 n_bytes);
+
+    /// rewind the file
+    ///
+    bool rewind();
+
+    /// return the offset of the next byte to be read in the decompressed stream
+    ///
+    uint64 tell() const { return m_offset; }
+
+    /// return whether a read has hit the end of the file
+    ///
+    bool eof() const { return m_eof; }
+
+    /// return whether the file is open and no error has occurred
+    ///
+    bool is_ok() const { return m_format != NONE && m_error.empty(); }
+
+    /// return the last error message
+    ///
+    const char* error() const { return m_error.c_str(); }
+
+    /// return the input format
+    ///
+    Format format() const { return m_format; }
+
+    /// return the number of decompression threads
+    ///
+    uint32 n_threads() const { return uint32( m_threads.size() ); }
+
+private:
+    enum SlotState { FREE = 0, READY = 1, BUSY = 2, DONE = 3 };
+
+    struct Slot
+    {
+        Slot() : out_size(0), state(FREE) {}
+
+        std::vector<uint8>  in;         // the compressed BGZF blocks
+        std::vector<uint32> blocks;     // the offsets of the compressed blocks in the input buffer
+        std::vector<uint32> outputs;    // the offsets of the decompressed blocks in the output buffer
+        std::vector<uint8>  out;        // the decompressed data
+        uint32              out_size;
+        uint32              state;
+        std::string         error;      // the error encountered while filling this slot
+    };
+
+    struct InputThread : public Thread<InputThread>
+    {
+        InputThread() : reader(NULL) {}
+
+        void run() { reader->input_loop(); }
+
+        ParallelGzipReader* reader;
+    };
+
+    struct DecompressionThread : public Thread<DecompressionThread>
+    {
+        DecompressionThread() : reader(NULL) {}
+
+        void run() { reader->decompression_loop(); }
+
+        ParallelGzipReader* reader;
+    };
+
+    /// spawn the threads
+    ///
+    void start();
+
+    /// stop all threads
+    ///
+    void stop();
+
+    /// the loop run by the input thread
+    ///
+    void input_loop();
+
+    /// the loop run by the decompression threads
+    ///
+    void decompression_loop();
+
+    /// read the next few BGZF blocks into a slot
+    ///
+    bool fill_bgzf(Slot& slot);
+
+    /// read the next chunk of a gzip file into a slot
+    ///
+    bool fill_gzip(Slot& slot);
+
+    /// read the next slot and hand it over to the decompression threads, or directly
+    /// to the consumer
+    ///
+    bool fill_next();
+
+    /// read and inflate the next slot on the consumer's side, in builds without threads
+    ///
+    void fill_next_synchronous();
+
+    /// consume up to n_bytes of decompressed data, copying them to dst if not NULL
+    ///
+    int64 consume(uint8* dst, const uint64 n_bytes);
+
+    std::string                         m_file_name;
+    Format                              m_format;
+    FILE*                               m_file;
+    gzFile                              m_gz_file;
+    uint32                              m_n_threads;
+    bool                                m_synchronous;
+    std::vector<Slot>                   m_slots;
+    std::queue<uint32>                  m_work;
+    uint64                              m_head;
+    uint64                              m_tail;
+    uint32                              m_tail_pos;
+    bool                                m_stop;
+    bool                                m_input_done;
+    bool                                m_eof;
+    uint64                              m_offset;
+    std::string                         m_error;
+    Mutex                               m_mutex;
+    Condition                           m_cond;
+    std::vector<DecompressionThread>    m_threads;
+    InputThread                         m_input_thread;
+};
+
+///@} // IO
+
+} // namespace io
+} // namespace nvbio
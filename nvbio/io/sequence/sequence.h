@@ -29,6 +29,7 @@
 
 #include <nvbio/strings/alphabet.h>
 #include <nvbio/io/sequence/sequence_traits.h>
+#include <nvbio/io/sequence/sequence_qualities.h>
 #include <nvbio/basic/packedstream.h>
 #include <nvbio/basic/vector_view.h>
 #include <nvbio/basic/vector.h>
@@ -58,8 +59,11 @@ namespace io {
 /// - io::SequenceDataMMAP
 /// - io::SequenceDataMMAPServer
 /// - io::SequenceDataInputStream
+/// - io::PairedSequenceDataInputStream
+/// - io::AsyncSequenceDataStream
 /// - io::SequenceDataOutputStream
 /// - io::open_sequence_file()
+/// - io::open_paired_sequence_files()
 /// - io::load_sequence_file()
 /// - io::map_sequence_file()
 ///\par
@@ -114,6 +118,13 @@ namespace io {
 ///     printf("\n");
 /// }
 ///\endcode
+///\par
+/// Quality scores can optionally be binned on input, trading precision for memory: when a SequenceDataHost
+/// is given a QualityBins scheme with SequenceDataStorage::set_quality_bins() (e.g. QualityBins::illumina()),
+/// each batch loaded into it stores 4-bit bin indices, two per byte. These can be read back as the scores
+/// their bins represent through a SequenceDataAccess with BINNED_QUALITIES set, e.g.
+/// SequenceDataAccess<DNA_N,ConstSequenceDataView,true>, or expanded in place with expand_qualities(),
+/// after which the plain SequenceDataAccess applies.
 ///
 ///\section SequenceDataStreamSection Sequence Data Streams
 ///\par
@@ -138,6 +149,15 @@ namespace io {
 ///     ...
 /// }
 ///\endcode
+///\par
+/// Read sets which are streamed through over and over again can be converted once to a binary
+/// read cache (.nvr), either with nvExtractReads or by writing them to a SequenceDataOutputStream
+/// opened on a .nvr file: io::open_sequence_file() maps such caches and hands out their batches
+/// without any text parsing.
+///\par
+/// In order to overlap reading with processing, any stream can be wrapped in an AsyncSequenceDataStream
+/// (nvbio/io/sequence/sequence_async.h), which reads batches ahead on a background thread into a pool of
+/// buffers bounded by a host memory budget.
 ///
 ///\section SequenceDataTechnicalSection Technical Documentation
 ///\par
@@ -219,12 +239,13 @@ struct SequenceDataInfo
     NVBIO_HOST_DEVICE NVBIO_FORCEINLINE uint32           size()             const { return m_n_seqs; }
     NVBIO_HOST_DEVICE NVBIO_FORCEINLINE uint32           bps()              const { return m_sequence_stream_len; }
     NVBIO_HOST_DEVICE NVBIO_FORCEINLINE uint32           words()            const { return m_sequence_stream_words; }
-    NVBIO_HOST_DEVICE NVBIO_FORCEINLINE uint32           qs()               const { return m_has_qualities ? m_sequence_stream_len : 0u; }
+    NVBIO_HOST_DEVICE NVBIO_FORCEINLINE uint32           qs()               const { return m_has_qualities ? m_quality_bins.storage_size( m_sequence_stream_len ) : 0u; }
     NVBIO_HOST_DEVICE NVBIO_FORCEINLINE uint32           name_stream_len()  const { return m_name_stream_len; }
     NVBIO_HOST_DEVICE NVBIO_FORCEINLINE bool             has_qualities()    const { return m_has_qualities ? true : false; }
     NVBIO_HOST_DEVICE NVBIO_FORCEINLINE uint32           max_sequence_len() const { return m_max_sequence_len; }
     NVBIO_HOST_DEVICE NVBIO_FORCEINLINE uint32           min_sequence_len() const { return m_min_sequence_len; }
     NVBIO_HOST_DEVICE NVBIO_FORCEINLINE uint32           avg_sequence_len() const { return m_avg_sequence_len; }
+    NVBIO_HOST_DEVICE NVBIO_FORCEINLINE const QualityBins& quality_bins()   const { return m_quality_bins; }
 
     Alphabet            m_alphabet;                 ///< the alphabet
     uint32              m_n_seqs;                   ///< number of reads in this struct
@@ -236,6 +257,8 @@ struct SequenceDataInfo
     uint32              m_min_sequence_len;         ///< statistics on the reads
     uint32              m_max_sequence_len;         ///< statistics on the reads
     uint32              m_avg_sequence_len;         ///< statistics on the reads
+
+    QualityBins         m_quality_bins;             ///< the binning scheme used to store the qualities
 };
 
 /// comparison operator for SequenceDataInfo
@@ -254,7 +277,8 @@ bool operator== (
         op1.m_has_qualities         == op2.m_has_qualities          &&
         op1.m_min_sequence_len      == op2.m_min_sequence_len       &&
         op1.m_max_sequence_len      == op2.m_max_sequence_len       &&
-        op1.m_avg_sequence_len      == op2.m_avg_sequence_len;
+        op1.m_avg_sequence_len      == op2.m_avg_sequence_len       &&
+        op1.m_quality_bins          == op2.m_quality_bins;
 }
 
 /// comparison operator for SequenceDataInfo
@@ -517,7 +541,7 @@ struct SequenceDataStorage : public SequenceData
         m_name_vec.resize( m_name_stream_len );
         m_name_index_vec.resize( m_n_seqs + 1u );
         if (m_has_qualities)
-            m_qual_vec.resize( m_sequence_stream_len );
+            m_qual_vec.resize( qs() );
 
         // and copy the contents
         thrust::copy( other.sequence_storage(), other.sequence_storage() + m_sequence_stream_words, m_sequence_vec.begin() );
@@ -525,7 +549,7 @@ struct SequenceDataStorage : public SequenceData
         thrust::copy( other.name_stream(),      other.name_stream()      + m_name_stream_len,       m_name_vec.begin() );
         thrust::copy( other.name_index(),       other.name_index()       + m_n_seqs + 1u,           m_name_index_vec.begin() );
         if (m_has_qualities)
-            thrust::copy( other.qual_stream(),  other.qual_stream()      + m_sequence_stream_len,   m_qual_vec.begin() );
+            thrust::copy( other.qual_stream(),  other.qual_stream()      + qs(),                    m_qual_vec.begin() );
 
         return *this;
     }
@@ -565,11 +589,22 @@ struct SequenceDataStorage : public SequenceData
 
         m_sequence_index_vec.reserve( n_seqs+1 );
         m_sequence_vec.reserve( n_bps / bps_per_word );
-        m_qual_vec.reserve( n_bps );
-        m_name_index_vec.reserve( AVG_NAME_LENGTH * n_seqs );
+        m_qual_vec.reserve( n_bps );   // the encoder writes plain qualities before binning them
+        m_name_vec.reserve( AVG_NAME_LENGTH * n_seqs );
         m_name_index_vec.reserve( n_seqs+1 );
     }
 
+    /// set the binning scheme used to store the qualities of all batches subsequently loaded
+    /// into this object through a sequence encoder (e.g. with io::next() or io::append());
+    /// QualityBins() restores plain qualities.
+    /// The scheme the current contents are stored with is given by quality_bins().
+    ///
+    void set_quality_bins(const QualityBins& bins) { m_quality_binning = bins; }
+
+    /// return the binning scheme used to store the qualities of the batches loaded next
+    ///
+    const QualityBins& quality_binning() const { return m_quality_binning; }
+
     NVBIO_FORCEINLINE index_iterator                  name_index()                { return m_name_index_vec.begin();  }
     NVBIO_FORCEINLINE index_iterator                  sequence_index()            { return m_sequence_index_vec.begin();  }
     NVBIO_FORCEINLINE name_storage_iterator           name_stream()               { return m_name_vec.begin(); }
@@ -587,6 +622,7 @@ struct SequenceDataStorage : public SequenceData
     nvbio::vector<system_tag,char>   m_qual_vec;
     nvbio::vector<system_tag,char>   m_name_vec;
     nvbio::vector<system_tag,uint32> m_name_index_vec;
+    QualityBins                      m_quality_binning;
 };
 
 typedef SequenceDataStorage<host_tag>   SequenceDataHost;           ///< a SequenceData object stored in host memory
@@ -605,7 +641,8 @@ struct SequenceDataInputStream
     ///
     virtual int next(struct SequenceDataEncoder* encoder, const uint32 batch_size, const uint32 batch_bps = uint32(-1)) = 0;
 
-    /// is the stream ok?
+    /// is the stream ok? i.e. has it been opened, with no error occurred since:
+    /// reaching the end of the stream is not an error
     ///
     virtual bool is_ok() = 0;
 
@@ -633,6 +670,12 @@ int append(const Alphabet alphabet, SequenceDataHost* data, SequenceDataInputStr
 ///
 int skip(SequenceDataInputStream* stream, const uint32 batch_size);
 
+/// expand the qualities of a host sequence data object stored with a QualityBins scheme back to
+/// plain Phred scores, i.e. to the scores represented by their bins, so that they can be read
+/// through a plain SequenceDataAccess; plain qualities are left untouched
+///
+void expand_qualities(SequenceDataHost* data);
+
 ///\relates SequenceDataInputStream
 /// factory method to open a read file
 ///
@@ -645,6 +688,23 @@ int skip(SequenceDataInputStream* stream, const uint32 batch_size);
 ///                             For example, passing FORWARD | REVERSE_COMPLEMENT
 ///                             will result in a stream containing BOTH the forward
 ///                             and reverse-complemented strands.
+/// \param trim3                number of bases to trim from the 3' end of each read
+/// \param trim5                number of bases to trim from the 5' end of each read
+/// \param n_threads            number of threads used to parse FASTQ and FASTA files:
+///                             1 selects the serial parsers, while any other value reads
+///                             the file in large blocks which are split and parsed
+///                             concurrently, 0 meaning all available OpenMP threads.
+///                             Files which can't be parsed this way (e.g. FASTQ files with
+///                             multi-line records) fall back to the serial parsers.
+///                             BAM and CRAM files are decompressed and decoded with the same
+///                             number of threads.
+/// \param skip_flags           records of SAM, BAM and CRAM files having any of these SAM flags set
+///                             are skipped; by default, secondary alignments (0x100)
+/// \param reference_name       the FASTA reference CRAM files have been compressed against;
+///                             a .pac archive is accepted too, but as it doesn't retain ambiguous
+///                             bases the reference MD5 checks are then disabled (see SequenceDataFile_CRAM).
+///                             If NULL, htslib looks it up through the REF_PATH and REF_CACHE
+///                             environment variables
 ///
 SequenceDataInputStream* open_sequence_file(
     const char*              sequence_file_name,
@@ -653,7 +713,82 @@ SequenceDataInputStream* open_sequence_file(
     const uint32             max_sequence_len = uint32(-1),
     const SequenceEncoding   flags            = FORWARD,
     const uint32             trim3            = 0,
-    const uint32             trim5            = 0);
+    const uint32             trim5            = 0,
+    const uint32             n_threads        = 1,
+    const uint32             skip_flags       = 0x100,
+    const char*              reference_name   = NULL);
+
+///
+/// A stream of paired-end SequenceData, returning mate-aligned batches:
+/// the i-th sequence of the first batch is the mate of the i-th sequence of the second.
+///
+struct PairedSequenceDataInputStream
+{
+    /// virtual destructor
+    ///
+    virtual ~PairedSequenceDataInputStream() {}
+
+    /// next batch of pairs
+    ///
+    /// \param alphabet             the alphabet used to encode the sequence data
+    /// \param data1                the output batch of first mates
+    /// \param data2                the output batch of second mates
+    /// \param batch_size           maximum number of sequences in each of the two batches
+    /// \param batch_bps            maximum number of base pairs in the two batches together
+    /// \return                     the number of sequences in each of the two batches
+    ///
+    virtual int next(const Alphabet alphabet, SequenceDataHost* data1, SequenceDataHost* data2, const uint32 batch_size, const uint32 batch_bps = uint32(-1)) = 0;
+
+    /// is the stream ok? i.e. has it been opened, with no error occurred since:
+    /// reaching the end of the stream is not an error
+    ///
+    virtual bool is_ok() = 0;
+
+    /// rewind
+    ///
+    virtual bool rewind() = 0;
+};
+
+///\relates PairedSequenceDataInputStream
+/// utility method to get the next batch of pairs from a PairedSequenceDataInputStream
+///
+int next(const Alphabet alphabet, SequenceDataHost* data1, SequenceDataHost* data2, PairedSequenceDataInputStream* stream, const uint32 batch_size, const uint32 batch_bps = uint32(-1));
+
+///\relates PairedSequenceDataInputStream
+/// factory method to open a paired-end read file, or a pair of mate files.
+/// If the second file name is NULL, the first file is expected to be interleaved,
+/// i.e. each record is immediately followed by its mate; otherwise, the two files are
+/// read concurrently, each providing one of the mates.
+/// In both cases the names of the mates are checked to match, ignoring everything
+/// past the first whitespace as well as /1 and /2 suffixes.
+///
+/// \param sequence_file_name1  the interleaved file, or the file of first mates
+/// \param sequence_file_name2  the file of second mates, or NULL for interleaved input
+/// \param qualities            the encoding of the qualities
+/// \param max_seqs             maximum number of sequences to input for each mate
+/// \param max_sequence_len     maximum read length - reads will be truncated
+/// \param flags                a set of flags indicating which strands to encode
+///                             in the batch for each read
+/// \param trim3                number of bases to trim from the 3' end of each read
+/// \param trim5                number of bases to trim from the 5' end of each read
+/// \param n_threads            number of threads used to parse the input, as in open_sequence_file();
+///                             with two files, the threads are split among them
+/// \param skip_flags           records of SAM, BAM and CRAM files having any of these SAM flags set
+///                             are skipped
+/// \param reference_name       the reference CRAM files have been compressed against
+///
+PairedSequenceDataInputStream* open_paired_sequence_files(
+    const char*              sequence_file_name1,
+    const char*              sequence_file_name2,
+    const QualityEncoding    qualities        = Phred33,
+    const uint32             max_seqs         = uint32(-1),
+    const uint32             max_sequence_len = uint32(-1),
+    const SequenceEncoding   flags            = FORWARD,
+    const uint32             trim3            = 0,
+    const uint32             trim5            = 0,
+    const uint32             n_threads        = 1,
+    const uint32             skip_flags       = 0x100,
+    const char*              reference_name   = NULL);
 
 ///\relates SequenceDataHost
 /// load a sequence file
@@ -707,7 +842,8 @@ struct SequenceDataOutputStream
 /// factory method to open a read file for writing
 ///
 /// \param sequence_file_name   the file to open
-/// \param compression          compression options
+/// \param compression          compression options; for .nvr read caches, the presence of
+///                             the character 'b' requests binning the qualities in 8 levels
 ///
 SequenceDataOutputStream* open_output_sequence_file(
     const char* sequence_file_name,
@@ -47,7 +47,10 @@ namespace io {
 /// An interface class to access a referenced sequence data object.
 ///\par
 /// This class is templated over the a SequenceDataT type which needs to provide the
-/// core iterators to access itself
+/// core iterators to access itself.
+/// Whether the qualities are stored with a QualityBins scheme is chosen at compile-time:
+/// plain qualities are read directly through the storage iterator, while binned ones
+/// are decoded by a BinnedQualityStream.
 ///
 /// \tparam SEQUENCE_ALPHABET_T         the alphabet used to access the data
 /// \tparam SequenceDataT               the type of the underlying sequence data;
@@ -73,10 +76,13 @@ namespace io {
 ///     NVBIO_HOST_DEVICE const_qual_storage_iterator     qual_stream()         const;
 /// };
 ///\endcode
+/// \tparam BINNED_QUALITIES            whether the qualities are binned, i.e. whether the data has
+///                                     been loaded with a non-plain QualityBins scheme
 ///
 template <
     Alphabet  SEQUENCE_ALPHABET_T,
-    typename  SequenceDataT = ConstSequenceDataView>
+    typename  SequenceDataT     = ConstSequenceDataView,
+    bool      BINNED_QUALITIES  = false>
 struct SequenceDataAccess
 {
     static const Alphabet SEQUENCE_ALPHABET = SEQUENCE_ALPHABET_T;                                                        ///< alphabet type
@@ -98,8 +104,11 @@ struct SequenceDataAccess
     typedef PackedStream<
         sequence_storage_iterator,uint8,SEQUENCE_BITS,SEQUENCE_BIG_ENDIAN>            sequence_stream_type;         ///< the packed read-stream type
 
+    typedef typename QualityStreamSelector<
+        BINNED_QUALITIES,qual_storage_iterator>::type                                 qual_stream_type;             ///< the (decoded) quality-stream type
+
     typedef vector_view<sequence_stream_type>                                         sequence_string;              ///< the read string type
-    typedef vector_view<qual_storage_iterator>                                        qual_string;                  ///< the quality string type
+    typedef vector_view<qual_stream_type>                                             qual_string;                  ///< the quality string type
     typedef vector_view<name_storage_iterator>                                        name_string;                  ///< the name string type
 
     typedef ConcatenatedStringSet<
@@ -107,7 +116,7 @@ struct SequenceDataAccess
         index_iterator>                                                         sequence_string_set_type;   ///< string-set type
 
     typedef ConcatenatedStringSet<
-        qual_storage_iterator,
+        qual_stream_type,
         index_iterator>                                                         qual_string_set_type;   ///< quality string-set type
 
     typedef ConcatenatedStringSet<
@@ -126,7 +135,8 @@ struct SequenceDataAccess
     NVBIO_HOST_DEVICE NVBIO_FORCEINLINE index_iterator                  sequence_index()            const { return m_data.sequence_index();  }
     NVBIO_HOST_DEVICE NVBIO_FORCEINLINE name_storage_iterator           name_stream()               const { return m_data.name_stream(); }
     NVBIO_HOST_DEVICE NVBIO_FORCEINLINE sequence_storage_iterator       sequence_storage()          const { return m_data.sequence_storage(); }
-    NVBIO_HOST_DEVICE NVBIO_FORCEINLINE qual_storage_iterator           qual_stream()               const { return m_data.qual_stream(); }
+    NVBIO_HOST_DEVICE NVBIO_FORCEINLINE qual_storage_iterator           qual_storage()              const { return m_data.qual_stream(); }
+    NVBIO_HOST_DEVICE NVBIO_FORCEINLINE const QualityBins&              quality_bins()              const { return m_data.quality_bins(); }
 
     /// constructor
     ///
@@ -145,6 +155,16 @@ struct SequenceDataAccess
     ///
     NVBIO_HOST_DEVICE NVBIO_FORCEINLINE sequence_stream_type sequence_stream() const { return sequence_stream_type( sequence_storage() ); }
 
+    /// return a quality stream object, decoding binned qualities if BINNED_QUALITIES is set
+    ///
+    NVBIO_HOST_DEVICE NVBIO_FORCEINLINE qual_stream_type qual_stream() const
+    {
+      #if !defined(NVBIO_DEVICE_COMPILATION) || defined(NVBIO_CUDA_DEBUG)
+        assert( m_data.quality_bins().is_plain() != BINNED_QUALITIES || m_data.has_qualities() == false );
+      #endif
+        return QualityStreamSelector<BINNED_QUALITIES,qual_storage_iterator>::make( qual_storage(), quality_bins() );
+    }
+
     /// return the a string-set view of this set of reads
     ///
     NVBIO_HOST_DEVICE NVBIO_FORCEINLINE sequence_string_set_type sequence_string_set() const
@@ -213,7 +233,8 @@ SequenceDataAccess<ALPHABET,SequenceDataT> make_access(const SequenceDataT& data
 /// An interface class to access a referenced sequence data object.
 ///
 /// This class is templated over the a SequenceDataT type which needs to provide the
-/// core iterators to access itself
+/// core iterators to access itself.
+/// Qualities are exposed in their storage format, and hence must not be binned.
 ///
 /// \tparam SEQUENCE_ALPHABET_T         the alphabet used to access the data
 /// \tparam SequenceDataT               the type of the underlying sequence data
@@ -282,6 +303,7 @@ struct SequenceDataEdit
     {
       #if !defined(NVBIO_DEVICE_COMPILATION) || defined(NVBIO_CUDA_DEBUG)
         assert( m_data.m_alphabet == SEQUENCE_ALPHABET );
+        assert( m_data.quality_bins().is_plain() );     // binned qualities can't be edited in place
       #endif
     }
 
@@ -0,0 +1,425 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <nvbio/io/sequence/sequence_async.h>
+#include <nvbio/basic/console.h>
+#include <nvbio/basic/timer.h>
+#include <nvbio/basic/exceptions.h>
+
+#include <stdexcept>
+#include <new>
+
+namespace nvbio {
+namespace io {
+
+///@addtogroup IO
+///@{
+
+///@addtogroup SequenceIO
+///@{
+
+namespace { // anonymous namespace
+
+// return the host memory held by the vectors of a SequenceDataHost
+//
+inline uint64 footprint(const SequenceDataHost& data)
+{
+    return uint64( data.m_sequence_vec.capacity() )       * sizeof(uint32) +
+           uint64( data.m_sequence_index_vec.capacity() ) * sizeof(uint32) +
+           uint64( data.m_qual_vec.capacity() )           * sizeof(char) +
+           uint64( data.m_name_vec.capacity() )           * sizeof(char) +
+           uint64( data.m_name_index_vec.capacity() )     * sizeof(uint32);
+}
+
+// swap the contents of two SequenceDataHost objects, leaving their quality binning settings untouched
+//
+inline void swap_contents(SequenceDataHost& a, SequenceDataHost& b)
+{
+    const SequenceDataInfo info = a;
+    a.SequenceDataInfo::operator=( b );
+    b.SequenceDataInfo::operator=( info );
+
+    a.m_sequence_vec.swap( b.m_sequence_vec );
+    a.m_sequence_index_vec.swap( b.m_sequence_index_vec );
+    a.m_qual_vec.swap( b.m_qual_vec );
+    a.m_name_vec.swap( b.m_name_vec );
+    a.m_name_index_vec.swap( b.m_name_index_vec );
+}
+
+} // anonymous namespace
+
+// constructor
+//
+AsyncSequenceDataStream::AsyncSequenceDataStream(
+    SequenceDataInputStream*    stream,
+    const Alphabet              alphabet,
+    const uint32                batch_size,
+    const uint32                batch_bps,
+    const uint64                memory_budget,
+    const QualityBins&          quality_bins) :
+    m_stream( stream ),
+    m_paired_stream( NULL ),
+    m_alphabet( alphabet ),
+    m_batch_size( batch_size ),
+    m_batch_bps( batch_bps ),
+    m_memory_budget( memory_budget ),
+    m_quality_bins( quality_bins ),
+    m_bytes( 0 ),
+    m_max_batch_bytes( 0 ),
+    m_reads( 0 ),
+    m_done( false ),
+    m_stop( false ),
+    m_error( false )
+{
+    create();
+}
+
+// constructor
+//
+AsyncSequenceDataStream::AsyncSequenceDataStream(
+    PairedSequenceDataInputStream*  stream,
+    const Alphabet                  alphabet,
+    const uint32                    batch_size,
+    const uint32                    batch_bps,
+    const uint64                    memory_budget,
+    const QualityBins&              quality_bins) :
+    m_stream( NULL ),
+    m_paired_stream( stream ),
+    m_alphabet( alphabet ),
+    m_batch_size( batch_size ),
+    m_batch_bps( batch_bps ),
+    m_memory_budget( memory_budget ),
+    m_quality_bins( quality_bins ),
+    m_bytes( 0 ),
+    m_max_batch_bytes( 0 ),
+    m_reads( 0 ),
+    m_done( false ),
+    m_stop( false ),
+    m_error( false )
+{
+    create();
+}
+
+// destructor
+//
+AsyncSequenceDataStream::~AsyncSequenceDataStream()
+{
+    // ask the background thread to stop, waking it up if it's waiting for a free buffer
+    {
+        ScopedLock lock( &m_mutex );
+        m_stop = true;
+        m_free_cond.broadcast();
+    }
+    join();
+
+    for (uint32 i = 0; i < m_buffers.size(); ++i)
+        delete m_buffers[i];
+}
+
+// the background thread loop
+//
+void AsyncSequenceDataStream::run()
+{
+    log_debug( stderr, "  starting background read-ahead thread\n" );
+
+    bool error = false;
+    try
+    {
+        while (1u)
+        {
+            Batch* batch;
+            {
+                ScopedLock lock( &m_mutex );
+                batch = acquire();
+            }
+            if (batch == NULL)
+                break;
+
+            Timer timer;
+            timer.start();
+
+            const int ret = m_paired_stream ?
+                io::next( m_alphabet, &batch->data[0], &batch->data[1], m_paired_stream, m_batch_size, m_batch_bps ) :
+                io::next( m_alphabet, &batch->data[0], m_stream, m_batch_size, m_batch_bps );
+
+            timer.stop();
+
+            ScopedLock lock( &m_mutex );
+
+            if (ret <= 0)
+            {
+                // streams report parsing and I/O errors by ending prematurely: tell them apart
+                m_free.push_back( batch );
+                error = m_paired_stream ? (m_paired_stream->is_ok() == false) : (m_stream->is_ok() == false);
+                break;
+            }
+
+            batch->offset    = m_reads;
+            batch->read_time = timer.seconds();
+            update_bytes( batch );
+
+            m_reads += batch->data[0].size();
+
+            m_stats.batches++;
+            m_stats.reads     += batch->data[0].size();
+            m_stats.bps       += batch->data[0].bps() + (m_paired_stream ? batch->data[1].bps() : 0u);
+            m_stats.read_time += timer.seconds();
+
+            m_ready.push_back( batch );
+            m_ready_cond.signal();
+        }
+    }
+    catch (nvbio::bad_alloc e)
+    {
+        log_error(stderr, "caught a nvbio::bad_alloc exception while reading:\n");
+        log_error(stderr, "  %s\n", e.what());
+        error = true;
+    }
+    catch (nvbio::logic_error e)
+    {
+        log_error(stderr, "caught a nvbio::logic_error exception while reading:\n");
+        log_error(stderr, "  %s\n", e.what());
+        error = true;
+    }
+    catch (nvbio::runtime_error e)
+    {
+        log_error(stderr, "caught a nvbio::runtime_error exception while reading:\n");
+        log_error(stderr, "  %s\n", e.what());
+        error = true;
+    }
+    catch (std::exception& e)
+    {
+        log_error(stderr, "caught a std::exception while reading:\n");
+        log_error(stderr, "  %s\n", e.what());
+        error = true;
+    }
+    catch (...)
+    {
+        log_error(stderr, "caught an unknown exception while reading!\n");
+        error = true;
+    }
+
+    // signal the end of the stream to all waiting consumers
+    ScopedLock lock( &m_mutex );
+    m_done  = true;
+    m_error = error;
+    m_ready_cond.broadcast();
+}
+
+// get a free buffer, waiting for one to be released if the budget is exhausted
+//
+AsyncSequenceDataStream::Batch* AsyncSequenceDataStream::acquire()
+{
+    bool stalled = false;
+
+    Timer timer;
+
+    while (m_stop == false)
+    {
+        Batch* batch = NULL;
+
+        if (m_free.empty() == false)
+        {
+            batch = m_free.back();
+            m_free.pop_back();
+        }
+        else if (m_buffers.size() < 2u || m_bytes + m_max_batch_bytes <= m_memory_budget)
+        {
+            batch = new Batch;
+            batch->offset    = 0;
+            batch->read_time = 0.0f;
+            batch->bytes     = 0;
+            batch->data[0].set_quality_bins( m_quality_bins );
+            batch->data[1].set_quality_bins( m_quality_bins );
+
+            m_buffers.push_back( batch );
+            m_stats.buffers = uint32( m_buffers.size() );
+        }
+
+        if (batch)
+        {
+            if (stalled)
+            {
+                timer.stop();
+                m_stats.producer_stall_time += timer.seconds();
+            }
+            return batch;
+        }
+
+        // all buffers are in use and the budget is exhausted: wait for the consumers
+        if (stalled == false)
+        {
+            stalled = true;
+            m_stats.producer_stalls++;
+            timer.start();
+        }
+        m_free_cond.wait( &m_mutex );
+    }
+    return NULL;
+}
+
+// pop the next ready batch, or return NULL if none is ready
+//
+AsyncSequenceDataStream::Batch* AsyncSequenceDataStream::pop_ready()
+{
+    if (m_ready.empty())
+        return NULL;
+
+    Batch* batch = m_ready.front();
+    m_ready.pop_front();
+    return batch;
+}
+
+// update the memory footprint of a batch
+//
+void AsyncSequenceDataStream::update_bytes(Batch* batch)
+{
+    const uint64 bytes = footprint( batch->data[0] ) + footprint( batch->data[1] );
+
+    m_bytes = m_bytes - batch->bytes + bytes;
+    batch->bytes = bytes;
+
+    m_max_batch_bytes  = nvbio::max( m_max_batch_bytes, bytes );
+    m_stats.peak_bytes = nvbio::max( m_stats.peak_bytes, m_bytes );
+}
+
+// get the next batch, waiting for it to be read if needed
+//
+AsyncSequenceDataStream::Batch* AsyncSequenceDataStream::next()
+{
+    ScopedLock lock( &m_mutex );
+
+    if (m_ready.empty() && m_done == false)
+    {
+        m_stats.consumer_stalls++;
+
+        Timer timer;
+        timer.start();
+
+        while (m_ready.empty() && m_done == false)
+            m_ready_cond.wait( &m_mutex );
+
+        timer.stop();
+        m_stats.consumer_stall_time += timer.seconds();
+    }
+    return pop_ready();
+}
+
+// get the next batch if it's already been read
+//
+AsyncSequenceDataStream::Batch* AsyncSequenceDataStream::try_next()
+{
+    ScopedLock lock( &m_mutex );
+    return pop_ready();
+}
+
+// release a batch
+//
+void AsyncSequenceDataStream::release(Batch* batch)
+{
+    ScopedLock lock( &m_mutex );
+    m_free.push_back( batch );
+    m_free_cond.signal();
+}
+
+// get the next batch, swapping its contents with the given object
+//
+uint32 AsyncSequenceDataStream::next(SequenceDataHost* data, uint64* offset)
+{
+    Batch* batch = next();
+    if (batch == NULL)
+    {
+        if (offset) *offset = m_reads;
+        data->SequenceDataInfo::operator=( SequenceDataInfo() );
+        return 0u;
+    }
+
+    swap_contents( *data, batch->data[0] );
+    if (offset) *offset = batch->offset;
+
+    // account for the buffers received in exchange before recycling them
+    ScopedLock lock( &m_mutex );
+    update_bytes( batch );
+    m_free.push_back( batch );
+    m_free_cond.signal();
+    return data->size();
+}
+
+// get the next batch of pairs, swapping its contents with the given objects
+//
+uint32 AsyncSequenceDataStream::next(SequenceDataHost* data1, SequenceDataHost* data2, uint64* offset)
+{
+    Batch* batch = next();
+    if (batch == NULL)
+    {
+        if (offset) *offset = m_reads;
+        data1->SequenceDataInfo::operator=( SequenceDataInfo() );
+        data2->SequenceDataInfo::operator=( SequenceDataInfo() );
+        return 0u;
+    }
+
+    swap_contents( *data1, batch->data[0] );
+    swap_contents( *data2, batch->data[1] );
+    if (offset) *offset = batch->offset;
+
+    // account for the buffers received in exchange before recycling them
+    ScopedLock lock( &m_mutex );
+    update_bytes( batch );
+    m_free.push_back( batch );
+    m_free_cond.signal();
+    return data1->size();
+}
+
+// return true if the end of the stream has been reached and all batches have been handed out
+//
+bool AsyncSequenceDataStream::done() const
+{
+    ScopedLock lock( &m_mutex );
+    return m_done && m_ready.empty();
+}
+
+// return true if reading failed
+//
+bool AsyncSequenceDataStream::error() const
+{
+    ScopedLock lock( &m_mutex );
+    return m_error;
+}
+
+// return a snapshot of the statistics
+//
+AsyncSequenceDataStats AsyncSequenceDataStream::stats() const
+{
+    ScopedLock lock( &m_mutex );
+    return m_stats;
+}
+
+///@} // SequenceIO
+///@} // IO
+
+} // namespace io
+} // namespace nvbio
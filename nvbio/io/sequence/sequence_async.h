@@ -0,0 +1,266 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <nvbio/io/sequence/sequence.h>
+#include <nvbio/basic/threads.h>
+
+#include <vector>
+#include <deque>
+
+namespace nvbio {
+namespace io {
+
+///@addtogroup IO
+///@{
+
+///@addtogroup SequenceIO
+///@{
+
+///
+/// The statistics collected by an AsyncSequenceDataStream
+///
+struct AsyncSequenceDataStats
+{
+    AsyncSequenceDataStats() :
+        batches( 0 ),
+        reads( 0 ),
+        bps( 0 ),
+        read_time( 0.0f ),
+        producer_stalls( 0 ),
+        producer_stall_time( 0.0f ),
+        consumer_stalls( 0 ),
+        consumer_stall_time( 0.0f ),
+        buffers( 0 ),
+        peak_bytes( 0 ) {}
+
+    uint32 batches;                 ///< number of batches read so far
+    uint64 reads;                   ///< number of reads read so far
+    uint64 bps;                     ///< number of base pairs read so far
+    float  read_time;               ///< time spent by the background thread reading batches
+    uint32 producer_stalls;         ///< number of times the background thread waited for a free buffer
+    float  producer_stall_time;     ///< time spent by the background thread waiting for a free buffer
+    uint32 consumer_stalls;         ///< number of times a consumer waited for a batch to be read
+    float  consumer_stall_time;     ///< time spent by the consumers waiting for batches to be read
+    uint32 buffers;                 ///< number of batch buffers allocated
+    uint64 peak_bytes;              ///< peak host memory held by the batch buffers
+};
+
+///
+/// A read-ahead wrapper around a SequenceDataInputStream or a PairedSequenceDataInputStream.
+///
+/// Batches are read on a background thread, started by the constructor, into a pool of buffers
+/// which is bounded by a host memory budget rather than by a buffer count: a new buffer is
+/// allocated only as long as the memory held by the pool, plus the footprint of the largest
+/// batch seen so far, fits within the budget. At least two buffers are always allocated, so
+/// that reading can overlap processing even if a single batch exceeds the budget.
+/// Once the pool is exhausted, the background thread waits for the consumers to release
+/// some of the batches they hold.
+///
+/// Batches are handed out in input order, and any number of consumer threads can fetch them
+/// concurrently, either through the blocking next() or through try_next().
+/// The stream must be destroyed before the wrapped stream is rewound or destroyed.
+///
+/// e.g.
+/// \code
+/// SharedPointer<io::SequenceDataStream> reads_file( io::open_sequence_file( "reads.fastq" ) );
+///
+/// io::AsyncSequenceDataStream reads( reads_file.get(), DNA_N, 256*1024, 256*1024*100 );
+///
+/// while (io::AsyncSequenceDataStream::Batch* batch = reads.next())
+/// {
+///     // process the reads
+///     do_something( batch->data[0] );
+///
+///     // hand the buffer back to the background thread
+///     reads.release( batch );
+/// }
+/// \endcode
+///
+class AsyncSequenceDataStream : private Thread<AsyncSequenceDataStream>
+{
+public:
+    static const uint64 DEFAULT_MEMORY_BUDGET = uint64(1) << 30;  ///< the default memory budget, 1GB
+
+    ///
+    /// a batch of reads, or of mate pairs
+    ///
+    struct Batch
+    {
+        SequenceDataHost data[2];       ///< the reads, or the first and second mates of paired-end streams
+        uint64           offset;        ///< the index of the first read of the batch in the input stream
+        float            read_time;     ///< the time spent reading the batch
+        uint64           bytes;         ///< the host memory held by the batch buffers
+    };
+
+    /// constructor
+    ///
+    /// \param stream           the input stream, which is not owned by this object
+    /// \param alphabet         the alphabet used to encode the reads
+    /// \param batch_size       maximum number of reads per batch
+    /// \param batch_bps        maximum number of base pairs per batch
+    /// \param memory_budget    maximum host memory held by the batch buffers
+    /// \param quality_bins     the binning scheme used to store the qualities
+    ///
+    AsyncSequenceDataStream(
+        SequenceDataInputStream*    stream,
+        const Alphabet              alphabet,
+        const uint32                batch_size,
+        const uint32                batch_bps     = uint32(-1),
+        const uint64                memory_budget = DEFAULT_MEMORY_BUDGET,
+        const QualityBins&          quality_bins  = QualityBins());
+
+    /// constructor
+    ///
+    /// \param stream           the paired-end input stream, which is not owned by this object
+    /// \param alphabet         the alphabet used to encode the reads
+    /// \param batch_size       maximum number of pairs per batch
+    /// \param batch_bps        maximum number of base pairs per batch, across both mates
+    /// \param memory_budget    maximum host memory held by the batch buffers
+    /// \param quality_bins     the binning scheme used to store the qualities
+    ///
+    AsyncSequenceDataStream(
+        PairedSequenceDataInputStream*  stream,
+        const Alphabet                  alphabet,
+        const uint32                    batch_size,
+        const uint32                    batch_bps     = uint32(-1),
+        const uint64                    memory_budget = DEFAULT_MEMORY_BUDGET,
+        const QualityBins&              quality_bins  = QualityBins());
+
+    /// destructor: stop the background thread and free all buffers
+    ///
+    ~AsyncSequenceDataStream();
+
+    /// get the next batch, waiting for it to be read if needed;
+    /// the batch must be handed back with release() once done with it
+    ///
+    /// \return                 the next batch, or NULL at the end of the stream
+    ///
+    Batch* next();
+
+    /// get the next batch if it's already been read;
+    /// the batch must be handed back with release() once done with it
+    ///
+    /// \return                 the next batch, or NULL if none is ready: use done()
+    ///                         to tell the end of the stream apart
+    ///
+    Batch* try_next();
+
+    /// release a batch, making its buffer available to the background thread
+    ///
+    void release(Batch* batch);
+
+    /// get the next batch, waiting for it to be read if needed, and swap its contents
+    /// with the given object: the buffers previously held by the object are recycled
+    ///
+    /// \param data             the output reads
+    /// \param offset           if not NULL, the index of the first read of the batch
+    /// \return                 the number of reads in the batch, or 0 at the end of the stream
+    ///
+    uint32 next(SequenceDataHost* data, uint64* offset = NULL);
+
+    /// get the next batch of pairs, waiting for it to be read if needed, and swap its
+    /// contents with the given objects: the buffers previously held by the objects are recycled
+    ///
+    /// \param data1            the output first mates
+    /// \param data2            the output second mates
+    /// \param offset           if not NULL, the index of the first pair of the batch
+    /// \return                 the number of pairs in the batch, or 0 at the end of the stream
+    ///
+    uint32 next(SequenceDataHost* data1, SequenceDataHost* data2, uint64* offset = NULL);
+
+    /// return true if the end of the stream has been reached and all batches have been handed out
+    ///
+    bool done() const;
+
+    /// return true if reading failed, i.e. if the wrapped stream threw an exception or
+    /// stopped while reporting an error through is_ok(): in this case the stream ends prematurely
+    ///
+    bool error() const;
+
+    /// return the maximum number of reads per batch
+    ///
+    uint32 batch_size() const { return m_batch_size; }
+
+    /// return a snapshot of the statistics
+    ///
+    AsyncSequenceDataStats stats() const;
+
+private:
+    friend class Thread<AsyncSequenceDataStream>;
+
+    // the background thread refers to this object, which can't hence be copied
+    AsyncSequenceDataStream(const AsyncSequenceDataStream&);
+    AsyncSequenceDataStream& operator=(const AsyncSequenceDataStream&);
+
+    // the background thread loop
+    void run();
+
+    // get a free buffer, waiting for one to be released if the budget is exhausted;
+    // return NULL if the thread has been asked to stop.
+    // NOTE: must be called with the mutex locked
+    Batch* acquire();
+
+    // pop the next ready batch, or return NULL if none is ready
+    // NOTE: must be called with the mutex locked
+    Batch* pop_ready();
+
+    // update the memory footprint of a batch
+    // NOTE: must be called with the mutex locked
+    void update_bytes(Batch* batch);
+
+    SequenceDataInputStream*        m_stream;
+    PairedSequenceDataInputStream*  m_paired_stream;
+    Alphabet                        m_alphabet;
+    uint32                          m_batch_size;
+    uint32                          m_batch_bps;
+    uint64                          m_memory_budget;
+    QualityBins                     m_quality_bins;
+
+    mutable Mutex                   m_mutex;
+    Condition                       m_ready_cond;
+    Condition                       m_free_cond;
+
+    std::vector<Batch*>             m_buffers;
+    std::vector<Batch*>             m_free;
+    std::deque<Batch*>              m_ready;
+    uint64                          m_bytes;
+    uint64                          m_max_batch_bytes;
+    uint64                          m_reads;
+
+    AsyncSequenceDataStats          m_stats;
+    bool                            m_done;
+    bool                            m_stop;
+    bool                            m_error;
+};
+
+///@} // SequenceIO
+///@} // IO
+
+} // namespace io
+} // namespace nvbio
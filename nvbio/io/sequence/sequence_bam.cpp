@@ -27,10 +27,14 @@
 
 #include <stdlib.h>
 #include <string.h>
-#include <zlib/zlib.h>
+#include <algorithm>
+
+#if defined(PLATFORM_X86) && defined(__SSSE3__)
+#include <tmmintrin.h>                              // SSSE3 intrinsics
+#endif
 
 #include <nvbio/basic/console.h>
-#include <nvbio/basic/packedstream.h>
+#include <nvbio/basic/omp.h>
 #include <nvbio/io/sequence/sequence_bam.h>
 #include <nvbio/io/sequence/sequence_sam.h>
 #include <nvbio/io/sequence/sequence_encoder.h>
@@ -49,11 +53,13 @@ namespace io {
 
 SequenceDataFile_BAM::SequenceDataFile_BAM(
     const char*             read_file_name,
-    const SequenceDataFile::Options& options)
-  : SequenceDataFile( options )
+    const SequenceDataFile::Options& options,
+    const uint32            n_threads)
+  : SequenceDataFile( options ),
+    m_n_threads( n_threads ? n_threads : uint32( omp_get_max_threads() ) ),
+    m_pending( false )
 {
-    fp = gzopen(read_file_name, "rb");
-    if (fp == NULL)
+    if (fp.open(read_file_name, m_n_threads) == false)
     {
         // this will cause init() to fail below
         log_error(stderr, "unable to open BAM file %s\n", read_file_name);
@@ -63,29 +69,27 @@ SequenceDataFile_BAM::SequenceDataFile_BAM(
     }
 }
 
+SequenceDataFile_BAM::SequenceDataFile_BAM(
+    const SequenceDataFile::Options& options,
+    const uint32            n_threads)
+  : SequenceDataFile( options ),
+    m_n_threads( n_threads ? n_threads : uint32( omp_get_max_threads() ) ),
+    m_pending( false )
+{}
+
 bool SequenceDataFile_BAM::readData(void *output, unsigned int len)
 {
-    unsigned int ret;
-
-    ret = gzread(fp, output, len);
-    if (ret > 0)
+    const int32 ret = fp.read(output, len);
+    if (ret == int32(len))
     {
         return true;
     } else {
-        // check for EOF separately; zlib will not always return Z_STREAM_END at EOF below
-        if (gzeof(fp))
+        // check for EOF separately
+        if (fp.is_ok())
         {
             m_file_state = FILE_EOF;
         } else {
-            // ask zlib what happened and inform the user
-            int err;
-            const char *msg;
-
-            msg = gzerror(fp, &err);
-            // we're making the assumption that we never see Z_STREAM_END here
-            assert(err != Z_STREAM_END);
-
-            log_error(stderr, "error processing BAM file: zlib error %d (%s)\n", err, msg);
+            log_error(stderr, "error processing BAM file: %s\n", fp.error());
             m_file_state = FILE_STREAM_ERROR;
         }
 
@@ -101,13 +105,13 @@ bool SequenceDataFile_BAM::readData(void *output, unsigned int len)
     }
 
 // skip bytes in fp
-// note that gzseek won't actually detect EOF, so we don't check return values here
+// note that truncated reads will be caught by the next GZREAD, so we don't check return values here
 #define GZFWD(bytes) \
-    gzseek(fp, (bytes), SEEK_CUR)
+    fp.skip(bytes)
 
 // skip a structure field in fp
 #define GZSKIP(field) \
-    gzseek(fp, sizeof(field), SEEK_CUR)
+    fp.skip(sizeof(field))
 
 bool SequenceDataFile_BAM::init(void)
 {
@@ -117,7 +121,7 @@ bool SequenceDataFile_BAM::init(void)
     BAM_header header;
     int c;
 
-    if (fp == NULL)
+    if (fp.is_ok() == false)
     {
         // file failed to open
         return false;
@@ -154,230 +158,319 @@ bool SequenceDataFile_BAM::init(void)
 
 namespace {
 
-// decode a BAM bp into ascii
-inline unsigned char decode_BAM_bp(uint8 bp)
+// fetch a little-endian 32-bit field from a (possibly unaligned) record
+inline uint32 load_field(const uint8* ptr)
 {
-    static const char table[] = "=ACMGRSVTWYHKDBN";
-
-    assert(bp < 16);
-    return table[bp];
+    uint32 r;
+    memcpy( &r, ptr, sizeof(uint32) );
+    return r;
 }
 
+// the ASCII symbols corresponding to the 4-bit BAM codes, and to their complements:
+// the codes are bitmasks of the bases they stand for, { A = 1, C = 2, G = 4, T = 8 },
+// and are complemented by reversing their bits
+const char BAM_bp_table[]    = "=ACMGRSVTWYHKDBN";
+const char BAM_rc_bp_table[] = "=TGKCYSBAWRDMHVN";
+
+// decode the 4-bit bases of a read into ASCII, possibly reverse-complementing them
+//
+template <bool RC>
+void decode_BAM_read(const uint8* bp, const uint32 len, uint8* out)
+{
+    const char* table = RC ? BAM_rc_bp_table : BAM_bp_table;
+
+    uint32 i = 0;
+
+  #if defined(PLATFORM_X86) && defined(__SSSE3__)
+    // unpack 16 bases at a time, high nibble first, and translate them with a byte shuffle
+    const __m128i lut     = _mm_loadu_si128( (const __m128i*)table );
+    const __m128i nibble  = _mm_set1_epi8( 0x0F );
+    const __m128i reverse = _mm_setr_epi8( 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 );
+
+    for (; i + 16u <= len; i += 16u)
+    {
+        const __m128i packed = _mm_loadl_epi64( (const __m128i*)( bp + i/2 ) );
+        const __m128i hi     = _mm_and_si128( _mm_srli_epi16( packed, 4 ), nibble );
+        const __m128i lo     = _mm_and_si128( packed, nibble );
+        const __m128i c      = _mm_shuffle_epi8( lut, _mm_unpacklo_epi8( hi, lo ) );
+
+        if (RC)
+            _mm_storeu_si128( (__m128i*)( out + len - i - 16u ), _mm_shuffle_epi8( c, reverse ) );
+        else
+            _mm_storeu_si128( (__m128i*)( out + i ), c );
+    }
+  #endif
+
+    for (; i < len; ++i)
+    {
+        const uint8 c = (i & 1u) ? (bp[i/2] & 15u) : (bp[i/2] >> 4);
+
+        out[ RC ? len - i - 1u : i ] = table[c];
+    }
 }
 
+} // anonymous namespace
+
 // rewind
 //
 bool SequenceDataFile_BAM::rewind()
 {
-    if (fp == NULL)
+    if (fp.is_ok() == false)
         return false;
 
-    gzrewind( fp );
+    fp.rewind();
 
+    m_pending    = false;
     m_file_state = FILE_OK;
     return init();
 }
 
-// grab the next chunk of reads from the file, up to max_reads
-int SequenceDataFile_BAM::nextChunk(SequenceDataEncoder *output, uint32 max_reads, uint32 max_bps)
+// read the next record in the record buffer, returning false on EOF or errors
+//
+bool SequenceDataFile_BAM::read_record(Record* record, uint32* flags)
 {
-    if (max_bps < SequenceDataFile::LONG_READ)
-        return 0;
-
-    // error code for gzread
-    static const int error = -1;
+    int32 block_size;
 
-    // small utility structure to keep track of data buffers and free them as appropriate
-    // (note the slightly evil initializer that sets all pointers to NULL)
-    struct data
+    const int32 n = fp.read( &block_size, sizeof(int32) );
+    if (n == 0 && fp.is_ok())
     {
-        char *read_name;
-        uint8 *encoded_read;
-        uint8 *decoded_read;
-        uint8 *quality;
-
-        ~data()
-        {
-            if (read_name)
-                free(read_name);
+        m_file_state = FILE_EOF;
+        return false;
+    }
+    if (n != int32( sizeof(int32) ) || block_size < int32( BAM_ALIGNMENT_FIELDS ))
+    {
+        log_error(stderr, "error processing BAM file: %s\n", fp.is_ok() ? "truncated or malformed record" : fp.error());
+        m_file_state = fp.is_ok() ? FILE_PARSE_ERROR : FILE_STREAM_ERROR;
+        return false;
+    }
 
-            if (encoded_read)
-                free(encoded_read);
+    // read the whole record
+    const uint32 offset = uint32( m_record_data.size() );
+    m_record_data.resize( offset + uint32( block_size ) );
 
-            if (decoded_read)
-                free(decoded_read);
+    if (fp.read( &m_record_data[ offset ], uint32( block_size ) ) != block_size)
+    {
+        log_error(stderr, "error processing BAM file: %s\n", fp.is_ok() ? "truncated record" : fp.error());
+        m_file_state = fp.is_ok() ? FILE_PARSE_ERROR : FILE_STREAM_ERROR;
+        return false;
+    }
 
-            if (quality)
-                free(quality);
-        }
-    } data = { };
+    return parse_record( offset, uint32( block_size ), record, flags );
+}
 
-    // utility structure to keep track of alignment header data
-    BAM_alignment align;
+// validate a record of a given size stored in BAM format at a given offset of the record buffer,
+// returning false if it's malformed
+//
+bool SequenceDataFile_BAM::parse_record(const uint32 offset, const uint32 block_size, Record* record, uint32* flags)
+{
+    uint8* data = &m_record_data[ offset ];
 
-    z_off_t read_block_start;
-    int read_name_len;
-    int read_flags;
-    int cigar_len;
-    int encoded_read_len;
+    const uint32 bin_mq_nl = load_field( data + 8u );
+    const uint32 flag_nc   = load_field( data + 12u );
+    const int32  l_seq     = int32( load_field( data + 16u ) );
 
-    int c;
+    const uint32 name_len  = bin_mq_nl & 0xff;
+    const uint32 cigar_len = (flag_nc & 0xffff) * sizeof(uint32);
 
-    // are we done?
-    if (gzeof(fp))
+    if (l_seq < 0 || name_len == 0 ||
+        uint64( BAM_ALIGNMENT_FIELDS ) + name_len + cigar_len + uint64( l_seq + 1 ) / 2 + uint64( l_seq ) > block_size)
     {
-        m_file_state = FILE_EOF;
-        return 0;
+        log_error(stderr, "error processing BAM file: malformed record\n");
+        m_file_state = FILE_PARSE_ERROR;
+        return false;
     }
 
-    // parse and skip all non-primary reads
-    do {
-        // read in the block_size
-        GZREAD(align.block_size);
+    // make sure the read name is null-terminated
+    data[ BAM_ALIGNMENT_FIELDS + name_len - 1u ] = 0;
 
-        // record the starting file position for this read block
-        read_block_start = gztell(fp);
+    record->name = offset + BAM_ALIGNMENT_FIELDS;
+    record->bp   = record->name + name_len + cigar_len;
+    record->q    = record->bp + uint32( l_seq + 1 ) / 2;
+    record->len  = uint32( l_seq );
+    record->out  = 0u;
+    record->rc   = ((flag_nc >> 16) & SAMFlag_ReverseComplemented) != 0;
 
-        // skip uninsteresting fields
-        GZFWD(sizeof(align.refID) +
-              sizeof(align.pos));
+    *flags = flag_nc >> 16;
+    return true;
+}
 
-        GZREAD(align.bin_mq_nl);
-        GZREAD(align.flag_nc);
+// decode the gathered records into the decoded bases and qualities buffers
+//
+void SequenceDataFile_BAM::decode_records()
+{
+    const int32 n_records = int32( m_records.size() );
 
-        // compute read flags
-        read_flags = align.flag_nc >> 16;
-        if (read_flags & SAMFlag_SecondaryAlignment)
-        {
-            // we're not interested in this read; skip the remainder of the read block and loop
-            uint32 skip = align.block_size - (gztell(fp) - read_block_start);
-            assert(skip);
-            GZFWD(skip);
+    #pragma omp parallel for num_threads(m_n_threads) if (n_records >= 1024)
+    for (int32 i = 0; i < n_records; ++i)
+    {
+        const Record& record = m_records[i];
 
-            continue;
-        }
-    } while (read_flags & SAMFlag_SecondaryAlignment);
+        const uint8* bp = &m_record_data[ record.bp ];
+        const uint8* q  = &m_record_data[ record.q ];
 
-    // this is a primary read, so read the read
-    GZREAD(align.l_seq);
-    GZFWD(sizeof(align.next_refID) +
-          sizeof(align.next_pos) +
-          sizeof(align.tlen));
+        uint8* out_bp = &m_decoded_bps[ record.out ];
+        uint8* out_q  = &m_decoded_quals[ record.out ];
 
-    // read in the name (and add a null-terminator just in case)
-    read_name_len = align.bin_mq_nl & 0xff;
-    data.read_name = (char *) malloc(read_name_len + 1);
-    data.read_name[read_name_len] = 0;
+        // reverse-complemented reads are restored to their original orientation
+        if (record.rc)
+        {
+            decode_BAM_read<true>( bp, record.len, out_bp );
+            std::reverse_copy( q, q + record.len, out_q );
+        }
+        else
+        {
+            decode_BAM_read<false>( bp, record.len, out_bp );
+            memcpy( out_q, q, record.len );
+        }
+    }
+}
 
-    if (gzread(fp, data.read_name, read_name_len) != read_name_len)
-    {
-        log_error(stderr, "error processing BAM file (could not fetch read name)\n");
-        m_file_state = FILE_STREAM_ERROR;
+// grab the next batch of reads into a host memory buffer
+//
+int SequenceDataFile_BAM::next(SequenceDataEncoder* encoder, const uint32 batch_size, const uint32 batch_bps)
+{
+    const uint32 reads_to_load = std::min(m_options.max_seqs - m_loaded, batch_size);
+
+    if (m_file_state != FILE_OK || reads_to_load == 0)
         return 0;
-    }
 
-    // skip the cigar
-    cigar_len = (align.flag_nc & 0xffff) * sizeof(uint32);
-    GZFWD(cigar_len);
+    const uint32 read_mult =
+        ((m_options.flags & FORWARD)            ? 1u : 0u) +
+        ((m_options.flags & REVERSE)            ? 1u : 0u) +
+        ((m_options.flags & FORWARD_COMPLEMENT) ? 1u : 0u) +
+        ((m_options.flags & REVERSE_COMPLEMENT) ? 1u : 0u);
 
-    // grab the read data
-    encoded_read_len = (align.l_seq + 1) / 2;
-    data.encoded_read = (uint8 *) malloc((align.l_seq + 1) / 2);
+    // a default average read length used to reserve enough space
+    const uint32 AVG_READ_LENGTH = 100;
 
-    if (gzread(fp, data.encoded_read, encoded_read_len) != encoded_read_len)
-    {
-        log_error(stderr, "error processing BAM file (could not fetch sequence data)\n");
-        m_file_state = FILE_STREAM_ERROR;
-        return 0;
-    }
+    encoder->begin_batch();
+    encoder->reserve(
+        batch_size,
+        batch_bps == uint32(-1) ? batch_size * AVG_READ_LENGTH : batch_bps ); // try to use a default read length
 
-    // read in the quality data
-    data.quality = (uint8 *) malloc(align.l_seq);
-    if (gzread(fp, data.quality, align.l_seq) != align.l_seq)
+    // move the record which didn't fit the previous batch to the front
+    if (m_pending)
     {
-        log_error(stderr, "error processing BAM file (could not fetch quality data)\n");
-        m_file_state = FILE_STREAM_ERROR;
-        return 0;
-    }
+        Record record = m_records.back();
 
-    // skip the rest of the read block
-    uint32 skip = align.block_size - (gztell(fp) - read_block_start);
-    GZFWD(skip);
+        const uint32 offset = record.name - BAM_ALIGNMENT_FIELDS;
+        const uint32 size   = uint32( m_record_data.size() ) - offset;
 
-    // decode the read data into a null-terminated string
-    data.decoded_read = (uint8 *) malloc(align.l_seq + 1);
-    data.decoded_read[align.l_seq] = 0;
+        memmove( &m_record_data[0], &m_record_data[ offset ], size );
+        m_record_data.resize( size );
 
-    PackedStream<uint8*, uint8, 4, true> stream(data.encoded_read);
-    for(c = 0; c < align.l_seq; c++)
-    {
-        data.decoded_read[c] = decode_BAM_bp(stream[c]);
-    }
+        record.name -= offset;
+        record.bp   -= offset;
+        record.q    -= offset;
 
-    if (m_options.flags & FORWARD)
-    {
-        const SequenceDataEncoder::StrandOp op = (read_flags & SAMFlag_ReverseComplemented) ?
-              SequenceDataEncoder::REVERSE_COMPLEMENT_OP : SequenceDataEncoder::NO_OP;
-
-        // add the read into the batch
-        output->push_back(align.l_seq,
-                          data.read_name,
-                          data.decoded_read,
-                          data.quality,
-                          Phred,
-                          m_options.max_sequence_len,
-                          m_options.trim3,
-                          m_options.trim5,
-                          op );
+        m_records.resize( 1u );
+        m_records[0] = record;
+        m_pending = false;
     }
-    if (m_options.flags & REVERSE)
+    else
     {
-        const SequenceDataEncoder::StrandOp op = (read_flags & SAMFlag_ReverseComplemented) ?
-              SequenceDataEncoder::COMPLEMENT_OP : SequenceDataEncoder::REVERSE_OP;
-
-        output->push_back(align.l_seq,
-                          data.read_name,
-                          data.decoded_read,
-                          data.quality,
-                          Phred,
-                          m_options.max_sequence_len,
-                          m_options.trim3,
-                          m_options.trim5,
-                          op );
+        m_record_data.clear();
+        m_records.clear();
     }
-    if (m_options.flags & FORWARD_COMPLEMENT)
+
+    // gather as many records as fit in the batch
+    uint32 n_reads   = 0;
+    uint64 n_bps     = 0;
+    uint32 n_decoded = 0;
+
+    uint32 i = 0;
+    while (n_reads + read_mult <= reads_to_load)
     {
-        const SequenceDataEncoder::StrandOp op = (read_flags & SAMFlag_ReverseComplemented) ?
-              SequenceDataEncoder::REVERSE_OP : SequenceDataEncoder::COMPLEMENT_OP;
-
-        output->push_back(align.l_seq,
-                          data.read_name,
-                          data.decoded_read,
-                          data.quality,
-                          Phred,
-                          m_options.max_sequence_len,
-                          m_options.trim3,
-                          m_options.trim5,
-                          op );
+        // fetch a new record, unless this is the one carried over from the previous batch
+        if (i == m_records.size())
+        {
+            Record record;
+            uint32 flags;
+            if (read_record( &record, &flags ) == false)
+                break;
+
+            // drop filtered records
+            if (flags & m_options.skip_flags)
+            {
+                m_record_data.resize( record.name - BAM_ALIGNMENT_FIELDS );
+                continue;
+            }
+
+            m_records.push_back( record );
+        }
+
+        Record& record = m_records[i];
+
+        const uint32 trimmed_len = record.len > m_options.trim3 + m_options.trim5 ?
+                                   record.len - m_options.trim3 - m_options.trim5 : 0u;
+
+        const uint64 sequence_len = read_mult * nvbio::min( trimmed_len, m_options.max_sequence_len );
+
+        // keep the record for the next batch if it doesn't fit, making sure we output at least one read per batch
+        if (n_bps + sequence_len > batch_bps && n_reads)
+        {
+            m_pending = true;
+            break;
+        }
+
+        record.out = n_decoded;
+
+        n_reads   += read_mult;
+        n_bps     += sequence_len;
+        n_decoded += record.len;
+        ++i;
     }
-    if (m_options.flags & REVERSE_COMPLEMENT)
+
+    const uint32 n_records = uint32( m_records.size() ) - (m_pending ? 1u : 0u);
+
+    if (n_records)
     {
-        const SequenceDataEncoder::StrandOp op = (read_flags & SAMFlag_ReverseComplemented) ?
-              SequenceDataEncoder::NO_OP : SequenceDataEncoder::REVERSE_COMPLEMENT_OP;
-
-        output->push_back(align.l_seq,
-                          data.read_name,
-                          data.decoded_read,
-                          data.quality,
-                          Phred,
-                          m_options.max_sequence_len,
-                          m_options.trim3,
-                          m_options.trim5,
-                          op );
+        // decode all records in parallel, leaving the pending one out
+        m_decoded_bps.resize( n_decoded );
+        m_decoded_quals.resize( n_decoded );
+
+        const Record pending = m_records.back();
+        m_records.resize( n_records );
+
+        decode_records();
+
+        m_lens.resize( n_records );
+        m_names.resize( n_records );
+        m_bps.resize( n_records );
+        m_quals.resize( n_records );
+
+        for (uint32 i = 0; i < n_records; ++i)
+        {
+            const Record& record = m_records[i];
+
+            m_lens[i]  = record.len;
+            m_names[i] = (const char*)&m_record_data[0] + record.name;
+            m_bps[i]   = n_decoded ? &m_decoded_bps[0]   + record.out : NULL;
+            m_quals[i] = n_decoded ? &m_decoded_quals[0] + record.out : NULL;
+        }
+
+        // BAM qualities are stored as plain Phred scores
+        encoder->push_back(
+            n_records,
+            &m_lens[0],
+            &m_names[0],
+            &m_bps[0],
+            &m_quals[0],
+            Phred,
+            m_options.max_sequence_len,
+            m_options.trim3,
+            m_options.trim5,
+            m_options.flags );
+
+        if (m_pending)
+            m_records.push_back( pending );
     }
 
-    // we always return 1 read at a time
-    return 1;
+    m_loaded += encoder->info()->size();
+
+    encoder->end_batch();
+
+    return encoder->info()->size();
 }
 
 ///@} // SequenceIODetail
@@ -27,13 +27,14 @@
 
 #pragma once
 
-#include <zlib/zlib.h>
-
 #include <nvbio/io/bam_format.h>
+#include <nvbio/io/parallel_gzip_reader.h>
 #include <nvbio/io/sequence/sequence.h>
 #include <nvbio/io/sequence/sequence_priv.h>
 #include <nvbio/basic/console.h>
 
+#include <vector>
+
 namespace nvbio {
 namespace io {
 
@@ -46,19 +47,36 @@ namespace io {
 ///@addtogroup SequenceIODetail
 ///@{
 
-/// SequenceDataFile from a BAM file
+///
+/// SequenceDataFile from a BAM file.
+///
+/// The BGZF blocks are decompressed ahead of the parser by a ParallelGzipReader, while
+/// records are read whole and gathered for an entire batch. Records having any of the
+/// SequenceDataFile::Options::skip_flags set are dropped. The gathered records are then
+/// decoded concurrently, unpacking their 4-bit bases and restoring the original orientation
+/// of the reverse-complemented ones, and handed to the SequenceDataEncoder in bulk.
 ///
 struct SequenceDataFile_BAM : public SequenceDataFile
 {
     /// constructor
     ///
+    /// \param read_file_name       the file to open
+    /// \param options              the loading options
+    /// \param n_threads            the number of decompression and decoding threads,
+    ///                             or 0 to use all OpenMP threads
+    ///
     SequenceDataFile_BAM(
         const char*                      read_file_name,
-        const SequenceDataFile::Options& options);
+        const SequenceDataFile::Options& options,
+        const uint32                     n_threads = 0);
 
-    /// read the next chunk
+    /// virtual destructor
     ///
-    virtual int nextChunk(struct SequenceDataEncoder *output, uint32 max_reads, uint32 max_bps);
+    virtual ~SequenceDataFile_BAM() {}
+
+    /// grab the next batch of reads into a host memory buffer
+    ///
+    virtual int next(struct SequenceDataEncoder* encoder, const uint32 batch_size, const uint32 batch_bps);
 
     /// rewind the file
     ///
@@ -66,14 +84,59 @@ struct SequenceDataFile_BAM : public SequenceDataFile
 
     /// initialize the stream
     ///
-    bool init(void);
+    virtual bool init(void);
+
+protected:
+    /// constructor for derived readers which provide records from other sources
+    ///
+    SequenceDataFile_BAM(
+        const SequenceDataFile::Options& options,
+        const uint32                     n_threads);
+
+    // get a chunk of reads: unused, as next() is overridden
+    int nextChunk(struct SequenceDataEncoder* encoder, uint32 max_reads, uint32 max_bps) { return 0; }
+
+    // a gathered record, expressed as offsets in the record buffer
+    struct Record
+    {
+        uint32 name;        // the offset of the read name
+        uint32 bp;          // the offset of the 4-bit encoded bases
+        uint32 q;           // the offset of the qualities
+        uint32 len;         // the read length
+        uint32 out;         // the offset of the decoded bases and qualities
+        bool   rc;          // whether the read is stored reverse-complemented
+    };
 
-private:
     /// small utility function to read data from the gzip stream
     ///
     bool readData(void *output, unsigned int len);
 
-    gzFile fp;              ///< file pointer
+    // read the next record in the record buffer, returning false on EOF or errors
+    virtual bool read_record(Record* record, uint32* flags);
+
+    // validate a record of a given size stored in BAM format at a given offset of the record buffer,
+    // returning false if it's malformed
+    bool parse_record(const uint32 offset, const uint32 block_size, Record* record, uint32* flags);
+
+    // decode the gathered records into the decoded bases and qualities buffers
+    void decode_records();
+
+    // the size of the fixed-length fields of an alignment record, from refID to tlen
+    static const uint32 BAM_ALIGNMENT_FIELDS = 32u;
+
+    uint32                      m_n_threads;
+    std::vector<uint8>          m_record_data;      // the raw records gathered for the current batch
+    std::vector<Record>         m_records;          // the records gathered for the current batch
+    bool                        m_pending;          // whether the last gathered record didn't fit the previous batch
+    std::vector<uint8>          m_decoded_bps;      // the decoded bases of the gathered records
+    std::vector<uint8>          m_decoded_quals;    // the qualities of the gathered records
+    std::vector<uint32>         m_lens;             // temporary arrays used to push records in bulk
+    std::vector<const char*>    m_names;
+    std::vector<const uint8*>   m_bps;
+    std::vector<const uint8*>   m_quals;
+
+private:
+    ParallelGzipReader          fp;                 ///< file reader
 };
 
 ///@} // SequenceIODetail
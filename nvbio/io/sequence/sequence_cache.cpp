@@ -0,0 +1,690 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <nvbio/io/sequence/sequence_cache.h>
+#include <nvbio/io/sequence/sequence_encoder.h>
+#include <nvbio/basic/console.h>
+#include <nvbio/basic/exceptions.h>
+#include <nvbio/basic/omp.h>
+#include <nvbio/basic/popcount.h>
+
+#include <string.h>
+#include <algorithm>
+
+#if defined(PLATFORM_X86) && defined(__SSSE3__)
+#include <tmmintrin.h>                              // SSSE3 intrinsics
+#endif
+
+namespace nvbio {
+namespace io {
+
+///@addtogroup IO
+///@{
+
+///@addtogroup SequenceIO
+///@{
+
+///@addtogroup SequenceIODetail
+///@{
+
+namespace {
+
+const char READ_CACHE_MAGIC[4] = { 'N', 'V', 'R', '\1' };
+
+// a table expanding a byte of 2-bit codes into 4 ASCII bases
+//
+struct BaseTable
+{
+    BaseTable()
+    {
+        for (uint32 b = 0; b < 256; ++b)
+            for (uint32 i = 0; i < 4; ++i)
+                bases[b][i] = "ACGT"[ (b >> (i*2)) & 3u ];
+    }
+
+    char bases[256][4];
+};
+
+// a table mapping ASCII bases to their 2-bit codes, or to 4 if they must be stored as exceptions
+//
+struct CodeTable
+{
+    CodeTable()
+    {
+        memset( codes, 4, sizeof(codes) );
+        codes['A'] = 0; codes['C'] = 1; codes['G'] = 2; codes['T'] = 3;
+    }
+
+    uint8 codes[256];
+};
+
+// expand the bases [begin, begin + len) of a 2-bit packed block into ASCII
+//
+inline void decode_bases(const uint8* bases, const uint32 begin, const uint32 len, uint8* out)
+{
+    static const BaseTable table;
+
+    uint32 i = 0;
+
+    // decode the bases preceding the first byte boundary one at a time
+    for (; i < len && ((begin + i) & 3u); ++i)
+        out[i] = table.bases[ bases[ (begin + i) / 4u ] ][ (begin + i) & 3u ];
+
+    // expand whole bytes
+    for (; i + 4u <= len; i += 4u)
+        memcpy( out + i, table.bases[ bases[ (begin + i) / 4u ] ], 4u );
+
+    for (; i < len; ++i)
+        out[i] = table.bases[ bases[ (begin + i) / 4u ] ][ (begin + i) & 3u ];
+}
+
+// expand the binned qualities [begin, begin + len) of a block
+//
+inline void decode_qualities(const uint8* qualities, const uint8* bins, const uint32 begin, const uint32 len, uint8* out)
+{
+    const uint8* q = qualities + begin / 2u;
+
+    uint32 i = 0;
+
+    // decode the high nibble of the first byte if the read starts in the middle of it
+    if (len && (begin & 1u))
+        out[i++] = bins[ *q++ >> 4 ];
+
+  #if defined(PLATFORM_X86) && defined(__SSSE3__)
+    // expand 16 qualities at a time, low nibble first, translating them with a byte shuffle
+    const __m128i lut    = _mm_loadu_si128( (const __m128i*)bins );
+    const __m128i nibble = _mm_set1_epi8( 0x0F );
+
+    for (; i + 16u <= len; i += 16u, q += 8u)
+    {
+        const __m128i packed = _mm_loadl_epi64( (const __m128i*)q );
+        const __m128i hi     = _mm_and_si128( _mm_srli_epi16( packed, 4 ), nibble );
+        const __m128i lo     = _mm_and_si128( packed, nibble );
+
+        _mm_storeu_si128( (__m128i*)( out + i ), _mm_shuffle_epi8( lut, _mm_unpacklo_epi8( lo, hi ) ) );
+    }
+  #endif
+
+    // expand whole bytes
+    for (; i + 2u <= len; i += 2u, ++q)
+    {
+        out[i]    = bins[ *q & 15u ];
+        out[i+1u] = bins[ *q >> 4 ];
+    }
+
+    if (i < len)
+        out[i] = bins[ *q & 15u ];
+}
+
+} // anonymous namespace
+
+SequenceDataFile_Cache::SequenceDataFile_Cache(
+    const char*                      read_file_name,
+    const SequenceDataFile::Options& options,
+    const uint32                     n_threads)
+  : SequenceDataFile( options ),
+    m_file_name( read_file_name ),
+    m_n_threads( n_threads ? n_threads : uint32( omp_get_max_threads() ) ),
+    m_data( NULL ),
+    m_header( NULL ),
+    m_blocks( NULL ),
+    m_block( 0 ),
+    m_block_read( 0 ),
+    m_block_bp( 0 ),
+    m_block_name( 0 )
+{}
+
+bool SequenceDataFile_Cache::init(void)
+{
+    try
+    {
+        m_data = (const uint8*)m_file.init( m_file_name );
+    }
+    catch (DiskMappedFile::mapping_error e)
+    {
+        log_error(stderr, "unable to open read cache %s (error %d)\n", e.m_file_name, e.m_code);
+        m_file_state = FILE_OPEN_FAILED;
+        return false;
+    }
+    catch (DiskMappedFile::view_error e)
+    {
+        log_error(stderr, "unable to map read cache %s (error %d)\n", e.m_file_name, e.m_code);
+        m_file_state = FILE_OPEN_FAILED;
+        return false;
+    }
+
+    const uint64 file_size = m_file.size();
+
+    m_header = (const ReadCacheHeader*)m_data;
+
+    if (file_size < sizeof(ReadCacheHeader) ||
+        memcmp( m_header->magic, READ_CACHE_MAGIC, sizeof(READ_CACHE_MAGIC) ) != 0)
+    {
+        log_error(stderr, "error parsing read cache %s (invalid magic)\n", m_file_name);
+        m_file_state = FILE_PARSE_ERROR;
+        return false;
+    }
+    if (m_header->version != ReadCacheHeader::VERSION)
+    {
+        log_error(stderr, "error parsing read cache %s (unsupported version %u)\n", m_file_name, m_header->version);
+        m_file_state = FILE_PARSE_ERROR;
+        return false;
+    }
+    if (m_header->index_offset > file_size ||
+        uint64( m_header->n_blocks ) * sizeof(ReadCacheBlock) > file_size - m_header->index_offset)
+    {
+        log_error(stderr, "error parsing read cache %s (truncated file)\n", m_file_name);
+        m_file_state = FILE_PARSE_ERROR;
+        return false;
+    }
+
+    m_blocks = (const ReadCacheBlock*)( m_data + m_header->index_offset );
+
+    // check that all blocks lie within the file, and that their names are properly terminated
+    for (uint32 i = 0; i < m_header->n_blocks; ++i)
+    {
+        const ReadCacheBlockLayout layout( m_blocks[i], m_header->quality_mode );
+
+        if (m_blocks[i].offset > m_header->index_offset ||
+            layout.size > m_header->index_offset - m_blocks[i].offset ||
+            (m_blocks[i].n_reads && (m_blocks[i].names_len == 0 || m_data[ m_blocks[i].offset + layout.size - 1u ] != 0)))
+        {
+            log_error(stderr, "error parsing read cache %s (malformed block %u)\n", m_file_name, i);
+            m_file_state = FILE_PARSE_ERROR;
+            return false;
+        }
+    }
+
+    log_verbose(stderr, "read cache %s: %llu reads, %llu bps, %u blocks\n", m_file_name, m_header->n_reads, m_header->n_bps, m_header->n_blocks);
+
+    m_file_state = FILE_OK;
+    return true;
+}
+
+// rewind
+//
+bool SequenceDataFile_Cache::rewind()
+{
+    if (m_header == NULL || m_file_state == FILE_PARSE_ERROR)
+        return false;
+
+    m_block      = 0;
+    m_block_read = 0;
+    m_block_bp   = 0;
+    m_block_name = 0;
+    m_file_state = FILE_OK;
+    return true;
+}
+
+// decode the gathered records into the decoded bases and qualities buffers
+//
+void SequenceDataFile_Cache::decode_records()
+{
+    const int32 n_records = int32( m_records.size() );
+
+    const bool binned = m_header->quality_mode == ReadCacheHeader::QUALS_BINNED;
+
+    #pragma omp parallel for num_threads(m_n_threads) if (n_records >= 1024)
+    for (int32 i = 0; i < n_records; ++i)
+    {
+        const Record&              record = m_records[i];
+        const ReadCacheBlock&      block  = m_blocks[ record.block ];
+        const ReadCacheBlockLayout layout( block, m_header->quality_mode );
+
+        const uint8* block_data = m_data + block.offset;
+
+        decode_bases( block_data + layout.bases, record.bp, record.len, &m_decoded_bps[ record.out ] );
+
+        if (binned)
+            decode_qualities( block_data + layout.qualities, m_header->quality_bins, record.bp, record.len, &m_decoded_quals[ record.out ] );
+    }
+
+    // patch the exceptions, going through the contiguous runs of records from each block
+    for (uint32 i = 0; i < uint32( n_records );)
+    {
+        const Record&              first  = m_records[i];
+        const ReadCacheBlock&      block  = m_blocks[ first.block ];
+        const ReadCacheBlockLayout layout( block, m_header->quality_mode );
+
+        uint32 bp_end = first.bp;
+        for (; i < uint32( n_records ) && m_records[i].block == first.block; ++i)
+            bp_end += m_records[i].len;
+
+        if (block.n_exceptions == 0)
+            continue;
+
+        const uint32* exceptions     = (const uint32*)( m_data + block.offset + layout.exceptions );
+        const char*   exception_syms = (const char*)( m_data + block.offset + layout.exception_syms );
+
+        uint8* out = &m_decoded_bps[ first.out ] - first.bp;
+
+        if (block.exception_format == ReadCacheBlock::EXCEPTION_LIST)
+        {
+            for (uint32 e = uint32( std::lower_bound( exceptions, exceptions + block.n_exceptions, first.bp ) - exceptions );
+                 e < block.n_exceptions && exceptions[e] < bp_end;
+                 ++e)
+                out[ exceptions[e] ] = uint8( exception_syms[e] );
+        }
+        else
+        {
+            // find the symbol of the first exception by counting the bits preceding the first base
+            const uint32 first_word = first.bp / 32u;
+
+            uint32 e = 0;
+            for (uint32 w = 0; w < first_word; ++w)
+                e += popc( exceptions[w] );
+
+            for (uint32 w = first_word; w * 32u < bp_end; ++w)
+            {
+                uint32 mask = exceptions[w];
+
+                // skip the bits preceding the first base
+                if (w == first_word && (first.bp & 31u))
+                {
+                    e   += popc( mask & ((1u << (first.bp & 31u)) - 1u) );
+                    mask = mask & ~((1u << (first.bp & 31u)) - 1u);
+                }
+
+                for (; mask; mask &= mask - 1u)
+                {
+                    const uint32 p = w * 32u + ffs( int32( mask ) ) - 1u;
+                    if (p >= bp_end)
+                        break;
+
+                    out[p] = uint8( exception_syms[e++] );
+                }
+            }
+        }
+    }
+}
+
+// grab the next batch of reads into a host memory buffer
+//
+int SequenceDataFile_Cache::next(SequenceDataEncoder* encoder, const uint32 batch_size, const uint32 batch_bps)
+{
+    const uint32 reads_to_load = std::min(m_options.max_seqs - m_loaded, batch_size);
+
+    if (m_file_state != FILE_OK || reads_to_load == 0)
+        return 0;
+
+    const uint32 read_mult =
+        ((m_options.flags & FORWARD)            ? 1u : 0u) +
+        ((m_options.flags & REVERSE)            ? 1u : 0u) +
+        ((m_options.flags & FORWARD_COMPLEMENT) ? 1u : 0u) +
+        ((m_options.flags & REVERSE_COMPLEMENT) ? 1u : 0u);
+
+    // a default average read length used to reserve enough space
+    const uint32 AVG_READ_LENGTH = 100;
+
+    encoder->begin_batch();
+    encoder->reserve(
+        batch_size,
+        batch_bps == uint32(-1) ? batch_size * AVG_READ_LENGTH : batch_bps ); // try to use a default read length
+
+    m_records.clear();
+    m_names.clear();
+
+    // gather as many reads as fit in the batch
+    uint32 n_reads   = 0;
+    uint64 n_bps     = 0;
+    uint32 n_decoded = 0;
+
+    const uint32* lengths = NULL;
+    const char*   names   = NULL;
+    uint32        block   = uint32(-1);
+
+    while (n_reads + read_mult <= reads_to_load)
+    {
+        // skip to the next block with reads left
+        while (m_block < m_header->n_blocks && m_block_read == m_blocks[ m_block ].n_reads)
+        {
+            ++m_block;
+            m_block_read = 0;
+            m_block_bp   = 0;
+            m_block_name = 0;
+        }
+
+        if (m_block == m_header->n_blocks)
+        {
+            m_file_state = FILE_EOF;
+            break;
+        }
+
+        if (block != m_block)
+        {
+            block = m_block;
+
+            const ReadCacheBlockLayout layout( m_blocks[ block ], m_header->quality_mode );
+
+            lengths = (const uint32*)( m_data + m_blocks[ block ].offset + layout.lengths );
+            names   = (const char*)( m_data + m_blocks[ block ].offset + layout.names );
+        }
+
+        const uint32 len = lengths[ m_block_read ];
+
+        if (uint64( m_block_bp ) + len > m_blocks[ block ].n_bps ||
+            m_block_name >= m_blocks[ block ].names_len)
+        {
+            log_error(stderr, "error parsing read cache %s (malformed block %u)\n", m_file_name, block);
+            m_file_state = FILE_PARSE_ERROR;
+            break;
+        }
+
+        const uint32 trimmed_len = len > m_options.trim3 + m_options.trim5 ?
+                                   len - m_options.trim3 - m_options.trim5 : 0u;
+
+        const uint64 sequence_len = read_mult * nvbio::min( trimmed_len, m_options.max_sequence_len );
+
+        // leave the read for the next batch if it doesn't fit, making sure we output at least one read per batch
+        if (n_bps + sequence_len > batch_bps && n_reads)
+            break;
+
+        Record record;
+        record.block = block;
+        record.bp    = m_block_bp;
+        record.len   = len;
+        record.out   = n_decoded;
+        m_records.push_back( record );
+
+        const char* name = names + m_block_name;
+        m_names.push_back( name );
+
+        m_block_read++;
+        m_block_bp   += len;
+        m_block_name += uint32( strlen( name ) ) + 1u;
+
+        n_reads   += read_mult;
+        n_bps     += sequence_len;
+        n_decoded += len;
+    }
+
+    const uint32 n_records = uint32( m_records.size() );
+
+    if (n_records && m_file_state != FILE_PARSE_ERROR)
+    {
+        const bool binned = m_header->quality_mode == ReadCacheHeader::QUALS_BINNED;
+
+        m_decoded_bps.resize( n_decoded );
+        if (binned)
+            m_decoded_quals.resize( n_decoded );
+
+        decode_records();
+
+        m_lens.resize( n_records );
+        m_bps.resize( n_records );
+        m_quals.resize( n_records );
+
+        for (uint32 i = 0; i < n_records; ++i)
+        {
+            const Record& record = m_records[i];
+
+            m_lens[i] = record.len;
+            m_bps[i]  = n_decoded ? &m_decoded_bps[0] + record.out : NULL;
+
+            // raw qualities are handed out straight from the mapped file
+            if (binned)
+                m_quals[i] = n_decoded ? &m_decoded_quals[0] + record.out : NULL;
+            else
+            {
+                const ReadCacheBlock&      block = m_blocks[ record.block ];
+                const ReadCacheBlockLayout layout( block, m_header->quality_mode );
+
+                m_quals[i] = m_data + block.offset + layout.qualities + record.bp;
+            }
+        }
+
+        // the cached qualities are stored as plain Phred scores
+        encoder->push_back(
+            n_records,
+            &m_lens[0],
+            &m_names[0],
+            &m_bps[0],
+            &m_quals[0],
+            Phred,
+            m_options.max_sequence_len,
+            m_options.trim3,
+            m_options.trim5,
+            m_options.flags );
+    }
+
+    m_loaded += encoder->info()->size();
+
+    encoder->end_batch();
+
+    return encoder->info()->size();
+}
+
+SequenceDataOutputFile_Cache::SequenceDataOutputFile_Cache(
+    const char* file_name,
+    const char* options)
+  : m_file_name( file_name ),
+    m_offset( 0 )
+{
+    memset( &m_header, 0, sizeof(ReadCacheHeader) );
+    memcpy( m_header.magic, READ_CACHE_MAGIC, sizeof(READ_CACHE_MAGIC) );
+    m_header.version      = ReadCacheHeader::VERSION;
+    m_header.quality_mode = (options && strchr( options, 'b' )) ?
+        ReadCacheHeader::QUALS_BINNED :
+        ReadCacheHeader::QUALS_RAW;
+
+    // build the quality binning tables, using Illumina's 8 levels
+    const QualityBins bins = QualityBins::illumina();
+    for (uint32 b = 0; b < bins.size(); ++b)
+        m_header.quality_bins[b] = bins.value(b);
+
+    bins.bin_table( m_quality_to_bin );
+
+    m_file = fopen( file_name, "wb" );
+    if (m_file == NULL)
+    {
+        log_error(stderr, "unable to open read cache %s for writing\n", file_name);
+        return;
+    }
+
+    // reserve space for the header, which is written once all blocks are known
+    write( sizeof(ReadCacheHeader), &m_header );
+}
+
+SequenceDataOutputFile_Cache::~SequenceDataOutputFile_Cache()
+{
+    if (m_file == NULL)
+        return;
+
+    // append the block index and rewrite the header
+    m_header.n_blocks     = uint32( m_index.size() );
+    m_header.index_offset = m_offset;
+
+    if (m_index.size())
+        fwrite( &m_index[0], sizeof(ReadCacheBlock), m_index.size(), m_file );
+
+    fseek( m_file, 0, SEEK_SET );
+    fwrite( &m_header, sizeof(ReadCacheHeader), 1u, m_file );
+    fclose( m_file );
+}
+
+// append some bytes to the file, padding them to a 4-byte boundary, or to an 8-byte boundary
+// at the end of a block so as to keep the 64-bit fields of the block index aligned
+//
+void SequenceDataOutputFile_Cache::write(const uint64 size, const void* data, const bool end_of_block)
+{
+    const uint64 end     = m_offset + size;
+    const uint32 padding = uint32( (end_of_block ? ReadCacheBlockLayout::align<8>( end ) : ReadCacheBlockLayout::align<4>( end )) - end );
+    const uint64 zero    = 0u;
+
+    if ((size && fwrite( data, 1u, size, m_file ) != size) ||
+        (padding && fwrite( &zero, 1u, padding, m_file ) != padding))
+        throw runtime_error( "failed writing read cache file" );
+
+    m_offset += size + padding;
+}
+
+// write a batch of reads as a new block
+//
+template <Alphabet ALPHABET>
+void SequenceDataOutputFile_Cache::write_block(const SequenceDataAccess<ALPHABET>& sequence_data)
+{
+    static const CodeTable table;
+
+    typedef typename SequenceDataAccess<ALPHABET>::sequence_string sequence_string;
+
+    const uint32 n_reads = sequence_data.size();
+    const uint32 n_bps   = sequence_data.bps();
+
+    ReadCacheBlock block;
+    block.offset       = m_offset;
+    block.n_reads      = n_reads;
+    block.n_bps        = n_bps;
+    block.n_exceptions = 0u;
+    block.names_len    = sequence_data.name_stream_len();
+    block.reserved     = 0u;
+
+    std::vector<uint32> lengths( n_reads );
+    std::vector<char>   ascii( n_bps + 4u, 'A' );
+
+    // convert the reads to ASCII
+    #pragma omp parallel for
+    for (int32 i = 0; i < int32( n_reads ); ++i)
+    {
+        const sequence_string read   = sequence_data.get_read( i );
+        const uint32          offset = sequence_data.get_range( i ).x;
+
+        for (uint32 j = 0; j < read.size(); ++j)
+            ascii[ offset + j ] = to_char<ALPHABET>( read[j] );
+
+        lengths[i] = read.size();
+    }
+
+    // pack the bases
+    std::vector<uint8> bases( (n_bps + 3u) / 4u );
+
+    #pragma omp parallel for
+    for (int32 i = 0; i < int32( bases.size() ); ++i)
+    {
+        uint8 b = 0;
+        for (uint32 j = 0; j < 4; ++j)
+            b |= (table.codes[ uint8( ascii[ i*4 + j ] ) ] & 3u) << (j*2);
+
+        bases[i] = b;
+    }
+
+    // collect the exceptions, building both their list and their bitmask
+    std::vector<uint32> exceptions;
+    std::vector<uint32> exception_mask( (n_bps + 31u) / 32u, 0u );
+    std::vector<char>   exception_syms;
+
+    for (uint32 i = 0; i < n_bps; ++i)
+    {
+        if (table.codes[ uint8( ascii[i] ) ] == 4u)
+        {
+            exceptions.push_back( i );
+            exception_mask[ i / 32u ] |= 1u << (i & 31u);
+            exception_syms.push_back( ascii[i] );
+        }
+    }
+    block.n_exceptions = uint32( exceptions.size() );
+
+    // and keep whichever of the two takes less space
+    if (exception_mask.size() < exceptions.size())
+    {
+        block.exception_format = ReadCacheBlock::EXCEPTION_MASK;
+        exceptions.swap( exception_mask );
+    }
+    else
+        block.exception_format = ReadCacheBlock::EXCEPTION_LIST;
+
+    write( lengths.size() * sizeof(uint32), n_reads ? &lengths[0] : NULL );
+    write( exceptions.size() * sizeof(uint32), exceptions.size() ? &exceptions[0] : NULL );
+    write( exception_syms.size(), exception_syms.size() ? &exception_syms[0] : NULL );
+    write( bases.size(), bases.size() ? &bases[0] : NULL );
+
+    // the qualities are already stored as plain Phred scores
+    const char* quals = sequence_data.qual_stream();
+
+    if (m_header.quality_mode == ReadCacheHeader::QUALS_BINNED)
+    {
+        std::vector<uint8> bins( (n_bps + 1u) / 2u );
+
+        #pragma omp parallel for
+        for (int32 i = 0; i < int32( bins.size() ); ++i)
+        {
+            const uint32 p = uint32(i)*2u;
+
+            bins[i] = m_quality_to_bin[ uint8( quals[p] ) ] |
+                (p + 1u < n_bps ? m_quality_to_bin[ uint8( quals[p+1] ) ] << 4 : 0u);
+        }
+        write( bins.size(), bins.size() ? &bins[0] : NULL );
+    }
+    else
+        write( n_bps, quals );
+
+    write( block.names_len, sequence_data.name_stream(), true );
+
+    m_index.push_back( block );
+
+    m_header.n_reads += n_reads;
+    m_header.n_bps   += n_bps;
+}
+
+// next batch
+//
+void SequenceDataOutputFile_Cache::next(const SequenceDataHost& sequence_data)
+{
+    // binned qualities are written out as the scores their bins represent
+    if (sequence_data.quality_bins().is_plain() == false)
+    {
+        SequenceDataHost plain_data( sequence_data );
+        expand_qualities( &plain_data );
+        next( plain_data );
+        return;
+    }
+
+    if (sequence_data.alphabet() == DNA)
+        write_block( io::SequenceDataAccess<DNA>( sequence_data ) );
+    else if (sequence_data.alphabet() == DNA_N)
+        write_block( io::SequenceDataAccess<DNA_N>( sequence_data ) );
+    else if (sequence_data.alphabet() == DNA_IUPAC)
+        write_block( io::SequenceDataAccess<DNA_IUPAC>( sequence_data ) );
+    else if (sequence_data.alphabet() == PROTEIN)
+        write_block( io::SequenceDataAccess<PROTEIN>( sequence_data ) );
+    else if (sequence_data.alphabet() == RNA)
+        write_block( io::SequenceDataAccess<RNA>( sequence_data ) );
+    else if (sequence_data.alphabet() == RNA_N)
+        write_block( io::SequenceDataAccess<RNA_N>( sequence_data ) );
+    else if (sequence_data.alphabet() == ASCII)
+        write_block( io::SequenceDataAccess<ASCII>( sequence_data ) );
+}
+
+// return whether the stream is ok
+//
+bool SequenceDataOutputFile_Cache::is_ok() { return m_file != NULL; }
+
+///@} // SequenceIODetail
+///@} // SequenceIO
+///@} // IO
+
+} // namespace io
+} // namespace nvbio
@@ -0,0 +1,267 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <nvbio/io/sequence/sequence.h>
+#include <nvbio/io/sequence/sequence_priv.h>
+#include <nvbio/basic/mmap.h>
+
+#include <stdio.h>
+#include <vector>
+
+namespace nvbio {
+namespace io {
+
+///@addtogroup IO
+///@{
+
+///@addtogroup SequenceIO
+///@{
+
+///@addtogroup SequenceIODetail
+///@{
+
+///
+/// The header of a read cache (.nvr) file.
+///
+/// A read cache stores a set of reads in a pre-encoded binary format which can be mapped
+/// and handed out in batches without any text parsing. The file is laid out as:
+///\verbatim
+///   ReadCacheHeader
+///   block[0] ... block[n_blocks-1]
+///   ReadCacheBlock[n_blocks]          (the block index, at index_offset)
+///\endverbatim
+/// where each block starts at an 8-byte boundary and is in turn made of the following sections,
+/// each starting at a 4-byte boundary (see ReadCacheBlockLayout):
+///\verbatim
+///   uint32 lengths[n_reads]
+///   uint32 exceptions[]                (the exception positions, or a bitmask of them)
+///   char   exception_symbols[n_exceptions]
+///   uint8  bases[(n_bps+3)/4]          (2-bit codes of A,C,G,T, the first base in the lowest bits)
+///   uint8  qualities[]                 (one Phred score per byte, or one 4-bit bin per base)
+///   char   names[names_len]            (null-terminated)
+///\endverbatim
+/// Bases other than A, C, G, T are stored as exceptions, keeping the symbol they had
+/// in the original ASCII representation: their positions are listed explicitly, unless
+/// they are dense enough for a bitmask over all the bases of the block to take less space.
+/// All values are stored in little-endian order.
+///
+struct ReadCacheHeader
+{
+    static const uint32 VERSION = 1u;
+
+    enum QualityMode
+    {
+        QUALS_RAW    = 0u,     ///< one plain Phred score per byte
+        QUALS_BINNED = 1u,     ///< one 4-bit bin index per base, two bases per byte
+    };
+
+    char    magic[4];           ///< "NVR\1"
+    uint32  version;            ///< the format version
+    uint32  quality_mode;       ///< the QualityMode
+    uint32  n_blocks;           ///< the number of blocks
+    uint64  n_reads;            ///< the total number of reads
+    uint64  n_bps;              ///< the total number of bases
+    uint64  index_offset;       ///< the offset of the block index
+    uint8   quality_bins[16];   ///< the Phred score represented by each quality bin
+};
+
+///
+/// A block index entry of a read cache file
+///
+struct ReadCacheBlock
+{
+    enum ExceptionFormat
+    {
+        EXCEPTION_LIST = 0u,    ///< the sorted list of the exception positions
+        EXCEPTION_MASK = 1u,    ///< a bitmask with one bit per base, packed in 32-bit words
+    };
+
+    uint64  offset;             ///< the offset of the block in the file
+    uint32  n_reads;            ///< the number of reads in the block
+    uint32  n_bps;              ///< the number of bases in the block
+    uint32  n_exceptions;       ///< the number of non-ACGT bases in the block
+    uint32  exception_format;   ///< the ExceptionFormat
+    uint32  names_len;          ///< the length of the names section
+    uint32  reserved;
+};
+
+///
+/// The offsets of the sections of a read cache block, relative to the start of the block
+///
+struct ReadCacheBlockLayout
+{
+    ReadCacheBlockLayout(const ReadCacheBlock& block, const uint32 quality_mode)
+    {
+        lengths        = 0u;
+        exceptions     = lengths    + block.n_reads * sizeof(uint32);
+        exception_syms = exceptions + (block.exception_format == ReadCacheBlock::EXCEPTION_MASK ?
+                                       (uint64( block.n_bps ) + 31u) / 32u :
+                                        uint64( block.n_exceptions )) * sizeof(uint32);
+        bases          = align<4>( exception_syms + block.n_exceptions );
+        qualities      = align<4>( bases + (uint64( block.n_bps ) + 3u) / 4u );
+        names          = align<4>( qualities + (quality_mode == ReadCacheHeader::QUALS_BINNED ?
+                                                (uint64( block.n_bps ) + 1u) / 2u :
+                                                 uint64( block.n_bps )) );
+        size           = names + block.names_len;
+    }
+
+    template <uint32 N>
+    static uint64 align(const uint64 x) { return (x + N-1u) & ~uint64(N-1u); }
+
+    uint64 lengths;
+    uint64 exceptions;
+    uint64 exception_syms;
+    uint64 bases;
+    uint64 qualities;
+    uint64 names;
+    uint64 size;
+};
+
+///
+/// SequenceDataFile from a read cache (.nvr) file.
+///
+/// The file is memory-mapped, and the reads of each batch are expanded from their 2-bit
+/// representation and handed to the SequenceDataEncoder in bulk, so that the strands, trimming
+/// and alphabets requested through the SequenceDataFile::Options are applied as for any other format.
+/// Qualities are stored as plain Phred scores, so that the requested QualityEncoding is ignored.
+///
+struct SequenceDataFile_Cache : public SequenceDataFile
+{
+    /// constructor
+    ///
+    /// \param read_file_name       the file to open
+    /// \param options              the loading options
+    /// \param n_threads            the number of decoding threads, or 0 to use all OpenMP threads
+    ///
+    SequenceDataFile_Cache(
+        const char*                      read_file_name,
+        const SequenceDataFile::Options& options,
+        const uint32                     n_threads = 0);
+
+    /// grab the next batch of reads into a host memory buffer
+    ///
+    virtual int next(struct SequenceDataEncoder* encoder, const uint32 batch_size, const uint32 batch_bps);
+
+    /// rewind the file
+    ///
+    virtual bool rewind();
+
+    /// initialize the stream
+    ///
+    virtual bool init(void);
+
+private:
+    // get a chunk of reads: unused, as next() is overridden
+    int nextChunk(struct SequenceDataEncoder* encoder, uint32 max_reads, uint32 max_bps) { return 0; }
+
+    // a read gathered for the current batch
+    struct Record
+    {
+        uint32 block;       // the block index
+        uint32 bp;          // the offset of the first base within the block
+        uint32 len;         // the read length
+        uint32 out;         // the offset of the decoded bases and qualities
+    };
+
+    // decode the gathered records into the decoded bases and qualities buffers
+    void decode_records();
+
+    const char*                 m_file_name;
+    uint32                      m_n_threads;
+    DiskMappedFile              m_file;
+    const uint8*                m_data;
+    const ReadCacheHeader*      m_header;
+    const ReadCacheBlock*       m_blocks;
+
+    uint32                      m_block;            // the current block
+    uint32                      m_block_read;       // the next read within the current block
+    uint32                      m_block_bp;         // the offset of the next base within the current block
+    uint32                      m_block_name;       // the offset of the next name within the current block
+
+    std::vector<Record>         m_records;          // the reads gathered for the current batch
+    std::vector<uint8>          m_decoded_bps;      // the decoded bases of the gathered reads
+    std::vector<uint8>          m_decoded_quals;    // the decoded qualities of the gathered reads
+    std::vector<uint32>         m_lens;             // temporary arrays used to push reads in bulk
+    std::vector<const char*>    m_names;
+    std::vector<const uint8*>   m_bps;
+    std::vector<const uint8*>   m_quals;
+};
+
+///
+/// SequenceDataOutputStream writing a read cache (.nvr) file.
+///
+/// Each batch is written as a separate block, and the block index and the final header
+/// are written when the stream is destroyed.
+///
+struct SequenceDataOutputFile_Cache : SequenceDataOutputStream
+{
+    /// constructor
+    ///
+    /// \param file_name        the file to open
+    /// \param options          a string of options: if it contains the character 'b' the qualities
+    ///                         are binned in 8 levels, Illumina style, and stored in 4 bits each
+    ///
+    SequenceDataOutputFile_Cache(
+        const char* file_name,
+        const char* options);
+
+    /// destructor
+    ///
+    ~SequenceDataOutputFile_Cache();
+
+    /// next batch
+    ///
+    void next(const SequenceDataHost& sequence_data);
+
+    /// return whether the stream is ok
+    ///
+    bool is_ok();
+
+private:
+    // write a batch of reads as a new block
+    template <Alphabet ALPHABET>
+    void write_block(const SequenceDataAccess<ALPHABET>& sequence_data);
+
+    // append some bytes to the file, padding them to a 4-byte boundary, or to an 8-byte one at the end of a block
+    void write(const uint64 size, const void* data, const bool end_of_block = false);
+
+    const char*                 m_file_name;
+    FILE*                       m_file;
+    uint64                      m_offset;
+    ReadCacheHeader             m_header;
+    std::vector<ReadCacheBlock> m_index;
+    uint8                       m_quality_to_bin[256];
+};
+
+///@} // SequenceIODetail
+///@} // SequenceIO
+///@} // IO
+
+} // namespace io
+} // namespace nvbio
@@ -0,0 +1,382 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <nvbio/io/sequence/sequence_cram.h>
+#include <nvbio/io/sequence/sequence_access.h>
+#include <nvbio/io/sequence/sequence_pac.h>
+#include <nvbio/basic/console.h>
+#include <nvbio/basic/dna.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(NVBIO_CRAM)
+#ifndef WIN32
+#include <unistd.h>
+#endif
+#include <htslib/sam.h>
+#include <htslib/faidx.h>
+#ifndef SAMTOOLS
+#define SAMTOOLS 1                                  // select the CRAM headers' htslib configuration
+#endif
+#include <cram/cram.h>
+#endif
+
+namespace nvbio {
+namespace io {
+
+///@addtogroup IO
+///@{
+
+///@addtogroup SequenceIO
+///@{
+
+///@addtogroup SequenceIODetail
+///@{
+
+#if defined(NVBIO_CRAM)
+
+// the htslib objects backing the stream
+//
+struct SequenceDataFile_CRAM::HTSFile
+{
+    HTSFile() : fp( NULL ), header( NULL ), record( NULL ) {}
+
+    samFile*    fp;
+    bam_hdr_t*  header;
+    bam1_t*     record;
+};
+
+namespace {
+
+// check whether a file exists
+//
+bool file_exists(const std::string& file_name)
+{
+    FILE* file = fopen( file_name.c_str(), "rb" );
+    if (file == NULL)
+        return false;
+
+    fclose( file );
+    return true;
+}
+
+// pick a temporary file name, returning an empty string on failure
+//
+std::string temp_file_name()
+{
+#ifdef WIN32
+    char* name = _tempnam( NULL, "nvbio-cram-" );
+    if (name == NULL)
+        return std::string();
+
+    const std::string r( name );
+    free( name );
+    return r;
+#else
+    // create the file right away, so as to reserve its name
+    const char* dir = getenv( "TMPDIR" );
+
+    std::string name = std::string( dir && dir[0] ? dir : "/tmp" ) + "/nvbio-cram-XXXXXX";
+    const int fd = mkstemp( &name[0] );
+    if (fd == -1)
+        return std::string();
+
+    ::close( fd );
+    return name;
+#endif
+}
+
+// export a .pac archive to a FASTA file
+//
+bool export_pac_reference(const char* prefix, const std::string& fasta_name)
+{
+    log_info(stderr, "exporting reference %s to %s\n", prefix, fasta_name.c_str());
+
+    SequenceDataHost reference;
+    if (load_pac( DNA, &reference, prefix, SequenceFlags( SEQUENCE_DATA | SEQUENCE_NAMES ), Phred33 ) == false)
+        return false;
+
+    FILE* file = fopen( fasta_name.c_str(), "w" );
+    if (file == NULL)
+    {
+        log_error(stderr, "unable to create %s\n", fasta_name.c_str());
+        return false;
+    }
+
+    const SequenceDataAccess<DNA> access( reference );
+
+    const uint32 LINE_LENGTH = 60;
+    char line[ LINE_LENGTH + 1 ];
+
+    for (uint32 i = 0; i < reference.size(); ++i)
+    {
+        const SequenceDataAccess<DNA>::name_string     name = access.get_name(i);
+        const SequenceDataAccess<DNA>::sequence_string seq  = access.get_read(i);
+
+        fprintf( file, ">%.*s\n", int( name.length() ), name.begin() );
+
+        for (uint32 j = 0; j < seq.length(); j += LINE_LENGTH)
+        {
+            const uint32 n = nvbio::min( LINE_LENGTH, seq.length() - j );
+            for (uint32 k = 0; k < n; ++k)
+                line[k] = dna_to_char( seq[j + k] );
+
+            line[n] = '\n';
+            fwrite( line, 1u, n + 1u, file );
+        }
+    }
+
+    const bool ok = ferror( file ) == 0;
+    fclose( file );
+
+    if (ok == false)
+    {
+        log_error(stderr, "failed writing %s\n", fasta_name.c_str());
+        remove( fasta_name.c_str() );
+    }
+    return ok;
+}
+
+} // anonymous namespace
+
+SequenceDataFile_CRAM::SequenceDataFile_CRAM(
+    const char*                      read_file_name,
+    const SequenceDataFile::Options& options,
+    const uint32                     n_threads,
+    const char*                      reference_name)
+  : SequenceDataFile_BAM( options, n_threads ),
+    m_file_name( read_file_name ),
+    m_temp_reference( false ),
+    m_file( NULL )
+{
+    m_file_state = FILE_OK;
+
+    if (reference_name == NULL)
+        return;
+
+    // htslib needs a FASTA reference: export .pac archives to a temporary one
+    if (is_pac_archive( reference_name ))
+    {
+        log_warning(stderr, "decoding CRAM file %s against the .pac archive %s\n", read_file_name, reference_name);
+        log_warning(stderr, "  .pac archives don't retain ambiguous bases: the reference MD5 checks are disabled,\n");
+        log_warning(stderr, "  and reads overlapping N runs may be decoded wrongly - pass the original FASTA instead\n");
+
+        m_reference_name = temp_file_name();
+        if (m_reference_name.empty())
+        {
+            log_error(stderr, "unable to create a temporary reference file\n");
+            m_file_state = FILE_OPEN_FAILED;
+            return;
+        }
+        m_temp_reference = true;
+
+        if (export_pac_reference( reference_name, m_reference_name ) == false)
+        {
+            m_file_state = FILE_OPEN_FAILED;
+            return;
+        }
+    }
+    else
+        m_reference_name = reference_name;
+
+    // and an index to go along with it
+    if (file_exists( m_reference_name + ".fai" ) == false &&
+        fai_build( m_reference_name.c_str() ) != 0)
+    {
+        log_error(stderr, "unable to index reference %s\n", m_reference_name.c_str());
+        m_file_state = FILE_OPEN_FAILED;
+    }
+}
+
+SequenceDataFile_CRAM::~SequenceDataFile_CRAM()
+{
+    close();
+
+    // remove the exported reference, together with its index
+    if (m_temp_reference)
+    {
+        remove( m_reference_name.c_str() );
+        remove( (m_reference_name + ".fai").c_str() );
+    }
+}
+
+// close the file
+//
+void SequenceDataFile_CRAM::close()
+{
+    if (m_file == NULL)
+        return;
+
+    if (m_file->record) bam_destroy1( m_file->record );
+    if (m_file->header) bam_hdr_destroy( m_file->header );
+    if (m_file->fp)     sam_close( m_file->fp );
+
+    delete m_file;
+    m_file = NULL;
+}
+
+// initialize the stream
+//
+bool SequenceDataFile_CRAM::init(void)
+{
+    if (m_file_state == FILE_OPEN_FAILED)
+        return false;
+
+    close();
+
+    m_file = new HTSFile();
+    m_file->fp = sam_open( m_file_name.c_str(), "r" );
+    if (m_file->fp == NULL || m_file->fp->is_cram == 0)
+    {
+        log_error(stderr, "unable to open CRAM file %s\n", m_file_name.c_str());
+        m_file_state = FILE_OPEN_FAILED;
+        return false;
+    }
+
+    cram_fd* cram = m_file->fp->fp.cram;
+
+    // the MD and NM tags aren't needed to recover the reads
+    cram_set_option( cram, CRAM_OPT_DECODE_MD, 0 );
+
+    // decode the containers on a pool of worker threads
+    if (m_n_threads > 1)
+        cram_set_option( cram, CRAM_OPT_NTHREADS, int( m_n_threads ) );
+
+    if (m_reference_name.empty() == false &&
+        cram_set_option( cram, CRAM_OPT_REFERENCE, m_reference_name.c_str() ) != 0)
+    {
+        log_error(stderr, "unable to load reference %s\n", m_reference_name.c_str());
+        m_file_state = FILE_OPEN_FAILED;
+        return false;
+    }
+
+    // references exported from .pac archives lack the ambiguous bases their checksums cover
+    if (m_temp_reference)
+        cram_set_option( cram, CRAM_OPT_IGNORE_MD5, 1 );
+
+    m_file->header = sam_hdr_read( m_file->fp );
+    if (m_file->header == NULL)
+    {
+        log_error(stderr, "error parsing CRAM file %s (invalid header)\n", m_file_name.c_str());
+        m_file_state = FILE_PARSE_ERROR;
+        return false;
+    }
+
+    m_file->record = bam_init1();
+
+    m_pending    = false;
+    m_file_state = FILE_OK;
+    return true;
+}
+
+// rewind the file
+//
+bool SequenceDataFile_CRAM::rewind()
+{
+    if (m_file == NULL)
+        return false;
+
+    // htslib can't seek back to the first container, so reopen the file
+    return init();
+}
+
+// read the next record in the record buffer, returning false on EOF or errors
+//
+bool SequenceDataFile_CRAM::read_record(Record* record, uint32* flags)
+{
+    bam1_t* b = m_file->record;
+
+    const int ret = sam_read1( m_file->fp, m_file->header, b );
+    if (ret < 0)
+    {
+        if (cram_eof( m_file->fp->fp.cram ))
+            m_file_state = FILE_EOF;
+        else
+        {
+            log_error(stderr, "error decoding CRAM file %s\n", m_file_name.c_str());
+            m_file_state = FILE_STREAM_ERROR;
+        }
+        return false;
+    }
+
+    // lay the record out as in a BAM file, skipping block_size
+    const bam1_core_t& core = b->core;
+
+    const uint32 fields[ BAM_ALIGNMENT_FIELDS / sizeof(uint32) ] = {
+        uint32( core.tid ),
+        uint32( core.pos ),
+        (uint32( core.bin ) << 16) | (uint32( core.qual ) << 8) | uint32( core.l_qname ),
+        (uint32( core.flag ) << 16) | uint32( core.n_cigar ),
+        uint32( core.l_qseq ),
+        uint32( core.mtid ),
+        uint32( core.mpos ),
+        uint32( core.isize )
+    };
+
+    const uint32 offset     = uint32( m_record_data.size() );
+    const uint32 block_size = BAM_ALIGNMENT_FIELDS + uint32( b->l_data );
+
+    m_record_data.resize( offset + block_size );
+    memcpy( &m_record_data[ offset ],                        fields,  BAM_ALIGNMENT_FIELDS );
+    memcpy( &m_record_data[ offset + BAM_ALIGNMENT_FIELDS ], b->data, b->l_data );
+
+    return parse_record( offset, block_size, record, flags );
+}
+
+#else // NVBIO_CRAM
+
+struct SequenceDataFile_CRAM::HTSFile {};
+
+SequenceDataFile_CRAM::SequenceDataFile_CRAM(
+    const char*                      read_file_name,
+    const SequenceDataFile::Options& options,
+    const uint32                     n_threads,
+    const char*                      reference_name)
+  : SequenceDataFile_BAM( options, n_threads ),
+    m_file_name( read_file_name ),
+    m_file( NULL )
+{
+    log_error(stderr, "unable to open %s: nvbio was built without CRAM support\n", read_file_name);
+    m_file_state = FILE_OPEN_FAILED;
+}
+
+SequenceDataFile_CRAM::~SequenceDataFile_CRAM() {}
+
+void SequenceDataFile_CRAM::close() {}
+bool SequenceDataFile_CRAM::init(void)                              { return false; }
+bool SequenceDataFile_CRAM::rewind()                                { return false; }
+bool SequenceDataFile_CRAM::read_record(Record* record, uint32* flags) { return false; }
+
+#endif // NVBIO_CRAM
+
+///@} // SequenceIODetail
+///@} // SequenceIO
+///@} // IO
+
+} // namespace io
+} // namespace nvbio
@@ -0,0 +1,108 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#pragma once
+
+#include <nvbio/io/sequence/sequence_bam.h>
+
+#include <string>
+
+namespace nvbio {
+namespace io {
+
+///@addtogroup IO
+///@{
+
+///@addtogroup SequenceIO
+///@{
+
+///@addtogroup SequenceIODetail
+///@{
+
+///
+/// SequenceDataFile from a CRAM file, decoded by the bundled htslib.
+///
+/// The CRAM containers are decoded by a pool of htslib worker threads, and the resulting
+/// records are gathered, filtered and decoded in bulk exactly as in SequenceDataFile_BAM.
+/// Reference-compressed files need the FASTA reference they were encoded against, whose .fai
+/// index is built if missing.
+/// A .pac archive is also accepted as a fallback, and exported to a temporary FASTA file which is
+/// removed with the stream. As .pac archives don't retain ambiguous bases, the export can't match
+/// the MD5 checksums htslib verifies against the CRAM header: these checks are then disabled,
+/// with a warning, and reads overlapping N runs of the original reference may be decoded wrongly.
+///
+/// This driver is only available when nvbio is built with the CRAM option (NVBIO_CRAM).
+///
+struct SequenceDataFile_CRAM : public SequenceDataFile_BAM
+{
+    /// constructor
+    ///
+    /// \param read_file_name       the file to open
+    /// \param options              the loading options
+    /// \param n_threads            the number of decoding threads, or 0 to use all OpenMP threads
+    /// \param reference_name       the reference FASTA file, or a .pac archive as a fallback, or NULL to
+    ///                             let htslib locate it through the REF_PATH and REF_CACHE environment variables
+    ///
+    SequenceDataFile_CRAM(
+        const char*                      read_file_name,
+        const SequenceDataFile::Options& options,
+        const uint32                     n_threads      = 0,
+        const char*                      reference_name = NULL);
+
+    /// destructor
+    ///
+    ~SequenceDataFile_CRAM();
+
+    /// rewind the file
+    ///
+    virtual bool rewind();
+
+    /// initialize the stream
+    ///
+    virtual bool init(void);
+
+protected:
+    // read the next record in the record buffer, returning false on EOF or errors
+    virtual bool read_record(Record* record, uint32* flags);
+
+private:
+    // close the file
+    void close();
+
+    struct HTSFile;
+
+    std::string m_file_name;
+    std::string m_reference_name;
+    bool        m_temp_reference;
+    HTSFile*    m_file;
+};
+
+///@} // SequenceIODetail
+///@} // SequenceIO
+///@} // IO
+
+} // namespace io
+} // namespace nvbio
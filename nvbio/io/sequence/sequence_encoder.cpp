@@ -26,7 +26,13 @@
  */
 
 #include <nvbio/io/sequence/sequence_encoder.h>
+#include <nvbio/basic/omp.h>
 #include <stdio.h>
+#include <algorithm>
+
+#if defined(PLATFORM_X86) && defined(__SSSE3__)
+#include <tmmintrin.h>                              // SSSE3 intrinsics
+#endif
 
 namespace nvbio {
 namespace io {
@@ -106,7 +112,8 @@ inline unsigned char convert_to_phred_quality(const uint8 q)
         return q - 64;
 
     case Solexa:
-        return s_solexa_to_phred[q];
+        // the table is indexed by the Solexa score + 10, i.e. by the ASCII value - 64 + 10
+        return q >= 54u ? s_solexa_to_phred[q - 54u] : 0u;
 
     default:
         break;
@@ -116,6 +123,35 @@ inline unsigned char convert_to_phred_quality(const uint8 q)
     return q;
 }
 
+// bin n plain Phred qualities in place, packing two 4-bit bin indices per byte
+// (the first in the low nibble); each output byte only overwrites qualities which
+// have already been consumed.
+inline void bin_qualities(const QualityBins& bins, const uint32 n, char* quals)
+{
+    uint8 table[256];
+    bins.bin_table( table );
+
+    const uint8* in  = (const uint8*)quals;
+          uint8* out = (uint8*)quals;
+
+    for (uint32 i = 0; i + 1u < n; i += 2u)
+        out[i/2] = table[ in[i] ] | (table[ in[i+1] ] << 4);
+
+    if (n & 1u)
+        out[n/2] = table[ in[n-1] ];
+}
+
+// expand n binned qualities in place back to the Phred scores their bins represent,
+// proceeding backwards so as to consume each packed byte before overwriting it
+inline void unbin_qualities(const QualityBins& bins, const uint32 n, char* quals)
+{
+    const uint8* in  = (const uint8*)quals;
+          uint8* out = (uint8*)quals;
+
+    for (uint32 i = n; i > 0; --i)
+        out[i-1] = bins.value( (in[(i-1)/2] >> (((i-1) & 1u)*4u)) & 15u );
+}
+
 } // anonymous namespace
 
 // a small sequence class supporting REVERSE | COMPLEMENT operations
@@ -151,10 +187,18 @@ struct sequence_string
         {
             const uint8 bp = from_char<ALPHABET>( c );
 
-            // TODO: implement complementing!
-            //if (FLAGS & SequenceDataEncoder::COMPLEMENT_OP)
-            //    return ???;
+            if (FLAGS & SequenceDataEncoder::COMPLEMENT_OP)
+            {
+                if (ALPHABET == RNA || ALPHABET == RNA_N)
+                    return bp < 4u ? 3u - bp : bp;
+
+                // IUPAC symbols are bitmasks of the bases they stand for, { A = 1, C = 2, G = 4, T = 8 },
+                // so complementing amounts to reversing their bits
+                if (ALPHABET == DNA_IUPAC)
+                    return uint8( ((bp & 1u) << 3) | ((bp & 2u) << 1) | ((bp & 4u) >> 1) | ((bp & 8u) >> 3) );
 
+                // proteins and ASCII text have no complement
+            }
             return bp;
         }
     }
@@ -162,7 +206,7 @@ struct sequence_string
     // quality operator
     uint8 quality(const uint32 i) const
     {
-        const uint32 index = (FLAGS & REVERSE) ? m_len - i - 1u : i;
+        const uint32 index = (FLAGS & SequenceDataEncoder::REVERSE_OP) ? m_len - i - 1u : i;
 
         return m_qual[index];
     }
@@ -230,39 +274,249 @@ void encode(
     }
 }
 
-// encode a sequence according to some given run-time flags and quality-encoding
+// a substring of a sequence_string, used to encode long strands a piece at a time
+//
+template <typename sequence_type>
+struct sequence_infix
+{
+    // constructor
+    sequence_infix(const sequence_type sequence, const uint32 begin, const uint32 end) : m_sequence(sequence), m_begin(begin), m_end(end) {}
+
+    // string length
+    uint32 length() const { return m_end - m_begin; }
+
+    // indexing operator
+    uint8 operator[] (const uint32 i) const { return m_sequence[ m_begin + i ]; }
+
+    // quality operator
+    uint8 quality(const uint32 i) const { return m_sequence.quality( m_begin + i ); }
+
+    const sequence_type m_sequence;
+    const uint32        m_begin;
+    const uint32        m_end;
+};
+
+#if defined(PLATFORM_X86) && defined(__SSSE3__)
+
+// convert 16 ASCII bases to the { A, C, G, T, N } alphabet, matching nst_nt4_encode()
+//
+inline __m128i nt4_encode(const __m128i c)
+{
+    const __m128i u = _mm_and_si128( c, _mm_set1_epi8( char(0xDF) ) ); // to upper case
+
+    const __m128i is_a = _mm_cmpeq_epi8( u, _mm_set1_epi8( 'A' ) );
+    const __m128i is_c = _mm_cmpeq_epi8( u, _mm_set1_epi8( 'C' ) );
+    const __m128i is_g = _mm_cmpeq_epi8( u, _mm_set1_epi8( 'G' ) );
+    const __m128i is_t = _mm_cmpeq_epi8( u, _mm_set1_epi8( 'T' ) );
+    const __m128i is_d = _mm_cmpeq_epi8( c, _mm_set1_epi8( '-' ) );
+
+    const __m128i known = _mm_or_si128( _mm_or_si128( is_a, is_c ), _mm_or_si128( is_g, is_t ) );
+
+    __m128i bp = _mm_and_si128( is_c, _mm_set1_epi8( 1 ) );
+    bp = _mm_or_si128( bp, _mm_and_si128( is_g, _mm_set1_epi8( 2 ) ) );
+    bp = _mm_or_si128( bp, _mm_and_si128( is_t, _mm_set1_epi8( 3 ) ) );
+    bp = _mm_or_si128( bp, _mm_andnot_si128( known, _mm_set1_epi8( 4 ) ) );      // N
+    return _mm_xor_si128( bp, _mm_and_si128( is_d, _mm_set1_epi8( 1 ) ) );        // '-' = 5
+}
+
+// complement 16 symbols of the { A, C, G, T, N } alphabet
+//
+inline __m128i nt4_complement(const __m128i bp)
+{
+    return _mm_shuffle_epi8( _mm_setr_epi8( 3, 2, 1, 0, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4 ), bp );
+}
+
+// reverse the order of 16 bytes
+//
+inline __m128i reverse_bytes(const __m128i v)
+{
+    return _mm_shuffle_epi8( v, _mm_setr_epi8( 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 ) );
+}
+
+// load the 16 characters at positions [i, i + 16) of a possibly reversed string of length len
+//
+template <bool REVERSE>
+inline __m128i load_chars(const uint8* string, const uint32 len, const uint32 i)
+{
+    return REVERSE ?
+        reverse_bytes( _mm_loadu_si128( (const __m128i*)( string + len - i - 16u ) ) ) :
+                       _mm_loadu_si128( (const __m128i*)( string + i ) );
+}
+
+// pack 16 symbols into big-endian 32-bit words of 2-bit (one word) or 4-bit symbols (two words)
+//
+template <uint32 SYMBOL_SIZE>
+inline void pack_symbols(const __m128i bp, uint32* words)
+{
+    if (SYMBOL_SIZE == 2)
+    {
+        // merge pairs of symbols into nibbles, pairs of nibbles into bytes, and reverse the bytes of each word
+        const __m128i v = _mm_maddubs_epi16( _mm_and_si128( bp, _mm_set1_epi8( 3 ) ), _mm_set1_epi16( 0x0104 ) );
+        const __m128i u = _mm_madd_epi16( v, _mm_set1_epi32( 0x00010010 ) );
+        *words = uint32( _mm_cvtsi128_si32( _mm_shuffle_epi8( u, _mm_setr_epi8( 12, 8, 4, 0, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 ) ) ) );
+    }
+    else
+    {
+        // merge pairs of symbols into bytes, and reverse the bytes of each word
+        const __m128i v = _mm_maddubs_epi16( bp, _mm_set1_epi16( 0x0110 ) );
+        _mm_storel_epi64( (__m128i*)words, _mm_shuffle_epi8( v, _mm_setr_epi8( 6, 4, 2, 0, 14, 12, 10, 8, -1, -1, -1, -1, -1, -1, -1, -1 ) ) );
+    }
+}
+
+// convert the qualities at positions [begin, end) of a possibly reversed string to Phred,
+// 16 at a time
+//
+template <bool REVERSE>
+void encode_qualities(
+    const QualityEncoding   quality_encoding,
+    const uint32            len,
+    const uint32            begin,
+    const uint32            end,
+    const uint8*            quality,
+    char*                   qual_stream)
+{
+    if (quality_encoding == Solexa)
+    {
+        for (uint32 i = begin; i < end; ++i)
+            qual_stream[i - begin] = convert_to_phred_quality<Solexa>( quality[ REVERSE ? len - i - 1u : i ] );
+        return;
+    }
+
+    const uint8 offset = quality_encoding == Phred33 ? 33u :
+                         quality_encoding == Phred64 ? 64u : 0u;
+
+    const __m128i offset_v = _mm_set1_epi8( char(offset) );
+
+    uint32 i = begin;
+    for (; i + 16u <= end; i += 16u)
+        _mm_storeu_si128( (__m128i*)( qual_stream + i - begin ), _mm_sub_epi8( load_chars<REVERSE>( quality, len, i ), offset_v ) );
+
+    for (; i < end; ++i)
+        qual_stream[i - begin] = char( quality[ REVERSE ? len - i - 1u : i ] - offset );
+}
+
+// encode the [begin, end) portion of a DNA strand directly into the words of the packed stream,
+// 16 bases at a time, leaving the partially covered words at either end to the serial assign()
+//
+template <Alphabet ALPHABET, SequenceDataEncoder::StrandOp FLAGS>
+void encode_simd(
+    const QualityEncoding                                                           quality_encoding,
+    const uint32                                                                    sequence_len,
+    const uint32                                                                    begin,
+    const uint32                                                                    end,
+    const uint8*                                                                    sequence,
+    const uint8*                                                                    quality,
+    typename SequenceDataEdit<ALPHABET,SequenceDataView>::sequence_stream_type      stream,
+    char*                                                                           qual_stream)
+{
+    typedef sequence_string<ALPHABET,FLAGS> sequence_type;
+
+    const bool   REVERSE          = (FLAGS & SequenceDataEncoder::REVERSE_OP)    != 0;
+    const bool   COMPLEMENT       = (FLAGS & SequenceDataEncoder::COMPLEMENT_OP) != 0;
+    const uint32 SYMBOL_SIZE      = SequenceDataTraits<ALPHABET>::SEQUENCE_BITS;
+    const uint32 SYMBOLS_PER_WORD = SequenceDataTraits<ALPHABET>::SEQUENCE_SYMBOLS_PER_WORD;
+
+    const sequence_type string( sequence_len, sequence, quality );
+
+    // fill the first word up to a word boundary
+    const uint32 word_offset = uint32( stream.index() ) & (SYMBOLS_PER_WORD-1);
+    const uint32 head        = nvbio::min( (SYMBOLS_PER_WORD - word_offset) & (SYMBOLS_PER_WORD-1), end - begin );
+    if (head)
+        assign( head, sequence_infix<sequence_type>( string, begin, begin + head ), stream );
+
+    // encode all whole words
+    uint32* words = stream.stream() + (stream.index() + head) / SYMBOLS_PER_WORD;
+
+    uint32 i = begin + head;
+    for (; i + 16u <= end; i += 16u, words += 16u / SYMBOLS_PER_WORD)
+    {
+        const __m128i bp = nt4_encode( load_chars<REVERSE>( sequence, sequence_len, i ) );
+
+        pack_symbols<SYMBOL_SIZE>( COMPLEMENT ? nt4_complement( bp ) : bp, words );
+    }
+
+    // and the remainder
+    if (i < end)
+        assign( end - i, sequence_infix<sequence_type>( string, i, end ), stream + (i - begin) );
+
+    encode_qualities<REVERSE>( quality_encoding, sequence_len, begin, end, quality, qual_stream );
+}
+
+#endif
+
+// encode the [begin, end) portion of a sequence according to some given run-time flags and quality-encoding
 //
 template <Alphabet ALPHABET>
 void encode(
     const SequenceDataEncoder::StrandOp                                             conversion_flags,
     const QualityEncoding                                                           quality_encoding,
     const uint32                                                                    sequence_len,
+    const uint32                                                                    begin,
+    const uint32                                                                    end,
     const uint8*                                                                    sequence,
     const uint8*                                                                    quality,
     typename SequenceDataEdit<ALPHABET,SequenceDataView>::sequence_stream_type      stream,
     char*                                                                           qual_stream)
 {
-    const sequence_string<ALPHABET,SequenceDataEncoder::REVERSE_OP>              r_sequence( sequence_len, sequence, quality );
-    const sequence_string<ALPHABET,SequenceDataEncoder::REVERSE_COMPLEMENT_OP>   rc_sequence( sequence_len, sequence, quality );
-    const sequence_string<ALPHABET,SequenceDataEncoder::COMPLEMENT_OP>           fc_sequence( sequence_len, sequence, quality );
-    const sequence_string<ALPHABET,SequenceDataEncoder::NO_OP>                   f_sequence( sequence_len, sequence, quality );
+    typedef sequence_string<ALPHABET,SequenceDataEncoder::REVERSE_OP>            r_sequence_type;
+    typedef sequence_string<ALPHABET,SequenceDataEncoder::REVERSE_COMPLEMENT_OP> rc_sequence_type;
+    typedef sequence_string<ALPHABET,SequenceDataEncoder::COMPLEMENT_OP>         fc_sequence_type;
+    typedef sequence_string<ALPHABET,SequenceDataEncoder::NO_OP>                 f_sequence_type;
+
+  #if defined(PLATFORM_X86) && defined(__SSSE3__)
+    // DNA strands take the vectorized path
+    if (ALPHABET == DNA || ALPHABET == DNA_N)
+    {
+        switch (conversion_flags)
+        {
+        case SequenceDataEncoder::NO_OP:
+            encode_simd<ALPHABET,SequenceDataEncoder::NO_OP>( quality_encoding, sequence_len, begin, end, sequence, quality, stream, qual_stream );
+            break;
+        case SequenceDataEncoder::REVERSE_OP:
+            encode_simd<ALPHABET,SequenceDataEncoder::REVERSE_OP>( quality_encoding, sequence_len, begin, end, sequence, quality, stream, qual_stream );
+            break;
+        case SequenceDataEncoder::COMPLEMENT_OP:
+            encode_simd<ALPHABET,SequenceDataEncoder::COMPLEMENT_OP>( quality_encoding, sequence_len, begin, end, sequence, quality, stream, qual_stream );
+            break;
+        case SequenceDataEncoder::REVERSE_COMPLEMENT_OP:
+            encode_simd<ALPHABET,SequenceDataEncoder::REVERSE_COMPLEMENT_OP>( quality_encoding, sequence_len, begin, end, sequence, quality, stream, qual_stream );
+            break;
+        }
+        return;
+    }
+  #endif
 
     if (conversion_flags & SequenceDataEncoder::REVERSE_OP)
     {
         if (conversion_flags & SequenceDataEncoder::COMPLEMENT_OP)
-            encode<ALPHABET>( quality_encoding, rc_sequence, stream, qual_stream );
+            encode<ALPHABET>( quality_encoding, sequence_infix<rc_sequence_type>( rc_sequence_type( sequence_len, sequence, quality ), begin, end ), stream, qual_stream );
         else
-            encode<ALPHABET>( quality_encoding, r_sequence,  stream, qual_stream );
+            encode<ALPHABET>( quality_encoding, sequence_infix<r_sequence_type>( r_sequence_type( sequence_len, sequence, quality ), begin, end ), stream, qual_stream );
     }
     else
     {
         if (conversion_flags & SequenceDataEncoder::COMPLEMENT_OP)
-            encode<ALPHABET>( quality_encoding, fc_sequence, stream, qual_stream );
+            encode<ALPHABET>( quality_encoding, sequence_infix<fc_sequence_type>( fc_sequence_type( sequence_len, sequence, quality ), begin, end ), stream, qual_stream );
         else
-            encode<ALPHABET>( quality_encoding, f_sequence,  stream, qual_stream );
+            encode<ALPHABET>( quality_encoding, sequence_infix<f_sequence_type>( f_sequence_type( sequence_len, sequence, quality ), begin, end ), stream, qual_stream );
     }
 }
 
+// encode a sequence according to some given run-time flags and quality-encoding
+//
+template <Alphabet ALPHABET>
+void encode(
+    const SequenceDataEncoder::StrandOp                                             conversion_flags,
+    const QualityEncoding                                                           quality_encoding,
+    const uint32                                                                    sequence_len,
+    const uint8*                                                                    sequence,
+    const uint8*                                                                    quality,
+    typename SequenceDataEdit<ALPHABET,SequenceDataView>::sequence_stream_type      stream,
+    char*                                                                           qual_stream)
+{
+    encode<ALPHABET>( conversion_flags, quality_encoding, sequence_len, 0u, sequence_len, sequence, quality, stream, qual_stream );
+}
+
 ///
 /// Concrete class to encode a host-side SequenceData object.
 ///
@@ -313,6 +567,13 @@ struct SequenceDataEncoderImpl : public SequenceDataEncoder
             m_data->m_name_index_vec[0] = 0;
         }
 
+        else if (m_data->m_quality_bins.is_plain() == false)
+        {
+            // expand the qualities appended to, which will be binned again at the end of the batch
+            unbin_qualities( m_data->m_quality_bins, m_data->m_sequence_stream_len, nvbio::raw_pointer( m_data->m_qual_vec ) );
+            m_data->m_quality_bins = QualityBins();
+        }
+
         // assign the alphabet
         m_data->m_alphabet = SEQUENCE_ALPHABET;
         m_data->m_has_qualities = true;
@@ -401,6 +662,140 @@ struct SequenceDataEncoderImpl : public SequenceDataEncoder
         m_data->m_name_index_vec[ m_data->m_n_seqs ] = m_data->m_name_stream_len;
     }
 
+    /// add a set of reads to the end of this batch, encoding them in parallel
+    ///
+    void push_back(
+        const uint32            n_sequences,
+        const uint32*           sequence_lens,
+        const char* const*      names,
+        const uint8* const*     base_pairs,
+        const uint8* const*     qualities,
+        const QualityEncoding   quality_encoding,
+        const uint32            max_sequence_len,
+        const uint32            trim3,
+        const uint32            trim5,
+        const SequenceEncoding  flags)
+    {
+        // list the strands to emit for each read
+        StrandOp ops[4];
+        uint32   n_ops = 0;
+        if (flags & FORWARD)            ops[ n_ops++ ] = NO_OP;
+        if (flags & REVERSE)            ops[ n_ops++ ] = REVERSE_OP;
+        if (flags & FORWARD_COMPLEMENT) ops[ n_ops++ ] = COMPLEMENT_OP;
+        if (flags & REVERSE_COMPLEMENT) ops[ n_ops++ ] = REVERSE_COMPLEMENT_OP;
+
+        const uint32 n_strands = n_sequences * n_ops;
+        if (n_strands == 0)
+            return;
+
+        const uint32 first_seq = m_data->m_n_seqs;
+
+        if (m_data->m_sequence_index_vec.size() < first_seq + n_strands + 1u)
+            m_data->m_sequence_index_vec.resize( (first_seq + n_strands + 1u)*2 );
+        if (m_data->m_name_index_vec.size() < first_seq + n_strands + 1u)
+            m_data->m_name_index_vec.resize( (first_seq + n_strands + 1u)*2 );
+
+        uint32* sequence_index = nvbio::raw_pointer( m_data->m_sequence_index_vec ) + first_seq;
+        uint32* name_index     = nvbio::raw_pointer( m_data->m_name_index_vec )     + first_seq;
+
+        // compute the offsets of all strands and names
+        uint32 stream_len = m_data->m_sequence_stream_len;
+        uint32 name_len   = m_data->m_name_stream_len;
+        for (uint32 i = 0; i < n_sequences; ++i)
+        {
+            const uint32 trimmed_len = sequence_lens[i] > trim3 + trim5 ?
+                                       sequence_lens[i] - trim3 - trim5 : 0u;
+
+            // truncate sequence
+            const uint32 sequence_len = nvbio::min( trimmed_len, max_sequence_len );
+            assert(sequence_len);
+
+            const uint32 name_size = uint32( strlen( names[i] ) ) + 1u;
+
+            for (uint32 op = 0; op < n_ops; ++op)
+            {
+                stream_len += sequence_len;
+                name_len   += name_size;
+
+                sequence_index[ i * n_ops + op + 1u ] = stream_len;
+                name_index[ i * n_ops + op + 1u ]     = name_len;
+            }
+
+            m_data->m_min_sequence_len = nvbio::min( m_data->m_min_sequence_len, sequence_len );
+            m_data->m_max_sequence_len = nvbio::max( m_data->m_max_sequence_len, sequence_len );
+        }
+
+        // resize the sequences, quality & name buffers
+        {
+            static const uint32 bps_per_word = 32u / SEQUENCE_BITS;
+            const uint32 words = util::divide_ri( stream_len, bps_per_word );
+
+            if (m_data->m_sequence_vec.size() < words)
+                m_data->m_sequence_vec.resize( words*2 );
+            if (m_data->m_qual_vec.size() < stream_len)
+                m_data->m_qual_vec.resize( stream_len*2 );
+            if (m_data->m_name_vec.size() < name_len)
+                m_data->m_name_vec.resize( name_len*2 );
+
+            m_data->m_sequence_stream_words = words;
+        }
+
+        typename SequenceDataEdit<SEQUENCE_ALPHABET,SequenceDataView>::sequence_stream_type stream( nvbio::raw_pointer( m_data->m_sequence_vec ) );
+        char* qual_stream = nvbio::raw_pointer( m_data->m_qual_vec );
+        char* name_stream = nvbio::raw_pointer( m_data->m_name_vec );
+
+        // split the output stream in word-aligned groups of symbols, encoded concurrently;
+        // strands straddling a group boundary are split, so that no two threads ever touch
+        // the same word of the packed stream
+        const uint32 first_symbol = m_data->m_sequence_stream_len;
+        const uint32 n_threads    = uint32( omp_get_max_threads() );
+        const uint32 group_len    = util::round_i(
+            nvbio::max( util::divide_ri( stream_len - first_symbol, n_threads * 8u ), 16u*1024u ),
+            SEQUENCE_SYMBOLS_PER_WORD );
+
+        const uint32 first_group = first_symbol / group_len;
+        const int32  n_groups    = int32( util::divide_ri( stream_len, group_len ) - first_group );
+
+        #pragma omp parallel for schedule(dynamic) if (n_groups > 1)
+        for (int32 g = 0; g < n_groups; ++g)
+        {
+            const uint32 group_begin = nvbio::max( (first_group + g) * group_len, first_symbol );
+            const uint32 group_end   = nvbio::min( (first_group + g + 1u) * group_len, stream_len );
+
+            // find the first strand overlapping the group
+            uint32 k = uint32( std::upper_bound( sequence_index, sequence_index + n_strands + 1u, group_begin ) - sequence_index ) - 1u;
+
+            for (; k < n_strands && sequence_index[k] < group_end; ++k)
+            {
+                const uint32 i = k / n_ops;
+
+                const uint32 begin = nvbio::max( sequence_index[k],   group_begin );
+                const uint32 end   = nvbio::min( sequence_index[k+1], group_end );
+
+                encode<SEQUENCE_ALPHABET>(
+                    ops[ k % n_ops ],
+                    quality_encoding,
+                    sequence_index[k+1] - sequence_index[k],
+                    begin - sequence_index[k],
+                    end   - sequence_index[k],
+                    base_pairs[i] + trim5,
+                    qualities[i]  + trim5,
+                    stream + begin,
+                    qual_stream + begin );
+            }
+        }
+
+        // copy the names
+        #pragma omp parallel for if (n_strands > 16u*1024u)
+        for (int32 k = 0; k < int32( n_strands ); ++k)
+            memcpy( name_stream + name_index[k], names[ k / n_ops ], name_index[k+1] - name_index[k] );
+
+        // update sequence and bp counts
+        m_data->m_n_seqs              += n_strands;
+        m_data->m_sequence_stream_len  = stream_len;
+        m_data->m_name_stream_len      = name_len;
+    }
+
     /// signals that the batch is complete
     ///
     void end_batch(void)
@@ -408,6 +803,13 @@ struct SequenceDataEncoderImpl : public SequenceDataEncoder
         assert( m_data->m_sequence_stream_words == util::divide_ri( m_data->m_sequence_stream_len, SEQUENCE_SYMBOLS_PER_WORD ) );
 
         m_data->m_avg_sequence_len = (uint32) ceilf(float(m_data->m_sequence_stream_len) / float(m_data->m_n_seqs));
+
+        // bin the qualities, if requested
+        if (m_data->quality_binning().is_plain() == false)
+        {
+            bin_qualities( m_data->quality_binning(), m_data->m_sequence_stream_len, nvbio::raw_pointer( m_data->m_qual_vec ) );
+            m_data->m_quality_bins = m_data->quality_binning();
+        }
     }
 
     /// return the sequence data info
@@ -431,6 +833,9 @@ SequenceDataEncoder* create_encoder(const Alphabet alphabet, SequenceDataHost* d
     case DNA_N:
         return new SequenceDataEncoderImpl<DNA_N>( data );
         break;
+    case DNA_IUPAC:
+        return new SequenceDataEncoderImpl<DNA_IUPAC>( data );
+        break;
     case PROTEIN:
         return new SequenceDataEncoderImpl<PROTEIN>( data );
         break;
@@ -450,6 +855,18 @@ SequenceDataEncoder* create_encoder(const Alphabet alphabet, SequenceDataHost* d
     return NULL;
 }
 
+// expand binned qualities back to plain Phred scores
+//
+void expand_qualities(SequenceDataHost* data)
+{
+    if (data->has_qualities() == false || data->m_quality_bins.is_plain())
+        return;
+
+    data->m_qual_vec.resize( data->m_sequence_stream_len );
+    unbin_qualities( data->m_quality_bins, data->m_sequence_stream_len, nvbio::raw_pointer( data->m_qual_vec ) );
+    data->m_quality_bins = QualityBins();
+}
+
 // next batch
 //
 int next(const Alphabet alphabet, SequenceDataHost* data, SequenceDataStream* stream, const uint32 batch_size, const uint32 batch_bps)
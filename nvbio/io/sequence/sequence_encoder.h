@@ -92,6 +92,48 @@ struct SequenceDataEncoder
         m_info.m_n_seqs++;
     }
 
+    /// add a set of reads to the end of this batch, emitting for each of them all the strands
+    /// selected by a set of SequenceEncoding flags, in the order FORWARD, REVERSE,
+    /// FORWARD_COMPLEMENT and REVERSE_COMPLEMENT.
+    /// The default implementation calls the single-read push_back() method on each strand,
+    /// while encoders are free to process the reads in parallel.
+    ///
+    /// \param n_sequences                  number of input reads
+    /// \param sequence_lens                input read lengths
+    /// \param names                        read names
+    /// \param base_pairs                   list of base pairs of each read
+    /// \param qualities                    list of base qualities of each read
+    /// \param quality_encoding             quality encoding scheme
+    /// \param max_sequence_len             truncate the reads if longer than this
+    /// \param trim3                        trim the first trim3 bases from the 3' end
+    /// \param trim5                        trim the first trim5 bases from the 5' end
+    /// \param flags                        the strands to emit for each read
+    ///
+    virtual void push_back(
+        const uint32            n_sequences,
+        const uint32*           sequence_lens,
+        const char* const*      names,
+        const uint8* const*     base_pairs,
+        const uint8* const*     qualities,
+        const QualityEncoding   quality_encoding,
+        const uint32            max_sequence_len,
+        const uint32            trim3,
+        const uint32            trim5,
+        const SequenceEncoding  flags)
+    {
+        for (uint32 i = 0; i < n_sequences; ++i)
+        {
+            if (flags & FORWARD)
+                push_back( sequence_lens[i], names[i], base_pairs[i], qualities[i], quality_encoding, max_sequence_len, trim3, trim5, NO_OP );
+            if (flags & REVERSE)
+                push_back( sequence_lens[i], names[i], base_pairs[i], qualities[i], quality_encoding, max_sequence_len, trim3, trim5, REVERSE_OP );
+            if (flags & FORWARD_COMPLEMENT)
+                push_back( sequence_lens[i], names[i], base_pairs[i], qualities[i], quality_encoding, max_sequence_len, trim3, trim5, COMPLEMENT_OP );
+            if (flags & REVERSE_COMPLEMENT)
+                push_back( sequence_lens[i], names[i], base_pairs[i], qualities[i], quality_encoding, max_sequence_len, trim3, trim5, REVERSE_COMPLEMENT_OP );
+        }
+    }
+
     /// signals that a batch is to begin
     ///
     virtual void begin_batch(void) { m_info = SequenceDataInfo(); }
@@ -28,11 +28,19 @@
 #include <nvbio/io/sequence/sequence_fastq.h>
 #include <nvbio/io/sequence/sequence_encoder.h>
 #include <nvbio/basic/types.h>
+#include <nvbio/basic/popcount.h>
 #include <nvbio/basic/timer.h>
 
 #include <string.h>
 #include <ctype.h>
 
+#if defined(PLATFORM_X86)
+#include <emmintrin.h>                              // SSE2 intrinsics
+#if defined(__AVX2__)
+#include <immintrin.h>                              // AVX2 intrinsics
+#endif
+#endif
+
 namespace nvbio {
 namespace io {
 
@@ -45,11 +53,367 @@ namespace io {
 ///@addtogroup SequenceIODetail
 ///@{
 
+namespace {
+
+// append the offsets of all the newlines in buffer[begin, end) to a list
+//
+void find_newlines(const char* buffer, uint32 begin, const uint32 end, std::vector<uint32>& newlines)
+{
+#if defined(PLATFORM_X86)
+  #if defined(__AVX2__)
+    const __m256i nl32 = _mm256_set1_epi8( '\n' );
+    for (; begin + 32u <= end; begin += 32u)
+    {
+        uint32 mask = (uint32)_mm256_movemask_epi8( _mm256_cmpeq_epi8( _mm256_loadu_si256( (const __m256i*)(buffer + begin) ), nl32 ) );
+        for (; mask; mask &= mask - 1u)
+            newlines.push_back( begin + ffs( int32(mask) ) - 1u );
+    }
+  #endif
+    const __m128i nl16 = _mm_set1_epi8( '\n' );
+    for (; begin + 16u <= end; begin += 16u)
+    {
+        uint32 mask = (uint32)_mm_movemask_epi8( _mm_cmpeq_epi8( _mm_loadu_si128( (const __m128i*)(buffer + begin) ), nl16 ) );
+        for (; mask; mask &= mask - 1u)
+            newlines.push_back( begin + ffs( int32(mask) ) - 1u );
+    }
+#endif
+    for (; begin < end; ++begin)
+    {
+        if (buffer[begin] == '\n')
+            newlines.push_back( begin );
+    }
+}
+
+// check whether a string is entirely made of printable characters, i.e. isgraph()
+//
+bool is_graph(const char* str, const uint32 len)
+{
+    uint32 i = 0;
+#if defined(PLATFORM_X86)
+    const __m128i lo = _mm_set1_epi8( 0x20 );
+    const __m128i hi = _mm_set1_epi8( 0x7F );
+    for (; i + 16u <= len; i += 16u)
+    {
+        const __m128i c = _mm_loadu_si128( (const __m128i*)(str + i) );
+
+        // characters above 0x7F compare as negative and are hence rejected by the first test
+        if (_mm_movemask_epi8( _mm_and_si128( _mm_cmpgt_epi8( c, lo ), _mm_cmplt_epi8( c, hi ) ) ) != 0xFFFF)
+            return false;
+    }
+#endif
+    for (; i < len; ++i)
+    {
+        if (str[i] < 0x21 || str[i] > 0x7E)
+            return false;
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+// locate all the newlines in m_buffer[m_newline_end, m_buffer_size)
+//
+void SequenceDataFile_FASTQ_parser::index_newlines()
+{
+    find_newlines( &m_buffer[0], m_newline_end, m_buffer_size, m_newlines );
+    m_newline_end = m_buffer_size;
+
+    // skip the newlines which have already been consumed
+    while (m_newline_pos < m_newlines.size() && m_newlines[ m_newline_pos ] < m_buffer_pos)
+        ++m_newline_pos;
+}
+
+// move the unconsumed data to the front of the buffer and append more from the file
+//
+SequenceDataFile_FASTQ_parser::FileState SequenceDataFile_FASTQ_parser::refill()
+{
+    if (m_buffer_eof)
+        return FILE_EOF;
+
+    if (m_buffer_pos)
+    {
+        const uint32 n_newlines = uint32( m_newlines.size() ) - m_newline_pos;
+
+        memmove( &m_buffer[0], &m_buffer[0] + m_buffer_pos, m_buffer_size - m_buffer_pos );
+        for (uint32 i = 0; i < n_newlines; ++i)
+            m_newlines[i] = m_newlines[ m_newline_pos + i ] - m_buffer_pos;
+
+        m_newlines.resize( n_newlines );
+        m_newline_pos  = 0;
+        m_newline_end -= m_buffer_pos;
+        m_buffer_size -= m_buffer_pos;
+        m_buffer_pos   = 0;
+    }
+
+    // a record doesn't fit in the buffer: expand it
+    if (m_buffer_size == m_buffer.size())
+        m_buffer.resize( m_buffer.size() * 2u );
+
+    const FileState state = fillBuffer();
+    if (state != FILE_OK)
+        m_buffer_eof = true;
+
+    return state;
+}
+
+// parse the next record directly from the buffer
+//
+SequenceDataFile_FASTQ_parser::RecordState SequenceDataFile_FASTQ_parser::scan_record(
+    const char**    name,
+    const uint8**   read_bp,
+    const uint8**   read_q,
+    uint32*         len)
+{
+    while (1)
+    {
+        index_newlines();
+
+        char* buffer = &m_buffer[0];
+
+        // consume spaces & newlines
+        for (; m_buffer_pos < m_buffer_size && buffer[ m_buffer_pos ] >= 1 && buffer[ m_buffer_pos ] <= 31; ++m_buffer_pos)
+        {
+            // count lines
+            if (buffer[ m_buffer_pos ] == '\n')
+            {
+                m_line++;
+                m_newline_pos++;
+            }
+        }
+
+        if (m_buffer_pos < m_buffer_size)
+        {
+            // let the fallback parser report errors
+            if (buffer[ m_buffer_pos ] != '@')
+                return RECORD_FALLBACK;
+
+            // check whether the record is entirely contained in the buffer; the newline
+            // ending the last line is optional at the end of the file
+            const uint32 n_newlines = uint32( m_newlines.size() ) - m_newline_pos;
+            if (n_newlines >= 4u || (n_newlines == 3u && m_buffer_eof))
+            {
+                const uint32* nl = &m_newlines[ m_newline_pos ];
+
+                const uint32 name_begin = m_buffer_pos + 1u;
+                const uint32 bp_begin   = nl[0] + 1u;
+                const uint32 plus_begin = nl[1] + 1u;
+                const uint32 q_begin    = nl[2] + 1u;
+                const uint32 q_end      = n_newlines >= 4u ? nl[3] : m_buffer_size;
+
+                // strip DOS line endings
+                const uint32 name_end = (nl[0] > name_begin && buffer[ nl[0] - 1u ] == '\r') ? nl[0] - 1u : nl[0];
+                const uint32 bp_end   = (nl[1] > bp_begin && buffer[ nl[1] - 1u ] == '\r') ? nl[1] - 1u : nl[1];
+                const uint32 q_trim   = (q_end > q_begin && buffer[ q_end - 1u ] == '\r') ? q_end - 1u : q_end;
+
+                const uint32 bp_len = bp_end - bp_begin;
+
+                // check whether this is a plain four-line record
+                if (buffer[ plus_begin ] != '+' ||
+                    q_trim - q_begin != bp_len  ||
+                    is_graph( buffer + bp_begin, bp_len ) == false ||
+                    is_graph( buffer + q_begin,  bp_len ) == false)
+                    return RECORD_FALLBACK;
+
+                // terminate the name in place
+                buffer[ name_end ] = '\0';
+
+                *name    = buffer + name_begin;
+                *read_bp = (const uint8*)buffer + bp_begin;
+                *read_q  = (const uint8*)buffer + q_begin;
+                *len     = bp_len;
+
+                m_buffer_pos   = n_newlines >= 4u ? q_end + 1u : q_end;
+                m_newline_pos += n_newlines >= 4u ? 4u : 3u;
+                m_line        += 4u;
+                return RECORD_OK;
+            }
+        }
+
+        // we need more data
+        const bool      was_eof = m_buffer_eof;
+        const FileState state   = refill();
+        if (state == FILE_OK)
+            continue;
+
+        if (state == FILE_EOF)
+        {
+            if (m_buffer_pos < m_buffer_size)
+            {
+                // try once more, knowing the last record might not end with a newline
+                if (was_eof == false)
+                    continue;
+
+                // let the fallback parser deal with incomplete records
+                return RECORD_FALLBACK;
+            }
+
+            m_file_state = FILE_EOF;
+            return RECORD_EOF;
+        }
+
+        m_file_state = state;
+        return RECORD_ERROR;
+    }
+}
+
+// parse the next record character by character
+//
+int SequenceDataFile_FASTQ_parser::parse_record(uint32* read_len_ptr)
+{
+    char marker;
+
+    // consume spaces & newlines
+    do {
+        marker = get();
+
+        // count lines
+        if (marker == '\n')
+            m_line++;
+    }
+    while (marker >= 1 && marker <= 31);
+
+    // check for EOF or read errors
+    if (m_file_state != FILE_OK)
+        return 0;
+
+    // if the newlines didn't end in a read marker,
+    // issue a parsing error...
+    if (marker != '@')
+    {
+        log_error(stderr, "FASTQ loader: parsing error at %u!\n", m_line);
+
+        m_file_state = FILE_PARSE_ERROR;
+        m_error_char = marker;
+        return -1;
+    }
+
+    // read all the line
+    uint32 len = 0;
+    for (uint8 c = get(); c != '\n' && c != 0; c = get())
+    {
+        m_name[ len++ ] = c;
+
+        // expand on demand
+        if (m_name.size() <= len)
+            m_name.resize( len * 2u );
+    }
+
+    // strip DOS line endings
+    if (len && m_name[ len-1 ] == '\r')
+        --len;
+
+    m_name[ len++ ] = '\0';
+
+    // check for errors
+    if (m_file_state != FILE_OK)
+    {
+        log_error(stderr, "FASTQ loader: incomplete read at line %u!\n", m_line);
+
+        m_error_char = 0;
+        return -1;
+    }
+
+    m_line++;
+
+    // start reading the bp read
+    len = 0;
+    for (char c = get(); c != '+' && c != 0; c = get())
+    {
+        // if (isgraph(c))
+        if (c >= 0x21 && c <= 0x7E)
+            m_read_bp[ len++ ] = c;
+        else if (c == '\n')
+            m_line++;
+
+        // expand on demand
+        if (m_read_bp.size() <= len)
+        {
+            m_read_bp.resize( len * 2u );
+            m_read_q.resize(  len * 2u );
+        }
+    }
+
+    const uint32 read_len = len;
+
+    // check for errors
+    if (m_file_state != FILE_OK)
+    {
+        log_error(stderr, "FASTQ loader: incomplete read at line %u!\n", m_line);
+
+        m_error_char = 0;
+        return -1;
+    }
+
+    // read all the line
+    for (char c = get(); c != '\n' && c != 0; c = get()) {}
+
+    // check for errors
+    if (m_file_state != FILE_OK)
+    {
+        log_error(stderr, "FASTQ loader: incomplete read at line %u!\n", m_line);
+
+        m_error_char = 0;
+        return -1;
+    }
+
+    m_line++;
+
+    // start reading the quality read
+    len = 0;
+
+    // read as many qualities as there are in the read, without reading past the last one:
+    // a last record might not end with a newline
+    while (len < read_len)
+    {
+        const char c = get();
+        if (m_file_state != FILE_OK)
+            break;
+
+        // if (isgraph(c))
+        if (c >= 0x21 && c <= 0x7E)
+            m_read_q[ len++ ] = c;
+        else if (c == '\n')
+            m_line++;
+    }
+    /*
+    // the below works for proper FASTQ files, but not for old Sanger ones
+    // allowing strings to span multiple lines...
+    for (uint8 c = get(); c != '\n' && c != 0; c = get())
+        m_read_q[ len++ ] = c;
+
+    if (len < read_len)
+    {
+        m_read_bp[ read_len ] = '\0';
+        m_read_q[ len ] = '\0';
+
+        log_error(stderr, "FASTQ loader: qualities and read lengths differ at line %u!\n", m_line);
+        log_error(stderr, "  name: %s\n", &m_name[0]);
+        log_error(stderr, "  read: %s\n", &m_read_bp[0]);
+        log_error(stderr, "  qual: %s\n", &m_read_q[0]);
+
+        m_file_state = FILE_PARSE_ERROR;
+
+        m_error_char = 0;
+        return -1;
+    }*/
+
+    // check for errors
+    if (m_file_state != FILE_OK)
+    {
+        log_error(stderr, "FASTQ loader: incomplete read at line %u!\n", m_line);
+
+        m_error_char = 0;
+        return -1;
+    }
+
+    *read_len_ptr = len;
+    return 1;
+}
+
 int SequenceDataFile_FASTQ_parser::nextChunk(SequenceDataEncoder *output, uint32 max_reads, uint32 max_bps)
 {
     uint32 n_reads = 0;
     uint32 n_bps   = 0;
-    char   marker;
 
     const uint32 read_mult =
         ((m_options.flags & FORWARD)            ? 1u : 0u) +
@@ -108,151 +472,46 @@ int SequenceDataFile_FASTQ_parser::nextChunk(SequenceDataEncoder *output, uint32
             return -1;
         }
         m_line++;
-    #else
-        // consume spaces & newlines
-        do {
-            marker = get();
 
-            // count lines
-            if (marker == '\n')
-                m_line++;
-        }
-        while (marker >= 1 && marker <= 31);
+        const char*  name    = &m_name[0];
+        const uint8* read_bp = &m_read_bp[0];
+        const uint8* read_q  = &m_read_q[0];
+    #else
+        uint32       len;
+        const char*  name;
+        const uint8* read_bp;
+        const uint8* read_q;
 
-        // check for EOF or read errors
-        if (m_file_state != FILE_OK)
+        const RecordState state = scan_record( &name, &read_bp, &read_q, &len );
+        if (state == RECORD_EOF)
             break;
-
-        // if the newlines didn't end in a read marker,
-        // issue a parsing error...
-        if (marker != '@')
-        {
-            log_error(stderr, "FASTQ loader: parsing error at %u!\n", m_line);
-
-            m_file_state = FILE_PARSE_ERROR;
-            m_error_char = marker;
-            return uint32(-1);
-        }
-
-        // read all the line
-        uint32 len = 0;
-        for (uint8 c = get(); c != '\n' && c != 0; c = get())
-        {
-            m_name[ len++ ] = c;
-
-            // expand on demand
-            if (m_name.size() <= len)
-                m_name.resize( len * 2u );
-        }
-
-        m_name[ len++ ] = '\0';
-
-        // check for errors
-        if (m_file_state != FILE_OK)
-        {
-            log_error(stderr, "FASTQ loader: incomplete read at line %u!\n", m_line);
-
-            m_error_char = 0;
-            return uint32(-1);
-        }
-
-        m_line++;
-
-        // start reading the bp read
-        len = 0;
-        for (char c = get(); c != '+' && c != 0; c = get())
-        {
-            // if (isgraph(c))
-            if (c >= 0x21 && c <= 0x7E)
-                m_read_bp[ len++ ] = c;
-            else if (c == '\n')
-                m_line++;
-
-            // expand on demand
-            if (m_read_bp.size() <= len)
-            {
-                m_read_bp.resize( len * 2u );
-                m_read_q.resize(  len * 2u );
-            }
-        }
-
-        const uint32 read_len = len;
-
-        // check for errors
-        if (m_file_state != FILE_OK)
-        {
-            log_error(stderr, "FASTQ loader: incomplete read at line %u!\n", m_line);
-
-            m_error_char = 0;
-            return uint32(-1);
-        }
-
-        // read all the line
-        for (char c = get(); c != '\n' && c != 0; c = get()) {}
-
-        // check for errors
-        if (m_file_state != FILE_OK)
+        else if (state == RECORD_ERROR)
         {
-            log_error(stderr, "FASTQ loader: incomplete read at line %u!\n", m_line);
+            log_error(stderr, "FASTQ loader: stream error at line %u!\n", m_line);
 
             m_error_char = 0;
             return uint32(-1);
         }
-
-        m_line++;
-
-        // start reading the quality read
-        len = 0;
-
-        // read as many qualities as there are in the read
-        for (char c = get(); (len < read_len) && (m_file_state == FILE_OK); c = get())
-        {
-            // if (isgraph(c))
-            if (c >= 0x21 && c <= 0x7E)
-                m_read_q[ len++ ] = c;
-            else if (c == '\n')
-                m_line++;
-        }
-        /*
-        // the below works for proper FASTQ files, but not for old Sanger ones
-        // allowing strings to span multiple lines...
-        for (uint8 c = get(); c != '\n' && c != 0; c = get())
-            m_read_q[ len++ ] = c;
-
-        if (len < read_len)
-        {
-            m_read_bp[ read_len ] = '\0';
-            m_read_q[ len ] = '\0';
-
-            log_error(stderr, "FASTQ loader: qualities and read lengths differ at line %u!\n", m_line);
-            log_error(stderr, "  name: %s\n", &m_name[0]);
-            log_error(stderr, "  read: %s\n", &m_read_bp[0]);
-            log_error(stderr, "  qual: %s\n", &m_read_q[0]);
-
-            m_file_state = FILE_PARSE_ERROR;
-
-            m_error_char = 0;
-            return uint32(-1);
-        }*/
-
-        // check for errors
-        if (m_file_state != FILE_OK)
+        else if (state == RECORD_FALLBACK)
         {
-            log_error(stderr, "FASTQ loader: incomplete read at line %u!\n", m_line);
-
-            m_error_char = 0;
-            return uint32(-1);
+            const int ret = parse_record( &len );
+            if (ret == 0)
+                break;
+            else if (ret < 0)
+                return uint32(-1);
+
+            name    = &m_name[0];
+            read_bp = &m_read_bp[0];
+            read_q  = &m_read_q[0];
         }
-
-        m_line++;
     #endif
 
         if (m_options.flags & FORWARD)
         {
             output->push_back( len,
-                              &m_name[0],
-                              &m_read_bp[0],
-                              &m_read_q[0],
+                              name,
+                              read_bp,
+                              read_q,
                               m_options.qualities,
                               m_options.max_sequence_len,
                               m_options.trim3,
@@ -262,9 +521,9 @@ int SequenceDataFile_FASTQ_parser::nextChunk(SequenceDataEncoder *output, uint32
         if (m_options.flags & REVERSE)
         {
             output->push_back( len,
-                              &m_name[0],
-                              &m_read_bp[0],
-                              &m_read_q[0],
+                              name,
+                              read_bp,
+                              read_q,
                               m_options.qualities,
                               m_options.max_sequence_len,
                               m_options.trim3,
@@ -274,9 +533,9 @@ int SequenceDataFile_FASTQ_parser::nextChunk(SequenceDataEncoder *output, uint32
         if (m_options.flags & FORWARD_COMPLEMENT)
         {
             output->push_back( len,
-                              &m_name[0],
-                              &m_read_bp[0],
-                              &m_read_q[0],
+                              name,
+                              read_bp,
+                              read_q,
                               m_options.qualities,
                               m_options.max_sequence_len,
                               m_options.trim3,
@@ -286,9 +545,9 @@ int SequenceDataFile_FASTQ_parser::nextChunk(SequenceDataEncoder *output, uint32
         if (m_options.flags & REVERSE_COMPLEMENT)
         {
             output->push_back( len,
-                              &m_name[0],
-                              &m_read_bp[0],
-                              &m_read_q[0],
+                              name,
+                              read_bp,
+                              read_q,
                               m_options.qualities,
                               m_options.max_sequence_len,
                               m_options.trim3,
@@ -307,64 +566,66 @@ SequenceDataFile_FASTQ_gz::SequenceDataFile_FASTQ_gz(
     const SequenceDataFile::Options&    options)
     : SequenceDataFile_FASTQ_parser(read_file_name, options)
 {
-    m_file = gzopen(read_file_name, "r");
-    if (!m_file) {
+    if (m_file.open( read_file_name ) == false) {
         m_file_state = FILE_OPEN_FAILED;
     } else {
         m_file_state = FILE_OK;
     }
-
-    gzbuffer(m_file, m_buffer_size);
 }
 
 SequenceDataFile_FASTQ_gz::~SequenceDataFile_FASTQ_gz()
 {
-    gzclose( m_file );
+    m_file.close();
 }
 
 //static float time = 0.0f;
 
 SequenceDataFile_FASTQ_parser::FileState SequenceDataFile_FASTQ_gz::fillBuffer(void)
 {
-    m_buffer_size = gzread(m_file, &m_buffer[0], (uint32)m_buffer.size());
+    const int n_bytes = m_file.read(&m_buffer[0] + m_buffer_size, (uint32)m_buffer.size() - m_buffer_size);
 
-    if (m_buffer_size <= 0)
+    if (n_bytes <= 0)
     {
-        // check for EOF separately; zlib will not always return Z_STREAM_END at EOF below
-        if (gzeof(m_file))
+        // check for EOF separately
+        if (m_file.eof())
             return FILE_EOF;
         else
         {
-            // ask zlib what happened and inform the user
-            int err;
-            const char *msg;
-            log_warning(stderr, "zlib error\n");
-
-            msg = gzerror(m_file, &err);
-            // we're making the assumption that we never see Z_STREAM_END here
-            assert(err != Z_STREAM_END);
-
-            log_error(stderr, "error processing FASTQ file: zlib error %d (%s)\n", err, msg);
+            log_error(stderr, "error processing FASTQ file: %s\n", m_file.error());
             return FILE_STREAM_ERROR;
         }
     }
+    m_buffer_size += uint32( n_bytes );
     return FILE_OK;
 }
 
+// read a line
+//
+bool SequenceDataFile_FASTQ_gz::gets(char* buffer, int len)
+{
+    int n = 0;
+    while (n + 1 < len && m_file.read( buffer + n, 1u ) == 1)
+    {
+        if (buffer[n++] == '\n')
+            break;
+    }
+    buffer[n] = '\0';
+    return n > 0;
+}
+
 // rewind
 //
 bool SequenceDataFile_FASTQ_gz::rewind()
 {
-    if (m_file == NULL || (m_file_state != FILE_OK && m_file_state != FILE_EOF))
+    if (m_file.is_ok() == false || (m_file_state != FILE_OK && m_file_state != FILE_EOF))
         return false;
 
-    gzrewind( m_file );
+    m_file.rewind();
 
     m_file_state = FILE_OK;
 
-    m_buffer_size = (uint32)m_buffer.size();
-    m_buffer_pos  = (uint32)m_buffer.size();
-    m_line        = 0;
+    reset_buffer();
+    m_line = 0;
     return true;
 }
 
@@ -392,9 +653,9 @@ SequenceDataFile_FASTQ::~SequenceDataFile_FASTQ()
 
 SequenceDataFile_FASTQ_parser::FileState SequenceDataFile_FASTQ::fillBuffer(void)
 {
-    m_buffer_size = fread(&m_buffer[0], 1u, (uint32)m_buffer.size(), m_file);
+    const size_t n_bytes = fread(&m_buffer[0] + m_buffer_size, 1u, (uint32)m_buffer.size() - m_buffer_size, m_file);
 
-    if (m_buffer_size <= 0)
+    if (n_bytes == 0)
     {
         // check for EOF separately; zlib will not always return Z_STREAM_END at EOF below
         if (feof(m_file))
@@ -414,6 +675,7 @@ SequenceDataFile_FASTQ_parser::FileState SequenceDataFile_FASTQ::fillBuffer(void
             return FILE_STREAM_ERROR;
         }
     }
+    m_buffer_size += uint32( n_bytes );
     return FILE_OK;
 }
 
@@ -428,9 +690,8 @@ bool SequenceDataFile_FASTQ::rewind()
 
     m_file_state = FILE_OK;
 
-    m_buffer_size = (uint32)m_buffer.size();
-    m_buffer_pos  = (uint32)m_buffer.size();
-    m_line        = 0;
+    reset_buffer();
+    m_line = 0;
     return true;
 }
 
@@ -505,6 +766,15 @@ void write(
 //
 void SequenceDataOutputFile_FASTQ::next(const SequenceDataHost& sequence_data)
 {
+    // binned qualities are written out as the scores their bins represent
+    if (sequence_data.quality_bins().is_plain() == false)
+    {
+        SequenceDataHost plain_data( sequence_data );
+        expand_qualities( &plain_data );
+        next( plain_data );
+        return;
+    }
+
     if (sequence_data.alphabet() == DNA)
         write( m_file, io::SequenceDataAccess<DNA>( sequence_data ) );
     else if (sequence_data.alphabet() == DNA_N)
@@ -30,6 +30,7 @@
 #include <nvbio/io/sequence/sequence.h>
 #include <nvbio/io/sequence/sequence_priv.h>
 #include <nvbio/io/output_stream.h>
+#include <nvbio/io/parallel_gzip_reader.h>
 #include <nvbio/basic/console.h>
 
 #include <zlib/zlib.h>
@@ -50,18 +51,27 @@ namespace io {
 /// contains the code to parse FASTQ files and dump the results into a SequenceDataRAM object
 /// file access is done via derived classes
 ///
+/// Parsing proceeds a whole buffer at a time: the offsets of all newlines in the buffer
+/// are first located with a vectorized scan, after which each well-formed four-line record
+/// is validated and handed to the encoder straight from the buffer, without copies.
+/// Records spanning multiple sequence or quality lines (as found in old Sanger files)
+/// are detected and parsed by a fallback character-by-character parser.
+///
 struct SequenceDataFile_FASTQ_parser : public SequenceDataFile
 {
 protected:
     SequenceDataFile_FASTQ_parser(
         const char*                         read_file_name,
         const SequenceDataFile::Options&    options,
-        const uint32                        buffer_size = 64536u)
+        const uint32                        buffer_size = 1024u*1024u)
       : SequenceDataFile( options ),
         m_file_name(read_file_name),
         m_buffer(buffer_size),
-        m_buffer_size(buffer_size),
-        m_buffer_pos(buffer_size),
+        m_buffer_size(0),
+        m_buffer_pos(0),
+        m_buffer_eof(false),
+        m_newline_pos(0),
+        m_newline_end(0),
         m_line(0),
         m_name( 1024*1024 ),
         m_read_bp( 1024*1024 ),
@@ -72,14 +82,40 @@ protected:
     // this can cause m_file_state to change
     virtual int nextChunk(struct SequenceDataEncoder *output, uint32 max_reads, uint32 max_bps);
 
-    // fill m_buffer with data from the file, return the new file state
+    // append data from the file to m_buffer[m_buffer_size, m_buffer.size()), advancing
+    // m_buffer_size and returning the new file state
     // this should only report EOF when no more bytes could be read
     // derived classes should override this method to return actual file data
     virtual FileState fillBuffer(void) = 0;
 
     virtual bool gets(char* buffer, int len) = 0;
 
+    // discard all buffered data, e.g. after rewinding the underlying file
+    void reset_buffer();
+
 private:
+    // the outcome of the block parser
+    enum RecordState
+    {
+        RECORD_OK,          // a record has been parsed
+        RECORD_EOF,         // no more records
+        RECORD_ERROR,       // a stream error occurred
+        RECORD_FALLBACK,    // the record has to be parsed by parse_record()
+    };
+
+    // parse the next record directly from the buffer
+    RecordState scan_record(const char** name, const uint8** read_bp, const uint8** read_q, uint32* len);
+
+    // parse the next record character by character, into m_name, m_read_bp and m_read_q;
+    // returns 1 on success, 0 at EOF and -1 on errors
+    int parse_record(uint32* len);
+
+    // move the unconsumed data to the front of the buffer and append more from the file
+    FileState refill();
+
+    // locate all the newlines in m_buffer[m_newline_end, m_buffer_size)
+    void index_newlines();
+
     // get next character from file
     char get();
 
@@ -91,6 +127,13 @@ protected:
     std::vector<char>       m_buffer;
     uint32                  m_buffer_size;
     uint32                  m_buffer_pos;
+    bool                    m_buffer_eof;
+
+    // offsets of the newlines in m_buffer[0, m_newline_end); the first
+    // newline at or past m_buffer_pos is at index m_newline_pos
+    std::vector<uint32>     m_newlines;
+    uint32                  m_newline_pos;
+    uint32                  m_newline_end;
 
     // counter for which line we're at
     uint32                  m_line;
@@ -105,7 +148,9 @@ protected:
 };
 
 /// loader for gzipped files
-/// this also works for plain uncompressed files, as zlib does that transparently
+/// this also works for plain uncompressed files, as zlib does that transparently;
+/// decompression runs ahead of the parser on separate threads, and BGZF files are
+/// inflated in parallel
 ///
 struct SequenceDataFile_FASTQ_gz : public SequenceDataFile_FASTQ_parser
 {
@@ -117,14 +162,14 @@ struct SequenceDataFile_FASTQ_gz : public SequenceDataFile_FASTQ_parser
 
     virtual FileState fillBuffer(void);
 
-    virtual bool gets(char* buffer, int len) { return gzgets( m_file, buffer, len ) != NULL; };
+    virtual bool gets(char* buffer, int len);
 
     /// rewind the file
     ///
     virtual bool rewind();
 
 private:
-    gzFile m_file;
+    ParallelGzipReader m_file;
 };
 
 /// loader for gzipped files
@@ -183,28 +228,47 @@ private:
 
 inline char SequenceDataFile_FASTQ_parser::get(void)
 {
-    if (m_buffer_pos >= m_buffer_size /*|| m_buffer[m_buffer_pos] == '\0'*/)
+    if (m_buffer_pos >= m_buffer_size)
     {
+        // discard the consumed data
+        m_buffer_size = 0;
+        m_buffer_pos  = 0;
+
+        m_newlines.clear();
+        m_newline_pos = 0;
+        m_newline_end = 0;
+
         // check whether we had already reached the end of file
-        if (m_buffer_size < m_buffer.size())
+        if (m_buffer_eof)
         {
             m_file_state = FILE_EOF;
             return 0;
         }
-        else
-        {
-            // grab more data from the underlying file
-            m_file_state = fillBuffer();
-            m_buffer_pos = 0;
 
-            // if we failed to read more data, return \0
-            if (m_file_state != FILE_OK)
-                return 0;
+        // grab more data from the underlying file
+        m_file_state = fillBuffer();
+
+        // if we failed to read more data, return \0
+        if (m_file_state != FILE_OK)
+        {
+            m_buffer_eof = true;
+            return 0;
         }
     }
 
     return m_buffer[m_buffer_pos++];
 }
 
+inline void SequenceDataFile_FASTQ_parser::reset_buffer()
+{
+    m_buffer_size = 0;
+    m_buffer_pos  = 0;
+    m_buffer_eof  = false;
+
+    m_newlines.clear();
+    m_newline_pos = 0;
+    m_newline_end = 0;
+}
+
 } // namespace io
 } // namespace nvbio
@@ -0,0 +1,646 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <nvbio/io/sequence/sequence_paired.h>
+#include <nvbio/io/sequence/sequence_encoder.h>
+#include <nvbio/basic/threads.h>
+#include <nvbio/basic/console.h>
+#include <nvbio/basic/omp.h>
+
+#include <string.h>
+
+namespace nvbio {
+namespace io {
+
+///@addtogroup IO
+///@{
+
+///@addtogroup SequenceIO
+///@{
+
+///@addtogroup SequenceIODetail
+///@{
+
+namespace { // anonymous namespace
+
+// return the number of strands encoded for each read
+//
+inline uint32 strand_count(const SequenceEncoding flags)
+{
+    return ((flags & FORWARD)            ? 1u : 0u) +
+           ((flags & REVERSE)            ? 1u : 0u) +
+           ((flags & FORWARD_COMPLEMENT) ? 1u : 0u) +
+           ((flags & REVERSE_COMPLEMENT) ? 1u : 0u);
+}
+
+// return the length of the part of a read name identifying its pair, i.e. stopping
+// at the first whitespace and excluding a trailing /1 or /2
+//
+inline uint32 pair_name_length(const char* name)
+{
+    uint32 len = 0;
+    while (name[len] != '\0' && name[len] != ' ' && name[len] != '\t')
+        ++len;
+
+    if (len >= 2 && name[len-2] == '/' && (name[len-1] == '1' || name[len-1] == '2'))
+        len -= 2;
+
+    return len;
+}
+
+// check whether two mates have matching names
+//
+inline bool match_mate_names(const char* name1, const char* name2)
+{
+    const uint32 len1 = pair_name_length( name1 );
+    const uint32 len2 = pair_name_length( name2 );
+    return len1 == len2 && strncmp( name1, name2, len1 ) == 0;
+}
+
+// check that the names of all mates in two batches match, logging the first mismatch
+//
+bool check_mate_names(const SequenceDataHost& data1, const SequenceDataHost& data2, const uint32 n_strands)
+{
+    const char*   names1 = nvbio::raw_pointer( data1.m_name_vec );
+    const char*   names2 = nvbio::raw_pointer( data2.m_name_vec );
+    const uint32* index1 = nvbio::raw_pointer( data1.m_name_index_vec );
+    const uint32* index2 = nvbio::raw_pointer( data2.m_name_index_vec );
+
+    // all strands of a read share its name, so it's enough to check the first one
+    for (uint32 i = 0; i < data1.size(); i += n_strands)
+    {
+        if (match_mate_names( names1 + index1[i], names2 + index2[i] ) == false)
+        {
+            log_error(stderr, "mates \"%s\" and \"%s\" have different names\n", names1 + index1[i], names2 + index2[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+//
+// An encoder splitting an interleaved stream of reads among two encoders, sending
+// even reads to the first and odd reads to the second.
+// First mates are only forwarded together with their second mate, so that the
+// two batches always stay aligned: if the stream stops between the two, the first
+// mate is copied aside and completed by the next batch.
+// The info reported to the stream accounts for exactly the reads it pushed in the
+// current batch, regardless of which of them have been forwarded.
+//
+struct MatePairingEncoder : public SequenceDataEncoder
+{
+    typedef PairedSequenceDataFile_Interleaved::PendingMate PendingMate;
+
+    MatePairingEncoder(
+        SequenceDataEncoder*    encoder1,
+        SequenceDataEncoder*    encoder2,
+        const SequenceEncoding  flags,
+        PendingMate*            pending) :
+        SequenceDataEncoder( encoder1->alphabet() ),
+        m_encoder1( encoder1 ),
+        m_encoder2( encoder2 ),
+        m_flags( flags ),
+        m_n_strands( nvbio::max( strand_count( flags ), 1u ) ),
+        m_strand( 0 ),
+        m_forward( false ),
+        m_pending( pending ),
+        m_carried_seqs( pending_seqs() ),
+        m_carried_bps( pending_bps() ) {}
+
+    /// reserve enough storage for a given number of reads and bps
+    ///
+    void reserve(const uint32 n_reads, const uint32 n_bps)
+    {
+        m_encoder1->reserve( n_reads / 2, n_bps / 2 );
+        m_encoder2->reserve( n_reads / 2, n_bps / 2 );
+    }
+
+    /// add a strand of a read to the end of this batch
+    ///
+    void push_back(
+        const uint32            in_sequence_len,
+        const char*             name,
+        const uint8*            base_pairs,
+        const uint8*            quality,
+        const QualityEncoding   quality_encoding,
+        const uint32            max_sequence_len,
+        const uint32            trim3,
+        const uint32            trim5,
+        const StrandOp          conversion_flags)
+    {
+        // the first strand of each read decides where the read goes
+        if (m_strand == 0)
+        {
+            if (m_pending->valid == false)
+            {
+                // a first mate: keep it aside until its mate shows up
+                store( in_sequence_len, name, base_pairs, quality, quality_encoding, max_sequence_len, trim3, trim5 );
+                update_info();
+                m_forward = false;
+            }
+            else
+            {
+                // a second mate: emit the pending first mate and forward all its strands
+                flush();
+                m_forward = true;
+            }
+        }
+
+        if (m_forward)
+        {
+            m_encoder2->push_back(
+                in_sequence_len,
+                name,
+                base_pairs,
+                quality,
+                quality_encoding,
+                max_sequence_len,
+                trim3,
+                trim5,
+                conversion_flags );
+
+            update_info();
+        }
+
+        m_strand = (m_strand + 1u) % m_n_strands;
+    }
+
+    /// add a set of reads to the end of this batch
+    ///
+    void push_back(
+        const uint32            n_sequences,
+        const uint32*           sequence_lens,
+        const char* const*      names,
+        const uint8* const*     base_pairs,
+        const uint8* const*     qualities,
+        const QualityEncoding   quality_encoding,
+        const uint32            max_sequence_len,
+        const uint32            trim3,
+        const uint32            trim5,
+        const SequenceEncoding  flags)
+    {
+        if (n_sequences == 0)
+            return;
+
+        uint32 first = 0;
+
+        // complete the pending pair, if any
+        if (m_pending->valid)
+        {
+            flush();
+
+            m_encoder2->push_back(
+                1u,
+                sequence_lens,
+                names,
+                base_pairs,
+                qualities,
+                quality_encoding,
+                max_sequence_len,
+                trim3,
+                trim5,
+                flags );
+
+            first = 1u;
+        }
+
+        // split all complete pairs among the two encoders
+        const uint32 n_pairs = (n_sequences - first) / 2u;
+        if (n_pairs)
+        {
+            m_lens.resize( n_pairs * 2u );
+            m_names.resize( n_pairs * 2u );
+            m_bps.resize( n_pairs * 2u );
+            m_quals.resize( n_pairs * 2u );
+
+            for (uint32 i = 0; i < n_pairs; ++i)
+            {
+                for (uint32 mate = 0; mate < 2u; ++mate)
+                {
+                    const uint32 in  = first + i * 2u + mate;
+                    const uint32 out = mate * n_pairs + i;
+
+                    m_lens[ out ]  = sequence_lens[ in ];
+                    m_names[ out ] = names[ in ];
+                    m_bps[ out ]   = base_pairs[ in ];
+                    m_quals[ out ] = qualities[ in ];
+                }
+            }
+
+            m_encoder1->push_back( n_pairs, &m_lens[0],       &m_names[0],       &m_bps[0],       &m_quals[0],       quality_encoding, max_sequence_len, trim3, trim5, flags );
+            m_encoder2->push_back( n_pairs, &m_lens[n_pairs], &m_names[n_pairs], &m_bps[n_pairs], &m_quals[n_pairs], quality_encoding, max_sequence_len, trim3, trim5, flags );
+        }
+
+        // keep aside the last first mate, if its pair is incomplete
+        if ((n_sequences - first) & 1u)
+        {
+            const uint32 last = n_sequences - 1u;
+            store( sequence_lens[last], names[last], base_pairs[last], qualities[last], quality_encoding, max_sequence_len, trim3, trim5 );
+        }
+
+        update_info();
+    }
+
+    /// signals that a batch is to begin
+    ///
+    void begin_batch(void)
+    {
+        m_encoder1->begin_batch();
+        m_encoder2->begin_batch();
+
+        m_info = SequenceDataInfo();
+        update_info();
+    }
+
+    /// signals that the batch is complete
+    ///
+    void end_batch(void)
+    {
+        m_encoder1->end_batch();
+        m_encoder2->end_batch();
+    }
+
+    /// return the sequence data info
+    ///
+    const SequenceDataInfo* info() const { return &m_info; }
+
+private:
+    // copy a first mate aside
+    void store(
+        const uint32            sequence_len,
+        const char*             name,
+        const uint8*            base_pairs,
+        const uint8*            quality,
+        const QualityEncoding   quality_encoding,
+        const uint32            max_sequence_len,
+        const uint32            trim3,
+        const uint32            trim5)
+    {
+        m_pending->valid            = true;
+        m_pending->name             = name;
+        m_pending->bps.assign( base_pairs, base_pairs + sequence_len );
+        m_pending->quals.assign( quality,  quality    + sequence_len );
+        m_pending->qualities        = quality_encoding;
+        m_pending->max_sequence_len = max_sequence_len;
+        m_pending->trim3            = trim3;
+        m_pending->trim5            = trim5;
+    }
+
+    // emit the pending first mate
+    void flush()
+    {
+        const uint32 len   = uint32( m_pending->bps.size() );
+        const char*  name  = m_pending->name.c_str();
+        const uint8* bps   = len ? &m_pending->bps[0]   : NULL;
+        const uint8* quals = len ? &m_pending->quals[0] : NULL;
+
+        m_encoder1->push_back(
+            1u,
+            &len,
+            &name,
+            &bps,
+            &quals,
+            m_pending->qualities,
+            m_pending->max_sequence_len,
+            m_pending->trim3,
+            m_pending->trim5,
+            m_flags );
+
+        m_pending->valid = false;
+    }
+
+    // the number of sequences held by the pending mate
+    uint32 pending_seqs() const { return m_pending->valid ? m_n_strands : 0u; }
+
+    // the number of bps held by the pending mate
+    uint32 pending_bps() const
+    {
+        if (m_pending->valid == false)
+            return 0u;
+
+        const uint32 len         = uint32( m_pending->bps.size() );
+        const uint32 trimmed_len = len > m_pending->trim3 + m_pending->trim5 ?
+                                   len - m_pending->trim3 - m_pending->trim5 : 0u;
+
+        return m_n_strands * nvbio::min( trimmed_len, m_pending->max_sequence_len );
+    }
+
+    // update the info of the reads pushed in this batch: these include the pending mate,
+    // but not the one carried over from the previous batch
+    void update_info()
+    {
+        m_info.m_n_seqs              = m_encoder1->info()->size() + m_encoder2->info()->size() + pending_seqs() - m_carried_seqs;
+        m_info.m_sequence_stream_len = m_encoder1->info()->bps()  + m_encoder2->info()->bps()  + pending_bps()  - m_carried_bps;
+    }
+
+    SequenceDataEncoder*        m_encoder1;
+    SequenceDataEncoder*        m_encoder2;
+    SequenceEncoding            m_flags;
+    uint32                      m_n_strands;
+    uint32                      m_strand;
+    bool                        m_forward;
+    PendingMate*                m_pending;
+    uint32                      m_carried_seqs;
+    uint32                      m_carried_bps;
+    SequenceDataInfo            m_info;
+
+    std::vector<uint32>         m_lens;
+    std::vector<const char*>    m_names;
+    std::vector<const uint8*>   m_bps;
+    std::vector<const uint8*>   m_quals;
+};
+
+//
+// A thread reading a batch from a stream
+//
+struct MateReaderThread : public Thread<MateReaderThread>
+{
+    MateReaderThread(
+        const Alphabet              _alphabet,
+        SequenceDataHost*           _data,
+        SequenceDataInputStream*    _stream,
+        const uint32                _batch_size) :
+        alphabet( _alphabet ), data( _data ), stream( _stream ), batch_size( _batch_size ), ret( 0 ) {}
+
+    void run() { ret = io::next( alphabet, data, stream, batch_size ); }
+
+    Alphabet                    alphabet;
+    SequenceDataHost*           data;
+    SequenceDataInputStream*    stream;
+    uint32                      batch_size;
+    int                         ret;
+};
+
+} // anonymous namespace
+
+// constructor
+//
+PairedSequenceDataFile_Interleaved::PairedSequenceDataFile_Interleaved(SequenceDataInputStream* stream, const SequenceEncoding flags) :
+    m_stream( stream ),
+    m_flags( flags ),
+    m_error( false ) {}
+
+// next batch of pairs
+//
+int PairedSequenceDataFile_Interleaved::next(const Alphabet alphabet, SequenceDataHost* data1, SequenceDataHost* data2, const uint32 batch_size, const uint32 batch_bps)
+{
+    if (m_error)
+        return 0;
+
+    SharedPointer<SequenceDataEncoder> encoder1( create_encoder( alphabet, data1 ) );
+    SharedPointer<SequenceDataEncoder> encoder2( create_encoder( alphabet, data2 ) );
+    if (encoder1 == NULL || encoder2 == NULL)
+    {
+        log_error(stderr, "unsupported alphabet for paired-end input\n");
+        m_error = true;
+        return 0;
+    }
+
+    const uint32 n_strands = nvbio::max( strand_count( m_flags ), 1u );
+
+    // a batch might only contain a first mate if the stream stops right after it,
+    // in which case the mate is carried over and the next batch is read
+    do
+    {
+        MatePairingEncoder encoder( encoder1.get(), encoder2.get(), m_flags, &m_pending );
+
+        // each pair counts for two sequences in the interleaved stream, one of which
+        // might have been carried over from the previous batch
+        const uint32 n = batch_size <= uint32(-1) / 2u ?
+            batch_size * 2u - (m_pending.valid ? nvbio::min( n_strands, batch_size ) : 0u) :
+            uint32(-1);
+
+        if (m_stream->next( &encoder, n, batch_bps ) == 0)
+        {
+            if (m_pending.valid)
+            {
+                log_error(stderr, "read \"%s\" has no mate at the end of the interleaved input\n", m_pending.name.c_str());
+                m_error = true;
+            }
+            return 0;
+        }
+    }
+    while (data1->size() == 0);
+
+    if (check_mate_names( *data1, *data2, n_strands ) == false)
+    {
+        m_error = true;
+        return 0;
+    }
+    return data1->size();
+}
+
+// is the stream ok?
+//
+bool PairedSequenceDataFile_Interleaved::is_ok()
+{
+    return m_error == false && m_stream->is_ok();
+}
+
+// rewind
+//
+bool PairedSequenceDataFile_Interleaved::rewind()
+{
+    m_pending.valid = false;
+    m_error         = false;
+    return m_stream->rewind();
+}
+
+// constructor
+//
+PairedSequenceDataFile_Dual::PairedSequenceDataFile_Dual(SequenceDataInputStream* stream1, SequenceDataInputStream* stream2, const SequenceEncoding flags) :
+    m_stream1( stream1 ),
+    m_stream2( stream2 ),
+    m_n_strands( nvbio::max( strand_count( flags ), 1u ) ),
+    m_max_sequence_len( 0 ),
+    m_error( false ) {}
+
+// next batch of pairs
+//
+int PairedSequenceDataFile_Dual::next(const Alphabet alphabet, SequenceDataHost* data1, SequenceDataHost* data2, const uint32 batch_size, const uint32 batch_bps)
+{
+    if (m_error)
+        return 0;
+
+    // the budget of each of the two batches
+    const uint32 mate_bps = batch_bps == uint32(-1) ? uint32(-1) : batch_bps / 2u;
+
+    int ret1, ret2;
+
+    if (mate_bps != uint32(-1) && m_max_sequence_len == 0)
+    {
+        // no clue about the read lengths yet: fit the first mates in the budget,
+        // and then fetch as many second mates
+        ret1 = io::next( alphabet, data1, m_stream1.get(), batch_size, mate_bps );
+        ret2 = ret1 ? io::next( alphabet, data2, m_stream2.get(), uint32( ret1 ) ) : 0;
+    }
+    else
+    {
+        // convert the budget to a number of reads, assuming they are no longer than those seen so far
+        uint32 n = batch_size;
+        if (mate_bps != uint32(-1))
+        {
+            const uint32 n_reads = nvbio::max( mate_bps / (m_max_sequence_len * m_n_strands), 1u );
+            n = nvbio::min( n, n_reads * m_n_strands );
+        }
+
+        // read the second mates on a helper thread, while reading the first ones on this
+        MateReaderThread mate2( alphabet, data2, m_stream2.get(), n );
+        mate2.create();
+
+        ret1 = io::next( alphabet, data1, m_stream1.get(), n );
+
+        mate2.join();
+        ret2 = mate2.ret;
+    }
+
+    if (ret1 != ret2)
+    {
+        log_error(stderr, "the two mate files contain a different number of reads\n");
+        m_error = true;
+        return 0;
+    }
+    if (ret1 == 0)
+        return 0;
+
+    m_max_sequence_len = nvbio::max(
+        m_max_sequence_len,
+        nvbio::max( data1->max_sequence_len(), data2->max_sequence_len() ) );
+
+    if (check_mate_names( *data1, *data2, m_n_strands ) == false)
+    {
+        m_error = true;
+        return 0;
+    }
+    return ret1;
+}
+
+// is the stream ok?
+//
+bool PairedSequenceDataFile_Dual::is_ok()
+{
+    return m_error == false && m_stream1->is_ok() && m_stream2->is_ok();
+}
+
+// rewind
+//
+bool PairedSequenceDataFile_Dual::rewind()
+{
+    m_error = false;
+
+    const bool ret1 = m_stream1->rewind();
+    const bool ret2 = m_stream2->rewind();
+    return ret1 && ret2;
+}
+
+// next batch of pairs
+//
+int next(const Alphabet alphabet, SequenceDataHost* data1, SequenceDataHost* data2, PairedSequenceDataInputStream* stream, const uint32 batch_size, const uint32 batch_bps)
+{
+    return stream->next( alphabet, data1, data2, batch_size, batch_bps );
+}
+
+// factory method to open a paired-end read file, or a pair of mate files
+//
+PairedSequenceDataInputStream* open_paired_sequence_files(
+    const char*              sequence_file_name1,
+    const char*              sequence_file_name2,
+    const QualityEncoding    qualities,
+    const uint32             max_seqs,
+    const uint32             max_sequence_len,
+    const SequenceEncoding   flags,
+    const uint32             trim3,
+    const uint32             trim5,
+    const uint32             n_threads,
+    const uint32             skip_flags,
+    const char*              reference_name)
+{
+    if (sequence_file_name2 == NULL)
+    {
+        // both mates come from the same stream
+        SequenceDataInputStream* stream = open_sequence_file(
+            sequence_file_name1,
+            qualities,
+            max_seqs <= uint32(-1) / 2u ? max_seqs * 2u : uint32(-1),
+            max_sequence_len,
+            flags,
+            trim3,
+            trim5,
+            n_threads,
+            skip_flags,
+            reference_name );
+
+        if (stream == NULL)
+            return NULL;
+
+        return new PairedSequenceDataFile_Interleaved( stream, flags );
+    }
+
+    // split the parsing threads among the two files
+    const uint32 mate_threads = n_threads == 1u ? 1u :
+        nvbio::max( (n_threads ? n_threads : uint32( omp_get_max_threads() )) / 2u, 2u );
+
+    SequenceDataInputStream* stream1 = open_sequence_file(
+        sequence_file_name1,
+        qualities,
+        max_seqs,
+        max_sequence_len,
+        flags,
+        trim3,
+        trim5,
+        mate_threads,
+        skip_flags,
+        reference_name );
+
+    SequenceDataInputStream* stream2 = open_sequence_file(
+        sequence_file_name2,
+        qualities,
+        max_seqs,
+        max_sequence_len,
+        flags,
+        trim3,
+        trim5,
+        mate_threads,
+        skip_flags,
+        reference_name );
+
+    if (stream1 == NULL || stream2 == NULL)
+    {
+        delete stream1;
+        delete stream2;
+        return NULL;
+    }
+
+    return new PairedSequenceDataFile_Dual( stream1, stream2, flags );
+}
+
+///@} // SequenceIODetail
+///@} // SequenceIO
+///@} // IO
+
+} // namespace io
+} // namespace nvbio
@@ -0,0 +1,144 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <nvbio/io/sequence/sequence.h>
+#include <nvbio/basic/shared_pointer.h>
+
+#include <string>
+#include <vector>
+
+namespace nvbio {
+namespace io {
+
+///@addtogroup IO
+///@{
+
+///@addtogroup SequenceIO
+///@{
+
+///@addtogroup SequenceIODetail
+///@{
+
+///
+/// A PairedSequenceDataInputStream reading both mates from a single interleaved stream,
+/// where each record is immediately followed by its mate.
+///
+/// The records are split among the two output batches by a pairing encoder sitting between
+/// the underlying stream and the actual encoders, so that any file format and parser can be
+/// used. If a batch ends between two mates, the first mate is kept aside and completed
+/// at the beginning of the next batch.
+///
+struct PairedSequenceDataFile_Interleaved : public PairedSequenceDataInputStream
+{
+    /// a first mate still waiting for the second one
+    ///
+    struct PendingMate
+    {
+        PendingMate() : valid( false ) {}
+
+        bool                valid;
+        std::string         name;
+        std::vector<uint8>  bps;
+        std::vector<uint8>  quals;
+        QualityEncoding     qualities;
+        uint32              max_sequence_len;
+        uint32              trim3;
+        uint32              trim5;
+    };
+
+    /// constructor
+    ///
+    /// \param stream       the interleaved stream, which is owned by this object
+    /// \param flags        the strands encoded by the stream for each read
+    ///
+    PairedSequenceDataFile_Interleaved(SequenceDataInputStream* stream, const SequenceEncoding flags);
+
+    /// next batch of pairs
+    ///
+    int next(const Alphabet alphabet, SequenceDataHost* data1, SequenceDataHost* data2, const uint32 batch_size, const uint32 batch_bps);
+
+    /// is the stream ok?
+    ///
+    bool is_ok();
+
+    /// rewind
+    ///
+    bool rewind();
+
+private:
+    SharedPointer<SequenceDataInputStream>  m_stream;
+    SequenceEncoding                        m_flags;
+    PendingMate                             m_pending;
+    bool                                    m_error;
+};
+
+///
+/// A PairedSequenceDataInputStream reading the two mates from two separate streams.
+///
+/// Both streams are read concurrently, the second one on a helper thread. As the two batches
+/// must hold the same number of reads, the base pair budget is converted to a number of reads
+/// using the longest read seen so far; the very first batch, for which no such estimate is
+/// available, reads the first mates within the budget and then as many second mates.
+///
+struct PairedSequenceDataFile_Dual : public PairedSequenceDataInputStream
+{
+    /// constructor
+    ///
+    /// \param stream1      the stream of first mates, which is owned by this object
+    /// \param stream2      the stream of second mates, which is owned by this object
+    /// \param flags        the strands encoded by the streams for each read
+    ///
+    PairedSequenceDataFile_Dual(SequenceDataInputStream* stream1, SequenceDataInputStream* stream2, const SequenceEncoding flags);
+
+    /// next batch of pairs
+    ///
+    int next(const Alphabet alphabet, SequenceDataHost* data1, SequenceDataHost* data2, const uint32 batch_size, const uint32 batch_bps);
+
+    /// is the stream ok?
+    ///
+    bool is_ok();
+
+    /// rewind
+    ///
+    bool rewind();
+
+private:
+    SharedPointer<SequenceDataInputStream>  m_stream1;
+    SharedPointer<SequenceDataInputStream>  m_stream2;
+    uint32                                  m_n_strands;
+    uint32                                  m_max_sequence_len;
+    bool                                    m_error;
+};
+
+///@} // SequenceIODetail
+///@} // SequenceIO
+///@} // IO
+
+} // namespace io
+} // namespace nvbio
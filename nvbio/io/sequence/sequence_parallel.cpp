@@ -0,0 +1,627 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <nvbio/io/sequence/sequence_parallel.h>
+#include <nvbio/io/sequence/sequence_encoder.h>
+#include <nvbio/io/sequence/sequence_fastq.h>
+#include <nvbio/io/sequence/sequence_fasta.h>
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/omp.h>
+
+#include <string.h>
+#include <algorithm>
+
+namespace nvbio {
+namespace io {
+
+///@addtogroup IO
+///@{
+
+///@addtogroup SequenceIO
+///@{
+
+///@addtogroup SequenceIODetail
+///@{
+
+namespace { // anonymous namespace
+
+// the default amount of data read per parsing thread in each block
+const uint32 BLOCK_SIZE_PER_THREAD = 4u*1024u*1024u;
+
+// find the first occurrence of c in str[begin, end), returning end if not found
+//
+inline uint32 find(const char* str, const uint32 begin, const uint32 end, const char c)
+{
+    const char* p = begin < end ? (const char*)memchr( str + begin, c, end - begin ) : NULL;
+    return p ? uint32( p - str ) : end;
+}
+
+// find the beginning of the first line starting at or past a given offset
+//
+inline uint32 line_start(const char* str, const uint32 offset, const uint32 end)
+{
+    if (offset == 0 || str[ offset-1 ] == '\n')
+        return offset;
+
+    const uint32 nl = find( str, offset, end, '\n' );
+    return nl < end ? nl + 1u : end;
+}
+
+} // anonymous namespace
+
+// constructor
+//
+SequenceDataFile_Parallel::SequenceDataFile_Parallel(
+    const char*                         read_file_name,
+    const Format                        format,
+    const SequenceDataFile::Options&    options,
+    const uint32                        n_threads,
+    const uint32                        block_size) :
+    SequenceDataFile( options ),
+    m_file_name( read_file_name ),
+    m_fallback( NULL ),
+    m_format( format ),
+    m_n_threads( n_threads ? n_threads : uint32( omp_get_max_threads() ) ),
+    m_block( block_size ? block_size : nvbio::max( m_n_threads, 2u ) * BLOCK_SIZE_PER_THREAD ),
+    m_block_len( 0 ),
+    m_block_parsed( 0 ),
+    m_block_offset( 0 ),
+    m_eof( false ),
+    m_error_offset( 0 ),
+    m_record_pos( 0 ),
+    m_range_records( m_n_threads )
+{
+    if (m_file.open( read_file_name, m_n_threads ) == false)
+        m_file_state = FILE_OPEN_FAILED;
+    else
+        m_file_state = FILE_OK;
+}
+
+// destructor
+//
+SequenceDataFile_Parallel::~SequenceDataFile_Parallel()
+{
+    delete m_fallback;
+    m_file.close();
+}
+
+// initialize the stream, parsing the first block; parsing errors are not reported
+// here, so as to let the caller fall back to a serial parser
+//
+bool SequenceDataFile_Parallel::init(void)
+{
+    if (m_file_state != FILE_OK)
+        return false;
+
+    // an empty file is a legitimate, if pointless, input
+    return load_block() || m_file_state == FILE_EOF;
+}
+
+// rewind the file
+//
+bool SequenceDataFile_Parallel::rewind()
+{
+    if (m_file.is_ok() == false || (m_file_state != FILE_OK && m_file_state != FILE_EOF))
+        return false;
+
+    m_file.rewind();
+
+    // start over in parallel
+    delete m_fallback;
+    m_fallback = NULL;
+
+    m_file_state   = FILE_OK;
+    m_block_len    = 0;
+    m_block_parsed = 0;
+    m_block_offset = 0;
+    m_eof          = false;
+
+    m_records.clear();
+    m_record_pos = 0;
+    return true;
+}
+
+// grab the next batch of reads into a host memory buffer
+//
+int SequenceDataFile_Parallel::next(SequenceDataEncoder* encoder, const uint32 batch_size, const uint32 batch_bps)
+{
+    if (m_fallback)
+        return m_fallback->next( encoder, batch_size, batch_bps );
+
+    const uint32 reads_to_load = std::min(m_options.max_seqs - m_loaded, batch_size);
+
+    if (m_file_state != FILE_OK || reads_to_load == 0)
+        return 0;
+
+    const uint32 read_mult =
+        ((m_options.flags & FORWARD)            ? 1u : 0u) +
+        ((m_options.flags & REVERSE)            ? 1u : 0u) +
+        ((m_options.flags & FORWARD_COMPLEMENT) ? 1u : 0u) +
+        ((m_options.flags & REVERSE_COMPLEMENT) ? 1u : 0u);
+
+    // a default average read length used to reserve enough space
+    const uint32 AVG_READ_LENGTH = 100;
+
+    encoder->begin_batch();
+    encoder->reserve(
+        batch_size,
+        batch_bps == uint32(-1) ? batch_size * AVG_READ_LENGTH : batch_bps ); // try to use a default read length
+
+    // fetch the sequence info
+    const SequenceDataInfo* info = encoder->info();
+
+    while (info->size() < reads_to_load &&
+           info->bps()  < batch_bps)
+    {
+        // parse a new block if all records have been consumed
+        if (m_record_pos == m_records.size() && load_block() == false)
+        {
+            // the records of the current block have not been output: let the serial parser
+            // try them, and continue from there if this batch is still empty
+            if (m_file_state == FILE_PARSE_ERROR &&
+                fall_back( m_loaded + info->size() ) &&
+                info->size() == 0)
+            {
+                encoder->end_batch();
+                return m_fallback->next( encoder, batch_size, batch_bps );
+            }
+            break;
+        }
+
+        // select as many records as fit in the batch
+        const uint32 first = m_record_pos;
+
+        uint32 n_reads = info->size();
+        uint64 n_bps   = info->bps();
+
+        for (; m_record_pos < m_records.size() && n_reads + read_mult <= reads_to_load; ++m_record_pos)
+        {
+            const uint32 len         = m_records[ m_record_pos ].len;
+            const uint32 trimmed_len = len > m_options.trim3 + m_options.trim5 ?
+                                       len - m_options.trim3 - m_options.trim5 : 0u;
+
+            const uint64 sequence_len = read_mult * nvbio::min( trimmed_len, m_options.max_sequence_len );
+
+            // make sure we output at least one read per batch
+            if (n_bps + sequence_len > batch_bps && n_reads)
+                break;
+
+            n_reads += read_mult;
+            n_bps   += sequence_len;
+        }
+
+        const uint32 n_records = m_record_pos - first;
+        if (n_records == 0)
+            break;
+
+        m_lens.resize( n_records );
+        m_names.resize( n_records );
+        m_bps.resize( n_records );
+        m_quals.resize( n_records );
+
+        for (uint32 i = 0; i < n_records; ++i)
+        {
+            const Record& record = m_records[ first + i ];
+
+            m_lens[i]  = record.len;
+            m_names[i] = &m_block[0] + record.name;
+            m_bps[i]   = (const uint8*)&m_block[0] + record.bp;
+            m_quals[i] = m_format == FASTQ ? (const uint8*)&m_block[0] + record.q : &m_fasta_quals[0];
+        }
+
+        encoder->push_back(
+            n_records,
+            &m_lens[0],
+            &m_names[0],
+            &m_bps[0],
+            &m_quals[0],
+            m_options.qualities,
+            m_options.max_sequence_len,
+            m_options.trim3,
+            m_options.trim5,
+            m_options.flags );
+    }
+
+    m_loaded += info->size();
+
+    encoder->end_batch();
+
+    return info->size();
+}
+
+// hand the rest of the file over to a serial parser, skipping the reads output so far
+//
+bool SequenceDataFile_Parallel::fall_back(const uint32 n_skip)
+{
+    log_warning(stderr, "unable to parse %s in parallel past byte offset %llu, falling back to the serial parser\n", m_file_name.c_str(), m_error_offset);
+
+    SequenceDataFile* file = m_format == FASTQ ?
+        (SequenceDataFile*)new SequenceDataFile_FASTQ_gz( m_file_name.c_str(), m_options ) :
+        (SequenceDataFile*)new SequenceDataFile_FASTA_gz( m_file_name.c_str(), m_options );
+
+    // skip the reads output so far, only counting them
+    SequenceDataEncoder counter( DNA );
+
+    uint32 n_skipped = 0;
+    while (n_skipped < n_skip)
+    {
+        const int n = file->next( &counter, nvbio::min( n_skip - n_skipped, 1024u*1024u ), uint32(-1) );
+        if (n <= 0)
+            break;
+
+        n_skipped += uint32( n );
+    }
+
+    if (n_skipped < n_skip)
+    {
+        log_error(stderr, "%s loader: malformed record at byte offset %llu!\n", m_format == FASTQ ? "FASTQ" : "FASTA", m_error_offset);
+        delete file;
+        return false;
+    }
+
+    m_fallback   = file;
+    m_file_state = FILE_OK;
+    return true;
+}
+
+// read the next block and parse it
+//
+bool SequenceDataFile_Parallel::load_block()
+{
+    m_records.clear();
+    m_record_pos = 0;
+
+    // move the incomplete record at the end of the previous block to the front
+    const uint32 tail_len = m_block_len - m_block_parsed;
+    if (m_block_parsed)
+        memmove( &m_block[0], &m_block[0] + m_block_parsed, tail_len );
+
+    m_block_offset += m_block_parsed;
+    m_block_len     = tail_len;
+    m_block_parsed  = 0;
+
+    while (1)
+    {
+        if (m_eof)
+        {
+            if (m_block_len)
+            {
+                m_error_offset = m_block_offset;
+                m_file_state   = FILE_PARSE_ERROR;
+            }
+            else
+                m_file_state = FILE_EOF;
+
+            return false;
+        }
+
+        // a single record doesn't fit in the block: expand it
+        if (m_block_len == m_block.size())
+            m_block.resize( m_block.size() * 2u );
+
+        const int32 n_bytes = m_file.read( &m_block[0] + m_block_len, uint32( m_block.size() - m_block_len ) );
+        if (n_bytes < 0)
+        {
+            log_error(stderr, "error processing %s file: %s\n", m_format == FASTQ ? "FASTQ" : "FASTA", m_file.error());
+            m_file_state = FILE_STREAM_ERROR;
+            return false;
+        }
+
+        m_block_len += uint32( n_bytes );
+        m_eof        = m_file.eof();
+
+        // skip trailing blanks at the end of the file, and leave room for terminating
+        // a name lying at the very end of the block; FASTA sequences keep all blanks
+        // but spaces and newlines, as with the serial parser
+        if (m_eof)
+        {
+            if (m_format == FASTA)
+            {
+                while (m_block_len && (m_block[ m_block_len-1 ] == ' ' || m_block[ m_block_len-1 ] == '\n'))
+                    --m_block_len;
+            }
+            else
+            {
+                while (m_block_len && m_block[ m_block_len-1 ] >= 0 && m_block[ m_block_len-1 ] <= ' ')
+                    --m_block_len;
+            }
+
+            if (m_block_len == m_block.size())
+                m_block.resize( m_block_len + 1u );
+        }
+
+        if (parse_block() == false)
+            return false;
+
+        if (m_records.size())
+            return true;
+    }
+}
+
+// parse the current block, splitting it in ranges
+//
+bool SequenceDataFile_Parallel::parse_block()
+{
+    const uint32 n_ranges = m_n_threads;
+
+    // resynchronize the range boundaries on record boundaries
+    std::vector<uint32> begin( n_ranges + 1u );
+    begin[0]        = 0u;
+    begin[n_ranges] = m_block_len;
+
+    #pragma omp parallel for num_threads(m_n_threads)
+    for (int32 r = 1; r < int32( n_ranges ); ++r)
+        begin[r] = resync( uint32( (uint64( m_block_len ) * uint64( r )) / n_ranges ) );
+
+    // parse all ranges
+    std::vector<uint32>     parsed( n_ranges );
+    std::vector<RangeState> state( n_ranges );
+
+    #pragma omp parallel for num_threads(m_n_threads)
+    for (int32 r = 0; r < int32( n_ranges ); ++r)
+        state[r] = parse_range( begin[r], begin[r+1], m_range_records[r], &parsed[r] );
+
+    // gather the records in order, stopping at the first incomplete one
+    m_block_parsed = m_block_len;
+
+    for (uint32 r = 0; r < n_ranges; ++r)
+    {
+        m_records.insert( m_records.end(), m_range_records[r].begin(), m_range_records[r].end() );
+
+        if (state[r] == RANGE_ERROR)
+        {
+            m_error_offset = m_block_offset + parsed[r];
+            m_file_state   = FILE_PARSE_ERROR;
+            m_records.clear();
+            return false;
+        }
+        if (state[r] == RANGE_INCOMPLETE)
+        {
+            // only the record straddling the end of the block can be incomplete
+            if (begin[r+1] != m_block_len)
+            {
+                m_error_offset = m_block_offset + parsed[r];
+                m_file_state   = FILE_PARSE_ERROR;
+                m_records.clear();
+                return false;
+            }
+            m_block_parsed = parsed[r];
+            break;
+        }
+    }
+
+    // assign constant qualities to FASTA reads
+    if (m_format == FASTA)
+    {
+        uint32 max_len = 0;
+        for (uint32 i = 0; i < m_records.size(); ++i)
+            max_len = nvbio::max( max_len, m_records[i].len );
+
+        if (m_fasta_quals.size() < max_len + 1u)
+            m_fasta_quals.resize( max_len + 1u, 50u );
+    }
+    return true;
+}
+
+// find the first record starting at or past a given offset
+//
+uint32 SequenceDataFile_Parallel::resync(const uint32 offset) const
+{
+    const char* block = &m_block[0];
+    const uint32 end  = m_block_len;
+
+    for (uint32 line = line_start( block, offset, end ); line < end; line = line_start( block, line + 1u, end ))
+    {
+        if (m_format == FASTA)
+        {
+            // '>' can only appear at the beginning of a header line
+            const uint32 marker = find( block, line, end, '>' );
+            if (marker == end)
+                return end;
+
+            if (marker == 0 || block[ marker-1 ] == '\n')
+                return marker;
+
+            line = marker;
+        }
+        else if (block[ line ] == '@')
+        {
+            // a line starting with '@' could be either a header or a quality line:
+            // only headers are followed by a '+' line after the sequence line
+            const uint32 bp_line   = line_start( block, line + 1u, end );
+            const uint32 plus_line = line_start( block, bp_line + 1u, end );
+            if (plus_line == end)
+                return end;
+
+            if (block[ plus_line ] == '+')
+                return line;
+        }
+    }
+    return end;
+}
+
+// parse all records starting in a given range, returning the offset past the last one,
+// or the offset of the first record which could not be parsed
+//
+SequenceDataFile_Parallel::RangeState SequenceDataFile_Parallel::parse_range(
+    const uint32            begin,
+    const uint32            end,
+    std::vector<Record>&    records,
+    uint32*                 parsed)
+{
+    records.clear();
+
+    const char* block = &m_block[0];
+
+    uint32 offset = begin;
+    while (1)
+    {
+        // consume spaces & newlines
+        while (offset < end && block[ offset ] >= 1 && block[ offset ] <= ' ')
+            ++offset;
+
+        if (offset >= end)
+            break;
+
+        Record record;
+
+        const uint32 record_begin = offset;
+
+        const RangeState state = m_format == FASTQ ?
+            parse_fastq( &offset, &record ) :
+            parse_fasta( &offset, &record );
+
+        if (state != RANGE_OK)
+        {
+            *parsed = record_begin;
+            return state;
+        }
+
+        records.push_back( record );
+    }
+
+    *parsed = offset;
+    return offset == end ? RANGE_OK : RANGE_ERROR;
+}
+
+// parse a FASTQ record starting at a given offset
+//
+SequenceDataFile_Parallel::RangeState SequenceDataFile_Parallel::parse_fastq(uint32* offset, Record* record)
+{
+    char* block      = &m_block[0];
+    const uint32 end = m_block_len;
+
+    const uint32 pos = *offset;
+
+    if (block[pos] != '@')
+        return RANGE_ERROR;
+
+    // locate the four lines
+    const uint32 name_end = find( block, pos, end, '\n' );
+    if (name_end == end)
+        return RANGE_INCOMPLETE;
+
+    const uint32 bp_end = find( block, name_end + 1u, end, '\n' );
+    if (bp_end == end)
+        return RANGE_INCOMPLETE;
+
+    if (bp_end + 1u == end)
+        return RANGE_INCOMPLETE;
+
+    if (block[ bp_end + 1u ] != '+')
+        return RANGE_ERROR;
+
+    const uint32 plus_end = find( block, bp_end + 1u, end, '\n' );
+    if (plus_end == end)
+        return RANGE_INCOMPLETE;
+
+    // the last newline is optional at the end of the file
+    const uint32 q_end = find( block, plus_end + 1u, end, '\n' );
+    if (q_end == end && m_eof == false)
+        return RANGE_INCOMPLETE;
+
+    // strip DOS line endings
+    const uint32 bp_begin  = name_end + 1u;
+    const uint32 q_begin   = plus_end + 1u;
+    const uint32 name_term = (name_end > pos + 1u && block[ name_end-1u ] == '\r') ? name_end - 1u : name_end;
+    const uint32 bp_len    = (bp_end > bp_begin && block[ bp_end-1u ] == '\r') ? bp_end - 1u - bp_begin : bp_end - bp_begin;
+    const uint32 q_len     = (q_end  > q_begin  && block[ q_end-1u ]  == '\r') ? q_end  - 1u - q_begin  : q_end  - q_begin;
+
+    // sequences and qualities split across multiple lines are not supported
+    if (bp_len != q_len)
+        return RANGE_ERROR;
+
+    // terminate the name in place
+    block[ name_term ] = '\0';
+
+    record->name = pos + 1u;
+    record->bp   = bp_begin;
+    record->q    = q_begin;
+    record->len  = bp_len;
+
+    *offset = q_end < end ? q_end + 1u : end;
+    return RANGE_OK;
+}
+
+// parse a FASTA record starting at a given offset
+//
+SequenceDataFile_Parallel::RangeState SequenceDataFile_Parallel::parse_fasta(uint32* offset, Record* record)
+{
+    char* block      = &m_block[0];
+    const uint32 end = m_block_len;
+
+    const uint32 pos = *offset;
+
+    if (block[pos] != '>')
+        return RANGE_ERROR;
+
+    // find the end of the record, i.e. the next header line
+    const uint32 name_end = find( block, pos, end, '\n' );
+    if (name_end == end && m_eof == false)
+        return RANGE_INCOMPLETE;
+
+    // the record ends at the next '>', which the serial parser takes as the start of a new
+    // record wherever it is: leave the ones not starting a line to it, as ranges are split
+    // at line starts
+    const uint32 record_end = name_end < end ? find( block, name_end + 1u, end, '>' ) : end;
+    if (record_end == end && m_eof == false)
+        return RANGE_INCOMPLETE;
+
+    if (record_end < end && block[ record_end-1u ] != '\n')
+        return RANGE_ERROR;
+
+    // tokenize as the serial FASTA_reader does: the name ends at the first space, and only
+    // spaces and newlines are dropped from the sequence (keeping e.g. '\r' and tabs)
+    uint32 name_len = 1u;
+    while (pos + name_len < name_end && block[ pos + name_len ] != ' ')
+        ++name_len;
+
+    block[ pos + name_len ] = '\0';
+
+    // compact the sequence lines in place
+    uint32 len = 0;
+    for (uint32 i = name_end + 1u; i < record_end; ++i)
+    {
+        if (block[i] != '\n' && block[i] != ' ')
+            block[ name_end + 1u + len++ ] = block[i];
+    }
+
+    record->name = pos + 1u;
+    record->bp   = name_end + 1u;
+    record->q    = 0u;
+    record->len  = len;
+
+    *offset = record_end;
+    return RANGE_OK;
+}
+
+///@} // SequenceIODetail
+///@} // SequenceIO
+///@} // IO
+
+} // namespace io
+} // namespace nvbio
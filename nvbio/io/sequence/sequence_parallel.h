@@ -0,0 +1,185 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <nvbio/io/sequence/sequence.h>
+#include <nvbio/io/sequence/sequence_priv.h>
+#include <nvbio/io/parallel_gzip_reader.h>
+#include <nvbio/basic/console.h>
+
+#include <string>
+#include <vector>
+
+namespace nvbio {
+namespace io {
+
+///@addtogroup IO
+///@{
+
+///@addtogroup SequenceIO
+///@{
+
+///@addtogroup SequenceIODetail
+///@{
+
+///
+/// A parallel loader for FASTQ and FASTA files, possibly gzipped.
+///
+/// The file is read a large block at a time. Each block is split in as many byte ranges
+/// as there are parsing threads, the beginning of each range is resynchronized on the first
+/// record starting at or past it, and all ranges are parsed concurrently by a team of
+/// OpenMP threads. The parsed records are kept in their original order and are finally
+/// handed to the SequenceDataEncoder in bulk, which encodes them in parallel as well.
+/// Records which straddle the end of a block are carried over to the next one.
+///
+/// Only FASTQ files made of four-line records are supported: files splitting sequences
+/// or qualities across multiple lines are rejected by init(), and should be read with
+/// SequenceDataFile_FASTQ_gz instead. If such records only show up past the first block,
+/// the rest of the file is handed over to the serial parser (SequenceDataFile_FASTQ_gz or
+/// SequenceDataFile_FASTA_gz), which either parses them or reports the parsing error
+/// through is_ok().
+///
+struct SequenceDataFile_Parallel : public SequenceDataFile
+{
+    /// the supported file formats
+    ///
+    enum Format
+    {
+        FASTQ,
+        FASTA,
+    };
+
+    /// constructor
+    ///
+    /// \param read_file_name       the file to open
+    /// \param format               the file format
+    /// \param options              the loading options
+    /// \param n_threads            the number of parsing threads, or 0 to use all OpenMP threads
+    /// \param block_size           the size of the blocks read from the file, or 0 to pick a default
+    ///
+    SequenceDataFile_Parallel(
+        const char*                         read_file_name,
+        const Format                        format,
+        const SequenceDataFile::Options&    options,
+        const uint32                        n_threads  = 0,
+        const uint32                        block_size = 0);
+
+    /// destructor
+    ///
+    ~SequenceDataFile_Parallel();
+
+    /// initialize the stream, parsing the first block
+    ///
+    bool init(void);
+
+    /// grab the next batch of reads into a host memory buffer
+    ///
+    int next(struct SequenceDataEncoder* encoder, const uint32 batch_size, const uint32 batch_bps);
+
+    /// rewind the file
+    ///
+    bool rewind();
+
+    /// return true if the stream is ok, including the serial stream it might have fallen back to
+    ///
+    bool is_ok(void) { return m_fallback ? m_fallback->is_ok() : SequenceDataFile::is_ok(); }
+
+protected:
+    // get a chunk of reads: unused, as next() is overridden
+    int nextChunk(struct SequenceDataEncoder* encoder, uint32 max_reads, uint32 max_bps) { return 0; }
+
+private:
+    // a parsed record, expressed as offsets in the current block
+    struct Record
+    {
+        uint32 name;
+        uint32 bp;
+        uint32 q;
+        uint32 len;
+    };
+
+    // the outcome of parsing a range
+    enum RangeState
+    {
+        RANGE_OK,           // all records have been parsed
+        RANGE_INCOMPLETE,   // the last record is incomplete
+        RANGE_ERROR,        // a malformed record has been found
+    };
+
+    // read the next block and parse it
+    bool load_block();
+
+    // hand the rest of the file over to a serial parser, skipping the reads output so far
+    bool fall_back(const uint32 n_skip);
+
+    // parse the current block, splitting it in ranges
+    bool parse_block();
+
+    // find the first record starting at or past a given offset
+    uint32 resync(const uint32 offset) const;
+
+    // parse all records starting in a given range, returning the offset past the last one,
+    // or the offset of the first record which could not be parsed
+    RangeState parse_range(const uint32 begin, const uint32 end, std::vector<Record>& records, uint32* parsed);
+
+    // parse a FASTQ record starting at a given offset, advancing it past the record
+    RangeState parse_fastq(uint32* offset, Record* record);
+
+    // parse a FASTA record starting at a given offset, advancing it past the record
+    RangeState parse_fasta(uint32* offset, Record* record);
+
+    ParallelGzipReader                  m_file;
+    std::string                         m_file_name;
+    SequenceDataFile*                   m_fallback;         // the serial parser reading past a malformed block
+    Format                              m_format;
+    uint32                              m_n_threads;
+
+    std::vector<char>                   m_block;            // the current block
+    uint32                              m_block_len;        // the number of bytes in the block
+    uint32                              m_block_parsed;     // the offset past the last complete record
+    uint64                              m_block_offset;     // the file offset of the block
+    bool                                m_eof;
+    uint64                              m_error_offset;     // the file offset of the first malformed record
+
+    std::vector<Record>                 m_records;          // the records parsed from the block
+    uint32                              m_record_pos;       // the next record to output
+    std::vector< std::vector<Record> >  m_range_records;    // the records parsed from each range
+
+    std::vector<uint8>                  m_fasta_quals;      // the constant qualities assigned to FASTA reads
+    std::vector<uint32>                 m_lens;             // temporary arrays used to push records in bulk
+    std::vector<const char*>            m_names;
+    std::vector<const uint8*>           m_bps;
+    std::vector<const uint8*>           m_quals;
+};
+
+///@} // SequenceIODetail
+///@} // SequenceIO
+///@} // IO
+
+} // namespace io
+} // namespace nvbio
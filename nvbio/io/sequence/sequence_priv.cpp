@@ -33,7 +33,10 @@
 #include <nvbio/io/sequence/sequence_txt.h>
 #include <nvbio/io/sequence/sequence_sam.h>
 #include <nvbio/io/sequence/sequence_bam.h>
+#include <nvbio/io/sequence/sequence_cram.h>
 #include <nvbio/io/sequence/sequence_pac.h>
+#include <nvbio/io/sequence/sequence_cache.h>
+#include <nvbio/io/sequence/sequence_parallel.h>
 
 #include <nvbio/basic/shared_pointer.h>
 
@@ -45,7 +48,7 @@ int SequenceDataFile::next(SequenceDataEncoder* encoder, const uint32 batch_size
 {
     const uint32 reads_to_load = std::min(m_options.max_seqs - m_loaded, batch_size);
 
-    if (!is_ok() || reads_to_load == 0)
+    if (m_file_state != FILE_OK || reads_to_load == 0)
         return 0;
 
     // a default average read length used to reserve enough space
@@ -81,6 +84,40 @@ int SequenceDataFile::next(SequenceDataEncoder* encoder, const uint32 batch_size
     return info->size();
 }
 
+namespace {
+
+// open a FASTQ or FASTA file with the parallel parser, falling back to a serial
+// parser if the file can't be parsed that way
+//
+template <typename serial_file_type>
+SequenceDataStream* open_parallel_file(
+    const char*                         sequence_file_name,
+    const SequenceDataFile_Parallel::Format format,
+    const SequenceDataFile::Options&    options,
+    const uint32                        n_threads)
+{
+    if (n_threads != 1)
+    {
+        SequenceDataFile_Parallel* ret = new SequenceDataFile_Parallel(
+            sequence_file_name,
+            format,
+            options,
+            n_threads );
+
+        if (ret->init())
+            return ret;
+
+        delete ret;
+
+        log_warning(stderr, "unable to parse %s in parallel, falling back to the serial parser\n", sequence_file_name);
+    }
+    return new serial_file_type(
+        sequence_file_name,
+        options );
+}
+
+} // anonymous namespace
+
 // factory method to open a read file, tries to detect file type based on file name
 SequenceDataStream *open_sequence_file(
     const char *             sequence_file_name,
@@ -89,7 +126,10 @@ SequenceDataStream *open_sequence_file(
     const uint32             max_sequence_len,
     const SequenceEncoding   flags,
     const uint32             trim3,
-    const uint32             trim5)
+    const uint32             trim5,
+    const uint32             n_threads,
+    const uint32             skip_flags,
+    const char*              reference_name)
 {
     // parse out file extension; look for .fastq.gz, .fastq suffixes
     uint32 len = uint32( strlen(sequence_file_name) );
@@ -102,6 +142,7 @@ SequenceDataStream *open_sequence_file(
     options.flags            = flags;
     options.trim3            = trim3;
     options.trim5            = trim5;
+    options.skip_flags       = skip_flags;
 
     if (len == 0)
     {
@@ -126,9 +167,11 @@ SequenceDataStream *open_sequence_file(
     {
         if (strncmp(&sequence_file_name[len - strlen(".fasta")], ".fasta", strlen(".fasta")) == 0)
         {
-            return new SequenceDataFile_FASTA_gz(
+            return open_parallel_file<SequenceDataFile_FASTA_gz>(
                 sequence_file_name,
-                options );
+                SequenceDataFile_Parallel::FASTA,
+                options,
+                n_threads );
         }
     }
     // check for fastq suffix
@@ -136,9 +179,11 @@ SequenceDataStream *open_sequence_file(
     {
         if (strncmp(&sequence_file_name[len - strlen(".fa")], ".fa", strlen(".fa")) == 0)
         {
-            return new SequenceDataFile_FASTA_gz(
+            return open_parallel_file<SequenceDataFile_FASTA_gz>(
                 sequence_file_name,
-                options );
+                SequenceDataFile_Parallel::FASTA,
+                options,
+                n_threads );
         }
     }
 
@@ -147,9 +192,11 @@ SequenceDataStream *open_sequence_file(
     {
         if (strncmp(&sequence_file_name[len - strlen(".fastq")], ".fastq", strlen(".fastq")) == 0)
         {
-            return new SequenceDataFile_FASTQ_gz(
+            return open_parallel_file<SequenceDataFile_FASTQ_gz>(
                 sequence_file_name,
-                options );
+                SequenceDataFile_Parallel::FASTQ,
+                options,
+                n_threads );
         }
     }
 
@@ -158,9 +205,11 @@ SequenceDataStream *open_sequence_file(
     {
         if (strncmp(&sequence_file_name[len - strlen(".fq")], ".fq", strlen(".fq")) == 0)
         {
-            return new SequenceDataFile_FASTQ_gz(
+            return open_parallel_file<SequenceDataFile_FASTQ_gz>(
                 sequence_file_name,
-                options );
+                SequenceDataFile_Parallel::FASTQ,
+                options,
+                n_threads );
         }
     }
 
@@ -205,7 +254,53 @@ SequenceDataStream *open_sequence_file(
 
             ret = new SequenceDataFile_BAM(
                 sequence_file_name,
-                options );
+                options,
+                n_threads );
+
+            if (ret->init() == false)
+            {
+                delete ret;
+                return NULL;
+            }
+
+            return ret;
+        }
+    }
+
+    // check for cram suffix
+    if (len >= strlen(".cram"))
+    {
+        if (strncmp(&sequence_file_name[len - strlen(".cram")], ".cram", strlen(".cram")) == 0)
+        {
+            SequenceDataFile_CRAM *ret;
+
+            ret = new SequenceDataFile_CRAM(
+                sequence_file_name,
+                options,
+                n_threads,
+                reference_name );
+
+            if (ret->init() == false)
+            {
+                delete ret;
+                return NULL;
+            }
+
+            return ret;
+        }
+    }
+
+    // check for nvr suffix
+    if (len >= strlen(".nvr"))
+    {
+        if (strncmp(&sequence_file_name[len - strlen(".nvr")], ".nvr", strlen(".nvr")) == 0)
+        {
+            SequenceDataFile_Cache *ret;
+
+            ret = new SequenceDataFile_Cache(
+                sequence_file_name,
+                options,
+                n_threads );
 
             if (ret->init() == false)
             {
@@ -371,6 +466,17 @@ SequenceDataOutputStream* open_output_sequence_file(
         }
     }
 
+    // check for nvr suffix
+    if (len >= strlen(".nvr"))
+    {
+        if (strncmp(&sequence_file_name[len - strlen(".nvr")], ".nvr", strlen(".nvr")) == 0)
+        {
+            return new SequenceDataOutputFile_Cache(
+                sequence_file_name,
+                options );
+        }
+    }
+
     // we don't actually know what this is; guess fastq
     log_warning(stderr, "could not determine file type for %s; guessing fastq\n", sequence_file_name);
     return new SequenceDataOutputFile_FASTQ(
@@ -55,7 +55,8 @@ struct SequenceDataFile : public SequenceDataStream
             max_sequence_len(uint32(-1)),
             trim3(0),
             trim5(0),
-            flags(FORWARD) {}
+            flags(FORWARD),
+            skip_flags(0x100) {}
 
         QualityEncoding    qualities;
         uint32             max_seqs;
@@ -63,6 +64,7 @@ struct SequenceDataFile : public SequenceDataStream
         uint32             trim3;
         uint32             trim5;
         SequenceEncoding   flags;
+        uint32             skip_flags;      ///< SAM and BAM records with any of these SAM flags set are skipped
     };
 
     static const uint32 LONG_READ = 32*1024;
@@ -102,11 +104,12 @@ public:
     ///
     virtual int next(struct SequenceDataEncoder* encoder, const uint32 batch_size, const uint32 batch_bps);
 
-    /// returns true if the stream is ready to read from
+    /// returns true if the stream has been opened and no error has occurred since;
+    /// reaching the end of the stream is not an error
     ///
     virtual bool is_ok(void)
     {
-        return m_file_state == FILE_OK;
+        return m_file_state == FILE_OK || m_file_state == FILE_EOF;
     };
 
 protected:
@@ -0,0 +1,126 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <nvbio/io/sequence/sequence_qualities.h>
+#include <nvbio/basic/console.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace nvbio {
+namespace io {
+
+// the 8-level binning scheme used by Illumina's sequencers
+//
+QualityBins QualityBins::illumina()
+{
+    const uint8 lower[8] = { 0, 2, 10, 20, 25, 30, 35, 40 };
+    const uint8 value[8] = { 0, 6, 15, 22, 27, 33, 37, 40 };
+
+    QualityBins bins;
+    bins.m_n_bins = 8u;
+    for (uint32 i = 0; i < 8u; ++i)
+    {
+        bins.m_lower[i] = lower[i];
+        bins.m_value[i] = value[i];
+    }
+    return bins;
+}
+
+// parse a binning scheme
+//
+bool QualityBins::parse(const char* spec, QualityBins* bins)
+{
+    if (strcmp( spec, "illumina" ) == 0)
+    {
+        *bins = illumina();
+        return true;
+    }
+
+    QualityBins r;
+
+    const char* p = spec;
+    while (*p)
+    {
+        char* end;
+        const long lower = strtol( p, &end, 10 );
+        if (end == p || *end != ':')
+            break;
+
+        p = end + 1;
+        const long value = strtol( p, &end, 10 );
+        if (end == p || (*end != ',' && *end != '\0'))
+            break;
+
+        if (r.m_n_bins == MAX_BINS)
+        {
+            log_error(stderr, "quality bins \"%s\": at most %u bins are supported\n", spec, MAX_BINS);
+            return false;
+        }
+        if (lower < 0 || lower > 255 || value < 0 || value > 255)
+        {
+            log_error(stderr, "quality bins \"%s\": Phred scores must be in the range [0,255]\n", spec);
+            return false;
+        }
+        if ((r.m_n_bins == 0u && lower != 0) ||
+            (r.m_n_bins >  0u && lower <= r.m_lower[ r.m_n_bins-1 ]))
+        {
+            log_error(stderr, "quality bins \"%s\": lower bounds must start at 0 and be strictly increasing\n", spec);
+            return false;
+        }
+
+        r.m_lower[ r.m_n_bins ] = uint8( lower );
+        r.m_value[ r.m_n_bins ] = uint8( value );
+        r.m_n_bins++;
+
+        p = *end ? end + 1 : end;
+    }
+
+    if (*p || r.m_n_bins == 0u)
+    {
+        log_error(stderr, "quality bins \"%s\": expected \"illumina\" or a list of lower:value pairs\n", spec);
+        return false;
+    }
+
+    *bins = r;
+    return true;
+}
+
+// fill a 256-entry table mapping each Phred score to its bin
+//
+void QualityBins::bin_table(uint8* table) const
+{
+    for (uint32 q = 0, b = 0; q < 256; ++q)
+    {
+        if (b + 1u < m_n_bins && q >= m_lower[b+1])
+            ++b;
+
+        table[q] = uint8( b );
+    }
+}
+
+} // namespace io
+} // namespace nvbio
@@ -0,0 +1,275 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/iterator.h>
+
+namespace nvbio {
+namespace io {
+
+///@addtogroup IO
+///@{
+
+///@addtogroup SequenceIO
+///@{
+
+///
+/// A lossy quality binning scheme, mapping Phred scores to at most 16 bins, each represented
+/// by a single score.
+///\par
+/// When a SequenceDataHost is configured with a non-plain binning scheme (see SequenceDataStorage::set_quality_bins()),
+/// the sequence encoder replaces each incoming quality with its bin index and packs two of them per byte,
+/// halving the size of the quality stream. Binned qualities can then be read through a SequenceDataAccess
+/// instantiated with BINNED_QUALITIES = true, which returns the score represented by each bin, or expanded
+/// back to plain scores with expand_qualities().
+///
+struct QualityBins
+{
+    static const uint32 MAX_BINS = 16u;
+
+    /// empty constructor: plain qualities
+    ///
+    NVBIO_HOST_DEVICE NVBIO_FORCEINLINE
+    QualityBins() : m_n_bins(0) {}
+
+    /// return true if qualities are stored as plain Phred scores
+    ///
+    NVBIO_HOST_DEVICE NVBIO_FORCEINLINE bool   is_plain() const { return m_n_bins == 0u; }
+
+    /// return the number of bins
+    ///
+    NVBIO_HOST_DEVICE NVBIO_FORCEINLINE uint32 size()     const { return m_n_bins; }
+
+    /// return the Phred score represented by a given bin
+    ///
+    NVBIO_HOST_DEVICE NVBIO_FORCEINLINE uint8  value(const uint32 bin) const { return m_value[bin]; }
+
+    /// return the number of bytes needed to store the qualities of n bases
+    ///
+    NVBIO_HOST_DEVICE NVBIO_FORCEINLINE uint32 storage_size(const uint32 n) const { return is_plain() ? n : (n + 1u) / 2u; }
+
+    /// the 8-level binning scheme used by Illumina's sequencers
+    ///
+    static QualityBins illumina();
+
+    /// parse a binning scheme, either "illumina", or a comma-separated list of "lower:value" pairs,
+    /// e.g. "0:0,2:6,10:15,20:22,25:27,30:33,35:37,40:40", where each bin covers the Phred scores
+    /// from its lower bound up to the lower bound of the next one;
+    /// the bounds must be strictly increasing, and start at 0.
+    ///
+    /// \return     false if the specification is invalid
+    ///
+    static bool parse(const char* spec, QualityBins* bins);
+
+    /// fill a 256-entry table mapping each Phred score to its bin
+    ///
+    void bin_table(uint8* table) const;
+
+    uint32 m_n_bins;                ///< the number of bins, or 0 for plain qualities
+    uint8  m_lower[MAX_BINS];       ///< the lowest Phred score covered by each bin
+    uint8  m_value[MAX_BINS];       ///< the Phred score represented by each bin
+};
+
+/// comparison operator for QualityBins
+///
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+bool operator== (
+    const QualityBins& op1,
+    const QualityBins& op2)
+{
+    if (op1.m_n_bins != op2.m_n_bins)
+        return false;
+
+    for (uint32 i = 0; i < op1.m_n_bins; ++i)
+    {
+        if (op1.m_lower[i] != op2.m_lower[i] ||
+            op1.m_value[i] != op2.m_value[i])
+            return false;
+    }
+    return true;
+}
+
+/// comparison operator for QualityBins
+///
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+bool operator!= (
+    const QualityBins& op1,
+    const QualityBins& op2)
+{
+    return !(op1 == op2);
+}
+
+///
+/// A random access iterator decoding the qualities stored by a SequenceData object with a
+/// QualityBins scheme, i.e. as 4-bit bin indices packed two per byte (the first in the low nibble),
+/// returning the Phred score represented by each bin.
+///
+/// \tparam QualStorageIterator     the type of the iterator to the qualities storage
+///
+template <typename QualStorageIterator>
+struct BinnedQualityStream
+{
+    typedef char                                                                    value_type;
+    typedef char                                                                    reference;
+    typedef char                                                                    const_reference;
+    typedef const char*                                                             pointer;
+    typedef int32                                                                   difference_type;
+    typedef typename std::iterator_traits<QualStorageIterator>::iterator_category   iterator_category;
+
+    /// empty constructor
+    ///
+    NVBIO_HOST_DEVICE NVBIO_FORCEINLINE
+    BinnedQualityStream() {}
+
+    /// constructor
+    ///
+    /// \param storage      the qualities storage
+    /// \param bins         the binning scheme used to store the qualities
+    ///
+    NVBIO_HOST_DEVICE NVBIO_FORCEINLINE
+    BinnedQualityStream(const QualStorageIterator storage, const QualityBins& bins)
+      : m_storage( storage ), m_index( 0 )
+    {
+        for (uint32 i = 0; i < QualityBins::MAX_BINS; ++i)
+            m_value[i] = i < bins.size() ? bins.value(i) : 0u;
+    }
+
+    /// indexing operator
+    ///
+    NVBIO_HOST_DEVICE NVBIO_FORCEINLINE
+    char operator[] (const uint32 i) const
+    {
+        const uint32 p    = m_index + i;
+        const uint8  bins = uint8( m_storage[ p >> 1 ] );
+        return char( m_value[ (bins >> ((p & 1u) * 4u)) & 15u ] );
+    }
+
+    /// dereference operator
+    ///
+    NVBIO_HOST_DEVICE NVBIO_FORCEINLINE
+    char operator* () const { return (*this)[0]; }
+
+    /// pre-increment
+    ///
+    NVBIO_HOST_DEVICE NVBIO_FORCEINLINE
+    BinnedQualityStream& operator++ () { ++m_index; return *this; }
+
+    /// post-increment
+    ///
+    NVBIO_HOST_DEVICE NVBIO_FORCEINLINE
+    BinnedQualityStream operator++ (int) { BinnedQualityStream r( *this ); ++m_index; return r; }
+
+    /// pre-decrement
+    ///
+    NVBIO_HOST_DEVICE NVBIO_FORCEINLINE
+    BinnedQualityStream& operator-- () { --m_index; return *this; }
+
+    /// post-decrement
+    ///
+    NVBIO_HOST_DEVICE NVBIO_FORCEINLINE
+    BinnedQualityStream operator-- (int) { BinnedQualityStream r( *this ); --m_index; return r; }
+
+    /// addition
+    ///
+    NVBIO_HOST_DEVICE NVBIO_FORCEINLINE
+    BinnedQualityStream operator+ (const difference_type i) const { BinnedQualityStream r( *this ); r.m_index += i; return r; }
+
+    /// subtraction
+    ///
+    NVBIO_HOST_DEVICE NVBIO_FORCEINLINE
+    BinnedQualityStream operator- (const difference_type i) const { BinnedQualityStream r( *this ); r.m_index -= i; return r; }
+
+    /// addition
+    ///
+    NVBIO_HOST_DEVICE NVBIO_FORCEINLINE
+    BinnedQualityStream& operator+= (const difference_type i) { m_index += i; return *this; }
+
+    /// subtraction
+    ///
+    NVBIO_HOST_DEVICE NVBIO_FORCEINLINE
+    BinnedQualityStream& operator-= (const difference_type i) { m_index -= i; return *this; }
+
+    /// iterator subtraction
+    ///
+    NVBIO_HOST_DEVICE NVBIO_FORCEINLINE
+    difference_type operator- (const BinnedQualityStream& it) const { return difference_type( m_index ) - difference_type( it.m_index ); }
+
+    /// equality test
+    ///
+    NVBIO_HOST_DEVICE NVBIO_FORCEINLINE
+    bool operator== (const BinnedQualityStream& it) const { return m_storage == it.m_storage && m_index == it.m_index; }
+
+    /// inequality test
+    ///
+    NVBIO_HOST_DEVICE NVBIO_FORCEINLINE
+    bool operator!= (const BinnedQualityStream& it) const { return !(*this == it); }
+
+    QualStorageIterator m_storage;                      ///< the qualities storage
+    uint32              m_index;                        ///< the current quality index
+    uint8               m_value[QualityBins::MAX_BINS]; ///< the Phred score represented by each bin
+};
+
+///
+/// A helper class selecting at compile-time the iterator used to read qualities out of their storage:
+/// plain qualities are read directly through the storage iterator, binned ones through a BinnedQualityStream.
+///
+/// \tparam BINNED                  whether the qualities are binned
+/// \tparam QualStorageIterator     the type of the iterator to the qualities storage
+///
+template <bool BINNED, typename QualStorageIterator>
+struct QualityStreamSelector
+{
+    typedef QualStorageIterator type;
+
+    /// return a quality stream
+    ///
+    NVBIO_HOST_DEVICE NVBIO_FORCEINLINE
+    static type make(const QualStorageIterator storage, const QualityBins& bins) { return storage; }
+};
+
+///
+/// A helper class selecting at compile-time the iterator used to read qualities out of their storage,
+/// specialized for binned qualities.
+///
+template <typename QualStorageIterator>
+struct QualityStreamSelector<true,QualStorageIterator>
+{
+    typedef BinnedQualityStream<QualStorageIterator> type;
+
+    /// return a quality stream
+    ///
+    NVBIO_HOST_DEVICE NVBIO_FORCEINLINE
+    static type make(const QualStorageIterator storage, const QualityBins& bins) { return type( storage, bins ); }
+};
+
+///@} // SequenceIO
+///@} // IO
+
+} // namespace io
+} // namespace nvbio
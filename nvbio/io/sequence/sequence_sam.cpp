@@ -380,7 +380,7 @@ int SequenceDataFile_SAM::nextChunk(SequenceDataEncoder *output, uint32 max_read
 
     uint32 read_flags;
 
-    // find the next primary alignment from the file
+    // find the next alignment which isn't filtered out by its flags
     do {
         // get next line from file
         if (readLine() == false)
@@ -420,7 +420,7 @@ int SequenceDataFile_SAM::nextChunk(SequenceDataEncoder *output, uint32 max_read
 
         // figure out what the flag value is
         read_flags = strtol(flag, NULL, 0);
-    } while(read_flags & SAMFlag_SecondaryAlignment);
+    } while(read_flags & m_options.skip_flags);
 
     if (m_options.flags & FORWARD)
     {
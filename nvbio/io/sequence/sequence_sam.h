@@ -74,6 +74,8 @@ enum AlignmentFlags
     SAMFlag_FailedQC = 0x200,
     // PCR or optical duplicate
     SAMFlag_Duplicate = 0x400,
+    // supplementary alignment
+    SAMFlag_SupplementaryAlignment = 0x800,
 };
 
 
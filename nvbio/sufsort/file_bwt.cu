@@ -27,6 +27,7 @@
 
 #include <nvbio/sufsort/file_bwt.h>
 #include <nvbio/sufsort/file_bwt_bgz.h>
+#include <nvbio/sufsort/file_bwt_lz4.h>
 #include <nvbio/sufsort/sufsort_priv.h>
 #include <zlib/zlib.h>
 #ifdef _OPENMP
@@ -461,6 +462,161 @@ struct ASCIIFileBWTHandler : public SetBWTHandler, public BWTWriter
     std::vector<char>       dollar_buffer;
 };
 
+/// A class to output the BWT to a run-length encoded binary file.
+///
+/// Each run is encoded as a LEB128 variable-length integer containing the value
+/// ((length - 1) << 4) | symbol, where symbols larger than 15 are saturated to 15.
+///
+template <typename BWTWriter>
+struct RLFileBWTHandler : public SetBWTHandler, public BWTWriter
+{
+    /// constructor
+    ///
+    RLFileBWTHandler() : offset(0), n_runs(0), run_symbol(0), run_length(0) {}
+
+    /// destructor
+    ///
+    virtual ~RLFileBWTHandler()
+    {
+        // encode the last pending run
+        if (run_length)
+        {
+            encode_run( run_symbol, run_length );
+            flush_runs();
+        }
+        log_verbose(stderr,"  encoded %llu symbols in %llu runs\n", offset, n_runs);
+    }
+
+    /// write header
+    ///
+    void write_header()
+    {
+        const char* magic = "PRIB";         // PRImary-Binary
+        BWTWriter::index_write( 4, magic );
+
+        const char* rl_magic = "RLBW";      // Run-Length BWT
+        BWTWriter::bwt_write( 4, rl_magic );
+    }
+
+    /// append a run to the output buffer
+    ///
+    void encode_run(const uint8 c, const uint64 len)
+    {
+        uint64 v = ((len - 1u) << 4) | nvbio::min( uint32(c), 15u );
+
+        // LEB128 encoding
+        while (v >= 0x80u)
+        {
+            runs.push_back( uint8( v & 0x7Fu ) | 0x80u );
+            v >>= 7;
+        }
+        runs.push_back( uint8( v ) );
+        ++n_runs;
+    }
+
+    /// write out the encoded runs
+    ///
+    void flush_runs()
+    {
+        if (runs.empty())
+            return;
+
+        const uint32 n_bytes   = uint32( runs.size() );
+        const uint32 n_written = BWTWriter::bwt_write( n_bytes, &runs[0] );
+        if (n_written != n_bytes)
+            throw nvbio::runtime_error("RLFileBWTHandler::process() : bwt write failed! (%u/%u bytes written)", n_written, n_bytes);
+
+        runs.clear();
+    }
+
+    /// process a batch of BWT symbols
+    ///
+    template <typename bwt_iterator>
+    void write(
+        const uint32        n_suffixes,
+        const bwt_iterator  bwt,
+        const uint32        n_dollars,
+        const uint64*       dollar_pos,
+        const uint64*       dollar_ids)
+    {
+        // extend the pending run and encode all the ones that get closed
+        // (note that runs can span across batches)
+        for (uint32 i = 0; i < n_suffixes; ++i)
+        {
+            const uint8 c = bwt[i];
+
+            if (run_length && c == run_symbol)
+                ++run_length;
+            else
+            {
+                if (run_length)
+                    encode_run( run_symbol, run_length );
+
+                run_symbol = c;
+                run_length = 1u;
+            }
+        }
+        flush_runs();
+
+        // and write the list to the output
+        if (n_dollars)
+        {
+            priv::alloc_storage( dollars, n_dollars );
+
+            #pragma omp parallel for
+            for (int32 i = 0; i < int32( n_dollars ); ++i)
+                dollars[i] = std::make_pair( dollar_pos[i], dollar_ids[i] );
+
+            const uint32 n_bytes   = uint32( sizeof(uint64) * 2 * n_dollars );
+            const uint32 n_written = BWTWriter::index_write( n_bytes, &dollars[0] );
+            if (n_written != n_bytes)
+                throw nvbio::runtime_error("RLFileBWTHandler::process() : index write failed! (%u/%u bytes written)", n_written, n_bytes);
+        }
+
+        // advance the offset
+        offset += n_suffixes;
+    }
+
+    /// process a batch of BWT symbols
+    ///
+    void process(
+        const uint32  n_suffixes,
+        const uint32  bits_per_symbol,
+        const uint32* bwt,
+        const uint32  n_dollars,
+        const uint64* dollar_pos,
+        const uint64* dollar_ids)
+    {
+        if (bits_per_symbol == 2)
+            write( n_suffixes, PackedStream<const uint32*,uint8,2,true>( bwt ), n_dollars, dollar_pos, dollar_ids );
+        else if (bits_per_symbol == 4)
+            write( n_suffixes, PackedStream<const uint32*,uint8,4,true>( bwt ), n_dollars, dollar_pos, dollar_ids );
+        else if (bits_per_symbol == 8)
+            write( n_suffixes, PackedStream<const uint32*,uint8,8,true>( bwt ), n_dollars, dollar_pos, dollar_ids );
+        else
+            throw nvbio::runtime_error("RLFileBWTHandler::process() : unsupported input format! (%u bits per symbol)", bits_per_symbol);
+    }
+
+    /// process a batch of BWT symbols
+    ///
+    void process(
+        const uint32  n_suffixes,
+        const uint8*  bwt,
+        const uint32  n_dollars,
+        const uint64* dollar_pos,
+        const uint64* dollar_ids)
+    {
+        write( n_suffixes, bwt, n_dollars, dollar_pos, dollar_ids );
+    }
+
+    uint64                  offset;
+    uint64                  n_runs;
+    uint8                   run_symbol;
+    uint64                  run_length;
+    std::vector<uint8>      runs;
+    std::vector< std::pair<uint64,uint64> > dollars;
+};
+
 /// A class to output the BWT to a binary file
 ///
 struct RawBWTWriter
@@ -610,9 +766,80 @@ uint32 BWTGZWriter::index_write(const uint32 n_bytes, const void* buffer)
 bool BWTGZWriter::is_ok() const { return output_file != NULL || index_file != NULL; }
 
 
+// read a run-length encoded BWT file
+//
+bool read_rlbwt_file(const char* input_name, std::vector<uint8>& heads, std::vector<uint64>& lengths)
+{
+    gzFile file = gzopen( input_name, "rb" );
+    if (file == NULL)
+    {
+        log_error(stderr,"  unable to open input file \"%s\"\n", input_name);
+        return false;
+    }
+
+    char magic[4];
+    if (gzread( file, magic, 4 ) != 4 || strncmp( magic, "RLBW", 4 ) != 0)
+    {
+        log_error(stderr,"  invalid run-length BWT file \"%s\"\n", input_name);
+        gzclose( file );
+        return false;
+    }
+
+    heads.clear();
+    lengths.clear();
+
+    std::vector<uint8> buffer( 1024*1024 );
+
+    uint64 v     = 0;
+    uint32 shift = 0;
+
+    bool overflow = false;
+
+    int n_bytes;
+    while (overflow == false && (n_bytes = gzread( file, &buffer[0], (unsigned int)buffer.size() )) > 0)
+    {
+        // decode the LEB128 encoded runs
+        for (int i = 0; i < n_bytes; ++i)
+        {
+            // a run must fit in 64 bits: the 10-th byte may only carry the top bit,
+            // and there can't be an 11-th one
+            if (shift >= 64u || (shift == 63u && (buffer[i] & 0x7Eu)))
+            {
+                overflow = true;
+                break;
+            }
+
+            v |= uint64( buffer[i] & 0x7Fu ) << shift;
+
+            if (buffer[i] & 0x80u)
+                shift += 7;
+            else
+            {
+                heads.push_back( uint8( v & 15u ) );
+                lengths.push_back( (v >> 4) + 1u );
+                v     = 0;
+                shift = 0;
+            }
+        }
+    }
+    gzclose( file );
+
+    if (overflow)
+    {
+        log_error(stderr,"  corrupt run-length BWT file \"%s\": run length overflows 64 bits\n", input_name);
+        return false;
+    }
+    if (n_bytes < 0 || shift)
+    {
+        log_error(stderr,"  error reading run-length BWT file \"%s\"\n", input_name);
+        return false;
+    }
+    return true;
+}
+
 // open a BWT file
 //
-SetBWTHandler* open_bwt_file(const char* output_name, const char* params)
+SetBWTHandler* open_bwt_file(const char* output_name, const char* params, const uint32 compression_threads, const uint64 compression_memory)
 {
     enum OutputFormat
     {
@@ -629,6 +856,8 @@ SetBWTHandler* open_bwt_file(const char* output_name, const char* params)
         BWT4GZ  = 10,
         BWT4BGZ = 11,
         BWT4LZ4 = 12,
+        RLBWT   = 13,
+        RLBWTGZ = 14,
     };
     OutputFormat format = UNKNOWN;
     std::string  index_string = output_name;
@@ -640,6 +869,14 @@ SetBWTHandler* open_bwt_file(const char* output_name, const char* params)
         //
         // detect BWT2* variants
         //
+        if (len >= strlen(".bwt.lz4"))
+        {
+            if (strcmp(&output_name[len - strlen(".bwt.lz4")], ".bwt.lz4") == 0)
+            {
+                format = BWT2LZ4;
+                index_string.replace( index_string.find(".bwt.lz4"), 8u, ".pri.lz4" );
+            }
+        }
         if (len >= strlen(".bwt.bgz"))
         {
             if (strcmp(&output_name[len - strlen(".bwt.bgz")], ".bwt.bgz") == 0)
@@ -668,6 +905,14 @@ SetBWTHandler* open_bwt_file(const char* output_name, const char* params)
         //
         // detect BWT4* variants
         //
+        if (len >= strlen(".bwt4.lz4"))
+        {
+            if (strcmp(&output_name[len - strlen(".bwt4.lz4")], ".bwt4.lz4") == 0)
+            {
+                format = BWT4LZ4;
+                index_string.replace( index_string.find(".bwt4.lz4"), 9u, ".pri.lz4" );
+            }
+        }
         if (len >= strlen(".bwt4.bgz"))
         {
             if (strcmp(&output_name[len - strlen(".bwt4.bgz")], ".bwt4.bgz") == 0)
@@ -693,9 +938,37 @@ SetBWTHandler* open_bwt_file(const char* output_name, const char* params)
             }
         }
 
+        //
+        // detect RLBWT* variants
+        //
+        if (len >= strlen(".rlbwt.gz"))
+        {
+            if (strcmp(&output_name[len - strlen(".rlbwt.gz")], ".rlbwt.gz") == 0)
+            {
+                format = RLBWTGZ;
+                index_string.replace( index_string.find(".rlbwt.gz"), 9u, ".pri.gz" );
+            }
+        }
+        if (len >= strlen(".rlbwt"))
+        {
+            if (strcmp(&output_name[len - strlen(".rlbwt")], ".rlbwt") == 0)
+            {
+                format = RLBWT;
+                index_string.replace( index_string.find(".rlbwt"), 6u, ".pri" );
+            }
+        }
+
         //
         // detect TXT* variants
         //
+        if (len >= strlen(".txt.lz4"))
+        {
+            if (strcmp(&output_name[len - strlen(".txt.lz4")], ".txt.lz4") == 0)
+            {
+                format = TXTLZ4;
+                index_string.replace( index_string.find(".txt.lz4"), 8u, ".pri.lz4" );
+            }
+        }
         if (len >= strlen(".txt.gz"))
         {
             if (strcmp(&output_name[len - strlen(".txt.gz")], ".txt.gz") == 0)
@@ -708,7 +981,7 @@ SetBWTHandler* open_bwt_file(const char* output_name, const char* params)
         {
             if (strcmp(&output_name[len - strlen(".txt.bgz")], ".txt.bgz") == 0)
             {
-                format = TXTGZ;
+                format = TXTBGZ;
                 index_string.replace( index_string.find(".txt.bgz"), 8u, ".pri.bgz" );
             }
         }
@@ -741,7 +1014,7 @@ SetBWTHandler* open_bwt_file(const char* output_name, const char* params)
         // build an output handler
         FileBWTHandler<BWTBGZWriter,2,true,uint32>* file_handler = new FileBWTHandler<BWTBGZWriter,2,true,uint32>();
 
-        file_handler->open( output_name, index_string.c_str(), params );
+        file_handler->open( output_name, index_string.c_str(), params, compression_threads, compression_memory );
         if (file_handler->is_ok() == false)
         {
             log_error(stderr,"  unable to open output file \"%s\"\n", output_name);
@@ -764,6 +1037,20 @@ SetBWTHandler* open_bwt_file(const char* output_name, const char* params)
         file_handler->write_header();
         return file_handler;
     }
+    else if (format == BWT2LZ4)
+    {
+        // build an output handler
+        FileBWTHandler<BWTLZ4Writer,2,true,uint32>* file_handler = new FileBWTHandler<BWTLZ4Writer,2,true,uint32>();
+
+        file_handler->open( output_name, index_string.c_str(), params, compression_threads, compression_memory );
+        if (file_handler->is_ok() == false)
+        {
+            log_error(stderr,"  unable to open output file \"%s\"\n", output_name);
+            return NULL;
+        }
+        file_handler->write_header();
+        return file_handler;
+    }
     else if (format == BWT4)
     {
         // build an output handler
@@ -783,7 +1070,7 @@ SetBWTHandler* open_bwt_file(const char* output_name, const char* params)
         // build an output handler
         FileBWTHandler<BWTBGZWriter,4,true,uint32>* file_handler = new FileBWTHandler<BWTBGZWriter,4,true,uint32>();
 
-        file_handler->open( output_name, index_string.c_str(), params );
+        file_handler->open( output_name, index_string.c_str(), params, compression_threads, compression_memory );
         if (file_handler->is_ok() == false)
         {
             log_error(stderr,"  unable to open output file \"%s\"\n", output_name);
@@ -806,6 +1093,48 @@ SetBWTHandler* open_bwt_file(const char* output_name, const char* params)
         file_handler->write_header();
         return file_handler;
     }
+    else if (format == BWT4LZ4)
+    {
+        // build an output handler
+        FileBWTHandler<BWTLZ4Writer,4,true,uint32>* file_handler = new FileBWTHandler<BWTLZ4Writer,4,true,uint32>();
+
+        file_handler->open( output_name, index_string.c_str(), params, compression_threads, compression_memory );
+        if (file_handler->is_ok() == false)
+        {
+            log_error(stderr,"  unable to open output file \"%s\"\n", output_name);
+            return NULL;
+        }
+        file_handler->write_header();
+        return file_handler;
+    }
+    else if (format == RLBWT)
+    {
+        // build an output handler
+        RLFileBWTHandler<RawBWTWriter>* file_handler = new RLFileBWTHandler<RawBWTWriter>();
+
+        file_handler->open( output_name, index_string.c_str() );
+        if (file_handler->is_ok() == false)
+        {
+            log_error(stderr,"  unable to open output file \"%s\"\n", output_name);
+            return NULL;
+        }
+        file_handler->write_header();
+        return file_handler;
+    }
+    else if (format == RLBWTGZ)
+    {
+        // build an output handler
+        RLFileBWTHandler<BWTGZWriter>* file_handler = new RLFileBWTHandler<BWTGZWriter>();
+
+        file_handler->open( output_name, index_string.c_str(), params );
+        if (file_handler->is_ok() == false)
+        {
+            log_error(stderr,"  unable to open output file \"%s\"\n", output_name);
+            return NULL;
+        }
+        file_handler->write_header();
+        return file_handler;
+    }
     else if (format == TXT)
     {
         // build an output handler
@@ -839,7 +1168,21 @@ SetBWTHandler* open_bwt_file(const char* output_name, const char* params)
         // build an output handler
         ASCIIFileBWTHandler<BWTBGZWriter>* file_handler = new ASCIIFileBWTHandler<BWTBGZWriter>();
 
-        file_handler->open( output_name, index_string.c_str(), params );
+        file_handler->open( output_name, index_string.c_str(), params, compression_threads, compression_memory );
+        if (file_handler->is_ok() == false)
+        {
+            log_error(stderr,"  unable to open output file \"%s\"\n", output_name);
+            return NULL;
+        }
+        file_handler->write_header();
+        return file_handler;
+    }
+    else if (format == TXTLZ4)
+    {
+        // build an output handler
+        ASCIIFileBWTHandler<BWTLZ4Writer>* file_handler = new ASCIIFileBWTHandler<BWTLZ4Writer>();
+
+        file_handler->open( output_name, index_string.c_str(), params, compression_threads, compression_memory );
         if (file_handler->is_ok() == false)
         {
             log_error(stderr,"  unable to open output file \"%s\"\n", output_name);
@@ -28,6 +28,8 @@
 #pragma once
 
 #include <nvbio/sufsort/sufsort_utils.h>
+#include <nvbio/fmindex/rl_rank_dictionary.h>
+#include <vector>
 
 namespace nvbio {
 
@@ -44,14 +46,28 @@ namespace nvbio {
 /// <tr><td style="white-space: nowrap; vertical-align:text-top;">.txt</td><td style="vertical-align:text-top;">      ASCII</td></tr>
 /// <tr><td style="white-space: nowrap; vertical-align:text-top;">.txt.gz</td><td style="vertical-align:text-top;">   ASCII, gzip compressed</td></tr>
 /// <tr><td style="white-space: nowrap; vertical-align:text-top;">.txt.bgz</td><td style="vertical-align:text-top;">  ASCII, block-gzip compressed</td></tr>
+/// <tr><td style="white-space: nowrap; vertical-align:text-top;">.txt.lz4</td><td style="vertical-align:text-top;">   ASCII, LZ4 compressed</td></tr>
 /// <tr><td style="white-space: nowrap; vertical-align:text-top;">.bwt</td><td style="vertical-align:text-top;">      2-bit packed binary</td></tr>
 /// <tr><td style="white-space: nowrap; vertical-align:text-top;">.bwt.gz</td><td style="vertical-align:text-top;">   2-bit packed binary, gzip compressed</td></tr>
 /// <tr><td style="white-space: nowrap; vertical-align:text-top;">.bwt.bgz</td><td style="vertical-align:text-top;">  2-bit packed binary, block-gzip compressed</td></tr>
+/// <tr><td style="white-space: nowrap; vertical-align:text-top;">.bwt.lz4</td><td style="vertical-align:text-top;">  2-bit packed binary, LZ4 compressed</td></tr>
 /// <tr><td style="white-space: nowrap; vertical-align:text-top;">.bwt4</td><td style="vertical-align:text-top;">     4-bit packed binary</td></tr>
 /// <tr><td style="white-space: nowrap; vertical-align:text-top;">.bwt4.gz</td><td style="vertical-align:text-top;">  4-bit packed binary, gzip compressed</td></tr>
 /// <tr><td style="white-space: nowrap; vertical-align:text-top;">.bwt4.bgz</td><td style="vertical-align:text-top;"> 4-bit packed binary, block-gzip compressed</td></tr>
+/// <tr><td style="white-space: nowrap; vertical-align:text-top;">.bwt4.lz4</td><td style="vertical-align:text-top;"> 4-bit packed binary, LZ4 compressed</td></tr>
+/// <tr><td style="white-space: nowrap; vertical-align:text-top;">.rlbwt</td><td style="vertical-align:text-top;">     run-length encoded binary</td></tr>
+/// <tr><td style="white-space: nowrap; vertical-align:text-top;">.rlbwt.gz</td><td style="vertical-align:text-top;">  run-length encoded binary, gzip compressed</td></tr>
 /// </table>
 ///
+/// The run-length encoded file has the form:
+///\verbatim
+///char[4] header = "RLBW";
+///varint  runs[r];
+///\endverbatim
+/// where each run is a LEB128 variable-length integer encoding the value ((length - 1) << 4) | symbol.
+/// Such files can be loaded back with load_rlbwt_file(), obtaining a run-length rank dictionary
+/// whose size is proportional to the number of runs rather than to the length of the text.
+///
 /// Alongside with the main BWT file, a file containing the mapping between the primary
 /// dollar tokens and their position in the BWT will be generated. This (.pri|.pri.gz|.pri.bgz)
 /// file is a plain list of (position,string-id) pairs, either in ASCII or binary form.
@@ -69,11 +85,56 @@ namespace nvbio {
 ///struct { uint64 position; uint32 string_id; } pairs[n];
 ///\endverbatim
 ///
-/// \param output_name      output name
-/// \param params           additional compression parameters (e.g. "1R", "9", etc)
+/// Block-compressed outputs (.bgz|.lz4) compress independent blocks concurrently on a pool of
+/// threads, writing them out in order: the number of threads and the amount of memory used
+/// to stage the blocks can be controlled by the optional parameters.
+///
+/// \param output_name          output name
+/// \param params               additional compression parameters (e.g. "1R", "9", etc)
+/// \param compression_threads  number of compression threads for block-compressed outputs (0 = all available cores)
+/// \param compression_memory   maximum amount of memory used to stage blocks for compression, in bytes
 /// \return     a handler that can be used by the string-set BWT construction functions
 ///
-SetBWTHandler* open_bwt_file(const char* output_name, const char* params);
+SetBWTHandler* open_bwt_file(
+    const char*     output_name,
+    const char*     params,
+    const uint32    compression_threads = 0,
+    const uint64    compression_memory  = 256u*1024u*1024u);
+
+/// read a run-length encoded BWT file (.rlbwt|.rlbwt.gz), returning the list of its runs
+/// as (symbol,length) pairs
+///
+/// \param input_name       input name
+/// \param heads            output run heads
+/// \param lengths          output run lengths
+/// \return     true on success
+///
+bool read_rlbwt_file(const char* input_name, std::vector<uint8>& heads, std::vector<uint64>& lengths);
+
+/// load a run-length encoded BWT file (.rlbwt|.rlbwt.gz) into a run-length rank dictionary,
+/// which can be used as the rank dictionary of an fm_index
+///
+/// \param input_name       input name
+/// \param dict             output dictionary
+/// \return     true on success
+///
+template <uint32 SYMBOL_SIZE, typename IndexType>
+bool load_rlbwt_file(const char* input_name, RLRankDictionaryStorage<host_tag,SYMBOL_SIZE,IndexType>& dict)
+{
+    std::vector<uint8>  heads;
+    std::vector<uint64> lengths;
+
+    if (read_rlbwt_file( input_name, heads, lengths ) == false)
+        return false;
+
+    setup_rl_rank_dictionary(
+        uint64( heads.size() ),
+        heads.begin(),
+        lengths.begin(),
+        dict );
+
+    return true;
+}
 
 ///@}
 
@@ -28,9 +28,6 @@
 #include <nvbio/sufsort/file_bwt_bgz.h>
 #include <nvbio/basic/exceptions.h>
 #include <zlib/zlib.h>
-#ifdef _OPENMP
-#include <omp.h>
-#endif
 
 namespace nvbio {
 
@@ -66,12 +63,11 @@ static const int one = 1;
 static const uint32 BLOCK_SIZE             = 256*1024;      // the compression unit, in bytes
 static const unsigned int BGZS_MAGICNUMBER = 0x0F1F2F3F;    // just a magic number
 static const unsigned int BGZS_EOS         = 0;             // a stream terminator
-static const uint32 NUM_BLOCKS             = 128;           // the highest, the better for load balancing
 
 // constructor
 //
 BGZFileWriter::BGZFileWriter(FILE* _file) :
-    m_file(NULL), m_buffer(NUM_BLOCKS*BLOCK_SIZE), m_buffer_size(0), m_comp_buffer(NUM_BLOCKS*BLOCK_SIZE)
+    m_file(NULL), m_buffer(BLOCK_SIZE), m_buffer_size(0)
 {
     if (_file != NULL)
         open( _file, Z_DEFAULT_COMPRESSION, Z_DEFAULT_STRATEGY );
@@ -83,14 +79,14 @@ BGZFileWriter::~BGZFileWriter() { close(); }
 
 // open a session
 //
-void BGZFileWriter::open(FILE* _file, const int level, const int strategy)
+void BGZFileWriter::open(FILE* _file, const int level, const int strategy, const uint32 n_threads, const uint64 max_memory)
 {
     m_file = _file;
 
     const uint32 blockSizeId = nvbio::log2( BLOCK_SIZE );
 
     // write the archive header
-    char out_buff[7];
+    char out_buff[8] = { 0 };
     *(unsigned int*)out_buff = LITTLE_ENDIAN_32(BGZS_MAGICNUMBER);   // Magic Number, in Little Endian convention
     *(out_buff+4)  = 1;                                              // Version('01')
     *(out_buff+5)  = (char)blockSizeId;
@@ -98,46 +94,57 @@ void BGZFileWriter::open(FILE* _file, const int level, const int strategy)
 
     m_level    = level;
     m_strategy = strategy;
+
+    // spawn the compression threads
+    m_block_writer.open( m_file, this, BLOCK_SIZE, n_threads, max_memory );
 }
 
 // close a session
 //
-void BGZFileWriter::close()
+bool BGZFileWriter::close()
 {
     if (m_file == NULL)
-        return;
+        return true;
+
+    bool ok = true;
 
     // encode any remaining bytes
     if (m_buffer_size)
     {
-        encode_block( m_buffer_size, &m_buffer[0] );
+        ok = m_block_writer.write( m_buffer_size, &m_buffer[0] );
         m_buffer_size = 0;
     }
 
+    // wait for all blocks to be written out
+    if (m_block_writer.close() == false)
+        ok = false;
+
     // write the BGZ End-Of-Stream marker
     const unsigned int eos = BGZS_EOS;
-    fwrite( &eos, 1, 4, m_file );
+    if (fwrite( &eos, 1, 4, m_file ) != 4)
+        ok = false;
 
     // invalidate the file pointer
     m_file = NULL;
+    return ok;
 }
 
 // write a block to the output
 //
-void BGZFileWriter::write(uint32 n_bytes, const void* _src)
+uint32 BGZFileWriter::write(uint32 n_bytes, const void* _src)
 {
+    const uint32 n_requested = n_bytes;
+
     // convert input to a uint8 pointer
     const uint8* src = (const uint8*)_src;
 
-    const uint32 NB = NUM_BLOCKS;//(uint32)omp_get_num_procs();
-
     if (m_buffer_size)
     {
         //
         // we have some pending bytes in the buffer, let's add as much as we can and
         // eventually output a block if full
         //
-        const uint32 n_needed = nvbio::min( NB*BLOCK_SIZE - m_buffer_size, n_bytes );
+        const uint32 n_needed = nvbio::min( BLOCK_SIZE - m_buffer_size, n_bytes );
 
         // copy the given block from the source
         memcpy( &m_buffer[0] + m_buffer_size, src, n_needed );
@@ -146,10 +153,11 @@ void BGZFileWriter::write(uint32 n_bytes, const void* _src)
         src           += n_needed;
         n_bytes       -= n_needed;
 
-        if (m_buffer_size == NB*BLOCK_SIZE)
+        if (m_buffer_size == BLOCK_SIZE)
         {
-            encode_block( m_buffer_size, &m_buffer[0] );
             m_buffer_size = 0;
+            if (m_block_writer.write( BLOCK_SIZE, &m_buffer[0] ) == false)
+                return 0u;
         }
     }
 
@@ -158,14 +166,15 @@ void BGZFileWriter::write(uint32 n_bytes, const void* _src)
     // we have terminated the source (i.e. n_bytes = 0)
     //
 
-    for (uint32 block_begin = 0; block_begin < n_bytes; block_begin += NB*BLOCK_SIZE)
+    for (uint32 block_begin = 0; block_begin < n_bytes; block_begin += BLOCK_SIZE)
     {
-        const uint32 block_end = nvbio::min( block_begin + NB*BLOCK_SIZE, n_bytes );
+        const uint32 block_end = nvbio::min( block_begin + BLOCK_SIZE, n_bytes );
 
-        if (block_end - block_begin == NB*BLOCK_SIZE)
+        if (block_end - block_begin == BLOCK_SIZE)
         {
-            // encode directly without buffering
-            encode_block( NB*BLOCK_SIZE, src + block_begin );
+            // queue the block directly without buffering
+            if (m_block_writer.write( BLOCK_SIZE, src + block_begin ) == false)
+                return 0u;
         }
         else
         {
@@ -174,43 +183,12 @@ void BGZFileWriter::write(uint32 n_bytes, const void* _src)
             m_buffer_size += block_end - block_begin;
         }
     }
-}
-
-// encode a given block and write it to the output
-//
-void BGZFileWriter::encode_block(uint32 n_bytes, const uint8* src)
-{
-    uint32 block_sizes[NUM_BLOCKS];
-
-    #pragma omp parallel for
-    for (int block = 0; block < int( n_bytes ); block += BLOCK_SIZE)
-    {
-        const uint32 block_size = nvbio::min( BLOCK_SIZE, uint32( n_bytes - block ) );
-        block_sizes[ block/BLOCK_SIZE ] = compress( src + block, &m_comp_buffer[0] + block, block_size );
-    }
-
-    for (int block = 0; block < int( n_bytes ); block += BLOCK_SIZE)
-    {
-        const uint32 block_size = nvbio::min( BLOCK_SIZE, uint32( n_bytes - block ) );
-        const uint32 n_compressed = block_sizes[ block/BLOCK_SIZE ];
-        if (n_compressed)
-        {
-            const uint32 block_header = LITTLE_ENDIAN_32( n_compressed );
-            fwrite( &block_header, sizeof(uint32), 1u, m_file );
-            fwrite( &m_comp_buffer[0] + block, sizeof(uint8), n_compressed, m_file );
-        }
-        else
-        {
-            const uint32 block_header = LITTLE_ENDIAN_32( block_size | 0x80000000);   // Add Uncompressed flag
-            fwrite( &block_header, sizeof(uint32), 1u, m_file );
-            fwrite( src + block, sizeof(uint8), block_size, m_file );
-        }
-    }
+    return n_requested;
 }
 
 // compress a given block
 //
-uint32 BGZFileWriter::compress(const uint8* src, uint8* dst, const uint32 n_bytes)
+uint32 BGZFileWriter::compress(const uint8* src, uint8* dst, const uint32 n_bytes) const
 {
     // initialize the gzip header
     // note that we don't actually care about most of these fields
@@ -274,8 +252,11 @@ BWTBGZWriter::BWTBGZWriter() :
 //
 BWTBGZWriter::~BWTBGZWriter()
 {
-    output_file_writer.close();
-    index_file_writer.close();
+    // the last blocks are only written out here, so this is the last chance to report failures
+    if (output_file_writer.close() == false)
+        log_error(stderr,"  writing bwt file failed\n");
+    if (index_file_writer.close() == false)
+        log_error(stderr,"  writing index file failed\n");
 
     fclose( output_file );
     fclose( index_file );
@@ -283,7 +264,7 @@ BWTBGZWriter::~BWTBGZWriter()
 
 // open
 //
-void BWTBGZWriter::open(const char* output_name, const char* index_name, const char* compression)
+void BWTBGZWriter::open(const char* output_name, const char* index_name, const char* compression, const uint32 n_threads, const uint64 max_memory)
 {
     log_verbose(stderr,"  opening bwt file \"%s\" (compression level: %s)\n", output_name, compression);
     log_verbose(stderr,"  opening index file \"%s\" (compression level: %s)\n", index_name, compression);
@@ -320,24 +301,23 @@ void BWTBGZWriter::open(const char* output_name, const char* index_name, const c
         }
     }
 
-    output_file_writer.open( output_file, level, strategy );
-    index_file_writer.open( index_file, level, strategy );
+    // the index is tiny compared to the BWT, a single compression thread suffices
+    output_file_writer.open( output_file, level, strategy, n_threads, max_memory );
+    index_file_writer.open( index_file, level, strategy, 1u, 4u*BLOCK_SIZE );
 }
 
 // write to the bwt
 //
 uint32 BWTBGZWriter::bwt_write(const uint32 n_bytes, const void* buffer)
 {
-    output_file_writer.write( n_bytes, buffer );
-    return n_bytes;
+    return output_file_writer.write( n_bytes, buffer );
 }
 
 // write to the index
 //
 uint32 BWTBGZWriter::index_write(const uint32 n_bytes, const void* buffer)
 {
-    index_file_writer.write( n_bytes, buffer );
-    return n_bytes;
+    return index_file_writer.write( n_bytes, buffer );
 }
 
 // return whether the file is in a good state
@@ -0,0 +1,311 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <nvbio/sufsort/file_bwt_block_writer.h>
+#include <nvbio/basic/console.h>
+#include <nvbio/basic/exceptions.h>
+#include <nvbio/basic/numbers.h>
+#include <string.h>
+
+namespace nvbio {
+
+//**************************************
+// Compiler-specific functions
+//**************************************
+#if defined(__GNUC__)
+#define GCC_VERSION (__GNUC__ * 100 + __GNUC_MINOR__)
+#endif
+
+#if defined(_MSC_VER)    // Visual Studio
+#  define swap32 _byteswap_ulong
+#elif GCC_VERSION >= 403
+#  define swap32 __builtin_bswap32
+#else
+  static inline unsigned int swap32(unsigned int x)
+  {
+    return ((x << 24) & 0xff000000 ) |
+           ((x <<  8) & 0x00ff0000 ) |
+           ((x >>  8) & 0x0000ff00 ) |
+           ((x >> 24) & 0x000000ff );
+  }
+#endif
+
+//**************************************
+// Architecture Macros
+//**************************************
+static const int one = 1;
+#define CPU_LITTLE_ENDIAN   (*(char*)(&one))
+#define CPU_BIG_ENDIAN      (!CPU_LITTLE_ENDIAN)
+#define LITTLE_ENDIAN_32(i) (CPU_LITTLE_ENDIAN?(i):swap32(i))
+
+// constructor
+//
+ParallelBlockWriter::ParallelBlockWriter() :
+    m_file( NULL ),
+    m_compressor( NULL ),
+    m_head( 0 ),
+    m_tail( 0 ),
+    m_block_size( 0 ),
+    m_synchronous( false ),
+    m_stop( false ),
+    m_error( false )
+{}
+
+// destructor
+//
+ParallelBlockWriter::~ParallelBlockWriter() { close(); }
+
+// open a session, spawning the compression threads
+//
+void ParallelBlockWriter::open(
+    FILE*                   file,
+    const BlockCompressor*  compressor,
+    const uint32            block_size,
+    const uint32            n_threads,
+    const uint64            max_memory)
+{
+    m_file       = file;
+    m_compressor = compressor;
+    m_head       = 0;
+    m_tail        = 0;
+    m_block_size  = block_size;
+    m_synchronous = threads_enabled() == false;
+    m_stop        = false;
+    m_error       = false;
+
+    // without threads, blocks are compressed in place by write() using a single slot
+    const uint32 n_compression_threads = m_synchronous ? 0u :
+        n_threads ? n_threads : nvbio::max( num_logical_cores(), 1u );
+
+    // each slot needs an input and an output buffer; keep at least one slot per thread
+    // plus one being filled, regardless of the memory budget
+    const uint32 n_slots = m_synchronous ? 1u : nvbio::max(
+        uint32( nvbio::min( max_memory / (2u * uint64( block_size )), uint64( 4096u ) ) ),
+        n_compression_threads + 1u );
+
+    m_slots.resize( n_slots );
+    for (uint32 i = 0; i < n_slots; ++i)
+    {
+        m_slots[i].in.resize( block_size );
+        m_slots[i].out.resize( block_size );
+        m_slots[i].state = FREE;
+    }
+
+    log_debug(stderr,"  block writer: %u threads, %u slots (%.1f MB)\n",
+        n_compression_threads, n_slots, float( 2u * uint64( block_size ) * n_slots ) / float(1024*1024));
+
+    if (m_synchronous)
+        return;
+
+    // spawn the threads - note that the threads vector must not be resized after this point
+    m_threads.resize( n_compression_threads );
+    for (uint32 i = 0; i < n_compression_threads; ++i)
+    {
+        m_threads[i].writer = this;
+        m_threads[i].set_id( i );
+        m_threads[i].create();
+    }
+
+    m_output_thread.writer = this;
+    m_output_thread.create();
+}
+
+// close a session, waiting for all pending blocks to be written out
+//
+bool ParallelBlockWriter::close()
+{
+    if (m_file == NULL)
+        return true;
+
+    if (m_synchronous == false)
+    {
+        // signal termination
+        {
+            ScopedLock lock( &m_mutex );
+            m_stop = true;
+            m_cond.broadcast();
+        }
+
+        // wait for all threads to drain the queues
+        for (uint32 i = 0; i < m_threads.size(); ++i)
+            m_threads[i].join();
+
+        m_output_thread.join();
+    }
+
+    m_threads.clear();
+    m_slots.clear();
+    m_file = NULL;
+
+    return m_error == false;
+}
+
+// queue a block for compression
+//
+bool ParallelBlockWriter::write(const uint32 n_bytes, const void* src)
+{
+    if (n_bytes > m_block_size)
+        throw nvbio::runtime_error("ParallelBlockWriter::write() : block too large! (%u > %u bytes)", n_bytes, m_block_size);
+
+    if (n_bytes == 0)
+        return failed() == false;
+
+    if (m_synchronous)
+    {
+        // compress and write the block out right away
+        Slot& slot = m_slots[0];
+
+        const uint32 out_size = m_compressor->compress( (const uint8*)src, &slot.out[0], n_bytes );
+        if (write_block( (const uint8*)src, n_bytes, &slot.out[0], out_size ) == false)
+            m_error = true;
+
+        return m_error == false;
+    }
+
+    const uint32 slot_idx = uint32( m_head % m_slots.size() );
+    Slot& slot = m_slots[ slot_idx ];
+
+    // wait for the slot to be released by the output thread
+    {
+        ScopedLock lock( &m_mutex );
+        while (slot.state != FREE)
+            m_cond.wait( &m_mutex );
+
+        // report any failure of the previous blocks, which are written out asynchronously
+        if (m_error)
+            return false;
+    }
+
+    // FREE slots are only ever touched by the producer, so we can fill it outside the lock
+    memcpy( &slot.in[0], src, n_bytes );
+    slot.in_size = n_bytes;
+
+    // and hand it over to the compression threads
+    {
+        ScopedLock lock( &m_mutex );
+        slot.state = READY;
+        m_work.push( slot_idx );
+        ++m_head;
+        m_cond.broadcast();
+    }
+    return true;
+}
+
+// check whether any block failed to be written out; in asynchronous mode the
+// flag is raised by the output thread, so it must be read under the lock
+//
+bool ParallelBlockWriter::failed()
+{
+    if (m_synchronous)
+        return m_error;
+
+    ScopedLock lock( &m_mutex );
+    return m_error;
+}
+
+// the loop run by the compression threads
+//
+void ParallelBlockWriter::compression_loop()
+{
+    m_mutex.lock();
+    while (1)
+    {
+        while (m_work.empty() && m_stop == false)
+            m_cond.wait( &m_mutex );
+
+        if (m_work.empty())
+            break; // stopped and drained
+
+        const uint32 slot_idx = m_work.front();
+        m_work.pop();
+
+        Slot& slot = m_slots[ slot_idx ];
+        slot.state = BUSY;
+        m_mutex.unlock();
+
+        // compress the block
+        slot.out_size = m_compressor->compress( &slot.in[0], &slot.out[0], slot.in_size );
+
+        m_mutex.lock();
+        slot.state = DONE;
+        m_cond.broadcast();
+    }
+    m_mutex.unlock();
+}
+
+// the loop run by the output thread
+//
+void ParallelBlockWriter::output_loop()
+{
+    m_mutex.lock();
+    while (1)
+    {
+        Slot& slot = m_slots[ m_tail % m_slots.size() ];
+
+        // wait for the oldest block to be compressed
+        while (slot.state != DONE && (m_stop == false || m_tail < m_head))
+            m_cond.wait( &m_mutex );
+
+        if (slot.state != DONE)
+            break; // stopped and drained
+
+        m_mutex.unlock();
+
+        // write the block out
+        const bool written = write_block( &slot.in[0], slot.in_size, &slot.out[0], slot.out_size );
+
+        m_mutex.lock();
+        if (written == false)
+            m_error = true;
+
+        slot.state = FREE;
+        ++m_tail;
+        m_cond.broadcast();
+    }
+    m_mutex.unlock();
+}
+
+// write a compressed block out, or the raw one if out_size is 0
+//
+bool ParallelBlockWriter::write_block(const uint8* in, const uint32 in_size, const uint8* out, const uint32 out_size)
+{
+    if (out_size)
+    {
+        const uint32 block_header = LITTLE_ENDIAN_32( out_size );
+        return fwrite( &block_header, sizeof(uint32), 1u, m_file ) == 1u &&
+               fwrite( out, sizeof(uint8), out_size, m_file ) == out_size;
+    }
+    else
+    {
+        const uint32 block_header = LITTLE_ENDIAN_32( in_size | UNCOMPRESSED_FLAG );
+        return fwrite( &block_header, sizeof(uint32), 1u, m_file ) == 1u &&
+               fwrite( in, sizeof(uint8), in_size, m_file ) == in_size;
+    }
+}
+
+} // namespace nvbio
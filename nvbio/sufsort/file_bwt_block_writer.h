@@ -0,0 +1,175 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/threads.h>
+#include <vector>
+#include <queue>
+#include <stdio.h>
+
+namespace nvbio {
+
+/// A block compressor interface, used by ParallelBlockWriter to compress independent blocks
+/// concurrently: implementations must hence be thread-safe.
+///
+struct BlockCompressor
+{
+    /// virtual destructor
+    ///
+    virtual ~BlockCompressor() {}
+
+    /// compress a block into a destination buffer of the same size
+    ///
+    /// \return     the size of the compressed block, or 0 if the block could not be compressed
+    ///             in less than n_bytes
+    ///
+    virtual uint32 compress(const uint8* src, uint8* dst, const uint32 n_bytes) const = 0;
+};
+
+/// A class compressing a sequence of independent blocks on a pool of threads and writing them
+/// out in their original order, each prefixed by a 32-bit little-endian header holding either
+/// its compressed size, or its raw size with the top bit set if the block was left uncompressed.
+///\par
+/// Blocks are staged in a ring of slots whose total size is bounded by a configurable memory
+/// budget: when all slots are in use, write() blocks until the oldest one has been written out.
+/// In builds without threads (see threads_enabled()) blocks are compressed and written out
+/// synchronously within write().
+///
+struct ParallelBlockWriter
+{
+    static const uint32 UNCOMPRESSED_FLAG = 0x80000000u;
+
+    /// constructor
+    ///
+    ParallelBlockWriter();
+
+    /// destructor
+    ///
+    ~ParallelBlockWriter();
+
+    /// open a session, spawning the compression threads
+    ///
+    /// \param file             the output file
+    /// \param compressor       the block compressor
+    /// \param block_size       the maximum block size, in bytes
+    /// \param n_threads        the number of compression threads (0 = all available cores)
+    /// \param max_memory       the maximum amount of memory used for staging blocks, in bytes
+    ///
+    void open(
+        FILE*                   file,
+        const BlockCompressor*  compressor,
+        const uint32            block_size,
+        const uint32            n_threads,
+        const uint64            max_memory);
+
+    /// close a session, waiting for all pending blocks to be written out
+    ///
+    /// \return                 false if any block failed to be written out
+    ///
+    bool close();
+
+    /// queue a block for compression - the data is copied, so that the source buffer can
+    /// be reused as soon as this method returns
+    ///
+    /// \param n_bytes          the block size, which must not exceed the session's block size
+    /// \param src              the block data
+    /// \return                 false if this or any previous block failed to be written out
+    ///
+    bool write(const uint32 n_bytes, const void* src);
+
+    /// return the number of compression threads
+    ///
+    uint32 n_threads() const { return uint32( m_threads.size() ); }
+
+private:
+    enum SlotState { FREE = 0, READY = 1, BUSY = 2, DONE = 3 };
+
+    struct Slot
+    {
+        Slot() : in_size(0), out_size(0), state(FREE) {}
+
+        std::vector<uint8>  in;
+        std::vector<uint8>  out;
+        uint32              in_size;
+        uint32              out_size;
+        uint32              state;
+    };
+
+    struct CompressionThread : public Thread<CompressionThread>
+    {
+        CompressionThread() : writer(NULL) {}
+
+        void run() { writer->compression_loop(); }
+
+        ParallelBlockWriter* writer;
+    };
+
+    struct OutputThread : public Thread<OutputThread>
+    {
+        OutputThread() : writer(NULL) {}
+
+        void run() { writer->output_loop(); }
+
+        ParallelBlockWriter* writer;
+    };
+
+    /// check whether any block failed to be written out
+    ///
+    bool failed();
+
+    /// the loop run by the compression threads
+    ///
+    void compression_loop();
+
+    /// the loop run by the output thread
+    ///
+    void output_loop();
+
+    /// write a compressed block out, or the raw one if out_size is 0
+    ///
+    bool write_block(const uint8* in, const uint32 in_size, const uint8* out, const uint32 out_size);
+
+    FILE*                           m_file;
+    const BlockCompressor*          m_compressor;
+    std::vector<Slot>               m_slots;
+    std::queue<uint32>              m_work;
+    uint64                          m_head;
+    uint64                          m_tail;
+    uint32                          m_block_size;
+    bool                            m_synchronous;
+    bool                            m_stop;
+    bool                            m_error;
+    Mutex                           m_mutex;
+    Condition                       m_cond;
+    std::vector<CompressionThread>  m_threads;
+    OutputThread                    m_output_thread;
+};
+
+} // namespace nvbio
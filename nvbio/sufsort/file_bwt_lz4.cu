@@ -71,7 +71,7 @@ static const unsigned int LZ4S_EOS         = 0;
 // constructor
 //
 LZ4FileWriter::LZ4FileWriter(FILE* _file) :
-    m_file(NULL), m_buffer(BLOCK_SIZE), m_buffer_size(0), m_comp_buffer(BLOCK_SIZE)
+    m_file(NULL), m_buffer(BLOCK_SIZE), m_buffer_size(0)
 {
     if (_file != NULL)
         open( _file );
@@ -83,7 +83,7 @@ LZ4FileWriter::~LZ4FileWriter() { close(); }
 
 // open a session
 //
-void LZ4FileWriter::open(FILE* _file)
+void LZ4FileWriter::open(FILE* _file, const uint32 n_threads, const uint64 max_memory)
 {
     m_file = _file;
 
@@ -106,34 +106,47 @@ void LZ4FileWriter::open(FILE* _file)
     //checkbits = LZ4S_GetCheckBits_FromXXH(checkbits);
     *(out_buff+6)  = (unsigned char)checkbits;
     fwrite( out_buff, 1, 7, m_file );
+
+    // spawn the compression threads
+    m_block_writer.open( m_file, this, BLOCK_SIZE, n_threads, max_memory );
 }
 
 // close a session
 //
-void LZ4FileWriter::close()
+bool LZ4FileWriter::close()
 {
     if (m_file == NULL)
-        return;
+        return true;
+
+    bool ok = true;
 
     // encode any remaining bytes
     if (m_buffer_size)
     {
-        encode_block( m_buffer_size, &m_buffer[0] );
+        ok = m_block_writer.write( m_buffer_size, &m_buffer[0] );
         m_buffer_size = 0;
     }
 
+    // wait for all blocks to be written out
+    if (m_block_writer.close() == false)
+        ok = false;
+
     // write the LZ4 End-Of-Stream marker
     const unsigned int eos = LZ4S_EOS;
-    fwrite( &eos, 1, 4, m_file );
+    if (fwrite( &eos, 1, 4, m_file ) != 4)
+        ok = false;
 
     // invalidate the file pointer
     m_file = NULL;
+    return ok;
 }
 
 // write a block to the output
 //
-void LZ4FileWriter::write(uint32 n_bytes, const void* _src)
+uint32 LZ4FileWriter::write(uint32 n_bytes, const void* _src)
 {
+    const uint32 n_requested = n_bytes;
+
     // convert input to a uint8 pointer
     const uint8* src = (const uint8*)_src;
 
@@ -154,8 +167,9 @@ void LZ4FileWriter::write(uint32 n_bytes, const void* _src)
 
         if (m_buffer_size == BLOCK_SIZE)
         {
-            encode_block( m_buffer_size, &m_buffer[0] );
             m_buffer_size = 0;
+            if (m_block_writer.write( BLOCK_SIZE, &m_buffer[0] ) == false)
+                return 0u;
         }
     }
 
@@ -170,8 +184,9 @@ void LZ4FileWriter::write(uint32 n_bytes, const void* _src)
 
         if (block_end - block_begin == BLOCK_SIZE)
         {
-            // encode directly without buffering
-            encode_block( BLOCK_SIZE, src + block_begin );
+            // queue the block directly without buffering
+            if (m_block_writer.write( BLOCK_SIZE, src + block_begin ) == false)
+                return 0u;
         }
         else
         {
@@ -180,29 +195,16 @@ void LZ4FileWriter::write(uint32 n_bytes, const void* _src)
             m_buffer_size += block_end - block_begin;
         }
     }
+    return n_requested;
 }
 
-// encode a given block and write it to the output
+// compress a given block
 //
-void LZ4FileWriter::encode_block(uint32 n_bytes, const uint8* src)
+uint32 LZ4FileWriter::compress(const uint8* src, uint8* dst, const uint32 n_bytes) const
 {
-    const uint32 n_compressed = (uint32)LZ4_compressHC_limitedOutput( (const char*)src, (char*)&m_comp_buffer[0], n_bytes, n_bytes-1 );
-
-    if (n_compressed)
-    {
-        const uint32 block_header = LITTLE_ENDIAN_32( n_compressed );
-        fwrite( &block_header, sizeof(uint32), 1u, m_file );
-        fwrite( &m_comp_buffer[0], sizeof(uint8), n_compressed, m_file );
-    }
-    else
-    {
-        const uint32 block_header = LITTLE_ENDIAN_32( n_bytes | 0x80000000);   // Add Uncompressed flag
-        fwrite( &block_header, sizeof(uint32), 1u, m_file );
-        fwrite( src, sizeof(uint8), n_bytes, m_file );
-    }
+    return (uint32)LZ4_compressHC_limitedOutput( (const char*)src, (char*)dst, n_bytes, n_bytes-1 );
 }
 
-
 // constructor
 //
 BWTLZ4Writer::BWTLZ4Writer() :
@@ -214,8 +216,11 @@ BWTLZ4Writer::BWTLZ4Writer() :
 //
 BWTLZ4Writer::~BWTLZ4Writer()
 {
-    output_file_writer.close();
-    index_file_writer.close();
+    // the last blocks are only written out here, so this is the last chance to report failures
+    if (output_file_writer.close() == false)
+        log_error(stderr,"  writing bwt file failed\n");
+    if (index_file_writer.close() == false)
+        log_error(stderr,"  writing index file failed\n");
 
     fclose( output_file );
     fclose( index_file );
@@ -223,31 +228,30 @@ BWTLZ4Writer::~BWTLZ4Writer()
 
 // open
 //
-void BWTLZ4Writer::open(const char* output_name, const char* index_name, const char* compression)
+void BWTLZ4Writer::open(const char* output_name, const char* index_name, const char* compression, const uint32 n_threads, const uint64 max_memory)
 {
     log_verbose(stderr,"  opening bwt file \"%s\" (compression level: %s)\n", output_name, compression);
     log_verbose(stderr,"  opening index file \"%s\" (compression level: %s)\n", index_name, compression);
     output_file = fopen( output_name, "wb" );
     index_file  = fopen( index_name,  "wb" );
 
-    output_file_writer.open( output_file );
-    index_file_writer.open( index_file );
+    // the index is tiny compared to the BWT, a single compression thread suffices
+    output_file_writer.open( output_file, n_threads, max_memory );
+    index_file_writer.open( index_file, 1u, 4u*BLOCK_SIZE );
 }
 
 // write to the bwt
 //
 uint32 BWTLZ4Writer::bwt_write(const uint32 n_bytes, const void* buffer)
 {
-    output_file_writer.write( n_bytes, buffer );
-    return n_bytes;
+    return output_file_writer.write( n_bytes, buffer );
 }
 
 // write to the index
 //
 uint32 BWTLZ4Writer::index_write(const uint32 n_bytes, const void* buffer)
 {
-    index_file_writer.write( n_bytes, buffer );
-    return n_bytes;
+    return index_file_writer.write( n_bytes, buffer );
 }
 
 // return whether the file is in a good state
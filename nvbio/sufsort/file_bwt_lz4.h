@@ -28,10 +28,14 @@
 #pragma once
 
 #include <nvbio/sufsort/file_bwt.h>
+#include <nvbio/sufsort/file_bwt_block_writer.h>
 
 namespace nvbio {
 
-struct LZ4FileWriter
+/// A class to write a stream of bytes to an LZ4 compressed file, compressing
+/// the blocks concurrently on a pool of threads
+///
+struct LZ4FileWriter : public BlockCompressor
 {
     /// constructor
     ///
@@ -43,25 +47,33 @@ struct LZ4FileWriter
 
     /// open a session
     ///
-    void open(FILE* _file);
+    /// \param _file            the output file
+    /// \param n_threads        the number of compression threads (0 = all available cores)
+    /// \param max_memory       the maximum amount of memory used for staging blocks, in bytes
+    ///
+    void open(FILE* _file, const uint32 n_threads = 0, const uint64 max_memory = 256u*1024u*1024u);
 
     /// close a session
     ///
-    void close();
+    /// \return                 false if any block failed to be written out
+    ///
+    bool close();
 
     /// write a block to the output
     ///
-    void write(uint32 n_bytes, const void* _src);
+    /// \return                 n_bytes, or 0 if this or any previous block failed to be written out
+    ///
+    uint32 write(uint32 n_bytes, const void* _src);
 
-private:
-    /// encode a given block and write it to the output
+    /// compress a given block
     ///
-    void encode_block(uint32 n_bytes, const uint8* src);
+    uint32 compress(const uint8* src, uint8* dst, const uint32 n_bytes) const;
 
-    FILE*              m_file;
-    std::vector<uint8> m_buffer;
-    std::vector<uint8> m_comp_buffer;
-    uint32             m_buffer_size;
+private:
+    FILE*               m_file;
+    std::vector<uint8>  m_buffer;
+    uint32              m_buffer_size;
+    ParallelBlockWriter m_block_writer;
 };
 
 /// A class to output the BWT to an LZ4-compressed binary file
@@ -77,7 +89,14 @@ struct BWTLZ4Writer
     ~BWTLZ4Writer();
 
     /// open
-    void open(const char* output_name, const char* index_name, const char* compression);
+    ///
+    /// \param output_name      the output BWT file name
+    /// \param index_name       the output index file name
+    /// \param compression      the compression level (unused)
+    /// \param n_threads        the number of compression threads (0 = all available cores)
+    /// \param max_memory       the maximum amount of memory used for staging blocks, in bytes
+    ///
+    void open(const char* output_name, const char* index_name, const char* compression, const uint32 n_threads = 0, const uint64 max_memory = 256u*1024u*1024u);
 
     /// write to the bwt
     ///
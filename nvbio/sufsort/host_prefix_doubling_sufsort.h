@@ -0,0 +1,400 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <nvbio/strings/string_set.h>
+#include <nvbio/basic/exceptions.h>
+#include <nvbio/basic/timer.h>
+#include <nvbio/basic/omp.h>
+#include <vector>
+#include <algorithm>
+
+namespace nvbio {
+
+///
+/// A sorting enactor for sorting all suffixes of a host-side string set using a parallel
+/// host version of "Faster Suffix Sorting" by Larsson and Sadanake.
+///\par
+/// The suffixes are first radix-bucketed and sorted by a packed key encoding their first few
+/// symbols and the position of their terminator; the unsorted groups left are then refined
+/// by prefix-doubling, sorting all groups in parallel.
+/// As with cuda::suffix_sort(), each string is implicitly terminated by a dollar symbol smaller
+/// than all other symbols, and identical suffixes of different strings are sorted by string id.
+///
+struct HostPrefixDoublingSufSort
+{
+    static const uint32 KEY_BITS    = 64u;     ///< number of bits of the initial sorting keys
+    static const uint32 DOLLAR_BITS = 6u;      ///< number of bits encoding the dollar position
+    static const uint32 RADIX_BITS  = 16u;     ///< number of bits used for the initial bucketing
+
+    /// constructor
+    ///
+    HostPrefixDoublingSufSort() :
+        init_time(0.0f),
+        radixsort_time(0.0f),
+        doubling_time(0.0f),
+        n_passes(0u) {}
+
+    /// Sort all the suffixes of a given host-side string set, including the empty suffix
+    /// of each string.
+    ///
+    /// \tparam SYMBOL_SIZE         the number of bits per symbol
+    /// \tparam string_set_type     a host-side string set
+    ///
+    /// \param string_set           the input string set
+    ///
+    /// Upon return, suffixes contains the list of sorted global suffix indices,
+    /// string_ids the string id bound to each global suffix index, and cum_lengths the
+    /// inclusive cumulative sum of the string lengths (each extended by one).
+    ///
+    template <uint32 SYMBOL_SIZE, typename string_set_type>
+    void sort(const string_set_type& string_set);
+
+    /// return the number of sorted suffixes
+    ///
+    uint32 size() const { return uint32( suffixes.size() ); }
+
+    /// free all storage
+    ///
+    void clear()
+    {
+        std::vector<uint32>().swap( suffixes );
+        std::vector<uint32>().swap( string_ids );
+        std::vector<uint32>().swap( cum_lengths );
+        std::vector<uint32>().swap( m_ranks );
+    }
+
+    std::vector<uint32> suffixes;       ///< sorted global suffix indices
+    std::vector<uint32> string_ids;     ///< the string id of each global suffix
+    std::vector<uint32> cum_lengths;    ///< cumulative (extended) string lengths
+
+    float  init_time;                   ///< timing stats
+    float  radixsort_time;              ///< timing stats
+    float  doubling_time;               ///< timing stats
+    uint32 n_passes;                    ///< number of prefix-doubling passes
+
+private:
+    struct group_type
+    {
+        uint32 begin;
+        uint32 end;
+    };
+    struct key_type
+    {
+        uint64 key;
+        uint32 idx;
+    };
+    struct rank_type
+    {
+        uint32 key;
+        uint32 idx;
+    };
+    struct key_less
+    {
+        bool operator() (const key_type a, const key_type b) const
+        {
+            return a.key < b.key || (a.key == b.key && a.idx < b.idx);
+        }
+        bool operator() (const rank_type a, const rank_type b) const
+        {
+            return a.key < b.key || (a.key == b.key && a.idx < b.idx);
+        }
+    };
+
+    template <uint32 SYMBOL_SIZE, typename string_type>
+    static uint64 extract_key(const string_type string, const uint32 string_len, const uint32 suffix_idx);
+
+    std::vector<uint32> m_ranks;        ///< the inverse suffix array, i.e. the current suffix ranks
+};
+
+// extract the initial sorting key of a suffix, encoding its first symbols
+// and the position of its dollar in the least significant bits
+//
+template <uint32 SYMBOL_SIZE, typename string_type>
+uint64 HostPrefixDoublingSufSort::extract_key(const string_type string, const uint32 string_len, const uint32 suffix_idx)
+{
+    const uint32 SYMBOLS_PER_KEY = (KEY_BITS - DOLLAR_BITS) / SYMBOL_SIZE;
+    const uint32 SYMBOL_OFFSET   = KEY_BITS - SYMBOL_SIZE;
+
+    uint64 key = 0u;
+    for (uint32 j = 0; j < SYMBOLS_PER_KEY; ++j)
+    {
+        const uint32 jj = suffix_idx + j;
+        const uint64 c  = jj < string_len ? uint64( string[jj] ) : 0u;
+        key |= c << (SYMBOL_OFFSET - j*SYMBOL_SIZE);
+    }
+
+    // a suffix whose dollar falls within SYMBOLS_PER_KEY symbols is fully determined by its key
+    const uint32 dollar_offset = string_len - suffix_idx <= SYMBOLS_PER_KEY ?
+        string_len - suffix_idx :
+        (1u << DOLLAR_BITS) - 1u;
+
+    return key | dollar_offset;
+}
+
+// Sort all the suffixes of a given host-side string set
+//
+template <uint32 SYMBOL_SIZE, typename string_set_type>
+void HostPrefixDoublingSufSort::sort(const string_set_type& string_set)
+{
+    typedef typename string_set_type::string_type string_type;
+
+    const uint32 SYMBOLS_PER_KEY = (KEY_BITS - DOLLAR_BITS) / SYMBOL_SIZE;
+    const uint32 N_BUCKETS       = 1u << RADIX_BITS;
+
+    Timer timer;
+    timer.start();
+
+    const uint32 n_strings = uint32( string_set.size() );
+
+    // compute the cumulative sum of the extended string lengths
+    cum_lengths.resize( n_strings );
+
+    uint64 n = 0;
+    for (uint32 i = 0; i < n_strings; ++i)
+    {
+        n += string_set[i].length() + 1u;
+        cum_lengths[i] = uint32( n );
+
+        if (n >= uint64(1u) << 32)
+            throw nvbio::runtime_error("HostPrefixDoublingSufSort: too many suffixes (%llu)", n);
+    }
+
+    const uint32 n_suffixes = uint32( n );
+
+    suffixes.resize( n_suffixes );
+    string_ids.resize( n_suffixes );
+    m_ranks.resize( n_suffixes );
+
+    n_passes = 0u;
+
+    if (n_suffixes == 0)
+        return;
+
+    // build the initial keys
+    std::vector<key_type> keys( n_suffixes );
+
+    #pragma omp parallel for schedule(dynamic,256)
+    for (int32 i = 0; i < int32( n_strings ); ++i)
+    {
+        const string_type string     = string_set[i];
+        const uint32      string_len = string.length();
+        const uint32      begin      = i ? cum_lengths[i-1] : 0u;
+
+        for (uint32 k = 0; k <= string_len; ++k)
+        {
+            keys[ begin + k ].key = extract_key<SYMBOL_SIZE>( string, string_len, k );
+            keys[ begin + k ].idx = begin + k;
+
+            string_ids[ begin + k ] = uint32(i);
+        }
+    }
+
+    timer.stop();
+    init_time += timer.seconds();
+
+    timer.start();
+
+    //
+    // bucket the suffixes by the most significant bits of their keys with a parallel
+    // counting sort, and sort each bucket independently
+    //
+    std::vector<key_type> sorted_keys( n_suffixes );
+    std::vector<uint32>   bucket_offsets( N_BUCKETS+1 );
+    {
+        const uint32 n_threads  = uint32( omp_get_max_threads() );
+        const uint32 chunk_size = (n_suffixes + n_threads-1) / n_threads;
+
+        std::vector<uint32> counts( n_threads * N_BUCKETS, 0u );
+
+        #pragma omp parallel for
+        for (int32 t = 0; t < int32( n_threads ); ++t)
+        {
+            uint32* thread_counts = &counts[ t * N_BUCKETS ];
+
+            const uint32 begin = nvbio::min( t * chunk_size, n_suffixes );
+            const uint32 end   = nvbio::min( begin + chunk_size, n_suffixes );
+            for (uint32 i = begin; i < end; ++i)
+                ++thread_counts[ keys[i].key >> (KEY_BITS - RADIX_BITS) ];
+        }
+
+        // compute the scatter offsets of each thread within each bucket
+        uint32 offset = 0u;
+        for (uint32 b = 0; b < N_BUCKETS; ++b)
+        {
+            bucket_offsets[b] = offset;
+            for (uint32 t = 0; t < n_threads; ++t)
+            {
+                const uint32 count = counts[ t * N_BUCKETS + b ];
+                counts[ t * N_BUCKETS + b ] = offset;
+                offset += count;
+            }
+        }
+        bucket_offsets[ N_BUCKETS ] = offset;
+
+        #pragma omp parallel for
+        for (int32 t = 0; t < int32( n_threads ); ++t)
+        {
+            uint32* thread_offsets = &counts[ t * N_BUCKETS ];
+
+            const uint32 begin = nvbio::min( t * chunk_size, n_suffixes );
+            const uint32 end   = nvbio::min( begin + chunk_size, n_suffixes );
+            for (uint32 i = begin; i < end; ++i)
+                sorted_keys[ thread_offsets[ keys[i].key >> (KEY_BITS - RADIX_BITS) ]++ ] = keys[i];
+        }
+    }
+    std::vector<key_type>().swap( keys );
+
+    std::vector<group_type> groups;
+
+    #pragma omp parallel
+    {
+        std::vector<group_type> thread_groups;
+
+        #pragma omp for schedule(dynamic,64)
+        for (int32 b = 0; b < int32( N_BUCKETS ); ++b)
+        {
+            const uint32 begin = bucket_offsets[b];
+            const uint32 end   = bucket_offsets[b+1];
+            if (begin == end)
+                continue;
+
+            std::sort( sorted_keys.begin() + begin, sorted_keys.begin() + end, key_less() );
+
+            // find the groups of suffixes sharing the same key
+            for (uint32 i = begin; i < end;)
+            {
+                uint32 j = i + 1;
+                while (j < end && sorted_keys[j].key == sorted_keys[i].key)
+                    ++j;
+
+                // suffixes whose dollar falls within the key are determined, and ordered by string id
+                const uint32 dollar_offset = uint32( sorted_keys[i].key & ((1u << DOLLAR_BITS) - 1u) );
+                const bool   determined    = (j - i == 1u) || (dollar_offset <= SYMBOLS_PER_KEY);
+
+                for (uint32 k = i; k < j; ++k)
+                {
+                    suffixes[k] = sorted_keys[k].idx;
+                    m_ranks[ sorted_keys[k].idx ] = determined ? k : i;
+                }
+
+                if (determined == false)
+                {
+                    group_type group;
+                    group.begin = i;
+                    group.end   = j;
+                    thread_groups.push_back( group );
+                }
+                i = j;
+            }
+        }
+
+        #pragma omp critical
+        groups.insert( groups.end(), thread_groups.begin(), thread_groups.end() );
+    }
+    std::vector<key_type>().swap( sorted_keys );
+
+    timer.stop();
+    radixsort_time += timer.seconds();
+
+    timer.start();
+
+    //
+    // refine the unsorted groups by prefix-doubling: at the beginning of each pass, all the
+    // suffixes in a group share the same h-prefix, which does not include their dollar, and
+    // can hence be sorted by the rank of the suffix h positions ahead
+    //
+    std::vector<rank_type> rank_keys( n_suffixes );
+
+    for (uint32 h = SYMBOLS_PER_KEY; groups.empty() == false; h *= 2u)
+    {
+        // sort each group by the rank of the suffixes at distance h
+        #pragma omp parallel for schedule(dynamic,16)
+        for (int32 g = 0; g < int32( groups.size() ); ++g)
+        {
+            const group_type group = groups[g];
+
+            for (uint32 i = group.begin; i < group.end; ++i)
+            {
+                rank_keys[i].key = m_ranks[ suffixes[i] + h ];
+                rank_keys[i].idx = suffixes[i];
+            }
+
+            std::sort( rank_keys.begin() + group.begin, rank_keys.begin() + group.end, key_less() );
+
+            for (uint32 i = group.begin; i < group.end; ++i)
+                suffixes[i] = rank_keys[i].idx;
+        }
+
+        // split the groups and update the ranks - this must happen only after all groups
+        // have been sorted, as the sorting pass reads the ranks of suffixes in other groups
+        std::vector<group_type> new_groups;
+
+        #pragma omp parallel
+        {
+            std::vector<group_type> thread_groups;
+
+            #pragma omp for schedule(dynamic,16)
+            for (int32 g = 0; g < int32( groups.size() ); ++g)
+            {
+                const group_type group = groups[g];
+
+                for (uint32 i = group.begin; i < group.end;)
+                {
+                    uint32 j = i + 1;
+                    while (j < group.end && rank_keys[j].key == rank_keys[i].key)
+                        ++j;
+
+                    for (uint32 k = i; k < j; ++k)
+                        m_ranks[ suffixes[k] ] = i;
+
+                    if (j - i > 1u)
+                    {
+                        group_type new_group;
+                        new_group.begin = i;
+                        new_group.end   = j;
+                        thread_groups.push_back( new_group );
+                    }
+                    i = j;
+                }
+            }
+
+            #pragma omp critical
+            new_groups.insert( new_groups.end(), thread_groups.begin(), thread_groups.end() );
+        }
+
+        groups.swap( new_groups );
+        ++n_passes;
+    }
+
+    timer.stop();
+    doubling_time += timer.seconds();
+}
+
+} // namespace nvbio
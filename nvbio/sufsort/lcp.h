@@ -0,0 +1,143 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <nvbio/sufsort/sufsort.h>
+#include <nvbio/strings/string_set.h>
+
+namespace nvbio {
+
+///@addtogroup Sufsort
+///@{
+
+///
+///@defgroup LCPModule LCP Arrays
+/// This module contains a series of functions to compute the Longest Common Prefix arrays
+/// of suffix arrays and generalized suffix arrays built on the host with the functions
+/// of the \ref Sufsort module.
+///\par
+/// The LCP arrays are computed using the PHI algorithm by J.Kaerkkaeinen, G.Manzini and S.Puglisi
+/// ("Permuted Longest-Common-Prefix Array", CPM 2009), split in blocks of text positions so
+/// that, besides the input string and suffix array, no more than BWTParams::host_memory bytes
+/// of temporary storage are used.
+/// Each block is processed in parallel, streaming through the suffix array twice.
+///@{
+///
+
+/// Compute the LCP array of a host-side string, given its (possibly partial) suffix array.
+/// The suffix array may or may not include the empty suffix (i.e. string_len), as
+/// output by blockwise_suffix_sort() and StringSAHandler; lcp[0] is always set to 0.
+///
+/// \tparam string_type             an iterator to the string
+/// \tparam suffix_iterator         an iterator to the suffix array
+/// \tparam output_iterator         an iterator for the output LCP values
+///
+/// \param string_len               the length of the given string
+/// \param string                   a host-side string
+/// \param n_suffixes               the number of suffixes in the suffix array
+/// \param sa                       the host-side suffix array
+/// \param lcp                      the output LCP array, where lcp[i] = LCP( sa[i-1], sa[i] )
+/// \param params                   construction parameters
+///
+template <typename string_type, typename suffix_iterator, typename output_iterator>
+void lcp_array(
+    const uint32            string_len,
+    const string_type       string,
+    const uint32            n_suffixes,
+    const suffix_iterator   sa,
+    output_iterator         lcp,
+    const BWTParams*        params = NULL);
+
+/// Compute a Sampled LCP array of a host-side string, retaining the LCP of one suffix out of
+/// every mod entries of the suffix array - i.e. the LCP of the same entries sampled by
+/// StringSSAHandler, so that it can be paired with a Sampled Suffix Array for FM-index
+/// based MEM queries.
+///
+/// \param mod                      the sampling interval, a power of 2
+/// \param slcp                     the output sampled LCP array, of size (n_suffixes + mod-1) / mod
+///
+template <typename string_type, typename suffix_iterator, typename output_iterator>
+void sampled_lcp_array(
+    const uint32            string_len,
+    const string_type       string,
+    const uint32            n_suffixes,
+    const suffix_iterator   sa,
+    const uint32            mod,
+    output_iterator         slcp,
+    const BWTParams*        params = NULL);
+
+/// Compute the LCP array of a generalized suffix array of a host-side string set, as output by
+/// suffix_sort(): the suffixes are expressed as global indices, and each string is implicitly
+/// terminated by a distinct dollar symbol, so that common prefixes never extend across strings.
+///
+/// \tparam string_set_type         string-set type
+/// \tparam suffix_iterator         an iterator to the generalized suffix array
+/// \tparam output_iterator         an iterator for the output LCP values
+///
+/// \param string_set               a host-side string set
+/// \param n_suffixes               the number of suffixes in the generalized suffix array
+/// \param sa                       the sorted global suffix indices
+/// \param string_ids               the string id bound to each global suffix index
+/// \param cum_lengths              the cumulative (extended) string lengths
+/// \param lcp                      the output LCP array, where lcp[i] = LCP( sa[i-1], sa[i] )
+/// \param params                   construction parameters
+///
+template <typename string_set_type, typename suffix_iterator, typename output_iterator>
+void lcp_array(
+    const string_set_type&  string_set,
+    const uint32            n_suffixes,
+    const suffix_iterator   sa,
+    const uint32*           string_ids,
+    const uint32*           cum_lengths,
+    output_iterator         lcp,
+    const BWTParams*        params = NULL);
+
+/// Compute a Sampled LCP array of a generalized suffix array of a host-side string set,
+/// retaining the LCP of one suffix out of every mod entries.
+///
+/// \param mod                      the sampling interval, a power of 2
+/// \param slcp                     the output sampled LCP array, of size (n_suffixes + mod-1) / mod
+///
+template <typename string_set_type, typename suffix_iterator, typename output_iterator>
+void sampled_lcp_array(
+    const string_set_type&  string_set,
+    const uint32            n_suffixes,
+    const suffix_iterator   sa,
+    const uint32*           string_ids,
+    const uint32*           cum_lengths,
+    const uint32            mod,
+    output_iterator         slcp,
+    const BWTParams*        params = NULL);
+
+///@} LCPModule
+///@} Sufsort
+
+} // namespace nvbio
+
+#include <nvbio/sufsort/lcp_inl.h>
@@ -0,0 +1,315 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <nvbio/basic/omp.h>
+#include <nvbio/basic/exceptions.h>
+#include <vector>
+
+namespace nvbio {
+
+namespace priv {
+
+// A text accessor used by the PHI algorithm to extend the common prefix of two suffixes of a string
+//
+template <typename string_type>
+struct lcp_string_text
+{
+    lcp_string_text(const uint32 _string_len, const string_type _string) :
+        string_len( _string_len ), string( _string ) {}
+
+    // return the number of text positions
+    //
+    uint32 size() const { return string_len + 1u; }
+
+    // extend the common prefix of the suffixes starting at a and b, known to be at least l
+    //
+    uint32 extend(const uint32 a, const uint32 b, uint32 l) const
+    {
+        while (a + l < string_len && b + l < string_len && string[a + l] == string[b + l])
+            ++l;
+
+        return l;
+    }
+
+    const uint32        string_len;
+    const string_type   string;
+};
+
+// A text accessor used by the PHI algorithm to extend the common prefix of two suffixes of a string set,
+// expressed as global suffix indices
+//
+template <typename string_set_type>
+struct lcp_string_set_text
+{
+    typedef typename string_set_type::string_type string_type;
+
+    lcp_string_set_text(const string_set_type& _string_set, const uint32* _string_ids, const uint32* _cum_lengths) :
+        string_set( _string_set ), string_ids( _string_ids ), cum_lengths( _cum_lengths ) {}
+
+    // return the number of text positions
+    //
+    uint32 size() const { return string_set.size() ? cum_lengths[ string_set.size()-1 ] : 0u; }
+
+    // extend the common prefix of the suffixes starting at a and b, known to be at least l
+    //
+    uint32 extend(const uint32 a, const uint32 b, uint32 l) const
+    {
+        const uint32 a_id    = string_ids[a];
+        const uint32 b_id    = string_ids[b];
+        const uint32 a_begin = a_id ? cum_lengths[a_id-1] : 0u;
+        const uint32 b_begin = b_id ? cum_lengths[b_id-1] : 0u;
+
+        // the extended lengths include the dollar
+        const uint32 a_len = cum_lengths[a_id] - a_begin - 1u;
+        const uint32 b_len = cum_lengths[b_id] - b_begin - 1u;
+
+        const uint32 a_off = a - a_begin;
+        const uint32 b_off = b - b_begin;
+
+        const string_type a_string = string_set[a_id];
+        const string_type b_string = string_set[b_id];
+
+        while (a_off + l < a_len && b_off + l < b_len && a_string[a_off + l] == b_string[b_off + l])
+            ++l;
+
+        return l;
+    }
+
+    const string_set_type&  string_set;
+    const uint32*           string_ids;
+    const uint32*           cum_lengths;
+};
+
+// A functor storing all LCP values in a dense array
+//
+template <typename output_iterator>
+struct lcp_dense_store
+{
+    lcp_dense_store(output_iterator _output) : output( _output ) {}
+
+    void operator() (const uint32 slot, const uint32 lcp) const { output[slot] = lcp; }
+
+    output_iterator output;
+};
+
+// A functor storing only the LCP values of one slot out of every mod
+//
+template <typename output_iterator>
+struct lcp_sampled_store
+{
+    lcp_sampled_store(const uint32 _mod, output_iterator _output) : mod( _mod ), output( _output ) {}
+
+    void operator() (const uint32 slot, const uint32 lcp) const
+    {
+        if ((slot & (mod-1)) == 0)
+            output[slot / mod] = lcp;
+    }
+
+    const uint32    mod;
+    output_iterator output;
+};
+
+// return the number of text positions to process per block, as bounded by the host memory budget:
+// a smaller budget only costs more passes over the suffix array, so it is never exceeded
+//
+inline uint32 lcp_block_size(const uint32 n_positions, const BWTParams* params)
+{
+    const uint64 host_memory    = params ? params->host_memory : BWTParams().host_memory;
+    const uint64 max_block_size = host_memory / sizeof(uint32);
+    if (max_block_size == 0)
+        throw nvbio::runtime_error("phi_lcp() : host memory budget too small! (%llu bytes)", (unsigned long long)host_memory);
+
+    return uint32( nvbio::min( uint64( n_positions ), max_block_size ) );
+}
+
+// compute the LCP array of a suffix array with the PHI algorithm, processing the text in blocks of positions:
+// for each block, Phi[p] = SA[ISA[p]-1] is scattered for all positions p in the block, then replaced
+// by the permuted LCP value PLCP[p] = LCP( p, Phi[p] ), and finally gathered back in suffix array order
+//
+template <typename text_type, typename suffix_iterator, typename store_functor>
+void phi_lcp(
+    const text_type&        text,
+    const uint32            n_suffixes,
+    const suffix_iterator   sa,
+    const store_functor     store,
+    const BWTParams*        params)
+{
+    const uint32 NONE        = uint32(-1);
+    const uint32 n_positions = text.size();
+    if (n_positions == 0 || n_suffixes == 0)
+        return;
+
+    const uint32 block_size = lcp_block_size( n_positions, params );
+
+    std::vector<uint32> phi( block_size );
+
+    for (uint32 block_begin = 0; block_begin < n_positions; block_begin += block_size)
+    {
+        const uint32 block_end = nvbio::min( block_begin + block_size, n_positions );
+        const uint32 block_len = block_end - block_begin;
+
+        // positions not appearing in the suffix array, if any, will have no predecessor
+        #pragma omp parallel for
+        for (int64 p = 0; p < int64( block_len ); ++p)
+            phi[p] = NONE;
+
+        // scatter the predecessor of each suffix falling in this block
+        #pragma omp parallel for
+        for (int64 j = 0; j < int64( n_suffixes ); ++j)
+        {
+            const uint32 p = sa[j];
+            if (p >= block_begin && p < block_end)
+                phi[ p - block_begin ] = j ? uint32( sa[j-1] ) : NONE;
+        }
+
+        // compute the permuted LCP values in place, splitting the block in as many contiguous
+        // ranges as threads: within each range, PLCP[p+1] >= PLCP[p]-1 lets us skip most comparisons
+        const uint32 n_threads  = uint32( omp_get_max_threads() );
+        const uint32 range_size = (block_len + n_threads-1) / n_threads;
+
+        #pragma omp parallel for
+        for (int32 t = 0; t < int32( n_threads ); ++t)
+        {
+            const uint32 range_begin = nvbio::min( t * range_size, block_len );
+            const uint32 range_end   = nvbio::min( range_begin + range_size, block_len );
+
+            uint32 l = 0u;
+            for (uint32 p = range_begin; p < range_end; ++p)
+            {
+                const uint32 q = phi[p];
+                if (q == NONE)
+                {
+                    phi[p] = 0u;
+                    l = 0u;
+                    continue;
+                }
+
+                l = text.extend( block_begin + p, q, l );
+
+                phi[p] = l;
+
+                l = l ? l-1u : 0u;
+            }
+        }
+
+        // gather the LCP values in suffix array order
+        #pragma omp parallel for
+        for (int64 j = 0; j < int64( n_suffixes ); ++j)
+        {
+            const uint32 p = sa[j];
+            if (p >= block_begin && p < block_end)
+                store( uint32(j), j ? phi[ p - block_begin ] : 0u );
+        }
+    }
+}
+
+} // namespace priv
+
+// Compute the LCP array of a host-side string
+//
+template <typename string_type, typename suffix_iterator, typename output_iterator>
+void lcp_array(
+    const uint32            string_len,
+    const string_type       string,
+    const uint32            n_suffixes,
+    const suffix_iterator   sa,
+    output_iterator         lcp,
+    const BWTParams*        params)
+{
+    priv::phi_lcp(
+        priv::lcp_string_text<string_type>( string_len, string ),
+        n_suffixes,
+        sa,
+        priv::lcp_dense_store<output_iterator>( lcp ),
+        params );
+}
+
+// Compute a Sampled LCP array of a host-side string
+//
+template <typename string_type, typename suffix_iterator, typename output_iterator>
+void sampled_lcp_array(
+    const uint32            string_len,
+    const string_type       string,
+    const uint32            n_suffixes,
+    const suffix_iterator   sa,
+    const uint32            mod,
+    output_iterator         slcp,
+    const BWTParams*        params)
+{
+    priv::phi_lcp(
+        priv::lcp_string_text<string_type>( string_len, string ),
+        n_suffixes,
+        sa,
+        priv::lcp_sampled_store<output_iterator>( mod, slcp ),
+        params );
+}
+
+// Compute the LCP array of a generalized suffix array of a host-side string set
+//
+template <typename string_set_type, typename suffix_iterator, typename output_iterator>
+void lcp_array(
+    const string_set_type&  string_set,
+    const uint32            n_suffixes,
+    const suffix_iterator   sa,
+    const uint32*           string_ids,
+    const uint32*           cum_lengths,
+    output_iterator         lcp,
+    const BWTParams*        params)
+{
+    priv::phi_lcp(
+        priv::lcp_string_set_text<string_set_type>( string_set, string_ids, cum_lengths ),
+        n_suffixes,
+        sa,
+        priv::lcp_dense_store<output_iterator>( lcp ),
+        params );
+}
+
+// Compute a Sampled LCP array of a generalized suffix array of a host-side string set
+//
+template <typename string_set_type, typename suffix_iterator, typename output_iterator>
+void sampled_lcp_array(
+    const string_set_type&  string_set,
+    const uint32            n_suffixes,
+    const suffix_iterator   sa,
+    const uint32*           string_ids,
+    const uint32*           cum_lengths,
+    const uint32            mod,
+    output_iterator         slcp,
+    const BWTParams*        params)
+{
+    priv::phi_lcp(
+        priv::lcp_string_set_text<string_set_type>( string_set, string_ids, cum_lengths ),
+        n_suffixes,
+        sa,
+        priv::lcp_sampled_store<output_iterator>( mod, slcp ),
+        params );
+}
+
+} // namespace nvbio
@@ -273,6 +273,36 @@ void bwt(
 ///@addtogroup Sufsort
 ///@{
 
+/// Sort the suffixes of all the strings in a host-side string set, using a parallel
+/// host implementation of prefix-doubling (see HostPrefixDoublingSufSort).
+/// The suffixes come out in the same order as with cuda::suffix_sort(), but are
+/// passed to the output handler in host memory.
+///
+/// \tparam string_set_type         string-set type
+/// \tparam output_handler          an output handler, exposing the following interface:
+///
+/// \code
+/// struct SetSuffixOutputHandler
+/// {
+///     // process a batch of BWT symbols
+///     void process(
+///        const uint32  n_suffixes,        // number of sorted suffixes emitted
+///        const uint32* h_suffixes,        // host-side array of sorted global suffix indices
+///        const uint32* h_string_ids,      // host-side array of the string ids bound to each suffix
+///        const uint32* h_cum_lengths);    // host-side array of cumulative string lengths
+/// };
+/// \endcode
+///
+/// \param string_set               a host-side string-set, e.g. a ConcatenatedStringSet or a SparseStringSet
+/// \param output                   output handler
+/// \param params                   construction parameters
+///
+template <typename string_set_type, typename output_handler>
+void suffix_sort(
+    const string_set_type&   string_set,
+          output_handler&    output,
+    BWTParams*               params = NULL);
+
 /// Build the bwt of a large host-side string set - the string set might not fit into GPU memory.
 ///
 /// \tparam SYMBOL_SIZE             alphabet size, in bits per symbol
@@ -32,6 +32,7 @@
 #include <nvbio/sufsort/sufsort_utils.h>
 #include <nvbio/sufsort/compression_sort.h>
 #include <nvbio/sufsort/prefix_doubling_sufsort.h>
+#include <nvbio/sufsort/host_prefix_doubling_sufsort.h>
 #include <nvbio/sufsort/blockwise_sufsort.h>
 #include <nvbio/sufsort/dcs.h>
 #include <nvbio/strings/string_set.h>
@@ -940,6 +941,32 @@ void bwt(
 
 } // namespace cuda
 
+// Sort the suffixes of all the strings in the given host-side string_set
+//
+template <typename string_set_type, typename output_handler>
+void suffix_sort(
+    const string_set_type&   string_set,
+          output_handler&    output,
+          BWTParams*         params)
+{
+    NVBIO_VAR_UNUSED const uint32 SYMBOL_SIZE = 2u;
+
+    HostPrefixDoublingSufSort sufsort;
+    sufsort.sort<SYMBOL_SIZE>( string_set );
+
+    NVBIO_CUDA_DEBUG_STATEMENT( log_verbose(stderr,"    init     : %5.1f ms\n", 1.0e3f * sufsort.init_time) );
+    NVBIO_CUDA_DEBUG_STATEMENT( log_verbose(stderr,"    r-sort   : %5.1f ms\n", 1.0e3f * sufsort.radixsort_time) );
+    NVBIO_CUDA_DEBUG_STATEMENT( log_verbose(stderr,"    doubling : %5.1f ms (%u passes)\n", 1.0e3f * sufsort.doubling_time, sufsort.n_passes) );
+
+    const uint32 n_suffixes = sufsort.size();
+
+    output.process(
+        n_suffixes,
+        n_suffixes ? &sufsort.suffixes[0]    : NULL,
+        n_suffixes ? &sufsort.string_ids[0]  : NULL,
+        n_suffixes ? &sufsort.cum_lengths[0] : NULL );
+}
+
 // Compute the bwt of a host-side string set
 //
 template <uint32 SYMBOL_SIZE, bool BIG_ENDIAN, typename storage_type, typename output_handler>
@@ -530,6 +530,78 @@ struct StringSSAHandler
     thrust::host_vector<uint32>     h_suffixes;
 };
 
+/// a utility \ref StringSuffixHandler to retain the full Suffix Array in host memory,
+/// e.g. to compute its LCP array with lcp_array()
+///
+template <typename output_iterator>
+struct StringSAHandler
+{
+    // constructor
+    //
+    StringSAHandler(
+        const uint32        _string_len,
+        output_iterator     _output) :
+        string_len  ( _string_len ),
+        n_output    ( 1 ),
+        output      ( _output )
+    {
+        // encode the implicit empty suffix directly
+        output[0] = _string_len;
+    }
+
+    // process the next batch of suffixes
+    //
+    void process_batch(
+        const uint32  n_suffixes,
+        const uint32* d_suffixes)
+    {
+        priv::alloc_storage( h_suffixes, n_suffixes );
+
+        thrust::copy(
+            thrust::device_ptr<const uint32>(d_suffixes),
+            thrust::device_ptr<const uint32>(d_suffixes) + n_suffixes,
+            h_suffixes.begin() );
+
+        #pragma omp parallel for
+        for (int i = 0; i < int( n_suffixes ); ++i)
+            output[i + n_output] = h_suffixes[i];
+
+        // advance the output counter
+        n_output += n_suffixes;
+    }
+
+    // process a sparse set of suffixes
+    //
+    void process_scattered(
+        const uint32  n_suffixes,
+        const uint32* d_suffixes,
+        const uint32* d_slots)
+    {
+        priv::alloc_storage( h_slots,    n_suffixes );
+        priv::alloc_storage( h_suffixes, n_suffixes );
+
+        thrust::copy(
+            thrust::device_ptr<const uint32>(d_slots),
+            thrust::device_ptr<const uint32>(d_slots) + n_suffixes,
+            h_slots.begin() );
+
+        thrust::copy(
+            thrust::device_ptr<const uint32>(d_suffixes),
+            thrust::device_ptr<const uint32>(d_suffixes) + n_suffixes,
+            h_suffixes.begin() );
+
+        #pragma omp parallel for
+        for (int i = 0; i < int( n_suffixes ); ++i)
+            output[ h_slots[i] + 1u ] = h_suffixes[i];      // +1 for the implicit empty suffix
+    }
+
+    const uint32                    string_len;
+    uint32                          n_output;
+    output_iterator                 output;
+    thrust::host_vector<uint32>     h_slots;
+    thrust::host_vector<uint32>     h_suffixes;
+};
+
 /// a utility \ref StringSuffixHandler to retain the BWT and a Sampled Suffix Array
 ///
 template <typename string_type, typename output_bwt_iterator, typename output_ssa_iterator>
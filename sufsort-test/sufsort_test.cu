@@ -39,6 +39,7 @@
 
 #include <nvbio/sufsort/sufsort.h>
 #include <nvbio/sufsort/sufsort_utils.h>
+#include <nvbio/sufsort/lcp.h>
 #include <nvbio/basic/exceptions.h>
 #include <nvbio/basic/timer.h>
 #include <nvbio/strings/string_set.h>
@@ -89,6 +90,45 @@ struct SuffixHandler
     thrust::device_vector<uint32> output;
 };
 
+struct HostSuffixHandler
+{
+    void process(
+        const uint32  n_suffixes,
+        const uint32* suffix_array,
+        const uint32* string_ids,
+        const uint32* cum_lengths)
+    {
+        output.resize( n_suffixes );
+        thrust::copy(
+            suffix_array,
+            suffix_array + n_suffixes,
+            output.begin() );
+    }
+
+    thrust::host_vector<uint32> output;
+};
+
+struct HostSetSuffixHandler
+{
+    HostSetSuffixHandler(const uint32 _n_strings) : n_strings( _n_strings ) {}
+
+    void process(
+        const uint32  n_suffixes,
+        const uint32* suffix_array,
+        const uint32* _string_ids,
+        const uint32* _cum_lengths)
+    {
+        output.assign( suffix_array, suffix_array + n_suffixes );
+        string_ids.assign( _string_ids, _string_ids + n_suffixes );
+        cum_lengths.assign( _cum_lengths, _cum_lengths + n_strings );
+    }
+
+    uint32              n_strings;
+    std::vector<uint32> output;
+    std::vector<uint32> string_ids;
+    std::vector<uint32> cum_lengths;
+};
+
 } // namespace sufsort
 
 int sufsort_test(int argc, char* argv[])
@@ -103,6 +143,9 @@ int sufsort_test(int argc, char* argv[])
         kGPU_BWT_SET        = 32u,
         kCPU_BWT_SET        = 64u,
         kGPU_SA_SET         = 128u,
+        kCPU_SA_SET         = 256u,
+        kCPU_LCP            = 512u,
+        kCPU_SET_LCP        = 1024u,
     };
     uint32 TEST_MASK = 0xFFFFFFFFu;
 
@@ -190,6 +233,14 @@ int sufsort_test(int argc, char* argv[])
                     TEST_MASK |= kGPU_BWT_SET;
                 else if (strcmp( temp, "cpu-set-bwt" ) == 0)
                     TEST_MASK |= kCPU_BWT_SET;
+                else if (strcmp( temp, "gpu-set-sa" ) == 0)
+                    TEST_MASK |= kGPU_SA_SET;
+                else if (strcmp( temp, "cpu-set-sa" ) == 0)
+                    TEST_MASK |= kCPU_SA_SET;
+                else if (strcmp( temp, "cpu-lcp" ) == 0)
+                    TEST_MASK |= kCPU_LCP;
+                else if (strcmp( temp, "cpu-set-lcp" ) == 0)
+                    TEST_MASK |= kCPU_SET_LCP;
 
                 if (*end == '\0')
                     break;
@@ -401,6 +452,274 @@ int sufsort_test(int argc, char* argv[])
             log_info(stderr, "    %5.1f G symbols/s\n",  (1.0e-9f*float(uint64(N_strings)*(N+1)*(N+1)/2)) * (float(N_tests)/timer.seconds()));
         }
     }
+    if (TEST_MASK & kCPU_SA_SET)
+    {
+        typedef PackedStream<uint32*,uint8,SYMBOL_SIZE,false>           packed_stream_type;
+        typedef ConcatenatedStringSet<packed_stream_type,uint32*>       string_set;
+
+        const uint32 N_strings  = 256*1024;
+        const uint32 N_words    = uint32((uint64(N_strings)*N + SYMBOLS_PER_WORD-1) / SYMBOLS_PER_WORD);
+
+        thrust::host_vector<uint32>  h_string( N_words );
+        thrust::host_vector<uint32>  h_offsets( N_strings+1 );
+
+        sufsort::make_test_string_set<SYMBOL_SIZE>(
+            N_strings,
+            N,
+            h_string,
+            h_offsets );
+
+        // insert some duplicate strings, to exercise the long common prefixes
+        for (uint32 i = 0; i < N_words/4; ++i)
+            h_string[i + N_words/4] = h_string[i];
+
+        packed_stream_type h_packed_string( nvbio::plain_view( h_string ) );
+
+        string_set h_string_set(
+            N_strings,
+            h_packed_string,
+            nvbio::plain_view( h_offsets ) );
+
+        log_info(stderr, "  cpu SA test\n");
+        log_info(stderr, "    %5.1f M strings\n",  (1.0e-6f*float(N_strings)));
+        log_info(stderr, "    %5.1f M suffixes\n", (1.0e-6f*float(N_strings*(N+1))));
+
+        sufsort::HostSuffixHandler h_suffix_handler;
+        {
+            Timer timer;
+            timer.start();
+
+            // sort the suffixes on the host
+            suffix_sort( h_string_set, h_suffix_handler, &params );
+
+            timer.stop();
+
+            log_info(stderr, "  sorting time: %.2fs\n", timer.seconds());
+            log_info(stderr, "    %5.1f M strings/s\n",  (1.0e-6f*float(N_strings))       / timer.seconds());
+            log_info(stderr, "    %5.1f M suffixes/s\n", (1.0e-6f*float(N_strings*(N+1))) / timer.seconds());
+        }
+
+        // and compare the result against the device sorter
+        thrust::device_vector<uint32>  d_string( h_string );
+        thrust::device_vector<uint32>  d_offsets( h_offsets );
+
+        packed_stream_type d_packed_string( nvbio::plain_view( d_string ) );
+
+        string_set d_string_set(
+            N_strings,
+            d_packed_string,
+            nvbio::plain_view( d_offsets ) );
+
+        sufsort::SuffixHandler d_suffix_handler;
+        cuda::suffix_sort( d_string_set, d_suffix_handler, &params );
+
+        thrust::host_vector<uint32> h_ref( d_suffix_handler.output );
+        if (h_ref.size() != h_suffix_handler.output.size())
+        {
+            log_error(stderr, "  mismatching number of suffixes: expected %u, got %u\n", uint32( h_ref.size() ), uint32( h_suffix_handler.output.size() ));
+            return 0u;
+        }
+        for (uint32 i = 0; i < h_ref.size(); ++i)
+        {
+            if (h_ref[i] != h_suffix_handler.output[i])
+            {
+                log_error(stderr, "  mismatch at %u: expected %u, got %u\n", i, h_ref[i], h_suffix_handler.output[i]);
+                return 0u;
+            }
+        }
+    }
+    if (TEST_MASK & kCPU_LCP)
+    {
+        typedef uint32                                                  index_type;
+        typedef PackedStream<uint32*,uint8,SYMBOL_SIZE,true,index_type> packed_stream_type;
+
+        const index_type N_symbols  = 4u*1024u*1024u;
+        const index_type N_words    = (N_symbols + SYMBOLS_PER_WORD-1) / SYMBOLS_PER_WORD;
+        const uint32     mod        = 16u;
+
+        log_info(stderr, "  cpu lcp test\n");
+        log_info(stderr, "    %5.1f M symbols\n",  (1.0e-6f*float(N_symbols)));
+
+        thrust::host_vector<uint32> h_string( N_words );
+
+        LCG_random rand;
+        for (index_type i = 0; i < N_words; ++i)
+            h_string[i] = rand.next();
+
+        // insert a long repeat
+        for (uint32 i = 0; i < 1000; ++i)
+            h_string[i + N_words/2] = h_string[i];
+
+        thrust::device_vector<uint32> d_string( h_string );
+        thrust::host_vector<uint32>   h_sa( N_symbols+1 );
+        thrust::host_vector<uint32>   h_lcp( N_symbols+1 );
+        thrust::host_vector<uint32>   h_slcp( (N_symbols+1 + mod-1) / mod );
+
+        packed_stream_type d_packed_string( nvbio::plain_view( d_string ) );
+        packed_stream_type h_packed_string( nvbio::plain_view( h_string ) );
+
+        // build the suffix array
+        StringSAHandler<uint32*> sa_handler( N_symbols, nvbio::plain_view( h_sa ) );
+
+        cuda::blockwise_suffix_sort(
+            N_symbols,
+            d_packed_string,
+            sa_handler,
+            &params );
+
+        Timer timer;
+        timer.start();
+
+        lcp_array( N_symbols, h_packed_string, N_symbols+1, nvbio::plain_view( h_sa ), nvbio::plain_view( h_lcp ), &params );
+
+        timer.stop();
+        log_info(stderr, "  lcp... done: %.2fs (%.1fM suffixes/s)\n", timer.seconds(), 1.0e-6f*float(N_symbols)/float(timer.seconds()));
+
+        sampled_lcp_array( N_symbols, h_packed_string, N_symbols+1, nvbio::plain_view( h_sa ), mod, nvbio::plain_view( h_slcp ), &params );
+
+        // check the LCP values against a direct comparison of the suffixes
+        for (uint32 i = 1; i <= N_symbols; ++i)
+        {
+            const uint32 a = h_sa[i-1];
+            const uint32 b = h_sa[i];
+
+            uint32 l = 0;
+            while (a + l < N_symbols && b + l < N_symbols && h_packed_string[a + l] == h_packed_string[b + l])
+                ++l;
+
+            if (h_lcp[i] != l)
+            {
+                log_error(stderr, "  lcp mismatch at %u: expected %u, got %u\n", i, l, h_lcp[i]);
+                return 0u;
+            }
+            if ((i & (mod-1)) == 0 && h_slcp[i / mod] != l)
+            {
+                log_error(stderr, "  sampled lcp mismatch at %u: expected %u, got %u\n", i, l, h_slcp[i / mod]);
+                return 0u;
+            }
+        }
+    }
+    if (TEST_MASK & kCPU_SET_LCP)
+    {
+        typedef PackedStream<uint32*,uint8,SYMBOL_SIZE,false>           packed_stream_type;
+        typedef ConcatenatedStringSet<packed_stream_type,uint32*>       string_set;
+
+        const uint32 N_strings  = 4*1024;
+        const uint32 mod        = 8u;
+
+        log_info(stderr, "  cpu set lcp test\n");
+
+        // strings of random lengths, including empty ones
+        thrust::host_vector<uint32> h_offsets( N_strings+1 );
+
+        LCG_random rand;
+        h_offsets[0] = 0u;
+        for (uint32 i = 0; i < N_strings; ++i)
+            h_offsets[i+1] = h_offsets[i] + (rand.next() % (2u*N));
+
+        const uint32 N_symbols = h_offsets[ N_strings ];
+        const uint32 N_words   = (N_symbols + SYMBOLS_PER_WORD-1) / SYMBOLS_PER_WORD;
+
+        thrust::host_vector<uint32> h_string( N_words );
+        for (uint32 i = 0; i < N_words; ++i)
+            h_string[i] = rand.next();
+
+        packed_stream_type h_packed_string( nvbio::plain_view( h_string ) );
+
+        // make every fourth string a copy of a prefix of the previous one, so that common prefixes
+        // run up to the end of a string and across block boundaries
+        for (uint32 i = 1; i < N_strings; i += 4)
+        {
+            const uint32 src = h_offsets[i-1];
+            const uint32 dst = h_offsets[i];
+            const uint32 len = nvbio::min( h_offsets[i+1] - dst, dst - src );
+            for (uint32 j = 0; j < len; ++j)
+                h_packed_string[ dst + j ] = h_packed_string[ src + j ];
+        }
+
+        string_set h_string_set(
+            N_strings,
+            h_packed_string,
+            nvbio::plain_view( h_offsets ) );
+
+        sufsort::HostSetSuffixHandler h_suffix_handler( N_strings );
+        suffix_sort( h_string_set, h_suffix_handler, &params );
+
+        const uint32 n_suffixes = uint32( h_suffix_handler.output.size() );
+        if (n_suffixes != N_symbols + N_strings)
+        {
+            log_error(stderr, "  mismatching number of suffixes: expected %u, got %u\n", N_symbols + N_strings, n_suffixes);
+            return 0u;
+        }
+
+        // map each global suffix index to its string and offset, independently of the sorter's output
+        std::vector<uint32> suffix_string( n_suffixes );
+        std::vector<uint32> suffix_offset( n_suffixes );
+        for (uint32 i = 0, g = 0; i < N_strings; ++i)
+        {
+            for (uint32 k = 0; k <= h_offsets[i+1] - h_offsets[i]; ++k, ++g)
+            {
+                suffix_string[g] = i;
+                suffix_offset[g] = k;
+            }
+        }
+
+        // use a budget of a few thousand positions, so as to process the text in many blocks
+        BWTParams lcp_params = params;
+        lcp_params.host_memory = 4096u * sizeof(uint32);
+
+        std::vector<uint32> h_lcp( n_suffixes );
+        std::vector<uint32> h_slcp( (n_suffixes + mod-1) / mod );
+
+        lcp_array(
+            h_string_set,
+            n_suffixes,
+            &h_suffix_handler.output[0],
+            &h_suffix_handler.string_ids[0],
+            &h_suffix_handler.cum_lengths[0],
+            &h_lcp[0],
+            &lcp_params );
+
+        sampled_lcp_array(
+            h_string_set,
+            n_suffixes,
+            &h_suffix_handler.output[0],
+            &h_suffix_handler.string_ids[0],
+            &h_suffix_handler.cum_lengths[0],
+            mod,
+            &h_slcp[0],
+            &lcp_params );
+
+        // check the LCP values against a direct comparison of the suffixes, which never extends past
+        // the end of either string
+        for (uint32 i = 0; i < n_suffixes; ++i)
+        {
+            uint32 l = 0;
+            if (i)
+            {
+                const uint32 a       = h_suffix_handler.output[i-1];
+                const uint32 b       = h_suffix_handler.output[i];
+                const uint32 a_begin = h_offsets[ suffix_string[a] ] + suffix_offset[a];
+                const uint32 b_begin = h_offsets[ suffix_string[b] ] + suffix_offset[b];
+                const uint32 a_end   = h_offsets[ suffix_string[a]+1 ];
+                const uint32 b_end   = h_offsets[ suffix_string[b]+1 ];
+
+                while (a_begin + l < a_end && b_begin + l < b_end && h_packed_string[a_begin + l] == h_packed_string[b_begin + l])
+                    ++l;
+            }
+
+            if (h_lcp[i] != l)
+            {
+                log_error(stderr, "  set lcp mismatch at %u: expected %u, got %u\n", i, l, h_lcp[i]);
+                return 0u;
+            }
+            if ((i & (mod-1)) == 0 && h_slcp[i / mod] != l)
+            {
+                log_error(stderr, "  sampled set lcp mismatch at %u: expected %u, got %u\n", i, l, h_slcp[i / mod]);
+                return 0u;
+            }
+        }
+    }
     if (TEST_MASK & kGPU_BWT_FUNCTIONAL)
     {
         typedef PackedStream<uint32*,uint8,SYMBOL_SIZE,true,uint32>     packed_stream_type;
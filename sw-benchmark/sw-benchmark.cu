@@ -50,6 +50,7 @@
 #include <nvbio/basic/packedstream_loader.h>
 #include <nvbio/basic/vector_view.h>
 #include <nvbio/basic/shared_pointer.h>
+#include <nvbio/basic/host_simd.h>
 #include <nvbio/io/sequence/sequence.h>
 #include <nvbio/fasta/fasta.h>
 #include <nvbio/basic/dna.h>
@@ -443,6 +444,90 @@ void batch_score_profile_all(
     fprintf(stderr, " GCUPS\n");
 }
 
+// execute and time a batch of full DP alignments on the host, using the given aligner
+// and one OpenMP thread per read
+//
+// \return                          GCUPS
+//
+template <typename aligner_type>
+float host_score_profile(
+    const aligner_type                      aligner,
+    const uint32                            n_tasks,
+    const uint32*                           offsets,
+    const uint8*                            patterns,
+    const uint32                            max_pattern_len,
+    const uint8*                            text,
+    const uint32                            text_len)
+{
+    typedef vector_view<const uint8*>                                   string_type;
+    typedef typename aln::column_storage_type<aligner_type>::type      cell_type;
+
+    uint64 n_cells = 0u;
+    for (uint32 i = 0; i < n_tasks; ++i)
+        n_cells += uint64( offsets[i+1] - offsets[i] ) * uint64( text_len );
+
+    Timer timer;
+    timer.start();
+
+    #pragma omp parallel
+    {
+        std::vector<cell_type> column( max_pattern_len );
+
+        #pragma omp for schedule(dynamic)
+        for (int i = 0; i < int( n_tasks ); ++i)
+        {
+            const uint32 pattern_len = offsets[i+1] - offsets[i];
+
+            aln::BestSink<int32> sink;
+            aln::alignment_score(
+                aligner,
+                string_type( pattern_len, patterns + offsets[i] ),
+                aln::trivial_quality_string(),
+                string_type( text_len, text ),
+                Field_traits<int32>::min(),
+                sink,
+                &column[0] );
+        }
+    }
+
+    timer.stop();
+
+    return 1.0e-9f * float(n_cells) / timer.seconds();
+}
+
+// compare the host scalar and striped Gotoh implementations
+//
+template <aln::AlignmentType TYPE>
+void host_striped_profile(
+    const aln::SimpleGotohScheme            scoring,
+    const uint32                            n_tasks,
+    const uint32*                           offsets,
+    const uint8*                            patterns,
+    const uint32                            max_pattern_len,
+    const uint8*                            text,
+    const uint32                            text_len)
+{
+    const float scalar_gcups = host_score_profile(
+        aln::make_gotoh_aligner<TYPE,aln::TextBlockingTag>( scoring ),
+        n_tasks,
+        offsets,
+        patterns,
+        max_pattern_len,
+        text,
+        text_len );
+
+    const float striped_gcups = host_score_profile(
+        aln::make_gotoh_aligner<TYPE,aln::StripedTag>( scoring ),
+        n_tasks,
+        offsets,
+        patterns,
+        max_pattern_len,
+        text,
+        text_len );
+
+    fprintf(stderr,"  %5.1f (scalar)  %5.1f (striped %s) GCUPS\n", scalar_gcups, striped_gcups, host_simd_isa());
+}
+
 enum AlignmentTest
 {
     ALL                 = 0xFFFFFFFFu,
@@ -452,7 +537,8 @@ enum AlignmentTest
     ED_BANDED           = 8u,
     SW_BANDED           = 16u,
     GOTOH_BANDED        = 32u,
-    SSW                 = 64u
+    SSW                 = 64u,
+    STRIPED             = 128u
 };
 
 int main(int argc, char* argv[])
@@ -462,6 +548,7 @@ int main(int argc, char* argv[])
     const char* reads_name  = argv[argc-2];
     const char* ref_name    = argv[argc-1];
     uint32      threads     = omp_get_num_procs();
+    uint32      host_reads  = 256;
     io::QualityEncoding qencoding = io::Phred33;
 
     for (int i = 0; i < argc-2; ++i)
@@ -494,6 +581,8 @@ int main(int argc, char* argv[])
                     TEST_MASK |= GOTOH;
                 else if (strcmp( temp, "ssw" ) == 0)
                     TEST_MASK |= SSW;
+                else if (strcmp( temp, "striped" ) == 0)
+                    TEST_MASK |= STRIPED;
 
                 if (*end == '\0')
                     break;
@@ -503,6 +592,8 @@ int main(int argc, char* argv[])
         }
         else if (strcmp( argv[i], "-threads" ) == 0)
             threads = atoi( argv[++i] );
+        else if (strcmp( argv[i], "-host-reads" ) == 0)
+            host_reads = atoi( argv[++i] );
     }
 
     fprintf(stderr,"sw-benchmark... started\n");
@@ -563,7 +654,19 @@ int main(int argc, char* argv[])
         for (uint32 i = 0; i < ref_length; ++i)
             unpacked_ref[i] = h_ref_stream[i];
     }
+  #endif
+
+    std::vector<uint8> host_ref;
+    if (TEST_MASK & STRIPED)
+    {
+        host_ref.resize( ref_length );
+
+        ref_stream_type h_ref_stream( nvbio::raw_pointer( h_ref_storage ) );
+        for (uint32 i = 0; i < ref_length; ++i)
+            host_ref[i] = h_ref_stream[i];
+    }
 
+  #if defined(SSWLIB)
     // Now set the number of threads
     omp_set_num_threads( threads );
 
@@ -571,6 +674,9 @@ int main(int argc, char* argv[])
     {
         fprintf(stderr, "  running on multiple threads\n");
     }
+  #else
+    if (TEST_MASK & STRIPED)
+        omp_set_num_threads( threads );
   #endif
 
     io::SequenceDataHost h_read_data;
@@ -655,6 +761,54 @@ int main(int argc, char* argv[])
             }
         }
 
+        if (TEST_MASK & STRIPED)
+        {
+            // the host tests align each read against the whole reference, so we only
+            // consider a small subset of the batch
+            const uint32 n_host_reads = nvbio::min( host_reads, h_read_data.size() );
+
+            typedef io::SequenceDataAccess<DNA_N>           read_access_type;
+            typedef read_access_type::sequence_stream_type  read_stream_type;
+
+            const read_access_type reads_access( h_read_data );
+            const read_stream_type packed_reads( reads_access.sequence_stream() );
+
+            std::vector<uint32> host_offsets( n_host_reads+1 );
+            for (uint32 i = 0; i <= n_host_reads; ++i)
+                host_offsets[i] = reads_access.sequence_index()[i] - reads_access.sequence_index()[0];
+
+            std::vector<uint8> host_reads_storage( host_offsets[ n_host_reads ] );
+            for (uint32 i = 0; i < host_offsets[ n_host_reads ]; ++i)
+                host_reads_storage[i] = packed_reads[ reads_access.sequence_index()[0] + i ];
+
+            aln::SimpleGotohScheme scoring;
+            scoring.m_match    =  2;
+            scoring.m_mismatch = -1;
+            scoring.m_gap_open = -2;
+            scoring.m_gap_ext  = -1;
+
+            fprintf(stderr,"  testing host striped Gotoh scoring speed (%u reads)...\n", n_host_reads);
+            fprintf(stderr,"    %15s : ", "semi-global");
+            host_striped_profile<aln::SEMI_GLOBAL>(
+                scoring,
+                n_host_reads,
+                &host_offsets[0],
+                &host_reads_storage[0],
+                h_read_data.max_sequence_len(),
+                &host_ref[0],
+                ref_length );
+
+            fprintf(stderr,"    %15s : ", "local");
+            host_striped_profile<aln::LOCAL>(
+                scoring,
+                n_host_reads,
+                &host_offsets[0],
+                &host_reads_storage[0],
+                h_read_data.max_sequence_len(),
+                &host_ref[0],
+                ref_length );
+        }
+
         #if defined(SSWLIB)
         if (TEST_MASK & SSW)
         {